@@ -0,0 +1,147 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Compares the free slot policies of data_storage.
+/// This benchmark emulates string updates (e.g., mjl.set()), i.e., erase and
+/// emplace pairs on compact_string_storage, using the ordered set based free
+/// slot list and the stack based one.
+
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <metall/detail/time.hpp>
+#include <metall/metall.hpp>
+
+#include <json_bento/details/compact_string_storage.hpp>
+
+using alloc_type = metall::manager::allocator_type<std::byte>;
+
+void print_usage(std::string_view program_name);
+void parse_options(int argc, char **argv, std::string &metall_datastore_path,
+                   std::size_t &num_strings, std::size_t &num_updates);
+void execute_command(const std::string_view command);
+
+template <template <typename> class FreeSlots>
+void run_bench(const std::string_view policy_name,
+               const std::string &metall_datastore_path,
+               const std::size_t num_strings, const std::size_t num_updates) {
+  using storage_type =
+      json_bento::jbdtl::compact_string_storage<alloc_type, FreeSlots>;
+
+  std::cout << "\n<<" << policy_name << ">>" << std::endl;
+  execute_command("rm -rf " + metall_datastore_path);
+  metall::manager manager(metall::create_only, metall_datastore_path.c_str());
+  auto *storage = manager.construct<storage_type>(metall::unique_instance)(
+      manager.get_allocator());
+
+  const std::string        value = "a string that is long enough to allocate";
+  std::vector<std::size_t> ids;
+  ids.reserve(num_strings);
+  {
+    const auto start = metall::mtlldetail::elapsed_time_sec();
+    for (std::size_t i = 0; i < num_strings; ++i) {
+      ids.push_back(storage->emplace(value));
+    }
+    std::cout << "Emplace time (s)\t"
+              << metall::mtlldetail::elapsed_time_sec(start) << std::endl;
+  }
+
+  {
+    std::mt19937_64                            rnd(123);
+    std::uniform_int_distribution<std::size_t> dist(0, num_strings - 1);
+    const auto start = metall::mtlldetail::elapsed_time_sec();
+    for (std::size_t i = 0; i < num_updates; ++i) {
+      auto &id = ids[dist(rnd)];
+      storage->erase(id);
+      id = storage->emplace(value);
+    }
+    std::cout << "Update time (s)\t"
+              << metall::mtlldetail::elapsed_time_sec(start) << std::endl;
+  }
+
+  {
+    const auto  start = metall::mtlldetail::elapsed_time_sec();
+    std::size_t total = 0;
+    for (const auto &str : *storage) {
+      total += str.size();
+    }
+    std::cout << "Scan time (s)\t"
+              << metall::mtlldetail::elapsed_time_sec(start) << std::endl;
+    if (total != value.size() * num_strings) {
+      std::cerr << "Wrong total length: " << total << std::endl;
+      std::abort();
+    }
+  }
+
+  manager.destroy<storage_type>(metall::unique_instance);
+}
+
+int main(int argc, char **argv) {
+  std::string metall_datastore_path;
+  std::size_t num_strings = 1ULL << 20;
+  std::size_t num_updates = 1ULL << 22;
+  parse_options(argc, argv, metall_datastore_path, num_strings, num_updates);
+
+  run_bench<json_bento::jbdtl::ordered_free_slots>(
+      "Ordered set free slots", metall_datastore_path, num_strings,
+      num_updates);
+  run_bench<json_bento::jbdtl::stack_free_slots>(
+      "Stack free slots", metall_datastore_path, num_strings, num_updates);
+
+  return 0;
+}
+
+void print_usage(std::string_view program_name) {
+  std::cout << "Usage: " << program_name
+            << " -d Metall datastore path [-n #of strings] [-u #of updates]"
+            << std::endl;
+}
+
+void parse_options(int argc, char **argv, std::string &metall_datastore_path,
+                   std::size_t &num_strings, std::size_t &num_updates) {
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:n:u:h")) != -1) {
+    switch (opt) {
+      case 'd':
+        metall_datastore_path = optarg;
+        break;
+      case 'n':
+        num_strings = std::stoull(optarg);
+        break;
+      case 'u':
+        num_updates = std::stoull(optarg);
+        break;
+      case 'h':
+        [[fallthrough]];
+      default:
+        print_usage(argv[0]);
+        std::abort();
+    }
+  }
+
+  if (metall_datastore_path.empty() || num_strings == 0) {
+    print_usage(argv[0]);
+    std::abort();
+  }
+
+  std::cout << "Metall datastore path: " << metall_datastore_path << std::endl;
+  std::cout << "#of strings: " << num_strings << std::endl;
+  std::cout << "#of updates: " << num_updates << std::endl;
+}
+
+void execute_command(const std::string_view command) {
+  std::cout << command << std::endl;
+  const int  status  = std::system(command.data());
+  const bool success = (status != -1) && !!(WIFEXITED(status));
+  if (!success) {
+    std::cerr << "Failed to execute " << command << std::endl;
+  }
+}
@@ -0,0 +1,363 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief JSON Bento micro-benchmark suite.
+/// Generates synthetic datasets (numeric-heavy, string-heavy, and objects of
+/// different widths), stores each into a box in Metall and measures:
+///  - ingest: push_back()
+///  - random_at: at() with random indices
+///  - key_lookup: object key lookup in random rows
+///  - scan_filter: full scan counting the rows that match a predicate
+///  - value_to: value_to<boost::json::value>() of random rows
+///  - reopen: reopening the datastore and finding the box
+/// The results (ops/s, bytes/row, RSS) are written as a JSON document so that
+/// they can be compared between builds, e.g., the value locator layouts.
+/// Progress messages are written to stderr.
+
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <metall/detail/time.hpp>
+#include <metall/metall.hpp>
+
+#include <json_bento/boost_json.hpp>
+#include <json_bento/json_bento.hpp>
+
+namespace bj     = boost::json;
+using bento_type = json_bento::box<metall::manager::allocator_type<std::byte>>;
+using value_accessor_type = typename bento_type::value_accessor;
+
+struct option_type {
+  std::string metall_datastore_path;
+  std::string output_path;
+  std::size_t num_rows{100000};
+  std::size_t num_queries{100000};
+  uint64_t    seed{123};
+};
+
+/// \brief Synthetic dataset.
+struct dataset_type {
+  std::string name;
+  /// \brief Makes the i-th row.
+  std::function<bj::value(std::size_t, std::mt19937_64 &)> make_row;
+  /// \brief Keys that every row has; used by key_lookup.
+  std::vector<std::string> keys;
+  /// \brief Predicate used by scan_filter.
+  std::function<bool(const value_accessor_type &)> filter;
+};
+
+void print_usage(std::string_view program_name);
+void parse_options(int argc, char **argv, option_type &option);
+void execute_command(const std::string_view command);
+std::vector<dataset_type> make_datasets();
+bj::object run_dataset(const dataset_type &dataset, const option_type &option);
+
+int main(int argc, char **argv) {
+  option_type option;
+  parse_options(argc, argv, option);
+
+  bj::object config;
+  config["num_rows"]    = option.num_rows;
+  config["num_queries"] = option.num_queries;
+  config["seed"]        = option.seed;
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+  config["value_locator"] = "compact";
+#else
+  config["value_locator"] = "padded";
+#endif
+
+  bj::array results;
+  for (const auto &dataset : make_datasets()) {
+    std::cerr << "<<" << dataset.name << ">>" << std::endl;
+    results.emplace_back(run_dataset(dataset, option));
+  }
+
+  bj::object report;
+  report["config"]   = std::move(config);
+  report["datasets"] = std::move(results);
+
+  if (option.output_path.empty()) {
+    std::cout << report << std::endl;
+  } else {
+    std::ofstream ofs(option.output_path);
+    if (!ofs.is_open()) {
+      std::cerr << "Failed to open " << option.output_path << std::endl;
+      std::abort();
+    }
+    ofs << report << std::endl;
+  }
+
+  execute_command("rm -rf " + option.metall_datastore_path);
+
+  return 0;
+}
+
+/// \brief Returns the current and peak resident set sizes in KB.
+std::pair<std::size_t, std::size_t> get_rss_kb() {
+  std::size_t   current = 0;
+  std::ifstream ifs("/proc/self/status");
+  for (std::string line; std::getline(ifs, line);) {
+    if (line.rfind("VmRSS:", 0) == 0) {
+      current = std::stoull(line.substr(6));
+      break;
+    }
+  }
+
+  struct rusage usage {};
+  getrusage(RUSAGE_SELF, &usage);
+  return {current, static_cast<std::size_t>(usage.ru_maxrss)};
+}
+
+/// \brief Returns the number of bytes actually allocated on the disk for
+/// the files in a directory, i.e., holes in sparse files are not counted.
+std::size_t get_disk_usage(const std::string &path) {
+  std::size_t total = 0;
+  if (!std::filesystem::exists(path)) return total;
+  for (const auto &entry :
+       std::filesystem::recursive_directory_iterator(path)) {
+    if (!entry.is_regular_file()) continue;
+    struct stat st {};
+    if (::stat(entry.path().c_str(), &st) == 0) {
+      total += static_cast<std::size_t>(st.st_blocks) * 512;
+    }
+  }
+  return total;
+}
+
+/// \brief Runs 'op' 'n' times and returns the elapsed time and throughput.
+bj::object measure(const std::size_t n, const std::function<void()> &op) {
+  const auto start = metall::mtlldetail::elapsed_time_sec();
+  for (std::size_t i = 0; i < n; ++i) op();
+  const double elapsed = metall::mtlldetail::elapsed_time_sec(start);
+
+  bj::object result;
+  result["ops"]         = n;
+  result["elapsed_sec"] = elapsed;
+  result["ops_per_sec"] = (elapsed > 0.0) ? double(n) / elapsed : 0.0;
+  return result;
+}
+
+bj::object run_dataset(const dataset_type &dataset, const option_type &option) {
+  const auto &path = option.metall_datastore_path;
+
+  std::mt19937_64        rnd(option.seed);
+  std::vector<bj::value> rows;
+  rows.reserve(option.num_rows);
+  for (std::size_t i = 0; i < option.num_rows; ++i) {
+    rows.emplace_back(dataset.make_row(i, rnd));
+  }
+
+  bj::object benchmarks;
+  // Used to keep the compiler from removing the accessed values
+  std::size_t checksum = 0;
+
+  execute_command("rm -rf " + path);
+  {
+    metall::manager manager(metall::create_only, path.c_str());
+    auto *bento = manager.construct<bento_type>(metall::unique_instance)(
+        manager.get_allocator());
+
+    std::size_t i = 0;
+    benchmarks["ingest"] =
+        measure(rows.size(), [&]() { bento->push_back(rows[i++]); });
+  }
+  rows.clear();
+  rows.shrink_to_fit();
+  const std::size_t disk_usage = get_disk_usage(path);
+
+  double reopen_sec = 0.0;
+  {
+    const auto      start = metall::mtlldetail::elapsed_time_sec();
+    metall::manager manager(metall::open_read_only, path.c_str());
+    const auto *bento = manager.find<bento_type>(metall::unique_instance).first;
+    if (!bento || bento->size() != option.num_rows) {
+      std::cerr << "Failed to reopen the box" << std::endl;
+      std::abort();
+    }
+    checksum += bento->at(0).as_object().size();
+    reopen_sec = metall::mtlldetail::elapsed_time_sec(start);
+
+    std::uniform_int_distribution<std::size_t> row_dist(0, bento->size() - 1);
+    std::uniform_int_distribution<std::size_t> key_dist(
+        0, dataset.keys.size() - 1);
+
+    benchmarks["random_at"] = measure(option.num_queries, [&]() {
+      checksum += bento->at(row_dist(rnd)).as_object().size();
+    });
+
+    benchmarks["key_lookup"] = measure(option.num_queries, [&]() {
+      const auto obj = bento->at(row_dist(rnd)).as_object();
+      checksum += obj.at(dataset.keys[key_dist(rnd)]).is_null() ? 0 : 1;
+    });
+
+    std::size_t num_matches = 0;
+    benchmarks["scan_filter"] = measure(1, [&]() {
+      for (std::size_t r = 0; r < bento->size(); ++r) {
+        if (dataset.filter(bento->at(r))) ++num_matches;
+      }
+    });
+    benchmarks["scan_filter"].as_object()["rows_per_sec"] =
+        benchmarks["scan_filter"].as_object()["ops_per_sec"].as_double() *
+        double(bento->size());
+    benchmarks["scan_filter"].as_object()["matches"] = num_matches;
+
+    benchmarks["value_to"] = measure(option.num_queries, [&]() {
+      const auto v =
+          json_bento::value_to<bj::value>(bento->at(row_dist(rnd)));
+      checksum += v.as_object().size();
+    });
+  }
+
+  const auto [rss_kb, peak_rss_kb] = get_rss_kb();
+
+  bj::object result;
+  result["name"]          = dataset.name;
+  result["rows"]          = option.num_rows;
+  result["bytes"]         = disk_usage;
+  result["bytes_per_row"] = double(disk_usage) / double(option.num_rows);
+  result["reopen_sec"]    = reopen_sec;
+  result["rss_kb"]        = rss_kb;
+  result["peak_rss_kb"]   = peak_rss_kb;
+  result["checksum"]      = checksum;
+  result["benchmarks"]    = std::move(benchmarks);
+  return result;
+}
+
+std::string make_random_string(const std::size_t min_length,
+                               const std::size_t max_length,
+                               std::mt19937_64  &rnd) {
+  std::uniform_int_distribution<std::size_t> len_dist(min_length, max_length);
+  std::uniform_int_distribution<int>         char_dist('a', 'z');
+  std::string                                str(len_dist(rnd), ' ');
+  for (auto &c : str) c = static_cast<char>(char_dist(rnd));
+  return str;
+}
+
+std::vector<dataset_type> make_datasets() {
+  std::vector<dataset_type> datasets;
+
+  datasets.push_back(dataset_type{
+      "numeric",
+      [](const std::size_t i, std::mt19937_64 &rnd) {
+        std::uniform_int_distribution<int64_t> int_dist(0, 1000000);
+        std::uniform_real_distribution<double> real_dist(0.0, 1.0);
+        bj::object                             obj;
+        obj["id"]    = i;
+        obj["x"]     = real_dist(rnd);
+        obj["y"]     = real_dist(rnd);
+        obj["count"] = int_dist(rnd);
+        obj["flag"]  = (int_dist(rnd) % 2 == 0);
+        bj::array vec;
+        for (int k = 0; k < 4; ++k) vec.emplace_back(int_dist(rnd));
+        obj["vec"] = std::move(vec);
+        return bj::value(std::move(obj));
+      },
+      {"id", "x", "y", "count", "flag", "vec"},
+      [](const value_accessor_type &row) {
+        return row.as_object().at("count").as_int64() < 500000;
+      }});
+
+  datasets.push_back(dataset_type{
+      "string",
+      [](const std::size_t, std::mt19937_64 &rnd) {
+        std::uniform_int_distribution<int> city_dist(0, 15);
+        bj::object                         obj;
+        obj["name"] = make_random_string(8, 32, rnd);
+        obj["city"] = "city" + std::to_string(city_dist(rnd));
+        obj["text"] = make_random_string(64, 256, rnd);
+        bj::array tags;
+        for (int k = 0; k < 3; ++k) {
+          tags.emplace_back(make_random_string(4, 12, rnd));
+        }
+        obj["tags"] = std::move(tags);
+        return bj::value(std::move(obj));
+      },
+      {"name", "city", "text", "tags"},
+      [](const value_accessor_type &row) {
+        return row.as_object().at("city").as_string().str_view() == "city0";
+      }});
+
+  for (const std::size_t width : {4, 16, 64, 256}) {
+    std::vector<std::string> keys;
+    for (std::size_t k = 0; k < width; ++k) {
+      keys.emplace_back("key" + std::to_string(k));
+    }
+    datasets.push_back(dataset_type{
+        "width" + std::to_string(width),
+        [keys](const std::size_t, std::mt19937_64 &rnd) {
+          std::uniform_int_distribution<int64_t> int_dist(0, 1000000);
+          bj::object                             obj;
+          for (const auto &key : keys) obj[key] = int_dist(rnd);
+          return bj::value(std::move(obj));
+        },
+        keys,
+        [last = keys.back()](const value_accessor_type &row) {
+          return row.as_object().at(last).as_int64() < 500000;
+        }});
+  }
+
+  return datasets;
+}
+
+void print_usage(std::string_view program_name) {
+  std::cerr << "Usage: " << program_name
+            << " -d Metall datastore path [-n #of rows] [-q #of queries]"
+               " [-s seed] [-o output JSON file path]"
+            << "\n The results are written to stdout if -o is not given."
+            << std::endl;
+}
+
+void parse_options(int argc, char **argv, option_type &option) {
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:n:q:s:o:h")) != -1) {
+    switch (opt) {
+      case 'd':
+        option.metall_datastore_path = optarg;
+        break;
+      case 'n':
+        option.num_rows = std::stoull(optarg);
+        break;
+      case 'q':
+        option.num_queries = std::stoull(optarg);
+        break;
+      case 's':
+        option.seed = std::stoull(optarg);
+        break;
+      case 'o':
+        option.output_path = optarg;
+        break;
+      case 'h':
+        [[fallthrough]];
+      default:
+        print_usage(argv[0]);
+        std::abort();
+    }
+  }
+
+  if (option.metall_datastore_path.empty() || option.num_rows == 0) {
+    print_usage(argv[0]);
+    std::abort();
+  }
+}
+
+void execute_command(const std::string_view command) {
+  std::cerr << command << std::endl;
+  const int  status  = std::system(command.data());
+  const bool success = (status != -1) && !!(WIFEXITED(status));
+  if (!success) {
+    std::cerr << "Failed to execute " << command << std::endl;
+  }
+}
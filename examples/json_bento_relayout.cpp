@@ -0,0 +1,134 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Converts a json_bento::box between the value locator layouts.
+/// A box made with padded_value_locator cannot be opened by a program built
+/// with JSON_BENTO_COMPACT_VALUE_LOCATOR and vice versa.
+/// This program is built twice, once for each layout
+/// (json_bento_relayout_padded and json_bento_relayout_compact).
+/// 'dump' writes the items of a box as JSON lines to stdout and 'load' adds
+/// JSON lines from stdin into a box; for example:
+/// \code
+/// json_bento_relayout_padded -d ./old dump |
+///   json_bento_relayout_compact -d ./new load
+/// \endcode
+/// The box must be stored as metall::unique_instance, e.g., each local
+/// datastore of MetallJsonLines. Indexed keys are not carried over.
+
+#if defined(JSON_BENTO_RELAYOUT_COMPACT)
+#ifndef JSON_BENTO_COMPACT_VALUE_LOCATOR
+#define JSON_BENTO_COMPACT_VALUE_LOCATOR
+#endif
+#else
+#undef JSON_BENTO_COMPACT_VALUE_LOCATOR
+#endif
+
+#include <unistd.h>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/json/src.hpp>
+#include <metall/metall.hpp>
+
+#include <json_bento/json_bento.hpp>
+
+using bento_type = json_bento::box<metall::manager::allocator_type<std::byte>>;
+
+void print_usage(std::string_view program_name);
+void parse_options(int argc, char **argv, std::string &metall_datastore_path,
+                   std::string &command);
+
+void dump(const std::string &metall_datastore_path) {
+  metall::manager manager(metall::open_read_only,
+                          metall_datastore_path.c_str());
+  const auto *bento = manager.find<bento_type>(metall::unique_instance).first;
+  if (!bento) {
+    std::cerr << "Cannot find a box in " << metall_datastore_path << std::endl;
+    std::abort();
+  }
+
+  for (std::size_t i = 0; i < bento->size(); ++i) {
+    std::cout << json_bento::value_to<boost::json::value>((*bento)[i])
+              << "\n";
+  }
+  std::cout.flush();
+}
+
+void load(const std::string &metall_datastore_path) {
+  metall::manager manager(metall::create_only, metall_datastore_path.c_str());
+  auto *bento = manager.construct<bento_type>(metall::unique_instance)(
+      manager.get_allocator());
+
+  constexpr std::size_t    batch_size = 4096;
+  std::vector<std::string> batch;
+  std::size_t              num_lines = 0;
+  std::size_t              num_added = 0;
+  batch.reserve(batch_size);
+
+  auto store_batch = [&]() {
+    num_added += bento->push_back_batch(batch);
+    num_lines += batch.size();
+    batch.clear();
+  };
+
+  for (std::string line; std::getline(std::cin, line);) {
+    batch.emplace_back(std::move(line));
+    if (batch.size() == batch_size) store_batch();
+  }
+  store_batch();
+
+  std::cerr << "#of added items: " << num_added << std::endl;
+  if (num_added != num_lines) {
+    std::cerr << "#of rejected lines: " << num_lines - num_added << std::endl;
+  }
+}
+
+int main(int argc, char **argv) {
+  std::string metall_datastore_path;
+  std::string command;
+  parse_options(argc, argv, metall_datastore_path, command);
+
+  if (command == "dump") {
+    dump(metall_datastore_path);
+  } else {
+    load(metall_datastore_path);
+  }
+
+  return 0;
+}
+
+void print_usage(std::string_view program_name) {
+  std::cerr << "Usage: " << program_name
+            << " -d Metall datastore path dump|load" << std::endl;
+}
+
+void parse_options(int argc, char **argv, std::string &metall_datastore_path,
+                   std::string &command) {
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:h")) != -1) {
+    switch (opt) {
+      case 'd':
+        metall_datastore_path = optarg;
+        break;
+      case 'h':
+        [[fallthrough]];
+      default:
+        print_usage(argv[0]);
+        std::abort();
+    }
+  }
+
+  if (optind < argc) command = argv[optind];
+
+  if (metall_datastore_path.empty() ||
+      (command != "dump" && command != "load")) {
+    print_usage(argv[0]);
+    std::abort();
+  }
+}
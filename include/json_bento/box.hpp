@@ -5,15 +5,25 @@
 
 #pragma once
 
+#include <algorithm>
+#include <array>
 #include <iterator>
 #include <memory>
+#include <numeric>
 #include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <utility>
+#include <vector>
 
 #include <metall/json/json.hpp>
 
 #include <json_bento/boost_json.hpp>
 #include <json_bento/box/array_accessor.hpp>
 #include <json_bento/box/core_data/core_data.hpp>
+#include <json_bento/box/core_data/object_writer.hpp>
+#include <json_bento/box/core_data/sax_handler.hpp>
 #include <json_bento/box/key_value_pair_accessor.hpp>
 #include <json_bento/box/object_accessor.hpp>
 #include <json_bento/box/string_accessor.hpp>
@@ -28,16 +38,54 @@ namespace bj = boost::json;
 namespace mj = metall::json;
 }  // namespace
 
+/// \brief How the memory of arrays and objects is allocated.
+/// See box::set_row_allocation().
+using row_allocation_mode = jbdtl::row_allocation_mode;
+
+/// \brief Locator of an object key.
+/// See object_accessor::locate_key().
+using key_locator = jbdtl::key_locator;
+
+/// \brief Number of bytes used by each storage of a box.
+/// See box::usage().
+struct storage_usage {
+  std::size_t root_value_bytes{0};
+  std::size_t string_bytes{0};
+  std::size_t array_bytes{0};
+  std::size_t object_bytes{0};
+  std::size_t key_bytes{0};
+  /// Sorted key positions of wide objects.
+  std::size_t key_order_bytes{0};
+  std::size_t packed_array_bytes{0};
+  /// Out-of-line integers; always 0 unless JSON_BENTO_COMPACT_VALUE_LOCATOR.
+  std::size_t wide_integer_bytes{0};
+  std::size_t num_strings{0};
+  /// Slots of erased strings, which are reused by later insertions.
+  std::size_t num_free_string_slots{0};
+  std::size_t num_keys{0};
+  std::size_t num_wide_integers{0};
+
+  std::size_t total_bytes() const {
+    return root_value_bytes + string_bytes + array_bytes + object_bytes +
+           key_bytes + key_order_bytes + packed_array_bytes +
+           wide_integer_bytes;
+  }
+};
+
 /// \brief Memory-efficient JSON store
 /// that adds items sequentially and provides array-like indexing,
 /// i.e., index range is [0, N - 1], where N is the number of items at the time.
+/// Reading through accessors is thread safe as long as the box is not
+/// modified: the key cache is locked, and compressed strings are decompressed
+/// into per-thread caches. An accessor must not be shared between threads.
 /// \tparam Alloc Allocator type.
 template <typename Alloc = std::allocator<std::byte>>
 class box {
  private:
-  using self_type      = box<Alloc>;
-  using core_data_type = jbdtl::core_data<Alloc>;
-  using value_locator  = typename core_data_type::value_locator_type;
+  using self_type              = box<Alloc>;
+  using core_data_type         = jbdtl::core_data<Alloc>;
+  using value_locator          = typename core_data_type::value_locator_type;
+  using compressed_blocks_type = jbdtl::compressed_string_blocks<Alloc>;
 
  public:
   using index_type      = std::size_t;
@@ -45,6 +93,7 @@ class box {
   using value_accessor  = jbdtl::value_accessor<Alloc>;
   using object_accessor = jbdtl::object_accessor<Alloc>;
   using array_accessor  = jbdtl::array_accessor<Alloc>;
+  using object_writer   = jbdtl::object_writer<jbdtl::core_data<Alloc>>;
 
   box() = default;
 
@@ -133,18 +182,445 @@ class box {
     return push_back_root_value(value, m_box);
   }
 
+  /// \brief Parses a JSON string and adds it at the end.
+  /// Parsed tokens are written directly into the box
+  /// without constructing an intermediate boost::json::value.
+  /// \param json_string A JSON string.
+  /// \param ec Set if 'json_string' is not a valid JSON.
+  /// Nothing is added in that case.
+  /// \return Returns the ID of the added item; size() if failed.
+  index_type push_back_json(std::string_view         json_string,
+                            boost::json::error_code& ec) {
+    return jbdtl::parse_root_value(json_string, m_box, ec);
+  }
+
+  /// \brief Returns the locator of 'key', adding the key to the key store
+  /// if it does not exist.
+  /// \param key A key.
+  /// \return A key locator that can be passed to object_writer.
+  key_locator add_key(std::string_view key) {
+    return m_box.key_storage.find_or_add(key);
+  }
+
+  /// \brief Returns the locator of 'key' without adding the key.
+  /// \param key A key.
+  /// \return A key locator; keys that do not exist in the box are never found
+  /// by object_accessor::if_contains(key_locator).
+  key_locator locate_key(std::string_view key) const {
+    return m_box.key_storage.find(key);
+  }
+
+  /// \brief Starts adding a flat object at the end.
+  /// Key-value pairs are added through the returned writer, using key
+  /// locators from add_key(); object_writer::finish() must be called before
+  /// the box is used otherwise.
+  /// \example
+  /// \code
+  /// box jb;
+  /// const auto id = jb.add_key("id");
+  /// auto w = jb.push_back_object();
+  /// w.add_int64(id, 42);
+  /// w.finish();
+  /// \endcode
+  object_writer push_back_object() { return object_writer(&m_box); }
+
+  /// \brief Parses JSON strings and adds them at the end.
+  /// Memory for the items is reserved once for the whole batch,
+  /// using the first item as a sample.
+  /// Invalid JSON strings are skipped.
+  /// \tparam string_range A range of string-like objects
+  /// that can be converted to std::string_view.
+  /// \param json_strings JSON strings.
+  /// \return Returns the number of added items.
+  template <typename string_range>
+  std::size_t push_back_batch(const string_range& json_strings) {
+    const auto n = std::distance(std::begin(json_strings),
+                                 std::end(json_strings));
+    if (n <= 0) return 0;
+    m_box.root_value_storage.reserve(m_box.root_value_storage.size() + n);
+
+    std::size_t             num_added = 0;
+    boost::json::error_code ec;
+    auto                    itr = std::begin(json_strings);
+    for (; itr != std::end(json_strings) && num_added == 0; ++itr) {
+      const std::array<std::size_t, 3> before{m_box.string_storage.size(),
+                                              m_box.array_storage.size(),
+                                              m_box.object_storage.size()};
+      push_back_json(std::string_view(*itr), ec);
+      if (ec) {
+        ec.clear();
+        continue;
+      }
+      ++num_added;
+
+      // Reserve memory for the rest, assuming they look like the first one.
+      const std::size_t rest = std::distance(itr, std::end(json_strings)) - 1;
+      m_box.string_storage.reserve(
+          m_box.string_storage.size() +
+          (m_box.string_storage.size() - before[0]) * rest);
+      m_box.array_storage.reserve(
+          m_box.array_storage.size() +
+          (m_box.array_storage.size() - before[1]) * rest);
+      m_box.object_storage.reserve(
+          m_box.object_storage.size() +
+          (m_box.object_storage.size() - before[2]) * rest);
+    }
+
+    for (; itr != std::end(json_strings); ++itr) {
+      push_back_json(std::string_view(*itr), ec);
+      if (ec) {
+        ec.clear();
+        continue;
+      }
+      ++num_added;
+    }
+
+    return num_added;
+  }
+
+  /// \brief Adds all items of another box at the end.
+  /// Keys are reconciled through the key store of this box.
+  /// \tparam other_allocator_type Allocator type of 'other'.
+  /// \param other A box to copy items from.
+  template <typename other_allocator_type>
+  void append(const box<other_allocator_type>& other) {
+    m_box.root_value_storage.reserve(m_box.root_value_storage.size() +
+                                     other.size());
+    for (std::size_t i = 0; i < other.size(); ++i) {
+      push_back_root_value(other[i], m_box);
+    }
+  }
+
+  /// \brief Removes the items for which 'pred' returns true.
+  /// The remaining items keep their order but are renumbered.
+  /// The remaining items are copied into a staging box allocated by
+  /// std::allocator and copied back after clear();
+  /// thus, as with clear(), not all memory is freed.
+  /// \tparam predicate_type A function that takes an index and a value
+  /// accessor and returns a bool.
+  /// \param pred Decides which items are removed.
+  /// \return Returns the number of removed items.
+  template <typename predicate_type>
+  std::size_t remove_if(predicate_type pred) {
+    box<std::allocator<std::byte>> staging;
+    staging.set_row_allocation(row_allocation_mode::bump);
+
+    const std::size_t n = size();
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!pred(i, at(i))) push_back_root_value(at(i), staging.m_box);
+    }
+
+    const std::size_t num_removed = n - staging.size();
+    if (num_removed == 0) return 0;
+
+    clear();
+    append(staging);
+    return num_removed;
+  }
+
+  /// \brief Rewrites the items into freshly allocated storage.
+  /// clear(), remove_if(), and reassigned strings leave memory behind that
+  /// is only partly reused, and the data of later items gets scattered.
+  /// compact() copies the items into a staging box allocated by
+  /// std::allocator, destroys all storage of this box, and copies the items
+  /// back, densely packed in item order.
+  /// Indexed keys and the settings of this box are kept;
+  /// key locators obtained before the call become invalid.
+  /// \param sort_key If not empty, the items are reordered by the value of
+  /// this key of root objects: numbers (by value) come before strings
+  /// (in lexicographic order), which come before other values and items
+  /// without the key. Equal items keep their order.
+  void compact(std::string_view sort_key = {}) {
+    std::vector<std::size_t> order(size());
+    std::iota(order.begin(), order.end(), 0);
+    if (!sort_key.empty()) {
+      std::vector<std::tuple<int, double, std::string>> values;
+      values.reserve(size());
+      for (std::size_t i = 0; i < size(); ++i) {
+        values.push_back(priv_sort_value(at(i), sort_key));
+      }
+      std::stable_sort(order.begin(), order.end(),
+                       [&values](std::size_t lhs, std::size_t rhs) {
+                         return values[lhs] < values[rhs];
+                       });
+    }
+
+    box<std::allocator<std::byte>> staging;
+    staging.set_row_allocation(row_allocation_mode::bump);
+    for (const std::size_t i : order) {
+      push_back_root_value(at(i), staging.m_box);
+    }
+
+    const auto           keys      = indexed_keys();
+    const auto           cold_keys = compressed_keys();
+    const auto           threshold = m_box.sorted_key_threshold;
+    const auto           packing   = m_box.packed_array_threshold;
+    const auto           mode      = row_allocation();
+    const bool           intern    = m_box.string_storage.interning();
+    const auto           min_len   = m_box.string_storage.intern_min_length();
+    const allocator_type alloc     = m_box.key_storage.get_allocator();
+
+    std::destroy_at(&m_box);
+    std::construct_at(&m_box, alloc);
+
+    set_row_allocation(mode);
+    intern_strings(intern, min_len);
+    sort_keys_of_wide_objects(threshold);
+    pack_numeric_arrays(packing);
+    for (const auto& key : keys) {
+      index_key(key);
+    }
+    for (const auto& [key, length] : cold_keys) {
+      compress_key(key, length);
+    }
+    append(staging);
+  }
+
+  /// \brief Parses JSON strings using multiple threads and adds them at the
+  /// end, keeping the order of 'json_strings'.
+  /// Each thread parses a contiguous chunk of 'json_strings' into its own
+  /// staging box allocated by std::allocator; the staging boxes are merged
+  /// into this box by the calling thread.
+  /// Therefore, the allocator of this box does not need to be thread-safe.
+  /// Invalid JSON strings are skipped.
+  /// \tparam string_range A random access range of string-like objects
+  /// that can be converted to std::string_view.
+  /// \param json_strings JSON strings.
+  /// \param num_threads Number of threads to parse JSON strings.
+  /// \return Returns the number of added items.
+  template <typename string_range>
+  std::size_t push_back_batch_parallel(const string_range& json_strings,
+                                       const std::size_t   num_threads) {
+    const std::size_t n = std::distance(std::begin(json_strings),
+                                        std::end(json_strings));
+    if (num_threads <= 1 || n < num_threads) {
+      return push_back_batch(json_strings);
+    }
+
+    using staging_box_type = box<std::allocator<std::byte>>;
+    std::vector<staging_box_type> staging(num_threads);
+    for (auto& b : staging) b.set_row_allocation(row_allocation_mode::bump);
+    std::vector<std::thread>      threads;
+    const std::size_t             chunk = (n + num_threads - 1) / num_threads;
+    for (std::size_t t = 0; t < num_threads; ++t) {
+      threads.emplace_back([&json_strings, &staging, chunk, n, t]() {
+        const auto first = std::min(n, chunk * t);
+        const auto last  = std::min(n, chunk * (t + 1));
+        std::vector<std::string_view> part;
+        part.reserve(last - first);
+        for (std::size_t i = first; i < last; ++i) {
+          part.emplace_back(*(std::begin(json_strings) + i));
+        }
+        staging[t].push_back_batch(part);
+      });
+    }
+
+    std::size_t num_added = 0;
+    for (std::size_t t = 0; t < num_threads; ++t) {
+      threads[t].join();
+      append(staging[t]);
+      num_added += staging[t].size();
+      staging[t].clear();
+    }
+    return num_added;
+  }
+
   /// \brief Return the number of items.
   /// \return Number of items.
   std::size_t size() const { return m_box.root_value_storage.size(); }
 
+  /// \brief Return the memory of the root values,
+  /// i.e., of the locators that every access to an item reads first.
+  /// \return Address and size in bytes.
+  std::pair<const void*, std::size_t> root_value_region() const {
+    return {m_box.root_value_storage.data(),
+            m_box.root_value_storage.size() * sizeof(value_locator)};
+  }
+
   /// \brief Erase all items.
   /// This function does not free all memory allocated for the items.
+  /// Indexed keys are kept.
   void clear() {
+    const auto keys      = indexed_keys();
+    const auto cold_keys = compressed_keys();
     m_box.string_storage.clear();
     m_box.root_value_storage.clear();
     m_box.array_storage.clear();
     m_box.object_storage.clear();
     m_box.key_storage.clear();
+    m_box.column_index_storage.clear();
+    m_box.object_key_order_storage.clear();
+    m_box.compressed_key_storage.clear();
+    m_box.packed_array_storage.clear();
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+    m_box.wide_integer_storage.clear();
+#endif
+    for (const auto& key : keys) {
+      index_key(key);
+    }
+    for (const auto& [key, length] : cold_keys) {
+      compress_key(key, length);
+    }
+  }
+
+  /// \brief Declares 'key' as an indexed key.
+  /// For each root object, the position of an indexed key is kept in a column
+  /// so that looking up the key in a root object does not scan the object.
+  /// Existing items are indexed by this call; later items are indexed by
+  /// push_back.
+  /// \param key Key to index.
+  void index_key(std::string_view key) {
+    jbdtl::add_column_index(m_box, key);
+  }
+
+  /// \brief Returns true if 'key' has been used as an object key.
+  /// Keys are not removed when objects are modified or erased,
+  /// thus a key may be reported although no object has it anymore.
+  /// \param key Key to check.
+  /// \return False if no object has 'key'.
+  bool contains_key(std::string_view key) const {
+    return m_box.key_storage.contains(key);
+  }
+
+  /// \brief Attaches a volatile (DRAM) cache of key lookups to this box,
+  /// so that repeated lookups of the same keys (e.g., by filters) do not
+  /// probe the persistent key store.
+  /// The cache is bound to this process and to the address of the box:
+  /// call detach_key_cache() before the box is unmapped. Calls are counted,
+  /// i.e., the cache is dropped by the last detach_key_cache().
+  /// \param prewarm If true, caches all keys of the box.
+  /// \return False if no cache could be attached.
+  bool attach_key_cache(const bool prewarm = false) const {
+    return m_box.key_storage.attach_cache(prewarm);
+  }
+
+  /// \brief Detaches the cache attached by attach_key_cache().
+  void detach_key_cache() const { m_box.key_storage.detach_cache(); }
+
+  /// \brief Returns true if 'key' is an indexed key.
+  /// \param key Key to check.
+  /// \return True if 'key' is indexed; otherwise, false.
+  bool is_indexed_key(std::string_view key) const {
+    const auto& index = m_box.column_index_storage;
+    return index.find_column(m_box.key_storage.find(key)) !=
+           index.num_columns();
+  }
+
+  /// \brief Enables binary search on keys for wide objects.
+  /// Objects that have 'threshold' or more elements keep their key positions
+  /// sorted by key so that key lookups in those objects take O(log n).
+  /// This setting applies to objects added or modified after this call.
+  /// \param threshold Minimum object width. 0 disables the feature.
+  void sort_keys_of_wide_objects(const std::size_t threshold) {
+    m_box.sorted_key_threshold = threshold;
+  }
+
+  /// \brief Returns the threshold set by sort_keys_of_wide_objects().
+  std::size_t wide_object_threshold() const {
+    return m_box.sorted_key_threshold;
+  }
+
+  /// \brief Stores arrays of numbers packed.
+  /// Arrays that have 'threshold' or more elements, all of them int64, all
+  /// uint64, or all double values (e.g., ID lists, timestamps, vectors), are
+  /// stored as 8-byte values or, for integers whose differences are small
+  /// such as sorted IDs, as delta-encoded varints, instead of one value
+  /// locator per element. Array accessors read them transparently.
+  /// Modifying an element, e.g., by operator=, or the size of a packed array
+  /// stores it unpacked again. The numeric accessors (e.g., as_int64()) of
+  /// an element of a packed array return a reference to a copy.
+  /// This setting applies to arrays added after this call.
+  /// \param threshold Minimum array size. 0 disables the feature.
+  void pack_numeric_arrays(const std::size_t threshold) {
+    m_box.packed_array_threshold = threshold;
+  }
+
+  /// \brief Returns the threshold set by pack_numeric_arrays().
+  std::size_t packed_array_threshold() const {
+    return m_box.packed_array_threshold;
+  }
+
+  /// \brief Enables or disables string interning (dictionary encoding).
+  /// If enabled, string values that are at least 'min_length' long are
+  /// stored only once and shared by all items that hold the same string.
+  /// This setting applies to strings added after this call.
+  /// \param enable Enable if true.
+  /// \param min_length Minimum length of strings to intern.
+  void intern_strings(const bool enable, const std::size_t min_length = 8) {
+    m_box.string_storage.intern(enable, min_length);
+  }
+
+  /// \brief Returns true if string interning is enabled.
+  bool interning_strings() const { return m_box.string_storage.interning(); }
+
+  /// \brief Stores the string values of 'key' in compressed blocks.
+  /// Values of 'key' that are at least 'min_length' long are packed into
+  /// zstd-compressed blocks of about 64 KB and decompressed on access, which
+  /// suits long strings that are rarely read (e.g., descriptions); the values
+  /// of other keys stay uncompressed. Meant to be set when the box is
+  /// created; it applies to values added after this call. Compressed strings
+  /// are not interned, and a view of a compressed string is valid only until
+  /// the thread accesses a few other compressed strings.
+  /// Calling it again for 'key' changes 'min_length'.
+  /// \param key Key whose string values are compressed.
+  /// \param min_length Minimum length of strings to compress.
+  /// \return False if JSON Bento was built without zstd support
+  /// (JSON_BENTO_USE_ZSTD); the call has no effect then.
+  bool compress_key(std::string_view key, const std::size_t min_length = 256) {
+    if (!compressed_blocks_type::compressing) return false;
+
+    const auto loc = m_box.key_storage.find_or_add(key);
+    for (auto& item : m_box.compressed_key_storage) {
+      if (item.key == loc) {
+        item.min_length = min_length;
+        return true;
+      }
+    }
+    m_box.compressed_key_storage.push_back(
+        jbdtl::compressed_key{loc, min_length});
+    return true;
+  }
+
+  /// \brief Returns the keys set by compress_key() and their minimum
+  /// string lengths.
+  std::vector<std::pair<std::string, std::size_t>> compressed_keys() const {
+    std::vector<std::pair<std::string, std::size_t>> keys;
+    for (const auto& item : m_box.compressed_key_storage) {
+      keys.emplace_back(m_box.key_storage.find(item.key), item.min_length);
+    }
+    return keys;
+  }
+
+  /// \brief Changes how the memory of arrays and objects is allocated.
+  /// With row_allocation_mode::slab, small arrays and objects (up to 8
+  /// elements) are carved out of large chunks instead of being allocated one
+  /// by one, which reduces allocator calls and metadata for datasets of tiny
+  /// objects. row_allocation_mode::bump does not reuse the memory of removed
+  /// small arrays and objects and is meant for data that is not modified
+  /// after an import.
+  /// Can be changed only while the box is empty.
+  /// \param mode Allocation mode.
+  /// \return Returns true on success; otherwise, false.
+  bool set_row_allocation(const row_allocation_mode mode) {
+    if (size() > 0) return false;
+    return m_box.array_storage.set_row_allocation(mode) &&
+           m_box.object_storage.set_row_allocation(mode);
+  }
+
+  /// \brief Returns how the memory of arrays and objects is allocated.
+  row_allocation_mode row_allocation() const {
+    return m_box.object_storage.row_allocation();
+  }
+
+  /// \brief Returns the indexed keys.
+  /// \return Indexed keys.
+  std::vector<std::string> indexed_keys() const {
+    std::vector<std::string> keys;
+    const auto&              index = m_box.column_index_storage;
+    for (std::size_t c = 0; c < index.num_columns(); ++c) {
+      keys.emplace_back(m_box.key_storage.find(index.key(c)));
+    }
+    return keys;
   }
 
   /// \brief Reserve additional memory for storing 'n' json items whose data
@@ -172,12 +648,57 @@ class box {
     os << "#of root value data\t" << m_box.root_value_storage.size()
        << std::endl;
     os << "#of string data\t" << m_box.string_storage.size() << std::endl;
+    os << "#of compressed string data\t"
+       << m_box.string_storage.num_compressed() << std::endl;
     os << "#of array data\t" << m_box.array_storage.size() << std::endl;
     os << "#of object data\t" << m_box.object_storage.size() << std::endl;
     os << "#of key data\t" << m_box.key_storage.size() << std::endl;
+    os << "#of indexed keys\t" << m_box.column_index_storage.num_columns()
+       << std::endl;
+  }
+
+  /// \brief Returns the number of bytes used by each storage.
+  /// Capacities are counted, i.e., reserved but unused memory is included;
+  /// allocator overheads are not.
+  storage_usage usage() const {
+    storage_usage res;
+    res.root_value_bytes =
+        m_box.root_value_storage.capacity() * sizeof(value_locator);
+    res.string_bytes          = m_box.string_storage.memory_size();
+    res.array_bytes           = m_box.array_storage.memory_size();
+    res.object_bytes          = m_box.object_storage.memory_size();
+    res.key_bytes             = m_box.key_storage.memory_size();
+    res.key_order_bytes       = m_box.object_key_order_storage.memory_size();
+    res.packed_array_bytes    = m_box.packed_array_storage.memory_size();
+    res.num_strings           = m_box.string_storage.size();
+    res.num_free_string_slots = m_box.string_storage.num_free_slots();
+    res.num_keys              = m_box.key_storage.size();
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+    res.wide_integer_bytes =
+        m_box.wide_integer_storage.capacity() * sizeof(uint64_t);
+    res.num_wide_integers = m_box.wide_integer_storage.size();
+#endif
+    return res;
   }
 
  private:
+  /// \brief Returns the sort key of an item for compact().
+  static std::tuple<int, double, std::string> priv_sort_value(
+      const value_accessor& item, std::string_view key) {
+    if (!item.is_object()) return {2, 0.0, {}};
+
+    const auto val = item.as_object().if_contains(key);
+    if (!val) return {2, 0.0, {}};
+    if (val->is_int64()) return {0, double(val->as_int64()), {}};
+    if (val->is_uint64()) return {0, double(val->as_uint64()), {}};
+    if (val->is_double()) return {0, val->as_double(), {}};
+    // Copied: views of compressed strings do not outlive other accesses.
+    if (val->is_string()) {
+      return {1, 0.0, std::string(val->as_string().str_view())};
+    }
+    return {2, 0.0, {}};
+  }
+
   template <typename json_container_type>
   void priv_count_types(const json_container_type&  sample,
                         std::array<std::size_t, 4>& counts) const {
@@ -207,6 +728,9 @@ class box {
     }
   }
 
+  template <typename>
+  friend class box;
+
   core_data_type m_box;
 };
 }  // namespace json_bento
\ No newline at end of file
@@ -6,6 +6,7 @@
 #pragma once
 
 #include <memory>
+#include <vector>
 
 #include <json_bento/boost_json.hpp>
 #include <json_bento/box/accessor_fwd.hpp>
@@ -65,12 +66,48 @@ class array_accessor {
   }
 
   std::size_t size() const {
+    if (is_packed_array(*m_core_data, m_array_index)) {
+      return packed_array_size(*m_core_data, m_array_index);
+    }
     return m_core_data->array_storage.size(m_array_index);
   }
 
+  /// \brief Copies the elements as doubles, e.g., for numeric kernels.
+  /// Decodes a packed array in one pass.
+  /// \param out Receives the elements.
+  /// \return False if an element is not a number; 'out' is unspecified then.
+  bool copy_numbers(std::vector<double> &out) const {
+    if (is_packed_array(*m_core_data, m_array_index)) {
+      const auto *data =
+          &*m_core_data->packed_array_storage.begin(m_array_index);
+      out.resize(packed_array::size(data));
+      packed_array::decode_doubles(data, out.data());
+      return true;
+    }
+
+    const auto &storage = m_core_data->array_storage;
+    const auto  slots   = wide_integers_of(*m_core_data);
+    out.resize(storage.size(m_array_index));
+    std::size_t pos = 0;
+    for (auto itr = storage.begin(m_array_index);
+         itr != storage.end(m_array_index); ++itr, ++pos) {
+      if (itr->is_double()) {
+        out[pos] = itr->as_double();
+      } else if (itr->is_int64()) {
+        out[pos] = double(itr->as_int64(slots));
+      } else if (itr->is_uint64()) {
+        out[pos] = double(itr->as_uint64(slots));
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
   /// \brief Resize the array.
   /// \param size New size.
   void resize(const std::size_t size) {
+    unpack_array(*m_core_data, m_array_index);
     m_core_data->array_storage.resize(m_array_index, size);
   }
 
@@ -78,6 +115,7 @@ class array_accessor {
   /// Expand (resize) the array if capacity() < size() + 1.
   /// \param value Value to add.
   void push_back(value_accessor_type value) {
+    unpack_array(*m_core_data, m_array_index);
     value_locator loc;
     add_value(value, *m_core_data, loc);
     m_core_data->array_storage.push_back(m_array_index, std::move(loc));
@@ -91,6 +129,7 @@ class array_accessor {
   value_accessor_type emplace_back(Arg &&arg) {
     boost::json::value value(std::forward<Arg>(arg));
     value_locator      loc;
+    unpack_array(*m_core_data, m_array_index);
     add_value(value, *m_core_data, loc);
     m_core_data->array_storage.push_back(m_array_index, std::move(loc));
     return back();
@@ -0,0 +1,456 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+
+namespace json_bento::jbdtl {
+
+/// \brief Out-of-line storage of the integers that do not fit in a
+/// compact_value_locator, e.g., core_data::wide_integer_storage.
+/// Refers to a data_storage of uint64_t values without depending on its
+/// allocator type. A default-constructed instance refers to no storage.
+class wide_integer_slots {
+ public:
+  wide_integer_slots() = default;
+
+  template <typename storage_type>
+  explicit wide_integer_slots(storage_type *const storage)
+      : m_storage(storage),
+        m_at(&priv_at<storage_type>),
+        m_emplace(&priv_emplace<storage_type>),
+        m_erase(&priv_erase<storage_type>) {}
+
+  bool has_storage() const { return m_storage != nullptr; }
+
+  uint64_t &at(const std::size_t id) const {
+    assert(has_storage());
+    return m_at(m_storage, id);
+  }
+
+  std::size_t emplace(const uint64_t u) const {
+    assert(has_storage());
+    return m_emplace(m_storage, u);
+  }
+
+  void erase(const std::size_t id) const {
+    assert(has_storage());
+    m_erase(m_storage, id);
+  }
+
+ private:
+  template <typename storage_type>
+  static uint64_t &priv_at(void *const storage, const std::size_t id) {
+    return static_cast<storage_type *>(storage)->at(id);
+  }
+
+  template <typename storage_type>
+  static std::size_t priv_emplace(void *const storage, const uint64_t u) {
+    return static_cast<storage_type *>(storage)->emplace(u);
+  }
+
+  template <typename storage_type>
+  static void priv_erase(void *const storage, const std::size_t id) {
+    static_cast<storage_type *>(storage)->erase(id);
+  }
+
+  void *m_storage{nullptr};
+  uint64_t &(*m_at)(void *, std::size_t){nullptr};
+  std::size_t (*m_emplace)(void *, uint64_t){nullptr};
+  void (*m_erase)(void *, std::size_t){nullptr};
+};
+
+/// \brief 8-byte value locator (NaN-boxing).
+/// A double value is stored as is. The other types are stored in the payload
+/// of negative quiet NaNs, which are never produced by this class
+/// (NaN doubles are canonicalized to the positive quiet NaN).
+/// The payload has 48 bits: int64 values in [-2^47, 2^47) and
+/// uint64 values less than 2^48 are stored in place.
+/// Other integers are stored out of line in the wide_integer_slots given
+/// to as_*() and emplace_*(); the payload holds their ID then.
+/// Storing such a value without slots throws std::overflow_error,
+/// as does storing an index that is not less than 2^48.
+/// reset() and emplace_*() release an out-of-line value;
+/// packed arrays never hold one (see packed_array::encode()).
+///
+/// As the raw values are not stored in the native representations,
+/// as_*() and emplace_*() return proxy objects instead of references.
+class compact_value_locator {
+ public:
+  using index_type = uint64_t;
+
+ private:
+  using word_type = uint64_t;
+
+  enum data_tag : word_type {
+    wide_integer = 0,  // Never a double, see set_double()
+    null,
+    bool_value,
+    int64_value,
+    uint64_value,
+    string_index,
+    array_index,
+    object_index
+  };
+
+  static constexpr word_type k_box_mask     = 0xFFF8000000000000ULL;
+  static constexpr word_type k_tag_shift    = 48;
+  static constexpr word_type k_tag_mask     = 0x7ULL << k_tag_shift;
+  static constexpr word_type k_payload_mask = (1ULL << k_tag_shift) - 1;
+  static constexpr word_type k_quiet_nan    = 0x7FF8000000000000ULL;
+  // Payload of a wide integer: the signedness bit and the slot ID.
+  static constexpr word_type k_wide_uint64_bit = 1ULL << (k_tag_shift - 1);
+  static constexpr word_type k_wide_id_mask    = k_wide_uint64_bit - 1;
+
+  static constexpr int64_t k_min_int64 = -(int64_t(1) << (k_tag_shift - 1));
+  static constexpr int64_t k_max_int64 = (int64_t(1) << (k_tag_shift - 1)) - 1;
+
+ public:
+  /// \brief Proxy object that behaves like a reference to the held value.
+  /// \tparam T Value type.
+  /// \tparam Kind Kind of the held value.
+  template <typename T, int Kind>
+  class proxy {
+   public:
+    explicit proxy(compact_value_locator *const locator,
+                   const wide_integer_slots   &slots = {})
+        : m_loc(locator), m_slots(slots) {}
+    proxy(const proxy &) = default;
+
+    operator T() const { return m_loc->template priv_get<Kind>(m_slots); }
+
+    proxy &operator=(const T v) {
+      m_loc->template priv_put<Kind>(v, m_slots);
+      return *this;
+    }
+
+    proxy &operator=(const proxy &other) {
+      return operator=(static_cast<T>(other));
+    }
+
+   private:
+    compact_value_locator *m_loc;
+    wide_integer_slots     m_slots;
+  };
+
+  using bool_reference   = proxy<bool, 0>;
+  using int64_reference  = proxy<int64_t, 1>;
+  using uint64_reference = proxy<uint64_t, 2>;
+  using double_reference = proxy<double, 3>;
+  using index_reference  = proxy<index_type, 4>;
+
+  /// \brief Types returned by the const accessors.
+  using bool_const_reference   = bool;
+  using int64_const_reference  = int64_t;
+  using uint64_const_reference = uint64_t;
+  using double_const_reference = double;
+
+  static constexpr std::size_t max_index() { return k_payload_mask; }
+
+  /// \brief Returns true if an int64 value can be stored in place.
+  static constexpr bool fits_int64(const int64_t v) {
+    return k_min_int64 <= v && v <= k_max_int64;
+  }
+
+  /// \brief Returns true if an uint64 value can be stored in place.
+  static constexpr bool fits_uint64(const uint64_t v) {
+    return v <= k_payload_mask;
+  }
+
+  compact_value_locator() { reset(); }
+
+  ~compact_value_locator() noexcept = default;
+
+  /// \brief Compares the locators; out-of-line values are compared
+  /// by their IDs.
+  bool operator==(const compact_value_locator &other) {
+    if (is_double() && other.is_double()) {
+      return get_double() == other.get_double();
+    }
+    return m_word == other.m_word;
+  }
+
+  bool operator!=(const compact_value_locator &other) {
+    return !(*this == other);
+  }
+
+  bool is_null() const { return priv_tag() == data_tag::null; }
+
+  bool is_bool() const { return priv_tag() == data_tag::bool_value; }
+
+  bool is_int64() const {
+    return priv_tag() == data_tag::int64_value ||
+           (is_out_of_line() && !(m_word & k_wide_uint64_bit));
+  }
+
+  bool is_uint64() const {
+    return priv_tag() == data_tag::uint64_value ||
+           (is_out_of_line() && (m_word & k_wide_uint64_bit));
+  }
+
+  /// \brief Returns true if the value is an integer stored out of line.
+  bool is_out_of_line() const {
+    return !is_double() && priv_tag() == data_tag::wide_integer;
+  }
+
+  bool is_double() const { return (m_word & k_box_mask) != k_box_mask; }
+
+  bool is_string_index() const { return priv_tag() == data_tag::string_index; }
+
+  bool is_array_index() const { return priv_tag() == data_tag::array_index; }
+
+  bool is_object_index() const { return priv_tag() == data_tag::object_index; }
+
+  bool is_primitive() const {
+    return is_bool() || is_int64() || is_uint64() || is_double();
+  }
+
+  bool is_index() const {
+    return is_string_index() || is_array_index() || is_object_index();
+  }
+
+  bool_reference as_bool() {
+    assert(is_bool());
+    return bool_reference(this);
+  }
+
+  int64_reference as_int64(const wide_integer_slots &slots = {}) {
+    assert(is_int64());
+    return int64_reference(this, slots);
+  }
+
+  uint64_reference as_uint64(const wide_integer_slots &slots = {}) {
+    assert(is_uint64());
+    return uint64_reference(this, slots);
+  }
+
+  double_reference as_double() {
+    assert(is_double());
+    return double_reference(this);
+  }
+
+  index_reference as_index() {
+    assert(is_index());
+    return index_reference(this);
+  }
+
+  bool as_bool() const { return get_bool(); }
+
+  int64_t as_int64(const wide_integer_slots &slots = {}) const {
+    return get_int64(slots);
+  }
+
+  uint64_t as_uint64(const wide_integer_slots &slots = {}) const {
+    return get_uint64(slots);
+  }
+
+  double as_double() const { return get_double(); }
+
+  index_type as_index() const { return get_index(); }
+
+  void emplace_null() { reset(); }
+
+  bool_reference emplace_bool() {
+    priv_set(data_tag::bool_value, 0);
+    return bool_reference(this);
+  }
+
+  int64_reference emplace_int64(const wide_integer_slots &slots = {}) {
+    reset(slots);
+    priv_set(data_tag::int64_value, 0);
+    return int64_reference(this, slots);
+  }
+
+  uint64_reference emplace_uint64(const wide_integer_slots &slots = {}) {
+    reset(slots);
+    priv_set(data_tag::uint64_value, 0);
+    return uint64_reference(this, slots);
+  }
+
+  double_reference emplace_double() {
+    set_double(0.0);
+    return double_reference(this);
+  }
+
+  index_reference emplace_string_index() {
+    priv_set(data_tag::string_index, 0);
+    return index_reference(this);
+  }
+
+  index_reference emplace_array_index() {
+    priv_set(data_tag::array_index, 0);
+    return index_reference(this);
+  }
+
+  index_reference emplace_object_index() {
+    priv_set(data_tag::object_index, 0);
+    return index_reference(this);
+  }
+
+  /// \brief Resets the value to null.
+  /// \param slots The slots of an out-of-line value, which is released.
+  void reset(const wide_integer_slots &slots = {}) {
+    priv_release(slots);
+    priv_set(data_tag::null, 0);
+  }
+
+ private:
+  template <typename, int>
+  friend class proxy;
+
+  bool get_bool() const {
+    assert(is_bool());
+    return m_word & k_payload_mask;
+  }
+
+  int64_t get_int64(const wide_integer_slots &slots) const {
+    assert(is_int64());
+    if (is_out_of_line()) {
+      return static_cast<int64_t>(slots.at(m_word & k_wide_id_mask));
+    }
+    // Sign-extend the 48-bit payload
+    const auto shift = 64 - k_tag_shift;
+    return static_cast<int64_t>((m_word & k_payload_mask) << shift) >> shift;
+  }
+
+  uint64_t get_uint64(const wide_integer_slots &slots) const {
+    assert(is_uint64());
+    if (is_out_of_line()) return slots.at(m_word & k_wide_id_mask);
+    return m_word & k_payload_mask;
+  }
+
+  double get_double() const {
+    assert(is_double());
+    double d;
+    std::memcpy(&d, &m_word, sizeof(d));
+    return d;
+  }
+
+  index_type get_index() const {
+    assert(is_index());
+    return m_word & k_payload_mask;
+  }
+
+  void set_bool(const bool b) {
+    assert(is_bool());
+    priv_set(data_tag::bool_value, b ? 1 : 0);
+  }
+
+  void set_int64(const int64_t i, const wide_integer_slots &slots) {
+    assert(is_int64());
+    if (!fits_int64(i)) {
+      priv_set_wide(static_cast<uint64_t>(i), 0, slots);
+      return;
+    }
+    priv_release(slots);
+    priv_set(data_tag::int64_value, static_cast<word_type>(i));
+  }
+
+  void set_uint64(const uint64_t u, const wide_integer_slots &slots) {
+    assert(is_uint64());
+    if (!fits_uint64(u)) {
+      priv_set_wide(u, k_wide_uint64_bit, slots);
+      return;
+    }
+    priv_release(slots);
+    priv_set(data_tag::uint64_value, u);
+  }
+
+  /// \brief Stores an integer out of line,
+  /// reusing the slot of the current value if it has one.
+  void priv_set_wide(const uint64_t u, const word_type sign_bit,
+                     const wide_integer_slots &slots) {
+    if (is_out_of_line()) {
+      const auto id = m_word & k_wide_id_mask;
+      slots.at(id)  = u;
+      priv_set(data_tag::wide_integer, sign_bit | id);
+      return;
+    }
+    if (!slots.has_storage()) {
+      throw std::overflow_error("integer value does not fit in 48 bits");
+    }
+    const auto id = slots.emplace(u);
+    if (id > k_wide_id_mask) {
+      slots.erase(id);
+      throw std::overflow_error("too many out-of-line integers");
+    }
+    priv_set(data_tag::wide_integer, sign_bit | id);
+  }
+
+  /// \brief Releases the slot of an out-of-line value.
+  void priv_release(const wide_integer_slots &slots) {
+    if (!is_out_of_line()) return;
+    assert(slots.has_storage());
+    if (slots.has_storage()) slots.erase(m_word & k_wide_id_mask);
+  }
+
+  void set_double(const double d) {
+    if (std::isnan(d)) {
+      m_word = k_quiet_nan;
+      return;
+    }
+    std::memcpy(&m_word, &d, sizeof(d));
+  }
+
+  void set_index(const index_type index) {
+    assert(is_index());
+    if (index > max_index()) {
+      throw std::overflow_error("index does not fit in 48 bits");
+    }
+    priv_set(static_cast<data_tag>(priv_tag()), index);
+  }
+
+  template <int Kind>
+  auto priv_get(const wide_integer_slots &slots) const {
+    if constexpr (Kind == 0) {
+      return get_bool();
+    } else if constexpr (Kind == 1) {
+      return get_int64(slots);
+    } else if constexpr (Kind == 2) {
+      return get_uint64(slots);
+    } else if constexpr (Kind == 3) {
+      return get_double();
+    } else {
+      return get_index();
+    }
+  }
+
+  template <int Kind, typename T>
+  void priv_put(const T v, const wide_integer_slots &slots) {
+    if constexpr (Kind == 0) {
+      set_bool(v);
+    } else if constexpr (Kind == 1) {
+      set_int64(v, slots);
+    } else if constexpr (Kind == 2) {
+      set_uint64(v, slots);
+    } else if constexpr (Kind == 3) {
+      set_double(v);
+    } else {
+      set_index(v);
+    }
+  }
+
+  word_type priv_tag() const {
+    if (is_double()) return 0;
+    return (m_word & k_tag_mask) >> k_tag_shift;
+  }
+
+  void priv_set(const data_tag tag, const word_type payload) {
+    m_word = k_box_mask | (word_type(tag) << k_tag_shift) |
+             (payload & k_payload_mask);
+  }
+
+  word_type m_word;
+};
+
+static_assert(sizeof(compact_value_locator) == 8);
+
+}  // namespace json_bento::jbdtl
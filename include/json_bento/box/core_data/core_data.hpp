@@ -5,21 +5,34 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <memory>
+#include <numeric>
 #include <utility>
+#include <vector>
 
 #include <metall/container/string.hpp>
 #include <metall/container/vector.hpp>
 
 #include <json_bento/box/core_data/value_locator.hpp>
+#include <json_bento/details/column_index.hpp>
 #include <json_bento/details/compact_adjacency_list.hpp>
 #include <json_bento/details/compact_string_storage.hpp>
 #include <json_bento/details/data_storage.hpp>
 #include <json_bento/details/key_store.hpp>
 #include <json_bento/details/key_value_pair.hpp>
+#include <json_bento/details/packed_array.hpp>
 
 namespace json_bento::jbdtl {
 
+/// \brief A key whose string values are stored compressed.
+struct compressed_key {
+  key_locator key;
+  /// Shorter strings are not compressed.
+  std::size_t min_length;
+};
+
 template <typename Alloc>
 struct core_data {
  public:
@@ -36,12 +49,26 @@ struct core_data {
       compact_adjacency_list<value_locator_type, allocator_type>;
   using object_storage_type =
       compact_adjacency_list<key_value_pair, allocator_type>;
+  using column_index_type = column_index<allocator_type>;
+  // Holds, for wide objects, the positions of the key-value pairs
+  // sorted by key locator.
+  using object_key_order_storage_type =
+      compact_adjacency_list<uint32_t, allocator_type>;
+  // Holds, for numeric arrays, the encoded elements (see packed_array).
+  using packed_array_storage_type =
+      compact_adjacency_list<uint8_t, allocator_type>;
+  // Holds the integers that do not fit in a compact_value_locator.
+  using wide_integer_storage_type = data_storage<uint64_t, allocator_type>;
 
   // Use vector here to provide vector-like concept in JSON Bento
   using root_value_storage_type =
       metall::container::vector<value_locator_type,
                                 typename std::allocator_traits<allocator_type>::
                                     template rebind_alloc<value_locator_type>>;
+  using compressed_key_storage_type =
+      metall::container::vector<compressed_key,
+                                typename std::allocator_traits<allocator_type>::
+                                    template rebind_alloc<compressed_key>>;
 
   core_data() = default;
 
@@ -50,7 +77,16 @@ struct core_data {
         root_value_storage(alloc),
         array_storage(alloc),
         object_storage(alloc),
-        key_storage(alloc) {}
+        key_storage(alloc),
+        column_index_storage(alloc),
+        object_key_order_storage(alloc),
+        compressed_key_storage(alloc),
+        packed_array_storage(alloc)
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+        , wide_integer_storage(alloc)
+#endif
+  {
+  }
 
   ~core_data() noexcept = default;
 
@@ -59,13 +95,219 @@ struct core_data {
   array_storage_type      array_storage{allocator_type{}};
   object_storage_type     object_storage{allocator_type{}};
   key_storage_type        key_storage{allocator_type{}};
+  column_index_type       column_index_storage{allocator_type{}};
+  object_key_order_storage_type object_key_order_storage{allocator_type{}};
+  compressed_key_storage_type   compressed_key_storage{allocator_type{}};
+  packed_array_storage_type     packed_array_storage{allocator_type{}};
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+  wide_integer_storage_type wide_integer_storage{allocator_type{}};
+#endif
+
+  /// Objects whose number of elements is equal to or larger than this value
+  /// hold sorted key positions in object_key_order_storage.
+  /// 0 disables the feature.
+  std::size_t sorted_key_threshold{0};
+
+  /// Arrays of numbers whose number of elements is equal to or larger than
+  /// this value are stored encoded in packed_array_storage;
+  /// their rows in array_storage are empty. 0 disables the feature.
+  std::size_t packed_array_threshold{0};
 };
 
 }  // namespace json_bento::jbdtl
 
+namespace json_bento::jbdtl {
+
+/// \brief Returns the slots of the integers that do not fit in a value
+/// locator; none with padded_value_locator, which holds every integer.
+template <typename core_data_type>
+inline wide_integer_slots wide_integers_of(core_data_type &core_data) {
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+  return wide_integer_slots(&core_data.wide_integer_storage);
+#else
+  (void)core_data;
+  return wide_integer_slots();
+#endif
+}
+
+/// \brief Returns true if an object has up-to-date sorted key positions.
+template <typename core_data_type>
+inline bool has_object_key_order(const core_data_type &core_data,
+                                 const std::size_t     row) {
+  const auto n = core_data.object_key_order_storage.size(row);
+  return n > 0 && n == core_data.object_storage.size(row);
+}
+
+/// \brief Removes the sorted key positions of an object.
+template <typename core_data_type>
+inline void clear_object_key_order(core_data_type   &core_data,
+                                   const std::size_t row) {
+  if (core_data.object_key_order_storage.size(row) == 0) return;
+  core_data.object_key_order_storage.clear(row);
+  core_data.object_key_order_storage.shrink_to_fit(row);
+}
+
+/// \brief Builds or updates the sorted key positions of an object
+/// if the object is wide enough.
+/// If only the last key-value pair is new, it is inserted in place.
+template <typename core_data_type>
+inline void update_object_key_order(core_data_type   &core_data,
+                                    const std::size_t row) {
+  auto      &order = core_data.object_key_order_storage;
+  const auto n     = core_data.object_storage.size(row);
+  if (core_data.sorted_key_threshold == 0 ||
+      n < core_data.sorted_key_threshold) {
+    clear_object_key_order(core_data, row);
+    return;
+  }
+
+  const auto key_at = [&core_data, row](const uint32_t pos) {
+    return core_data.object_storage.at(row, pos).key();
+  };
+
+  if (order.size(row) + 1 == n) {
+    // Insert the position of the new (last) key.
+    order.push_back(row, uint32_t(n - 1));
+    auto       first = order.begin(row);
+    auto       last  = order.end(row) - 1;
+    const auto key   = key_at(n - 1);
+    auto       pos   = std::upper_bound(
+        first, last, key, [&key_at](const key_locator k, const uint32_t p) {
+          return k < key_at(p);
+        });
+    std::rotate(pos, last, order.end(row));
+    return;
+  }
+
+  if (row >= order.size()) order.resize(row + 1);
+  order.resize(row, n);
+  std::iota(order.begin(row), order.end(row), uint32_t(0));
+  // Stable so that the first one of duplicate keys comes first.
+  std::stable_sort(order.begin(row), order.end(row),
+                   [&key_at](const uint32_t lhs, const uint32_t rhs) {
+                     return key_at(lhs) < key_at(rhs);
+                   });
+}
+
+/// \brief Finds a key in an object using the sorted key positions.
+/// \return The position of the key, or the size of the object if not found.
+/// The object must have the sorted key positions.
+template <typename core_data_type>
+inline std::size_t find_in_object_key_order(const core_data_type &core_data,
+                                            const std::size_t     row,
+                                            const key_locator     key) {
+  assert(has_object_key_order(core_data, row));
+  const auto &order = core_data.object_key_order_storage;
+  const auto  itr   = std::lower_bound(
+      order.begin(row), order.end(row), key,
+      [&core_data, row](const uint32_t p, const key_locator k) {
+        return core_data.object_storage.at(row, p).key() < k;
+      });
+  if (itr == order.end(row) ||
+      core_data.object_storage.at(row, *itr).key() != key) {
+    return core_data.object_storage.size(row);
+  }
+  return *itr;
+}
+
+/// \brief Returns true if an array is stored packed.
+template <typename core_data_type>
+inline bool is_packed_array(const core_data_type &core_data,
+                            const std::size_t     row) {
+  return core_data.packed_array_storage.size(row) > 0;
+}
+
+/// \brief Returns the number of elements of a packed array.
+template <typename core_data_type>
+inline std::size_t packed_array_size(const core_data_type &core_data,
+                                     const std::size_t     row) {
+  assert(is_packed_array(core_data, row));
+  return packed_array::size(&*core_data.packed_array_storage.begin(row));
+}
+
+/// \brief Returns an element of a packed array.
+template <typename core_data_type>
+inline value_locator packed_array_at(const core_data_type &core_data,
+                                     const std::size_t     row,
+                                     const std::size_t     pos) {
+  value_locator loc;
+  packed_array::decode(&*core_data.packed_array_storage.begin(row), pos, loc);
+  return loc;
+}
+
+/// \brief Removes the packed elements of an array.
+template <typename core_data_type>
+inline void clear_packed_array(core_data_type &core_data,
+                               const std::size_t row) {
+  if (!is_packed_array(core_data, row)) return;
+  core_data.packed_array_storage.clear(row);
+  core_data.packed_array_storage.shrink_to_fit(row);
+}
+
+/// \brief Stores an array packed if all its elements are int64, all uint64,
+/// or all double values and it has at least packed_array_threshold elements.
+/// \return True if the array has been packed.
+template <typename core_data_type>
+inline bool pack_array(core_data_type &core_data, const std::size_t row) {
+  auto      &packed = core_data.packed_array_storage;
+  const auto n      = core_data.array_storage.size(row);
+  if (core_data.packed_array_threshold == 0 ||
+      n < core_data.packed_array_threshold) {
+    return false;
+  }
+
+  std::vector<uint8_t> bytes;
+  if (!packed_array::encode(core_data.array_storage.begin(row),
+                            core_data.array_storage.end(row), bytes)) {
+    return false;
+  }
+
+  if (row >= packed.size()) packed.resize(row + 1);
+  packed.resize(row, bytes.size());
+  std::copy(bytes.begin(), bytes.end(), packed.begin(row));
+  core_data.array_storage.clear(row);
+  core_data.array_storage.shrink_to_fit(row);
+  return true;
+}
+
+/// \brief Stores a packed array as an array of value locators again,
+/// e.g., before it is modified.
+template <typename core_data_type>
+inline void unpack_array(core_data_type &core_data, const std::size_t row) {
+  if (!is_packed_array(core_data, row)) return;
+
+  std::vector<value_locator> values;
+  packed_array::decode_all(&*core_data.packed_array_storage.begin(row),
+                           values);
+  clear_packed_array(core_data, row);
+  core_data.array_storage.reserve(row, values.size());
+  for (auto &v : values) {
+    core_data.array_storage.push_back(row, std::move(v));
+  }
+}
+
+}  // namespace json_bento::jbdtl
+
 // TODO: make a better implementation
 namespace json_bento::jbdtl {
 
+/// \brief Stores the string value of a key-value pair.
+/// The string is compressed if 'key' is a compressed key
+/// and the string is long enough.
+/// \return The string ID.
+template <typename core_data_type>
+inline std::size_t emplace_member_string(core_data_type   &core_data,
+                                         const key_locator key,
+                                         const char *const s,
+                                         const std::size_t count) {
+  for (const auto &item : core_data.compressed_key_storage) {
+    if (item.key == key && count >= item.min_length) {
+      return core_data.string_storage.emplace_compressed(s, count);
+    }
+  }
+  return core_data.string_storage.emplace(s, count);
+}
+
 template <typename value_type, typename core_data_type>
 inline void add_value(const value_type &value, core_data_type &core_data,
                       value_locator &loc) {
@@ -74,9 +316,9 @@ inline void add_value(const value_type &value, core_data_type &core_data,
   } else if (value.is_bool()) {
     loc.emplace_bool() = value.as_bool();
   } else if (value.is_int64()) {
-    loc.emplace_int64() = value.as_int64();
+    loc.emplace_int64(wide_integers_of(core_data)) = value.as_int64();
   } else if (value.is_uint64()) {
-    loc.emplace_uint64() = value.as_uint64();
+    loc.emplace_uint64(wide_integers_of(core_data)) = value.as_uint64();
   } else if (value.is_double()) {
     loc.emplace_double() = value.as_double();
   } else if (value.is_string()) {
@@ -89,6 +331,9 @@ inline void add_value(const value_type &value, core_data_type &core_data,
       const auto col = core_data.array_storage.size(row) - 1;
       add_value(v, core_data, core_data.array_storage.at(row, col));
     }
+    if (core_data.packed_array_threshold > 0) {
+      pack_array(core_data, row);
+    }
     loc.emplace_array_index() = row;
   } else if (value.is_object()) {
     const auto row = core_data.object_storage.push_back();
@@ -100,9 +345,18 @@ inline void add_value(const value_type &value, core_data_type &core_data,
 #endif
       core_data.object_storage.push_back(
           row, key_value_pair(key_loc, value_locator()));
-      const auto col = core_data.object_storage.size(row) - 1;
-      add_value(kv.value(), core_data,
-                core_data.object_storage.at(row, col).value());
+      const auto col    = core_data.object_storage.size(row) - 1;
+      auto      &member = core_data.object_storage.at(row, col).value();
+      if (kv.value().is_string()) {
+        member.emplace_string_index() = emplace_member_string(
+            core_data, key_loc, kv.value().as_string().c_str(),
+            kv.value().as_string().size());
+      } else {
+        add_value(kv.value(), core_data, member);
+      }
+    }
+    if (core_data.sorted_key_threshold > 0) {
+      update_object_key_order(core_data, row);
     }
     loc.emplace_object_index() = row;
   } else {
@@ -110,6 +364,52 @@ inline void add_value(const value_type &value, core_data_type &core_data,
   }
 }
 
+/// \brief Records the positions of the indexed keys in a root value.
+/// \param core_data A core data.
+/// \param root_index The index of the root value to (re)index.
+template <typename core_data_type>
+inline void update_column_index(core_data_type   &core_data,
+                                const std::size_t root_index) {
+  using position_type =
+      typename core_data_type::column_index_type::position_type;
+  auto &index = core_data.column_index_storage;
+
+  for (std::size_t c = 0; c < index.num_columns(); ++c) {
+    index.set(c, root_index, index.k_absent);
+  }
+
+  const auto &loc = core_data.root_value_storage.at(root_index);
+  if (!loc.is_object_index()) return;
+
+  const auto row = loc.as_index();
+  for (std::size_t i = 0; i < core_data.object_storage.size(row); ++i) {
+    const auto key = core_data.object_storage.at(row, i).key();
+    const auto c   = index.find_column(key);
+    // Keep the first occurrence to match the linear search.
+    if (c != index.num_columns() &&
+        index.find(key, root_index) == index.k_absent) {
+      index.set(c, root_index, position_type(i));
+    }
+  }
+}
+
+/// \brief Adds an indexed key and indexes all existing root values.
+/// \param core_data A core data.
+/// \param key A key to index.
+template <typename core_data_type>
+inline void add_column_index(core_data_type                          &core_data,
+                             const typename core_data_type::key_type &key) {
+  const auto key_loc = core_data.key_storage.find_or_add(key);
+  const auto c       = core_data.column_index_storage.find_column(key_loc);
+  if (c != core_data.column_index_storage.num_columns()) return;
+
+  core_data.column_index_storage.add_column(
+      key_loc, core_data.root_value_storage.size());
+  for (std::size_t i = 0; i < core_data.root_value_storage.size(); ++i) {
+    update_column_index(core_data, i);
+  }
+}
+
 /// \brief Add a value at the end of a core data as a root value.
 /// \tparam value_type JSON value type that is compatible with Boost/Metall JSON
 /// value.
@@ -123,6 +423,9 @@ inline auto push_back_root_value(const value_type &source_value,
   const auto idx = core_data.root_value_storage.size();
   core_data.root_value_storage.emplace_back();
   add_value(source_value, core_data, core_data.root_value_storage.back());
+  if (!core_data.column_index_storage.empty()) {
+    update_column_index(core_data, idx);
+  }
   return idx;
 }
 
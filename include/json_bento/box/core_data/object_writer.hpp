@@ -0,0 +1,92 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <string_view>
+
+#include <json_bento/box/core_data/core_data.hpp>
+
+namespace json_bento::jbdtl {
+
+/// \brief Writes a flat object (i.e., an object whose values are primitives
+/// or strings) directly into a core data as a root value.
+/// Keys are given as key locators, which the caller resolves once,
+/// e.g., once per column of a columnar file.
+/// No intermediate JSON value is constructed.
+/// \tparam core_data_type Core data type.
+template <typename core_data_type>
+class object_writer {
+ public:
+  explicit object_writer(core_data_type* const core_data)
+      : m_core_data(core_data),
+        m_root_index(core_data->root_value_storage.size()),
+        m_row(core_data->object_storage.push_back()) {
+    m_core_data->root_value_storage.emplace_back();
+    m_core_data->root_value_storage.back().emplace_object_index() = m_row;
+  }
+
+  object_writer(const object_writer&)            = delete;
+  object_writer& operator=(const object_writer&) = delete;
+  object_writer(object_writer&&)                 = default;
+  object_writer& operator=(object_writer&&)      = default;
+
+  void add_null(const key_locator key) { priv_emplace_value(key).reset(); }
+
+  void add_bool(const key_locator key, const bool b) {
+    priv_emplace_value(key).emplace_bool() = b;
+  }
+
+  void add_int64(const key_locator key, const std::int64_t i) {
+    priv_emplace_value(key).emplace_int64(wide_integers_of(*m_core_data)) = i;
+  }
+
+  void add_uint64(const key_locator key, const std::uint64_t u) {
+    priv_emplace_value(key).emplace_uint64(wide_integers_of(*m_core_data)) = u;
+  }
+
+  void add_double(const key_locator key, const double d) {
+    priv_emplace_value(key).emplace_double() = d;
+  }
+
+  void add_string(const key_locator key, const std::string_view s) {
+    const auto index =
+        emplace_member_string(*m_core_data, key, s.data(), s.size());
+    priv_emplace_value(key).emplace_string_index() = index;
+  }
+
+  /// \brief Completes the object, i.e., updates the key order and
+  /// the column index.
+  /// \return The index of the written root value.
+  std::size_t finish() {
+    assert(m_core_data);
+    if (m_core_data->sorted_key_threshold > 0) {
+      update_object_key_order(*m_core_data, m_row);
+    }
+    if (!m_core_data->column_index_storage.empty()) {
+      update_column_index(*m_core_data, m_root_index);
+    }
+    m_core_data = nullptr;
+    return m_root_index;
+  }
+
+ private:
+  /// \brief Appends a key-value pair and returns a reference to its value.
+  /// The reference is valid until the object grows again.
+  value_locator& priv_emplace_value(const key_locator key) {
+    assert(m_core_data);
+    m_core_data->object_storage.push_back(m_row,
+                                          key_value_pair(key, value_locator()));
+    return m_core_data->object_storage.back(m_row).value();
+  }
+
+  core_data_type* m_core_data;
+  std::size_t     m_root_index;
+  std::size_t     m_row;
+};
+
+}  // namespace json_bento::jbdtl
@@ -0,0 +1,258 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <json_bento/boost_json.hpp>
+#include <json_bento/box/core_data/core_data.hpp>
+
+namespace json_bento::jbdtl {
+
+/// \brief Handler of boost::json::basic_parser that writes parsed JSON tokens
+/// directly into a core data as a root value.
+/// No intermediate boost::json::value is constructed.
+/// \tparam core_data_type Core data type.
+template <typename core_data_type>
+class sax_handler {
+ public:
+  static constexpr std::size_t max_object_size =
+      std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_array_size =
+      std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_key_size =
+      std::numeric_limits<std::size_t>::max();
+  static constexpr std::size_t max_string_size =
+      std::numeric_limits<std::size_t>::max();
+
+  explicit sax_handler(core_data_type* const core_data)
+      : m_core_data(core_data) {}
+
+  /// \brief Returns the index of the root value that was (being) written.
+  std::size_t root_index() const { return m_root_index; }
+
+  /// \brief Removes a partially written root value, e.g., after a parse
+  /// error. Storage allocated for the partial value is not reclaimed.
+  void discard() {
+    if (m_root_index == k_no_root) return;
+    assert(m_root_index + 1 == m_core_data->root_value_storage.size());
+    m_core_data->root_value_storage.pop_back();
+    m_root_index = k_no_root;
+    m_stack.clear();
+  }
+
+  bool on_document_begin(boost::json::error_code&) {
+    m_stack.clear();
+    m_root_index = m_core_data->root_value_storage.size();
+    m_core_data->root_value_storage.emplace_back();
+    return true;
+  }
+
+  bool on_document_end(boost::json::error_code&) {
+    assert(m_stack.empty());
+    if (!m_core_data->column_index_storage.empty()) {
+      update_column_index(*m_core_data, m_root_index);
+    }
+    return true;
+  }
+
+  bool on_object_begin(boost::json::error_code&) {
+    const auto row = m_core_data->object_storage.push_back();
+    priv_emplace_value().emplace_object_index() = row;
+    m_stack.push_back(frame{true, row, 0});
+    return true;
+  }
+
+  bool on_object_end(std::size_t, boost::json::error_code&) {
+    assert(!m_stack.empty() && m_stack.back().is_object);
+    if (m_core_data->sorted_key_threshold > 0) {
+      update_object_key_order(*m_core_data, m_stack.back().row);
+    }
+    m_stack.pop_back();
+    return true;
+  }
+
+  bool on_array_begin(boost::json::error_code&) {
+    const auto row = m_core_data->array_storage.push_back();
+    priv_emplace_value().emplace_array_index() = row;
+    m_stack.push_back(frame{false, row, 0});
+    return true;
+  }
+
+  bool on_array_end(std::size_t, boost::json::error_code&) {
+    assert(!m_stack.empty() && !m_stack.back().is_object);
+    if (m_core_data->packed_array_threshold > 0) {
+      pack_array(*m_core_data, m_stack.back().row);
+    }
+    m_stack.pop_back();
+    return true;
+  }
+
+  bool on_key_part(boost::json::string_view s, std::size_t,
+                   boost::json::error_code&) {
+    m_buffer.append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_key(boost::json::string_view s, std::size_t,
+              boost::json::error_code&) {
+    assert(!m_stack.empty() && m_stack.back().is_object);
+    if (m_buffer.empty()) {
+      m_stack.back().key = m_core_data->key_storage.find_or_add(
+          std::string_view(s.data(), s.size()));
+    } else {
+      m_buffer.append(s.data(), s.size());
+      m_stack.back().key = m_core_data->key_storage.find_or_add(m_buffer);
+      m_buffer.clear();
+    }
+    return true;
+  }
+
+  bool on_string_part(boost::json::string_view s, std::size_t,
+                      boost::json::error_code&) {
+    m_buffer.append(s.data(), s.size());
+    return true;
+  }
+
+  bool on_string(boost::json::string_view s, std::size_t,
+                 boost::json::error_code&) {
+    std::size_t index = 0;
+    if (m_buffer.empty()) {
+      index = priv_emplace_string(s.data(), s.size());
+    } else {
+      m_buffer.append(s.data(), s.size());
+      index = priv_emplace_string(m_buffer.data(), m_buffer.size());
+      m_buffer.clear();
+    }
+    priv_emplace_value().emplace_string_index() = index;
+    return true;
+  }
+
+  bool on_number_part(boost::json::string_view, boost::json::error_code&) {
+    return true;
+  }
+
+  bool on_int64(std::int64_t i, boost::json::string_view,
+                boost::json::error_code&) {
+    priv_emplace_value().emplace_int64(wide_integers_of(*m_core_data)) = i;
+    return true;
+  }
+
+  bool on_uint64(std::uint64_t u, boost::json::string_view,
+                 boost::json::error_code&) {
+    priv_emplace_value().emplace_uint64(wide_integers_of(*m_core_data)) = u;
+    return true;
+  }
+
+  bool on_double(double d, boost::json::string_view,
+                 boost::json::error_code&) {
+    priv_emplace_value().emplace_double() = d;
+    return true;
+  }
+
+  bool on_bool(bool b, boost::json::error_code&) {
+    priv_emplace_value().emplace_bool() = b;
+    return true;
+  }
+
+  bool on_null(boost::json::error_code&) {
+    priv_emplace_value().reset();
+    return true;
+  }
+
+  bool on_comment_part(boost::json::string_view, boost::json::error_code&) {
+    return true;
+  }
+
+  bool on_comment(boost::json::string_view, boost::json::error_code&) {
+    return true;
+  }
+
+ private:
+  static constexpr std::size_t k_no_root =
+      std::numeric_limits<std::size_t>::max();
+
+  /// \brief Array or object being written.
+  struct frame {
+    bool        is_object;
+    std::size_t row;
+    key_locator key;  // the last key seen in an object
+  };
+
+  /// \brief Allocates a slot for a new value in the current container
+  /// and returns a reference to it.
+  /// The reference is valid until the container grows again.
+  /// \brief Stores a string value of the current container.
+  std::size_t priv_emplace_string(const char* const s,
+                                  const std::size_t count) {
+    if (!m_stack.empty() && m_stack.back().is_object) {
+      return emplace_member_string(*m_core_data, m_stack.back().key, s, count);
+    }
+    return m_core_data->string_storage.emplace(s, count);
+  }
+
+  value_locator& priv_emplace_value() {
+    if (m_stack.empty()) {
+      return m_core_data->root_value_storage.at(m_root_index);
+    }
+
+    const auto& top = m_stack.back();
+    if (top.is_object) {
+      m_core_data->object_storage.push_back(
+          top.row, key_value_pair(top.key, value_locator()));
+      return m_core_data->object_storage.back(top.row).value();
+    }
+    m_core_data->array_storage.push_back(top.row, value_locator());
+    return m_core_data->array_storage.back(top.row);
+  }
+
+  core_data_type*    m_core_data;
+  std::size_t        m_root_index{k_no_root};
+  std::vector<frame> m_stack;
+  std::string        m_buffer;
+};
+
+/// \brief Parses a JSON string and adds it at the end of a core data as a root
+/// value. Unlike push_back_root_value, no intermediate JSON value is made.
+/// \param json_string A JSON string to parse.
+/// \param core_data A core data to which the value is added.
+/// \param ec Set if the string is not a valid JSON; nothing is added then.
+/// \return The index of the added value.
+template <typename core_data_type>
+inline std::size_t parse_root_value(const std::string_view   json_string,
+                                    core_data_type&          core_data,
+                                    boost::json::error_code& ec) {
+  boost::json::basic_parser<sax_handler<core_data_type>> parser(
+      boost::json::parse_options{}, &core_data);
+  std::size_t n = 0;
+  try {
+    n = parser.write_some(false, json_string.data(), json_string.size(), ec);
+  } catch (...) {
+    // e.g., a value that the value locator cannot hold
+    parser.handler().discard();
+    throw;
+  }
+  if (!ec) {
+    // Same as boost::json::parse(), only whitespace may follow the value.
+    for (auto c : json_string.substr(n)) {
+      if (c != ' ' && c != '\t' && c != '\r' && c != '\n') {
+        ec = boost::json::error::extra_data;
+        break;
+      }
+    }
+  }
+  if (ec) {
+    parser.handler().discard();
+    return core_data.root_value_storage.size();
+  }
+  return parser.handler().root_index();
+}
+
+}  // namespace json_bento::jbdtl
@@ -8,12 +8,28 @@
 #include <cstdlib>
 #include <limits>
 
+#include <json_bento/box/core_data/compact_value_locator.hpp>
+
 namespace json_bento::jbdtl {
 
-class value_locator {
+/// \brief Value locator that holds a tag and a 64-bit value.
+/// Takes 16 bytes due to padding.
+/// All values are stored in place; the wide_integer_slots parameters
+/// only mirror the interface of compact_value_locator.
+class padded_value_locator {
  public:
   using index_type = uint64_t;
 
+  using bool_reference         = bool &;
+  using int64_reference        = int64_t &;
+  using uint64_reference       = uint64_t &;
+  using double_reference       = double &;
+  using index_reference        = index_type &;
+  using bool_const_reference   = const bool &;
+  using int64_const_reference  = const int64_t &;
+  using uint64_const_reference = const uint64_t &;
+  using double_const_reference = const double &;
+
  private:
   enum data_tag : uint8_t {
     null,
@@ -40,11 +56,11 @@ class value_locator {
     return std::numeric_limits<index_type>::max();
   }
 
-  value_locator() { reset(); }
+  padded_value_locator() { reset(); }
 
-  ~value_locator() noexcept = default;
+  ~padded_value_locator() noexcept = default;
 
-  bool operator==(const value_locator &other) {
+  bool operator==(const padded_value_locator &other) {
     return m_tag == other.m_tag &&
            (is_null() ||
             (is_bool() && m_data.bool_value == other.m_data.bool_value) ||
@@ -54,7 +70,9 @@ class value_locator {
             (m_data.index == other.m_data.index));
   }
 
-  bool operator!=(const value_locator &other) { return !(*this == other); }
+  bool operator!=(const padded_value_locator &other) {
+    return !(*this == other);
+  }
 
   bool is_null() const { return m_tag == data_tag::null; }
 
@@ -72,6 +90,8 @@ class value_locator {
 
   bool is_object_index() const { return m_tag == data_tag::object_index; }
 
+  bool is_out_of_line() const { return false; }
+
   bool is_primitive() const {
     return is_bool() || is_int64() || is_uint64() || is_double();
   }
@@ -85,12 +105,12 @@ class value_locator {
     return m_data.bool_value;
   }
 
-  int64_t &as_int64() {
+  int64_t &as_int64(const wide_integer_slots & = {}) {
     assert(m_tag == data_tag::int64_value);
     return m_data.int64_value;
   }
 
-  uint64_t &as_uint64() {
+  uint64_t &as_uint64(const wide_integer_slots & = {}) {
     assert(m_tag == data_tag::uint64_value);
     return m_data.uint64_value;
   }
@@ -110,12 +130,12 @@ class value_locator {
     return m_data.bool_value;
   }
 
-  int64_t as_int64() const {
+  int64_t as_int64(const wide_integer_slots & = {}) const {
     assert(m_tag == data_tag::int64_value);
     return m_data.int64_value;
   }
 
-  uint64_t as_uint64() const {
+  uint64_t as_uint64(const wide_integer_slots & = {}) const {
     assert(m_tag == data_tag::uint64_value);
     return m_data.uint64_value;
   }
@@ -137,12 +157,12 @@ class value_locator {
     return m_data.bool_value;
   }
 
-  int64_t &emplace_int64() {
+  int64_t &emplace_int64(const wide_integer_slots & = {}) {
     m_tag = data_tag::int64_value;
     return m_data.int64_value;
   }
 
-  uint64_t &emplace_uint64() {
+  uint64_t &emplace_uint64(const wide_integer_slots & = {}) {
     m_tag = data_tag::uint64_value;
     return m_data.uint64_value;
   }
@@ -167,7 +187,7 @@ class value_locator {
     return m_data.index;
   }
 
-  void reset() {
+  void reset(const wide_integer_slots & = {}) {
     m_data.reset();
     m_tag = data_tag::null;
   }
@@ -177,4 +197,18 @@ class value_locator {
   data_tag  m_tag;
 };
 
+#if defined(DOXYGEN_SKIP)
+/// \brief If defined, use the 8-byte compact_value_locator
+/// instead of padded_value_locator.
+/// Data stores made with one layout cannot be opened with the other;
+/// see examples/json_bento_relayout.cpp to convert them.
+#define JSON_BENTO_COMPACT_VALUE_LOCATOR
+#endif
+
+#ifdef JSON_BENTO_COMPACT_VALUE_LOCATOR
+using value_locator = compact_value_locator;
+#else
+using value_locator = padded_value_locator;
+#endif
+
 }  // namespace json_bento::jbdtl
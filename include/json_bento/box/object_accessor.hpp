@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <limits>
 #include <memory>
 #include <optional>
 #include <type_traits>
@@ -37,6 +38,14 @@ class object_accessor {
   object_accessor(const std::size_t index, box_pointer_t box)
       : m_object_index(index), m_core_data(box) {}
 
+  /// \brief Constructor for an object that is a root value.
+  /// \param index Object index.
+  /// \param root_index Index of the root value.
+  /// \param box Pointer to the core data.
+  object_accessor(const std::size_t index, const std::size_t root_index,
+                  box_pointer_t box)
+      : m_object_index(index), m_root_index(root_index), m_core_data(box) {}
+
   value_accessor_type operator[](const key_type &key) {
     const auto idx = priv_find(key);
     if (idx != size()) {
@@ -44,12 +53,19 @@ class object_accessor {
                                  m_object_index, idx, m_core_data);
     }
 
-    // Allocate a new item
-    const auto key_loc = m_core_data->key_storage.find_or_add(key);
-    m_core_data->object_storage.push_back(
-        m_object_index, key_value_pair(key_loc, value_locator()));
-    return value_accessor_type(value_accessor_type::value_type_tag::object,
-                               m_object_index, size() - 1, m_core_data);
+    return priv_add(m_core_data->key_storage.find_or_add(key));
+  }
+
+  /// \brief Same as operator[](key), but takes a key locator given by
+  /// box::add_key() so that the key does not have to be hashed again.
+  value_accessor_type find_or_add(const key_locator key_loc) {
+    const auto idx = priv_find_locator(key_loc);
+    if (idx != size()) {
+      return value_accessor_type(value_accessor_type::value_type_tag::object,
+                                 m_object_index, idx, m_core_data);
+    }
+
+    return priv_add(key_loc);
   }
 
   /// \brief Equal operator.
@@ -80,8 +96,21 @@ class object_accessor {
   /// \return The value associated with the key in std::optional if it exists;
   /// otherwise, empty std::optional (i.e., std::nullopt).
   std::optional<value_accessor_type> if_contains(const key_type &key) const {
-    if (contains(key)) return at(key);
-    return std::nullopt;
+    return priv_if_contains(priv_find(key));
+  }
+
+  /// \brief Same as if_contains(key), but takes a key locator given by
+  /// locate_key() so that the key does not have to be hashed again.
+  std::optional<value_accessor_type> if_contains(
+      const key_locator key_loc) const {
+    return priv_if_contains(priv_find_locator(key_loc));
+  }
+
+  /// \brief Returns the locator of a key.
+  /// A locator is valid for all objects in the same box; keys that do not
+  /// exist in the box are never found by if_contains(key_locator).
+  key_locator locate_key(const key_type &key) const {
+    return m_core_data->key_storage.find(key);
   }
 
   /// \brief Count the number of elements with a specific key.
@@ -138,9 +167,30 @@ class object_accessor {
   }
 
   /// \brief Find the index of the item associated with key.
+  /// Uses the column index if this object is a root value and the key is
+  /// indexed; uses a binary search if this object is wide.
   std::size_t priv_find(const key_type &key) const {
-    const auto  key_loc = m_core_data->key_storage.find(key);
-    std::size_t i       = 0;
+    return priv_find_locator(m_core_data->key_storage.find(key));
+  }
+
+  std::size_t priv_find_locator(const key_locator key_loc) const {
+    if (m_root_index != k_no_root) {
+      const auto &index = m_core_data->column_index_storage;
+      const auto  pos   = index.find(key_loc, m_root_index);
+      if (pos == index.k_absent) {
+        return size();
+      } else if (pos != index.k_unknown) {
+        assert(m_core_data->object_storage.at(m_object_index, pos).key() ==
+               key_loc);
+        return pos;
+      }
+    }
+
+    if (has_object_key_order(*m_core_data, m_object_index)) {
+      return find_in_object_key_order(*m_core_data, m_object_index, key_loc);
+    }
+
+    std::size_t i = 0;
     for (; i < m_core_data->object_storage.size(m_object_index); ++i) {
       auto &kv = m_core_data->object_storage.at(m_object_index, i);
       if (kv.key() == key_loc) {
@@ -150,6 +200,28 @@ class object_accessor {
     return i;
   }
 
+  /// \brief Appends an item with 'key_loc' and a null value.
+  value_accessor_type priv_add(const key_locator key_loc) {
+    m_core_data->object_storage.push_back(
+        m_object_index, key_value_pair(key_loc, value_locator()));
+    if (m_root_index != k_no_root) {
+      m_core_data->column_index_storage.set_if_indexed(key_loc, m_root_index,
+                                                       size() - 1);
+    }
+    if (m_core_data->sorted_key_threshold > 0) {
+      update_object_key_order(*m_core_data, m_object_index);
+    }
+    return value_accessor_type(value_accessor_type::value_type_tag::object,
+                               m_object_index, size() - 1, m_core_data);
+  }
+
+  std::optional<value_accessor_type> priv_if_contains(
+      const std::size_t pos) const {
+    if (pos == size()) return std::nullopt;
+    return value_accessor_type(value_accessor_type::value_type_tag::object,
+                               m_object_index, pos, m_core_data);
+  }
+
   std::size_t priv_count(const key_type &key) const {
     const auto  key_loc = m_core_data->key_storage.find(key);
     std::size_t count   = 0;
@@ -170,7 +242,11 @@ class object_accessor {
     return m_core_data->object_storage.end(m_object_index);
   }
 
+  static constexpr std::size_t k_no_root =
+      std::numeric_limits<std::size_t>::max();
+
   std::size_t   m_object_index;
+  std::size_t   m_root_index{k_no_root};
   box_pointer_t m_core_data;
 };
 
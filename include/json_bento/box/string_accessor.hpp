@@ -10,6 +10,7 @@
 #include <string_view>
 
 #include <json_bento/box/accessor_fwd.hpp>
+#include <json_bento/box/core_data/value_locator.hpp>
 #include <json_bento/details/compact_string_storage.hpp>
 
 namespace json_bento::jbdtl {
@@ -21,6 +22,9 @@ class string_accessor {
   using storage_pointer_t =
       typename std::pointer_traits<typename std::allocator_traits<
           storage_allocator_type>::pointer>::template rebind<storage_t>;
+  using owner_pointer_t =
+      typename std::pointer_traits<typename std::allocator_traits<
+          storage_allocator_type>::pointer>::template rebind<value_locator>;
 
  public:
   using char_type      = typename storage_t::char_type;
@@ -30,23 +34,42 @@ class string_accessor {
   string_accessor(const std::size_t id, storage_t* const storage)
       : m_id(id), m_storage(storage) {}
 
+  /// \brief Constructor.
+  /// \param id String ID.
+  /// \param storage String storage.
+  /// \param owner The value locator that holds 'id'.
+  /// It is updated if 'id' changes by an assignment, i.e.,
+  /// the string was shared with others (interned).
+  string_accessor(const std::size_t id, storage_t* const storage,
+                  value_locator* const owner)
+      : m_id(id), m_storage(storage), m_owner(owner) {}
+
   string_accessor(const string_accessor&)                = default;
   string_accessor(string_accessor&&) noexcept            = default;
   string_accessor& operator=(const string_accessor&)     = default;
   string_accessor& operator=(string_accessor&&) noexcept = default;
 
   string_accessor& operator=(const char_type* const s) {
-    m_storage->assign(m_id, s, std::strlen(s));
+    priv_assign(s, std::strlen(s));
+    return *this;
+  }
+
+  /// \brief Assigns the characters of a view, which does not need to be
+  /// null-terminated.
+  string_accessor& operator=(const std::basic_string_view<char_type> s) {
+    priv_assign(s.data(), s.size());
     return *this;
   }
 
   friend bool operator==(const string_accessor& lhd,
-                         const string_accessor& rhd) noexcept {
-    return lhd.priv_get() == rhd.priv_get();
+                         const string_accessor& rhd) {
+    // Interned strings can be compared by their IDs
+    if (lhd.m_storage == rhd.m_storage && lhd.m_id == rhd.m_id) return true;
+    return lhd.str_view() == rhd.str_view();
   }
 
   friend bool operator!=(const string_accessor& lhd,
-                         const string_accessor& rhd) noexcept {
+                         const string_accessor& rhd) {
     return !(lhd == rhd);
   }
 
@@ -59,49 +82,67 @@ class string_accessor {
   /// \brief Provides an explicit conversion to std::basic_string_view.
   /// \return A std::basic_string_view with the same data.
   explicit operator std::basic_string_view<char_type>() const {
-    return std::basic_string_view<char_type>(c_str(), size());
+    return str_view();
+  }
+
+  /// \brief Returns a view of the stored string without copying it.
+  /// The view is valid until the string is modified or removed.
+  /// The view of a compressed string is valid until the thread has accessed
+  /// a few other compressed strings (see compressed_string_blocks).
+  /// \return A std::basic_string_view referring to the stored data.
+  std::basic_string_view<char_type> str_view() const {
+    return m_storage->str_view(m_id);
   }
 
   /// \brief Checks whether the string is empty.
   /// \return True if the string is empty, false otherwise.
-  bool empty() const noexcept { return size() == 0; }
+  bool empty() const { return size() == 0; }
 
   /// \brief Returns the number of CharT elements in the string.
   /// \return The number of CharT elements in the string.
-  std::size_t size() const noexcept { return priv_get().size(); }
+  std::size_t size() const { return m_storage->length(m_id); }
 
   /// \brief Returns the number of CharT elements in the string.
   /// \return The number of CharT elements in the string.
-  std::size_t length() const noexcept { return priv_get().length(); }
+  std::size_t length() const { return m_storage->length(m_id); }
 
   /// \brief Returns a pointer to a null-terminated character array with data
   /// equivalent to those stored in the string.
   /// Does not return a null-terminated character array if the stored string is
   /// empty.
   /// \return Pointer to the underlying character storage.
-  const char_type* c_str() const noexcept { return priv_get().c_str(); }
+  const char_type* c_str() const { return m_storage->c_str(m_id); }
 
   /// \brief Returns a pointer to a null-terminated character array with data
   /// equivalent to those stored in the string.
   /// Does not return a null-terminated character array if the stored string is
   /// empty.
   /// \return Pointer to the underlying character storage.
-  const char_type* data() const noexcept { return c_str(); }
+  const char_type* data() const { return c_str(); }
 
   /// \brief Removes all characters from the string.
-  void clear() { return m_storage->assign(m_id, "", 0); }
+  void clear() { priv_assign("", 0); }
 
   /// \brief Returns an iterator to the beginning.
+  /// A string shared with others (interned) is copied first,
+  /// so that writing through the iterator does not modify the others.
   /// \return An iterator to the beginning.
-  iterator begin() { return m_storage->begin_at(m_id); }
+  iterator begin() {
+    priv_detach();
+    return m_storage->begin_at(m_id);
+  }
 
   /// \brief Returns an iterator to the beginning.
   /// \return An iterator to the beginning.
   const_iterator begin() const { return m_storage->begin_at(m_id); }
 
   /// \brief Returns an iterator to the end.
+  /// A string shared with others is copied first, see begin().
   /// \return An iterator to the end.
-  iterator end() { return m_storage->end_at(m_id); }
+  iterator end() {
+    priv_detach();
+    return m_storage->end_at(m_id);
+  }
 
   /// \brief Returns an iterator to the end.
   /// \return An iterator to the end.
@@ -114,15 +155,28 @@ class string_accessor {
   /// if this string is greater than the other character sequence.
   int compare(std::size_t pos1, std::size_t count1, const char_type* s,
               std::size_t count2) const {
-    return priv_get().compare(pos1, count1, s, count2);
+    return str_view().compare(pos1, count1,
+                              std::basic_string_view<char_type>(s, count2));
   }
 
  private:
-  auto&       priv_get() { return m_storage->at(m_id); }
-  const auto& priv_get() const { return m_storage->at(m_id); }
+  void priv_assign(const char_type* const s, const std::size_t count) {
+    priv_set_id(m_storage->assign(m_id, s, count));
+  }
+
+  void priv_detach() { priv_set_id(m_storage->detach(m_id)); }
+
+  void priv_set_id(const std::size_t new_id) {
+    if (new_id != m_id) {
+      assert(m_owner);
+      m_id     = new_id;
+      m_owner->as_index() = new_id;
+    }
+  }
 
   std::size_t       m_id{0};
   storage_pointer_t m_storage{nullptr};
+  owner_pointer_t   m_owner{nullptr};
 };
 
 }  // namespace json_bento::jbdtl
@@ -153,7 +153,7 @@ class value_accessor {
   /// \brief Assign a std::string_view value.
   /// Allocates a memory storage or destroy the old content, if necessary.
   value_accessor &operator=(std::string_view s) {
-    emplace_string() = s.data();
+    emplace_string() = s;
     return *this;
   }
 
@@ -233,48 +233,52 @@ class value_accessor {
   bool is_object() const { return get_locator().is_object_index(); }
 
   /// \brief Return true if this is a bool.
-  bool &as_bool() {
-    return const_cast<bool &>(const_cast<const self_type *>(this)->as_bool());
+  /// \note For an element of a packed array (see box::pack_numeric_arrays()),
+  /// this and the other numeric accessors return a reference to a copy of the
+  /// element. Use operator= to modify such an element.
+  value_locator::bool_reference as_bool() {
+    assert(is_bool());
+    return get_locator().as_bool();
   }
 
   /// \brief Return a reference to the held value as a bool.
-  const bool &as_bool() const {
+  value_locator::bool_const_reference as_bool() const {
     assert(is_bool());
     return get_locator().as_bool();
   }
 
   /// \brief Return a reference to the held value as a int64.
-  int64_t &as_int64() {
-    return const_cast<int64_t &>(
-        const_cast<const self_type *>(this)->as_int64());
+  value_locator::int64_reference as_int64() {
+    assert(is_int64());
+    return get_locator().as_int64(priv_wide_integers());
   }
 
   /// \brief Return a reference to the held value as a int64.
-  const int64_t &as_int64() const {
+  value_locator::int64_const_reference as_int64() const {
     assert(is_int64());
-    return get_locator().as_int64();
+    return get_locator().as_int64(priv_wide_integers());
   }
 
   /// \brief Return a reference to the held value as a uint64.
-  uint64_t &as_uint64() {
-    return const_cast<uint64_t &>(
-        const_cast<const self_type *>(this)->as_uint64());
+  value_locator::uint64_reference as_uint64() {
+    assert(is_uint64());
+    return get_locator().as_uint64(priv_wide_integers());
   }
 
   /// \brief Return a reference to the held value as a uint64.
-  const uint64_t &as_uint64() const {
+  value_locator::uint64_const_reference as_uint64() const {
     assert(is_uint64());
-    return get_locator().as_uint64();
+    return get_locator().as_uint64(priv_wide_integers());
   }
 
   /// \brief Return a reference to the held value as a double.
-  double &as_double() {
-    return const_cast<double &>(
-        const_cast<const self_type *>(this)->as_double());
+  value_locator::double_reference as_double() {
+    assert(is_double());
+    return get_locator().as_double();
   }
 
   /// \brief Return a reference to the held value as a double.
-  const double &as_double() const {
+  value_locator::double_const_reference as_double() const {
     assert(is_double());
     return get_locator().as_double();
   }
@@ -287,8 +291,8 @@ class value_accessor {
   /// \brief Return a reference to the held value as a string.
   const string_accessor as_string() const {
     assert(is_string());
-    const auto index = get_locator().as_index();
-    return string_accessor(index, &m_box->string_storage);
+    auto &loc = get_locator();
+    return string_accessor(loc.as_index(), &m_box->string_storage, &loc);
   }
 
   /// \brief Return a reference to the held value as a array.
@@ -312,6 +316,10 @@ class value_accessor {
   const object_accessor as_object() const {
     assert(is_object());
     const auto index = get_locator().as_index();
+    if (m_tag == value_type_tag::root) {
+      return object_accessor(index, m_pos0,
+                             const_cast<self_type *>(this)->m_box);
+    }
     return object_accessor(index, const_cast<self_type *>(this)->m_box);
   }
 
@@ -320,28 +328,28 @@ class value_accessor {
 
   /// \brief Erase the existing value and reset it to bool.
   /// \return A reference to the new value as bool.
-  bool &emplace_bool() {
+  value_locator::bool_reference emplace_bool() {
     priv_reset();
     return get_locator().emplace_bool();
   }
 
   /// \brief Erase the existing value and reset it to int64.
   /// \return A reference to the new value as int64.
-  int64_t &emplace_int64() {
+  value_locator::int64_reference emplace_int64() {
     priv_reset();
-    return get_locator().emplace_int64();
+    return get_locator().emplace_int64(priv_wide_integers());
   }
 
   /// \brief Erase the existing value and reset it to uint64.
   /// \return A reference to the new value as uint64.
-  uint64_t &emplace_uint64() {
+  value_locator::uint64_reference emplace_uint64() {
     priv_reset();
-    return get_locator().emplace_uint64();
+    return get_locator().emplace_uint64(priv_wide_integers());
   }
 
   /// \brief Erase the existing value and reset it to double.
   /// \return A reference to the new value as double.
-  double &emplace_double() {
+  value_locator::double_reference emplace_double() {
     priv_reset();
     return get_locator().emplace_double();
   }
@@ -351,9 +359,10 @@ class value_accessor {
   /// \note The string accessor is invalidated if the value is modified.
   string_accessor emplace_string() {
     priv_reset();
-    const auto index                     = m_box->string_storage.emplace();
-    get_locator().emplace_string_index() = index;
-    return string_accessor(index, &m_box->string_storage);
+    const auto index = m_box->string_storage.emplace();
+    auto      &loc   = get_locator();
+    loc.emplace_string_index() = index;
+    return string_accessor(index, &m_box->string_storage, &loc);
   }
 
   /// \brief Erase the existing value and reset it to array.
@@ -371,6 +380,12 @@ class value_accessor {
     priv_reset();
     const auto index                     = m_box->object_storage.push_back();
     get_locator().emplace_object_index() = index;
+    if (m_tag == value_type_tag::root) {
+      if (!m_box->column_index_storage.empty()) {
+        update_column_index(*m_box, m_pos0);
+      }
+      return object_accessor(index, m_pos0, m_box);
+    }
     return object_accessor(index, m_box);
   }
 
@@ -378,6 +393,7 @@ class value_accessor {
   /// and replaces the existing value with the parsed one.
   /// \param input_json_string Input JSON string.
   void parse(std::string_view input_json_string) {
+    priv_unpack();
     boost::json::error_code ec;
     auto bj_value = boost::json::parse(input_json_string.data(), ec);
     if (ec) {
@@ -387,6 +403,10 @@ class value_accessor {
     }
 
     add_value(bj_value, *m_box, get_locator());
+    if (m_tag == value_type_tag::root &&
+        !m_box->column_index_storage.empty()) {
+      update_column_index(*m_box, m_pos0);
+    }
   }
 
   /// \brief Returns an allocator instance.
@@ -436,6 +456,10 @@ class value_accessor {
     if (m_tag == value_type_tag::root) {
       return m_box->root_value_storage.at(m_pos0);
     } else if (m_tag == value_type_tag::array) {
+      if (is_packed_array(*m_box, m_pos0)) {
+        m_packed_value = packed_array_at(*m_box, m_pos0, m_pos1);
+        return m_packed_value;
+      }
       return m_box->array_storage.at(m_pos0, m_pos1);
     } else if (m_tag == value_type_tag::object) {
       return m_box->object_storage.at(m_pos0, m_pos1).value();
@@ -444,26 +468,52 @@ class value_accessor {
     return m_box->root_value_storage.at(m_pos0); // dummy to remove warning
   }
 
+  /// \brief Returns the slots of the integers that do not fit in a value
+  /// locator. An element of a packed array is a copy and gets none.
+  wide_integer_slots priv_wide_integers() const {
+    if (m_tag == value_type_tag::array && is_packed_array(*m_box, m_pos0)) {
+      return wide_integer_slots();
+    }
+    return wide_integers_of(*m_box);
+  }
+
+  /// \brief Unpacks the array that holds this value, if it is packed,
+  /// so that the value can be modified.
+  void priv_unpack() {
+    if (m_tag == value_type_tag::array) {
+      unpack_array(*m_box, m_pos0);
+    }
+  }
+
   void priv_reset() {
+    priv_unpack();
     if (get_locator().is_null() || get_locator().is_primitive()) {
     } else if (get_locator().is_string_index()) {
       m_box->string_storage.erase(get_locator().as_index());
     } else if (get_locator().is_array_index()) {
       m_box->array_storage.clear(get_locator().as_index());
       m_box->array_storage.shrink_to_fit(get_locator().as_index());
+      clear_packed_array(*m_box, get_locator().as_index());
     } else if (get_locator().is_object_index()) {
       m_box->object_storage.clear(get_locator().as_index());
       m_box->object_storage.shrink_to_fit(get_locator().as_index());
+      clear_object_key_order(*m_box, get_locator().as_index());
     } else {
       assert(false);
     }
-    get_locator().reset();
+    get_locator().reset(priv_wide_integers());
+    if (m_tag == value_type_tag::root) {
+      m_box->column_index_storage.invalidate(m_pos0);
+    }
   }
 
   value_type_tag m_tag{value_type_tag::invalid};
   position_type  m_pos0{0};
   position_type  m_pos1{0};
   box_pointer_t  m_box{nullptr};
+
+  // Copy of the value if it is an element of a packed array
+  mutable value_locator_t m_packed_value{};
 };
 
 }  // namespace json_bento::jbdtl
@@ -5,6 +5,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <cstdlib>
 
 namespace json_bento::jbdtl {
@@ -17,4 +18,27 @@ static constexpr uint64_t get_lsb(const uint64_t value) {
   }
   return lsb;
 }
+
+/// \brief Returns the number of 64-bit words to hold 'num_bits' bits.
+static constexpr std::size_t num_bitmap_words(const std::size_t num_bits) {
+  return (num_bits + 63) / 64;
+}
+
+/// \brief Returns true if the bit at 'pos' is set.
+template <typename word_array_type>
+inline bool bitmap_test(const word_array_type &bitmap, const std::size_t pos) {
+  return bitmap[pos / 64] & (0x1ULL << (pos % 64));
+}
+
+/// \brief Sets the bit at 'pos'.
+template <typename word_array_type>
+inline void bitmap_set(word_array_type &bitmap, const std::size_t pos) {
+  bitmap[pos / 64] |= (0x1ULL << (pos % 64));
+}
+
+/// \brief Resets the bit at 'pos'.
+template <typename word_array_type>
+inline void bitmap_reset(word_array_type &bitmap, const std::size_t pos) {
+  bitmap[pos / 64] &= ~(0x1ULL << (pos % 64));
+}
 }  // namespace json_bento::jbdtl
@@ -0,0 +1,147 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <scoped_allocator>
+
+#include <metall/container/vector.hpp>
+
+#include <json_bento/box/core_data/key_locator.hpp>
+
+namespace json_bento::jbdtl {
+
+/// \brief Shadow index that keeps, for a few 'indexed' keys,
+/// the position of the key inside each root object.
+/// Each indexed key has one contiguous column whose i-th element is the
+/// position of the key in the i-th root object.
+/// A lookup of an indexed key in a root object therefore does not need to scan
+/// the key-value pairs of the object.
+/// \tparam Alloc Allocator type.
+template <typename Alloc = std::allocator<std::byte>>
+class column_index {
+ public:
+  using allocator_type = Alloc;
+  using position_type  = uint32_t;
+
+  /// \brief The position of the key is not known (e.g., the root value has
+  /// been replaced). The caller must fall back to a linear search.
+  static constexpr position_type k_unknown =
+      std::numeric_limits<position_type>::max();
+
+  /// \brief The root value does not contain the key.
+  static constexpr position_type k_absent = k_unknown - 1;
+
+ private:
+  template <typename T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  template <typename T>
+  using other_scoped_allocator =
+      std::scoped_allocator_adaptor<other_allocator<T>>;
+
+  using column_type =
+      metall::container::vector<position_type, other_allocator<position_type>>;
+  using column_table_type =
+      metall::container::vector<column_type,
+                                other_scoped_allocator<column_type>>;
+  using key_table_type =
+      metall::container::vector<key_locator, other_allocator<key_locator>>;
+
+ public:
+  column_index() = default;
+
+  explicit column_index(const allocator_type &alloc)
+      : m_keys(alloc), m_columns(alloc) {}
+
+  /// \brief Returns the number of indexed keys.
+  std::size_t num_columns() const { return m_keys.size(); }
+
+  /// \brief Returns true if there is no indexed key.
+  bool empty() const { return m_keys.empty(); }
+
+  /// \brief Returns the key locator of the column.
+  key_locator key(const std::size_t column) const { return m_keys.at(column); }
+
+  /// \brief Finds the column of a key.
+  /// \return The column number if the key is indexed;
+  /// otherwise, num_columns().
+  std::size_t find_column(const key_locator key) const {
+    std::size_t c = 0;
+    for (; c < m_keys.size(); ++c) {
+      if (m_keys[c] == key) break;
+    }
+    return c;
+  }
+
+  /// \brief Adds a new column for 'key'.
+  /// All positions of rows [0, num_rows) are initialized with k_unknown.
+  /// \return The column number of the key.
+  std::size_t add_column(const key_locator key, const std::size_t num_rows) {
+    const auto c = find_column(key);
+    if (c != num_columns()) return c;
+
+    m_keys.push_back(key);
+    m_columns.emplace_back();
+    m_columns.back().resize(num_rows, k_unknown);
+    return num_columns() - 1;
+  }
+
+  /// \brief Returns the position of the key in a root object.
+  /// \return The position, k_absent, or k_unknown.
+  /// k_unknown is also returned if 'key' is not indexed.
+  position_type find(const key_locator key, const std::size_t row) const {
+    const auto c = find_column(key);
+    if (c == num_columns() || row >= m_columns[c].size()) return k_unknown;
+    return m_columns[c][row];
+  }
+
+  /// \brief Sets the position of the column 'column' at 'row'.
+  /// Expands the column if necessary.
+  void set(const std::size_t column, const std::size_t row,
+           const position_type position) {
+    auto &col = m_columns.at(column);
+    if (row >= col.size()) col.resize(row + 1, k_unknown);
+    col[row] = position;
+  }
+
+  /// \brief Sets the position of 'key' at 'row' if 'key' is indexed.
+  void set_if_indexed(const key_locator key, const std::size_t row,
+                      const position_type position) {
+    const auto c = find_column(key);
+    if (c != num_columns()) set(c, row, position);
+  }
+
+  /// \brief Forgets the positions at 'row' in all columns.
+  void invalidate(const std::size_t row) {
+    for (auto &col : m_columns) {
+      if (row < col.size()) col[row] = k_unknown;
+    }
+  }
+
+  /// \brief Removes all positions but keeps the indexed keys.
+  void clear_rows() {
+    for (auto &col : m_columns) col.clear();
+  }
+
+  /// \brief Removes all indexed keys and their positions.
+  void clear() {
+    m_columns.clear();
+    m_keys.clear();
+  }
+
+  allocator_type get_allocator() const { return m_keys.get_allocator(); }
+
+ private:
+  key_table_type    m_keys;
+  column_table_type m_columns;
+};
+
+}  // namespace json_bento::jbdtl
@@ -9,6 +9,7 @@
 #include <memory>
 
 #include <json_bento/details/compact_vector.hpp>
+#include <json_bento/details/row_pool.hpp>
 
 namespace json_bento::jbdtl {
 
@@ -43,7 +44,7 @@ class compact_adjacency_list {
   compact_adjacency_list() = default;
 
   explicit compact_adjacency_list(const allocator_type &alloc)
-      : m_allocator(alloc) {}
+      : m_allocator(alloc), m_row_pool(alloc) {}
 
   ~compact_adjacency_list() noexcept { priv_destroy(); }
 
@@ -91,7 +92,7 @@ class compact_adjacency_list {
   void resize(const std::size_t size) { priv_resize(size); }
 
   void resize(const std::size_t row, const std::size_t size) {
-    m_table.at(row).resize(size, m_allocator);
+    m_table.at(row).resize(size, priv_row_allocator());
   }
 
   void reserve(const std::size_t capacity) {
@@ -99,7 +100,7 @@ class compact_adjacency_list {
   }
 
   void reserve(const std::size_t row, const std::size_t capacity) {
-    m_table.at(row).reserve(capacity, m_allocator);
+    m_table.at(row).reserve(capacity, priv_row_allocator());
   }
 
   std::size_t push_back() {
@@ -111,7 +112,8 @@ class compact_adjacency_list {
     if (row >= size()) {
       resize(row + 1);
     }
-    m_table.at(row).push_back(std::forward<value_type>(value), m_allocator);
+    m_table.at(row).push_back(std::forward<value_type>(value),
+                              priv_row_allocator());
     return m_table.at(row).size() - 1;
   }
 
@@ -133,29 +135,58 @@ class compact_adjacency_list {
     return m_table.at(row).capacity();
   }
 
+  /// \brief Returns the number of bytes used by the table and the rows,
+  /// counting the capacities of the rows.
+  std::size_t memory_size() const {
+    std::size_t total = m_table.capacity() * sizeof(row_list_type);
+    for (const auto &item : m_table) {
+      total += item.capacity() * sizeof(value_type);
+    }
+    return total;
+  }
+
   /// \brief Clear the row.
   /// \warning This function does not shrink the memory of the row.
-  void clear(const std::size_t row) { m_table.at(row).clear(m_allocator); }
+  void clear(const std::size_t row) {
+    m_table.at(row).clear(priv_row_allocator());
+  }
 
   /// \brief Clear all rows.
   /// \warning This function shrink the memory of each row but not that of main
   /// table.
   void clear() {
     for (auto &item : m_table) {
-      item.destroy(m_allocator);
+      item.destroy(priv_row_allocator());
     }
     m_table.clear(m_allocator);
+    m_row_pool.clear(m_allocator);
   }
 
   /// \brief Shrink the memory of the row.
   void shrink_to_fit(const std::size_t row) {
-    m_table.at(row).shrink_to_fit(m_allocator);
+    m_table.at(row).shrink_to_fit(priv_row_allocator());
+  }
+
+  /// \brief Returns how rows are allocated.
+  row_allocation_mode row_allocation() const { return m_row_pool.mode(); }
+
+  /// \brief Changes how rows are allocated.
+  /// Can be changed only while no row has memory, e.g., right after
+  /// construction or clear().
+  /// \return Returns true on success; otherwise, false.
+  bool set_row_allocation(const row_allocation_mode mode) {
+    for (const auto &item : m_table) {
+      if (item.capacity() > 0) return false;
+    }
+    m_row_pool.clear(m_allocator);
+    m_row_pool.set_mode(mode);
+    return true;
   }
 
   /// \brief Shrink the memory.
   void shrink_to_fit() {
     for (auto &item : m_table) {
-      item.shrink_to_fit(m_allocator);
+      item.shrink_to_fit(priv_row_allocator());
     }
     m_table.shrink_to_fit(m_allocator);
   }
@@ -163,9 +194,10 @@ class compact_adjacency_list {
  private:
   void priv_destroy() {
     for (std::size_t i = 0; i < m_table.size(); ++i) {
-      m_table.at(i).destroy(m_allocator);
+      m_table.at(i).destroy(priv_row_allocator());
     }
     m_table.destroy(m_allocator);
+    m_row_pool.clear(m_allocator);
   }
 
   void priv_resize(const std::size_t size) {
@@ -175,15 +207,20 @@ class compact_adjacency_list {
 
     if (size < m_table.size()) {
       for (std::size_t i = size; i < m_table.size(); ++i) {
-        m_table.at(i).destroy(m_allocator);
+        m_table.at(i).destroy(priv_row_allocator());
       }
     }
 
     m_table.resize(size, m_allocator);
   }
 
-  allocator_type   m_allocator{allocator_type{}};
-  column_list_type m_table{};
+  row_allocator<T, Alloc> priv_row_allocator() {
+    return row_allocator<T, Alloc>(m_allocator, &m_row_pool);
+  }
+
+  allocator_type     m_allocator{allocator_type{}};
+  column_list_type   m_table{};
+  row_pool<T, Alloc> m_row_pool{allocator_type{}};
 };
 
 }  // namespace json_bento::jbdtl
@@ -122,6 +122,12 @@ class compact_string {
   /// \brief Returns the length of the current string.
   std::size_t length() const { return m_str_length; }
 
+  /// \brief Returns the number of bytes allocated for the string;
+  /// 0 if the string is stored inline.
+  std::size_t allocated_size() const {
+    return priv_short_key() ? 0 : m_str_length + 1;
+  }
+
   /// \brief Return `true` if two str-value pairs are equal.
   /// \param lhs A str-value pair to compare.
   /// \param rhs A str-value pair to compare.
@@ -5,25 +5,62 @@
 
 #pragma once
 
+#include <cassert>
+#include <cstdint>
 #include <memory>
 #include <scoped_allocator>
+#include <string>
+#include <string_view>
+
+#include <metall/container/unordered_map.hpp>
+#include <metall/container/vector.hpp>
+#include <metall/utility/hash.hpp>
 
 #include <json_bento/details/compact_string.hpp>
+#include <json_bento/details/compressed_string_blocks.hpp>
 #include <json_bento/details/data_storage.hpp>
 
 namespace json_bento::jbdtl {
 
-template <typename Alloc = std::allocator<std::byte>>
+/// \brief Storage for strings that returns an ID for each string.
+/// Optionally, long strings can be interned (dictionary encoded):
+/// an identical string is stored only once and shared by reference counting.
+/// Strings added by emplace_compressed() are packed into compressed blocks
+/// (see compressed_string_blocks) instead of being allocated one by one;
+/// they are read through str_view(), c_str(), and length().
+/// \tparam Alloc Allocator type.
+/// \tparam FreeSlots Free slot list type of the underlying data_storage.
+template <typename Alloc                      = std::allocator<std::byte>,
+          template <typename> class FreeSlots = ordered_free_slots>
 class compact_string_storage {
  private:
   using compact_string_type =
       compact_string<typename std::allocator_traits<Alloc>::pointer>;
-  using storage_type = data_storage<compact_string_type, Alloc>;
+  using storage_type = data_storage<compact_string_type, Alloc, FreeSlots>;
+
+  template <typename K, typename V>
+  using map_type = metall::container::unordered_map<
+      K, V, std::hash<K>, std::equal_to<K>,
+      typename std::allocator_traits<Alloc>::template rebind_alloc<
+          std::pair<const K, V>>>;
+  // Hash value of a string -> ID
+  using dictionary_type = map_type<uint64_t, std::size_t>;
+  // ID -> reference count
+  using refcount_table_type = map_type<std::size_t, std::size_t>;
+  using blocks_type         = compressed_string_blocks<Alloc>;
+  // ID -> location in the compressed blocks
+  using location_table_type =
+      map_type<std::size_t, typename blocks_type::location>;
+  // One bit per ID, set if the string is compressed
+  using bitmap_type = metall::container::vector<
+      uint64_t,
+      typename std::allocator_traits<Alloc>::template rebind_alloc<uint64_t>>;
 
  public:
   // using view_type = typename compact_string_type::view_type;
   using string_type     = compact_string_type;
   using char_type       = typename string_type::char_type;
+  using view_type       = std::basic_string_view<char_type>;
   using allocator_type  = Alloc;
   using iterator        = typename storage_type::iterator;
   using const_iterator  = typename storage_type::const_iterator;
@@ -34,7 +71,12 @@ class compact_string_storage {
   compact_string_storage() = default;
 
   explicit compact_string_storage(const allocator_type &alloc)
-      : m_storage(alloc) {}
+      : m_storage(alloc),
+        m_dictionary(alloc),
+        m_refcounts(alloc),
+        m_blocks(alloc),
+        m_locations(alloc),
+        m_compressed_ids(alloc) {}
 
   ~compact_string_storage() noexcept { clear(); }
 
@@ -49,15 +91,67 @@ class compact_string_storage {
     return this->at(id);
   };
 
+  /// \brief Returns the string of 'id'.
+  /// A compressed string is not held by a string object;
+  /// use str_view() to access any string.
   const_reference at(const std::size_t id) const { return m_storage.at(id); }
 
+  /// \brief Returns a view of the string of 'id'.
+  /// The view of a compressed string is valid until this storage is modified
+  /// or the calling thread has decompressed a few other blocks
+  /// (see compressed_string_blocks).
+  view_type str_view(const std::size_t id) const {
+    if (compressed(id)) {
+      return m_blocks.view(m_locations.at(id));
+    }
+    return m_storage.at(id).str_view();
+  }
+
+  /// \brief Returns the string of 'id' as a null-terminated array.
+  /// See str_view() for the lifetime of the array.
+  const char_type *c_str(const std::size_t id) const {
+    return str_view(id).data();
+  }
+
+  /// \brief Returns the length of the string of 'id'.
+  size_type length(const std::size_t id) const {
+    if (compressed(id)) {
+      return m_locations.at(id).length;
+    }
+    return m_storage.at(id).length();
+  }
+
+  /// \brief Returns true if the string of 'id' is compressed.
+  bool compressed(const std::size_t id) const {
+    const std::size_t word = id / 64;
+    return word < m_compressed_ids.size() &&
+           (m_compressed_ids[word] >> (id % 64) & 1);
+  }
+
   std::size_t emplace() {
     const auto id = m_storage.emplace();
     return id;
   }
 
   std::size_t emplace(const char_type *s, size_type count) {
+    if (!priv_internable(count)) {
+      return m_storage.emplace(s, count, get_allocator());
+    }
+
+    const auto hash = priv_hash(s, count);
+    const auto itr  = m_dictionary.find(hash);
+    if (itr != m_dictionary.end() &&
+        m_storage.at(itr->second).str_view() == std::string_view(s, count)) {
+      ++m_refcounts[itr->second];
+      return itr->second;
+    }
+
     const auto id = m_storage.emplace(s, count, get_allocator());
+    // On a hash collision, the new string is stored without being interned.
+    if (itr == m_dictionary.end()) {
+      m_dictionary.emplace(hash, id);
+      m_refcounts.emplace(id, 1);
+    }
     return id;
   }
 
@@ -66,17 +160,84 @@ class compact_string_storage {
     return id;
   }
 
+  /// \brief Adds a string to the compressed blocks.
+  /// Compressed strings are not interned.
+  /// Without zstd support, the blocks are not compressed.
+  /// \return The ID of the string.
+  std::size_t emplace_compressed(const char_type *s, size_type count) {
+    const auto id = m_storage.emplace();
+    m_locations.emplace(id, m_blocks.add(s, count));
+    priv_set_compressed(id, true);
+    return id;
+  }
+
   void reserve(const std::size_t capacity) { m_storage.reserve(capacity); }
 
-  void assign(const std::size_t id, const char_type *s, size_type count) {
+  /// \brief Replaces the string of 'id'.
+  /// If interning is enabled, the ID can change:
+  /// a string shared with others is not modified but the new string is stored
+  /// with another ID, and a new string that is already interned is shared.
+  /// \return The ID of the new string.
+  std::size_t assign(const std::size_t id, const char_type *s,
+                     size_type count) {
+    // A compressed string is replaced by an uncompressed one.
+    priv_release_compressed(id);
+
+    const auto ref = m_refcounts.find(id);
+    if (ref != m_refcounts.end()) {
+      if (ref->second > 1) {
+        --(ref->second);
+        return emplace(s, count);
+      }
+      priv_remove_from_dictionary(id);
+    }
+
+    if (!priv_internable(count)) {
+      m_storage[id].assign(s, count, get_allocator());
+      return id;
+    }
+
+    const auto hash = priv_hash(s, count);
+    const auto itr  = m_dictionary.find(hash);
+    if (itr != m_dictionary.end() &&
+        m_storage.at(itr->second).str_view() == std::string_view(s, count)) {
+      // Share the existing one
+      m_storage[id].clear(m_storage.get_allocator());
+      m_storage.erase(id);
+      ++m_refcounts[itr->second];
+      return itr->second;
+    }
+
     m_storage[id].assign(s, count, get_allocator());
+    if (itr == m_dictionary.end()) {
+      m_dictionary.emplace(hash, id);
+      m_refcounts.emplace(id, 1);
+    }
+    return id;
   }
 
-  void assign(const std::size_t id, const std::string_view &s) {
-    m_storage[id].assign(s.data(), s.size(), get_allocator());
+  /// \brief Replaces the string of 'id'.
+  /// \return The ID of the new string. See the other overload.
+  std::size_t assign(const std::size_t id, const std::string_view &s) {
+    return assign(id, s.data(), s.size());
   }
 
+  /// \brief Erases a string.
+  /// An interned string is erased when it is no longer referenced.
   void erase(const std::size_t id) {
+    if (priv_release_compressed(id)) {
+      m_storage.erase(id);
+      return;
+    }
+
+    const auto ref = m_refcounts.find(id);
+    if (ref != m_refcounts.end()) {
+      if (ref->second > 1) {
+        --(ref->second);
+        return;
+      }
+      priv_remove_from_dictionary(id);
+    }
     m_storage[id].clear(m_storage.get_allocator());
     m_storage.erase(id);
   }
@@ -85,28 +246,110 @@ class compact_string_storage {
     for (auto &item : m_storage) {
       item.clear(m_storage.get_allocator());
     }
+    m_dictionary.clear();
+    m_refcounts.clear();
+    m_blocks.clear();
+    m_locations.clear();
+    m_compressed_ids.clear();
+  }
+
+  /// \brief Enables or disables string interning.
+  /// Strings added after this call are interned if they are at least
+  /// 'min_length' long. Disabling does not affect already interned strings.
+  /// \param enable Enable if true.
+  /// \param min_length Minimum length of strings to intern.
+  void intern(const bool enable, const std::size_t min_length = 8) {
+    m_intern            = enable;
+    m_intern_min_length = min_length;
+  }
+
+  /// \brief Returns true if string interning is enabled.
+  bool interning() const { return m_intern; }
+
+  /// \brief Returns the minimum length of interned strings.
+  std::size_t intern_min_length() const { return m_intern_min_length; }
+
+  /// \brief Returns the number of references to a string.
+  std::size_t use_count(const std::size_t id) const {
+    const auto ref = m_refcounts.find(id);
+    return (ref == m_refcounts.end()) ? 1 : ref->second;
   }
 
   std::size_t size() const { return m_storage.size(); }
 
+  /// \brief Returns the number of compressed strings.
+  std::size_t num_compressed() const { return m_locations.size(); }
+
+  /// \brief Returns the size of the compressed blocks in bytes
+  /// and the total length of the strings in them.
+  std::pair<std::size_t, std::size_t> compressed_size() const {
+    return {m_blocks.stored_size(), m_blocks.raw_size()};
+  }
+
+  /// \brief Returns the number of free slots, i.e., of erased strings
+  /// whose IDs are reused by later insertions.
+  std::size_t num_free_slots() const { return m_storage.num_free_slots(); }
+
+  /// \brief Returns the number of bytes used by the strings:
+  /// the string slots, the allocated strings, and the compressed blocks.
+  /// The tables of interned and compressed strings are not counted.
+  std::size_t memory_size() const {
+    std::size_t total = m_storage.capacity() * sizeof(string_type);
+    for (const auto &item : m_storage) total += item.allocated_size();
+    total += m_blocks.stored_size();
+    total += m_compressed_ids.size() * sizeof(uint64_t);
+    return total;
+  }
+
   const_iterator begin() const { return m_storage.begin(); }
 
   const_iterator end() const { return m_storage.end(); }
 
+  /// \brief Makes the string of 'id' modifiable in place.
+  /// A string shared with others is copied to a new ID, so that the others
+  /// do not change; an interned string is no longer shared afterward.
+  /// A compressed string is decompressed into a string object.
+  /// \return The ID of the modifiable string.
+  std::size_t detach(const std::size_t id) {
+    priv_decompress(id);
+
+    const auto ref = m_refcounts.find(id);
+    if (ref == m_refcounts.end()) return id;
+    if (ref->second > 1) {
+      --(ref->second);
+      // Copy first: emplace() can move the string objects.
+      const std::basic_string<char_type> str(m_storage.at(id).str_view());
+      return m_storage.emplace(str.data(), str.size(), get_allocator());
+    }
+    priv_remove_from_dictionary(id);
+    return id;
+  }
+
+  /// \brief Returns a mutable iterator to the beginning of a string.
+  /// The string must not be shared, see detach().
   typename string_type::iterator begin_at(const std::size_t id) {
+    const auto detached = detach(id);
+    assert(detached == id);
+    (void)detached;
     return m_storage.at(id).begin();
   }
 
   typename string_type::const_iterator begin_at(const std::size_t id) const {
-    return m_storage.at(id).cbegin();
+    return str_view(id).data();
   }
 
+  /// \brief Returns a mutable iterator to the end of a string.
+  /// The string must not be shared, see detach().
   typename string_type::iterator end_at(const std::size_t id) {
+    const auto detached = detach(id);
+    assert(detached == id);
+    (void)detached;
     return m_storage.at(id).end();
   }
 
   typename string_type::const_iterator end_at(const std::size_t id) const {
-    return m_storage.at(id).cend();
+    const auto view = str_view(id);
+    return view.data() + view.size();
   }
 
   allocator_type get_allocator() const { return m_storage.get_allocator(); }
@@ -116,7 +359,64 @@ class compact_string_storage {
     return (m_storage.capacity() - m_storage.size() > 0);
   }
 
-  storage_type m_storage{};
+  bool priv_internable(const size_type count) const {
+    return m_intern && count >= m_intern_min_length;
+  }
+
+  static uint64_t priv_hash(const char_type *s, const size_type count) {
+    return metall::mtlldetail::MurmurHash64A(s, (int)count, 123);
+  }
+
+  void priv_set_compressed(const std::size_t id, const bool value) {
+    const std::size_t word = id / 64;
+    if (word >= m_compressed_ids.size()) {
+      if (!value) return;
+      m_compressed_ids.resize(word + 1, 0);
+    }
+    const uint64_t bit = uint64_t(1) << (id % 64);
+    if (value) {
+      m_compressed_ids[word] |= bit;
+    } else {
+      m_compressed_ids[word] &= ~bit;
+    }
+  }
+
+  /// \brief Forgets the compressed string of 'id', if any.
+  /// Its space in the blocks is reclaimed only by clear().
+  /// \return True if the string was compressed.
+  bool priv_release_compressed(const std::size_t id) {
+    if (!compressed(id)) return false;
+    m_locations.erase(id);
+    priv_set_compressed(id, false);
+    return true;
+  }
+
+  /// \brief Moves a compressed string into its string object.
+  void priv_decompress(const std::size_t id) {
+    if (!compressed(id)) return;
+    const std::basic_string<char_type> str(str_view(id));
+    priv_release_compressed(id);
+    m_storage[id].assign(str.data(), str.size(), get_allocator());
+  }
+
+  void priv_remove_from_dictionary(const std::size_t id) {
+    const auto &str  = m_storage.at(id);
+    const auto  hash = priv_hash(str.c_str(), str.length());
+    const auto  itr  = m_dictionary.find(hash);
+    if (itr != m_dictionary.end() && itr->second == id) {
+      m_dictionary.erase(itr);
+    }
+    m_refcounts.erase(id);
+  }
+
+  storage_type        m_storage{};
+  dictionary_type     m_dictionary{};
+  refcount_table_type m_refcounts{};
+  blocks_type         m_blocks{allocator_type{}};
+  location_table_type m_locations{};
+  bitmap_type         m_compressed_ids{};
+  bool                m_intern{false};
+  std::size_t         m_intern_min_length{8};
 };
 
 }  // namespace json_bento::jbdtl
@@ -84,39 +84,55 @@ class compact_vector {
 
   std::size_t size() const { return priv_size(); }
 
+  // The memory management functions below take an allocator for value_type or
+  // an allocator that can be rebound to it.
+  // The allocator does not need to be 'Alloc' as long as it returns and takes
+  // the same pointer type, e.g., an allocator that carves small arrays out of
+  // larger chunks.
+
   /// \brief Expand or shrink the size of the vector.
   /// This function will not change the capacity when new_size <= size().
   /// \param new_size New size.
   /// \param allocator Allocator.
-  void resize(const std::size_t new_size, data_allocator_type allocator) {
-    priv_resize(new_size, allocator);
+  template <typename A>
+  void resize(const std::size_t new_size, const A &allocator) {
+    priv_resize(new_size, priv_rebind(allocator));
   }
 
   /// \brief Expand the capacity.
   /// This function will not shrink the capacity.
   /// \param new_capacity New capacity.
   /// \param allocator Allocator.
-  void reserve(const std::size_t new_capacity, data_allocator_type allocator) {
-    priv_reserve(new_capacity, allocator);
+  template <typename A>
+  void reserve(const std::size_t new_capacity, const A &allocator) {
+    priv_reserve(new_capacity, priv_rebind(allocator));
   }
 
-  void push_back(value_type &&value, data_allocator_type allocator) {
-    priv_push_back(std::forward<value_type>(value), allocator);
+  template <typename A>
+  void push_back(value_type &&value, const A &allocator) {
+    priv_push_back(std::forward<value_type>(value), priv_rebind(allocator));
   }
 
   /// \brief Destroy all elements and free the memory.
   /// \param allocator Allocator.
-  void destroy(data_allocator_type allocator) { priv_destroy(allocator); }
+  template <typename A>
+  void destroy(const A &allocator) {
+    priv_destroy(priv_rebind(allocator));
+  }
 
   /// \brief Clear all elements.
   /// This function does not free the memory.
   /// \param allocator Allocator.
-  void clear(data_allocator_type allocator) { priv_clear(allocator); }
+  template <typename A>
+  void clear(const A &allocator) {
+    priv_clear(priv_rebind(allocator));
+  }
 
   /// \brief Shrink the capacity to the size.
   /// \param allocator Allocator.
-  void shrink_to_fit(data_allocator_type allocator) {
-    priv_shrink_to_fit(allocator);
+  template <typename A>
+  void shrink_to_fit(const A &allocator) {
+    priv_shrink_to_fit(priv_rebind(allocator));
   }
 
   reference back() {
@@ -144,6 +160,13 @@ class compact_vector {
   static_assert(k_capacity_mask - ~k_size_mask == 0,
                 "Wrong mask values for capacity and size");
 
+  template <typename A>
+  static auto priv_rebind(const A &allocator) {
+    using rebound_type =
+        typename std::allocator_traits<A>::template rebind_alloc<value_type>;
+    return rebound_type(allocator);
+  }
+
   std::size_t priv_size() const { return m_capacity_and_size & k_size_mask; }
 
   std::size_t priv_capacity() const {
@@ -167,14 +190,15 @@ class compact_vector {
     m_capacity_and_size = (m_capacity_and_size & k_capacity_mask) | new_size;
   }
 
-  void priv_reserve(const std::size_t new_cap, data_allocator_type allocator) {
+  template <typename A>
+  void priv_reserve(const std::size_t new_cap, A allocator) {
     if (new_cap <= capacity()) {
       return;
     }
 
     // Move items to a new memory region
     const auto new_cap_power2 = metall::mtlldetail::next_power_of_2(new_cap);
-    auto       new_data = std::allocator_traits<data_allocator_type>::allocate(
+    auto       new_data = std::allocator_traits<A>::allocate(
         allocator, new_cap_power2);
     assert(new_data);
     for (std::size_t i = 0; i < this->size(); ++i) {
@@ -188,7 +212,8 @@ class compact_vector {
     // priv_update_size(old_size);
   }
 
-  void priv_resize(const std::size_t new_size, data_allocator_type allocator) {
+  template <typename A>
+  void priv_resize(const std::size_t new_size, A allocator) {
     if (new_size == size()) {
       return;  // Do nothing.
     } else if (new_size < size()) {
@@ -205,7 +230,8 @@ class compact_vector {
     priv_update_size(new_size);
   }
 
-  void priv_shrink_to_fit(data_allocator_type allocator) {
+  template <typename A>
+  void priv_shrink_to_fit(A allocator) {
     if (size() == capacity()) {
       return;  // Do nothing.
     }
@@ -220,7 +246,7 @@ class compact_vector {
     // Cannot shrink to the exact size because the capacity must be a power
     // of 2.
     const auto size_power2 = metall::mtlldetail::next_power_of_2(size());
-    auto       new_data = std::allocator_traits<data_allocator_type>::allocate(
+    auto       new_data = std::allocator_traits<A>::allocate(
         allocator, size_power2);
     assert(new_data);
     for (std::size_t i = 0; i < this->size(); ++i) {
@@ -233,40 +259,45 @@ class compact_vector {
     priv_update_capacity(size_power2);
   }
 
-  void priv_push_back(value_type &&value, data_allocator_type allocator) {
+  template <typename A>
+  void priv_push_back(value_type &&value, A allocator) {
     resize(size() + 1, allocator);
     new (metall::to_raw_pointer(&back())) value_type(std::move(value));
   }
 
-  void priv_clear(data_allocator_type allocator) {
+  template <typename A>
+  void priv_clear(A allocator) {
     priv_destroy_all_items(allocator);
     priv_update_size(0);
   }
 
-  void priv_destroy(data_allocator_type allocator) {
+  template <typename A>
+  void priv_destroy(A allocator) {
     priv_clear(allocator);
     priv_deallocate_data_array(allocator);
   }
 
-  void priv_destroy_all_items(data_allocator_type allocator) noexcept {
+  template <typename A>
+  void priv_destroy_all_items(A allocator) noexcept {
     for (std::size_t i = 0; i < size(); ++i) {
       priv_destroy_item_at(i, allocator);
     }
   }
 
-  void priv_destroy_item_at(const std::size_t   index,
-                            data_allocator_type allocator) noexcept {
-    std::allocator_traits<data_allocator_type>::destroy(
-        allocator, std::addressof(m_data[index]));
+  template <typename A>
+  void priv_destroy_item_at(const std::size_t index, A allocator) noexcept {
+    std::allocator_traits<A>::destroy(allocator,
+                                      std::addressof(m_data[index]));
   }
 
-  void priv_deallocate_data_array(data_allocator_type allocator) noexcept {
+  template <typename A>
+  void priv_deallocate_data_array(A allocator) noexcept {
     if (capacity() == 0) {
       assert(!m_data);
       return;
     }
 
-    std::allocator_traits<data_allocator_type>::deallocate(allocator, m_data,
+    std::allocator_traits<A>::deallocate(allocator, m_data,
                                                            capacity());
     m_data = nullptr;
     priv_update_capacity(0);
@@ -0,0 +1,221 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <metall/container/vector.hpp>
+
+#ifdef JSON_BENTO_USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace json_bento::jbdtl {
+
+/// \brief Append-only storage that packs strings into blocks of about
+/// k_block_size bytes and compresses each full block with zstd.
+/// A string is addressed by its location (block, offset, length).
+/// The last (open) block is kept uncompressed until it is full.
+/// A compressed block is decompressed on access into a small per-thread
+/// cache holding the last k_num_cached_blocks blocks;
+/// a view of a string is valid until this storage is modified or
+/// the calling thread has decompressed k_num_cached_blocks other blocks.
+/// Without JSON_BENTO_USE_ZSTD, blocks are stored uncompressed.
+/// \tparam Alloc Allocator type.
+template <typename Alloc = std::allocator<std::byte>>
+class compressed_string_blocks {
+ private:
+  template <typename T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  using byte_vector_type =
+      metall::container::vector<char, other_allocator<char>>;
+  using size_vector_type =
+      metall::container::vector<uint64_t, other_allocator<uint64_t>>;
+
+ public:
+  using allocator_type = Alloc;
+
+  /// \brief Approximate (uncompressed) size of a block.
+  static constexpr std::size_t k_block_size = 64 * 1024;
+
+  /// \brief Number of decompressed blocks cached per thread.
+  static constexpr std::size_t k_num_cached_blocks = 4;
+
+#ifdef JSON_BENTO_USE_ZSTD
+  static constexpr bool compressing = true;
+#else
+  static constexpr bool compressing = false;
+#endif
+
+  /// \brief Location of a string.
+  struct location {
+    uint32_t block{0};
+    uint32_t offset{0};
+    uint64_t length{0};
+  };
+
+  explicit compressed_string_blocks(const allocator_type &alloc)
+      : m_data(alloc),
+        m_block_ends(alloc),
+        m_raw_sizes(alloc),
+        m_tail(alloc),
+        m_stamp(priv_new_stamp()) {}
+
+  /// \brief Appends a string.
+  /// \return The location of the string.
+  location add(const char *const s, const std::size_t count) {
+    if (!m_tail.empty() && s >= m_tail.data() &&
+        s < m_tail.data() + m_tail.size()) {
+      // 's' is in the open block, which can be moved or sealed below.
+      const std::string copy(s, count);
+      return add(copy.data(), count);
+    }
+    if (!m_tail.empty() && m_tail.size() + count + 1 > k_block_size) {
+      priv_seal();
+    }
+    if (m_tail.capacity() < k_block_size) m_tail.reserve(k_block_size);
+
+    const location loc{uint32_t(num_blocks()), uint32_t(m_tail.size()),
+                       uint64_t(count)};
+    m_tail.insert(m_tail.end(), s, s + count);
+    m_tail.push_back('\0');
+    if (m_tail.size() >= k_block_size) priv_seal();
+    return loc;
+  }
+
+  /// \brief Returns a view of the string at 'loc'; the view is
+  /// null-terminated. See the class description for its lifetime.
+  std::string_view view(const location &loc) const {
+    if (loc.block == num_blocks()) {
+      return {m_tail.data() + loc.offset, loc.length};
+    }
+    return {priv_decompressed(loc.block) + loc.offset, loc.length};
+  }
+
+  /// \brief Removes all strings and frees the blocks.
+  void clear() {
+    m_data.clear();
+    m_data.shrink_to_fit();
+    m_block_ends.clear();
+    m_raw_sizes.clear();
+    m_tail.clear();
+    m_stamp = priv_new_stamp();
+  }
+
+  /// \brief Returns the number of full (compressed) blocks.
+  std::size_t num_blocks() const { return m_block_ends.size(); }
+
+  /// \brief Returns the size of the stored data in bytes,
+  /// i.e., of the compressed blocks plus the open block.
+  std::size_t stored_size() const { return m_data.size() + m_tail.size(); }
+
+  /// \brief Returns the uncompressed size of the stored data in bytes.
+  std::size_t raw_size() const {
+    std::size_t total = m_tail.size();
+    for (const auto n : m_raw_sizes) total += n;
+    return total;
+  }
+
+ private:
+  struct cached_block {
+    const void       *owner{nullptr};
+    uint64_t          stamp{0};
+    std::size_t       block{0};
+    std::vector<char> data;
+  };
+
+  struct block_cache {
+    std::array<cached_block, k_num_cached_blocks> entries;
+    std::size_t                                   next{0};
+  };
+
+  static uint64_t priv_new_stamp() {
+    std::random_device rd;
+    return (uint64_t(rd()) << 32) ^ uint64_t(rd());
+  }
+
+  static block_cache &priv_cache() {
+    thread_local block_cache cache;
+    return cache;
+  }
+
+  std::size_t priv_block_begin(const std::size_t block) const {
+    return (block == 0) ? 0 : m_block_ends[block - 1];
+  }
+
+  /// \brief Compresses the open block.
+  void priv_seal() {
+    assert(!m_tail.empty());
+#ifdef JSON_BENTO_USE_ZSTD
+    const std::size_t first = m_data.size();
+    const std::size_t bound = ZSTD_compressBound(m_tail.size());
+    m_data.resize(first + bound);
+    const std::size_t n = ZSTD_compress(&m_data[first], bound, m_tail.data(),
+                                        m_tail.size(), k_compression_level);
+    if (ZSTD_isError(n)) {
+      m_data.resize(first);
+      throw std::runtime_error(std::string("zstd: ") + ZSTD_getErrorName(n));
+    }
+    m_data.resize(first + n);
+#else
+    m_data.insert(m_data.end(), m_tail.begin(), m_tail.end());
+#endif
+    m_block_ends.push_back(m_data.size());
+    m_raw_sizes.push_back(m_tail.size());
+    m_tail.clear();
+  }
+
+  /// \brief Returns the decompressed data of a full block.
+  const char *priv_decompressed(const std::size_t block) const {
+    const std::size_t first = priv_block_begin(block);
+#ifndef JSON_BENTO_USE_ZSTD
+    return &m_data[first];
+#else
+    auto &cache = priv_cache();
+    for (const auto &entry : cache.entries) {
+      if (entry.owner == this && entry.stamp == m_stamp &&
+          entry.block == block) {
+        return entry.data.data();
+      }
+    }
+
+    auto &entry = cache.entries[cache.next];
+    cache.next  = (cache.next + 1) % k_num_cached_blocks;
+    entry.owner = nullptr;
+    entry.data.resize(m_raw_sizes[block]);
+    const std::size_t n =
+        ZSTD_decompress(entry.data.data(), entry.data.size(), &m_data[first],
+                        m_block_ends[block] - first);
+    if (ZSTD_isError(n) || n != entry.data.size()) {
+      throw std::runtime_error("zstd: corrupted string block");
+    }
+    entry.owner = this;
+    entry.stamp = m_stamp;
+    entry.block = block;
+    return entry.data.data();
+#endif
+  }
+
+  static constexpr int k_compression_level = 3;
+
+  byte_vector_type m_data;        // Compressed blocks, back to back
+  size_vector_type m_block_ends;  // End offset of each block in m_data
+  size_vector_type m_raw_sizes;   // Uncompressed size of each block
+  byte_vector_type m_tail;        // The open block
+  // Identifies the data in the per-thread cache; renewed by clear()
+  uint64_t m_stamp;
+};
+
+}  // namespace json_bento::jbdtl
@@ -9,8 +9,7 @@
 #include <memory>
 #include <scoped_allocator>
 
-#include <metall/container/set.hpp>
-
+#include <json_bento/details/free_slot_policy.hpp>
 #include <json_bento/details/vector.hpp>
 
 namespace json_bento::jbdtl {
@@ -21,16 +20,16 @@ namespace json_bento::jbdtl {
 /// later element insertion.
 /// \tparam T Type of the value to insert.
 /// \tparam Alloc Allocator type.
-template <typename T, typename Alloc = std::allocator<T>>
+/// \tparam FreeSlots Free slot list type,
+/// e.g., ordered_free_slots or stack_free_slots.
+template <typename T, typename Alloc = std::allocator<T>,
+          template <typename> class FreeSlots = ordered_free_slots>
 class data_storage {
  private:
   using storage_alloc_type = std::scoped_allocator_adaptor<
       typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
-  using storage_type = vector<T, storage_alloc_type>;
-  using free_slot_storage_type =
-      metall::container::set<std::size_t, std::less<std::size_t>,
-                             typename std::allocator_traits<
-                                 Alloc>::template rebind_alloc<std::size_t>>;
+  using storage_type           = vector<T, storage_alloc_type>;
+  using free_slot_storage_type = FreeSlots<Alloc>;
   using void_pointer = typename std::allocator_traits<Alloc>::void_pointer;
   using const_void_pointer =
       typename std::allocator_traits<Alloc>::const_void_pointer;
@@ -85,10 +84,9 @@ class data_storage {
     }
 
     // Reuse previously cleared slot.
-    const auto empty_slot_pos = *(m_free_slots.begin());
+    const auto empty_slot_pos = m_free_slots.pop();
     new (&(m_storage.at(empty_slot_pos)))
         value_type(std::forward<Args>(args)...);
-    m_free_slots.erase(m_free_slots.begin());
     return empty_slot_pos;
   }
 
@@ -98,9 +96,13 @@ class data_storage {
 
   std::size_t capacity() const { return m_storage.size(); }
 
+  /// \brief Returns the number of slots of erased elements,
+  /// which are reused by later insertions.
+  std::size_t num_free_slots() const { return m_free_slots.size(); }
+
   void erase(const std::size_t id) {
     m_storage.at(id).~value_type();
-    m_free_slots.insert(id);
+    m_free_slots.push(id);
   }
 
   void clear() {
@@ -129,9 +131,9 @@ class data_storage {
   free_slot_storage_type m_free_slots{};
 };
 
-template <typename T, typename Alloc>
+template <typename T, typename Alloc, template <typename> class FreeSlots>
 template <bool is_const>
-class data_storage<T, Alloc>::basic_iterator {
+class data_storage<T, Alloc, FreeSlots>::basic_iterator {
  public:
   using value_type = T;
   using pointer =
@@ -182,7 +184,8 @@ class data_storage<T, Alloc>::basic_iterator {
   }
 
   void priv_move_to_first_valid_pos() {
-    while (m_index < m_storage->size() && m_free_slot_storage->count(m_index)) {
+    while (m_index < m_storage->size() &&
+           m_free_slot_storage->contains(m_index)) {
       ++m_index;
     }
   }
@@ -192,7 +195,8 @@ class data_storage<T, Alloc>::basic_iterator {
       return;
     }
     ++m_index;
-    while (m_index < m_storage->size() && m_free_slot_storage->count(m_index)) {
+    while (m_index < m_storage->size() &&
+           m_free_slot_storage->contains(m_index)) {
       ++m_index;
     }
   }
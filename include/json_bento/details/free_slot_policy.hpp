@@ -0,0 +1,117 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+
+#include <metall/container/set.hpp>
+#include <metall/container/vector.hpp>
+
+#include <json_bento/details/bit_operation.hpp>
+
+namespace json_bento::jbdtl {
+
+/// \brief Free slot list of data_storage, implemented with an ordered set.
+/// The smallest free slot is reused first.
+/// Each insertion allocates a tree node.
+/// \tparam Alloc Allocator type.
+template <typename Alloc>
+class ordered_free_slots {
+ private:
+  using set_type =
+      metall::container::set<std::size_t, std::less<std::size_t>,
+                             typename std::allocator_traits<
+                                 Alloc>::template rebind_alloc<std::size_t>>;
+
+ public:
+  ordered_free_slots() = default;
+
+  explicit ordered_free_slots(const Alloc &alloc) : m_set(alloc) {}
+
+  bool empty() const { return m_set.empty(); }
+
+  std::size_t size() const { return m_set.size(); }
+
+  /// \brief Returns true if 'slot' is free.
+  bool contains(const std::size_t slot) const { return m_set.count(slot); }
+
+  /// \brief Marks 'slot' as free.
+  void push(const std::size_t slot) { m_set.insert(slot); }
+
+  /// \brief Takes one free slot out of this list.
+  std::size_t pop() {
+    assert(!empty());
+    const auto slot = *(m_set.begin());
+    m_set.erase(m_set.begin());
+    return slot;
+  }
+
+  void clear() { m_set.clear(); }
+
+ private:
+  set_type m_set;
+};
+
+/// \brief Free slot list of data_storage, implemented with a stack and
+/// a bitmap. The most recently freed slot is reused first.
+/// No memory is allocated per insertion, except when the stack or the bitmap
+/// grows.
+/// \tparam Alloc Allocator type.
+template <typename Alloc>
+class stack_free_slots {
+ private:
+  template <typename T>
+  using vector_type = metall::container::vector<
+      T, typename std::allocator_traits<Alloc>::template rebind_alloc<T>>;
+
+ public:
+  stack_free_slots() = default;
+
+  explicit stack_free_slots(const Alloc &alloc)
+      : m_stack(alloc), m_bitmap(alloc) {}
+
+  bool empty() const { return m_stack.empty(); }
+
+  std::size_t size() const { return m_stack.size(); }
+
+  /// \brief Returns true if 'slot' is free.
+  bool contains(const std::size_t slot) const {
+    if (slot / 64 >= m_bitmap.size()) return false;
+    return bitmap_test(m_bitmap, slot);
+  }
+
+  /// \brief Marks 'slot' as free.
+  void push(const std::size_t slot) {
+    assert(!contains(slot));
+    if (num_bitmap_words(slot + 1) > m_bitmap.size()) {
+      m_bitmap.resize(num_bitmap_words(slot + 1), 0);
+    }
+    bitmap_set(m_bitmap, slot);
+    m_stack.push_back(slot);
+  }
+
+  /// \brief Takes one free slot out of this list.
+  std::size_t pop() {
+    assert(!empty());
+    const auto slot = m_stack.back();
+    m_stack.pop_back();
+    bitmap_reset(m_bitmap, slot);
+    return slot;
+  }
+
+  void clear() {
+    m_stack.clear();
+    m_bitmap.clear();
+  }
+
+ private:
+  vector_type<std::size_t> m_stack;
+  vector_type<uint64_t>    m_bitmap;
+};
+
+}  // namespace json_bento::jbdtl
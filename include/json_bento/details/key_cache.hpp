@@ -0,0 +1,164 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include <json_bento/box/core_data/key_locator.hpp>
+
+namespace json_bento::jbdtl {
+
+/// \brief Volatile (DRAM) cache of the key lookups of a key_store.
+/// Caches found and missing keys; when a key is added to the store,
+/// the store updates its entry.
+class key_cache {
+ private:
+  struct string_hash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const noexcept {
+      return std::hash<std::string_view>{}(s);
+    }
+  };
+
+  using map_type = std::unordered_map<std::string, key_locator, string_hash,
+                                      std::equal_to<>>;
+
+ public:
+  /// \brief Returns the cached locator of 'key', or std::nullopt if the
+  /// lookup has not been cached. The locator is 'absent' if the key was not
+  /// in the store.
+  std::optional<key_locator> find(std::string_view key) const {
+    std::shared_lock lock(m_mutex);
+    const auto       itr = m_map.find(key);
+    if (itr == m_map.end()) {
+      return std::nullopt;
+    }
+    return itr->second;
+  }
+
+  /// \brief Caches the locator of 'key'.
+  void add(std::string_view key, const key_locator loc) {
+    std::unique_lock lock(m_mutex);
+    m_map.insert_or_assign(std::string(key), loc);
+  }
+
+  void clear() {
+    std::unique_lock lock(m_mutex);
+    m_map.clear();
+  }
+
+  std::size_t size() const {
+    std::shared_lock lock(m_mutex);
+    return m_map.size();
+  }
+
+ private:
+  mutable std::shared_mutex m_mutex;
+  map_type                  m_map;
+};
+
+/// \brief Process-local registry of the key caches attached to key stores.
+/// A key store lives in persistent memory and cannot hold a pointer to DRAM;
+/// its cache is therefore looked up by the store's address. The owner of an
+/// opened store attaches the cache and detaches it before the store is closed.
+/// Attaching is reference counted.
+class key_cache_registry {
+ private:
+  static constexpr std::size_t k_max_num_caches = 64;
+
+  struct entry {
+    std::atomic<const void *> store{nullptr};
+    std::atomic<key_cache *>  cache{nullptr};
+    std::size_t               num_attached{0};
+  };
+
+  struct registry {
+    std::array<entry, k_max_num_caches> entries;
+    std::atomic<std::size_t>            size{0};  // Entries in use are < size
+    std::mutex                          mutex;
+  };
+
+ public:
+  /// \brief Returns the cache attached to 'store', or nullptr.
+  static key_cache *find(const void *const store) noexcept {
+    auto      &reg  = priv_registry();
+    const auto size = reg.size.load(std::memory_order_acquire);
+    for (std::size_t i = 0; i < size; ++i) {
+      if (reg.entries[i].store.load(std::memory_order_acquire) == store) {
+        return reg.entries[i].cache.load(std::memory_order_acquire);
+      }
+    }
+    return nullptr;
+  }
+
+  /// \brief Attaches a cache to 'store'.
+  /// \return The cache of 'store', or nullptr if too many caches are attached.
+  static key_cache *attach(const void *const store) {
+    auto           &reg        = priv_registry();
+    std::lock_guard lock(reg.mutex);
+    const auto      size       = reg.size.load(std::memory_order_relaxed);
+    entry          *free_entry = nullptr;
+    for (std::size_t i = 0; i < size; ++i) {
+      auto &item = reg.entries[i];
+      if (item.store.load(std::memory_order_relaxed) == store) {
+        ++item.num_attached;
+        return item.cache.load(std::memory_order_relaxed);
+      }
+      if (!free_entry && !item.store.load(std::memory_order_relaxed)) {
+        free_entry = &item;
+      }
+    }
+
+    if (!free_entry) {
+      if (size == k_max_num_caches) {
+        return nullptr;
+      }
+      free_entry = &reg.entries[size];
+      reg.size.store(size + 1, std::memory_order_release);
+    }
+
+    auto *const cache        = new key_cache;
+    free_entry->num_attached = 1;
+    free_entry->cache.store(cache, std::memory_order_release);
+    free_entry->store.store(store, std::memory_order_release);
+    return cache;
+  }
+
+  /// \brief Detaches a cache from 'store';
+  /// the cache is destroyed when it is no longer attached.
+  static void detach(const void *const store) {
+    auto           &reg = priv_registry();
+    std::lock_guard lock(reg.mutex);
+    const auto      size = reg.size.load(std::memory_order_relaxed);
+    for (std::size_t i = 0; i < size; ++i) {
+      auto &item = reg.entries[i];
+      if (item.store.load(std::memory_order_relaxed) != store) continue;
+      if (--item.num_attached > 0) return;
+
+      item.store.store(nullptr, std::memory_order_release);
+      delete item.cache.exchange(nullptr, std::memory_order_acq_rel);
+      return;
+    }
+  }
+
+ private:
+  static registry &priv_registry() {
+    static registry reg;
+    return reg;
+  }
+};
+
+}  // namespace json_bento::jbdtl
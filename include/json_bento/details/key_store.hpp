@@ -5,6 +5,8 @@
 
 #pragma once
 
+#include <cassert>
+#include <limits>
 #include <memory>
 #include <scoped_allocator>
 #include <string_view>
@@ -12,13 +14,25 @@
 
 #include <metall/container/string.hpp>
 #include <metall/container/unordered_map.hpp>
+#include <metall/container/vector.hpp>
 #include <metall/utility/hash.hpp>
 
 #include <json_bento/box/core_data/key_locator.hpp>
+#include <json_bento/details/key_cache.hpp>
 #include <json_bento/details/compact_string.hpp>
 
 namespace json_bento::jbdtl {
 
+/// \brief Stores the keys of a box and assigns them stable IDs (locators).
+/// \details An ID is the hash of the key, incremented until it is unused.
+/// The keys are held in a flat open-addressing table: the slot of an ID is
+/// the ID modulo the (power of two) table size; collisions probe linearly.
+/// Keys that fit into a compact_string's inline buffer need no allocation,
+/// so a lookup usually touches a single contiguous slot.
+/// Stores created with the former node-based map are migrated into the table
+/// by the first find_or_add().
+/// An opened store can attach a volatile key_cache (see attach_cache()),
+/// which answers repeated lookups of the same keys from DRAM.
 template <typename Alloc = std::allocator<std::byte>>
 class key_store {
  public:
@@ -49,14 +63,26 @@ class key_store {
   static constexpr id_type k_max_internal_id =
       std::numeric_limits<id_type>::max();
 
+  /// An entry of the flat table; an empty slot has id k_max_internal_id.
+  struct slot {
+    id_type     id{k_max_internal_id};
+    string_type key;
+  };
+
+  using slot_vector_type =
+      metall::container::vector<slot, other_allocator<slot>>;
+
+  static constexpr std::size_t k_min_num_slots = 16;
+
  public:
   key_store(){};
 
-  explicit key_store(allocator_type allocator) : m_map(allocator) {}
+  explicit key_store(allocator_type allocator)
+      : m_map(allocator), m_slots(allocator) {}
 
   explicit key_store(const uint64_t        hash_seed,
                      const allocator_type &allocator = allocator_type())
-      : m_hash_seed(hash_seed), m_map(allocator) {}
+      : m_hash_seed(hash_seed), m_map(allocator), m_slots(allocator) {}
 
   // Delete all for now.
   // When implement them, make sure to copy compact_string explicitly.
@@ -68,55 +94,104 @@ class key_store {
   ~key_store() { clear(); }
 
   key_locator find_or_add(const key_type &key) {
-    const auto id = priv_find_or_generate_internal_id(key);
+    if (!m_map.empty()) priv_migrate();
+
+    auto *const cache = key_cache_registry::find(this);
+    auto        id    = priv_find_internal_id(key, cache);
+    if (id != k_max_internal_id) {
+      return id;
+    }
+
+    id = priv_generate_internal_id(key);
     assert(id != k_max_internal_id);
-    m_map.emplace(
-        std::piecewise_construct, std::forward_as_tuple(id),
-        std::forward_as_tuple(key.data(), key.length(), get_allocator()));
+    priv_insert(id, key);
+    if (cache) cache->add(key, id);
     return id;
   }
 
   key_locator find(const key_type &key) const {
-    const auto locator_type = priv_find_internal_id(key);
+    const auto locator_type =
+        priv_find_internal_id(key, key_cache_registry::find(this));
     return locator_type;
   }
 
+  /// \brief Returns true if 'key' is in the store.
+  bool contains(const key_type &key) const {
+    return find(key) != k_max_internal_id;
+  }
+
   key_type find(const key_locator &locator_type) const {
     static_assert(std::is_same_v<key_type, typename string_type::view_type>,
                   "Cannot convert");
-    assert(m_map.count(locator_type) == 1);
-    return m_map.at(locator_type).str_view();
+    if (!m_map.empty()) {
+      assert(m_map.count(locator_type) == 1);
+      return m_map.at(locator_type).str_view();
+    }
+
+    const auto pos = priv_find_slot(locator_type);
+    assert(pos != m_slots.size());
+    return m_slots[pos].key.str_view();
   }
 
   void clear() {
     for (auto &item : m_map) {
       item.second.clear(m_map.get_allocator());
     }
+    for (auto &item : m_slots) {
+      item.key.clear(m_slots.get_allocator());
+    }
+    if (auto *const cache = key_cache_registry::find(this)) cache->clear();
+  }
+
+  /// \brief Attaches a volatile cache of key lookups to this store.
+  /// The cache must be detached before the store is closed
+  /// (e.g., the Metall datastore is unmapped); attach and detach calls pair.
+  /// Clearing or destroying the store empties the cache, thus a store that
+  /// is rebuilt at the same address keeps an attached, consistent cache.
+  /// \param prewarm If true, caches all keys of the store.
+  /// \return False if no cache could be attached.
+  bool attach_cache(const bool prewarm = false) const {
+    auto *const cache = key_cache_registry::attach(this);
+    if (!cache) return false;
+
+    if (prewarm) {
+      for (const auto &item : m_map) {
+        cache->add(item.second.str_view(), item.first);
+      }
+      for (const auto &item : m_slots) {
+        if (item.id != k_max_internal_id) {
+          cache->add(item.key.str_view(), item.id);
+        }
+      }
+    }
+    return true;
   }
 
-  std::size_t size() const { return m_map.size(); }
+  /// \brief Detaches the cache attached by attach_cache().
+  void detach_cache() const { key_cache_registry::detach(this); }
 
-  allocator_type get_allocator() const { return m_map.get_allocator(); }
+  std::size_t size() const { return m_map.size() + m_num_keys; }
 
- private:
-  /// \brief Finds the internal ID that corresponds to 'key'.
-  /// If this container does not have an element with 'key',
-  /// Generate a new internal ID.
-  id_type priv_find_or_generate_internal_id(const key_type &key) {
-    auto internal_id = priv_find_internal_id(key);
-    if (internal_id == k_max_internal_id) {  // Couldn't find
-      // Generate a new one.
-      internal_id = priv_generate_internal_id(key);
+  /// \brief Returns the number of bytes used by the keys:
+  /// the table slots and the keys that are not stored inline.
+  std::size_t memory_size() const {
+    std::size_t total = m_slots.capacity() * sizeof(slot);
+    for (const auto &item : m_slots) total += item.key.allocated_size();
+    for (const auto &item : m_map) {
+      total += sizeof(item) + item.second.allocated_size();
     }
-    return internal_id;
+    return total;
   }
 
+  allocator_type get_allocator() const { return m_slots.get_allocator(); }
+
+ private:
   /// \brief Generates a new internal ID for 'key'.
   id_type priv_generate_internal_id(const key_type &key) {
     auto internal_id = priv_hash_key(key, m_hash_seed);
 
     std::size_t distance = 0;
-    while (m_map.count(internal_id) > 0) {
+    while (priv_find_slot(internal_id) != m_slots.size()) {
       internal_id = priv_increment_internal_id(internal_id);
       ++distance;
     }
@@ -128,7 +203,50 @@ class key_store {
   /// \brief Finds the internal ID that corresponds with 'key'.
   /// If this container does not have an element with 'key',
   /// returns k_max_internal_id.
+  /// Looks up and fills 'cache' first, if it is not nullptr.
+  id_type priv_find_internal_id(const key_type &key,
+                                key_cache *const cache) const {
+    if (cache) {
+      if (const auto cached = cache->find(key)) {
+        return *cached;
+      }
+      const auto internal_id = priv_find_internal_id(key);
+      cache->add(key, internal_id);
+      return internal_id;
+    }
+    return priv_find_internal_id(key);
+  }
+
+  /// \brief Finds the internal ID that corresponds with 'key' in the store.
   id_type priv_find_internal_id(const key_type &key) const {
+    if (!m_map.empty()) {
+      return priv_find_internal_id_in_map(key);
+    }
+
+    if (m_slots.empty()) {
+      return k_max_internal_id;
+    }
+
+    // The IDs hash, hash + 1, ... occupy consecutive home slots and the slots
+    // between an ID's home and its actual slot are occupied. Thus, an ID of
+    // 'key' is in the run of occupied slots that starts at the hash's home.
+    const auto hash = priv_hash_key(key, m_hash_seed);
+    const auto mask = m_slots.size() - 1;
+    for (auto pos = hash & mask; m_slots[pos].id != k_max_internal_id;
+         pos      = (pos + 1) & mask) {
+      const auto &item = m_slots[pos];
+      if (priv_id_distance(hash, item.id) <= m_max_id_probe_distance &&
+          item.key.str_view() == key) {
+        return item.id;
+      }
+    }
+
+    return k_max_internal_id;  // Couldn't find
+  }
+
+  /// \brief Finds the internal ID of 'key' in the node-based map of stores
+  /// that have not been migrated yet.
+  id_type priv_find_internal_id_in_map(const key_type &key) const {
     auto internal_id = priv_hash_key(key, m_hash_seed);
 
     for (std::size_t d = 0; d <= m_max_id_probe_distance; ++d) {
@@ -146,6 +264,83 @@ class key_store {
     return k_max_internal_id;  // Couldn't find
   }
 
+  /// \brief Returns the position of the slot that holds 'id',
+  /// or m_slots.size() if there is none.
+  std::size_t priv_find_slot(const id_type id) const {
+    if (m_slots.empty()) {
+      return m_slots.size();
+    }
+
+    const auto mask = m_slots.size() - 1;
+    for (auto pos = id & mask; m_slots[pos].id != k_max_internal_id;
+         pos      = (pos + 1) & mask) {
+      if (m_slots[pos].id == id) {
+        return pos;
+      }
+    }
+
+    return m_slots.size();
+  }
+
+  /// \brief Adds the (unused) 'id' with 'key' to the table.
+  void priv_insert(const id_type id, const key_type &key) {
+    priv_reserve(m_num_keys + 1);
+    auto &item = m_slots[priv_free_slot(id)];
+    item.id    = id;
+    item.key   = string_type(key.data(), key.length(), get_allocator());
+    ++m_num_keys;
+  }
+
+  /// \brief Returns the first free slot at or after the home slot of 'id'.
+  std::size_t priv_free_slot(const id_type id) const {
+    const auto mask = m_slots.size() - 1;
+    auto       pos  = id & mask;
+    while (m_slots[pos].id != k_max_internal_id) {
+      pos = (pos + 1) & mask;
+    }
+    return pos;
+  }
+
+  /// \brief Grows the table, if needed, such that it holds 'num_keys' keys
+  /// with a load factor of at most 0.75.
+  void priv_reserve(const std::size_t num_keys) {
+    if (num_keys * 4 <= m_slots.size() * 3) {
+      return;
+    }
+
+    std::size_t num_slots = std::max(m_slots.size(), k_min_num_slots);
+    while (num_keys * 4 > num_slots * 3) {
+      num_slots *= 2;
+    }
+
+    slot_vector_type old_slots(get_allocator());
+    old_slots.swap(m_slots);
+    m_slots.resize(num_slots);
+    for (auto &item : old_slots) {
+      if (item.id == k_max_internal_id) continue;
+      auto &dst = m_slots[priv_free_slot(item.id)];
+      dst.id    = item.id;
+      dst.key   = std::move(item.key);
+    }
+  }
+
+  /// \brief Moves the keys of the node-based map into the flat table.
+  void priv_migrate() {
+    priv_reserve(m_num_keys + m_map.size());
+    for (auto &item : m_map) {
+      auto &dst = m_slots[priv_free_slot(item.first)];
+      dst.id    = item.first;
+      dst.key   = std::move(item.second);
+      ++m_num_keys;
+    }
+    m_map.clear();
+  }
+
+  /// \brief Returns how often 'from' was incremented to reach 'to'.
+  static id_type priv_id_distance(const id_type from, const id_type to) {
+    return (to >= from) ? to - from : to + (k_max_internal_id - from);
+  }
+
   static id_type priv_hash_key(const key_type                 &key,
                                [[maybe_unused]] const uint64_t seed) {
     auto hash = (id_type)metall::mtlldetail::MurmurHash64A(
@@ -163,9 +358,11 @@ class key_store {
     return new_id;
   }
 
-  uint64_t    m_hash_seed{123};
-  std::size_t m_max_id_probe_distance{0};
-  map_type    m_map;
+  uint64_t         m_hash_seed{123};
+  std::size_t      m_max_id_probe_distance{0};
+  map_type         m_map;  // Keys of stores that are not migrated yet
+  slot_vector_type m_slots;
+  std::size_t      m_num_keys{0};
 };
 
 }  // namespace json_bento::jbdtl
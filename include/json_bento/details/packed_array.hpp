@@ -0,0 +1,271 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <json_bento/box/core_data/value_locator.hpp>
+
+namespace json_bento::jbdtl::packed_array {
+
+/// \brief Encodings of an array whose elements are all int64, all uint64,
+/// or all double values.
+/// Raw encodings store the 8-byte values back to back.
+/// Delta encodings split the elements into blocks of k_block_size;
+/// a block starts with its first value, followed by the differences of
+/// consecutive values as zigzag varints, so that sorted or small integers
+/// (IDs, timestamps) take one or two bytes each.
+/// The byte offset of each block is kept for random access.
+enum class encoding : uint8_t {
+  raw_int64 = 1,
+  raw_uint64,
+  raw_double,
+  delta_int64,
+  delta_uint64
+};
+
+/// \brief Number of elements of a block of a delta encoding.
+static constexpr std::size_t k_block_size = 32;
+
+namespace detail {
+
+inline uint64_t zigzag(const uint64_t u) {
+  return (u << 1) ^ uint64_t(-(int64_t(u) < 0 ? 1 : 0));
+}
+
+inline uint64_t unzigzag(const uint64_t z) {
+  return (z >> 1) ^ uint64_t(-int64_t(z & 1));
+}
+
+inline void put_varint(uint64_t u, std::vector<uint8_t> &out) {
+  while (u >= 0x80) {
+    out.push_back(uint8_t(u | 0x80));
+    u >>= 7;
+  }
+  out.push_back(uint8_t(u));
+}
+
+inline uint64_t get_varint(const uint8_t *&p) {
+  uint64_t u     = 0;
+  int      shift = 0;
+  while (*p & 0x80) {
+    u |= uint64_t(*p++ & 0x7f) << shift;
+    shift += 7;
+  }
+  u |= uint64_t(*p++) << shift;
+  return u;
+}
+
+inline void put_u32(const uint32_t u, uint8_t *const p) {
+  std::memcpy(p, &u, sizeof(u));
+}
+
+inline uint32_t get_u32(const uint8_t *const p) {
+  uint32_t u;
+  std::memcpy(&u, p, sizeof(u));
+  return u;
+}
+
+inline uint64_t get_u64(const uint8_t *const p) {
+  uint64_t u;
+  std::memcpy(&u, p, sizeof(u));
+  return u;
+}
+
+/// \brief Returns the bits of a numeric value.
+inline uint64_t bits_of(const value_locator &loc) {
+  uint64_t u = 0;
+  if (loc.is_int64()) {
+    const int64_t i = loc.as_int64();
+    std::memcpy(&u, &i, sizeof(u));
+  } else if (loc.is_uint64()) {
+    u = loc.as_uint64();
+  } else {
+    const double d = loc.as_double();
+    std::memcpy(&u, &d, sizeof(u));
+  }
+  return u;
+}
+
+inline void set_bits(const encoding enc, const uint64_t u,
+                     value_locator &loc) {
+  if (enc == encoding::raw_int64 || enc == encoding::delta_int64) {
+    int64_t i;
+    std::memcpy(&i, &u, sizeof(i));
+    loc.emplace_int64() = i;
+  } else if (enc == encoding::raw_uint64 || enc == encoding::delta_uint64) {
+    loc.emplace_uint64() = u;
+  } else {
+    double d;
+    std::memcpy(&d, &u, sizeof(d));
+    loc.emplace_double() = d;
+  }
+}
+
+struct header {
+  encoding       enc;
+  std::size_t    size;
+  const uint8_t *offsets;  // Block offsets; delta encodings only
+  const uint8_t *payload;
+};
+
+inline header read_header(const uint8_t *p) {
+  header h{};
+  h.enc  = encoding(*p++);
+  h.size = std::size_t(get_varint(p));
+  if (h.enc == encoding::delta_int64 || h.enc == encoding::delta_uint64) {
+    h.offsets = p;
+    p += sizeof(uint32_t) * ((h.size + k_block_size - 1) / k_block_size);
+  }
+  h.payload = p;
+  return h;
+}
+
+}  // namespace detail
+
+/// \brief Encodes an array of value locators.
+/// \param first First element.
+/// \param last End of the elements.
+/// \param out Receives the encoded bytes.
+/// \return False if the elements are not all int64, all uint64,
+/// or all double values, or if an integer is stored out of line;
+/// 'out' is left empty then.
+template <typename iterator_type>
+inline bool encode(iterator_type first, iterator_type last,
+                   std::vector<uint8_t> &out) {
+  out.clear();
+  if (first == last) return false;
+
+  encoding enc;
+  if (first->is_int64()) {
+    enc = encoding::raw_int64;
+  } else if (first->is_uint64()) {
+    enc = encoding::raw_uint64;
+  } else if (first->is_double()) {
+    enc = encoding::raw_double;
+  } else {
+    return false;
+  }
+
+  std::vector<uint64_t> values;
+  for (auto itr = first; itr != last; ++itr) {
+    if ((enc == encoding::raw_int64 && !itr->is_int64()) ||
+        (enc == encoding::raw_uint64 && !itr->is_uint64()) ||
+        (enc == encoding::raw_double && !itr->is_double()) ||
+        itr->is_out_of_line()) {
+      return false;
+    }
+    values.push_back(detail::bits_of(*itr));
+  }
+
+  std::vector<uint8_t> payload;
+  std::vector<uint8_t> offsets;
+  if (enc != encoding::raw_double) {
+    for (std::size_t i = 0; i < values.size(); ++i) {
+      if (i % k_block_size == 0) {
+        offsets.resize(offsets.size() + sizeof(uint32_t));
+        detail::put_u32(uint32_t(payload.size()),
+                        &offsets[offsets.size() - sizeof(uint32_t)]);
+        detail::put_varint(detail::zigzag(values[i]), payload);
+      } else {
+        detail::put_varint(detail::zigzag(values[i] - values[i - 1]),
+                           payload);
+      }
+    }
+  }
+
+  const bool delta = !payload.empty() &&
+                     offsets.size() + payload.size() < values.size() * 8;
+  if (delta) {
+    enc = (enc == encoding::raw_int64) ? encoding::delta_int64
+                                       : encoding::delta_uint64;
+  }
+
+  out.push_back(uint8_t(enc));
+  detail::put_varint(values.size(), out);
+  if (delta) {
+    out.insert(out.end(), offsets.begin(), offsets.end());
+    out.insert(out.end(), payload.begin(), payload.end());
+  } else {
+    const std::size_t pos = out.size();
+    out.resize(pos + values.size() * 8);
+    std::memcpy(&out[pos], values.data(), values.size() * 8);
+  }
+  return true;
+}
+
+/// \brief Returns the number of elements of an encoded array.
+inline std::size_t size(const uint8_t *const data) {
+  return detail::read_header(data).size;
+}
+
+/// \brief Decodes the element at 'pos' of an encoded array.
+inline void decode(const uint8_t *const data, const std::size_t pos,
+                   value_locator &out) {
+  const auto h = detail::read_header(data);
+  assert(pos < h.size);
+  if (h.enc == encoding::delta_int64 || h.enc == encoding::delta_uint64) {
+    const std::size_t block = pos / k_block_size;
+    const uint8_t    *p =
+        h.payload + detail::get_u32(h.offsets + block * sizeof(uint32_t));
+    uint64_t u = detail::unzigzag(detail::get_varint(p));
+    for (std::size_t i = block * k_block_size; i < pos; ++i) {
+      u += detail::unzigzag(detail::get_varint(p));
+    }
+    detail::set_bits(h.enc, u, out);
+    return;
+  }
+  detail::set_bits(h.enc, detail::get_u64(h.payload + pos * 8), out);
+}
+
+/// \brief Decodes all elements of an encoded array.
+inline void decode_all(const uint8_t *const        data,
+                       std::vector<value_locator> &out) {
+  const auto h = detail::read_header(data);
+  out.resize(h.size);
+  if (h.enc == encoding::delta_int64 || h.enc == encoding::delta_uint64) {
+    const uint8_t *p = h.payload;
+    uint64_t       u = 0;
+    for (std::size_t i = 0; i < h.size; ++i) {
+      const uint64_t z = detail::unzigzag(detail::get_varint(p));
+      u                = (i % k_block_size == 0) ? z : u + z;
+      detail::set_bits(h.enc, u, out[i]);
+    }
+    return;
+  }
+  for (std::size_t i = 0; i < h.size; ++i) {
+    detail::set_bits(h.enc, detail::get_u64(h.payload + i * 8), out[i]);
+  }
+}
+
+/// \brief Decodes all elements of an encoded array as doubles.
+/// \param out Receives size(data) values.
+inline void decode_doubles(const uint8_t *const data, double *const out) {
+  const auto h = detail::read_header(data);
+  if (h.enc == encoding::raw_double) {
+    std::memcpy(out, h.payload, h.size * sizeof(double));
+    return;
+  }
+  if (h.enc == encoding::raw_int64 || h.enc == encoding::raw_uint64) {
+    for (std::size_t i = 0; i < h.size; ++i) {
+      const uint64_t u = detail::get_u64(h.payload + i * 8);
+      out[i] = (h.enc == encoding::raw_int64) ? double(int64_t(u)) : double(u);
+    }
+    return;
+  }
+  const uint8_t *p = h.payload;
+  uint64_t       u = 0;
+  for (std::size_t i = 0; i < h.size; ++i) {
+    const uint64_t z = detail::unzigzag(detail::get_varint(p));
+    u                = (i % k_block_size == 0) ? z : u + z;
+    out[i] = (h.enc == encoding::delta_int64) ? double(int64_t(u)) : double(u);
+  }
+}
+
+}  // namespace json_bento::jbdtl::packed_array
@@ -0,0 +1,210 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <scoped_allocator>
+#include <type_traits>
+
+#include <metall/container/vector.hpp>
+
+namespace json_bento::jbdtl {
+
+/// \brief How the rows of compact_adjacency_list are allocated.
+enum class row_allocation_mode : uint8_t {
+  /// \brief Each row is allocated by the allocator.
+  individual,
+  /// \brief Small rows are carved out of large chunks per size class.
+  /// Freed rows are reused by rows of the same size class.
+  slab,
+  /// \brief Same as slab, but freed small rows are not reused.
+  /// Suited for data that is imported once and not modified.
+  bump
+};
+
+/// \brief Pool of memory for small row arrays of compact_adjacency_list.
+/// Row capacities are powers of 2; rows whose capacity is up to
+/// k_max_pooled_capacity are allocated from the pool.
+/// \tparam T Element type.
+/// \tparam Alloc Allocator type.
+template <typename T, typename Alloc>
+class row_pool {
+ public:
+  using allocator_type = Alloc;
+  using data_allocator_type =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  using pointer = typename std::allocator_traits<data_allocator_type>::pointer;
+
+  static constexpr std::size_t k_num_classes         = 4;
+  static constexpr std::size_t k_max_pooled_capacity = 1ULL
+                                                       << (k_num_classes - 1);
+  /// \brief Number of rows in a chunk.
+  static constexpr std::size_t k_chunk_rows = 1024;
+
+ private:
+  template <typename U>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<U>;
+
+  template <typename U>
+  using other_scoped_allocator =
+      std::scoped_allocator_adaptor<other_allocator<U>>;
+
+  struct chunk {
+    pointer     data;
+    std::size_t size_class;
+  };
+
+  using chunk_table_type =
+      metall::container::vector<chunk, other_allocator<chunk>>;
+  using free_list_type =
+      metall::container::vector<pointer, other_allocator<pointer>>;
+  using free_list_table_type =
+      metall::container::vector<free_list_type,
+                                other_scoped_allocator<free_list_type>>;
+  using count_table_type =
+      metall::container::vector<uint64_t, other_allocator<uint64_t>>;
+
+ public:
+  row_pool() : row_pool(allocator_type{}) {}
+
+  explicit row_pool(const allocator_type &alloc)
+      : m_chunks(alloc),
+        m_free_lists(k_num_classes, alloc),
+        m_current_chunk(k_num_classes, k_no_chunk, alloc),
+        m_num_used(k_num_classes, 0, alloc) {}
+
+  row_pool(const row_pool &)                = delete;
+  row_pool(row_pool &&) noexcept            = default;
+  row_pool &operator=(const row_pool &)     = delete;
+  row_pool &operator=(row_pool &&) noexcept = default;
+
+  row_allocation_mode mode() const { return m_mode; }
+
+  void set_mode(const row_allocation_mode mode) { m_mode = mode; }
+
+  /// \brief Returns true if rows of 'capacity' are allocated from the pool.
+  bool pooled(const std::size_t capacity) const {
+    return m_mode != row_allocation_mode::individual &&
+           capacity <= k_max_pooled_capacity;
+  }
+
+  /// \brief Returns the number of allocated chunks.
+  std::size_t num_chunks() const { return m_chunks.size(); }
+
+  /// \brief Allocates a row array of 'capacity' elements.
+  /// \param capacity A power of 2, up to k_max_pooled_capacity.
+  pointer allocate(const std::size_t capacity, data_allocator_type alloc) {
+    assert(pooled(capacity));
+    const auto c = priv_size_class(capacity);
+
+    auto &free_list = m_free_lists[c];
+    if (!free_list.empty()) {
+      pointer p = free_list.back();
+      free_list.pop_back();
+      return p;
+    }
+
+    if (m_current_chunk[c] == k_no_chunk || m_num_used[c] == k_chunk_rows) {
+      pointer data = std::allocator_traits<data_allocator_type>::allocate(
+          alloc, k_chunk_rows * capacity);
+      assert(data);
+      m_chunks.push_back(chunk{data, c});
+      m_current_chunk[c] = m_chunks.size() - 1;
+      m_num_used[c]      = 0;
+    }
+
+    return m_chunks[m_current_chunk[c]].data + (m_num_used[c]++) * capacity;
+  }
+
+  /// \brief Gives back a row array allocated by allocate().
+  void deallocate(pointer p, const std::size_t capacity) {
+    assert(pooled(capacity));
+    if (m_mode == row_allocation_mode::bump) return;
+    m_free_lists[priv_size_class(capacity)].push_back(p);
+  }
+
+  /// \brief Frees all chunks.
+  /// All rows allocated by this pool must have been destroyed.
+  void clear(data_allocator_type alloc) {
+    for (auto &ch : m_chunks) {
+      std::allocator_traits<data_allocator_type>::deallocate(
+          alloc, ch.data, k_chunk_rows * (1ULL << ch.size_class));
+    }
+    m_chunks.clear();
+    for (auto &free_list : m_free_lists) free_list.clear();
+    for (auto &cur : m_current_chunk) cur = k_no_chunk;
+    for (auto &n : m_num_used) n = 0;
+  }
+
+ private:
+  static constexpr uint64_t k_no_chunk = std::numeric_limits<uint64_t>::max();
+
+  static std::size_t priv_size_class(const std::size_t capacity) {
+    std::size_t c = 0;
+    while ((1ULL << c) < capacity) ++c;
+    return c;
+  }
+
+  row_allocation_mode  m_mode{row_allocation_mode::individual};
+  chunk_table_type     m_chunks;
+  free_list_table_type m_free_lists;
+  count_table_type     m_current_chunk;
+  count_table_type     m_num_used;
+};
+
+/// \brief Allocator-like handle that compact_adjacency_list passes to
+/// compact_vector for row arrays.
+/// Small arrays are taken from a row_pool; the others from the allocator.
+/// \tparam T Element type.
+/// \tparam Alloc Allocator type.
+template <typename T, typename Alloc>
+class row_allocator {
+ public:
+  using value_type          = T;
+  using data_allocator_type =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+  using pointer = typename std::allocator_traits<data_allocator_type>::pointer;
+  using const_pointer =
+      typename std::allocator_traits<data_allocator_type>::const_pointer;
+  using void_pointer =
+      typename std::allocator_traits<data_allocator_type>::void_pointer;
+  using const_void_pointer =
+      typename std::allocator_traits<data_allocator_type>::const_void_pointer;
+  using size_type = std::size_t;
+  using pool_type = row_pool<T, Alloc>;
+
+  template <typename U>
+  struct rebind {
+    static_assert(std::is_same_v<U, T>, "row_allocator cannot be rebound");
+    using other = row_allocator<U, Alloc>;
+  };
+
+  row_allocator(const data_allocator_type &alloc, pool_type *const pool)
+      : m_allocator(alloc), m_pool(pool) {}
+
+  pointer allocate(const size_type n) {
+    if (m_pool->pooled(n)) return m_pool->allocate(n, m_allocator);
+    return std::allocator_traits<data_allocator_type>::allocate(m_allocator, n);
+  }
+
+  void deallocate(pointer p, const size_type n) {
+    if (m_pool->pooled(n)) {
+      m_pool->deallocate(p, n);
+      return;
+    }
+    std::allocator_traits<data_allocator_type>::deallocate(m_allocator, p, n);
+  }
+
+ private:
+  data_allocator_type m_allocator;
+  pool_type          *m_pool;
+};
+
+}  // namespace json_bento::jbdtl
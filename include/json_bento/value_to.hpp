@@ -5,6 +5,9 @@
 
 #pragma once
 
+#include <string_view>
+#include <type_traits>
+
 #include <json_bento/boost_json.hpp>
 #include <json_bento/box/accessor_fwd.hpp>
 
@@ -62,11 +65,18 @@ namespace json_bento {
 /// has a default constructor. \tparam T The type to convert to. \tparam
 /// allocator_type The allocator type used in the value_accessor. \param value
 /// The value_accessor to convert. \return The converted value.
+/// If T is std::string_view, returns a view of the stored string without
+/// copying it; 'value' must hold a string then and the view is valid until
+/// the string is modified or removed.
 template <typename T, typename allocator_type>
 inline T value_to(const jbdtl::value_accessor<allocator_type> &value) {
-  T out_value;
-  jbdtl::value_to_helper(value, out_value);
-  return out_value;
+  if constexpr (std::is_same_v<T, std::string_view>) {
+    return value.as_string().str_view();
+  } else {
+    T out_value;
+    jbdtl::value_to_helper(value, out_value);
+    return out_value;
+  }
 }
 
 /// \brief Convert a value_accessor to the type T.
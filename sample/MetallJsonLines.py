@@ -65,6 +65,11 @@ q.count()
 
 q.head(num = 10)
 
+## run several methods on one selection in a single pass
+q = mjl[mjl.keys.score > 5]
+q.batch([{"method": "count"}, {"method": "head", "num": 3}, {"method": "hist", "col": "author", "max_bins": 10}])
+# > [15710, [...], [["[deleted]", 2731], ...]]
+
 #
 # update elements
 q = mjl[mjl.keys.author == "[deleted]"]
@@ -88,6 +93,31 @@ q.count()
 
 q.head()
 
+#
+# what-if experiments on a version
+mjl.snapshot("before-set")
+# > 'created version before-set of 81341 rows.'
+
+old = mjl.open_version("before-set")
+old[old.keys.author == "[deleted]"].count()
+# > 'Selected 22387 rows.'
+
+#
+# range selections on an indexed column
+mjl.create_index("created_utc")
+# > 'created index on created_utc of 81341 rows.'
+
+mjl[(mjl.keys.created_utc >= 1262304000) & (mjl.keys.created_utc < 1262390400)].count()
+
+# a zone map (min/max per block of rows) is cheaper for time-ordered ingests
+mjl.create_index("created_utc", kind = "zone_map")
+
+#
+# release the memory left behind by set and clear; sorting by a column
+# improves the locality of scans on it
+mjl.compact(sort_by = "created_utc")
+# > 'compacted 81341 rows sorted by created_utc.'
+
 
 
 
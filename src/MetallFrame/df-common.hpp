@@ -7,9 +7,16 @@
 
 #pragma once
 
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <cstdint>
 #include <limits>
+#include <optional>
 #include <string>
+#include <string_view>
+#include <variant>
+#include <vector>
 
 #include <metall/metall.hpp>
 
@@ -18,6 +25,8 @@
 #include "experimental/cxx-compat.hpp"
 #include "experimental/dataframe.hpp"
 
+#include "df-kernels.hpp"
+
 #define WITH_YGM 1
 
 #include <clippy/clippy-eval.hpp>
@@ -73,6 +82,111 @@ inline json_logic::ValueExpr toValueExpr(experimental::dataframe_variant_t el) {
   return json_logic::toValueExpr(nullptr);
 }
 
+inline json_logic::ValueExpr toValueExpr(
+    experimental::ColumnVariant::pointer_variant_t cell) {
+  if (experimental::string_t** s = std::get_if<experimental::string_t*>(&cell))
+    return json_logic::toValueExpr(
+        boost::json::string((*s)->begin(), (*s)->end()));
+
+  if (experimental::int_t** i = std::get_if<experimental::int_t*>(&cell))
+    return json_logic::toValueExpr(**i);
+
+  if (experimental::real_t** r = std::get_if<experimental::real_t*>(&cell))
+    return json_logic::toValueExpr(**r);
+
+  if (experimental::uint_t** u = std::get_if<experimental::uint_t*>(&cell))
+    return json_logic::toValueExpr(**u);
+
+  CXX_UNLIKELY;
+  return json_logic::toValueExpr(nullptr);
+}
+
+/// the columns that rules refer to, resolved once before the rows are
+/// visited: a column of the data set, or else one of the virtual columns
+/// rowid and mpiid; the value of any other column is null.
+/// \details
+///   a row's values are read without looking up the columns by name in the
+///   data set, and without catching an unknown_column_error per row.
+class ColumnLookup {
+ public:
+  explicit ColumnLookup(int rank) : rank(rank) {}
+
+  /// resolves the free variables \ref vars of a rule (e.g., "keys.x")
+  template <class DataSequence>
+  void addVars(const DataSequence&                     dataset,
+               const std::vector<boost::json::string>& vars) {
+    const std::size_t selLen = SELECTOR.size() + 1;
+
+    for (const boost::json::string& varname : vars) {
+      if (varname.size() < selLen) continue;
+
+      add(dataset, std::string_view{varname.data() + selLen,
+                                    varname.size() - selLen});
+    }
+  }
+
+  /// resolves column \ref col
+  template <class DataSequence>
+  void add(const DataSequence& dataset, std::string_view col) {
+    if (find(col)) return;
+
+    Entry entry{std::string(col), Kind::missing, std::nullopt};
+
+    try {
+      entry.column = std::move(
+          dataset.get_column_variants_std(ColumnSelector{entry.name}).front());
+      entry.kind = Kind::column;
+    } catch (const experimental::unknown_column_error&) {
+      if (col == "rowid") entry.kind = Kind::rowid;
+      if (col == "mpiid") entry.kind = Kind::mpiid;
+    }
+
+    entries.emplace_back(std::move(entry));
+  }
+
+  /// returns the value of column \ref col in row \ref row
+  json_logic::ValueExpr operator()(std::string_view col,
+                                   std::int64_t     row) const {
+    const Entry* entry = find(col);
+
+    if (!entry) {
+      CXX_UNLIKELY;
+      return json_logic::toValueExpr(nullptr);
+    }
+
+    switch (entry->kind) {
+      case Kind::column:
+        return toValueExpr(entry->column->at_variant(row));
+      case Kind::rowid:
+        return json_logic::toValueExpr(row);
+      case Kind::mpiid:
+        return json_logic::toValueExpr(std::int64_t(rank));
+      case Kind::missing:;
+    }
+
+    return json_logic::toValueExpr(nullptr);
+  }
+
+ private:
+  enum class Kind { column, rowid, mpiid, missing };
+
+  struct Entry {
+    std::string                                name;
+    Kind                                       kind;
+    std::optional<experimental::ColumnVariant> column;
+  };
+
+  const Entry* find(std::string_view col) const {
+    for (const Entry& entry : entries)
+      if (entry.name == col) return &entry;
+
+    return nullptr;
+  }
+
+  std::vector<Entry> entries;
+  int                rank;
+};
+
 inline std::vector<int> generateIndexN(std::vector<int> v, int count) {
   v.reserve(count);
   std::generate_n(std::back_inserter(v), count,
@@ -81,6 +195,38 @@ inline std::vector<int> generateIndexN(std::vector<int> v, int count) {
   return v;
 }
 
+/// returns true, if the rules in \ref partial (or all \ref queries if
+/// \ref all is set) hold for row \ref row
+inline bool interpretRow(const ColumnLookup& columns, std::int64_t row,
+                         std::vector<json_logic::AnyExpr>&  queries,
+                         std::vector<json_logic::AnyExpr*>& partial,
+                         bool                               all) {
+  const std::int64_t selLen    = (SELECTOR.size() + 1);
+  auto               varLookup = [&columns, selLen, row](
+                       const boost::json::string& colname,
+                       int) -> json_logic::ValueExpr {
+    // \todo match selector instead of skipping it
+    std::string_view col{colname.begin() + selLen, colname.size() - selLen};
+
+    return columns(col, row);
+  };
+
+  auto rowPredicate = [varLookup](json_logic::AnyExpr& query) -> bool {
+    json_logic::ValueExpr exp = json_logic::calculate(query, varLookup);
+
+    return !json_logic::unpackValue<bool>(std::move(exp));
+  };
+
+  if (all)
+    return std::find_if(queries.begin(), queries.end(), rowPredicate) ==
+           queries.end();
+
+  return std::none_of(partial.begin(), partial.end(),
+                      [&rowPredicate](json_logic::AnyExpr* query) -> bool {
+                        return rowPredicate(*query);
+                      });
+}
+
 /// Calls \fn(row, \dataset[row]) for all rows of \dataset, where all
 /// \predicates hold. \param Fn         a functor that is called with an integer
 /// and a row of \dataset. \param dataset    the data store \param predicates a
@@ -91,7 +237,9 @@ template <class Fn, class DataSequence>
 inline void forAllSelected(Fn fn, int rank, DataSequence& dataset,
                            JsonExpression predicates = {},
                            int numrows = std::numeric_limits<int>::max()) {
-  std::vector<json_logic::AnyExpr> queries;
+  std::vector<json_logic::AnyExpr>          queries;
+  std::vector<experimental::column_kernels> kernels;
+  ColumnLookup                              columns{rank};
 
   // prepare AST
   for (boost::json::object& jexp : predicates) {
@@ -109,46 +257,47 @@ inline void forAllSelected(Fn fn, int rank, DataSequence& dataset,
         throw std::logic_error("unknown selector.");
     }
 
+    columns.addVars(dataset, vars);
+    kernels.emplace_back(
+        experimental::column_kernels::compile(dataset, jexp["rule"], SELECTOR));
     queries.emplace_back(std::move(ast));
   }
 
-  std::vector<int> selectedRows;
-  // for (const auto& row : dataset)
-  for (std::int64_t row = 0, zzz = dataset.rows(); row < zzz; ++row) {
-    const std::int64_t selLen    = (SELECTOR.size() + 1);
-    auto               varLookup = [&dataset, selLen, row, rank](
-                         const boost::json::string& colname,
-                         int) -> json_logic::ValueExpr {
-      // \todo match selector instead of skipping it
-      std::string_view col{colname.begin() + selLen, colname.size() - selLen};
-
-      try {
-        return toValueExpr(dataset.get_cell_variant(row, col));
-      } catch (const experimental::unknown_column_error&) {
-        if (col == "rowid") return json_logic::toValueExpr(row);
-        if (col == "mpiid") return json_logic::toValueExpr(std::int64_t(rank));
-
-        return json_logic::toValueExpr(nullptr);
-      }
-    };
+  // phase 1: the compiled comparisons narrow the candidate rows
+  using bitmap_type = experimental::column_kernels::bitmap_type;
+
+  const std::size_t numRows = dataset.rows();
+  bitmap_type       candidates((numRows + 63) / 64, ~std::uint64_t(0));
+  bitmap_type       unknown(candidates.size(), 0);
+
+  if (numRows % 64)
+    candidates.back() = (std::uint64_t(1) << (numRows % 64)) - 1;
+
+  for (const experimental::column_kernels& kern : kernels)
+    kern.apply(candidates, unknown, numRows);
+
+  // phase 2: the rules are interpreted for the candidates that the kernels
+  //   did not decide
+  std::vector<json_logic::AnyExpr*> partial;
 
-    auto rowPredicate = [varLookup](json_logic::AnyExpr& query) -> bool {
-      json_logic::ValueExpr exp = json_logic::calculate(query, varLookup);
+  for (std::size_t i = 0; i < kernels.size(); ++i)
+    if (!kernels[i].exact()) partial.push_back(&queries[i]);
 
-      return !json_logic::unpackValue<bool>(std::move(exp));
-    };
+  for (std::size_t w = 0; w < candidates.size(); ++w) {
+    for (std::uint64_t word = candidates[w]; word != 0; word &= word - 1) {
+      const std::int64_t row       = w * 64 + std::countr_zero(word);
+      const bool         undecided = (unknown[w] >> (row % 64)) & 1;
 
-    const std::vector<json_logic::AnyExpr>::iterator lim = queries.end();
-    const std::vector<json_logic::AnyExpr>::iterator pos =
-        std::find_if(queries.begin(), lim, rowPredicate);
+      if ((undecided || !partial.empty()) &&
+          !interpretRow(columns, row, queries, partial, undecided))
+        continue;
 
-    if (pos == lim) {
       //~ fn(rownum, row);
       fn(row);
 
       if (0 == --numrows) {
         CXX_UNLIKELY;
-        break;
+        return;
       }
     }
   }
@@ -20,20 +20,57 @@ const std::string& name(const ColumnDescription& col) { return col.first; }
 namespace {
 const std::string METHOD_NAME     = "__init__";
 const std::string ARG_COLUMN_DESC = "columns";
+
+/// the storage of a column's cells
+enum class ColumnEncoding {
+  dense,    ///< a value for each row
+  sparse,   ///< sorted (row, value) pairs of the rows that have a value
+  nullable  ///< as sparse; rows without a value are null
+};
+
+/// splits a column type into the value type and the encoding,
+/// e.g., "int:sparse" -> ("int", sparse); the default encoding is dense.
+std::pair<std::string_view, ColumnEncoding> typeAndEncoding(
+    std::string_view coltype) {
+  static const std::string UNKNOWN_ENCODING{"unknown column encoding: "};
+
+  const std::size_t pos = coltype.find(':');
+
+  if (pos == std::string_view::npos) return {coltype, ColumnEncoding::dense};
+
+  const std::string_view enc = coltype.substr(pos + 1);
+  const std::string_view val = coltype.substr(0, pos);
+
+  if (enc == "dense") return {val, ColumnEncoding::dense};
+  if (enc == "sparse") return {val, ColumnEncoding::sparse};
+  if (enc == "nullable") return {val, ColumnEncoding::nullable};
+
+  throw std::runtime_error{UNKNOWN_ENCODING + std::string(enc)};
+}
+
+/// adds a column of values of type T with default value \ref dflt
+template <class T>
+void addColumn(xpr::DataFrame& df, ColumnEncoding enc, T dflt) {
+  if (enc == ColumnEncoding::dense)
+    df.add_column_default_value(xpr::dense<T>{std::move(dflt)});
+  else
+    df.add_column_default_value(xpr::sparse<T>{std::move(dflt)});
+}
 }  // namespace
 
 void appendColumn(xpr::DataFrame& df, const ColumnDescription& desc) {
   static const std::string UNKNOWN_COLUMN_TYPE{"unknown column type: "};
 
-  if (type(desc) == "uint")
-    df.add_column_default_value(xpr::dense<xpr::uint_t>{0});
-  else if (type(desc) == "int")
-    df.add_column_default_value(xpr::dense<xpr::int_t>{0});
-  else if (type(desc) == "real")
-    df.add_column_default_value(xpr::dense<xpr::real_t>{0});
-  else if (type(desc) == "string")
-    df.add_column_default_value(
-        xpr::dense<xpr::string_t>{df.persistent_string("")});
+  const auto [valtype, enc] = typeAndEncoding(type(desc));
+
+  if (valtype == "uint")
+    addColumn<xpr::uint_t>(df, enc, 0);
+  else if (valtype == "int")
+    addColumn<xpr::int_t>(df, enc, 0);
+  else if (valtype == "real")
+    addColumn<xpr::real_t>(df, enc, 0);
+  else if (valtype == "string")
+    addColumn<xpr::string_t>(df, enc, df.persistent_string(""));
   else
     throw std::runtime_error{UNKNOWN_COLUMN_TYPE + name(desc)};
 
@@ -64,7 +101,9 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
       ARG_COLUMN_DESC,
       "Column description (pair of string/string describing name and type of "
       "columns)."
-      "\n  Valid types in (string | int | uint | real)",
+      "\n  Valid types in (string | int | uint | real), optionally followed "
+      "by an encoding (:dense | :sparse | :nullable), e.g., \"int:sparse\". "
+      "Sparse and nullable columns only store the rows that have a value.",
       std::vector<ColumnDescription>{});
 
   // no object-state requirements in constructor
@@ -0,0 +1,344 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Column-at-a-time evaluation of common predicate shapes for
+///        MetallFrame selections.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "experimental/dataframe.hpp"
+
+namespace experimental {
+
+/// a conjunction of comparisons between a column and a constant
+///   (e.g., `{"and": [{"<": [{"var": "keys.x"}, 5]}, ...]}`), evaluated
+///   one column at a time into selection bitmaps.
+/// \details
+///   a kernel reads a column's cells in row order and sets one bit per
+///   row, instead of evaluating the json_logic rule and its variable
+///   lookups per row. A cell for which the kernel cannot decide the
+///   outcome as json_logic would (e.g., a string compared to a number)
+///   is marked as unknown; the rule must be interpreted for such rows.
+///   Comparisons that cannot be compiled (e.g., rowid, a disjunction)
+///   make the predicate partial: the compiled comparisons still narrow
+///   the candidate rows, and the rule is interpreted for these.
+class column_kernels {
+ public:
+  using bitmap_type = std::vector<std::uint64_t>;
+
+  /// compiles the comparisons of \ref rule that refer to columns of
+  ///   \ref dataset.
+  /// \param selectPrefix the prefix of the variable names (e.g., "keys")
+  template <class DataFrame>
+  static column_kernels compile(const DataFrame&          dataset,
+                                const boost::json::value& rule,
+                                std::string_view          selectPrefix) {
+    column_kernels res;
+
+    res.complete = res.add_rule(dataset, rule, selectPrefix);
+    return res;
+  }
+
+  /// returns true, if the kernels decide the predicate for all rows that
+  ///   are not marked unknown
+  bool exact() const { return complete; }
+
+  /// returns true, if no comparison was compiled
+  bool empty() const { return clauses.empty(); }
+
+  /// clears the bits of the rows in \ref candidates that the kernels
+  ///   reject, and sets the bits of undecided rows in \ref unknown.
+  ///   Both bitmaps have a bit for each row in [0, numrows).
+  void apply(bitmap_type& candidates, bitmap_type& unknown,
+             std::size_t numrows) const {
+    for (const clause& cl : clauses) cl.eval(candidates, unknown, numrows);
+  }
+
+ private:
+  enum class comparison : std::uint8_t { eq, ne, lt, le, gt, ge };
+
+  using constant_type = std::variant<int_t, uint_t, real_t, std::string>;
+
+  /// a comparison of a column against a constant
+  struct clause {
+    ColumnVariant column;
+    comparison    cmp;
+    constant_type cst;
+
+    void eval(bitmap_type& candidates, bitmap_type& unknown,
+              std::size_t numrows) const {
+      switch (cmp) {
+        case comparison::eq:
+          return run<std::equal_to<>>(candidates, unknown, numrows);
+        case comparison::ne:
+          return run<std::not_equal_to<>>(candidates, unknown, numrows);
+        case comparison::lt:
+          return run<std::less<>>(candidates, unknown, numrows);
+        case comparison::le:
+          return run<std::less_equal<>>(candidates, unknown, numrows);
+        case comparison::gt:
+          return run<std::greater<>>(candidates, unknown, numrows);
+        case comparison::ge:
+          return run<std::greater_equal<>>(candidates, unknown, numrows);
+      }
+    }
+
+    /// the kernel: one pass over the column, 64 rows per bitmap word
+    template <class Cmp>
+    void run(bitmap_type& candidates, bitmap_type& unknown,
+             std::size_t numrows) const {
+      for (std::size_t w = 0; w < candidates.size(); ++w) {
+        if (candidates[w] == 0) continue;
+
+        const std::size_t beg   = w * 64;
+        const std::size_t lim   = std::min(numrows, beg + 64);
+        std::uint64_t     pass  = 0;
+        std::uint64_t     undec = 0;
+
+        for (std::size_t row = beg; row < lim; ++row) {
+          const std::uint64_t bit = std::uint64_t(1) << (row - beg);
+
+          switch (test<Cmp>(column.at_variant(row))) {
+            case outcome::yes:
+              pass |= bit;
+              break;
+            case outcome::unknown:
+              pass |= bit;
+              undec |= bit;
+              break;
+            case outcome::no:;
+          }
+        }
+
+        unknown[w] |= undec & candidates[w];
+        candidates[w] &= pass;
+      }
+    }
+
+    enum class outcome : std::uint8_t { no, yes, unknown };
+
+    static outcome to_outcome(bool b) { return b ? outcome::yes : outcome::no; }
+
+    /// compares numbers as json_logic does; integers are compared exactly
+    template <class Cmp, class L, class R>
+    static bool compare(L lhs, R rhs) {
+      if constexpr (std::is_integral_v<L> && std::is_integral_v<R>) {
+        if constexpr (std::is_same_v<Cmp, std::equal_to<>>)
+          return std::cmp_equal(lhs, rhs);
+        if constexpr (std::is_same_v<Cmp, std::not_equal_to<>>)
+          return std::cmp_not_equal(lhs, rhs);
+        if constexpr (std::is_same_v<Cmp, std::less<>>)
+          return std::cmp_less(lhs, rhs);
+        if constexpr (std::is_same_v<Cmp, std::less_equal<>>)
+          return std::cmp_less_equal(lhs, rhs);
+        if constexpr (std::is_same_v<Cmp, std::greater<>>)
+          return std::cmp_greater(lhs, rhs);
+        if constexpr (std::is_same_v<Cmp, std::greater_equal<>>)
+          return std::cmp_greater_equal(lhs, rhs);
+
+        return false;
+      } else {
+        return Cmp{}(double(lhs), double(rhs));
+      }
+    }
+
+    template <class Cmp>
+    outcome test(ColumnVariant::pointer_variant_t cell) const {
+      if (const std::string* s = std::get_if<std::string>(&cst)) {
+        const string_t* const* str = std::get_if<string_t*>(&cell);
+
+        if (!str) return outcome::unknown;
+
+        const string_t&        val = **str;
+        const std::string_view sv =
+            val.size() ? std::string_view{&*val.begin(), val.size()}
+                       : std::string_view{};
+
+        return to_outcome(Cmp{}(sv, std::string_view{*s}));
+      }
+
+      return std::visit(
+          [&cell](auto c) -> outcome {
+            if constexpr (std::is_same_v<decltype(c), std::string>) {
+              return outcome::unknown;
+            } else {
+              if (int_t* const* i = std::get_if<int_t*>(&cell))
+                return to_outcome(compare<Cmp>(**i, c));
+              if (uint_t* const* u = std::get_if<uint_t*>(&cell))
+                return to_outcome(compare<Cmp>(**u, c));
+              if (real_t* const* r = std::get_if<real_t*>(&cell))
+                return to_outcome(compare<Cmp>(**r, c));
+
+              return outcome::unknown;
+            }
+          },
+          cst);
+    }
+  };
+
+  static std::optional<comparison> to_comparison(std::string_view op) {
+    if (op == "==") return comparison::eq;
+    if (op == "!=") return comparison::ne;
+    if (op == "<") return comparison::lt;
+    if (op == "<=") return comparison::le;
+    if (op == ">") return comparison::gt;
+    if (op == ">=") return comparison::ge;
+
+    return std::nullopt;
+  }
+
+  /// returns the comparison with swapped operands
+  static comparison flip(comparison cmp) {
+    switch (cmp) {
+      case comparison::lt:
+        return comparison::gt;
+      case comparison::le:
+        return comparison::ge;
+      case comparison::gt:
+        return comparison::lt;
+      case comparison::ge:
+        return comparison::le;
+      default:;
+    }
+
+    return cmp;
+  }
+
+  /// returns the column name if val is {"var": "<selectPrefix>.<column>"}
+  static std::optional<std::string> column_name(const boost::json::value& val,
+                                                std::string_view selectPrefix) {
+    const boost::json::object* obj = val.if_object();
+
+    if (!obj || obj->size() != 1) return std::nullopt;
+
+    const boost::json::value* var = obj->if_contains("var");
+
+    if (!var || !var->is_string()) return std::nullopt;
+
+    const std::string_view name{var->as_string().data(),
+                                var->as_string().size()};
+
+    if (name.size() <= selectPrefix.size() ||
+        name.substr(0, selectPrefix.size()) != selectPrefix ||
+        name[selectPrefix.size()] != '.')
+      return std::nullopt;
+
+    return std::string(name.substr(selectPrefix.size() + 1));
+  }
+
+  /// returns \ref val as a kernel constant; strings are only compared for
+  ///   (in)equality.
+  static std::optional<constant_type> constant(const boost::json::value& val,
+                                               comparison cmp) {
+    if (val.is_int64()) return constant_type{int_t(val.as_int64())};
+    if (val.is_uint64()) return constant_type{uint_t(val.as_uint64())};
+    if (val.is_double()) return constant_type{real_t(val.as_double())};
+
+    if (val.is_string() && ((cmp == comparison::eq) || (cmp == comparison::ne)))
+      return constant_type{std::string(val.as_string().c_str())};
+
+    return std::nullopt;
+  }
+
+  /// adds the comparison `column cmp cst`; returns false if the column is
+  ///   not a column of \ref dataset (e.g., rowid)
+  template <class DataFrame>
+  bool add_comparison(const DataFrame& dataset, std::string column,
+                      comparison cmp, constant_type cst) {
+    try {
+      std::vector<ColumnVariant> cols =
+          dataset.get_column_variants_std(std::vector<std::string>{column});
+
+      clauses.push_back(clause{std::move(cols.front()), cmp, std::move(cst)});
+      return true;
+    } catch (const unknown_column_error&) {
+      return false;
+    }
+  }
+
+  /// adds the comparisons of \ref rule; returns false if a part of the rule
+  ///   could not be compiled.
+  template <class DataFrame>
+  bool add_rule(const DataFrame& dataset, const boost::json::value& rule,
+                std::string_view selectPrefix) {
+    const boost::json::object* obj = rule.if_object();
+
+    if (!obj || obj->size() != 1) return false;
+
+    const auto&               op   = *obj->begin();
+    const boost::json::array* args = op.value().if_array();
+
+    if (!args) return false;
+
+    const std::string_view opname{op.key().data(), op.key().size()};
+
+    if (opname == "and") {
+      bool res = !args->empty();
+
+      for (const boost::json::value& sub : *args)
+        res = add_rule(dataset, sub, selectPrefix) && res;
+
+      return res;
+    }
+
+    const std::optional<comparison> cmp = to_comparison(opname);
+
+    if (!cmp) return false;
+
+    // between: {"<": [a, {"var": ...}, b]} (or "<=")
+    if ((args->size() == 3) &&
+        ((*cmp == comparison::lt) || (*cmp == comparison::le))) {
+      const std::optional<std::string> col =
+          column_name((*args)[1], selectPrefix);
+      const std::optional<constant_type> lo = constant((*args)[0], *cmp);
+      const std::optional<constant_type> hi = constant((*args)[2], *cmp);
+
+      if (!col || !lo || !hi) return false;
+
+      const bool lower = add_comparison(dataset, *col, flip(*cmp), *lo);
+
+      return add_comparison(dataset, *col, *cmp, *hi) && lower;
+    }
+
+    if (args->size() != 2) return false;
+
+    comparison                 actual = *cmp;
+    std::optional<std::string> column = column_name((*args)[0], selectPrefix);
+    const boost::json::value*  cst    = &(*args)[1];
+
+    if (!column) {
+      column = column_name((*args)[1], selectPrefix);
+      cst    = &(*args)[0];
+      actual = flip(actual);
+    }
+
+    if (!column) return false;
+
+    std::optional<constant_type> val = constant(*cst, actual);
+
+    if (!val) return false;
+
+    return add_comparison(dataset, std::move(*column), actual,
+                          std::move(*val));
+  }
+
+  column_kernels() = default;
+
+  std::vector<clause> clauses;
+  bool                complete = false;
+};
+
+}  // namespace experimental
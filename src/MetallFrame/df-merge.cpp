@@ -17,6 +17,7 @@
 
 #include "clippy/clippy.hpp"
 #include "df-common.hpp"
+#include "../MetallJsonLines/MetallJsonLines-join.hpp"
 
 namespace bj  = boost::json;
 namespace jl  = json_logic;
@@ -42,6 +43,11 @@ const std::string ARG_RIGHT_ON = "right_on";
 const std::string COLUMNS_LEFT  = "left_columns";
 const std::string COLUMNS_RIGHT = "right_columns";
 
+const std::string ARG_SPILL_BUDGET    = "spill_budget";
+const std::string ARG_SPILL_DIRECTORY = "spill_directory";
+
+const std::string ARG_PROFILE = "profile";
+
 const ColumnSelector DEFAULT_COLUMNS = {};
 
 //~ const std::string    ARG_SUFFIXES     = "suffixes";
@@ -74,23 +80,6 @@ T valueAt(bj::object& value, const argts&... keys) try {
   return T();
 }
 
-//
-// hash_combine: https://stackoverflow.com/a/50978188
-inline std::uint64_t xorShift(std::uint64_t n, int i) { return n ^ (n >> i); }
-
-// a hash function with another name as to not confuse with std::hash
-inline std::uint64_t stableHashDistribute(std::uint64_t n) {
-  std::uint64_t p = 0x5555555555555555ull;    // pattern of alternating 0 and 1
-  std::uint64_t c = 17316035218449499591ull;  // random uneven integer constant;
-  return c * xorShift(p * xorShift(n, 32), 32);
-}
-
-std::uint64_t stableHashCombine(std::uint64_t seed, std::uint64_t comp) {
-  return boost::hash_combine(seed, comp), seed;
-  //~ return std::rotl(seed, std::numeric_limits<std::uint64_t>::digits/3) ^
-  //stableHashDistribute(comp);
-}
-
 #if OBSOLETE_CODE
 template <typename _allocator_type>
 std::size_t hashCode(const mtljsn::value<_allocator_type>& val) {
@@ -112,8 +101,8 @@ std::size_t hashCode(const mtljsn::value<_allocator_type>& val) {
     std::size_t res{0};
 
     for (const auto& el : obj) {
-      res = stableHashCombine(res, std::hash<std::string_view>{}(el.key()));
-      res = stableHashCombine(res, hashCode(el.value()));
+      res = combine_hash(res, std::hash<std::string_view>{}(el.key()));
+      res = combine_hash(res, hashCode(el.value()));
     }
 
     return res;
@@ -126,7 +115,7 @@ std::size_t hashCode(const mtljsn::value<_allocator_type>& val) {
   // \todo should an element's position be taken into account for the computed
   // hash value?
   for (const auto& el : val.as_array())
-    res = stableHashCombine(res, hashCode(el));
+    res = combine_hash(res, hashCode(el));
 
   return res;
 }
@@ -136,15 +125,15 @@ std::uint64_t hashCode(xpr::ColumnVariant::pointer_variant_t ptr) {
   if (xpr::string_t** s = std::get_if<xpr::string_t*>(&ptr)) {
     const xpr::string_t& str = **s;
 
-    return std::hash<std::string_view>{}(
-        std::string_view{&*str.begin(), str.size()});
+    return stable_string_hash(std::string_view{&*str.begin(), str.size()});
   }
 
+  // same hashes as key_hash_code in the MetallJsonLines merge
   if (xpr::int_t** i = std::get_if<xpr::int_t*>(&ptr))
-    return std::hash<xpr::int_t>{}(**i);
+    return mix_hash64(std::uint64_t(**i));
 
   if (xpr::uint_t** u = std::get_if<xpr::uint_t*>(&ptr))
-    return std::hash<xpr::uint_t>{}(**u);
+    return mix_hash64(**u);
 
   if (xpr::real_t** r = std::get_if<xpr::real_t*>(&ptr))
     return std::hash<xpr::real_t>{}(**r);
@@ -154,60 +143,13 @@ std::uint64_t hashCode(xpr::ColumnVariant::pointer_variant_t ptr) {
 
 /// define data held locally
 
-enum JoinSide { lhsData = 0, rhsData = 1 };
-
-struct JoinRegistry : std::tuple<std::uint64_t, int, int> {
-  using base = std::tuple<std::uint64_t, int, int>;
-  using base::base;
-
-  std::uint64_t hash() const { return std::get<0>(*this); }
-  int           owner_rank() const { return std::get<1>(*this); }
-  int           owner_index() const { return std::get<2>(*this); }
-};
-
-struct ByHashOwner {
-  bool operator()(const JoinRegistry& lhs, const JoinRegistry& rhs) const {
-    std::uint64_t lskey = lhs.hash();
-    std::uint64_t rskey = rhs.hash();
-
-    if (lskey < rskey) return true;
-    if (lskey > rskey) return false;
-
-    return lhs.owner_rank() < rhs.owner_rank();
-  }
-};
-
-struct SameHash {
-  bool operator()(const JoinRegistry& rhs) const { return h == rhs.hash(); }
-
-  const std::uint64_t h;
-};
-
-struct JoinLeftInfo : std::tuple<int, int> {
-  using base = std::tuple<int, int>;
-  using base::base;
-
-  int owner() const { return std::get<0>(*this); }
-  int index() const { return std::get<1>(*this); }
-};
-
-using JoinRightInfo = int;
-
-struct MergeCandidates
-    : std::tuple<std::vector<JoinRightInfo>, std::vector<JoinLeftInfo> > {
-  using base =
-      std::tuple<std::vector<JoinRightInfo>, std::vector<JoinLeftInfo> >;
-  using base::base;
-
-  std::vector<JoinRightInfo>&       local_data() { return std::get<0>(*this); }
-  const std::vector<JoinRightInfo>& local_data() const {
-    return std::get<0>(*this);
-  }
-  std::vector<JoinLeftInfo>&       remote_data() { return std::get<1>(*this); }
-  const std::vector<JoinLeftInfo>& remote_data() const {
-    return std::get<1>(*this);
-  }
-};
+// the registries and candidates are kept by the shared join engine
+using JoinSide        = xpr::join_side;
+using JoinLeftInfo    = xpr::join_info_lhs;
+using JoinRightInfo   = xpr::join_info_rhs;
+using MergeCandidates = xpr::merge_candidates;
+using xpr::lhsData;
+using xpr::rhsData;
 
 struct JoinData : std::tuple<std::vector<int>, std::vector<std::string> > {
   using base = std::tuple<std::vector<int>, std::vector<std::string> >;
@@ -219,71 +161,56 @@ struct JoinData : std::tuple<std::vector<int>, std::vector<std::string> > {
   const std::vector<std::string>& data() const { return std::get<1>(*this); }
 };
 
-using JoinIndex = std::vector<JoinRegistry>;
-
 struct ProcessData {
-  std::vector<MergeCandidates> mergeCandidates;
-  std::vector<JoinData>        joinData;
-  JoinIndex                    joinIndex[2];
+  xpr::hash_join_state  join;
+  std::vector<JoinData> joinData;
+
+  /// phase times and counters; disabled unless requested
+  xpr::run_profile profile;
 };
 
 ProcessData local;  // global allocation!
 
 ///
 void storeElem(JoinSide which, std::uint64_t h, int rank, int idx) {
-  local.joinIndex[which].emplace_back(h, rank, idx);
+  local.join.register_row(which, h, rank, idx);
 
-  if (DEBUG_TRACE && ((local.joinIndex[which].size() % (1 << 12)) == 0)) {
+  if (DEBUG_TRACE && ((local.join.index[which].size() % (1 << 12)) == 0)) {
     //~ std::ofstream logfile{clippy::clippyLogFile, std::ofstream::app};
 
     std::cerr << "storeElem: @" << which << " - "
-              << local.joinIndex[which].size() << "  from: " << rank << '.'
+              << local.join.index[which].size() << "  from: " << rank << '.'
               << idx << std::endl;
   }
 }
 
 void commJoinHash(ygm::comm& w, JoinSide which, std::uint64_t h, int idx) {
   const int rank = w.rank();
-  const int dest = h % w.size();
+  const int dest = xpr::hash_owner(h, w.size());
 
   if (w.rank() == dest) {
     storeElem(which, h, rank, idx);
     return;
   }
 
+  local.profile.count(xpr::join_counter::messages_sent);
+  local.profile.count(xpr::join_counter::bytes_sent,
+                      xpr::message_size(which, h, rank, idx));
   w.async(
       dest,
       [](JoinSide operand, std::uint64_t hash, int owner_rank, int owner_idx)
-          -> void { storeElem(operand, hash, owner_rank, owner_idx); },
+          -> void {
+        local.profile.count(
+            xpr::join_counter::bytes_received,
+            xpr::message_size(operand, hash, owner_rank, owner_idx));
+        storeElem(operand, hash, owner_rank, owner_idx);
+      },
       which, h, rank, idx);
 }
 
-template <class PackerFn>
-auto packInfo(JoinIndex::const_iterator beg, JoinIndex::const_iterator lim,
-              PackerFn fn) -> std::vector<decltype(fn(*beg))> {
-  std::vector<decltype(fn(*beg))> res;
-
-  std::transform(beg, lim, std::back_inserter(res), fn);
-  return res;
-}
-
-std::vector<JoinLeftInfo> packLeftInfo(JoinIndex::const_iterator beg,
-                                       JoinIndex::const_iterator lim) {
-  return packInfo(beg, lim, [](const JoinRegistry& el) -> JoinLeftInfo {
-    return JoinLeftInfo{el.owner_rank(), el.owner_index()};
-  });
-}
-
-std::vector<JoinRightInfo> packRightInfo(JoinIndex::const_iterator beg,
-                                         JoinIndex::const_iterator lim) {
-  return packInfo(beg, lim, [](const JoinRegistry& el) -> JoinRightInfo {
-    return JoinRightInfo{el.owner_index()};
-  });
-}
-
 void storeCandidates(const std::vector<int>&          localInfo,
                      const std::vector<JoinLeftInfo>& remoteInfo) {
-  local.mergeCandidates.emplace_back(localInfo, remoteInfo);
+  local.join.store_candidates(localInfo, remoteInfo);
 }
 
 void commJoinCandidates(ygm::comm& w, int dest, const std::vector<int>& rhsInfo,
@@ -293,28 +220,43 @@ void commJoinCandidates(ygm::comm& w, int dest, const std::vector<int>& rhsInfo,
     return;
   }
 
+  local.profile.count(xpr::join_counter::messages_sent);
+  local.profile.count(xpr::join_counter::bytes_sent,
+                      xpr::message_size(rhsInfo, lhsInfo));
   w.async(
       dest,
       [](const std::vector<int>& ri, const std::vector<JoinLeftInfo>& li)
-          -> void { storeCandidates(ri, li); },
+          -> void {
+        local.profile.count(xpr::join_counter::bytes_received,
+                            xpr::message_size(ri, li));
+        storeCandidates(ri, li);
+      },
       rhsInfo, lhsInfo);
 }
 
 void storeJoinData(const std::vector<int>&    indices,
                    std::vector<std::string>&& data) {
+  local.profile.count(xpr::join_counter::rows_received, data.size());
   local.joinData.emplace_back(indices, std::move(data));
 }
 
 void commJoinData(ygm::comm& w, int dest, const std::vector<int>& indices,
                   std::vector<std::string>&& data) {
+  local.profile.count(xpr::join_counter::rows_moved, data.size());
+
   if (w.rank() == dest) {
     storeJoinData(indices, std::move(data));
     return;
   }
 
+  local.profile.count(xpr::join_counter::messages_sent);
+  local.profile.count(xpr::join_counter::bytes_sent,
+                      xpr::message_size(indices, data));
   w.async(
       dest,
       [](const std::vector<int>& idx, std::string&& data) -> void {
+        local.profile.count(xpr::join_counter::bytes_received,
+                            xpr::message_size(idx, data));
         storeJoinData(idx, std::move(data));
       },
       indices, data);
@@ -325,7 +267,7 @@ std::uint64_t computeHash(const std::vector<xpr::ColumnVariant>& colaccess,
   std::uint64_t res{0};
 
   for (const xpr::ColumnVariant& col : colaccess)
-    res = stableHashCombine(res, hashCode(col.at_variant(rownum)));
+    res = combine_hash(res, hashCode(col.at_variant(rownum)));
 
   return res;
 }
@@ -339,6 +281,8 @@ void computeMergeInfo(ygm::comm& world, const vector_json_type& vec,
   auto fn = [&world, &colaccess, which](int rownum) -> void {
     std::uint64_t hval = computeHash(colaccess, rownum, world);
 
+    local.profile.count(xpr::join_counter::rows_hashed);
+
     if (DEBUG_TRACE && ((rownum % (1 << 12)) == 0)) {
       //~ std::ofstream logfile{clippy::clippyLogFile, std::ofstream::app};
 
@@ -551,9 +495,28 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
                                     "projection list of the right input frame",
                                     DEFAULT_COLUMNS);
 
-  // currently unsupported optional arguments
-  // clip.add_optional(ARG_HOW, "join method:
-  // {'left'|'right'|'outer'|'inner'|'cross']} default: inner", DEFAULT_HOW);
+  clip.add_optional<int>(
+      ARG_SPILL_BUDGET,
+      "memory budget per rank in MiB for the join index; the excess is "
+      "spilled to scratch files (0 turns spilling off)",
+      0);
+  clip.add_optional<std::string>(
+      ARG_SPILL_DIRECTORY,
+      "directory of the scratch files (default: the temporary directory)",
+      "");
+
+  clip.add_optional<std::string>(
+      ARG_HOW,
+      "join type: {'inner'|'left'|'right'|'outer'|'semi'|'anti'}; "
+      "MetallFrame currently only computes inner joins",
+      DEFAULT_HOW);
+
+  clip.add_optional<bool>(
+      ARG_PROFILE,
+      "returns {'message', 'count', 'profile'}, where profile has the wall "
+      "time of each join phase and per-rank counters (e.g., bytes sent), "
+      "reduced over the ranks to min, max, sum, mean, and skew",
+      false);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
@@ -572,6 +535,24 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
     ColumnSelector projLhs = clip.get<ColumnSelector>(COLUMNS_LEFT);
     ColumnSelector projRhs = clip.get<ColumnSelector>(COLUMNS_RIGHT);
 
+    // the other join types need the matched-row tracking of
+    //   MetallJsonLines-merge.hpp, which is not yet ported.
+    if (xpr::to_merge_how(clip.get<std::string>(ARG_HOW)) !=
+        xpr::merge_how::inner)
+      throw std::invalid_argument{"MetallFrame only supports inner joins"};
+
+    const int spillBudget = clip.get<int>(ARG_SPILL_BUDGET);
+
+    if (spillBudget < 0)
+      throw std::invalid_argument{"spill_budget must not be negative"};
+
+    const xpr::spill_options spill{std::size_t(spillBudget) << 20,
+                                   clip.get<std::string>(ARG_SPILL_DIRECTORY)};
+
+    local.join.configure(spill);
+
+    if (clip.get<bool>(ARG_PROFILE)) local.profile = xpr::make_join_profile();
+
     // argument error checking
     //   \todo move to validation
     if (argLhsOn.empty() && argsOn.empty())
@@ -624,6 +605,8 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
 
     time_point starttime_P1 = std::chrono::system_clock::now();
 
+    local.profile.phase("hash");
+
     //   left:
     //     open left object
     //     compute hash and send to designated node
@@ -659,118 +642,57 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
       //~ std::ofstream logfile{clippy::clippyLogFile, std::ofstream::app};
 
       std::cerr << "phase 1: @" << world.rank()
-                << "  L: " << local.joinIndex[lhsData].size()
-                << "  R: " << local.joinIndex[rhsData].size() << std::endl;
+                << "  L: " << local.join.index[lhsData].size()
+                << "  R: " << local.join.index[rhsData].size() << std::endl;
     }
 
-    // phase 2: perform preliminary merge based on hash
-    //       a) sort the two indices
-    std::sort(local.joinIndex[lhsData].begin(), local.joinIndex[lhsData].end(),
-              ByHashOwner{});
-    std::sort(local.joinIndex[rhsData].begin(), local.joinIndex[rhsData].end(),
-              ByHashOwner{});
+    local.profile.count(xpr::join_counter::index_lhs,
+                        local.join.index[lhsData].size());
+    local.profile.count(xpr::join_counter::index_rhs,
+                        local.join.index[rhsData].size());
+    local.profile.phase("candidates");
 
+    // phase 2: perform preliminary merge based on hash
+    //       a) sort the two indices (runs spilled to scratch files are merged)
     //       b) send information of join candidates on left side to owners of
     //       right side
-    JoinIndex::const_iterator       lsbeg = local.joinIndex[lhsData].begin();
-    const JoinIndex::const_iterator lslim = local.joinIndex[lhsData].end();
-    JoinIndex::const_iterator       rsbeg = local.joinIndex[rhsData].begin();
-    const JoinIndex::const_iterator rslim = local.joinIndex[rhsData].end();
-
-    while ((lsbeg != lslim) && (rsbeg != rslim)) {
-      const std::uint64_t       lskey = lsbeg->hash();
-      const std::uint64_t       rskey = rsbeg->hash();
-      JoinIndex::const_iterator lseqr =
-          std::find_if_not(lsbeg + 1, lslim, SameHash{lsbeg->hash()});
-      JoinIndex::const_iterator rseqr =
-          std::find_if_not(rsbeg + 1, rslim, SameHash{rsbeg->hash()});
-
-      if (lskey < rskey) {
-        lsbeg = lseqr;
-        continue;
-      }
-
-      if (lskey > rskey) {
-        rsbeg = rseqr;
-        continue;
-      }
-
-      //     b.1) keys are equal
-      //             pack candidates on left side
-      std::vector<JoinLeftInfo> lhsJoinData = packLeftInfo(lsbeg, lseqr);
-
-      lsbeg = lseqr;
-
-      //     b.2) send lhs candidates to all owners of rhs candidates
-      //          processing groups by owner
-      while (rsbeg < rseqr) {
-        const int dest      = rsbeg->owner_rank();
-        auto      sameOwner = [dest](const JoinRegistry& rhs) -> bool {
-          return dest == rhs.owner_rank();
-        };
-        JoinIndex::const_iterator rsdst =
-            std::find_if_not(rsbeg + 1, rseqr, sameOwner);
-
-        //           pack all right hand side candidates with the same owner
-        std::vector<int> rhsJoinData = packRightInfo(rsbeg, rsdst);
-
-        //           send candidates
-        commJoinCandidates(world, dest, rhsJoinData, lhsJoinData);
-
-        rsbeg = rsdst;
-      }
-    }
-
-    // free up space
-    local.joinIndex[lhsData].clear();
-    local.joinIndex[rhsData].clear();
+    xpr::compute_candidates(
+        local.join,
+        [&world](int dest, const std::vector<int>& rhsJoinData,
+                 const std::vector<JoinLeftInfo>& lhsJoinData) -> void {
+          commJoinCandidates(world, dest, rhsJoinData, lhsJoinData);
+        });
 
     world.barrier();  // not needed
+    local.profile.phase("exchange");
 
     if (DEBUG_TRACE) {
       //~ std::ofstream logfile{clippy::clippyLogFile, std::ofstream::app};
 
       std::cerr << "phase 2: @" << world.rank()
-                << "  M: " << local.mergeCandidates.size() << std::endl;
+                << "  M: " << local.join.candidates.size() << std::endl;
     }
 
     // phase 3: send data to node that computes the join
-    for (const MergeCandidates& m : local.mergeCandidates) {
-      using iterator = std::vector<JoinLeftInfo>::const_iterator;
-
+    xpr::for_each_candidates(local.join, [&](const MergeCandidates& m) -> void {
       std::vector<std::string> mrgdata;
 
+      local.profile.count(xpr::join_counter::candidate_groups);
+      local.profile.count(xpr::join_counter::candidate_rows,
+                          m.local_data().size());
+
       // project the entry according to the projection list and send it to the
       // lhs
       for (int idx : m.local_data())
         projectData(*rhsVec, idx, sendListRhs));
 
       // send to all potential owners
-      iterator beg = m.remote_data().begin();
-      iterator lim = m.remote_data().end();
-
-      assert(beg != lim);
-      do {
-        int      dest = beg->owner();
-        iterator nxt =
-            std::find_if(beg, lim, [dest](const JoinLeftInfo& el) -> bool {
-              return el.owner() != dest;
-            });
-
-        std::vector<int> indices;
-
-        std::transform(
-            beg, nxt, std::back_inserter(indices),
-            [](const JoinLeftInfo& el) -> int { return el.index(); });
-
-        commJoinData(world, beg->owner(), indices, mrgdata);
-
-        beg = nxt;
-      } while (beg != lim);
-    }
-
-    // free up space
-    local.mergeCandidates.clear();
+      assert(!m.remote_data().empty());
+      xpr::for_each_lhs_owner(
+          m, [&](int dest, const std::vector<int>& indices) -> void {
+            commJoinData(world, dest, indices, mrgdata);
+          });
+    });
 
     world.barrier();
 
@@ -789,6 +711,7 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
         makeDataFrame(false /* existing */, outLoc, outKey);
 
     outVec->clear();
+    local.profile.phase("join");
 
     // phase 4:
     //   process the join data and perform the actual joins
@@ -814,13 +737,26 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
 
     // done
 
-    const int totalMerged = world.all_reduce_sum(outVec.size());
+    local.profile.count(xpr::join_counter::result_rows, outVec.size());
+
+    const int  totalMerged   = world.all_reduce_sum(outVec.size());
+    bj::object profileReport = local.profile.report(world);
 
     if (world.rank() == 0) {
       std::stringstream msg;
 
       msg << "joined " << totalMerged << " records." << std::endl;
-      clip.to_return(msg.str());
+
+      if (local.profile.enabled()) {
+        bj::object res;
+
+        res["message"]   = msg.str();
+        res["count"]     = totalMerged;
+        res[ARG_PROFILE] = std::move(profileReport);
+        clip.to_return(std::move(res));
+      } else {
+        clip.to_return(msg.str());
+      }
     }
   } catch (const std::exception& err) {
     error_code = 1;
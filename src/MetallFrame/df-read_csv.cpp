@@ -0,0 +1,141 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the typed import of csv files
+///        based on the distributed YGM line parser.
+
+#include "df-common.hpp"
+#include "experimental/json-io.hpp"
+#include "../MetallJsonLines/MetallJsonLines-csv.hpp"
+
+#include <ygm/io/line_parser.hpp>
+
+namespace xpr = experimental;
+
+namespace {
+const std::string ARG_IMPORTED = "CSV file";
+const std::string ARG_COLUMNS  = "columns";
+const std::string ARG_HEADER   = "header";
+const std::string METHOD_NAME  = "read_csv";
+
+using ColumnDescription = std::pair<std::string, std::string>;
+
+/// sets the cell \ref cell of row \ref rec
+void setCell(boost::json::object& rec, const xpr::csv_cell& cell,
+             boost::json::string_view name) {
+  switch (cell.type) {
+    case xpr::csv_type::null:
+      rec.erase(name);
+      return;
+    case xpr::csv_type::string: {
+      boost::json::value& val = rec[name];
+
+      // reuses the buffer of the previous row's string
+      if (!val.is_string()) val.emplace_string();
+
+      val.as_string().assign(cell.s.data(), cell.s.size());
+      return;
+    }
+    case xpr::csv_type::int64:
+      rec[name] = cell.i;
+      return;
+    case xpr::csv_type::uint64:
+      rec[name] = cell.u;
+      return;
+    case xpr::csv_type::real:
+      rec[name] = cell.d;
+      return;
+    case xpr::csv_type::boolean:
+      rec[name] = cell.b;
+      return;
+    default:;  // skipped column
+  }
+}
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{
+      METHOD_NAME, "Imports CSV Data from files into the MetallFrame object."};
+
+  clip.member_of(CLASS_NAME, "A " + CLASS_NAME + " class");
+
+  clip.add_required<std::vector<std::string> >(ARG_IMPORTED,
+                                               "CSV files to be ingested.");
+  clip.add_required<std::vector<ColumnDescription> >(
+      ARG_COLUMNS,
+      "Column description (pair of string/string describing name and type of "
+      "the fields of a line)."
+      "\n  Valid types in (string | int | uint | real | bool | auto | skip).");
+  clip.add_optional<bool>(ARG_HEADER, "Skip lines listing the column names.",
+                          false);
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  clip.add_required_state<std::string>(ST_METALLFRAME_NAME, "Metallframe2 key");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    std::vector<std::string> files =
+        clip.get<std::vector<std::string> >(ARG_IMPORTED);
+    std::string location = clip.get_state<std::string>(ST_METALL_LOCATION);
+    std::string key      = clip.get_state<std::string>(ST_METALLFRAME_NAME);
+    std::unique_ptr<xpr::DataFrame> dfp =
+        makeDataFrame(false /* existing */, location, key);
+    const xpr::csv_format format = xpr::csv_format::of(
+        clip.get<std::vector<ColumnDescription> >(ARG_COLUMNS), ',',
+        clip.get<bool>(ARG_HEADER));
+
+    ygm::io::line_parser lineParser{world, files};
+    xpr::csv_line_parser csvParser{format};
+    boost::json::value   record;
+    boost::json::object& rec         = record.emplace_object();
+    std::size_t          imported    = 0;
+    std::size_t          rejected    = 0;
+    const std::size_t    initialSize = dfp->rows();
+
+    // the record is reused for all rows, so that only its values change.
+    lineParser.for_all([&](const std::string& line) {
+      if (!csvParser.parse(line)) {
+        rejected += !csvParser.is_header();
+        return;
+      }
+
+      const std::vector<xpr::csv_cell>& row = csvParser.row();
+
+      for (std::size_t c = 0; c < row.size(); ++c) {
+        const std::string& name = format.columns[c].name;
+
+        setCell(rec, row[c], {name.data(), name.size()});
+      }
+
+      importJson(*dfp, record);
+      ++imported;
+    });
+
+    assert(dfp->rows() == initialSize + imported);
+
+    // not necessary here, but common to finish processing all messages
+    world.barrier();
+
+    const std::size_t totalImported = world.all_reduce_sum(imported);
+    const std::size_t totalRejected = world.all_reduce_sum(rejected);
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << totalImported << " rows imported, " << totalRejected
+          << " rejected" << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
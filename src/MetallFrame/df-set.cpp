@@ -59,27 +59,23 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
     xpr::DataFrame&           dataset  = *dfp;
     const xpr::ColumnVariant& colaccess =
         dfp->get_column_variant_std(columnName);
+    ColumnLookup columns{rank};
+
+    columns.addVars(dataset, vars);
+
     auto updateFn = [&dataset, &updCount, &ast, &colaccess,
-                     rank](std::int64_t row) -> void {
+                     &columns](std::int64_t row) -> void {
       ++updCount;
 
       const std::int64_t selLen = (SELECTOR.size() + 1);
 
-      auto varLookup = [&dataset, selLen, row, rank](
+      auto varLookup = [&columns, selLen, row](
                            const boost::json::string& colname,
                            int) -> json_logic::ValueExpr {
         // \todo match selector instead of skipping it
         std::string_view col{colname.begin() + selLen, colname.size() - selLen};
 
-        try {
-          return toValueExpr(dataset.get_cell_variant(row, col));
-        } catch (const experimental::unknown_column_error&) {
-          if (col == "rowid") return json_logic::toValueExpr(row);
-          if (col == "mpiid")
-            return json_logic::toValueExpr(std::int64_t(rank));
-
-          return json_logic::toValueExpr(nullptr);
-        }
+        return columns(col, row);
       };
 
       jl::ValueExpr exp = jl::calculate(ast, varLookup);
@@ -0,0 +1,174 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <ygm/comm.hpp>
+
+#include "MetallGraph-csr.hpp"
+
+/// message combining for the edge passes of the graph algorithms: instead
+///   of one message per edge, the updates of a pass are reduced per target
+///   vertex on the sending rank (e.g., summed degree increments, or the
+///   minimum label), and sent as one batch per destination rank.
+/// \details
+///   most edges of skewed graphs end in a few hub vertices, thus combining
+///   reduces the messages to at most one update per (rank, target vertex)
+///   and pass.
+namespace experimental {
+
+/// the number of pending vertices per destination rank, after which the
+///   updates for that rank are sent
+static constexpr std::size_t DEFAULT_COMBINER_BATCH = std::size_t(1) << 16;
+
+/// combines the updates of vertices and sends them in batches to the
+///   vertex owners.
+/// \tparam Value the type of an update
+/// \tparam Combine a functor Value(Value, Value) that reduces two updates
+///         of the same vertex
+/// \tparam Apply a captureless functor void(vertex_id, const Value&) that
+///         applies an update on the vertex owner
+/// \note the updates are applied when they are sent (local vertices) or
+///       received; all updates have arrived after flush and a barrier.
+template <class Value, class Combine, class Apply>
+class vertex_combiner {
+  static_assert(std::is_empty_v<Apply>,
+                "Apply runs on the owner ranks and must not capture state");
+
+ public:
+  vertex_combiner(ygm::comm& comm, const csr_view& g, Combine op, Apply,
+                  std::size_t batchSize = DEFAULT_COMBINER_BATCH)
+      : world(&comm),
+        graph(&g),
+        combine(std::move(op)),
+        pending(comm.size()),
+        batch(std::max<std::size_t>(batchSize, 1)) {}
+
+  ~vertex_combiner() { assert(empty()); }
+
+  vertex_combiner(const vertex_combiner&)            = delete;
+  vertex_combiner& operator=(const vertex_combiner&) = delete;
+
+  /// adds update \ref val of vertex \ref v
+  void add(vertex_id v, const Value& val) {
+    const int dest    = graph->owner(v);
+    auto&     updates = pending[dest];
+    auto [pos, fresh] = updates.try_emplace(v, val);
+
+    if (!fresh) pos->second = combine(pos->second, val);
+
+    ++numUpdates;
+
+    if (updates.size() >= batch) send(dest);
+  }
+
+  /// sends all pending updates
+  void flush() {
+    for (int dest = 0; dest < int(pending.size()); ++dest) send(dest);
+  }
+
+  /// returns true, if no updates are pending
+  bool empty() const {
+    return std::all_of(pending.begin(), pending.end(),
+                       [](const auto& el) -> bool { return el.empty(); });
+  }
+
+  /// returns the number of added updates
+  std::size_t updates() const { return numUpdates; }
+
+  /// returns the number of combined updates that were sent or applied
+  std::size_t combined() const { return numCombined; }
+
+ private:
+  void send(int dest) {
+    auto& updates = pending[dest];
+
+    if (updates.empty()) return;
+
+    numCombined += updates.size();
+
+    if (dest == world->rank()) {
+      for (const auto& [v, val] : updates) Apply{}(v, val);
+
+      updates.clear();
+      return;
+    }
+
+    std::vector<vertex_id> vertices;
+    std::vector<Value>     values;
+
+    vertices.reserve(updates.size());
+    values.reserve(updates.size());
+
+    for (const auto& [v, val] : updates) {
+      vertices.push_back(v);
+      values.push_back(val);
+    }
+
+    updates.clear();
+
+    world->async(
+        dest,
+        [](const std::vector<vertex_id>& vertices,
+           const std::vector<Value>&     values) -> void {
+          for (std::size_t i = 0; i < vertices.size(); ++i)
+            Apply{}(vertices[i], values[i]);
+        },
+        vertices, values);
+  }
+
+  ygm::comm*                                        world;
+  const csr_view*                                   graph;
+  Combine                                           combine;
+  std::vector<std::unordered_map<vertex_id, Value>> pending;
+  std::size_t                                       batch;
+  std::size_t                                       numUpdates  = 0;
+  std::size_t                                       numCombined = 0;
+};
+
+/// returns a combiner for updates of type \ref Value
+template <class Value, class Combine, class Apply>
+vertex_combiner<Value, Combine, Apply> make_vertex_combiner(
+    ygm::comm& comm, const csr_view& g, Combine op, Apply apply,
+    std::size_t batchSize = DEFAULT_COMBINER_BATCH) {
+  return {comm, g, std::move(op), apply, batchSize};
+}
+
+/// keeps the smaller of two updates (e.g., labels)
+struct min_update {
+  template <class T>
+  T operator()(const T& lhs, const T& rhs) const {
+    return std::min(lhs, rhs);
+  }
+};
+
+/// keeps the larger of two updates
+struct max_update {
+  template <class T>
+  T operator()(const T& lhs, const T& rhs) const {
+    return std::max(lhs, rhs);
+  }
+};
+
+/// adds two updates (e.g., degree increments, or pushed mass)
+struct sum_update {
+  template <class T>
+  T operator()(const T& lhs, const T& rhs) const {
+    return lhs + rhs;
+  }
+};
+
+/// keeps the first of two updates (e.g., visits)
+struct first_update {
+  template <class T>
+  T operator()(const T& lhs, const T&) const {
+    return lhs;
+  }
+};
+
+}  // namespace experimental
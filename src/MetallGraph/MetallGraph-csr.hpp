@@ -0,0 +1,587 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+#include <ygm/comm.hpp>
+
+#include "MetallJsonLines-hash.hpp"
+
+/// a distributed compressed-sparse-row (CSR) index of a graph, in which
+///   vertices are dense 64-bit ids. The graph algorithms run over the ids
+///   instead of building string-keyed adjacency maps.
+/// \details
+///   a vertex is owned by the rank that the hash of its key text maps to
+///   (vertex_key_owner). The ids of rank r are the range
+///   [rankOffsets[r], rankOffsets[r+1]); the owner numbers its vertices in
+///   the order of their keys, thus the sorted key texts are also the
+///   string->id dictionary. The owner stores the vertex' out-edges and
+///   in-edges as lists of target ids. Edges whose endpoints are not
+///   vertices are not part of the index. In addition, each rank maps its
+///   node rows to vertex ids (rowVertex), so that results can be written
+///   back to the rows.
+namespace experimental {
+
+using vertex_id = std::uint64_t;
+
+/// the id of rows that are not a vertex (e.g., not selected, no key)
+static constexpr vertex_id no_vertex = std::numeric_limits<vertex_id>::max();
+
+/// returns the rank that owns the vertex with key text \ref key
+inline int vertex_key_owner(std::string_view key, int numranks) {
+  return stable_string_hash(key) % numranks;
+}
+
+/// the fixed-size code of a vertex key text, which build_csr sends instead
+///   of the text: the hash selects the owner (as vertex_key_owner), and the
+///   owner finds the vertex by the hash and the check, a hash with another
+///   seed. Thus, an endpoint that is not a vertex matches a vertex only if
+///   both hashes collide.
+struct vertex_key_code {
+  static constexpr std::uint64_t CHECK_SEED = 0x6a09e667f3bcc908ull;
+
+  static vertex_key_code of(std::string_view key) {
+    return {stable_string_hash(key), stable_string_hash(key, CHECK_SEED)};
+  }
+
+  int owner(int numranks) const { return hash % numranks; }
+
+  auto operator<=>(const vertex_key_code&) const = default;
+
+  std::uint64_t hash  = 0;
+  std::uint64_t check = 0;
+};
+
+/// the arrays of a rank's part of the index
+/// \tparam Vector a vector of std::uint64_t
+/// \tparam String a string
+template <class Vector, class String>
+struct csr_parts {
+  template <class... Alloc>
+  explicit csr_parts(const Alloc&... alloc)
+      : rankOffsets(alloc...),
+        rowVertex(alloc...),
+        keyOffsets(alloc...),
+        keyChars(alloc...),
+        outOffsets(alloc...),
+        outTargets(alloc...),
+        inOffsets(alloc...),
+        inTargets(alloc...) {}
+
+  Vector rankOffsets;  ///< numranks+1 prefix sums of the vertex counts
+  Vector rowVertex;    ///< node row -> vertex id, or no_vertex
+  Vector keyOffsets;   ///< local vertex -> begin of its key in keyChars
+  String keyChars;     ///< the key texts of the local vertices, in order
+  Vector outOffsets;   ///< local vertex -> begin of its out-edges
+  Vector outTargets;   ///< the targets of the out-edges
+  Vector inOffsets;    ///< local vertex -> begin of its in-edges
+  Vector inTargets;    ///< the sources of the in-edges
+
+  /// replaces the arrays by the arrays of \ref other
+  template <class Parts>
+  void assign(const Parts& other) {
+    rankOffsets.assign(other.rankOffsets.begin(), other.rankOffsets.end());
+    rowVertex.assign(other.rowVertex.begin(), other.rowVertex.end());
+    keyOffsets.assign(other.keyOffsets.begin(), other.keyOffsets.end());
+    keyChars.assign(other.keyChars.data(), other.keyChars.size());
+    outOffsets.assign(other.outOffsets.begin(), other.outOffsets.end());
+    outTargets.assign(other.outTargets.begin(), other.outTargets.end());
+    inOffsets.assign(other.inOffsets.begin(), other.inOffsets.end());
+    inTargets.assign(other.inTargets.begin(), other.inTargets.end());
+  }
+
+  void clear() {
+    rankOffsets.clear();
+    rowVertex.clear();
+    keyOffsets.clear();
+    keyChars.clear();
+    outOffsets.clear();
+    outTargets.clear();
+    inOffsets.clear();
+    inTargets.clear();
+  }
+};
+
+/// an index in DRAM, e.g., for a selection of the edges
+using csr_buffer = csr_parts<std::vector<std::uint64_t>, std::string>;
+
+/// identifies the state of the node and edge rows that an index was built
+///   from; an index is stale when the rows were modified since.
+struct csr_stamp {
+  std::uint64_t nodeRows = 0;
+  std::uint64_t nodeMods = 0;
+  std::uint64_t edgeRows = 0;
+  std::uint64_t edgeMods = 0;
+
+  bool operator==(const csr_stamp&) const = default;
+};
+
+/// the persistent index of a rank; stored next to the node and edge
+///   containers in the same Metall datastore.
+template <class Alloc>
+class csr_store {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+ public:
+  using vector_type =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+  using parts_type = csr_parts<vector_type, string_type>;
+
+  explicit csr_store(const allocator_type& alloc) : arrays(alloc) {}
+
+  /// returns true, if the index was built from rows in state \ref st
+  bool current(const csr_stamp& st) const { return valid && (stamp == st); }
+
+  /// stores \ref index, built from rows in state \ref st
+  void assign(const csr_buffer& index, const csr_stamp& st) {
+    arrays.assign(index);
+    stamp = st;
+    valid = true;
+  }
+
+  /// drops the index
+  void clear() {
+    arrays.clear();
+    valid = false;
+  }
+
+  const parts_type& parts() const { return arrays; }
+
+ private:
+  parts_type arrays;
+  csr_stamp  stamp;
+  bool       valid = false;
+};
+
+/// a read-only view of a rank's part of an index
+class csr_view {
+ public:
+  using span_type = std::span<const std::uint64_t>;
+
+  csr_view() = default;
+
+  template <class Parts>
+  csr_view(const Parts& parts, int rank)
+      : rankOffsets(parts.rankOffsets.data(), parts.rankOffsets.size()),
+        rowVertex(parts.rowVertex.data(), parts.rowVertex.size()),
+        keyOffsets(parts.keyOffsets.data(), parts.keyOffsets.size()),
+        keyChars(parts.keyChars.data(), parts.keyChars.size()),
+        outOffsets(parts.outOffsets.data(), parts.outOffsets.size()),
+        outTargets(parts.outTargets.data(), parts.outTargets.size()),
+        inOffsets(parts.inOffsets.data(), parts.inOffsets.size()),
+        inTargets(parts.inTargets.data(), parts.inTargets.size()),
+        self(rank) {
+    assert(rankOffsets.size() > std::size_t(self + 1));
+  }
+
+  /// returns the number of vertices on all ranks
+  std::uint64_t num_vertices() const { return rankOffsets.back(); }
+
+  /// returns the number of vertices of this rank
+  std::size_t num_local() const {
+    return rankOffsets[self + 1] - rankOffsets[self];
+  }
+
+  /// returns the number of node rows of this rank
+  std::size_t num_rows() const { return rowVertex.size(); }
+
+  /// returns the id of local vertex \ref i
+  vertex_id global_id(std::size_t i) const { return rankOffsets[self] + i; }
+
+  /// returns the local index of vertex \ref v, which must be local
+  std::size_t local_index(vertex_id v) const {
+    assert(owner(v) == self);
+    return v - rankOffsets[self];
+  }
+
+  /// returns the rank that owns vertex \ref v
+  int owner(vertex_id v) const {
+    return std::upper_bound(rankOffsets.begin(), rankOffsets.end(), v) -
+           rankOffsets.begin() - 1;
+  }
+
+  /// returns the ids of the targets of local vertex \ref i's out-edges
+  span_type out(std::size_t i) const {
+    return outTargets.subspan(outOffsets[i], outOffsets[i + 1] - outOffsets[i]);
+  }
+
+  /// returns the ids of the sources of local vertex \ref i's in-edges
+  span_type in(std::size_t i) const {
+    return inTargets.subspan(inOffsets[i], inOffsets[i + 1] - inOffsets[i]);
+  }
+
+  /// returns the key text of local vertex \ref i
+  std::string_view key(std::size_t i) const {
+    return keyChars.substr(keyOffsets[i], keyOffsets[i + 1] - keyOffsets[i]);
+  }
+
+  /// returns the id of the local vertex with key text \ref k, or no_vertex.
+  ///   Use vertex_key_owner to find the rank that must be asked.
+  vertex_id find_local(std::string_view k) const {
+    std::size_t lo = 0;
+    std::size_t hi = num_local();
+
+    while (lo < hi) {
+      const std::size_t mid = lo + (hi - lo) / 2;
+
+      if (key(mid) < k)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+
+    return (lo < num_local()) && (key(lo) == k) ? global_id(lo) : no_vertex;
+  }
+
+  /// returns the vertex of node row \ref row
+  vertex_id row_vertex(std::size_t row) const { return rowVertex[row]; }
+
+ private:
+  span_type        rankOffsets;
+  span_type        rowVertex;
+  span_type        keyOffsets;
+  std::string_view keyChars;
+  span_type        outOffsets;
+  span_type        outTargets;
+  span_type        inOffsets;
+  span_type        inTargets;
+  int              self = 0;
+};
+
+/// computes the distinct neighbors of the local vertices of \ref g in
+///   both directions as CSR: the sorted neighbors of local vertex i are
+///   nbrs[offsets[i], offsets[i+1]).
+/// \param selfLoops if true, a vertex with a self loop is its own neighbor
+inline void distinct_neighbors(const csr_view&           g,
+                               std::vector<std::size_t>& offsets,
+                               std::vector<vertex_id>&   nbrs,
+                               bool                      selfLoops = false) {
+  const std::size_t n = g.num_local();
+
+  offsets.assign(1, 0);
+  nbrs.clear();
+
+  for (std::size_t i = 0; i < n; ++i) {
+    const std::size_t beg = nbrs.size();
+
+    for (csr_view::span_type adj : {g.out(i), g.in(i)})
+      for (vertex_id neighbor : adj)
+        if (selfLoops || (neighbor != g.global_id(i)))
+          nbrs.push_back(neighbor);
+
+    std::sort(nbrs.begin() + beg, nbrs.end());
+    nbrs.erase(std::unique(nbrs.begin() + beg, nbrs.end()), nbrs.end());
+    offsets.push_back(nbrs.size());
+  }
+}
+
+namespace {
+/// the per-rank state while an index is built
+struct csr_build_mg {
+  struct pending_key {
+    std::string key;
+    int         rank;
+    std::size_t row;
+
+    bool operator<(const pending_key& rhs) const {
+      return std::tie(key, rank, row) < std::tie(rhs.key, rhs.rank, rhs.row);
+    }
+  };
+
+  explicit csr_build_mg(ygm::comm& comm, std::size_t numrows) : world(&comm) {
+    index.rowVertex.resize(numrows, no_vertex);
+  }
+
+  /// returns the id of the local vertex with key text \ref key, or no_vertex
+  vertex_id find_local(std::string_view key) const {
+    auto pos = std::lower_bound(localKeys.begin(), localKeys.end(), key);
+
+    if ((pos == localKeys.end()) || (*pos != key)) return no_vertex;
+
+    return index.rankOffsets[world->rank()] + (pos - localKeys.begin());
+  }
+
+  /// returns the id of the local vertex with key code \ref code, or
+  ///   no_vertex
+  vertex_id find_local(vertex_key_code code) const {
+    auto pos = std::lower_bound(
+        localCodes.begin(), localCodes.end(), code,
+        [](const std::pair<vertex_key_code, vertex_id>& el,
+           const vertex_key_code& val) -> bool { return el.first < val; });
+
+    if ((pos == localCodes.end()) || (pos->first != code)) return no_vertex;
+
+    return pos->second;
+  }
+
+  /// builds localCodes from localKeys
+  /// \return false, if two local keys have the same code
+  bool index_codes() {
+    const vertex_id first = index.rankOffsets[world->rank()];
+
+    localCodes.reserve(localKeys.size());
+
+    for (std::size_t i = 0; i < localKeys.size(); ++i)
+      localCodes.emplace_back(vertex_key_code::of(localKeys[i]), first + i);
+
+    std::sort(localCodes.begin(), localCodes.end());
+
+    return std::adjacent_find(
+               localCodes.begin(), localCodes.end(),
+               [](const auto& lhs, const auto& rhs) -> bool {
+                 return lhs.first == rhs.first;
+               }) == localCodes.end();
+  }
+
+  ygm::comm*               world;
+  std::vector<pending_key> pending;
+  std::vector<std::string> localKeys;
+  std::vector<std::pair<vertex_key_code, vertex_id>> localCodes;
+  std::vector<std::pair<std::uint64_t, vertex_id>> outEdges;
+  std::vector<std::pair<std::uint64_t, vertex_id>> inEdges;
+  csr_buffer                                       index;
+
+  static csr_build_mg* ptr;
+};
+
+csr_build_mg* csr_build_mg::ptr = nullptr;
+
+/// returns the offsets and targets of the CSR of \ref edges, which are
+///   (local source, target) pairs of a rank with \ref numvertices vertices.
+void make_csr(std::vector<std::pair<std::uint64_t, vertex_id>>& edges,
+              std::size_t numvertices, std::vector<std::uint64_t>& offsets,
+              std::vector<std::uint64_t>& targets) {
+  std::sort(edges.begin(), edges.end());
+
+  offsets.assign(numvertices + 1, 0);
+  targets.clear();
+  targets.reserve(edges.size());
+
+  for (const auto& el : edges) {
+    ++offsets[el.first + 1];
+    targets.push_back(el.second);
+  }
+
+  for (std::size_t i = 0; i < numvertices; ++i) offsets[i + 1] += offsets[i];
+
+  std::vector<std::pair<std::uint64_t, vertex_id>>().swap(edges);
+}
+
+/// target owner: records the in-edge and tells the source owner
+/// \param tgtkey the key text or the key code of the target
+template <class Key>
+void csr_target_edge(const Key& tgtkey, vertex_id src) {
+  csr_build_mg&   state = *csr_build_mg::ptr;
+  const vertex_id tgt   = state.find_local(tgtkey);
+
+  if (tgt == no_vertex) return;
+
+  const int self = state.world->rank();
+
+  state.inEdges.emplace_back(tgt - state.index.rankOffsets[self], src);
+
+  const auto& offsets = state.index.rankOffsets;
+  const int   dest    = std::upper_bound(offsets.begin(), offsets.end(), src) -
+                   offsets.begin() - 1;
+
+  state.world->async(
+      dest,
+      [](vertex_id src, vertex_id tgt) -> void {
+        csr_build_mg& state = *csr_build_mg::ptr;
+        const int     self  = state.world->rank();
+
+        state.outEdges.emplace_back(src - state.index.rankOffsets[self], tgt);
+      },
+      src, tgt);
+}
+}  // namespace
+
+/// builds the index of a graph. Collective.
+/// \param numrows the number of node rows of this rank
+/// \param forEachVertex calls a functor fn(row, key) for each selected node
+///        row of this rank with the row's key text
+/// \param forEachEdge calls a functor fn(srckey, tgtkey) for each selected
+///        edge row of this rank with the key texts of the endpoints
+/// \details
+///   rows with the same key are mapped to the same vertex.
+template <class ForEachVertex, class ForEachEdge>
+csr_buffer build_csr(ygm::comm& world, std::size_t numrows,
+                     ForEachVertex forEachVertex, ForEachEdge forEachEdge) {
+  assert(csr_build_mg::ptr == nullptr);
+
+  std::unique_ptr<csr_build_mg> state =
+      std::make_unique<csr_build_mg>(world, numrows);
+
+  csr_build_mg::ptr = state.get();
+
+  struct reset_ptr {
+    ~reset_ptr() { csr_build_mg::ptr = nullptr; }
+  } resetGuard;
+
+  const int rank     = world.rank();
+  const int numranks = world.size();
+
+  // (1) register the vertex keys with their owners
+  world.barrier();
+  forEachVertex([&world, rank, numranks](std::size_t row,
+                                         const std::string& key) -> void {
+    world.async(
+        vertex_key_owner(key, numranks),
+        [](const std::string& key, int rank, std::size_t row) -> void {
+          csr_build_mg::ptr->pending.push_back({key, rank, row});
+        },
+        key, rank, row);
+  });
+  world.barrier();
+
+  // (2) number the local vertices in key order and tell the rows their ids
+  std::sort(state->pending.begin(), state->pending.end());
+
+  for (const csr_build_mg::pending_key& el : state->pending)
+    if (state->localKeys.empty() || (state->localKeys.back() != el.key))
+      state->localKeys.push_back(el.key);
+
+  {
+    std::vector<std::size_t> counts(numranks, 0);
+
+    counts[rank] = state->localKeys.size();
+    counts       = world.all_reduce(
+        counts,
+        [](const std::vector<std::size_t>& lhs,
+           const std::vector<std::size_t>& rhs) -> std::vector<std::size_t> {
+          std::vector<std::size_t> res{lhs};
+
+          for (std::size_t i = 0; i < rhs.size(); ++i) res[i] += rhs[i];
+
+          return res;
+        });
+
+    csr_buffer& index = state->index;
+
+    index.rankOffsets.assign(numranks + 1, 0);
+
+    for (int i = 0; i < numranks; ++i)
+      index.rankOffsets[i + 1] = index.rankOffsets[i] + counts[i];
+
+    index.keyOffsets.reserve(state->localKeys.size() + 1);
+    index.keyOffsets.push_back(0);
+
+    for (const std::string& key : state->localKeys) {
+      index.keyChars.append(key);
+      index.keyOffsets.push_back(index.keyChars.size());
+    }
+  }
+
+  for (const csr_build_mg::pending_key& el : state->pending) {
+    world.async(
+        el.rank,
+        [](std::size_t row, vertex_id v) -> void {
+          csr_build_mg::ptr->index.rowVertex[row] = v;
+        },
+        el.row, state->find_local(el.key));
+  }
+
+  std::vector<csr_build_mg::pending_key>().swap(state->pending);
+
+  // the key codes are only used if they are unique
+  const bool useCodes =
+      world.all_reduce_sum(std::size_t(!state->index_codes())) == 0;
+
+  world.barrier();
+
+  // (3) resolve the endpoints of the edges: the source owner looks up the
+  //     source, the target owner the target. Then both sides record the
+  //     edge. The endpoints are sent as key codes (two words each) instead
+  //     of key texts, unless two vertices have the same code.
+  if (useCodes) {
+    forEachEdge([&world, numranks](const std::string& srckey,
+                                   const std::string& tgtkey) -> void {
+      const vertex_key_code src = vertex_key_code::of(srckey);
+      const vertex_key_code tgt = vertex_key_code::of(tgtkey);
+
+      world.async(
+          src.owner(numranks),
+          [](std::uint64_t srchash, std::uint64_t srccheck,
+             std::uint64_t tgthash, std::uint64_t tgtcheck) -> void {
+            csr_build_mg&         state = *csr_build_mg::ptr;
+            const vertex_key_code tgt{tgthash, tgtcheck};
+            const vertex_id       src = state.find_local(
+                vertex_key_code{srchash, srccheck});
+
+            if (src == no_vertex) return;
+
+            const int dest = tgt.owner(state.world->size());
+
+            if (dest == state.world->rank()) return csr_target_edge(tgt, src);
+
+            state.world->async(
+                dest,
+                [](std::uint64_t tgthash, std::uint64_t tgtcheck,
+                   vertex_id src) -> void {
+                  csr_target_edge(vertex_key_code{tgthash, tgtcheck}, src);
+                },
+                tgt.hash, tgt.check, src);
+          },
+          src.hash, src.check, tgt.hash, tgt.check);
+    });
+  } else {
+    forEachEdge([&world, numranks](const std::string& srckey,
+                                   const std::string& tgtkey) -> void {
+      world.async(
+          vertex_key_owner(srckey, numranks),
+          [](const std::string& srckey, const std::string& tgtkey) -> void {
+            csr_build_mg&   state = *csr_build_mg::ptr;
+            const vertex_id src   = state.find_local(srckey);
+
+            if (src == no_vertex) return;
+
+            const int dest = vertex_key_owner(tgtkey, state.world->size());
+
+            if (dest == state.world->rank())
+              return csr_target_edge(tgtkey, src);
+
+            state.world->async(
+                dest,
+                [](const std::string& tgtkey, vertex_id src) -> void {
+                  csr_target_edge(tgtkey, src);
+                },
+                tgtkey, src);
+          },
+          srckey, tgtkey);
+    });
+  }
+
+  world.barrier();
+
+  // (4) assemble the CSR arrays
+  csr_buffer&       index       = state->index;
+  const std::size_t numvertices = state->localKeys.size();
+
+  make_csr(state->outEdges, numvertices, index.outOffsets, index.outTargets);
+  make_csr(state->inEdges, numvertices, index.inOffsets, index.inTargets);
+
+  return std::move(index);
+}
+
+}  // namespace experimental
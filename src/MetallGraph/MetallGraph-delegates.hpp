@@ -0,0 +1,223 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <vector>
+
+#include <ygm/comm.hpp>
+
+#include "MetallGraph-csr.hpp"
+#include "MetallJsonLines-profile.hpp"
+
+/// delegates of high-degree vertices (Pearce et al., Scaling Techniques for
+///   Massive Scale-Free Graphs in Distributed (External) Memory): the
+///   edges of a hub are split evenly over all ranks, instead of being
+///   scanned by the hub's owner alone. The state of the hubs (e.g., in the
+///   frontier, or the pushed share) is replicated on all ranks once per
+///   step, and the updates are reduced back to the owners.
+/// \details
+///   a vertex is a hub if it has at least partition_options::delegateDegree
+///   edges (in + out) in the index. Hubs are few, thus the replicated state
+///   is small. The owner of a hub keeps its edges in the index, but the
+///   algorithms skip them when delegates are enabled.
+namespace experimental {
+
+/// the partitioning of the edge work of an algorithm
+struct partition_options {
+  /// vertices with at least so many edges are delegated; 0 disables
+  ///   delegates
+  std::size_t delegateDegree = 0;
+};
+
+/// the per-rank counters of the graph algorithms
+enum class graph_work_counter : std::size_t {
+  vertices,          ///< local vertices
+  edges_scanned,     ///< edges that this rank scanned
+  updates_sent,      ///< combined vertex updates sent or applied
+  updates_received,  ///< vertex updates applied on this rank
+  delegated_edges    ///< hub edges that this rank scans for the owners
+};
+
+/// returns an enabled profile with the graph_work_counter counters
+inline run_profile make_graph_work_profile() {
+  return run_profile{{"vertices", "edges_scanned", "updates_sent",
+                      "updates_received", "delegated_edges"}};
+}
+
+/// returns the bitwise or of \ref bits over all ranks. Collective.
+inline std::vector<std::uint64_t> all_reduce_or(
+    ygm::comm& world, const std::vector<std::uint64_t>& bits) {
+  return world.all_reduce(
+      bits,
+      [](const std::vector<std::uint64_t>& lhs,
+         const std::vector<std::uint64_t>& rhs) -> std::vector<std::uint64_t> {
+        std::vector<std::uint64_t> res{lhs};
+
+        for (std::size_t i = 0; i < rhs.size(); ++i) res[i] |= rhs[i];
+
+        return res;
+      });
+}
+
+namespace {
+/// the per-rank state while the delegates are built
+struct delegate_build_mg {
+  std::vector<std::vector<vertex_id>> out;  ///< hub -> share of out-edges
+  std::vector<std::vector<vertex_id>> in;   ///< hub -> share of in-edges
+
+  static delegate_build_mg* ptr;
+};
+
+delegate_build_mg* delegate_build_mg::ptr = nullptr;
+}  // namespace
+
+/// the hubs of an index and this rank's share of their edges
+class csr_delegates {
+ public:
+  using span_type = csr_view::span_type;
+
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  /// creates delegates without hubs
+  csr_delegates() = default;
+
+  /// splits the edges of the vertices of \ref g with at least \ref minDegree
+  ///   edges over all ranks; without hubs if \ref minDegree is 0.
+  ///   Collective.
+  csr_delegates(ygm::comm& world, const csr_view& g, std::size_t minDegree) {
+    if (minDegree == 0) return;
+
+    for (std::size_t i = 0; i < g.num_local(); ++i)
+      if (g.out(i).size() + g.in(i).size() >= minDegree)
+        hubs.push_back(g.global_id(i));
+
+    hubs = world.all_reduce(
+        hubs,
+        [](const std::vector<vertex_id>& lhs,
+           const std::vector<vertex_id>& rhs) -> std::vector<vertex_id> {
+          std::vector<vertex_id> res;
+
+          res.reserve(lhs.size() + rhs.size());
+          std::merge(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                     std::back_inserter(res));
+          return res;
+        });
+
+    if (hubs.empty()) return;
+
+    assert(delegate_build_mg::ptr == nullptr);
+
+    delegate_build_mg state{std::vector<std::vector<vertex_id>>(hubs.size()),
+                            std::vector<std::vector<vertex_id>>(hubs.size())};
+
+    delegate_build_mg::ptr = &state;
+
+    struct reset_ptr {
+      ~reset_ptr() { delegate_build_mg::ptr = nullptr; }
+    } resetGuard;
+
+    world.barrier();
+
+    // the owner sends the r-th block of a hub's edges to rank r
+    const int numranks = world.size();
+
+    for (std::size_t h = 0; h < hubs.size(); ++h) {
+      if (g.owner(hubs[h]) != world.rank()) continue;
+
+      const std::size_t i = g.local_index(hubs[h]);
+
+      for (bool outgoing : {true, false}) {
+        const span_type adj = outgoing ? g.out(i) : g.in(i);
+
+        for (int r = 0; r < numranks; ++r) {
+          const std::size_t beg = adj.size() * r / numranks;
+          const std::size_t lim = adj.size() * (r + 1) / numranks;
+
+          if (beg == lim) continue;
+
+          world.async(
+              r,
+              [](std::size_t h, bool outgoing,
+                 const std::vector<vertex_id>& share) -> void {
+                delegate_build_mg& state = *delegate_build_mg::ptr;
+
+                (outgoing ? state.out : state.in)[h] = share;
+              },
+              h, outgoing,
+              std::vector<vertex_id>(adj.begin() + beg, adj.begin() + lim));
+        }
+      }
+    }
+
+    world.barrier();
+
+    flatten(state.out, outOffsets, outTargets);
+    flatten(state.in, inOffsets, inTargets);
+  }
+
+  /// returns the number of hubs
+  std::size_t size() const { return hubs.size(); }
+
+  bool empty() const { return hubs.empty(); }
+
+  /// returns the hub index of vertex \ref v, or npos if it is not a hub
+  std::size_t find(vertex_id v) const {
+    auto pos = std::lower_bound(hubs.begin(), hubs.end(), v);
+
+    return (pos != hubs.end()) && (*pos == v) ? pos - hubs.begin() : npos;
+  }
+
+  /// returns the vertex id of hub \ref h
+  vertex_id hub(std::size_t h) const { return hubs[h]; }
+
+  /// returns this rank's share of the out-edges of hub \ref h
+  span_type out(std::size_t h) const {
+    return span_type{outTargets}.subspan(outOffsets[h],
+                                         outOffsets[h + 1] - outOffsets[h]);
+  }
+
+  /// returns this rank's share of the in-edges of hub \ref h
+  span_type in(std::size_t h) const {
+    return span_type{inTargets}.subspan(inOffsets[h],
+                                        inOffsets[h + 1] - inOffsets[h]);
+  }
+
+  /// returns a bitmap over the hubs with all bits cleared
+  std::vector<std::uint64_t> make_bitmap() const {
+    return std::vector<std::uint64_t>((hubs.size() + 63) / 64, 0);
+  }
+
+ private:
+  static void flatten(std::vector<std::vector<vertex_id>>& shares,
+                      std::vector<std::uint64_t>&          offsets,
+                      std::vector<vertex_id>&              targets) {
+    offsets.assign(1, 0);
+
+    for (std::vector<vertex_id>& share : shares) {
+      targets.insert(targets.end(), share.begin(), share.end());
+      offsets.push_back(targets.size());
+      std::vector<vertex_id>().swap(share);
+    }
+  }
+
+  std::vector<vertex_id>     hubs;  ///< sorted
+  std::vector<std::uint64_t> outOffsets;
+  std::vector<vertex_id>     outTargets;
+  std::vector<std::uint64_t> inOffsets;
+  std::vector<vertex_id>     inTargets;
+};
+
+/// sets bit \ref i of \ref bits
+inline void set_bit(std::vector<std::uint64_t>& bits, std::uint64_t i) {
+  bits[i / 64] |= std::uint64_t(1) << (i % 64);
+}
+
+/// returns bit \ref i of \ref bits
+inline bool test_bit(const std::vector<std::uint64_t>& bits, std::uint64_t i) {
+  return (bits[i / 64] >> (i % 64)) & 1;
+}
+
+}  // namespace experimental
@@ -0,0 +1,160 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Synthetic graph models whose edges are generated by each rank.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "MetallJsonLines-hash.hpp"
+
+namespace experimental {
+
+/// the models of generate_edges
+enum class graph_model {
+  rmat,         ///< R-MAT (Graph500), 2^scale vertices
+  erdos_renyi,  ///< uniformly random endpoints, G(n, m)
+  power_law     ///< Chung-Lu, expected degrees follow a power law
+};
+
+inline graph_model to_graph_model(std::string_view name) {
+  if (name == "rmat") return graph_model::rmat;
+  if (name == "erdos_renyi") return graph_model::erdos_renyi;
+  if (name == "power_law") return graph_model::power_law;
+
+  throw std::invalid_argument{"unknown graph model: " + std::string(name)};
+}
+
+/// the parameters of a generated graph
+struct graph_generator_options {
+  graph_model model = graph_model::rmat;
+
+  /// the graph has 2^scale vertices
+  int scale = 16;
+
+  /// the graph has edgeFactor * 2^scale edges
+  double edgeFactor = 16;
+
+  /// R-MAT: the probabilities of the quadrants (d = 1 - a - b - c)
+  double a = 0.57;
+  double b = 0.19;
+  double c = 0.19;
+
+  /// power_law: the exponent of the degree distribution (> 2)
+  double exponent = 2.1;
+
+  /// if true, the vertex ids are permuted, so that the high-degree
+  ///   vertices of R-MAT and power_law are not the vertices with low ids
+  bool scramble = true;
+
+  std::uint64_t seed = 0;
+
+  std::uint64_t num_vertices() const { return std::uint64_t(1) << scale; }
+
+  std::uint64_t num_edges() const {
+    return std::uint64_t(std::llround(edgeFactor * double(num_vertices())));
+  }
+};
+
+/// returns the range [begin, end) of the \ref total items that \ref rank
+///   generates
+inline std::pair<std::uint64_t, std::uint64_t> generator_share(
+    std::uint64_t total, int rank, int numranks) {
+  const std::uint64_t base = total / numranks;
+  const std::uint64_t rest = total % numranks;
+  const std::uint64_t r    = rank;
+  const std::uint64_t beg  = r * base + std::min(r, rest);
+
+  return {beg, beg + base + (r < rest)};
+}
+
+/// calls fn(src, tgt) for the edges of \ref rank's share of the graph.
+/// \details
+///   each rank draws its edges from its own random stream, so that the
+///   graph only depends on the options and the number of ranks.
+///   The vertex ids are in [0, 2^scale).
+template <class Fn>
+void generate_edges(const graph_generator_options& opts, int rank,
+                    int numranks, Fn fn) {
+  if ((opts.scale < 1) || (opts.scale > 62))
+    throw std::invalid_argument{"graph scale must be in [1, 62]"};
+
+  const std::uint64_t n    = opts.num_vertices();
+  const std::uint64_t mask = n - 1;
+  // an odd factor, i.e., a bijection of [0, n)
+  auto scramble = [&opts, mask](std::uint64_t v) -> std::uint64_t {
+    return opts.scramble ? (v * 0x9E3779B97F4A7C15ull) & mask : v;
+  };
+
+  std::mt19937_64 rng{mix_hash64(opts.seed ^ mix_hash64(rank + 1))};
+  std::uniform_real_distribution<double> uniform;
+  const auto [beg, end] = generator_share(opts.num_edges(), rank, numranks);
+
+  switch (opts.model) {
+    case graph_model::rmat: {
+      const double ab  = opts.a + opts.b;
+      const double abc = ab + opts.c;
+
+      for (std::uint64_t e = beg; e < end; ++e) {
+        std::uint64_t u = 0;
+        std::uint64_t v = 0;
+
+        for (int bit = 0; bit < opts.scale; ++bit) {
+          const double p = uniform(rng);
+
+          u = (u << 1) | (p >= ab);
+          v = (v << 1) | (((p >= opts.a) && (p < ab)) || (p >= abc));
+        }
+
+        fn(scramble(u), scramble(v));
+      }
+
+      break;
+    }
+
+    case graph_model::erdos_renyi: {
+      std::uniform_int_distribution<std::uint64_t> vertex{0, mask};
+
+      for (std::uint64_t e = beg; e < end; ++e) fn(vertex(rng), vertex(rng));
+
+      break;
+    }
+
+    case graph_model::power_law: {
+      if (!(opts.exponent > 2.0))
+        throw std::invalid_argument{"power-law exponent must be > 2"};
+
+      // vertex x has the weight (x + 1)^-alpha; the endpoints are drawn by
+      //   inverting the (continuous) cumulative weight.
+      const double alpha = 1.0 / (opts.exponent - 1.0);
+      const double beta  = 1.0 - alpha;
+      const double range = std::pow(double(n) + 1.0, beta) - 1.0;
+
+      auto vertex = [&]() -> std::uint64_t {
+        const double x = std::pow(1.0 + uniform(rng) * range, 1.0 / beta);
+
+        return std::min(std::uint64_t(x) - 1, mask);
+      };
+
+      for (std::uint64_t e = beg; e < end; ++e) {
+        const std::uint64_t u = vertex();
+
+        fn(scramble(u), scramble(vertex()));
+      }
+
+      break;
+    }
+  }
+}
+
+}  // namespace experimental
@@ -0,0 +1,242 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <ygm/comm.hpp>
+
+#include "MetallJsonLines-job.hpp"
+
+#include "MetallGraph-combine.hpp"
+#include "MetallGraph-csr.hpp"
+
+/// vertex-centric programs (Malewicz et al., Pregel: A System for
+///   Large-Scale Graph Processing) over the CSR index: an algorithm
+///   supplies compute(program, vertex, message), which runs in supersteps
+///   for the active vertices, and the engine delivers the messages,
+///   tracks the active set, and synchronizes the ranks.
+/// \details
+///   the messages to a vertex are reduced by the combiner (e.g.,
+///   sum_update, min_update, or max_update) on the sending rank and on the
+///   owner, thus compute receives at most one message per superstep. A
+///   vertex is active in the next superstep if it receives a message or
+///   calls activate; the program stops when no vertex is active.
+///   Each vertex has a value of type Value, which set_vertex_property of
+///   MetallGraph stores as vertex property after the run.
+namespace experimental {
+
+/// the edges that send_to_neighbors follows
+enum class pregel_edges { out, in, both };
+
+/// runs a vertex program over the selected local vertices of a rank.
+/// \tparam Value the state of a vertex
+/// \tparam Message the type of the messages
+/// \tparam Combine a functor Message(Message, Message) that reduces two
+///         messages to the same vertex
+/// \note one program per (Value, Message, Combine) can exist at a time,
+///       because the message handlers find the program on the receiving
+///       rank through a static pointer.
+template <class Value, class Message, class Combine>
+class vertex_program {
+ public:
+  vertex_program(ygm::comm& comm, const csr_view& g, std::vector<char> sel,
+                 Combine op = {}, pregel_edges dir = pregel_edges::both,
+                 std::size_t batchSize = DEFAULT_COMBINER_BATCH)
+      : world(&comm),
+        graph(&g),
+        combine(op),
+        edges(dir),
+        selected(std::move(sel)),
+        vals(g.num_local()),
+        active(g.num_local(), 0),
+        nextActive(g.num_local(), 0),
+        inbox(g.num_local()),
+        nextInbox(g.num_local()),
+        messages(comm, g, std::move(op), deliver{}, batchSize) {
+    assert(selected.size() == g.num_local());
+    assert(ptr == nullptr);
+
+    ptr = this;
+  }
+
+  ~vertex_program() { ptr = nullptr; }
+
+  vertex_program(const vertex_program&)            = delete;
+  vertex_program& operator=(const vertex_program&) = delete;
+
+  /// the index
+  const csr_view& index() const { return *graph; }
+
+  /// returns true, if local vertex \ref i is part of the program
+  bool is_selected(std::size_t i) const { return selected[i]; }
+
+  /// the value of local vertex \ref i
+  Value&       value(std::size_t i) { return vals[i]; }
+  const Value& value(std::size_t i) const { return vals[i]; }
+
+  /// the values of the local vertices
+  std::vector<Value>&       values() { return vals; }
+  const std::vector<Value>& values() const { return vals; }
+
+  /// lets selected local vertex \ref i compute in the next superstep (or in
+  ///   the first one, when called before run)
+  void activate(std::size_t i) {
+    if (selected[i]) nextActive[i] = 1;
+  }
+
+  /// activates all selected local vertices
+  void activate_all() { nextActive = selected; }
+
+  /// sends \ref msg to vertex \ref v; a message to a vertex that is not
+  ///   selected is dropped.
+  void send(vertex_id v, const Message& msg) { messages.add(v, msg); }
+
+  /// sends \ref msg along the edges of local vertex \ref i
+  void send_to_neighbors(std::size_t i, const Message& msg) {
+    if (edges != pregel_edges::in)
+      for (vertex_id v : graph->out(i)) messages.add(v, msg);
+
+    if (edges != pregel_edges::out)
+      for (vertex_id v : graph->in(i)) messages.add(v, msg);
+  }
+
+  /// the neighbors of local vertex \ref i along the program's edges; the
+  ///   second span is empty, unless the program follows both directions.
+  std::array<csr_view::span_type, 2> neighbors(std::size_t i) const {
+    switch (edges) {
+      case pregel_edges::out: return {graph->out(i), csr_view::span_type{}};
+      case pregel_edges::in: return {graph->in(i), csr_view::span_type{}};
+      default: return {graph->out(i), graph->in(i)};
+    }
+  }
+
+  /// the current superstep
+  std::size_t superstep() const { return step; }
+
+  /// returns the number of messages that were sent
+  std::size_t updates() const { return messages.updates(); }
+
+  /// returns the number of combined messages that were sent or applied
+  std::size_t combined() const { return messages.combined(); }
+
+  /// returns the number of messages that the local vertices received
+  std::size_t received() const { return numReceived; }
+
+  /// runs supersteps until no vertex is active, or \ref maxSupersteps
+  ///   supersteps have run. Collective.
+  /// \param compute a functor void(vertex_program&, std::size_t i,
+  ///        const std::optional<Message>& msg), called for each active
+  ///        local vertex i with the combined message of the last
+  ///        superstep, if any.
+  /// \return the number of supersteps
+  template <class Compute>
+  std::size_t run(Compute compute,
+                  std::size_t maxSupersteps =
+                      std::numeric_limits<std::size_t>::max()) {
+    const std::size_t n = graph->num_local();
+
+    // the other ranks' handlers must find their program
+    world->barrier();
+    start_superstep();
+
+    while (step < maxSupersteps) {
+      const std::size_t numActive = world->all_reduce_sum(
+          std::size_t(std::count(active.begin(), active.end(), 1)));
+
+      if (numActive == 0) break;
+
+      report_progress({{"superstep", step}, {"active", numActive}});
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!active[i]) continue;
+
+        compute(*this, i, inbox[i]);
+      }
+
+      messages.flush();
+      world->barrier();
+
+      ++step;
+      start_superstep();
+    }
+
+    return step;
+  }
+
+  /// returns fn(value) of the selected local vertices (local vertex ->
+  ///   property value), e.g., for set_vertex_property
+  template <class Fn>
+  auto property_values(Fn fn) const {
+    using property_type = std::decay_t<decltype(fn(vals.front()))>;
+
+    std::vector<std::optional<property_type>> res(vals.size());
+
+    for (std::size_t i = 0; i < vals.size(); ++i)
+      if (selected[i]) res[i] = fn(vals[i]);
+
+    return res;
+  }
+
+  /// returns the values of the selected local vertices
+  std::vector<std::optional<Value>> property_values() const {
+    return property_values([](const Value& val) -> Value { return val; });
+  }
+
+ private:
+  /// applies the combined messages on the owner
+  struct deliver {
+    void operator()(vertex_id v, const Message& msg) const {
+      ptr->receive(v, msg);
+    }
+  };
+
+  void receive(vertex_id v, const Message& msg) {
+    const std::size_t j = graph->local_index(v);
+
+    ++numReceived;
+
+    if (!selected[j]) return;
+
+    std::optional<Message>& slot = nextInbox[j];
+
+    slot          = slot ? combine(*slot, msg) : msg;
+    nextActive[j] = 1;
+  }
+
+  /// moves the messages and activations of the last superstep in place
+  void start_superstep() {
+    active.swap(nextActive);
+    inbox.swap(nextInbox);
+    std::fill(nextActive.begin(), nextActive.end(), 0);
+    std::fill(nextInbox.begin(), nextInbox.end(), std::nullopt);
+  }
+
+  ygm::comm*                          world;
+  const csr_view*                     graph;
+  Combine                             combine;
+  pregel_edges                        edges;
+  std::vector<char>                   selected;
+  std::vector<Value>                  vals;
+  std::vector<char>                   active;
+  std::vector<char>                   nextActive;
+  std::vector<std::optional<Message>> inbox;  ///< the last messages
+  std::vector<std::optional<Message>> nextInbox;
+  vertex_combiner<Message, Combine, deliver> messages;
+  std::size_t                                step        = 0;
+  std::size_t                                numReceived = 0;
+
+  static vertex_program* ptr;
+};
+
+template <class Value, class Message, class Combine>
+vertex_program<Value, Message, Combine>*
+    vertex_program<Value, Message, Combine>::ptr = nullptr;
+
+}  // namespace experimental
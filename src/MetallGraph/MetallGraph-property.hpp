@@ -0,0 +1,251 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+/// typed vertex-property columns: the results of the graph algorithms
+///   (e.g., cc, bfs_level, pagerank) are stored as dense arrays aligned to
+///   the node rows of a rank, instead of as fields of the rows' JSON
+///   objects. A run replaces a column as a whole.
+/// \details
+///   a column holds one value per node row and a presence flag. Numbers
+///   are stored as 64-bit words (doubles by their bits). Strings are stored
+///   back to back; the words of a string column are numrows+1 offsets into
+///   the characters. A column is valid as long as the node rows are not
+///   modified (see property_stamp).
+namespace experimental {
+
+enum class property_kind : std::uint8_t { uint64, int64, real, string };
+
+/// returns the kind of a column that stores values of type \ref T
+template <class T>
+constexpr property_kind property_kind_of() {
+  if constexpr (std::is_same_v<T, std::string>)
+    return property_kind::string;
+  else if constexpr (std::is_floating_point_v<T>)
+    return property_kind::real;
+  else if constexpr (std::is_signed_v<T>)
+    return property_kind::int64;
+  else {
+    static_assert(std::is_unsigned_v<T>, "unsupported property type");
+    return property_kind::uint64;
+  }
+}
+
+/// identifies the node rows that a column was computed for
+struct property_stamp {
+  std::uint64_t nodeRows = 0;
+  std::uint64_t nodeMods = 0;
+
+  bool operator==(const property_stamp&) const = default;
+};
+
+/// a column in DRAM while an algorithm writes its results
+/// \tparam T the value type, std::string, a floating point, or an
+///           integral type
+template <class T>
+class property_buffer {
+ public:
+  explicit property_buffer(std::size_t numrows)
+      : values(numrows), present(numrows, 0) {}
+
+  void set(std::size_t row, const T& val) {
+    values[row]  = val;
+    present[row] = 1;
+  }
+
+  std::size_t size() const { return present.size(); }
+
+  /// returns the words of the column
+  std::vector<std::uint64_t> words() const {
+    std::vector<std::uint64_t> res;
+
+    if constexpr (property_kind_of<T>() == property_kind::string) {
+      res.reserve(size() + 1);
+      res.push_back(0);
+
+      for (std::size_t i = 0; i < size(); ++i)
+        res.push_back(res.back() + (present[i] ? values[i].size() : 0));
+    } else {
+      res.reserve(size());
+
+      for (std::size_t i = 0; i < size(); ++i) {
+        std::uint64_t word = 0;
+
+        if (present[i]) {
+          if constexpr (property_kind_of<T>() == property_kind::real) {
+            const double val = values[i];
+
+            std::memcpy(&word, &val, sizeof(word));
+          } else {
+            word = std::uint64_t(values[i]);
+          }
+        }
+
+        res.push_back(word);
+      }
+    }
+
+    return res;
+  }
+
+  /// returns the characters of a string column
+  std::string chars() const {
+    std::string res;
+
+    if constexpr (property_kind_of<T>() == property_kind::string)
+      for (std::size_t i = 0; i < size(); ++i)
+        if (present[i]) res.append(values[i]);
+
+    return res;
+  }
+
+  const std::vector<char>& presence() const { return present; }
+
+ private:
+  std::vector<T>    values;
+  std::vector<char> present;
+};
+
+/// a read-only view of a column
+class property_view {
+ public:
+  using span_type = std::span<const std::uint64_t>;
+
+  property_view(property_kind k, span_type words,
+                std::span<const char> present, std::string_view chars)
+      : knd(k), words(words), present(present), chars(chars) {}
+
+  property_kind kind() const { return knd; }
+
+  std::size_t size() const { return present.size(); }
+
+  /// returns true, if row \ref row has a value
+  bool contains(std::size_t row) const {
+    return (row < present.size()) && present[row];
+  }
+
+  std::uint64_t uint64_at(std::size_t row) const {
+    assert(contains(row) && (knd == property_kind::uint64));
+    return words[row];
+  }
+
+  std::int64_t int64_at(std::size_t row) const {
+    assert(contains(row) && (knd == property_kind::int64));
+    return std::int64_t(words[row]);
+  }
+
+  double real_at(std::size_t row) const {
+    assert(contains(row) && (knd == property_kind::real));
+
+    double res;
+
+    std::memcpy(&res, &words[row], sizeof(res));
+    return res;
+  }
+
+  std::string_view string_at(std::size_t row) const {
+    assert(contains(row) && (knd == property_kind::string));
+    return chars.substr(words[row], words[row + 1] - words[row]);
+  }
+
+  /// returns the value of row \ref row, or null
+  boost::json::value json_at(std::size_t row) const {
+    if (!contains(row)) return nullptr;
+
+    switch (knd) {
+      case property_kind::uint64:
+        return uint64_at(row);
+      case property_kind::int64:
+        return int64_at(row);
+      case property_kind::real:
+        return real_at(row);
+      case property_kind::string: {
+        const std::string_view str = string_at(row);
+
+        return boost::json::string(str.data(), str.size());
+      }
+    }
+
+    return nullptr;
+  }
+
+ private:
+  property_kind         knd;
+  span_type             words;
+  std::span<const char> present;
+  std::string_view      chars;
+};
+
+/// the persistent column of a vertex property on a rank; stored next to
+///   the node and edge containers in the same Metall datastore.
+template <class Alloc>
+class property_column {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+ public:
+  using word_vector =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+  using flag_vector = metall::container::vector<char, other_allocator<char>>;
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+
+  explicit property_column(const allocator_type& alloc)
+      : words(alloc), present(alloc), chars(alloc) {}
+
+  /// returns true, if the column was computed for rows in state \ref st
+  bool current(const property_stamp& st) const {
+    return valid && (stamp == st);
+  }
+
+  /// replaces the column by \ref buf, computed for rows in state \ref st
+  template <class T>
+  void assign(const property_buffer<T>& buf, const property_stamp& st) {
+    const std::vector<std::uint64_t> bufwords = buf.words();
+    const std::string                bufchars = buf.chars();
+
+    valid = false;
+    knd   = property_kind_of<T>();
+    words.assign(bufwords.begin(), bufwords.end());
+    present.assign(buf.presence().begin(), buf.presence().end());
+    chars.assign(bufchars.data(), bufchars.size());
+    stamp = st;
+    valid = true;
+  }
+
+  property_view view() const {
+    return {knd,
+            {words.data(), words.size()},
+            {present.data(), present.size()},
+            {chars.data(), chars.size()}};
+  }
+
+ private:
+  word_vector    words;
+  flag_vector    present;
+  string_type    chars;
+  property_kind  knd = property_kind::uint64;
+  property_stamp stamp;
+  bool           valid = false;
+};
+
+}  // namespace experimental
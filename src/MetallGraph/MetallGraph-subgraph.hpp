@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <metall/container/vector.hpp>
+
+#include "MetallGraph-csr.hpp"
+
+/// persistent subgraph views: a named selection of node and edge rows,
+///   stored as bitmaps over the rows of the node and edge lists, with the
+///   index of the selected subgraph. The rows are not copied; algorithms
+///   on a subgraph use its index instead of filtering the rows and
+///   building a transient index.
+/// \details
+///   the index has the selected vertices and the selected edges between
+///   them. As the persistent index, a subgraph becomes stale when the node
+///   or edge rows are modified, until it is created again.
+namespace experimental {
+
+/// returns true, if row \ref i is set in \ref bits
+template <class Bitmap>
+bool row_bit(const Bitmap& bits, std::size_t i) {
+  return (i / 64 < bits.size()) && ((bits[i / 64] >> (i % 64)) & 1);
+}
+
+/// sets row \ref i in a bitmap under construction
+inline void set_row_bit(std::vector<std::uint64_t>& bits, std::size_t i) {
+  if (bits.size() <= i / 64) bits.resize(i / 64 + 1, 0);
+
+  bits[i / 64] |= std::uint64_t(1) << (i % 64);
+}
+
+/// a subgraph of a rank; stored next to the node and edge containers in
+///   the same Metall datastore.
+template <class Alloc>
+class subgraph_store {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+ public:
+  using bitmap_type =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+  using index_type = csr_store<Alloc>;
+  using parts_type = typename index_type::parts_type;
+
+  explicit subgraph_store(const allocator_type& alloc)
+      : nodeBits(alloc), edgeBits(alloc), index(alloc) {}
+
+  /// returns true, if the subgraph was selected from rows in state \ref st
+  bool current(const csr_stamp& st) const { return index.current(st); }
+
+  /// stores the selected rows and the index of the subgraph, selected
+  ///   from rows in state \ref st
+  void assign(const std::vector<std::uint64_t>& nodes,
+              const std::vector<std::uint64_t>& edges, const csr_buffer& idx,
+              const csr_stamp& st) {
+    nodeBits.assign(nodes.begin(), nodes.end());
+    edgeBits.assign(edges.begin(), edges.end());
+    index.assign(idx, st);
+  }
+
+  /// the selected node rows (bit i is set iff local node row i is selected)
+  const bitmap_type& node_rows() const { return nodeBits; }
+
+  /// the selected edge rows
+  const bitmap_type& edge_rows() const { return edgeBits; }
+
+  /// the index of the subgraph
+  const parts_type& parts() const { return index.parts(); }
+
+ private:
+  bitmap_type nodeBits;
+  bitmap_type edgeBits;
+  index_type  index;
+};
+
+}  // namespace experimental
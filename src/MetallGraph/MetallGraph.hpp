@@ -1,7 +1,17 @@
 #pragma once
 
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <unordered_map>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <tuple>
 
 #include <boost/container/string.hpp>
 #include <boost/container/vector.hpp>
@@ -11,6 +21,15 @@
 #include <ygm/detail/ygm_ptr.hpp>
 
 #include "MetallJsonLines.hpp"
+#include "MetallJsonLines-groupby.hpp"
+#include "MetallJsonLines-mpiio.hpp"
+#include "MetallGraph-combine.hpp"
+#include "MetallGraph-csr.hpp"
+#include "MetallGraph-delegates.hpp"
+#include "MetallGraph-generate.hpp"
+#include "MetallGraph-pregel.hpp"
+#include "MetallGraph-property.hpp"
+#include "MetallGraph-subgraph.hpp"
 
 // Do not exetnd vertex names with column names for 'auto vertices'.
 #define METALLDATA_AUTO_VERTEX_NO_COLMUN_NAME
@@ -86,22 +105,57 @@ struct metall_graphKeys
 
 namespace {
 struct count_data_mg {
-  explicit count_data_mg(ygm::comm& comm)
-      : distributedKeys(comm), edgecnt(0), nodecnt(0) {}
+  explicit count_data_mg(ygm::comm& comm) : distributedKeys(comm) {}
 
   msg::distributed_string_set distributedKeys;
-  std::size_t                 edgecnt;
-  std::size_t                 nodecnt;
 
   static count_data_mg* ptr;
 };
 
 count_data_mg* count_data_mg::ptr = nullptr;
 
+struct csr_select_mg {
+  experimental::csr_view graph;
+  std::vector<char>      selected;  ///< local vertex -> selected
+
+  static csr_select_mg* ptr;
+};
+
+csr_select_mg* csr_select_mg::ptr = nullptr;
+
+struct count_comp_mg {
+  experimental::csr_view graph;
+  std::vector<char>      selected;
+  std::size_t            edgecnt = 0;  ///< edges between selected vertices
+
+  static count_comp_mg* ptr;
+};
+
+count_comp_mg* count_comp_mg::ptr = nullptr;
+
+template <class T>
+struct vertex_property_mg {
+  experimental::csr_view           graph;
+  std::vector<std::optional<T>>    values;  ///< local vertex -> value
+  experimental::property_buffer<T> column;  ///< node row -> value
+
+  static vertex_property_mg* ptr;
+};
+
+template <class T>
+vertex_property_mg<T>* vertex_property_mg<T>::ptr = nullptr;
+
 struct conn_comp_mg {
-  explicit conn_comp_mg(ygm::comm& comm) : distributedAdjList(comm) {}
+  experimental::csr_view               graph;
+  std::vector<char>                    selected;
+  std::vector<experimental::vertex_id> label;  ///< local vertex -> cc id
+  std::vector<std::string>             labelKey;
+  std::vector<std::string>             minKey;  ///< of a component's root
 
-  msg::distributed_adj_list distributedAdjList;
+  // union-find, label is the parent
+  std::vector<experimental::vertex_id> nextLabel;
+  std::vector<experimental::vertex_id> grandparent;
+  std::vector<experimental::vertex_id> minNeighbor;
 
   static conn_comp_mg* ptr;
 };
@@ -109,26 +163,115 @@ struct conn_comp_mg {
 conn_comp_mg* conn_comp_mg::ptr = nullptr;
 
 struct kcore_comp_mg {
-  explicit kcore_comp_mg(ygm::comm& comm) : adj_set(comm) {}
-
-  // Use map here on purpose because
-  // many hash conflicts will happen if graph partitioning also uses the
-  // same hash function.
-  std::map<std::string, size_t> kcore_table;
-  msg::distributed_adj_set      adj_set;
-  static kcore_comp_mg*         ptr;
+  experimental::csr_view   graph;
+  std::vector<char>        selected;
+  std::vector<char>        alive;
+  std::vector<std::size_t> degree;
+
+  static kcore_comp_mg* ptr;
 };
 
 kcore_comp_mg* kcore_comp_mg::ptr = nullptr;
 
+struct core_comp_mg {
+  experimental::csr_view               graph;
+  std::vector<char>                    selected;
+  std::vector<std::size_t>             nbrOffsets;
+  std::vector<experimental::vertex_id> nbrs;         ///< sorted per vertex
+  std::vector<std::size_t>             nbrEstimate;  ///< aligned with nbrs
+  std::vector<std::size_t>             estimate;     ///< local vertex -> core
+  std::vector<char>                    dirty;
+
+  static core_comp_mg* ptr;
+};
+
+core_comp_mg* core_comp_mg::ptr = nullptr;
+
 struct bfs_comp_mg {
-  std::map<std::string, size_t> level_table;
+  static constexpr std::size_t no_level =
+      std::numeric_limits<std::size_t>::max();
+
+  experimental::csr_view   graph;
+  std::vector<char>        selected;
+  std::vector<std::size_t> level;  ///< local vertex -> level, or no_level
+  std::vector<std::size_t> next;   ///< local vertices of the next frontier
+  std::size_t              received = 0;  ///< the applied visits
 
   static bfs_comp_mg* ptr;
 };
 
 bfs_comp_mg* bfs_comp_mg::ptr = nullptr;
 
+struct khop_mg {
+  experimental::csr_view graph;
+  std::vector<char>      selected;  ///< empty, if all vertices are selected
+
+  /// the reached local vertices -> hops; only the neighborhood is stored
+  std::unordered_map<std::size_t, std::size_t> hops;
+  std::vector<std::size_t>                     next;
+
+  // rank 0 collects the subgraph
+  std::vector<std::pair<experimental::vertex_id, boost::json::value>> rows;
+  std::vector<std::tuple<experimental::vertex_id, std::size_t, std::string>>
+      vertices;  ///< id, hops, key
+  std::vector<std::pair<experimental::vertex_id, experimental::vertex_id>>
+      edges;
+
+  bool is_selected(std::size_t i) const {
+    return selected.empty() || selected[i];
+  }
+
+  static khop_mg* ptr;
+};
+
+khop_mg* khop_mg::ptr = nullptr;
+
+struct pagerank_mg {
+  experimental::csr_view   graph;
+  std::vector<char>        selected;
+  std::vector<std::size_t> outdeg;    ///< out-edges to selected vertices
+  std::vector<double>      residual;  ///< local vertex -> unpushed mass
+  std::size_t              received = 0;  ///< the applied pushes
+
+  static pagerank_mg* ptr;
+};
+
+pagerank_mg* pagerank_mg::ptr = nullptr;
+
+struct triangle_mg {
+  experimental::csr_view               graph;
+  std::vector<char>                    selected;
+  std::vector<std::size_t>             nbrOffsets;
+  std::vector<experimental::vertex_id> nbrs;         ///< sorted per vertex
+  std::vector<char>                    nbrSelected;  ///< aligned with nbrs
+  std::vector<std::size_t>             nbrDegree;    ///< aligned with nbrs
+  std::vector<std::size_t>             degree;  ///< selected neighbors
+
+  /// the neighbors that come later in the degree order, sorted per vertex
+  std::vector<std::size_t>             hiOffsets;
+  std::vector<experimental::vertex_id> hi;
+
+  std::vector<std::size_t> triangles;  ///< local vertex -> count
+
+  /// the counts of the third vertices on other ranks
+  std::unordered_map<experimental::vertex_id, std::size_t> remote;
+
+  /// returns the position of neighbor \ref u in the neighbors of local
+  ///   vertex \ref j
+  std::size_t neighbor_pos(std::size_t j, experimental::vertex_id u) const {
+    const auto beg = nbrs.begin() + nbrOffsets[j];
+    const auto lim = nbrs.begin() + nbrOffsets[j + 1];
+    const auto pos = std::lower_bound(beg, lim, u);
+
+    assert((pos != lim) && (*pos == u));
+    return pos - nbrs.begin();
+  }
+
+  static triangle_mg* ptr;
+};
+
+triangle_mg* triangle_mg::ptr = nullptr;
+
 }  // namespace
 
 namespace experimental {
@@ -150,10 +293,70 @@ std::string to_string(const boost::json::value& val) {
   return stream.str();
 }
 
+/// returns true if \p str is serialized by boost::json without escapes.
+inline bool is_plain_json_string(std::string_view str) {
+  for (unsigned char c : str) {
+    if (c < 0x20 || c == '"' || c == '\\') return false;
+  }
+
+  return true;
+}
+
+/// converts a stored value into the same text as the boost::json
+/// serializer would. Strings and integers, the common vertex keys,
+/// are converted directly from the persistent data without
+/// materializing a boost::json::value.
 std::string to_string(const metall_json_lines::accessor_type& valacc) {
+  if (valacc.is_string()) {
+    const std::string_view str = valacc.as_string().str_view();
+
+    if (is_plain_json_string(str)) {
+      std::string res;
+
+      res.reserve(str.size() + 2);
+      res.push_back('"');
+      res.append(str);
+      res.push_back('"');
+      return res;
+    }
+  }
+
+  if (valacc.is_int64()) return std::to_string(valacc.as_int64());
+  if (valacc.is_uint64()) return std::to_string(valacc.as_uint64());
+
   return to_string(json_bento::value_to<boost::json::value>(valacc));
 }
 
+/// converts a parsed CSV cell into the same text as the boost::json
+/// serializer would for the value that the cell is stored as.
+std::string to_string(const csv_cell& cell) {
+  switch (cell.type) {
+    case csv_type::int64:
+      return std::to_string(cell.i);
+    case csv_type::uint64:
+      return std::to_string(cell.u);
+    case csv_type::boolean:
+      return cell.b ? "true" : "false";
+    case csv_type::null:
+      return "null";
+    case csv_type::real:
+      return to_string(boost::json::value(cell.d));
+    default:;
+  }
+
+  if (!is_plain_json_string(cell.s))
+    return to_string(boost::json::value(
+        boost::json::string_view(cell.s.data(), cell.s.size())));
+
+  std::string res;
+
+  res.reserve(cell.s.size() + 2);
+  res.push_back('"');
+  res.append(cell.s);
+  res.push_back('"');
+  return res;
+}
+
 std::function<bool(const boost::json::value&)> gen_keys_checker(
     std::vector<std::string_view> keys) {
   return [fields = std::move(keys)](const boost::json::value& val) -> bool {
@@ -208,6 +411,142 @@ std::function<boost::json::value(boost::json::value)> gen_keys_generator(
   };
 }
 
+/// returns the position of the stored column \ref key of \ref format;
+///   throws if there is none.
+std::size_t csv_column_of(const csv_format& format, std::string_view key) {
+  const std::size_t col = format.find(key);
+
+  if ((col == format.columns.size()) ||
+      (format.columns[col].type == csv_type::skip))
+    throw std::invalid_argument{"csv column not found: " + std::string(key)};
+
+  return col;
+}
+
+/// returns the columns that generate the vertex keys \ref edgeKeyFields of
+///   CSV lines from the columns \ref edgeKeysOrigin of \ref format,
+///   as gen_keys_generator does for JSON rows.
+std::vector<csv_extra_column> gen_csv_keys_generator(
+    std::vector<std::string_view> edgeKeyFields,
+    std::vector<std::string_view> edgeKeysOrigin, const csv_format& format) {
+  const std::size_t numKeys =
+      std::min(edgeKeyFields.size(), edgeKeysOrigin.size());
+  std::vector<csv_extra_column> res;
+
+  for (std::size_t i = 0; i < numKeys; ++i) {
+    const std::string_view key = edgeKeysOrigin[i];
+    const std::size_t      col = csv_column_of(format, key);
+
+    auto keyGen = [col, key = std::string(key)](
+                      const std::vector<csv_cell>& row) -> std::string {
+      std::string keyval = to_string(row[col]);
+
+#ifndef METALLDATA_AUTO_VERTEX_NO_COLMUN_NAME
+      keyval.push_back('@');
+      keyval.append(key);
+#endif
+
+      count_data_mg::ptr->distributedKeys.async_insert(keyval);
+      return keyval;
+    };
+
+    res.push_back(csv_extra_column{std::string(edgeKeyFields[i]), keyGen});
+  }
+
+  return res;
+}
+
+/// the algorithms of metall_graph::connected_components
+enum class cc_algorithm {
+  label_propagation,  ///< rounds proportional to the diameter
+  union_find          ///< FastSV, O(log V) rounds
+};
+
+/// returns the cc_algorithm named \ref name
+inline cc_algorithm to_cc_algorithm(std::string_view name) {
+  if (name == "label_propagation") return cc_algorithm::label_propagation;
+  if (name == "union_find") return cc_algorithm::union_find;
+
+  throw std::invalid_argument{"unknown connected components algorithm: " +
+                              std::string(name)};
+}
+
+/// the statistics of a level of a breadth-first search (see
+///   metall_graph::bfs)
+struct bfs_level_info {
+  std::size_t level;
+  bool        bottomUp;  ///< true, if the level was a bottom-up step
+  std::size_t frontier;  ///< the vertices of the level on all ranks
+  std::size_t edges;     ///< the edges scanned on all ranks
+  double      seconds;
+
+  boost::json::object asJson() const {
+    boost::json::object res;
+
+    res["level"]     = level;
+    res["direction"] = bottomUp ? "bottom-up" : "top-down";
+    res["frontier"]  = frontier;
+    res["edges"]     = edges;
+    res["seconds"]   = seconds;
+
+    return res;
+  }
+};
+
+/// the neighborhood of metall_graph::k_hop; only valid on rank 0
+struct khop_result {
+  std::vector<std::size_t> levels;     ///< the vertices reached per hop
+  bool                     truncated;  ///< true, if max_frontier stopped it
+  boost::json::array       nodes;  ///< the node rows, with field "hops"
+  boost::json::array       edges;  ///< the induced edges, as key pairs
+
+  boost::json::object asJson() const {
+    boost::json::object res;
+    boost::json::array  levelStats;
+
+    for (std::size_t el : levels) levelStats.emplace_back(el);
+
+    res["levels"]    = std::move(levelStats);
+    res["truncated"] = truncated;
+    res["nodes"]     = nodes;
+    res["edges"]     = edges;
+
+    return res;
+  }
+};
+
+/// the outcome of metall_graph::pagerank
+struct pagerank_summary {
+  std::size_t iterations;
+  bool        converged;  ///< true, if no residual exceeds the threshold
+  double      residual;   ///< the mass that was not pushed on all ranks
+
+  boost::json::object asJson() const {
+    boost::json::object res;
+
+    res["iterations"] = iterations;
+    res["converged"]  = converged;
+    res["residual"]   = residual;
+
+    return res;
+  }
+};
+
+/// the outcome of metall_graph::triangles
+struct triangle_summary {
+  std::size_t triangles;           ///< the triangles of the graph
+  double      averageClustering;  ///< over the selected vertices
+
+  boost::json::object asJson() const {
+    boost::json::object res;
+
+    res["triangles"]          = triangles;
+    res["average_clustering"] = averageClustering;
+
+    return res;
+  }
+};
+
 struct mg_count_summary : std::tuple<std::size_t, std::size_t> {
   using base = std::tuple<std::size_t, std::size_t>;
   using base::base;
@@ -243,6 +582,11 @@ struct metall_graph {
                                metall::manager::allocator_type<metall_string>>;
   using metall_manager_type = metall_json_lines::metall_manager_type;
   using filter_type         = metall_json_lines::filter_type;
+  using csr_store_type = csr_store<metall::manager::allocator_type<std::byte>>;
+  using property_column_type =
+      property_column<metall::manager::allocator_type<std::byte>>;
+  using subgraph_store_type =
+      subgraph_store<metall::manager::allocator_type<std::byte>>;
 
   enum file_type { json, parquet };
 
@@ -251,7 +595,17 @@ struct metall_graph {
         nodelst(manager, comm, node_location_suffix),
         keys(manager.get_local_manager()
                  .find<key_store_type>(keys_location_suffix)
-                 .first) {
+                 .first),
+        csr(manager.get_local_manager()
+                .find<csr_store_type>(csr_location_suffix)
+                .first),
+        propnames(manager.get_local_manager()
+                      .find<key_store_type>(property_names_location)
+                      .first),
+        subgraphnames(manager.get_local_manager()
+                          .find<key_store_type>(subgraph_names_location)
+                          .first),
+        localmgr(&manager.get_local_manager()) {
     checked_deref(keys, ERR_OPEN_KEYS);
   }
 
@@ -279,22 +633,35 @@ struct metall_graph {
     return import_summary{};
   }
 
+  /// imports vertices from CSV files; \ref format must have a column
+  ///   named as the vertex key.
+  import_summary read_vertex_files(const std::vector<std::string>& files,
+                                   const csv_format&               format) {
+    csv_column_of(format, nodeKey());
+
+    return nodelst.read_csv_files(files, format);
+  }
+
   import_summary read_edge_files(const std::vector<std::string>& files,
                                  const file_type ftype = file_type::json,
                                  std::vector<std::string_view> autoKeys = {}) {
     if (autoKeys.empty()) {
+      import_summary res;
+
       if (ftype == file_type::json) {
-        return edgelst.read_json_files(
+        res = edgelst.read_json_files(
             files, gen_keys_checker({edgeSrcKey(), edgeTgtKey()}));
       } else if (ftype == file_type::parquet) {
 #ifdef METALLDATA_USE_PARQUET
-        return edgelst.read_parquet_files(
+        res = edgelst.read_parquet_files(
             files, gen_keys_checker({edgeSrcKey(), edgeTgtKey()}));
 #else
         assert(false);
 #endif
       }
-      return import_summary{};
+
+      build_index();
+      return res;
     }
 
     msg::ptr_guard cntStateGuard{count_data_mg::ptr,
@@ -314,9 +681,99 @@ struct metall_graph {
 #endif
     comm().barrier();
     persist_keys(nodelst, nodeKey(), count_data_mg::ptr->distributedKeys);
+    build_index();
+    return res;
+  }
+
+  /// imports edges from CSV files
+  /// \param format   the columns of the files; without \ref autoKeys,
+  ///                 it must have columns named as the source and target keys.
+  /// \param autoKeys the columns from which the source and target vertices
+  ///                 are generated (see read_edge_files for JSON files).
+  /// \details
+  ///   the cells are typed as in \ref format and written into the edge list
+  ///   directly (see metall_json_lines::read_csv_files).
+  import_summary read_edge_files(const std::vector<std::string>& files,
+                                 const csv_format&               format,
+                                 std::vector<std::string_view> autoKeys = {}) {
+    if (autoKeys.empty()) {
+      csv_column_of(format, edgeSrcKey());
+      csv_column_of(format, edgeTgtKey());
+
+      import_summary res = edgelst.read_csv_files(files, format);
+
+      build_index();
+      return res;
+    }
+
+    msg::ptr_guard cntStateGuard{count_data_mg::ptr,
+                                 new count_data_mg{nodelst.comm()}};
+    import_summary res = edgelst.read_csv_files(
+        files, format,
+        gen_csv_keys_generator({edgeSrcKey(), edgeTgtKey()}, autoKeys,
+                               format));
+
+    comm().barrier();
+    persist_keys(nodelst, nodeKey(), count_data_mg::ptr->distributedKeys);
+    build_index();
     return res;
   }
 
+  /// number of edges that generate buffers before it appends them
+  static constexpr std::size_t GENERATE_BATCH_EDGES = 64 * 1024;
+
+  /// appends a synthetic graph (see generate_edges) with unsigned integer
+  ///   vertex keys in [0, 2^scale). Collective.
+  /// \return the numbers of generated vertices and edges
+  /// \details
+  ///   each rank generates its share of the edges and of the vertex keys,
+  ///   and appends them to its local edge and vertex lists directly
+  ///   (see metall_json_lines::append_objects); thus, no rows are sent.
+  ///   All 2^scale vertices are stored, including those without edges.
+  mg_count_summary generate(const graph_generator_options& opts) {
+    using edge_type = std::pair<std::uint64_t, std::uint64_t>;
+
+    const int                           rank     = comm().rank();
+    const int                           numranks = comm().size();
+    std::size_t                         numedges = 0;
+    std::vector<edge_type>              batch;
+    const std::vector<std::string_view> edgeKeys{edgeSrcKey(), edgeTgtKey()};
+
+    batch.reserve(GENERATE_BATCH_EDGES);
+
+    auto appendBatch = [this, &batch, &edgeKeys, &numedges]() -> void {
+      numedges += edgelst.append_objects(
+          edgeKeys, batch.size(),
+          [&batch](std::size_t i, auto& writer, const auto& keys) -> void {
+            writer.add_uint64(keys[0], batch[i].first);
+            writer.add_uint64(keys[1], batch[i].second);
+          });
+      batch.clear();
+    };
+
+    generate_edges(opts, rank, numranks,
+                   [&batch, &appendBatch](std::uint64_t src,
+                                          std::uint64_t tgt) -> void {
+                     batch.emplace_back(src, tgt);
+
+                     if (batch.size() == GENERATE_BATCH_EDGES) appendBatch();
+                   });
+    appendBatch();
+
+    const auto [beg, end] =
+        generator_share(opts.num_vertices(), rank, numranks);
+    const std::size_t numnodes = nodelst.append_objects(
+        {nodeKey()}, end - beg,
+        [first = beg](std::size_t i, auto& writer, const auto& keys) -> void {
+          writer.add_uint64(keys[0], first + i);
+        });
+
+    comm().barrier();
+    build_index();
+
+    return {comm().all_reduce_sum(numnodes), comm().all_reduce_sum(numedges)};
+  }
+
   static void create_new(metall_manager_type& manager, ygm::comm& comm,
                          std::string_view node_key,
                          std::string_view edge_src_key,
@@ -368,520 +825,1628 @@ struct metall_graph {
       }
   */
 
+  /// counts the selected vertices and the selected edges between them.
+  ///   The edges are counted by the owners of their targets; the counts are
+  ///   combined per target vertex before they are sent. Collective.
   mg_count_summary count(std::vector<filter_type> nfilt,
                          std::vector<filter_type> efilt) {
-    assert(count_data_mg::ptr == nullptr);
-
-    msg::ptr_guard cntStateGuard{count_data_mg::ptr,
-                                 new count_data_mg{nodelst.comm()}};
-    int            rank = comm().rank();
-
-    auto nodeAction = [nodeKeyTxt = nodeKey(), rank](
-                          std::size_t,
-                          const metall_json_lines::accessor_type& val) -> void {
-      assert(count_data_mg::ptr != nullptr);
-
-      msg::distributed_string_set& keyStore =
-          count_data_mg::ptr->distributedKeys;
+    csr_buffer        scratch;
+    const csr_view    g = graph_index(std::move(efilt), scratch);
+    const std::size_t n = g.num_local();
 
-      std::string thekey = to_string(get_key(val, nodeKeyTxt));
-      keyStore.async_insert(thekey);
+    nodelst.filter(std::move(nfilt));
 
-      ++count_data_mg::ptr->nodecnt;
-    };
+    msg::ptr_guard cntStateGuard{count_comp_mg::ptr,
+                                 new count_comp_mg{g, selected_vertices(g)}};
+    count_comp_mg& state = *count_comp_mg::ptr;
 
-    nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
     comm().barrier();
 
-    // \todo
-    //   this version only counts the presence of src and tgt vertex of an edge.
-    //   To mark the actual edge, we need to add (owner, index) to the msg, so
-    //   that the target vertex owner can notify the edge owner of its
-    //   inclusion.
-    auto edgeAction = [edgeSrcKeyTxt = edgeSrcKey(),
-                       edgeTgtKeyTxt = edgeTgtKey()](
-                          std::size_t                             pos,
-                          const metall_json_lines::accessor_type& val) -> void {
-      msg::distributed_string_set& keyStore =
-          count_data_mg::ptr->distributedKeys;
-      auto commEdgeSrcCheck = [](const std::string& srckey,
-                                 const std::string& tgtkey) {
-        msg::distributed_string_set& keyStore =
-            count_data_mg::ptr->distributedKeys;
-        auto commEdgeTgtCheck = [](const std::string&) {
-          ++count_data_mg::ptr->edgecnt;
-        };
+    {
+      auto targets = make_vertex_combiner<std::size_t>(
+          comm(), g, std::plus<std::size_t>{},
+          [](vertex_id v, std::size_t cnt) -> void {
+            count_comp_mg& state = *count_comp_mg::ptr;
 
-        keyStore.async_exe_if_contains(tgtkey, commEdgeTgtCheck);
-      };
+            if (state.selected[state.graph.local_index(v)])
+              state.edgecnt += cnt;
+          });
 
-      keyStore.async_exe_if_contains(to_string(get_key(val, edgeSrcKeyTxt)),
-                                     commEdgeSrcCheck,
-                                     to_string(get_key(val, edgeTgtKeyTxt)));
-    };
+      for (std::size_t i = 0; i < n; ++i)
+        if (state.selected[i])
+          for (vertex_id target : g.out(i)) targets.add(target, 1);
+
+      targets.flush();
+    }
 
-    edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
     comm().barrier();
 
-    const std::size_t totalNodes = count_data_mg::ptr->distributedKeys.size();
-    const std::size_t totalEdges =
-        nodelst.comm().all_reduce_sum(count_data_mg::ptr->edgecnt);
+    const std::size_t totalNodes = comm().all_reduce_sum(std::size_t(
+        std::count(state.selected.begin(), state.selected.end(), 1)));
+    const std::size_t totalEdges = comm().all_reduce_sum(state.edgecnt);
 
     return {totalNodes, totalEdges};
   }
 
-  ygm::comm& comm() { return nodelst.comm(); }
-
-  bool count_degree(std::vector<filter_type> nfilt,
-                    std::vector<filter_type> efilt, bool undirected = true) {
-    msg::ptr_guard cntStateGuard{bfs_comp_mg::ptr, new bfs_comp_mg{}};
-
-    //
-    // Allocate adjacency list
-    ygm::container::map<std::string, std::size_t> count_table(comm());
-    auto nodeAction = [&count_table, nodeKeyTxt = nodeKey()](
-                          std::size_t,
-                          const metall_json_lines::accessor_type& val) -> void {
-      const auto vertex = to_string(get_key(val, nodeKeyTxt));
-      count_table.async_insert_if_missing(vertex, 0);
-    };
-    nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
-    comm().barrier();
+  /// approximates count without building the graph index: the vertices
+  ///   are the distinct keys of the selected vertices and of the endpoints
+  ///   of the selected edges, estimated with HyperLogLog sketches that are
+  ///   merged with one all-reduce; the edges are all selected edges,
+  ///   regardless of whether their endpoints are selected. Collective.
+  /// \param precision the precision of the sketch (see hyperloglog)
+  mg_count_summary approx_count(
+      std::vector<filter_type> nfilt, std::vector<filter_type> efilt,
+      int precision = hyperloglog::DEFAULT_PRECISION) {
+    hyperloglog sketch{precision};
+
+    nodelst.filter(std::move(nfilt)).add_distinct(sketch, nodeKey());
+    edgelst.filter(std::move(efilt));
+    edgelst.add_distinct(sketch, edgeSrcKey());
+    edgelst.add_distinct(sketch, edgeTgtKey());
+
+    const double      nodes = nodelst.merged_estimate(sketch);
+    const std::size_t edges = edgelst.count();
+
+    return {std::size_t(std::llround(nodes)), edges};
+  }
 
-    auto edgeAction = [&count_table, undirected, edgeSrcKeyTxt = edgeSrcKey(),
-                       edgeTgtKeyTxt = edgeTgtKey()](
-                          std::size_t                             pos,
-                          const metall_json_lines::accessor_type& val) -> void {
-      const auto src = to_string(get_key(val, edgeTgtKeyTxt));
-      const auto dst = to_string(get_key(val, edgeSrcKeyTxt));
-      count_table.async_visit_if_exists(
-          src, [](const auto&, std::size_t& degree) { ++degree; });
-
-      if (!undirected) return;
-      count_table.async_visit_if_exists(
-          dst, [](const auto&, std::size_t& degree) { ++degree; });
-    };
-    edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
-    comm().barrier();
+  ygm::comm& comm() { return nodelst.comm(); }
 
-    auto level_setter = [&count_table, nodeKeyTxt = nodeKey(), this](
-                            const std::size_t                       node_index,
-                            const metall_json_lines::accessor_type& val) {
-      const auto v = to_string(get_key(val, nodeKeyTxt));
-      // Visit the rank that know the degree of v
-      count_table.async_visit(
-          v,
-          [](const std::string& v, const std::size_t degree,
-             ygm::ygm_ptr<metall_graph> pthis, const int src_rank,
-             const int node_index) {
-            // Send the degree to the node owner
-            pthis->comm().async(
-                src_rank,
-                [](auto, ygm::ygm_ptr<metall_graph> pthis, const int node_index,
-                   const std::size_t degree) {
-                  // Finally, update the degree value
-                  pthis->nodelst.at(node_index).as_object()["degree"] = degree;
-                },
-                pthis, node_index, degree);
-          },
-          ptr_this, comm().rank(), node_index);
-    };
-    nodelst.for_all_selected(level_setter);
-    comm().barrier();
+  /// rewrites the vertex and edge rows into densely packed storage
+  ///   (see metall_json_lines::compact). The rows keep their order, thus
+  ///   the graph index, the vertex property columns, and the subgraphs
+  ///   remain current.
+  /// \return false, if the datastore is read-only
+  bool compact() {
+    const bool edgesCompacted = edgelst.compact();
+    const bool nodesCompacted = nodelst.compact();
 
-    return true;
+    return edgesCompacted && nodesCompacted;
   }
 
-  std::size_t connected_components(std::vector<filter_type> nfilt,
-                                   std::vector<filter_type> efilt) {
-    msg::ptr_guard cntStateGuard{conn_comp_mg::ptr, new conn_comp_mg{comm()}};
+  /// combines the edges with the same source and target keys into one edge
+  ///   (see collapse_rows), which has the number of combined edges in
+  ///   \ref countColumn and the sums, minimums, or maximums of the columns
+  ///   in \ref aggs; then rebuilds the index. Collective.
+  /// \return the number of edges after collapsing
+  std::size_t collapse_edges(const std::vector<aggregate_spec>& aggs,
+                             const std::string& countColumn = "count") {
+    if (localmgr->read_only())
+      throw std::runtime_error{
+          "unable to collapse the edges of a read-only datastore"};
+
+    const std::size_t res = collapse_rows(
+        edgelst, {std::string(edgeSrcKey()), std::string(edgeTgtKey())}, aggs,
+        countColumn);
+
+    build_index();
+    return res;
+  }
 
-    auto nodeAction = [nodeKeyTxt = nodeKey()](
-                          std::size_t,
-                          const metall_json_lines::accessor_type& val) -> void {
-      std::string vertex = to_string(get_key(val, nodeKeyTxt));
+  /// returns the index of all vertices and of the edges selected by
+  ///   \ref efilt. Without edge filters, the persistent index is used; it is
+  ///   rebuilt (and stored, unless the datastore is read-only) if it is
+  ///   stale. With edge filters, a transient index is built in \ref scratch.
+  ///   In a subgraph (see use_subgraph), the index has the vertices and
+  ///   edges of the subgraph, and without edge filters, it is the
+  ///   subgraph's index. Must be called before a node filter is set.
+  ///   Collective.
+  csr_view graph_index(std::vector<filter_type> efilt, csr_buffer& scratch) {
+    if (efilt.empty()) {
+      if (subgraph) return csr_view{subgraph->parts(), comm().rank()};
+
+      if (csr_store_type* index = current_index())
+        return csr_view{index->parts(), comm().rank()};
+
+      scratch = make_index();
+
+      if (csr_store_type* index = writable_index()) {
+        index->assign(scratch, index_stamp());
+        return csr_view{index->parts(), comm().rank()};
+      }
 
-      conn_comp_mg::ptr->distributedAdjList.async_insert_if_missing(
-          vertex, std::vector<std::string>{});
-    };
+      return csr_view{scratch, comm().rank()};
+    }
 
-    nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
-    comm().barrier();
+    edgelst.filter(std::move(efilt));
+    scratch = make_index();
+    return csr_view{scratch, comm().rank()};
+  }
 
-    auto edgeAction = [edgeSrcKeyTxt = edgeSrcKey(),
-                       edgeTgtKeyTxt = edgeTgtKey()](
-                          std::size_t                             pos,
-                          const metall_json_lines::accessor_type& val) -> void {
-      msg::distributed_adj_list& adjList =
-          conn_comp_mg::ptr->distributedAdjList;
-
-      auto commEdgeTgtCheck = [](const std::string& tgtkey,
-                                 const std::vector<std::string>&,
-                                 const std::string& srckey) {
-        auto commEdgeSrcCheck =
-            [](const std::string& /*srckey*/, std::vector<std::string>& edges,
-               std::string tgtkey) { edges.emplace_back(std::move(tgtkey)); };
-
-        conn_comp_mg::ptr->distributedAdjList.async_visit_if_exists(
-            srckey, commEdgeSrcCheck, tgtkey);
-        conn_comp_mg::ptr->distributedAdjList.async_visit_if_exists(
-            tgtkey, commEdgeSrcCheck, srckey);
-      };
-
-      // check first target, if in then add edges (src->tgt and tgt->src) to
-      // adjecency list at src
-      //   we assume a
-      adjList.async_visit_if_exists(to_string(get_key(val, edgeTgtKeyTxt)),
-                                    commEdgeTgtCheck,
-                                    to_string(get_key(val, edgeSrcKeyTxt)));
-    };
+  /// builds and stores the persistent index of all vertices and edges;
+  ///   the algorithms rebuild a stale index on demand. Collective.
+  void build_index() {
+    const csr_buffer index = make_index();
 
-    edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
+    if (csr_store_type* store = writable_index())
+      store->assign(index, index_stamp());
+  }
 
-    comm().barrier();
-    static std::size_t localRoots = 0;
+  /// stores the node rows selected by \ref nfilt and the edge rows selected
+  ///   by \ref efilt as subgraph \ref name, together with the index of the
+  ///   selected vertices and the selected edges between them (see
+  ///   subgraph_store); replaces an existing subgraph \ref name.
+  ///   Collective.
+  /// \return the numbers of vertices and edges of the subgraph's index
+  mg_count_summary create_subgraph(const std::string&       name,
+                                   std::vector<filter_type> nfilt,
+                                   std::vector<filter_type> efilt) {
+    if (localmgr->read_only())
+      throw std::runtime_error{"unable to store subgraph " + name +
+                               " in a read-only datastore"};
+
+    std::vector<std::uint64_t> nodeBits;
+    std::vector<std::uint64_t> edgeBits;
+
+    nodelst.filter(std::move(nfilt))
+        .for_all_selected(
+            [&nodeBits](std::size_t row,
+                        const metall_json_lines::accessor_type&) -> void {
+              set_row_bit(nodeBits, row);
+            });
+    edgelst.filter(std::move(efilt))
+        .for_all_selected(
+            [&edgeBits](std::size_t row,
+                        const metall_json_lines::accessor_type&) -> void {
+              set_row_bit(edgeBits, row);
+            });
 
-    {
-      // from Roger's code
-      // https://lc.llnl.gov/gitlab/metall/ygm-reddit/-/blob/main/bench/reddit_components_labelprop.cpp
-
-      ygm::container::map<std::string, std::string> map_cc{comm()};
-      ygm::container::map<std::string, std::string> active{comm()};
-      ygm::container::map<std::string, std::string> next_active{comm()};
-
-      // \todo could be factored into a class similar to conn_comp_mg
-      static auto& s_next_active = next_active;
-      static auto& s_map_cc      = map_cc;
-      static auto& s_adj_list    = conn_comp_mg::ptr->distributedAdjList;
-
-      //
-      // Init map_cc
-      s_adj_list.for_all(
-          [&map_cc, &active](const std::string& vertex,
-                             const std::vector<std::string>&) -> void {
-            map_cc.async_insert(vertex, vertex);
-            active.async_insert(vertex, vertex);
-          });
-      comm().barrier();
+    const csr_buffer index = make_index();
+    const csr_view   g{index, comm().rank()};
+    std::size_t      numedges = 0;
 
-      while (active.size() > 0) {
-        // comm().cout0("active.size() = ", active.size());
-        active.for_all([](const std::string& vertex,
-                          const std::string& cc_id) -> void {
-          s_adj_list.async_visit(
-              vertex,
-              [](const std::string& vertex, const std::vector<std::string>& adj,
-                 const std::string& cc_id) -> void {
-                for (const auto& neighbor : adj) {
-                  if (cc_id < neighbor) {
-                    s_map_cc.async_visit(
-                        neighbor,
-                        [](const std::string& n, std::string& ncc,
-                           const std::string& cc_id) -> void {
-                          if (cc_id < ncc) {
-                            ncc = cc_id;
-                            s_next_active.async_reduce(
-                                n, cc_id,
-                                [](const std::string& a,
-                                   const std::string& b) -> const std::string& {
-                                  return std::min(a, b);
-                                });
-                          }
-                        },
-                        cc_id);
-                  }
-                }
-              },
-              cc_id);
-        });
-        comm().barrier();
-        active.clear();
-        active.swap(next_active);
-      }
+    for (std::size_t i = 0; i < g.num_local(); ++i)
+      numedges += g.out(i).size();
 
-      localRoots = 0;
-      // \todo should be local_for_all??
-      s_map_cc.for_all(
-          [](const std::string& lhs, const std::string& rhs) -> void {
-            localRoots += (lhs == rhs);
+    const std::string    location = subgraph_location(name);
+    subgraph_store_type* store =
+        localmgr->find<subgraph_store_type>(location.c_str()).first;
 
-            //~ if (lhs == rhs)
-            //~ std::cerr << lhs << std::flush;
-          });
-      comm().barrier();
+    if (!store) {
+      if (!subgraphnames)
+        subgraphnames = localmgr->construct<key_store_type>(
+            subgraph_names_location)(localmgr->get_allocator());
 
-      // Insert CC IDs to the corresponding nodes' JSON data
-      {
-        auto cc_setter = [nodeKeyTxt = nodeKey(), this](
-                             const std::size_t                       node_idx,
-                             const metall_json_lines::accessor_type& val) {
-          const std::string v = to_string(get_key(val, nodeKeyTxt));
-          // Visit the rank that holds v's CC ID.
-          s_map_cc.async_visit_if_exists(
-              v,
-              [](const std::string&, std::string& cc_id,
-                 const std::size_t node_idx, auto pthis, const int src_rank) {
-                // Send CC ID to src_rank who owns the node in the node-list.
-                pthis->comm().async(
-                    src_rank,
-                    [](auto, const std::string& cc_id,
-                       const std::size_t node_idx, auto pthis) {
-                      // Finally, we have come back to the original rank.
-                      // Update the CC ID.
-                      pthis->nodelst.at(node_idx).as_object()["cc"] = cc_id;
-                    },
-                    cc_id, node_idx, pthis);
-              },
-              node_idx, ptr_this, comm().rank());
-        };
-        nodelst.for_all_selected(cc_setter);
-        comm().barrier();
-      }
+      store = localmgr->construct<subgraph_store_type>(location.c_str())(
+          localmgr->get_allocator());
+      subgraphnames->emplace_back(
+          metall_string(name.data(), name.size(), localmgr->get_allocator()));
     }
 
-    const std::size_t totalRoots = nodelst.comm().all_reduce_sum(localRoots);
+    store->assign(nodeBits, edgeBits, index, index_stamp());
+    return {g.num_vertices(), comm().all_reduce_sum(numedges)};
+  }
+
+  /// returns the names of the subgraphs that are current
+  std::vector<std::string> subgraphs() const {
+    std::vector<std::string> res;
 
-    return totalRoots;
+    if (!subgraphnames) return res;
+
+    for (const metall_string& name : *subgraphnames)
+      if (const subgraph_store_type* store = find_subgraph(name))
+        if (store->current(index_stamp())) res.emplace_back(name);
+
+    return res;
   }
 
-  std::vector<std::size_t> kcore(std::vector<filter_type> nfilt,
-                                 std::vector<filter_type> efilt,
-                                 int                      max_kcore) {
-    msg::ptr_guard cntStateGuard{kcore_comp_mg::ptr, new kcore_comp_mg{comm()}};
-    auto&          adj_set     = kcore_comp_mg::ptr->adj_set;
-    auto&          kcore_table = kcore_comp_mg::ptr->kcore_table;
+  /// restricts the node and edge lists to the rows of subgraph \ref name,
+  ///   and lets the algorithms use its index (see graph_index); an empty
+  ///   name leaves the graph as is. Must be called before any filter is
+  ///   set. Collective.
+  void use_subgraph(std::string_view name) {
+    if (name.empty()) return;
+
+    const subgraph_store_type* store   = find_subgraph(name);
+    const bool                 current = store && store->current(index_stamp());
+
+    if (comm().all_reduce_sum(std::size_t(!current)) != 0)
+      throw std::runtime_error{
+          "subgraph does not exist or is stale (create it again): " +
+          std::string(name)};
+
+    subgraph = store;
+
+    nodelst.filter([bits = &store->node_rows()](
+                       std::size_t row,
+                       const metall_json_lines::accessor_type&) -> bool {
+      return row_bit(*bits, row);
+    });
+    edgelst.filter([bits = &store->edge_rows()](
+                       std::size_t row,
+                       const metall_json_lines::accessor_type&) -> bool {
+      return row_bit(*bits, row);
+    });
+  }
 
-    auto nodeAction = [nodeKeyTxt = nodeKey()](
-                          std::size_t,
-                          const metall_json_lines::accessor_type& val) -> void {
-      std::string vertex = to_string(get_key(val, nodeKeyTxt));
+  /// returns the names of the vertex properties whose columns are current
+  std::vector<std::string> vertex_properties() const {
+    std::vector<std::string> res;
 
-      kcore_comp_mg::ptr->adj_set.async_insert_if_missing(
-          vertex, std::set<std::string>{});
-    };
+    if (!propnames) return res;
 
-    nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
-    comm().barrier();
+    for (const metall_string& name : *propnames)
+      if (vertex_property_column(name)) res.emplace_back(name);
 
-    auto edgeAction = [edgeSrcKeyTxt = edgeSrcKey(),
-                       edgeTgtKeyTxt = edgeTgtKey()](
-                          std::size_t                             pos,
-                          const metall_json_lines::accessor_type& val) -> void {
-      const auto src = to_string(get_key(val, edgeTgtKeyTxt));
-      const auto dst = to_string(get_key(val, edgeSrcKeyTxt));
-      kcore_comp_mg::ptr->adj_set.async_visit_if_exists(
-          src,
-          [](std::string key, std::set<std::string>& adj, std::string v) {
-            adj.insert(v);
-          },
-          dst);
-      kcore_comp_mg::ptr->adj_set.async_visit_if_exists(
-          dst,
-          [](std::string key, std::set<std::string>& adj, std::string v) {
-            adj.insert(v);
-          },
-          src);
-    };
-    edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
-    comm().barrier();
+    return res;
+  }
 
-    const std::size_t num_nodes = comm().all_reduce_sum(nodelst.local_size());
+  /// returns the column of vertex property \ref name, or null if it does
+  ///   not exist or is stale (the node rows were modified since).
+  const property_column_type* vertex_property_column(
+      std::string_view name) const {
+    const property_column_type* col = find_property(name);
 
-    // i-th item is the number of nodes in 'i'-kore.
-    std::vector<size_t> kcore_size_list;
-    std::size_t         total_num_pruned = 0;
+    return col && col->current(property_state()) ? col : nullptr;
+  }
 
-    // Compute k-core (from 0-core to 'max_kcore'-core)
-    for (int kcore = 1; kcore <= max_kcore + 1; ++kcore) {
-      size_t num_pruned = 0;
-      while (true) {
-        size_t local_num_pruned = 0;
-        adj_set.for_all(
-            [kcore, &adj_set, &local_num_pruned, &kcore_table, this](
-                const std::string& vert, std::set<std::string>& adj) {
-              if (adj.empty() || adj.size() >= kcore) return;
-
-              // Found vertex to prune, go tell all neighbors of
-              // my demise
-              for (const auto& neighbor : adj) {
-                adj_set.async_visit_if_exists(
-                    neighbor,
-                    [](const std::string&, std::set<std::string>& adj,
-                       const std::string& v) { adj.erase(v); },
-                    vert);
-              }
-              adj.clear();
-              kcore_table[vert] = kcore - 1;
-              ++local_num_pruned;
-            });
-        comm().barrier();
+  /// returns a histogram of the values of column \ref colName of the
+  ///   selected node rows; reads the property column \ref colName if it
+  ///   is current. Collective.
+  std::vector<std::pair<boost::json::value, std::size_t>> hist(
+      std::vector<filter_type> nfilt, const std::string& colName) {
+    nodelst.filter(std::move(nfilt));
 
-        const auto n = comm().all_reduce_sum(local_num_pruned);
-        num_pruned += n;
-        if (n == 0) break;
-      }
+    const property_column_type* col = vertex_property_column(colName);
 
-      total_num_pruned += num_pruned;
-      kcore_size_list.emplace_back(num_nodes - total_num_pruned);
-    }
+    // the ranks must agree on the column source
+    if (comm().all_reduce_sum(std::size_t(col == nullptr)) > 0)
+      return nodelst.hist(colName);
 
-    // Insert k-core values to the corresponding nodes' JSON data
-    auto kcore_setter = [&adj_set, nodeKeyTxt = nodeKey(), this](
-                            const std::size_t                       index,
-                            const metall_json_lines::accessor_type& val) {
-      assert(kcore_comp_mg::ptr != nullptr);
-      const std::string v = to_string(get_key(val, nodeKeyTxt));
-      comm().async(
-          adj_set.owner(v),
-          [](auto pcomm, const std::string& v, const int index,
-             ygm::ygm_ptr<metall_graph> pthis, const int src_rank) {
-            auto& kcore_table = kcore_comp_mg::ptr->kcore_table;
-            if (kcore_table.count(v) == 0) return;
-            pcomm->async(
-                src_rank,
-                [](auto, const int kcore, const int index,
-                   ygm::ygm_ptr<metall_graph> pthis) {
-                  pthis->nodelst.at(index).as_object()["kcore"] = kcore;
-                },
-                kcore_table.at(v), index, pthis);
-          },
-          v, index, ptr_this, comm().rank());
-    };
-    nodelst.for_all_selected(kcore_setter);
-    comm().barrier();
+    return nodelst.hist_by(
+        [view = col->view()](std::size_t row, const auto&)
+            -> std::optional<boost::json::value> {
+          if (!view.contains(row)) return std::nullopt;
 
-    return kcore_size_list;
+          return view.json_at(row);
+        });
   }
 
-  size_t bfs(std::vector<filter_type> nfilt, std::vector<filter_type> efilt,
-             std::string root, bool undirected = true) {
-    msg::ptr_guard cntStateGuard{bfs_comp_mg::ptr, new bfs_comp_mg{}};
+  bool count_degree(std::vector<filter_type> nfilt,
+                    std::vector<filter_type> efilt, bool undirected = true) {
+    csr_buffer        scratch;
+    const csr_view    g = graph_index(std::move(efilt), scratch);
+    const std::size_t n = g.num_local();
 
-    //
-    // Allocate adjacency list
-    ygm::container::map<std::string, std::vector<std::string>> adj_list(comm());
+    nodelst.filter(std::move(nfilt));
 
-    auto nodeAction = [&adj_list, nodeKeyTxt = nodeKey()](
-                          std::size_t,
-                          const metall_json_lines::accessor_type& val) -> void {
-      std::string vertex = to_string(get_key(val, nodeKeyTxt));
+    const std::vector<char> selected = selected_vertices(g);
 
-      adj_list.async_insert_if_missing(vertex, std::vector<std::string>{});
-    };
+    // as before, the (directed) degree of a vertex counts its in-edges
+    std::vector<std::optional<std::size_t>> degree(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!selected[i]) continue;
+
+      degree[i] = g.in(i).size() + (undirected ? g.out(i).size() : 0);
+    }
+
+    set_vertex_property(g, "degree", std::move(degree));
+    return true;
+  }
+
+  /// computes the connected components of the selected subgraph; sets
+  ///   property "cc" of the vertices to the smallest key text of the
+  ///   component, and returns the number of components. Both algorithms
+  ///   compute the same components, and the labels do not depend on the
+  ///   number of ranks.
+  std::size_t connected_components(
+      std::vector<filter_type> nfilt, std::vector<filter_type> efilt,
+      cc_algorithm alg = cc_algorithm::label_propagation) {
+    csr_buffer        scratch;
+    const csr_view    g = graph_index(std::move(efilt), scratch);
+    const std::size_t n = g.num_local();
+
+    nodelst.filter(std::move(nfilt));
+
+    msg::ptr_guard cntStateGuard{conn_comp_mg::ptr,
+                                 new conn_comp_mg{g, selected_vertices(g)}};
+    conn_comp_mg& state = *conn_comp_mg::ptr;
+
+    state.label.resize(n);
+
+    for (std::size_t i = 0; i < n; ++i) state.label[i] = g.global_id(i);
+
+    comm().barrier();
+
+    if (alg == cc_algorithm::union_find)
+      union_find_components(g);
+    else
+      label_propagation_components(g);
+
+    std::size_t localRoots = 0;
+
+    for (std::size_t i = 0; i < n; ++i)
+      localRoots += (state.selected[i] && (state.label[i] == g.global_id(i)));
+
+    // as before, a component is labeled with its smallest key text; the
+    //   root of a component collects the smallest key of its vertices
+    const int rank = comm().rank();
+
+    state.minKey.resize(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (state.selected[i] && (state.label[i] == g.global_id(i)))
+        state.minKey[i] = g.key(i);
+
+    comm().barrier();
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i] || (state.label[i] == g.global_id(i))) continue;
+
+      comm().async(
+          g.owner(state.label[i]),
+          [](vertex_id cc_id, const std::string& key) -> void {
+            conn_comp_mg& state = *conn_comp_mg::ptr;
+            std::string&  cur   = state.minKey[state.graph.local_index(cc_id)];
+
+            if (key < cur) cur = key;
+          },
+          state.label[i], std::string(g.key(i)));
+    }
+
+    comm().barrier();
+
+    // look up the labels of the component ids
+    state.labelKey.resize(n);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i]) continue;
+
+      comm().async(
+          g.owner(state.label[i]),
+          [](auto pcomm, vertex_id cc_id, int src, std::size_t idx) -> void {
+            const conn_comp_mg& state = *conn_comp_mg::ptr;
+
+            pcomm->async(
+                src,
+                [](std::size_t idx, const std::string& key) -> void {
+                  conn_comp_mg::ptr->labelKey[idx] = key;
+                },
+                idx, state.minKey[state.graph.local_index(cc_id)]);
+          },
+          state.label[i], rank, i);
+    }
+
+    comm().barrier();
+
+    // Store the CC IDs as vertex property
+    std::vector<std::optional<std::string>> cc(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (state.selected[i]) cc[i] = std::move(state.labelKey[i]);
+
+    set_vertex_property(g, "cc", std::move(cc));
+
+    return comm().all_reduce_sum(localRoots);
+  }
+
+  std::vector<std::size_t> kcore(std::vector<filter_type> nfilt,
+                                 std::vector<filter_type> efilt,
+                                 int                      max_kcore) {
+    csr_buffer        scratch;
+    const csr_view    g = graph_index(std::move(efilt), scratch);
+    const std::size_t n = g.num_local();
+
+    nodelst.filter(std::move(nfilt));
+
+    msg::ptr_guard cntStateGuard{
+        kcore_comp_mg::ptr, new kcore_comp_mg{g, selected_vertices(g), {}, {}}};
+    kcore_comp_mg& state = *kcore_comp_mg::ptr;
+
+    std::vector<std::size_t> nbrOffsets;
+    std::vector<vertex_id>   nbrs;
+
+    distinct_neighbors(g, nbrOffsets, nbrs, true);
+
+    // as before, the degree of a vertex counts its distinct neighbors,
+    //   including unselected ones (which are never pruned) and itself for
+    //   a self loop. Vertices without neighbors are never pruned and get no
+    //   kcore.
+    state.alive.assign(n, 0);
+    state.degree.assign(n, 0);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i]) continue;
+
+      state.degree[i] = nbrOffsets[i + 1] - nbrOffsets[i];
+      state.alive[i]  = (state.degree[i] > 0);
+    }
+
+    comm().barrier();
+
+    const std::size_t num_nodes = comm().all_reduce_sum(std::size_t(
+        std::count(state.selected.begin(), state.selected.end(), 1)));
+
+    // i-th item is the number of nodes in 'i'-kore.
+    std::vector<size_t>             kcore_size_list;
+    std::vector<std::optional<int>> kcore_table(n);
+    std::size_t                     total_num_pruned = 0;
+
+    // Compute k-core (from 0-core to 'max_kcore'-core)
+    for (int kcore = 1; kcore <= max_kcore + 1; ++kcore) {
+      size_t num_pruned = 0;
+      while (true) {
+        size_t local_num_pruned = 0;
+
+        for (std::size_t i = 0; i < n; ++i) {
+          if (!state.alive[i] || (state.degree[i] >= std::size_t(kcore)))
+            continue;
+
+          // Found vertex to prune, go tell all neighbors of
+          // my demise
+          state.alive[i] = 0;
+          kcore_table[i] = kcore - 1;
+          ++local_num_pruned;
+
+          for (std::size_t k = nbrOffsets[i]; k < nbrOffsets[i + 1]; ++k) {
+            comm().async(
+                g.owner(nbrs[k]),
+                [](vertex_id v) -> void {
+                  kcore_comp_mg&    state = *kcore_comp_mg::ptr;
+                  const std::size_t j     = state.graph.local_index(v);
+
+                  if (state.alive[j] && (state.degree[j] > 0))
+                    --state.degree[j];
+                },
+                nbrs[k]);
+          }
+        }
+
+        comm().barrier();
+
+        const auto pruned = comm().all_reduce_sum(local_num_pruned);
+        num_pruned += pruned;
+        report_progress(
+            {{"k", kcore}, {"pruned", total_num_pruned + num_pruned}});
+        if (pruned == 0) break;
+      }
+
+      total_num_pruned += num_pruned;
+      kcore_size_list.emplace_back(num_nodes - total_num_pruned);
+    }
+
+    // Store the k-core values as vertex property
+    set_vertex_property(g, "kcore", std::move(kcore_table));
+
+    return kcore_size_list;
+  }
+
+  /// computes the core number of every selected vertex in one run and
+  ///   sets property "core"; returns the number of vertices of each core
+  ///   number (i-th item is the number of vertices with core number i).
+  /// \details
+  ///   the distributed algorithm of Montresor et al.: the estimate of a
+  ///   vertex starts at its degree. A vertex sends a changed estimate to
+  ///   its neighbors, which store it next to the neighbor in their sorted
+  ///   neighbor vector. A vertex with new neighbor estimates lowers its
+  ///   estimate to the largest h, such that h neighbors have an estimate of
+  ///   at least h (computed with one bucket per estimate). The estimates
+  ///   converge to the core numbers.
+  std::vector<std::size_t> core_decomposition(std::vector<filter_type> nfilt,
+                                              std::vector<filter_type> efilt) {
+    csr_buffer        scratch;
+    const csr_view    g = graph_index(std::move(efilt), scratch);
+    const std::size_t n = g.num_local();
+
+    nodelst.filter(std::move(nfilt));
+
+    msg::ptr_guard coreStateGuard{core_comp_mg::ptr,
+                                  new core_comp_mg{g, selected_vertices(g)}};
+    core_comp_mg& state = *core_comp_mg::ptr;
+
+    distinct_neighbors(g, state.nbrOffsets, state.nbrs);
+
+    // unselected neighbors never send and count as 0
+    state.nbrEstimate.assign(state.nbrs.size(), 0);
+    state.estimate.assign(n, 0);
+    state.dirty.assign(n, 0);
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (state.selected[i])
+        state.estimate[i] = state.nbrOffsets[i + 1] - state.nbrOffsets[i];
+
+    std::vector<char>        changed = state.selected;
+    std::vector<std::size_t> buckets;
+
+    comm().barrier();
+
+    for (std::size_t round = 0;; ++round) {
+      const std::size_t numChanged = comm().all_reduce_sum(
+          std::size_t(std::count(changed.begin(), changed.end(), 1)));
+
+      if (numChanged == 0) break;
+
+      report_progress({{"round", round}, {"changed", numChanged}});
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!changed[i]) continue;
+
+        for (std::size_t k = state.nbrOffsets[i]; k < state.nbrOffsets[i + 1];
+             ++k) {
+          comm().async(
+              g.owner(state.nbrs[k]),
+              [](vertex_id v, vertex_id u, std::size_t est) -> void {
+                core_comp_mg&     state = *core_comp_mg::ptr;
+                const std::size_t j     = state.graph.local_index(v);
+
+                if (!state.selected[j]) return;
+
+                const auto beg = state.nbrs.begin() + state.nbrOffsets[j];
+                const auto lim = state.nbrs.begin() + state.nbrOffsets[j + 1];
+                const auto pos = std::lower_bound(beg, lim, u);
+
+                assert((pos != lim) && (*pos == u));
+                state.nbrEstimate[pos - state.nbrs.begin()] = est;
+                state.dirty[j]                              = 1;
+              },
+              state.nbrs[k], g.global_id(i), state.estimate[i]);
+        }
+      }
+
+      comm().barrier();
+      std::fill(changed.begin(), changed.end(), 0);
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!state.dirty[i]) continue;
+
+        state.dirty[i] = 0;
+
+        // h-index of the neighbor estimates, capped by the own estimate
+        const std::size_t est = state.estimate[i];
+
+        buckets.assign(est + 1, 0);
+
+        for (std::size_t k = state.nbrOffsets[i]; k < state.nbrOffsets[i + 1];
+             ++k)
+          ++buckets[std::min(state.nbrEstimate[k], est)];
+
+        std::size_t h       = est;
+        std::size_t atLeast = buckets[est];
+
+        while (atLeast < h) atLeast += buckets[--h];
+
+        if (h < est) {
+          state.estimate[i] = h;
+          changed[i]        = 1;
+        }
+      }
+    }
+
+    std::vector<std::optional<std::size_t>> core(n);
+    std::vector<std::size_t>                histogram;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i]) continue;
+
+      core[i] = state.estimate[i];
+
+      if (histogram.size() <= state.estimate[i])
+        histogram.resize(state.estimate[i] + 1, 0);
+
+      ++histogram[state.estimate[i]];
+    }
+
+    histogram.resize(comm().all_reduce(histogram.size(),
+                                       [](std::size_t lhs, std::size_t rhs)
+                                           -> std::size_t {
+                                         return std::max(lhs, rhs);
+                                       }),
+                     0);
+    histogram = comm().all_reduce(
+        histogram,
+        [](const std::vector<std::size_t>& lhs,
+           const std::vector<std::size_t>& rhs) -> std::vector<std::size_t> {
+          std::vector<std::size_t> res{lhs};
+
+          for (std::size_t i = 0; i < rhs.size(); ++i) res[i] += rhs[i];
+
+          return res;
+        });
+
+    set_vertex_property(g, "core", std::move(core));
+    return histogram;
+  }
+
+  /// a breadth-first search from vertex \ref root; sets property
+  ///   "bfs_level" of the reached vertices and returns their number. The
+  ///   unreached selected vertices with edges get the largest size_t as
+  ///   level.
+  /// \details
+  ///   a direction-optimizing search (Beamer et al.): a top-down step
+  ///   sends the neighbors of the frontier vertices to their owners; a
+  ///   bottom-up step replicates the frontier as bitmap over all vertex
+  ///   ids, and each unvisited vertex checks whether one of its parents
+  ///   is in the frontier. The search switches to bottom-up steps when the
+  ///   frontier's edges exceed the unvisited vertices' edges / alpha, and
+  ///   back when the frontier is smaller than the vertices / beta.
+  ///   As before, a directed search follows the edges from target to
+  ///   source. With delegates (see \ref part), all ranks scan a share of
+  ///   the edges of the hubs in the frontier (top-down) or of the
+  ///   unvisited hubs (bottom-up).
+  /// \param levels if not null, receives the statistics of each level
+  /// \param profile if not null, receives the wall time of the top-down
+  ///        and bottom-up steps and the graph_work_counter counters of
+  ///        this rank (see make_graph_work_profile).
+  size_t bfs(std::vector<filter_type> nfilt, std::vector<filter_type> efilt,
+             std::string root, bool undirected = true,
+             std::vector<bfs_level_info>* levels  = nullptr,
+             const partition_options&     part    = {},
+             run_profile*                 profile = nullptr) {
+    using clock = std::chrono::steady_clock;
+    using work  = graph_work_counter;
+
+    static constexpr std::size_t alpha = 14;
+    static constexpr std::size_t beta  = 24;
+
+    run_profile       noProfile;
+    run_profile&      prof = profile ? *profile : noProfile;
+    csr_buffer        scratch;
+    const csr_view    g = graph_index(std::move(efilt), scratch);
+    const std::size_t n = g.num_local();
+
+    nodelst.filter(std::move(nfilt));
+
+    msg::ptr_guard cntStateGuard{
+        bfs_comp_mg::ptr,
+        new bfs_comp_mg{g, selected_vertices(g),
+                        std::vector<std::size_t>(n, bfs_comp_mg::no_level),
+                        {}}};
+    bfs_comp_mg&             state = *bfs_comp_mg::ptr;
+    std::vector<std::size_t> frontier;
+    const csr_delegates      hubs{comm(), g, part.delegateDegree};
+
+    prof.count(work::vertices, n);
+
+    if (vertex_key_owner(root, comm().size()) == comm().rank()) {
+      const vertex_id v = g.find_local(root);
+
+      if ((v != no_vertex) && state.selected[g.local_index(v)]) {
+        state.level[g.local_index(v)] = 0;
+        frontier.push_back(g.local_index(v));
+      }
+    }
+
+    // the edges that a step scans: a top-down step follows the children of
+    // the frontier vertices, a bottom-up step the parents of the unvisited
+    // vertices.
+    auto children = [&g, undirected](std::size_t i) -> std::size_t {
+      return g.in(i).size() + (undirected ? g.out(i).size() : 0);
+    };
+    auto parents = [&g, undirected](std::size_t i) -> std::size_t {
+      return g.out(i).size() + (undirected ? g.in(i).size() : 0);
+    };
+    // returns the hub index of local vertex i, or npos
+    auto hubOf = [&g, &hubs](std::size_t i) -> std::size_t {
+      return hubs.empty() ? csr_delegates::npos : hubs.find(g.global_id(i));
+    };
+
+    const std::size_t numSelected = comm().all_reduce_sum(std::size_t(
+        std::count(state.selected.begin(), state.selected.end(), 1)));
+    std::size_t localUnvisitedEdges = 0;
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (state.selected[i] && (state.level[i] == bfs_comp_mg::no_level))
+        localUnvisitedEdges += parents(i);
+
+    comm().barrier();
+
+    size_t local_total_visited = 0;
+    bool   bottomUp            = false;
+
+    for (size_t level = 0;; ++level) {
+      const std::size_t frontierSize = comm().all_reduce_sum(frontier.size());
+
+      if (frontierSize == 0) break;
+
+      report_progress({{"level", level}, {"frontier", frontierSize}});
+
+      const clock::time_point start = clock::now();
+      std::size_t             frontierEdges = 0;
+
+      for (std::size_t i : frontier) frontierEdges += children(i);
+
+      frontierEdges = comm().all_reduce_sum(frontierEdges);
+
+      const std::size_t unvisitedEdges =
+          comm().all_reduce_sum(localUnvisitedEdges);
+
+      if (!bottomUp && (frontierEdges > unvisitedEdges / alpha))
+        bottomUp = true;
+      else if (bottomUp && (frontierSize < numSelected / beta))
+        bottomUp = false;
+
+      prof.phase(bottomUp ? "bottom-up" : "top-down");
+      local_total_visited += frontier.size();
+
+      std::size_t scanned   = 0;
+      std::size_t delegated = 0;
+
+      if (bottomUp) {
+        // replicate the frontier
+        std::vector<std::uint64_t> bits((g.num_vertices() + 63) / 64, 0);
+
+        for (std::size_t i : frontier) set_bit(bits, g.global_id(i));
+
+        bits = all_reduce_or(comm(), bits);
+
+        auto inFrontier = [&bits](vertex_id v) -> bool {
+          return test_bit(bits, v);
+        };
+
+        // the unvisited hubs, which all ranks check
+        std::vector<std::uint64_t> openHubs = hubs.make_bitmap();
+
+        for (std::size_t i = 0; i < n; ++i) {
+          if (!state.selected[i] || (state.level[i] != bfs_comp_mg::no_level))
+            continue;
+
+          if (const std::size_t h = hubOf(i); h != csr_delegates::npos) {
+            set_bit(openHubs, h);
+            continue;
+          }
+
+          bool found = false;
+
+          for (csr_view::span_type adj : {g.out(i), g.in(i)}) {
+            for (vertex_id parent : adj) {
+              ++scanned;
+
+              if ((found = inFrontier(parent))) break;
+            }
+
+            if (found || !undirected) break;
+          }
+
+          if (!found) continue;
+
+          state.level[i] = level + 1;
+          state.next.push_back(i);
+        }
+
+        if (!hubs.empty()) {
+          openHubs = all_reduce_or(comm(), openHubs);
+
+          std::vector<std::uint64_t> foundHubs = hubs.make_bitmap();
+
+          for (std::size_t h = 0; h < hubs.size(); ++h) {
+            if (!test_bit(openHubs, h)) continue;
+
+            for (csr_view::span_type adj : {hubs.out(h), hubs.in(h)}) {
+              const auto pos = std::find_if(adj.begin(), adj.end(), inFrontier);
+
+              delegated += pos - adj.begin();
+
+              if (pos != adj.end()) {
+                set_bit(foundHubs, h);
+                break;
+              }
+
+              if (!undirected) break;
+            }
+          }
+
+          foundHubs = all_reduce_or(comm(), foundHubs);
+
+          for (std::size_t h = 0; h < hubs.size(); ++h) {
+            const vertex_id v = hubs.hub(h);
+
+            if (!test_bit(foundHubs, h) || (g.owner(v) != comm().rank()))
+              continue;
+
+            state.level[g.local_index(v)] = level + 1;
+            state.next.push_back(g.local_index(v));
+          }
+        }
+      } else {
+        // a vertex is visited once per rank and level
+        auto visits = make_vertex_combiner<std::size_t>(
+            comm(), g, first_update{}, [](vertex_id v, size_t level) -> void {
+              bfs_comp_mg&      state = *bfs_comp_mg::ptr;
+              const std::size_t j     = state.graph.local_index(v);
+
+              ++state.received;
+
+              if (!state.selected[j] ||
+                  (state.level[j] != bfs_comp_mg::no_level))
+                return;
+
+              state.level[j] = level + 1;
+              state.next.push_back(j);
+            });
+
+        // the hubs in the frontier, whose edges all ranks scan
+        std::vector<std::uint64_t> frontierHubs = hubs.make_bitmap();
+
+        for (std::size_t i : frontier) {
+          if (const std::size_t h = hubOf(i); h != csr_delegates::npos) {
+            set_bit(frontierHubs, h);
+            continue;
+          }
+
+          for (csr_view::span_type adj : {g.in(i), g.out(i)}) {
+            for (vertex_id neighbor : adj) visits.add(neighbor, level);
+
+            scanned += adj.size();
+
+            if (!undirected) break;
+          }
+        }
+
+        if (!hubs.empty()) {
+          frontierHubs = all_reduce_or(comm(), frontierHubs);
+
+          for (std::size_t h = 0; h < hubs.size(); ++h) {
+            if (!test_bit(frontierHubs, h)) continue;
+
+            for (csr_view::span_type adj : {hubs.in(h), hubs.out(h)}) {
+              for (vertex_id neighbor : adj) visits.add(neighbor, level);
+
+              delegated += adj.size();
+
+              if (!undirected) break;
+            }
+          }
+        }
+
+        visits.flush();
+        prof.count(work::updates_sent, visits.combined());
+      }
+
+      comm().barrier();
+
+      for (std::size_t i : state.next) localUnvisitedEdges -= parents(i);
+
+      frontier.swap(state.next);
+      state.next.clear();
+      prof.count(work::edges_scanned, scanned + delegated);
+      prof.count(work::delegated_edges, delegated);
+
+      if (levels) {
+        const std::chrono::duration<double> elapsed = clock::now() - start;
+
+        levels->push_back({level, bottomUp, frontierSize,
+                           comm().all_reduce_sum(scanned + delegated),
+                           elapsed.count()});
+      }
+    }
+
+    prof.stop();
+    prof.count(work::updates_received, state.received);
+
+    // as before, the unreached selected vertices with edges get no_level
+    std::vector<std::optional<std::size_t>> levelValues(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+      if ((state.level[i] != bfs_comp_mg::no_level) ||
+          (state.selected[i] && (children(i) > 0)))
+        levelValues[i] = state.level[i];
+
+    set_vertex_property(g, "bfs_level", std::move(levelValues));
+
+    return comm().all_reduce_sum(local_total_visited);
+  }
+
+  /// expands the neighborhood of the vertices \ref seeds (vertex keys) by up
+  ///   to \ref maxDepth hops and returns the induced subgraph on rank 0:
+  ///   the node rows of the reached vertices and the edges between them.
+  /// \details
+  ///   a top-down search over the persistent index, which only visits the
+  ///   frontier: the reached vertices are kept in a hash map, and a step
+  ///   sends the neighbors of the frontier vertices to their owners. Thus,
+  ///   the work grows with the neighborhood, not with the graph. Node
+  ///   filters cost one selection over the node rows, and edge filters a
+  ///   transient index. A directed expansion follows the edges from source
+  ///   to target. The node rows are found by their row->vertex entries; the
+  ///   index stores no edge rows, thus the induced edges are returned as
+  ///   {<source key>: .., <target key>: ..} objects.
+  /// \param maxFrontier if not 0, the expansion stops before a hop that
+  ///        reaches more vertices on all ranks.
+  khop_result k_hop(std::vector<filter_type> nfilt,
+                    std::vector<filter_type> efilt,
+                    const std::vector<std::string>& seeds, std::size_t maxDepth,
+                    bool undirected = true, std::size_t maxFrontier = 0) {
+    csr_buffer     scratch;
+    const csr_view g = graph_index(std::move(efilt), scratch);
+
+    std::vector<char> selected;
+
+    if (!nfilt.empty()) {
+      nodelst.filter(std::move(nfilt));
+      selected = selected_vertices(g);
+    }
+
+    msg::ptr_guard khopStateGuard{khop_mg::ptr,
+                                  new khop_mg{g, std::move(selected)}};
+    khop_mg&                 state = *khop_mg::ptr;
+    std::vector<std::size_t> frontier;
+
+    for (const std::string& seed : seeds) {
+      if (vertex_key_owner(seed, comm().size()) != comm().rank()) continue;
+
+      const vertex_id v = g.find_local(seed);
+
+      if (v == no_vertex) continue;
+
+      const std::size_t i = g.local_index(v);
+
+      if (state.is_selected(i) && state.hops.emplace(i, 0).second)
+        frontier.push_back(i);
+    }
+
+    comm().barrier();
+
+    khop_result res{{comm().all_reduce_sum(frontier.size())}, false, {}, {}};
+
+    for (std::size_t hop = 0; (hop < maxDepth) && (res.levels.back() > 0);
+         ++hop) {
+      // a vertex is visited once per rank and hop
+      auto visits = make_vertex_combiner<std::size_t>(
+          comm(), g, first_update{}, [](vertex_id v, std::size_t hop) -> void {
+            khop_mg&          state = *khop_mg::ptr;
+            const std::size_t j     = state.graph.local_index(v);
+
+            if (state.is_selected(j) && state.hops.emplace(j, hop + 1).second)
+              state.next.push_back(j);
+          });
+
+      for (std::size_t i : frontier) {
+        for (csr_view::span_type adj : {g.out(i), g.in(i)}) {
+          for (vertex_id neighbor : adj) visits.add(neighbor, hop);
+
+          if (!undirected) break;
+        }
+      }
+
+      visits.flush();
+      comm().barrier();
+
+      const std::size_t reached = comm().all_reduce_sum(state.next.size());
+
+      if ((maxFrontier > 0) && (reached > maxFrontier)) {
+        for (std::size_t i : state.next) state.hops.erase(i);
+
+        res.truncated = true;
+        break;
+      }
+
+      res.levels.push_back(reached);
+      frontier.swap(state.next);
+      state.next.clear();
+    }
+
+    if (res.levels.back() == 0) res.levels.pop_back();
+
+    // replicate the ids of the neighborhood, which is small
+    std::vector<vertex_id> reached;
+
+    for (const auto& [i, hops] : state.hops) reached.push_back(g.global_id(i));
+
+    std::sort(reached.begin(), reached.end());
+
+    reached = comm().all_reduce(
+        reached,
+        [](const std::vector<vertex_id>& lhs,
+           const std::vector<vertex_id>& rhs) -> std::vector<vertex_id> {
+          std::vector<vertex_id> res;
+
+          res.reserve(lhs.size() + rhs.size());
+          std::merge(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                     std::back_inserter(res));
+          return res;
+        });
+
+    auto isReached = [&reached](vertex_id v) -> bool {
+      return std::binary_search(reached.begin(), reached.end(), v);
+    };
+
+    // send the rows, vertices, and induced edges to rank 0
+    std::vector<vertex_id>          rowIds;
+    std::vector<boost::json::value> rows;
+
+    for (std::size_t row = 0; row < g.num_rows(); ++row) {
+      const vertex_id v = g.row_vertex(row);
+
+      if ((v == no_vertex) || !isReached(v)) continue;
+
+      rowIds.push_back(v);
+      rows.emplace_back(
+          json_bento::value_to<boost::json::value>(nodelst.at(row)));
+    }
+
+    std::vector<vertex_id>   ids;
+    std::vector<std::size_t> hops;
+    std::vector<std::string> keys;
+    std::vector<vertex_id>   sources;
+    std::vector<vertex_id>   targets;
+
+    for (const auto& [i, hop] : state.hops) {
+      ids.push_back(g.global_id(i));
+      hops.push_back(hop);
+      keys.emplace_back(g.key(i));
+
+      for (vertex_id tgt : g.out(i)) {
+        if (!isReached(tgt)) continue;
+
+        sources.push_back(g.global_id(i));
+        targets.push_back(tgt);
+      }
+    }
+
+    comm().async(
+        0,
+        [](const std::vector<vertex_id>&          rowIds,
+           const std::vector<boost::json::value>& rows,
+           const std::vector<vertex_id>&          ids,
+           const std::vector<std::size_t>&        hops,
+           const std::vector<std::string>&        keys,
+           const std::vector<vertex_id>&          sources,
+           const std::vector<vertex_id>&          targets) -> void {
+          khop_mg& state = *khop_mg::ptr;
+
+          for (std::size_t i = 0; i < rowIds.size(); ++i)
+            state.rows.emplace_back(rowIds[i], rows[i]);
+
+          for (std::size_t i = 0; i < ids.size(); ++i)
+            state.vertices.emplace_back(ids[i], hops[i], keys[i]);
+
+          for (std::size_t i = 0; i < sources.size(); ++i)
+            state.edges.emplace_back(sources[i], targets[i]);
+        },
+        rowIds, rows, ids, hops, keys, sources, targets);
+
+    comm().barrier();
+
+    if (comm().rank() != 0) return res;
+
+    std::sort(state.vertices.begin(), state.vertices.end());
+    std::sort(state.edges.begin(), state.edges.end());
+    std::stable_sort(state.rows.begin(), state.rows.end(),
+                     [](const auto& lhs, const auto& rhs) -> bool {
+                       return lhs.first < rhs.first;
+                     });
+
+    auto vertexOf = [&state](vertex_id v) -> const auto& {
+      auto pos = std::lower_bound(state.vertices.begin(), state.vertices.end(),
+                                  v, [](const auto& el, vertex_id v) -> bool {
+                                    return std::get<0>(el) < v;
+                                  });
+
+      assert((pos != state.vertices.end()) && (std::get<0>(*pos) == v));
+      return *pos;
+    };
+
+    for (auto& [v, row] : state.rows) {
+      if (boost::json::object* fields = row.if_object())
+        (*fields)["hops"] = std::get<1>(vertexOf(v));
+
+      res.nodes.emplace_back(std::move(row));
+    }
+
+    for (const auto& [src, tgt] : state.edges) {
+      boost::json::object edge;
+
+      edge[edgeSrcKey()] = std::get<2>(vertexOf(src));
+      edge[edgeTgtKey()] = std::get<2>(vertexOf(tgt));
+      res.edges.emplace_back(std::move(edge));
+    }
+
+    return res;
+  }
+
+  /// PageRank over the out-edges of the selected vertices; sets property
+  ///   "pagerank" of the selected vertices. With \ref seeds (vertex keys),
+  ///   computes the personalized PageRank, whose random jumps return to
+  ///   the selected seeds instead of all selected vertices.
+  /// \details
+  ///   push-based delta updates: each vertex holds its rank and a residual,
+  ///   the mass it has not yet passed on; the residual starts at
+  ///   (1 - damping) times the jump probability. An iteration moves the
+  ///   residuals above tolerance / #vertices into the ranks and pushes
+  ///   damping times the residual evenly to the out-neighbors; a vertex
+  ///   without selected out-neighbors spreads it over the jump vertices.
+  ///   Smaller residuals stay, so that the work shrinks as the ranks
+  ///   converge. Stops when no vertex pushes or after \ref maxIterations.
+  ///   The ranks sum to 1 - the remaining residual. With delegates (see
+  ///   \ref part), the owner of a hub replicates its share, and all ranks
+  ///   push it along a share of the hub's out-edges.
+  /// \param profile if not null, receives the wall time of the phases and
+  ///        the graph_work_counter counters of this rank (see
+  ///        make_graph_work_profile).
+  pagerank_summary pagerank(std::vector<filter_type> nfilt,
+                            std::vector<filter_type> efilt,
+                            double damping = 0.85, double tolerance = 1e-6,
+                            std::size_t                     maxIterations = 100,
+                            const std::vector<std::string>& seeds   = {},
+                            const partition_options&        part    = {},
+                            run_profile*                    profile = nullptr) {
+    using work = graph_work_counter;
+
+    if (!(damping > 0.0 && damping < 1.0))
+      throw std::invalid_argument{"damping must be in (0, 1)"};
+
+    if (!(tolerance > 0.0))
+      throw std::invalid_argument{"tolerance must be positive"};
+
+    run_profile       noProfile;
+    run_profile&      prof = profile ? *profile : noProfile;
+    csr_buffer        scratch;
+    const csr_view    g    = graph_index(std::move(efilt), scratch);
+    const std::size_t n    = g.num_local();
+    const int         rank = comm().rank();
+
+    nodelst.filter(std::move(nfilt));
+
+    msg::ptr_guard prStateGuard{pagerank_mg::ptr,
+                                new pagerank_mg{g, selected_vertices(g)}};
+    pagerank_mg&        state = *pagerank_mg::ptr;
+    const csr_delegates hubs{comm(), g, part.delegateDegree};
+
+    prof.count(work::vertices, n);
+
+    // returns the hub index of local vertex i, or npos
+    auto hubOf = [&g, &hubs](std::size_t i) -> std::size_t {
+      return hubs.empty() ? csr_delegates::npos : hubs.find(g.global_id(i));
+    };
+
+    state.outdeg.assign(n, 0);
+    state.residual.assign(n, 0.0);
+
+    // the jump vertices
+    std::vector<char> jump;
+
+    if (seeds.empty()) {
+      jump = state.selected;
+    } else {
+      jump.assign(n, 0);
+
+      for (const std::string& seed : seeds) {
+        if (vertex_key_owner(seed, comm().size()) != rank) continue;
+
+        const vertex_id v = g.find_local(seed);
+
+        if ((v != no_vertex) && state.selected[g.local_index(v)])
+          jump[g.local_index(v)] = 1;
+      }
+    }
+
+    const std::size_t numSelected = comm().all_reduce_sum(std::size_t(
+        std::count(state.selected.begin(), state.selected.end(), 1)));
+    const std::size_t numJump = comm().all_reduce_sum(
+        std::size_t(std::count(jump.begin(), jump.end(), 1)));
+
+    if (numJump == 0) {
+      if (!seeds.empty())
+        throw std::runtime_error{"pagerank: no seed vertex is selected"};
+
+      return {0, true, 0.0};
+    }
 
-    nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
     comm().barrier();
+    prof.phase("outdegree");
 
-    auto edgeAction = [&adj_list, undirected, edgeSrcKeyTxt = edgeSrcKey(),
-                       edgeTgtKeyTxt = edgeTgtKey()](
-                          std::size_t                             pos,
-                          const metall_json_lines::accessor_type& val) -> void {
-      const auto src = to_string(get_key(val, edgeTgtKeyTxt));
-      const auto dst = to_string(get_key(val, edgeSrcKeyTxt));
-      adj_list.async_visit_if_exists(
-          src,
-          [](std::string key, std::vector<std::string>& adj, std::string v) {
-            adj.push_back(v);
-            bfs_comp_mg::ptr->level_table[key] = -1;
-          },
-          dst);
+    // count the out-edges to selected vertices
+    auto countOutEdge = [this, &g](vertex_id src, vertex_id target) -> void {
+      comm().async(
+          g.owner(target),
+          [](auto pcomm, vertex_id v, vertex_id src) -> void {
+            pagerank_mg& state = *pagerank_mg::ptr;
 
-      if (!undirected) return;
+            if (!state.selected[state.graph.local_index(v)]) return;
 
-      adj_list.async_visit_if_exists(
-          dst,
-          [](std::string key, std::vector<std::string>& adj, std::string v) {
-            adj.push_back(v);
-            bfs_comp_mg::ptr->level_table[key] = -1;
+            pcomm->async(
+                state.graph.owner(src),
+                [](vertex_id src) -> void {
+                  pagerank_mg& state = *pagerank_mg::ptr;
+
+                  ++state.outdeg[state.graph.local_index(src)];
+                },
+                src);
           },
-          src);
+          target, src);
     };
-    edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
-    comm().barrier();
 
-    if (adj_list.is_mine(root)) {
-      bfs_comp_mg::ptr->level_table[root] = 0;
+    // the selected hubs, whose out-edges all ranks scan
+    std::vector<std::uint64_t> selectedHubs = hubs.make_bitmap();
+    std::size_t                scanned      = 0;
+    std::size_t                delegated    = 0;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i]) continue;
+
+      if (const std::size_t h = hubOf(i); h != csr_delegates::npos) {
+        set_bit(selectedHubs, h);
+        continue;
+      }
+
+      for (vertex_id target : g.out(i)) countOutEdge(g.global_id(i), target);
+
+      scanned += g.out(i).size();
     }
-    comm().cf_barrier();
 
-    size_t local_total_visited = 0;
-    for (size_t level = 0;; ++level) {
-      size_t count = 0;
-      adj_list.for_all([level, &count, &adj_list](
-                           const std::string&        v,
-                           std::vector<std::string>& adj) {
-        auto& current_lv = bfs_comp_mg::ptr->level_table.at(v);
-        if (level != current_lv) return;
-        ++count;
-
-        for (const auto& n : adj) {
-          adj_list.async_visit_if_exists(
-              n,
-              [](std::string v, std::vector<std::string>& adj, size_t level) {
-                auto& current_lv = bfs_comp_mg::ptr->level_table.at(v);
-                if (current_lv == -1) {
-                  current_lv = level + 1;
-                }
-              },
-              level);
+    if (!hubs.empty()) {
+      selectedHubs = all_reduce_or(comm(), selectedHubs);
+
+      for (std::size_t h = 0; h < hubs.size(); ++h) {
+        if (!test_bit(selectedHubs, h)) continue;
+
+        for (vertex_id target : hubs.out(h)) countOutEdge(hubs.hub(h), target);
+
+        delegated += hubs.out(h).size();
+      }
+    }
+
+    comm().barrier();
+    prof.phase("push");
+
+    std::vector<double> score(n, 0.0);
+    const double        threshold = tolerance / numSelected;
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (jump[i]) state.residual[i] = (1.0 - damping) / numJump;
+
+    std::size_t iteration = 0;
+    bool        converged = false;
+    auto        pushes    = make_vertex_combiner<double>(
+        comm(), g, std::plus<double>{}, [](vertex_id v, double share) -> void {
+          pagerank_mg&      state = *pagerank_mg::ptr;
+          const std::size_t j     = state.graph.local_index(v);
+
+          ++state.received;
+
+          if (state.selected[j]) state.residual[j] += share;
+        });
+
+    for (; iteration < maxIterations; ++iteration) {
+      std::size_t         pushing  = 0;
+      double              dangling = 0.0;
+      std::vector<double> hubShares(hubs.size(), 0.0);
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!state.selected[i] || (state.residual[i] <= threshold)) continue;
+
+        const double mass = state.residual[i];
+
+        ++pushing;
+        score[i] += mass;
+        state.residual[i] = 0.0;
+
+        if (state.outdeg[i] == 0) {
+          dangling += damping * mass;
+          continue;
         }
-      });
+
+        const double share = damping * mass / state.outdeg[i];
+
+        if (const std::size_t h = hubOf(i); h != csr_delegates::npos) {
+          hubShares[h] = share;
+          continue;
+        }
+
+        for (vertex_id target : g.out(i)) pushes.add(target, share);
+
+        scanned += g.out(i).size();
+      }
+
+      if (!hubs.empty()) {
+        hubShares = comm().all_reduce(
+            hubShares,
+            [](const std::vector<double>& lhs,
+               const std::vector<double>& rhs) -> std::vector<double> {
+              std::vector<double> res{lhs};
+
+              for (std::size_t i = 0; i < rhs.size(); ++i) res[i] += rhs[i];
+
+              return res;
+            });
+
+        for (std::size_t h = 0; h < hubs.size(); ++h) {
+          if (hubShares[h] == 0.0) continue;
+
+          for (vertex_id target : hubs.out(h)) pushes.add(target, hubShares[h]);
+
+          delegated += hubs.out(h).size();
+        }
+      }
+
+      pushes.flush();
       comm().barrier();
-      local_total_visited += count;
-      if (comm().all_reduce_sum(count) == 0) break;
+
+      if (comm().all_reduce_sum(pushing) == 0) {
+        converged = true;
+        break;
+      }
+
+      dangling = comm().all_reduce_sum(dangling);
+
+      for (std::size_t i = 0; i < n; ++i)
+        if (jump[i]) state.residual[i] += dangling / numJump;
+    }
+
+    prof.stop();
+    prof.count(work::edges_scanned, scanned + delegated);
+    prof.count(work::delegated_edges, delegated);
+    prof.count(work::updates_sent, pushes.combined());
+    prof.count(work::updates_received, state.received);
+
+    double residual = 0.0;
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (state.selected[i]) residual += state.residual[i];
+
+    std::vector<std::optional<double>> values(n);
+
+    for (std::size_t i = 0; i < n; ++i)
+      if (state.selected[i]) values[i] = score[i];
+
+    set_vertex_property(g, "pagerank", std::move(values));
+    return {iteration, converged, comm().all_reduce_sum(residual)};
+  }
+
+  /// counts the triangles of the undirected graph of the selected vertices;
+  ///   sets properties "triangles" and "clustering" (the local clustering
+  ///   coefficient) of the selected vertices.
+  /// \details
+  ///   degree-ordered wedge checking: the vertices are ordered by
+  ///   (degree, id), and each vertex keeps its neighbors that come later in
+  ///   the order (hi), sorted by id. A vertex u sends its hi list once to
+  ///   each owner of hi neighbors v, which intersects it with hi(v); a
+  ///   common neighbor w closes the triangle (u, v, w), which is found only
+  ///   once. Because the ids of a rank are contiguous, the hi neighbors of
+  ///   an owner are a contiguous range of the sorted list.
+  triangle_summary triangles(std::vector<filter_type> nfilt,
+                             std::vector<filter_type> efilt) {
+    csr_buffer        scratch;
+    const csr_view    g    = graph_index(std::move(efilt), scratch);
+    const std::size_t n    = g.num_local();
+    const int         rank = comm().rank();
+
+    nodelst.filter(std::move(nfilt));
+
+    msg::ptr_guard triStateGuard{triangle_mg::ptr,
+                                 new triangle_mg{g, selected_vertices(g)}};
+    triangle_mg& state = *triangle_mg::ptr;
+
+    distinct_neighbors(g, state.nbrOffsets, state.nbrs);
+    state.nbrSelected.assign(state.nbrs.size(), 0);
+    state.nbrDegree.assign(state.nbrs.size(), 0);
+    state.degree.assign(n, 0);
+    state.triangles.assign(n, 0);
+
+    comm().barrier();
+
+    // (1) the neighbors learn which vertices are selected
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i]) continue;
+
+      for (std::size_t k = state.nbrOffsets[i]; k < state.nbrOffsets[i + 1];
+           ++k) {
+        comm().async(
+            g.owner(state.nbrs[k]),
+            [](vertex_id v, vertex_id u) -> void {
+              triangle_mg&      state = *triangle_mg::ptr;
+              const std::size_t j     = state.graph.local_index(v);
+
+              if (!state.selected[j]) return;
+
+              state.nbrSelected[state.neighbor_pos(j, u)] = 1;
+              ++state.degree[j];
+            },
+            state.nbrs[k], g.global_id(i));
+      }
+    }
+
+    comm().barrier();
+
+    // (2) the selected neighbors learn the degrees
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t k = state.nbrOffsets[i]; k < state.nbrOffsets[i + 1];
+           ++k) {
+        if (!state.nbrSelected[k]) continue;
+
+        comm().async(
+            g.owner(state.nbrs[k]),
+            [](vertex_id v, vertex_id u, std::size_t deg) -> void {
+              triangle_mg&      state = *triangle_mg::ptr;
+              const std::size_t j     = state.graph.local_index(v);
+
+              state.nbrDegree[state.neighbor_pos(j, u)] = deg;
+            },
+            state.nbrs[k], g.global_id(i), state.degree[i]);
+      }
+    }
+
+    comm().barrier();
+
+    state.hiOffsets.assign(1, 0);
+
+    for (std::size_t i = 0; i < n; ++i) {
+      const std::pair<std::size_t, vertex_id> self{state.degree[i],
+                                                   g.global_id(i)};
+
+      for (std::size_t k = state.nbrOffsets[i]; k < state.nbrOffsets[i + 1];
+           ++k) {
+        if (state.nbrSelected[k] &&
+            (self < std::make_pair(state.nbrDegree[k], state.nbrs[k])))
+          state.hi.push_back(state.nbrs[k]);
+      }
+
+      state.hiOffsets.push_back(state.hi.size());
+    }
+
+    comm().barrier();
+
+    // (3) wedge checking
+    for (std::size_t i = 0; i < n; ++i) {
+      const auto beg = state.hi.begin() + state.hiOffsets[i];
+      const auto lim = state.hi.begin() + state.hiOffsets[i + 1];
+
+      // a vertex needs two hi neighbors to close a triangle
+      if (lim - beg < 2) continue;
+
+      const std::vector<vertex_id> hi(beg, lim);
+
+      for (auto pos = hi.begin(); pos != hi.end();) {
+        const int  dest = g.owner(*pos);
+        const auto nxt  = std::find_if(pos, hi.end(), [&g, dest](vertex_id v) {
+          return g.owner(v) != dest;
+        });
+
+        comm().async(
+            dest,
+            [](auto pcomm, int src, std::size_t idx,
+               const std::vector<vertex_id>& vs,
+               const std::vector<vertex_id>& uhi) -> void {
+              triangle_mg&           state = *triangle_mg::ptr;
+              const int              self  = pcomm->rank();
+              std::size_t            found = 0;
+              std::vector<vertex_id> common;
+
+              for (vertex_id v : vs) {
+                const std::size_t j = state.graph.local_index(v);
+
+                common.clear();
+                std::set_intersection(
+                    state.hi.begin() + state.hiOffsets[j],
+                    state.hi.begin() + state.hiOffsets[j + 1], uhi.begin(),
+                    uhi.end(), std::back_inserter(common));
+
+                found += common.size();
+                state.triangles[j] += common.size();
+
+                for (vertex_id w : common) {
+                  if (state.graph.owner(w) == self)
+                    ++state.triangles[state.graph.local_index(w)];
+                  else
+                    ++state.remote[w];
+                }
+              }
+
+              if (found == 0) return;
+
+              pcomm->async(
+                  src,
+                  [](std::size_t idx, std::size_t cnt) -> void {
+                    triangle_mg::ptr->triangles[idx] += cnt;
+                  },
+                  idx, found);
+            },
+            rank, i, std::vector<vertex_id>(pos, nxt), hi);
+
+        pos = nxt;
+      }
     }
 
-    auto level_setter = [&adj_list, nodeKeyTxt = nodeKey(), this](
-                            const std::size_t                       index,
-                            const metall_json_lines::accessor_type& val) {
-      const std::string v = to_string(get_key(val, nodeKeyTxt));
+    comm().barrier();
+
+    // (4) the third vertices receive their combined counts
+    for (const auto& [w, cnt] : state.remote) {
       comm().async(
-          adj_list.owner(v),
-          [](auto pcomm, const std::string& v, const int index,
-             ygm::ygm_ptr<metall_graph> pthis, const int src_rank) {
-            if (bfs_comp_mg::ptr->level_table.count(v) == 0) return;
-            pcomm->async(
-                src_rank,
-                [](auto, const size_t level, const int index,
-                   ygm::ygm_ptr<metall_graph> pthis) {
-                  pthis->nodelst.at(index).as_object()["bfs_level"] = level;
-                },
-                bfs_comp_mg::ptr->level_table.at(v), index, pthis);
+          g.owner(w),
+          [](vertex_id w, std::size_t cnt) -> void {
+            triangle_mg& state = *triangle_mg::ptr;
+
+            state.triangles[state.graph.local_index(w)] += cnt;
           },
-          v, index, ptr_this, comm().rank());
-    };
-    nodelst.for_all_selected(level_setter);
+          w, cnt);
+    }
+
     comm().barrier();
 
-    return comm().all_reduce_sum(local_total_visited);
+    std::vector<std::optional<std::size_t>> counts(n);
+    std::vector<std::optional<double>>      clustering(n);
+    std::size_t                             corners = 0;
+    double                                  sumClustering = 0.0;
+
+    for (std::size_t i = 0; i < n; ++i) {
+      if (!state.selected[i]) continue;
+
+      const std::size_t deg = state.degree[i];
+      const double      cc =
+          deg < 2 ? 0.0 : 2.0 * state.triangles[i] / (deg * (deg - 1.0));
+
+      counts[i]     = state.triangles[i];
+      clustering[i] = cc;
+      corners += state.triangles[i];
+      sumClustering += cc;
+    }
+
+    const std::size_t numSelected = comm().all_reduce_sum(std::size_t(
+        std::count(state.selected.begin(), state.selected.end(), 1)));
+
+    corners       = comm().all_reduce_sum(corners);
+    sumClustering = comm().all_reduce_sum(sumClustering);
+
+    set_vertex_property(g, "triangles", std::move(counts));
+    set_vertex_property(g, "clustering", std::move(clustering));
+
+    return {corners / 3, numSelected ? sumClustering / numSelected : 0.0};
   }
 
+  /// writes the selected nodes and edges as JSON lines
+  /// \param singleFile if true, all ranks write into the files
+  ///        <prefix>-node and <prefix>-edge with collective MPI-IO
+  ///        (see collective_line_writer); otherwise, each rank writes
+  ///        <prefix>-node-<rank> and <prefix>-edge-<rank>.
   bool dump(std::vector<filter_type> nfilt, std::vector<filter_type> efilt,
-            const std::string_view& prefix_path) {
-    {
-      const std::string node_path =
-          std::string(prefix_path) + "-node-" + std::to_string(comm().rank());
-      std::ofstream ofs(node_path);
-      auto          nodeAction = [&ofs](const auto, const auto& val) -> void {
-        ofs << val << "\n";
-      };
-      nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
-    }
+            const std::string_view& prefix_path, bool singleFile = false) {
+    const std::string prefix{prefix_path};
+    const std::string suffix =
+        singleFile ? std::string{} : "-" + std::to_string(comm().rank());
 
-    {
-      const std::string edge_path =
-          std::string(prefix_path) + "-edge-" + std::to_string(comm().rank());
-      std::ofstream ofs(edge_path);
-      auto          edgeAction = [&ofs](const auto, const auto& val) -> void {
-        ofs << val << "\n";
-      };
-      edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
+    if (singleFile) {
+      collective_line_writer nodeOut{prefix + "-node" + suffix};
+
+      dump_nodes(std::move(nfilt), [&nodeOut](const auto& val) -> void {
+        nodeOut.write_line(val);
+      });
+      nodeOut.close();
+
+      collective_line_writer edgeOut{prefix + "-edge" + suffix};
+
+      dump_edges(std::move(efilt), [&edgeOut](const auto& val) -> void {
+        edgeOut.write_line(val);
+      });
+      edgeOut.close();
+    } else {
+      std::ofstream nodeOut(prefix + "-node" + suffix);
+
+      dump_nodes(std::move(nfilt), [&nodeOut](const auto& val) -> void {
+        nodeOut << val << "\n";
+      });
+
+      std::ofstream edgeOut(prefix + "-edge" + suffix);
+
+      dump_edges(std::move(efilt), [&edgeOut](const auto& val) -> void {
+        edgeOut << val << "\n";
+      });
     }
+
     comm().cf_barrier();
 
     return true;
   }
 
+#if METALLDATA_USE_PARQUET
+  /// writes the selected nodes and edges into Parquet files, one per rank
+  ///   (<prefix>-node-<rank>.parquet and <prefix>-edge-<rank>.parquet).
+  /// \param nodecols the node columns to write; all columns if empty
+  /// \param edgecols the edge columns to write; all columns if empty
+  /// \return the total number of written nodes and edges
+  std::pair<std::size_t, std::size_t> to_parquet(
+      std::vector<filter_type> nfilt, std::vector<filter_type> efilt,
+      std::string_view prefix_path, const std::vector<std::string>& nodecols,
+      const std::vector<std::string>& edgecols) {
+    const std::string prefix{prefix_path};
+    const std::size_t numnodes =
+        nodelst.filter(std::move(nfilt)).to_parquet(prefix + "-node", nodecols);
+    const std::size_t numedges =
+        edgelst.filter(std::move(efilt)).to_parquet(prefix + "-edge", edgecols);
+
+    return {numnodes, numedges};
+  }
+#endif
+
   static void check_state(metall_manager_type& manager, ygm::comm& comm) {
     std::string_view edge_location_suffix_v{edge_location_suffix};
     std::string_view node_location_suffix_v{node_location_suffix};
@@ -901,14 +2466,378 @@ struct metall_graph {
   }
 
  private:
+  /// passes the selected nodes, with their vertex properties, to \ref out
+  template <class LineSink>
+  void dump_nodes(std::vector<filter_type> nfilt, LineSink out) {
+    std::vector<std::pair<std::string, property_view>> props;
+
+    for (const std::string& name : vertex_properties())
+      props.emplace_back(name, vertex_property_column(name)->view());
+
+    // the property values are added to the rows' objects
+    auto nodeAction = [&out, &props](const std::size_t row,
+                                     const auto&       val) -> void {
+      if (props.empty()) {
+        out(val);
+        return;
+      }
+
+      boost::json::value obj = json_bento::value_to<boost::json::value>(val);
+
+      if (boost::json::object* fields = obj.if_object())
+        for (const auto& [name, view] : props)
+          if (view.contains(row)) (*fields)[name] = view.json_at(row);
+
+      out(obj);
+    };
+
+    nodelst.filter(std::move(nfilt)).for_all_selected(nodeAction);
+  }
+
+  /// passes the selected edges to \ref out
+  template <class LineSink>
+  void dump_edges(std::vector<filter_type> efilt, LineSink out) {
+    auto edgeAction = [&out](const auto, const auto& val) -> void {
+      out(val);
+    };
+
+    edgelst.filter(std::move(efilt)).for_all_selected(edgeAction);
+  }
+
+  /// returns the state of the rows that the persistent index is built from
+  csr_stamp index_stamp() const {
+    return {nodelst.local_size(), nodelst.modification_count(),
+            edgelst.local_size(), edgelst.modification_count()};
+  }
+
+  /// returns the persistent index, if it is current on all ranks.
+  ///   Collective.
+  csr_store_type* current_index() {
+    const bool current = csr && csr->current(index_stamp());
+
+    return comm().all_reduce_sum(std::size_t(!current)) == 0 ? csr : nullptr;
+  }
+
+  /// returns the persistent index; creates it if it does not exist and
+  ///   the datastore is writable.
+  csr_store_type* writable_index() {
+    if (csr || localmgr->read_only()) return csr;
+
+    csr = localmgr->construct<csr_store_type>(csr_location_suffix)(
+        localmgr->get_allocator());
+    return csr;
+  }
+
+  /// label propagation (after Roger's code
+  /// https://lc.llnl.gov/gitlab/metall/ygm-reddit/-/blob/main/bench/reddit_components_labelprop.cpp)
+  /// over vertex ids; needs as many rounds as the longest shortest path.
+  void label_propagation_components(const csr_view& g) {
+    conn_comp_mg& state = *conn_comp_mg::ptr;
+
+    // a vertex receives the smallest label of its neighbors
+    vertex_program<vertex_id, vertex_id, min_update> prog{comm(), g,
+                                                          state.selected};
+
+    prog.values() = std::move(state.label);
+    prog.activate_all();
+
+    prog.run([](auto& prog, std::size_t i,
+                const std::optional<vertex_id>& msg) -> void {
+      vertex_id& cc_id = prog.value(i);
+
+      if (msg) {
+        if (cc_id <= *msg) return;
+
+        cc_id = *msg;
+      }
+
+      // a neighbor with a smaller id has a smaller label already
+      for (csr_view::span_type adj : prog.neighbors(i))
+        for (vertex_id neighbor : adj)
+          if (cc_id < neighbor) prog.send(neighbor, cc_id);
+    });
+
+    state.label = std::move(prog.values());
+  }
+
+  /// FastSV (Zhang et al.): union-find with min-hooking and pointer
+  ///   jumping over the parents (label) of the vertices; needs O(log V)
+  ///   iterations. An iteration (1) sends the changed grandparents to the
+  ///   neighbors, which keep the smallest one (minNeighbor); (2) hooks a
+  ///   vertex and its parent to minNeighbor (aggressive and stochastic
+  ///   hooking), and the vertex to its grandparent (shortcutting);
+  ///   (3) looks up the new grandparents. It stops when no grandparent
+  ///   changes.
+  void union_find_components(const csr_view& g) {
+    conn_comp_mg&     state = *conn_comp_mg::ptr;
+    const std::size_t n     = g.num_local();
+    const int         rank  = comm().rank();
+    std::vector<char> changed = state.selected;
+
+    state.grandparent = state.label;
+    state.minNeighbor.assign(n, no_vertex);
+
+    auto grandparents = make_vertex_combiner<vertex_id>(
+        comm(), g, min_update{}, [](vertex_id v, vertex_id gp) -> void {
+          conn_comp_mg&     state = *conn_comp_mg::ptr;
+          const std::size_t j     = state.graph.local_index(v);
+
+          if (state.selected[j])
+            state.minNeighbor[j] = std::min(state.minNeighbor[j], gp);
+        });
+    auto hooks = make_vertex_combiner<vertex_id>(
+        comm(), g, min_update{}, [](vertex_id p, vertex_id mngf) -> void {
+          conn_comp_mg&     state = *conn_comp_mg::ptr;
+          const std::size_t j     = state.graph.local_index(p);
+
+          state.nextLabel[j] = std::min(state.nextLabel[j], mngf);
+        });
+
+    for (std::size_t round = 0;; ++round) {
+      const std::size_t numChanged = comm().all_reduce_sum(
+          std::size_t(std::count(changed.begin(), changed.end(), 1)));
+
+      if (numChanged == 0) break;
+
+      report_progress({{"round", round}, {"changed", numChanged}});
+
+      // (1) neighbors learn the changed grandparents
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!changed[i]) continue;
+
+        for (csr_view::span_type adj : {g.out(i), g.in(i)})
+          for (vertex_id neighbor : adj)
+            grandparents.add(neighbor, state.grandparent[i]);
+      }
+
+      grandparents.flush();
+      comm().barrier();
+
+      // (2) hooking and shortcutting
+      state.nextLabel = state.label;
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!state.selected[i]) continue;
+
+        const vertex_id mngf = state.minNeighbor[i];
+
+        state.nextLabel[i] =
+            std::min({state.nextLabel[i], mngf, state.grandparent[i]});
+
+        // the parent's parent is the grandparent
+        if (mngf < state.grandparent[i]) hooks.add(state.label[i], mngf);
+      }
+
+      hooks.flush();
+      comm().barrier();
+      state.label.swap(state.nextLabel);
+
+      // (3) look up the grandparents
+      std::vector<vertex_id> previous = state.grandparent;
+
+      for (std::size_t i = 0; i < n; ++i) {
+        if (!state.selected[i]) continue;
+
+        comm().async(
+            g.owner(state.label[i]),
+            [](auto pcomm, vertex_id p, int src, std::size_t idx) -> void {
+              conn_comp_mg& state = *conn_comp_mg::ptr;
+
+              pcomm->async(
+                  src,
+                  [](std::size_t idx, vertex_id gp) -> void {
+                    conn_comp_mg::ptr->grandparent[idx] = gp;
+                  },
+                  idx, state.label[state.graph.local_index(p)]);
+            },
+            state.label[i], rank, i);
+      }
+
+      comm().barrier();
+
+      for (std::size_t i = 0; i < n; ++i)
+        changed[i] = state.grandparent[i] != previous[i];
+    }
+  }
+
+  /// builds an index over the selected node and edge rows. Collective.
+  csr_buffer make_index() {
+    return build_csr(
+        comm(), nodelst.local_size(),
+        [this, nodeKeyTxt = nodeKey()](auto fn) -> void {
+          nodelst.for_all_selected(
+              [&fn, nodeKeyTxt](std::size_t                             row,
+                                const metall_json_lines::accessor_type& val)
+                  -> void { fn(row, to_string(get_key(val, nodeKeyTxt))); });
+        },
+        [this, edgeSrcKeyTxt = edgeSrcKey(),
+         edgeTgtKeyTxt = edgeTgtKey()](auto fn) -> void {
+          edgelst.for_all_selected(
+              [&fn, edgeSrcKeyTxt, edgeTgtKeyTxt](
+                  std::size_t, const metall_json_lines::accessor_type& val)
+                  -> void {
+                fn(to_string(get_key(val, edgeSrcKeyTxt)),
+                   to_string(get_key(val, edgeTgtKeyTxt)));
+              });
+        });
+  }
+
+  /// returns the local vertices of the node rows that pass nodelst's
+  ///   filter (local vertex -> selected). Collective.
+  std::vector<char> selected_vertices(const csr_view& g) {
+    msg::ptr_guard selStateGuard{
+        csr_select_mg::ptr,
+        new csr_select_mg{g, std::vector<char>(g.num_local(), 0)}};
+
+    comm().barrier();
+
+    nodelst.for_all_selected(
+        [this, &g](std::size_t row,
+                   const metall_json_lines::accessor_type&) -> void {
+          const vertex_id v = g.row_vertex(row);
+
+          if (v == no_vertex) return;
+
+          comm().async(
+              g.owner(v),
+              [](vertex_id v) -> void {
+                csr_select_mg& state = *csr_select_mg::ptr;
+
+                state.selected[state.graph.local_index(v)] = 1;
+              },
+              v);
+        });
+
+    comm().barrier();
+    return std::move(csr_select_mg::ptr->selected);
+  }
+
+  /// replaces the column of property \ref name by the values of the
+  ///   vertices (local vertex -> value); a node row receives the value of
+  ///   its vertex. Collective.
+  template <class T>
+  void set_vertex_property(const csr_view& g, const std::string& name,
+                           std::vector<std::optional<T>> values) {
+    using state_type = vertex_property_mg<T>;
+
+    msg::ptr_guard propStateGuard{
+        state_type::ptr,
+        new state_type{g, std::move(values), property_buffer<T>(g.num_rows())}};
+    const int rank = comm().rank();
+
+    comm().barrier();
+
+    for (std::size_t row = 0; row < g.num_rows(); ++row) {
+      const vertex_id v = g.row_vertex(row);
+
+      if (v == no_vertex) continue;
+
+      // Visit the rank that knows the value of v
+      comm().async(
+          g.owner(v),
+          [](auto pcomm, vertex_id v, int src_rank, std::size_t row) {
+            state_type&             state = *state_type::ptr;
+            const std::optional<T>& val =
+                state.values[state.graph.local_index(v)];
+
+            if (!val) return;
+
+            // Send the value to the node owner
+            pcomm->async(
+                src_rank,
+                [](std::size_t row, const T& val) -> void {
+                  state_type::ptr->column.set(row, val);
+                },
+                row, *val);
+          },
+          v, rank, row);
+    }
+
+    comm().barrier();
+    store_vertex_property(name, state_type::ptr->column);
+  }
+
+  /// stores fn(value) of the selected vertices of \ref prog as property
+  ///   \ref name (see set_vertex_property). Collective.
+  template <class Value, class Message, class Combine, class Fn>
+  void set_vertex_property(const std::string&                             name,
+                           const vertex_program<Value, Message, Combine>& prog,
+                           Fn                                             fn) {
+    set_vertex_property(prog.index(), name,
+                        prog.property_values(std::move(fn)));
+  }
+
+  /// returns the state of the rows that the property columns belong to
+  property_stamp property_state() const {
+    return {nodelst.local_size(), nodelst.modification_count()};
+  }
+
+  static std::string property_location(std::string_view name) {
+    return std::string(property_location_prefix).append(name);
+  }
+
+  /// returns the column of property \ref name, or null
+  const property_column_type* find_property(std::string_view name) const {
+    return localmgr->find<property_column_type>(property_location(name).c_str())
+        .first;
+  }
+
+  static std::string subgraph_location(std::string_view name) {
+    return std::string(subgraph_location_prefix).append(name);
+  }
+
+  /// returns subgraph \ref name, or null
+  const subgraph_store_type* find_subgraph(std::string_view name) const {
+    return localmgr->find<subgraph_store_type>(subgraph_location(name).c_str())
+        .first;
+  }
+
+  /// stores \ref column as property \ref name
+  template <class T>
+  void store_vertex_property(const std::string&        name,
+                             const property_buffer<T>& column) {
+    if (localmgr->read_only())
+      throw std::runtime_error{"unable to store vertex property " + name +
+                               " in a read-only datastore"};
+
+    const std::string     location = property_location(name);
+    property_column_type* col =
+        localmgr->find<property_column_type>(location.c_str()).first;
+
+    if (!col) {
+      if (!propnames)
+        propnames = localmgr->construct<key_store_type>(
+            property_names_location)(localmgr->get_allocator());
+
+      col = localmgr->construct<property_column_type>(location.c_str())(
+          localmgr->get_allocator());
+      propnames->emplace_back(
+          metall_string(name.data(), name.size(), localmgr->get_allocator()));
+    }
+
+    col->assign(column, property_state());
+  }
+
   edge_list_type             edgelst;
   node_list_type             nodelst;
-  key_store_type*            keys = nullptr;
+  key_store_type*            keys          = nullptr;
+  csr_store_type*            csr           = nullptr;  ///< null until built
+  key_store_type*            propnames     = nullptr;  ///< null until stored
+  key_store_type*            subgraphnames = nullptr;  ///< null until stored
+  const subgraph_store_type* subgraph      = nullptr;  ///< null if none used
+  metall::manager*           localmgr      = nullptr;
   ygm::ygm_ptr<metall_graph> ptr_this{this};
 
   static constexpr const char* const edge_location_suffix = "edges";
   static constexpr const char* const node_location_suffix = "nodes";
   static constexpr const char* const keys_location_suffix = "keys";
+  static constexpr const char* const csr_location_suffix  = "keys-csr";
+  static constexpr const char* const property_names_location =
+      "vertex-properties";
+  static constexpr const char* const property_location_prefix =
+      "vertex-property-";
+  static constexpr const char* const subgraph_names_location  = "subgraphs";
+  static constexpr const char* const subgraph_location_prefix = "subgraph-";
 
   static constexpr const char* const ERR_CONSTRUCT_KEYS =
       "unable to construct metall_graph::keys object";
@@ -0,0 +1,525 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Scaling benchmark of MetallJsonLines and MetallGraph methods.
+/// Generates a synthetic JSON lines dataset and an R-MAT (Graph500) edge list
+/// at a target scale, and measures:
+///  - read_json: metall_json_lines::read_json_files of the rows
+///  - count, hist: full scans of the rows
+///  - merge: a hash join of the rows with a table of a quarter of their size
+///  - read_edges: metall_graph::read_edge_files, which generates the vertices
+///  - cc, bfs, kcore: connected components, BFS, and core decomposition
+/// In weak scaling mode (-m weak), the number of rows (-n) is per rank and the
+/// graph scale (-g) grows by log2(ranks); in strong scaling mode, both are
+/// totals. Run the benchmark with different numbers of ranks to obtain a
+/// scaling series.
+/// Each operation is repeated (-r); a repetition reports the wall time and
+/// the run_profile of the ranks, i.e., the min, max, mean, and skew of the
+/// phase times and of the counters (merge: messages and bytes sent and
+/// received; bfs: edges scanned and vertex updates sent and received).
+/// The results are written as a JSON document by rank 0; the generated files
+/// (-w) and the datastores (-d) must be on a file system that all ranks
+/// share.
+
+#include <unistd.h>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <random>
+#include <set>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "mg-common.hpp"
+
+#include "MetallJsonLines-merge.hpp"
+
+namespace xpr = experimental;
+namespace bj  = boost::json;
+
+namespace {
+const std::string ALL_OPS =
+    "read_json,count,hist,merge,read_edges,cc,bfs,kcore";
+
+struct option_type {
+  std::string datastore_path;
+  std::string work_path;
+  std::string output_path;
+  std::string mode{"weak"};
+  std::string ops{ALL_OPS};
+  std::size_t num_rows{1 << 20};
+  int         scale{16};
+  int         edge_factor{16};
+  int         repeats{3};
+  uint64_t    seed{123};
+};
+
+/// the generated data of this run
+struct dataset_type {
+  std::size_t              total_rows  = 0;
+  std::size_t              total_keys  = 0;  ///< rows of the merge's rhs
+  int                      scale       = 0;
+  std::size_t              total_edges = 0;
+  std::vector<std::string> row_files;
+  std::vector<std::string> key_files;
+  std::vector<std::string> edge_files;
+  std::string              bfs_root;  ///< a vertex with an edge
+};
+
+/// creates a profile for one repetition of an operation
+using profile_factory = std::function<xpr::run_profile()>;
+
+void print_usage(std::string_view program_name);
+bool parse_options(int argc, char** argv, option_type& option);
+
+/// returns the rows [begin, end) of \ref total that \ref rank generates
+std::pair<std::size_t, std::size_t> share(std::size_t total, int rank,
+                                          int numranks) {
+  const std::size_t base = total / numranks;
+  const std::size_t rest = total % numranks;
+  const std::size_t r    = rank;
+  const std::size_t beg  = r * base + std::min(r, rest);
+
+  return {beg, beg + base + (r < rest)};
+}
+
+/// returns the file of \ref rank for the dataset \ref name; all ranks
+///   return the same list.
+std::vector<std::string> rank_files(const option_type& option,
+                                    std::string_view name, int numranks) {
+  std::vector<std::string> res;
+
+  for (int r = 0; r < numranks; ++r) {
+    std::stringstream path;
+
+    path << option.work_path << "/" << name << "-" << r << ".json";
+    res.push_back(path.str());
+  }
+
+  return res;
+}
+
+/// writes this rank's share of the rows and of the rhs keys of the merge
+void generate_rows(ygm::comm& world, const option_type& option,
+                   dataset_type& data) {
+  static constexpr std::size_t num_groups  = 64;
+  static constexpr std::size_t num_authors = 1 << 20;
+
+  std::mt19937_64                        rng{option.seed + world.rank()};
+  std::uniform_real_distribution<double> uniform;
+
+  {
+    std::ofstream out{data.row_files[world.rank()]};
+    const auto [beg, end] = share(data.total_rows, world.rank(), world.size());
+
+    for (std::size_t i = beg; i < end; ++i) {
+      bj::object row;
+      // log-uniform, so that a few authors have many rows
+      const auto author = std::size_t(
+          std::exp(uniform(rng) * std::log(double(num_authors))));
+
+      row["id"]     = i;
+      row["key"]    = i % data.total_keys;
+      row["group"]  = i % num_groups;
+      row["author"] = "a" + std::to_string(author);
+      row["value"]  = uniform(rng);
+      out << row << '\n';
+    }
+  }
+
+  std::ofstream out{data.key_files[world.rank()]};
+  const auto [beg, end] = share(data.total_keys, world.rank(), world.size());
+
+  for (std::size_t k = beg; k < end; ++k) {
+    bj::object row;
+
+    row["key"]   = k;
+    row["label"] = "label-" + std::to_string(k);
+    out << row << '\n';
+  }
+}
+
+/// writes this rank's share of an R-MAT graph with the Graph500 parameters
+///   (a = 0.57, b = c = 0.19); the vertex ids are scrambled by a bijection,
+///   so that the high-degree vertices are spread over the owner ranks.
+///   Sets the BFS root to the smallest source of the ranks' first edges.
+void generate_edges(ygm::comm& world, const option_type& option,
+                    dataset_type& data) {
+  static constexpr double a = 0.57;
+  static constexpr double b = 0.19;
+  static constexpr double c = 0.19;
+
+  const std::uint64_t mask = (std::uint64_t(1) << data.scale) - 1;
+  auto scramble = [mask](std::uint64_t v) -> std::uint64_t {
+    return (v * 0x9E3779B97F4A7C15ull) & mask;  // odd factor: a bijection
+  };
+
+  std::mt19937_64                        rng{~option.seed + world.rank()};
+  std::uniform_real_distribution<double> uniform;
+  std::ofstream                          out{data.edge_files[world.rank()]};
+  const auto [beg, end] = share(data.total_edges, world.rank(), world.size());
+  std::uint64_t firstSrc = std::numeric_limits<std::uint64_t>::max();
+
+  for (std::size_t e = beg; e < end; ++e) {
+    std::uint64_t u = 0;
+    std::uint64_t v = 0;
+
+    for (int bit = 0; bit < data.scale; ++bit) {
+      const double p = uniform(rng);
+
+      u = (u << 1) | (p >= a + b);
+      v = (v << 1) | (((p >= a) && (p < a + b)) || (p >= a + b + c));
+    }
+
+    bj::object edge;
+
+    edge["u"] = scramble(u);
+    edge["v"] = scramble(v);
+    out << edge << '\n';
+
+    if (e == beg) firstSrc = scramble(u);
+  }
+
+  firstSrc = world.all_reduce(
+      firstSrc, [](std::uint64_t lhs, std::uint64_t rhs) -> std::uint64_t {
+        return std::min(lhs, rhs);
+      });
+  // the generated vertex keys are strings; bfs takes the key's JSON text
+  data.bfs_root = '"' + std::to_string(firstSrc) + '"';
+}
+
+/// runs \ref fn option.repeats times and returns {"op", "repeats": [{
+///   "seconds", "profile"}], "best_seconds"}; the time of a repetition is
+///   taken between barriers, i.e., it is the time of the slowest rank.
+/// \param makeProfile creates the profile that \ref fn records into
+/// \param setup       runs before each repetition, untimed
+boost::json::object measure(ygm::comm& world, const option_type& option,
+                            const std::string& name,
+                            const profile_factory& makeProfile,
+                            const std::function<void(xpr::run_profile&)>& fn,
+                            const std::function<void()>& setup = {}) {
+  using clock = std::chrono::steady_clock;
+
+  bj::array repeats;
+  double    best = std::numeric_limits<double>::infinity();
+
+  for (int i = 0; i < option.repeats; ++i) {
+    xpr::run_profile prof = makeProfile();
+
+    if (setup) setup();
+
+    world.barrier();
+    const clock::time_point start = clock::now();
+
+    fn(prof);
+    world.barrier();
+
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+    bj::object                          rep;
+
+    rep["seconds"] = elapsed.count();
+    rep["profile"] = prof.report(world);
+    repeats.emplace_back(std::move(rep));
+    best = std::min(best, elapsed.count());
+  }
+
+  if (world.rank() == 0)
+    std::cerr << name << ": " << best << " s" << std::endl;
+
+  bj::object res;
+
+  res["op"]           = name;
+  res["best_seconds"] = best;
+  res["repeats"]      = std::move(repeats);
+  return res;
+}
+
+/// a profile that only records the phases
+xpr::run_profile phase_profile() {
+  return xpr::run_profile{std::vector<std::string>{}};
+}
+
+bj::array run_json_lines(ygm::comm& world, const option_type& option,
+                         const std::set<std::string>& ops,
+                         const dataset_type&          data) {
+  static constexpr const char* rows_key   = "rows";
+  static constexpr const char* keys_key   = "keys";
+  static constexpr const char* merged_key = "merged";
+
+  const std::string location = option.datastore_path + "-mjl";
+  bj::array         res;
+
+  remove_directory_and_content(world, location);
+
+  xpr::datastore mm{metall::create_only, location};
+
+  xpr::metall_json_lines::create_new(mm, world,
+                                     {rows_key, keys_key, merged_key});
+
+  xpr::metall_json_lines rows{mm, world, rows_key};
+  xpr::metall_json_lines keys{mm, world, keys_key};
+  xpr::metall_json_lines merged{mm, world, merged_key};
+
+  res.emplace_back(measure(
+      world, option, "read_json", phase_profile,
+      [&](xpr::run_profile& prof) -> void {
+        prof.phase("import");
+        rows.read_json_files(data.row_files);
+      },
+      [&rows]() -> void { rows.clear(); }));
+
+  if (ops.count("count")) {
+    res.emplace_back(measure(world, option, "count", phase_profile,
+                             [&rows](xpr::run_profile& prof) -> void {
+                               prof.phase("scan");
+                               rows.count();
+                             }));
+  }
+
+  if (ops.count("hist")) {
+    res.emplace_back(measure(world, option, "hist", phase_profile,
+                             [&rows](xpr::run_profile& prof) -> void {
+                               prof.phase("scan");
+                               rows.hist("group");
+                             }));
+  }
+
+  if (ops.count("merge")) {
+    keys.read_json_files(data.key_files);
+
+    res.emplace_back(measure(
+        world, option, "merge", xpr::make_join_profile,
+        [&](xpr::run_profile& prof) -> void {
+          xpr::merge(merged, rows, keys, {"key"}, {"key"}, {}, {}, "_l", "_r",
+                     xpr::merge_algorithm::hash, xpr::DEFAULT_BROADCAST_LIMIT,
+                     xpr::DEFAULT_BLOOM_FILTER_LIMIT, {}, &prof);
+        },
+        [&merged]() -> void { merged.clear(); }));
+  }
+
+  return res;
+}
+
+bj::array run_graph(ygm::comm& world, const option_type& option,
+                    const std::set<std::string>& ops,
+                    const dataset_type&          data) {
+  const std::string location = option.datastore_path + "-mg";
+  bj::array         res;
+
+  remove_directory_and_content(world, location);
+
+  xpr::datastore mm{metall::create_only, location};
+
+  xpr::metall_graph::create_new(mm, world, "id", "src", "dst");
+
+  xpr::metall_graph g{mm, world};
+
+  res.emplace_back(measure(
+      world, option, "read_edges", phase_profile,
+      [&](xpr::run_profile& prof) -> void {
+        prof.phase("import");
+        g.read_edge_files(data.edge_files, xpr::metall_graph::json,
+                          {"u", "v"});
+      },
+      [&g]() -> void {
+        g.edges().clear();
+        g.nodes().clear();
+      }));
+
+  if (ops.count("cc")) {
+    res.emplace_back(measure(world, option, "cc", phase_profile,
+                             [&g](xpr::run_profile& prof) -> void {
+                               prof.phase("components");
+                               g.connected_components({}, {});
+                             }));
+  }
+
+  if (ops.count("bfs")) {
+    res.emplace_back(measure(world, option, "bfs",
+                             xpr::make_graph_work_profile,
+                             [&](xpr::run_profile& prof) -> void {
+                               g.bfs({}, {}, data.bfs_root, true, nullptr, {},
+                                     &prof);
+                             }));
+  }
+
+  if (ops.count("kcore")) {
+    res.emplace_back(measure(world, option, "kcore", phase_profile,
+                             [&g](xpr::run_profile& prof) -> void {
+                               prof.phase("decomposition");
+                               g.core_decomposition({}, {});
+                             }));
+  }
+
+  return res;
+}
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  option_type option;
+
+  if (!parse_options(argc, argv, option)) {
+    if (world.rank() == 0) print_usage(argv[0]);
+    return 1;
+  }
+
+  const bool            weak     = (option.mode == "weak");
+  const int             numranks = world.size();
+  std::set<std::string> ops;
+
+  for (std::string_view rest = option.ops; !rest.empty();) {
+    const std::size_t comma = std::min(rest.find(','), rest.size());
+
+    ops.emplace(rest.substr(0, comma));
+    rest.remove_prefix(std::min(comma + 1, rest.size()));
+  }
+
+  dataset_type data;
+
+  data.total_rows  = weak ? option.num_rows * numranks : option.num_rows;
+  data.total_keys  = std::max<std::size_t>(data.total_rows / 4, 1);
+  data.scale       = option.scale;
+  data.scale      += weak ? std::bit_width(unsigned(numranks)) - 1 : 0;
+  data.total_edges = std::size_t(option.edge_factor) << data.scale;
+  data.row_files   = rank_files(option, "rows", numranks);
+  data.key_files   = rank_files(option, "keys", numranks);
+  data.edge_files  = rank_files(option, "edges", numranks);
+
+  const bool mjlOps = ops.count("read_json") || ops.count("count") ||
+                      ops.count("hist") || ops.count("merge");
+  const bool mgOps  = ops.count("read_edges") || ops.count("cc") ||
+                      ops.count("bfs") || ops.count("kcore");
+
+  try {
+    if (world.rank() == 0)
+      std::filesystem::create_directories(option.work_path);
+
+    world.barrier();
+
+    if (mjlOps) generate_rows(world, option, data);
+    if (mgOps) generate_edges(world, option, data);
+
+    world.barrier();
+
+    bj::array results;
+
+    if (mjlOps)
+      for (bj::value& el : run_json_lines(world, option, ops, data))
+        results.emplace_back(std::move(el));
+
+    if (mgOps)
+      for (bj::value& el : run_graph(world, option, ops, data))
+        results.emplace_back(std::move(el));
+
+    if (world.rank() != 0) return 0;
+
+    bj::object config;
+
+    config["mode"]        = option.mode;
+    config["ranks"]       = numranks;
+    config["rows"]        = data.total_rows;
+    config["scale"]       = data.scale;
+    config["edge_factor"] = option.edge_factor;
+    config["edges"]       = data.total_edges;
+    config["repeats"]     = option.repeats;
+    config["seed"]        = option.seed;
+
+    bj::object report;
+
+    report["config"]  = std::move(config);
+    report["results"] = std::move(results);
+
+    if (option.output_path.empty()) {
+      std::cout << report << std::endl;
+    } else {
+      std::ofstream ofs(option.output_path);
+
+      if (!ofs.is_open()) {
+        std::cerr << "Failed to open " << option.output_path << std::endl;
+        return 1;
+      }
+
+      ofs << report << std::endl;
+    }
+  } catch (const std::exception& err) {
+    std::cerr << "rank " << world.rank() << ": " << err.what() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
+
+namespace {
+void print_usage(std::string_view program_name) {
+  std::cerr << "Usage: " << program_name
+            << " -d datastore path prefix -w directory of generated files"
+               " [-m weak|strong] [-n #of rows] [-g graph scale]"
+               " [-e edge factor] [-r #of repeats] [-s seed]"
+               " [-x comma-separated operations] [-o output JSON file path]"
+            << "\n The operations are " << ALL_OPS << "."
+            << "\n The results are written to stdout if -o is not given."
+            << std::endl;
+}
+
+bool parse_options(int argc, char** argv, option_type& option) {
+  int opt;
+
+  while ((opt = getopt(argc, argv, "d:w:m:n:g:e:r:s:x:o:h")) != -1) {
+    switch (opt) {
+      case 'd':
+        option.datastore_path = optarg;
+        break;
+      case 'w':
+        option.work_path = optarg;
+        break;
+      case 'm':
+        option.mode = optarg;
+        break;
+      case 'n':
+        option.num_rows = std::stoull(optarg);
+        break;
+      case 'g':
+        option.scale = std::stoi(optarg);
+        break;
+      case 'e':
+        option.edge_factor = std::stoi(optarg);
+        break;
+      case 'r':
+        option.repeats = std::stoi(optarg);
+        break;
+      case 's':
+        option.seed = std::stoull(optarg);
+        break;
+      case 'x':
+        option.ops = optarg;
+        break;
+      case 'o':
+        option.output_path = optarg;
+        break;
+      case 'h':
+        [[fallthrough]];
+      default:
+        return false;
+    }
+  }
+
+  return !option.datastore_path.empty() && !option.work_path.empty() &&
+         (option.mode == "weak" || option.mode == "strong") &&
+         (option.num_rows > 0) && (option.scale > 0) && (option.scale < 48) &&
+         (option.repeats > 0);
+}
+}  // namespace
@@ -13,6 +13,8 @@ namespace {
 const std::string METHOD_NAME      = "bfs";
 const std::string METHOD_DOCSTRING = "BFS..";
 const std::string BFS_ROOT_ARG     = "root";
+const std::string PROFILE_ARG      = "profile";
+const std::string DELEGATE_ARG     = "delegate_degree";
 // const std::string UNDIRECTED_ARG   = "undirected";
 }  // namespace
 
@@ -23,25 +25,76 @@ int ygm_main(ygm::comm &world, int argc, char **argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
   clip.add_required<std::string>(BFS_ROOT_ARG, "BFS root");
+  clip.add_optional<bool>(
+      PROFILE_ARG,
+      "returns {'visited', 'levels', 'work'}, where levels has the direction "
+      "(top-down or bottom-up), frontier size, scanned edges, and wall time "
+      "of each level, work the per-rank work counts, and method the "
+      "method's phases and per-rank load (see method_profile)",
+      false);
+  clip.add_optional<int>(DELEGATE_ARG,
+                         "the edges of vertices with at least so many edges "
+                         "are scanned by all ranks; 0 disables delegates",
+                         0);
+  add_job_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    const std::string root = clip.get<std::string>(BFS_ROOT_ARG);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
+    const std::string   root   = clip.get<std::string>(BFS_ROOT_ARG);
+    xpr::method_profile method = method_profile_of(world, clip);
+    xpr::job_progress   job    = job_of(clip, dataLocation, METHOD_NAME);
+
+    method.phase("open");
+
+    xpr::datastore    mm{metall::open_only, dataLocation};
     xpr::metall_graph g{mm, world};
-    const auto        res = g.bfs(filter(world.rank(), clip, NODES_SELECTOR),
-                                  filter(world.rank(), clip, EDGES_SELECTOR), root);
+    const bool        profile        = clip.get<bool>(PROFILE_ARG);
+    const int         delegateDegree = clip.get<int>(DELEGATE_ARG);
+
+    use_subgraph(g, clip);
+
+    if (delegateDegree < 0)
+      throw std::invalid_argument{"delegate_degree must not be negative"};
+
+    method.phase("bfs");
+    job.phase("bfs");
+
+    std::vector<xpr::bfs_level_info> levels;
+    xpr::run_profile                 work =
+        profile ? xpr::make_graph_work_profile() : xpr::run_profile{};
+    const auto res = g.bfs(
+        node_filter(world.rank(), clip, g),
+        filter(world.rank(), clip, EDGES_SELECTOR), root, true,
+        profile ? &levels : nullptr,
+        xpr::partition_options{std::size_t(delegateDegree)}, &work);
+    boost::json::object workReport   = work.report(world);
+    boost::json::object methodReport = method.report();
+
+    job.done(res);
 
     if (world.rank() == 0) {
-      clip.to_return(res);
+      if (profile) {
+        boost::json::object stats;
+        boost::json::array  levelStats;
+
+        for (const xpr::bfs_level_info& el : levels)
+          levelStats.emplace_back(el.asJson());
+
+        stats["visited"] = res;
+        stats["levels"]  = std::move(levelStats);
+        stats["work"]    = std::move(workReport);
+        stats["method"]  = std::move(methodReport);
+        clip.to_return(std::move(stats));
+      } else {
+        clip.to_return(res);
+      }
     }
   } catch (const std::exception &err) {
     error_code = 1;
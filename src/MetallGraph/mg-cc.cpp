@@ -12,6 +12,7 @@ namespace xpr = experimental;
 namespace {
 const std::string METHOD_NAME      = "connected_components";
 const std::string METHOD_DOCSTRING = "Computes connected components..";
+const std::string ALGORITHM_ARG    = "algorithm";
 }  // namespace
 
 std::size_t countLines(bool skip, bool ignoreFilter,
@@ -30,25 +31,45 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
+  clip.add_optional<std::string>(
+      ALGORITHM_ARG,
+      "{'label_propagation'|'union_find'}; union_find needs O(log V) rounds "
+      "instead of rounds proportional to the diameter",
+      "label_propagation");
+  add_profile_argument(clip);
+  add_job_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
-    xpr::metall_graph g{mm, world};
+    xpr::method_profile prof = method_profile_of(world, clip);
+    xpr::job_progress   job  = job_of(clip, dataLocation, METHOD_NAME);
+
+    prof.phase("open");
+
+    xpr::datastore          mm{metall::open_only, dataLocation};
+    xpr::metall_graph       g{mm, world};
+    const xpr::cc_algorithm alg =
+        xpr::to_cc_algorithm(clip.get<std::string>(ALGORITHM_ARG));
+
+    use_subgraph(g, clip);
+
+    prof.track(dataLocation);
+    prof.phase("components");
+    job.phase("components");
+
     const std::size_t res =
-        g.connected_components(filter(world.rank(), clip, NODES_SELECTOR),
-                               filter(world.rank(), clip, EDGES_SELECTOR));
+        g.connected_components(node_filter(world.rank(), clip, g),
+                               filter(world.rank(), clip, EDGES_SELECTOR),
+                               alg);
 
-    if (world.rank() == 0) {
-      clip.to_return(res);
-    }
+    job.done(res);
+    return_profiled(world, clip, prof, res, "components");
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
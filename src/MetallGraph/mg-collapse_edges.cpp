@@ -0,0 +1,73 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph collapse_edges method, which combines
+///        multi-edges into one edge.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "collapse_edges";
+const std::string METHOD_DOCSTRING =
+    "Replaces the edges with the same source and target by one edge that "
+    "has the number of combined edges and aggregates of their columns; "
+    "other columns are dropped. The selection is ignored.";
+
+const std::string ARG_AGG_NAME = "agg";
+const std::string ARG_AGG_DESC =
+    "object mapping a column to an aggregate function: sum, min, or max; "
+    "the aggregate is stored under the column's name";
+
+const std::string ARG_COUNT_COLUMN_NAME = "count_column";
+const std::string ARG_COUNT_COLUMN_DESC =
+    "column that receives the number of combined edges (none if empty); "
+    "an edge that has a count counts as that many edges";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  clip.add_optional<boost::json::object>(ARG_AGG_NAME, ARG_AGG_DESC,
+                                         boost::json::object{});
+  clip.add_optional<std::string>(ARG_COUNT_COLUMN_NAME, ARG_COUNT_COLUMN_DESC,
+                                 "count");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::vector<xpr::aggregate_spec> aggs =
+        aggregate_specs(clip.get<boost::json::object>(ARG_AGG_NAME));
+
+    xpr::datastore    mm{metall::open_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+    const std::size_t before = g.edges().count();
+    const std::size_t after  = g.collapse_edges(
+        aggs, clip.get<std::string>(ARG_COUNT_COLUMN_NAME));
+
+    if (world.rank() == 0) {
+      boost::json::object res;
+
+      res["edges_before"] = before;
+      res["edges"]        = after;
+
+      clip.to_return(res);
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
@@ -1,3 +1,5 @@
+#include <map>
+#include <memory>
 
 #include "mjl-common.hpp"
 #include "MetallGraph.hpp"
@@ -6,4 +8,81 @@ namespace {
 const std::string MG_CLASS_NAME  = "MetallGraph";
 const std::string NODES_SELECTOR = "nodes";
 const std::string EDGES_SELECTOR = "edges";
+
+const std::string ARG_SUBGRAPH_NAME = "subgraph";
+const std::string ARG_SUBGRAPH_DESC =
+    "name of a subgraph (see create_subgraph) to which the method is "
+    "restricted; its index is used instead of filtering all rows";
+
+/// returns the current vertex property columns of \ref g as columns that
+///   node filters can refer to (e.g., nodes.kcore)
+CXX_MAYBE_UNUSED
+external_columns vertex_property_columns(const experimental::metall_graph& g) {
+  namespace xpr = experimental;
+
+  using column_map =
+      std::map<std::string, const xpr::metall_graph::property_column_type*,
+               std::less<>>;
+
+  auto columns = std::make_shared<column_map>();
+
+  for (const std::string& name : g.vertex_properties())
+    (*columns)[name] = g.vertex_property_column(name);
+
+  if (columns->empty()) return {};
+
+  external_columns res;
+
+  res.contains = [columns](std::string_view col) -> bool {
+    return columns->find(col) != columns->end();
+  };
+
+  res.value = [columns](std::string_view col,
+                        std::size_t      row) -> json_logic::ValueExpr {
+    const xpr::property_view view = columns->find(col)->second->view();
+
+    if (!view.contains(row)) return json_logic::toValueExpr(nullptr);
+
+    switch (view.kind()) {
+      case xpr::property_kind::uint64:
+        return json_logic::toValueExpr(view.uint64_at(row));
+      case xpr::property_kind::int64:
+        return json_logic::toValueExpr(view.int64_at(row));
+      case xpr::property_kind::real:
+        return json_logic::toValueExpr(view.real_at(row));
+      case xpr::property_kind::string: {
+        const std::string_view str = view.string_at(row);
+
+        return json_logic::toValueExpr(
+            boost::json::string(str.data(), str.size()));
+      }
+    }
+
+    return json_logic::toValueExpr(nullptr);
+  };
+
+  return res;
+}
+
+/// returns the node filters of \ref clip, which can also refer to the
+///   vertex properties of \ref g
+CXX_MAYBE_UNUSED
+std::vector<experimental::metall_json_lines::filter_type> node_filter(
+    std::size_t rank, const clippy::clippy& clip,
+    const experimental::metall_graph& g) {
+  return filter(rank, clip, NODES_SELECTOR, vertex_property_columns(g));
+}
+
+/// adds the subgraph argument (see use_subgraph)
+CXX_MAYBE_UNUSED
+void add_subgraph_argument(clippy::clippy& clip) {
+  clip.add_optional<std::string>(ARG_SUBGRAPH_NAME, ARG_SUBGRAPH_DESC, "");
+}
+
+/// restricts \ref g to the subgraph named by the subgraph argument, if any;
+///   must be called before the filters of \ref clip are set.
+CXX_MAYBE_UNUSED
+void use_subgraph(experimental::metall_graph& g, const clippy::clippy& clip) {
+  g.use_subgraph(clip.get<std::string>(ARG_SUBGRAPH_NAME));
+}
 }  // namespace
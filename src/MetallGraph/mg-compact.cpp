@@ -0,0 +1,59 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph compact method.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "compact";
+const std::string METHOD_DOCSTRING =
+    "Rewrites the vertex and edge rows of each rank into freshly allocated, "
+    "densely packed storage and releases the memory left behind by "
+    "modifications. The selection is ignored.";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    xpr::datastore    mm{metall::open_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+    const bool        compacted = g.compact();
+
+    if (world.all_reduce_sum(std::size_t(!compacted)) != 0)
+      throw std::runtime_error{"unable to compact (read-only datastore)"};
+
+    const std::size_t numNodes = g.nodes().count();
+    const std::size_t numEdges = g.edges().count();
+
+    if (world.rank() == 0) {
+      boost::json::object res;
+
+      res["nodes"] = numNodes;
+      res["edges"] = numEdges;
+
+      clip.to_return(res);
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
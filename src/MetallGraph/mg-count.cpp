@@ -15,6 +15,23 @@ const std::string METHOD_DOCSTRING =
     "Counts the number of rows where the current selection criteria is true. "
     "Edges are counted only if their endpoints are both in the counted "
     "vertices set.";
+
+const std::string ARG_DETAILED_NAME = "detailed";
+const std::string ARG_DETAILED_DESC =
+    "if true, the result also has the per-rank storage breakdown of the "
+    "vertex and edge rows (see MetallJsonLines info)";
+
+const std::string ARG_APPROXIMATE_NAME = "approximate";
+const std::string ARG_APPROXIMATE_DESC =
+    "if true, the vertices are estimated as the distinct keys of the "
+    "selected vertices and edge endpoints (HyperLogLog), and all selected "
+    "edges are counted; this takes one scan and does not build the graph "
+    "index";
+
+const std::string ARG_PRECISION_NAME = "precision";
+const std::string ARG_PRECISION_DESC =
+    "precision of the approximate count in [4, 18]; the relative error is "
+    "about 1.04 / sqrt(2^precision)";
 }  // namespace
 
 std::size_t countLines(bool skip, bool ignoreFilter,
@@ -33,26 +50,50 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
+  clip.add_optional<bool>(ARG_DETAILED_NAME, ARG_DETAILED_DESC, false);
+  clip.add_optional<bool>(ARG_APPROXIMATE_NAME, ARG_APPROXIMATE_DESC, false);
+  clip.add_optional<int>(ARG_PRECISION_NAME, ARG_PRECISION_DESC,
+                         xpr::hyperloglog::DEFAULT_PRECISION);
+  add_profile_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager        mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
-    xpr::metall_graph     g{mm, world};
+    xpr::method_profile prof = method_profile_of(world, clip);
+
+    prof.phase("open");
+
+    xpr::datastore    mm{metall::open_read_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+    const bool        approximate = clip.get<bool>(ARG_APPROXIMATE_NAME);
+
+    use_subgraph(g, clip);
+
+    prof.phase("count");
+
     xpr::mg_count_summary res =
-        g.count(filter(world.rank(), clip, NODES_SELECTOR),
-                filter(world.rank(), clip, EDGES_SELECTOR));
+        approximate ? g.approx_count(node_filter(world.rank(), clip, g),
+                                     filter(world.rank(), clip, EDGES_SELECTOR),
+                                     clip.get<int>(ARG_PRECISION_NAME))
+                    : g.count(node_filter(world.rank(), clip, g),
+                              filter(world.rank(), clip, EDGES_SELECTOR));
 
-    if (world.rank() == 0) {
-      clip.to_return(res.asJson());
+    boost::json::object out = res.asJson();
+
+    if (approximate) out["approximate"] = true;
+
+    // count has selected the counted rows of both lists
+    if (clip.get<bool>(ARG_DETAILED_NAME)) {
+      out["node_storage"] = g.nodes().info(true);
+      out["edge_storage"] = g.edges().info(true);
     }
+
+    return_profiled(world, clip, prof, std::move(out));
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
@@ -21,19 +21,21 @@ int ygm_main(ygm::comm &world, int argc, char **argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
+    xpr::datastore    mm{metall::open_only, dataLocation};
     xpr::metall_graph g{mm, world};
-    const auto res = g.count_degree(filter(world.rank(), clip, NODES_SELECTOR),
+
+    use_subgraph(g, clip);
+
+    const auto res = g.count_degree(node_filter(world.rank(), clip, g),
                                     filter(world.rank(), clip, EDGES_SELECTOR));
 
     if (world.rank() == 0) {
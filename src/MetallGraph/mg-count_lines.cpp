@@ -26,11 +26,13 @@ const std::string WO_EDGES_DESC = "if true, edges are not counted";
 
 std::size_t countLines(bool skip, bool ignoreFilter,
                        xpr::metall_json_lines& lines, std::size_t rank,
-                       clippy::clippy& clip, std::string_view selector) {
+                       clippy::clippy& clip, std::string_view selector,
+                       external_columns extcols = {}) {
   if (skip) return 0;
   if (ignoreFilter) return lines.count();
 
-  return lines.filter(filter(rank, clip, selector)).count();
+  return lines.filter(filter(rank, clip, selector, std::move(extcols)))
+      .count();
 }
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
@@ -40,6 +42,7 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
 
   clip.add_optional<bool>(COUNT_ALL_NAME, COUNT_ALL_DESC, false);
   clip.add_optional<bool>(WO_NODES_NAME, WO_NODES_DESC, false);
@@ -50,18 +53,19 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
     const bool        countAll     = clip.get<bool>(COUNT_ALL_NAME);
     const bool        withoutNodes = clip.get<bool>(WO_NODES_NAME);
     const bool        withoutEdges = clip.get<bool>(WO_EDGES_NAME);
-    metall_manager    mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
+    xpr::datastore    mm{metall::open_read_only, dataLocation};
     xpr::metall_graph g{mm, world};
-    const std::size_t numNodes = countLines(withoutNodes, countAll, g.nodes(),
-                                            world.rank(), clip, NODES_SELECTOR);
+
+    use_subgraph(g, clip);
+
+    const std::size_t numNodes =
+        countLines(withoutNodes, countAll, g.nodes(), world.rank(), clip,
+                   NODES_SELECTOR, vertex_property_columns(g));
     const std::size_t numEdges = countLines(withoutEdges, countAll, g.edges(),
                                             world.rank(), clip, EDGES_SELECTOR);
 
@@ -0,0 +1,68 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph create_subgraph method, which stores the
+///        selected vertices and edges as a named subgraph.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "create_subgraph";
+const std::string METHOD_DOCSTRING =
+    "Stores the selected node and edge rows as a named subgraph, together "
+    "with its graph index; the rows are not copied. Methods that are "
+    "called with subgraph=name use the subgraph's index instead of "
+    "filtering all rows. Modifications of the rows make the subgraph stale "
+    "until create_subgraph is called again.";
+
+const std::string ARG_NAME_NAME = "name";
+const std::string ARG_NAME_DESC =
+    "name of the subgraph; replaces an existing subgraph with that name";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  clip.add_required<std::string>(ARG_NAME_NAME, ARG_NAME_DESC);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string name = clip.get<std::string>(ARG_NAME_NAME);
+
+    if (name.empty()) throw std::invalid_argument{"empty subgraph name"};
+
+    xpr::datastore              mm{metall::open_only, dataLocation};
+    xpr::metall_graph           g{mm, world};
+    const xpr::mg_count_summary res =
+        g.create_subgraph(name, node_filter(world.rank(), clip, g),
+                          filter(world.rank(), clip, EDGES_SELECTOR));
+
+    if (world.rank() == 0) {
+      boost::json::object out = res.asJson();
+
+      out["subgraph"] = name;
+      clip.to_return(out);
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
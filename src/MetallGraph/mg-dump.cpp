@@ -13,6 +13,20 @@ namespace {
 const std::string METHOD_NAME      = "dump";
 const std::string METHOD_DOCSTRING = "Dump";
 const std::string DUMP_LOCATION    = "loc";
+
+const std::string ARG_FORMAT_NAME = "format";
+const std::string ARG_FORMAT_DESC =
+    "Output format: json (JSON lines) or parquet (typed columns)";
+
+const std::string ARG_NODE_COLUMNS_NAME = "node_columns";
+const std::string ARG_EDGE_COLUMNS_NAME = "edge_columns";
+const std::string ARG_COLUMNS_DESC =
+    "projection list for parquet output (empty writes all columns)";
+
+const std::string ARG_SINGLE_FILE_NAME = "single_file";
+const std::string ARG_SINGLE_FILE_DESC =
+    "write the nodes and edges of all ranks into one file each "
+    "(<loc>-node, <loc>-edge) with collective MPI-IO (json only)";
 }  // namespace
 
 int ygm_main(ygm::comm &world, int argc, char **argv) {
@@ -22,27 +36,62 @@ int ygm_main(ygm::comm &world, int argc, char **argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
   clip.add_required<std::string>(DUMP_LOCATION, "Dump location (prefix)");
+  clip.add_optional<std::string>(ARG_FORMAT_NAME, ARG_FORMAT_DESC, "json");
+  clip.add_optional<ColumnSelector>(ARG_NODE_COLUMNS_NAME, ARG_COLUMNS_DESC,
+                                    ColumnSelector{});
+  clip.add_optional<ColumnSelector>(ARG_EDGE_COLUMNS_NAME, ARG_COLUMNS_DESC,
+                                    ColumnSelector{});
+  clip.add_optional<bool>(ARG_SINGLE_FILE_NAME, ARG_SINGLE_FILE_DESC, false);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
     const std::string dumpLocation = clip.get<std::string>(DUMP_LOCATION);
-    metall_manager    mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
+    const std::string format       = clip.get<std::string>(ARG_FORMAT_NAME);
+    const bool        singleFile   = clip.get<bool>(ARG_SINGLE_FILE_NAME);
+
+    if (format != "json" && format != "parquet")
+      throw std::invalid_argument{"unknown format: " + format};
+
+    if (singleFile && format != "json")
+      throw std::invalid_argument{"single_file requires the json format"};
+
+    xpr::datastore    mm{metall::open_read_only, dataLocation};
     xpr::metall_graph g{mm, world};
-    const auto        res =
-        g.dump(filter(world.rank(), clip, NODES_SELECTOR),
-               filter(world.rank(), clip, EDGES_SELECTOR), dumpLocation);
+    use_subgraph(g, clip);
+
+    if (format == "parquet") {
+#if METALLDATA_USE_PARQUET
+      const auto [numnodes, numedges] = g.to_parquet(
+          node_filter(world.rank(), clip, g),
+          filter(world.rank(), clip, EDGES_SELECTOR), dumpLocation,
+          clip.get<ColumnSelector>(ARG_NODE_COLUMNS_NAME),
+          clip.get<ColumnSelector>(ARG_EDGE_COLUMNS_NAME));
+
+      if (world.rank() == 0) {
+        boost::json::object res;
+
+        res["nodes"] = numnodes;
+        res["edges"] = numedges;
+        clip.to_return(res);
+      }
+#else
+      throw std::runtime_error{"built without Parquet support"};
+#endif
+    } else {
+      const auto res = g.dump(node_filter(world.rank(), clip, g),
+                              filter(world.rank(), clip, EDGES_SELECTOR),
+                              dumpLocation, singleFile);
 
-    if (world.rank() == 0) {
-      clip.to_return(res);
+      if (world.rank() == 0) {
+        clip.to_return(res);
+      }
     }
   } catch (const std::exception &err) {
     error_code = 1;
@@ -0,0 +1,111 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements generating a synthetic graph into a MetallGraph.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "generate";
+const std::string METHOD_DESC =
+    "Generates a synthetic graph with 2^scale vertices and "
+    "edge_factor * 2^scale edges; the vertex keys are integers.";
+
+const std::string ARG_MODEL_NAME = "model";
+const std::string ARG_MODEL_DESC =
+    "graph model (rmat | erdos_renyi | power_law)";
+const std::string ARG_MODEL_DFLT = "rmat";
+
+const std::string ARG_SCALE_NAME = "scale";
+const std::string ARG_SCALE_DESC = "the graph has 2^scale vertices";
+
+const std::string ARG_EDGE_FACTOR_NAME = "edge_factor";
+const std::string ARG_EDGE_FACTOR_DESC = "number of edges per vertex";
+
+const std::string ARG_RMAT_NAME = "rmat";
+const std::string ARG_RMAT_DESC =
+    "the probabilities a, b, and c of the R-MAT quadrants";
+
+const std::string ARG_EXPONENT_NAME = "exponent";
+const std::string ARG_EXPONENT_DESC =
+    "the exponent of the power-law degree distribution (> 2)";
+
+const std::string ARG_SCRAMBLE_NAME = "scramble";
+const std::string ARG_SCRAMBLE_DESC =
+    "if true, the vertex ids are permuted, so that the ids of high-degree "
+    "vertices are not clustered";
+
+const std::string ARG_SEED_NAME = "seed";
+const std::string ARG_SEED_DESC =
+    "random seed; a seed generates the same graph on the same number of ranks";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int                                error_code = 0;
+  clippy::clippy                     clip{METHOD_NAME, METHOD_DESC};
+  const xpr::graph_generator_options defaults;
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+
+  clip.add_optional<std::string>(ARG_MODEL_NAME, ARG_MODEL_DESC,
+                                 ARG_MODEL_DFLT);
+  clip.add_optional<int>(ARG_SCALE_NAME, ARG_SCALE_DESC, defaults.scale);
+  clip.add_optional<double>(ARG_EDGE_FACTOR_NAME, ARG_EDGE_FACTOR_DESC,
+                            defaults.edgeFactor);
+  clip.add_optional<std::vector<double>>(
+      ARG_RMAT_NAME, ARG_RMAT_DESC,
+      std::vector<double>{defaults.a, defaults.b, defaults.c});
+  clip.add_optional<double>(ARG_EXPONENT_NAME, ARG_EXPONENT_DESC,
+                            defaults.exponent);
+  clip.add_optional<bool>(ARG_SCRAMBLE_NAME, ARG_SCRAMBLE_DESC,
+                          defaults.scramble);
+  clip.add_optional<int>(ARG_SEED_NAME, ARG_SEED_DESC, 0);
+
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string         model = clip.get<std::string>(ARG_MODEL_NAME);
+    const std::vector<double> rmat =
+        clip.get<std::vector<double>>(ARG_RMAT_NAME);
+
+    if ((rmat.size() != 3) || (rmat[0] + rmat[1] + rmat[2] > 1.0))
+      throw std::invalid_argument{ARG_RMAT_NAME +
+                                  " must be three probabilities a, b, c"};
+
+    xpr::graph_generator_options opts;
+
+    opts.model      = xpr::to_graph_model(model);
+    opts.scale      = clip.get<int>(ARG_SCALE_NAME);
+    opts.edgeFactor = clip.get<double>(ARG_EDGE_FACTOR_NAME);
+    opts.a          = rmat[0];
+    opts.b          = rmat[1];
+    opts.c          = rmat[2];
+    opts.exponent   = clip.get<double>(ARG_EXPONENT_NAME);
+    opts.scramble   = clip.get<bool>(ARG_SCRAMBLE_NAME);
+    opts.seed       = clip.get<int>(ARG_SEED_NAME);
+
+    xpr::datastore              mm{metall::open_only, dataLocation};
+    xpr::metall_graph           g{mm, world};
+    const xpr::mg_count_summary summary = g.generate(opts);
+
+    if (world.rank() == 0) {
+      clip.to_return(summary.asJson());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
@@ -22,6 +22,7 @@ int ygm_main(ygm::comm &world, int argc, char **argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
+  add_subgraph_argument(clip);
   clip.add_required<std::string>(COLUMN_NAME, "Column name");
 
   if (clip.parse(argc, argv, world)) {
@@ -29,17 +30,15 @@ int ygm_main(ygm::comm &world, int argc, char **argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
     const std::string colName = clip.get<std::string>(COLUMN_NAME);
-    metall_manager    mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
+    xpr::datastore    mm{metall::open_read_only, dataLocation};
     xpr::metall_graph g{mm, world};
-    const auto        res = g.nodes()
-                         .filter(filter(world.rank(), clip, NODES_SELECTOR))
-                         .hist(colName);
+
+    use_subgraph(g, clip);
+
+    const auto res = g.hist(node_filter(world.rank(), clip, g), colName);
 
     if (world.rank() == 0) {
       clip.to_return(res);
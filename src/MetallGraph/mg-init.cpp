@@ -75,8 +75,6 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   try {
     // the real thing
     // try to create the object
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation = clip.get<std::string>(ST_METALL_LOCATION);
     const ARG_VERTEX_KEY_TYPE vertexKey =
         clip.get<ARG_VERTEX_KEY_TYPE>(ARG_VERTEX_KEY_NAME);
@@ -103,14 +101,12 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
         throw std::runtime_error{missingKeyA + ARG_EDGE_DSTKEY_NAME +
                                  missingKeyZ};
 
-      metall_manager mm{metall::create_only, dataLocation.data(),
-                        MPI_COMM_WORLD};
+      xpr::datastore mm{metall::create_only, dataLocation};
 
       xpr::metall_graph::create_new(mm, world, vertexKey, edgeSrcKey,
                                     edgeDstKey);
     } else {
-      metall_manager mm{metall::open_read_only, dataLocation.data(),
-                        MPI_COMM_WORLD};
+      xpr::datastore mm{metall::open_read_only, dataLocation};
 
       // check that storage is in consistent state
       xpr::metall_graph::check_state(mm, world);
@@ -0,0 +1,64 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements job_status, which reads (waits for, or cancels) a job
+///        of a MetallGraph (see mjl-job_status.cpp).
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "job_status";
+const std::string METHOD_DOCSTRING =
+    "Returns the status of a method that was called with job=name: its "
+    "state (running, done, failed, or cancelled), phase, progress, and the "
+    "result of a finished job. The datastore is not opened, thus the status "
+    "can be read while the job runs.";
+
+const std::string ARG_NAME_NAME = "name";
+const std::string ARG_NAME_DESC = "name of the job";
+
+const std::string ARG_WAIT_NAME = "wait";
+const std::string ARG_WAIT_DESC =
+    "seconds to wait for the job to end before the status is returned";
+
+const std::string ARG_CANCEL_NAME = "cancel";
+const std::string ARG_CANCEL_DESC =
+    "if true, the job is cancelled at its next progress report";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_NAME_NAME, ARG_NAME_DESC);
+  clip.add_optional<double>(ARG_WAIT_NAME, ARG_WAIT_DESC, 0.0);
+  clip.add_optional<bool>(ARG_CANCEL_NAME, ARG_CANCEL_DESC, false);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string name = clip.get<std::string>(ARG_NAME_NAME);
+
+    if (world.rank() == 0)
+      clip.to_return(xpr::query_job(dataLocation, name,
+                                    clip.get<bool>(ARG_CANCEL_NAME),
+                                    clip.get<double>(ARG_WAIT_NAME)));
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
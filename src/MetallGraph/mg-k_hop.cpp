@@ -0,0 +1,81 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph k_hop method.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "k_hop";
+const std::string METHOD_DOCSTRING =
+    "Returns the subgraph induced by the vertices within max_depth hops of "
+    "the seeds\n"
+    "returns {'levels', 'truncated', 'nodes', 'edges'}, where the nodes "
+    "have field 'hops'";
+const std::string SEEDS_ARG        = "seeds";
+const std::string MAX_DEPTH_ARG    = "max_depth";
+const std::string MAX_FRONTIER_ARG = "max_frontier";
+const std::string UNDIRECTED_ARG   = "undirected";
+}  // namespace
+
+int ygm_main(ygm::comm &world, int argc, char **argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  add_subgraph_argument(clip);
+  clip.add_required<std::vector<std::string> >(SEEDS_ARG,
+                                               "vertex keys of the seeds");
+  clip.add_optional<int>(MAX_DEPTH_ARG, "maximum number of hops", 2);
+  clip.add_optional<int>(
+      MAX_FRONTIER_ARG,
+      "stops before a hop that reaches more vertices; 0 is unbounded", 0);
+  clip.add_optional<bool>(UNDIRECTED_ARG,
+                          "follows the edges in both directions", true);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const int maxDepth    = clip.get<int>(MAX_DEPTH_ARG);
+    const int maxFrontier = clip.get<int>(MAX_FRONTIER_ARG);
+
+    if (maxDepth < 0)
+      throw std::invalid_argument{"max_depth must not be negative"};
+
+    if (maxFrontier < 0)
+      throw std::invalid_argument{"max_frontier must not be negative"};
+
+    xpr::datastore    mm{metall::open_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+
+    use_subgraph(g, clip);
+
+    const auto res =
+        g.k_hop(node_filter(world.rank(), clip, g),
+                filter(world.rank(), clip, EDGES_SELECTOR),
+                clip.get<std::vector<std::string> >(SEEDS_ARG), maxDepth,
+                clip.get<bool>(UNDIRECTED_ARG), maxFrontier);
+
+    if (world.rank() == 0) {
+      clip.to_return(res.asJson());
+    }
+  } catch (const std::exception &err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
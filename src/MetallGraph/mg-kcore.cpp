@@ -10,9 +10,10 @@
 namespace xpr = experimental;
 
 namespace {
-const std::string METHOD_NAME      = "kcore";
-const std::string METHOD_DOCSTRING = "K core..";
-const std::string MAX_K_ARG        = "k";
+const std::string METHOD_NAME       = "kcore";
+const std::string METHOD_DOCSTRING  = "K core..";
+const std::string MAX_K_ARG         = "k";
+const std::string DECOMPOSITION_ARG = "decomposition";
 }  // namespace
 
 int ygm_main(ygm::comm &world, int argc, char **argv) {
@@ -22,26 +23,49 @@ int ygm_main(ygm::comm &world, int argc, char **argv) {
   clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
-  clip.add_required<unsigned int>(MAX_K_ARG, "Max k-core value to compute");
+  add_subgraph_argument(clip);
+  clip.add_optional<unsigned int>(MAX_K_ARG, "Max k-core value to compute",
+                                  0);
+  clip.add_optional<bool>(
+      DECOMPOSITION_ARG,
+      "computes the core number of every vertex in one run and sets 'core'; "
+      "returns the number of vertices of each core number (k is ignored)",
+      false);
+  add_profile_argument(clip);
+  add_job_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    const unsigned int max_k = clip.get<unsigned int>(MAX_K_ARG);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
+    const unsigned int  max_k = clip.get<unsigned int>(MAX_K_ARG);
+    xpr::method_profile prof  = method_profile_of(world, clip);
+    xpr::job_progress   job   = job_of(clip, dataLocation, METHOD_NAME);
+
+    prof.phase("open");
+
+    xpr::datastore    mm{metall::open_only, dataLocation};
     xpr::metall_graph g{mm, world};
-    const auto        res = g.kcore(filter(world.rank(), clip, NODES_SELECTOR),
-                                    filter(world.rank(), clip, EDGES_SELECTOR), max_k);
+    const bool        decomposition = clip.get<bool>(DECOMPOSITION_ARG);
+
+    use_subgraph(g, clip);
+
+    prof.track(dataLocation);
+    prof.phase("kcore");
+    job.phase("kcore");
+
+    const std::vector<std::size_t> res =
+        decomposition
+            ? g.core_decomposition(node_filter(world.rank(), clip, g),
+                                   filter(world.rank(), clip, EDGES_SELECTOR))
+            : g.kcore(node_filter(world.rank(), clip, g),
+                      filter(world.rank(), clip, EDGES_SELECTOR), max_k);
 
-    if (world.rank() == 0) {
-      clip.to_return(res);
-    }
+    job.done(boost::json::value_from(res));
+    return_profiled(world, clip, prof, res, "cores");
   } catch (const std::exception &err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
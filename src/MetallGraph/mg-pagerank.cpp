@@ -0,0 +1,118 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph pagerank method.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME        = "pagerank";
+const std::string METHOD_DOCSTRING   =
+    "Computes the PageRank of the selected vertices (property 'pagerank'); "
+    "with seeds, computes the personalized PageRank\n"
+    "returns {'iterations', 'converged', 'residual'}";
+const std::string DAMPING_ARG        = "damping";
+const std::string TOLERANCE_ARG      = "tolerance";
+const std::string MAX_ITERATIONS_ARG = "max_iterations";
+const std::string SEEDS_ARG          = "seeds";
+const std::string DELEGATE_ARG       = "delegate_degree";
+const std::string PROFILE_ARG        = "profile";
+}  // namespace
+
+int ygm_main(ygm::comm &world, int argc, char **argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  add_subgraph_argument(clip);
+  clip.add_optional<double>(DAMPING_ARG,
+                            "probability of following an out-edge", 0.85);
+  clip.add_optional<double>(
+      TOLERANCE_ARG,
+      "a vertex pushes its residual when it exceeds tolerance / #vertices",
+      1e-6);
+  clip.add_optional<int>(MAX_ITERATIONS_ARG, "maximum number of iterations",
+                         100);
+  clip.add_optional<std::vector<std::string> >(
+      SEEDS_ARG,
+      "vertex keys of the personalized PageRank's jump targets; empty "
+      "computes the global PageRank",
+      {});
+  clip.add_optional<int>(DELEGATE_ARG,
+                         "the out-edges of vertices with at least so many "
+                         "edges are scanned by all ranks; 0 disables "
+                         "delegates",
+                         0);
+  clip.add_optional<bool>(
+      PROFILE_ARG,
+      "adds 'work', the per-rank wall times and work counts, and 'method', "
+      "the method's phases and per-rank load (see method_profile), to the "
+      "result",
+      false);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const int maxIterations = clip.get<int>(MAX_ITERATIONS_ARG);
+
+    if (maxIterations < 0)
+      throw std::invalid_argument{"max_iterations must not be negative"};
+
+    const int delegateDegree = clip.get<int>(DELEGATE_ARG);
+
+    if (delegateDegree < 0)
+      throw std::invalid_argument{"delegate_degree must not be negative"};
+
+    xpr::method_profile method = method_profile_of(world, clip);
+
+    method.phase("open");
+
+    xpr::datastore    mm{metall::open_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+    use_subgraph(g, clip);
+
+    method.phase("pagerank");
+
+    xpr::run_profile work = clip.get<bool>(PROFILE_ARG)
+                                ? xpr::make_graph_work_profile()
+                                : xpr::run_profile{};
+    const auto       res =
+        g.pagerank(node_filter(world.rank(), clip, g),
+                   filter(world.rank(), clip, EDGES_SELECTOR),
+                   clip.get<double>(DAMPING_ARG),
+                   clip.get<double>(TOLERANCE_ARG), maxIterations,
+                   clip.get<std::vector<std::string> >(SEEDS_ARG),
+                   xpr::partition_options{std::size_t(delegateDegree)}, &work);
+    boost::json::object workReport   = work.report(world);
+    boost::json::object methodReport = method.report();
+
+    if (world.rank() == 0) {
+      boost::json::object stats = res.asJson();
+
+      if (work.enabled()) {
+        stats["work"]   = std::move(workReport);
+        stats["method"] = std::move(methodReport);
+      }
+
+      clip.to_return(std::move(stats));
+    }
+  } catch (const std::exception &err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
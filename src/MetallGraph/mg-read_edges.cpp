@@ -28,9 +28,46 @@ const ARG_AUTO_VERTEX_TYPE ARG_AUTO_VERTEX_DFLT = {};
 
 using ARG_FILE_FORMAT_TYPE             = std::string;
 const std::string ARG_FILE_FORMAT_NAME = "fileType";
-const std::string ARG_FILE_FORMAT_DESC = "file type";
+const std::string ARG_FILE_FORMAT_DESC = "file type (json | parquet | csv)";
 const ARG_FILE_FORMAT_TYPE ARG_FILE_FORMAT_DFLT = "json";
 
+using ARG_CSV_COLUMNS_TYPE = std::vector<std::pair<std::string, std::string>>;
+const std::string ARG_CSV_COLUMNS_NAME = "csvColumns";
+const std::string ARG_CSV_COLUMNS_DESC =
+    "the columns of csv files (pairs of name and type);"
+    "\n  Valid types in (string | int | uint | real | bool | auto | skip).";
+const ARG_CSV_COLUMNS_TYPE ARG_CSV_COLUMNS_DFLT = {};
+
+using ARG_CSV_DELIMITER_TYPE             = std::string;
+const std::string ARG_CSV_DELIMITER_NAME = "csvDelimiter";
+const std::string ARG_CSV_DELIMITER_DESC = "the field delimiter of csv files";
+const ARG_CSV_DELIMITER_TYPE ARG_CSV_DELIMITER_DFLT = ",";
+
+using ARG_CSV_HEADER_TYPE             = bool;
+const std::string ARG_CSV_HEADER_NAME = "csvHeader";
+const std::string ARG_CSV_HEADER_DESC =
+    "skip lines of csv files that list the column names";
+const ARG_CSV_HEADER_TYPE ARG_CSV_HEADER_DFLT = false;
+
+using ARG_COLLAPSE_TYPE             = bool;
+const std::string ARG_COLLAPSE_NAME = "collapse";
+const std::string ARG_COLLAPSE_DESC =
+    "combine the edges with the same source and target into one edge after "
+    "the import (see collapse_edges)";
+const ARG_COLLAPSE_TYPE ARG_COLLAPSE_DFLT = false;
+
+using ARG_COLLAPSE_AGG_TYPE             = boost::json::object;
+const std::string ARG_COLLAPSE_AGG_NAME = "collapseAgg";
+const std::string ARG_COLLAPSE_AGG_DESC =
+    "with collapse, object mapping an edge column to sum, min, or max";
+const ARG_COLLAPSE_AGG_TYPE ARG_COLLAPSE_AGG_DFLT = {};
+
+using ARG_COUNT_COLUMN_TYPE             = std::string;
+const std::string ARG_COUNT_COLUMN_NAME = "countColumn";
+const std::string ARG_COUNT_COLUMN_DESC =
+    "with collapse, the column that receives the number of combined edges";
+const ARG_COUNT_COLUMN_TYPE ARG_COUNT_COLUMN_DFLT = "count";
+
 //~ using                              ARG_AUTO_SRC_VERTEX_TYPE =
 //boost::json::object; ~ const std::string ARG_AUTO_SRC_VERTEX_NAME =
 //"autoSourceVertex"; ~ const std::string ARG_AUTO_SRC_VERTEX_DESC = "a JSON
@@ -57,6 +94,18 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
       ARG_AUTO_VERTEX_NAME, ARG_AUTO_VERTEX_DESC, ARG_AUTO_VERTEX_DFLT);
   clip.add_optional<ARG_FILE_FORMAT_TYPE>(
       ARG_FILE_FORMAT_NAME, ARG_FILE_FORMAT_DESC, ARG_FILE_FORMAT_DFLT);
+  clip.add_optional<ARG_CSV_COLUMNS_TYPE>(
+      ARG_CSV_COLUMNS_NAME, ARG_CSV_COLUMNS_DESC, ARG_CSV_COLUMNS_DFLT);
+  clip.add_optional<ARG_CSV_DELIMITER_TYPE>(
+      ARG_CSV_DELIMITER_NAME, ARG_CSV_DELIMITER_DESC, ARG_CSV_DELIMITER_DFLT);
+  clip.add_optional<ARG_CSV_HEADER_TYPE>(
+      ARG_CSV_HEADER_NAME, ARG_CSV_HEADER_DESC, ARG_CSV_HEADER_DFLT);
+  clip.add_optional<ARG_COLLAPSE_TYPE>(ARG_COLLAPSE_NAME, ARG_COLLAPSE_DESC,
+                                       ARG_COLLAPSE_DFLT);
+  clip.add_optional<ARG_COLLAPSE_AGG_TYPE>(
+      ARG_COLLAPSE_AGG_NAME, ARG_COLLAPSE_AGG_DESC, ARG_COLLAPSE_AGG_DFLT);
+  clip.add_optional<ARG_COUNT_COLUMN_TYPE>(
+      ARG_COUNT_COLUMN_NAME, ARG_COUNT_COLUMN_DESC, ARG_COUNT_COLUMN_DFLT);
   //~ clip.add_optional<ARG_AUTO_SRC_VERTEX_TYPE>(ARG_AUTO_SRC_VERTEX_NAME,
   //ARG_AUTO_SRC_VERTEX_DESC, ARG_AUTO_SRC_VERTEX_DFLT); ~
   //clip.add_optional<ARG_AUTO_TGT_VERTEX_TYPE>(ARG_AUTO_TGT_VERTEX_NAME,
@@ -70,8 +119,6 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const ARG_EDGE_FILES_TYPE edgeFiles =
         clip.get<ARG_EDGE_FILES_TYPE>(ARG_EDGE_FILES_NAME);
     const ARG_AUTO_VERTEX_TYPE edgeVertexFields =
@@ -84,10 +131,41 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
     //clip.get<ARG_AUTO_TGT_VERTEX_TYPE>(ARG_AUTO_TGT_VERTEX_NAME);
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
+    xpr::datastore                mm{metall::open_only, dataLocation};
     xpr::metall_graph             g{mm, world};
     std::vector<std::string_view> edgeVertexFieldsVw{edgeVertexFields.begin(),
                                                      edgeVertexFields.end()};
+    const bool                    collapse =
+        clip.get<ARG_COLLAPSE_TYPE>(ARG_COLLAPSE_NAME);
+    const std::string             countColumn =
+        clip.get<ARG_COUNT_COLUMN_TYPE>(ARG_COUNT_COLUMN_NAME);
+    const std::vector<xpr::aggregate_spec> collapseAggs = aggregate_specs(
+        clip.get<ARG_COLLAPSE_AGG_TYPE>(ARG_COLLAPSE_AGG_NAME));
+
+    // collapses the multi-edges, if requested, and returns the summary
+    auto finish = [&](const xpr::import_summary& summary) -> void {
+      boost::json::object res = summary.asJson();
+
+      if (collapse) res["edges"] = g.collapse_edges(collapseAggs, countColumn);
+
+      if (world.rank() == 0) {
+        clip.to_return(res);
+      }
+    };
+
+    if (fileType == "csv") {
+      const ARG_CSV_DELIMITER_TYPE delim =
+          clip.get<ARG_CSV_DELIMITER_TYPE>(ARG_CSV_DELIMITER_NAME);
+
+      if (delim.size() != 1)
+        throw std::invalid_argument{"csv delimiter must be one character"};
+
+      const xpr::csv_format format = xpr::csv_format::of(
+          clip.get<ARG_CSV_COLUMNS_TYPE>(ARG_CSV_COLUMNS_NAME), delim.front(),
+          clip.get<ARG_CSV_HEADER_TYPE>(ARG_CSV_HEADER_NAME));
+      finish(g.read_edge_files(edgeFiles, format, edgeVertexFieldsVw));
+      return error_code;
+    }
 
     xpr::metall_graph::file_type ftype;
     if (fileType == "json") {
@@ -96,12 +174,7 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
       ftype = xpr::metall_graph::file_type::parquet;
     }
 
-    const xpr::import_summary summary = g.read_edge_files(
-        edgeFiles, ftype, edgeVertexFieldsVw);
-
-    if (world.rank() == 0) {
-      clip.to_return(summary.asJson());
-    }
+    finish(g.read_edge_files(edgeFiles, ftype, edgeVertexFieldsVw));
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
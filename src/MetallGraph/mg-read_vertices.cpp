@@ -44,15 +44,13 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const ARG_VERTEX_FILES_TYPE vertexFiles =
         clip.get<ARG_VERTEX_FILES_TYPE>(ARG_VERTEX_FILES_NAME);
     const ARG_FILE_FORMAT_TYPE fileType =
         clip.get<ARG_FILE_FORMAT_TYPE>(ARG_FILE_FORMAT_NAME);
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
+    xpr::datastore            mm{metall::open_only, dataLocation};
     xpr::metall_graph         g{mm, world};
 
     xpr::metall_graph::file_type ftype;
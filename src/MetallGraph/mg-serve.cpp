@@ -0,0 +1,240 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements a resident service that runs the MetallJsonLines and
+///        MetallGraph methods in one MPI job (see
+///        MetallJsonLines-service.hpp).
+/// \details
+///   mpirun -n <ranks> mg-serve [socket path]
+///   The methods are compiled into this executable: each method source is
+///   included in its own namespace, thus their ygm_main and constants do
+///   not collide. The headers that the methods include are included here
+///   first, so that they are not included into a method's namespace.
+
+#define METALLDATA_SERVICE 1
+
+#include <bit>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "clippy/clippy-eval.hpp"
+#include "clippy/clippy.hpp"
+
+#include "MetallJsonLines-fused.hpp"
+#include "MetallJsonLines-groupby.hpp"
+#include "MetallJsonLines-knn.hpp"
+#include "MetallJsonLines-merge.hpp"
+#include "MetallJsonLines-service.hpp"
+#include "mg-common.hpp"
+
+// clang-format off
+namespace mjl_init        {
+#include "../MetallJsonLines/mjl-init.cpp"
+}
+namespace mjl_read_json   {
+#include "../MetallJsonLines/mjl-read_json.cpp"
+}
+namespace mjl_getitem     {
+#include "../MetallJsonLines/mjl-getitem.cpp"
+}
+namespace mjl_count       {
+#include "../MetallJsonLines/mjl-count.cpp"
+}
+namespace mjl_hist        {
+#include "../MetallJsonLines/mjl-hist.cpp"
+}
+namespace mjl_head        {
+#include "../MetallJsonLines/mjl-head.cpp"
+}
+namespace mjl_info        {
+#include "../MetallJsonLines/mjl-info.cpp"
+}
+namespace mjl_set         {
+#include "../MetallJsonLines/mjl-set.cpp"
+}
+namespace mjl_clear       {
+#include "../MetallJsonLines/mjl-clear.cpp"
+}
+namespace mjl_merge       {
+#include "../MetallJsonLines/mjl-merge.cpp"
+}
+namespace mjl_groupby     {
+#include "../MetallJsonLines/mjl-groupby.cpp"
+}
+namespace mjl_rebalance   {
+#include "../MetallJsonLines/mjl-rebalance.cpp"
+}
+namespace mjl_to_parquet  {
+#include "../MetallJsonLines/mjl-to_parquet.cpp"
+}
+namespace mjl_batch       {
+#include "../MetallJsonLines/mjl-batch.cpp"
+}
+namespace mjl_snapshot    {
+#include "../MetallJsonLines/mjl-snapshot.cpp"
+}
+namespace mjl_open_version {
+#include "../MetallJsonLines/mjl-open_version.cpp"
+}
+namespace mjl_create_index {
+#include "../MetallJsonLines/mjl-create_index.cpp"
+}
+namespace mjl_create_knn_index {
+#include "../MetallJsonLines/mjl-create_knn_index.cpp"
+}
+namespace mjl_knn         {
+#include "../MetallJsonLines/mjl-knn.cpp"
+}
+namespace mjl_compact     {
+#include "../MetallJsonLines/mjl-compact.cpp"
+}
+namespace mjl_share       {
+#include "../MetallJsonLines/mjl-share.cpp"
+}
+namespace mjl_job_status  {
+#include "../MetallJsonLines/mjl-job_status.cpp"
+}
+
+namespace mg_init         {
+#include "mg-init.cpp"
+}
+namespace mg_read_vertices {
+#include "mg-read_vertices.cpp"
+}
+namespace mg_read_edges   {
+#include "mg-read_edges.cpp"
+}
+namespace mg_read_json    {
+#include "mg-read_json.cpp"
+}
+namespace mg_getitem      {
+#include "mg-getitem.cpp"
+}
+namespace mg_count        {
+#include "mg-count.cpp"
+}
+namespace mg_count_lines  {
+#include "mg-count_lines.cpp"
+}
+namespace mg_count_degree {
+#include "mg-count_degree.cpp"
+}
+namespace mg_kcore        {
+#include "mg-kcore.cpp"
+}
+namespace mg_cc           {
+#include "mg-cc.cpp"
+}
+namespace mg_bfs          {
+#include "mg-bfs.cpp"
+}
+namespace mg_pagerank     {
+#include "mg-pagerank.cpp"
+}
+namespace mg_k_hop        {
+#include "mg-k_hop.cpp"
+}
+namespace mg_triangles    {
+#include "mg-triangles.cpp"
+}
+namespace mg_dump         {
+#include "mg-dump.cpp"
+}
+namespace mg_hist         {
+#include "mg-hist.cpp"
+}
+namespace mg_compact      {
+#include "mg-compact.cpp"
+}
+namespace mg_create_subgraph {
+#include "mg-create_subgraph.cpp"
+}
+namespace mg_collapse_edges {
+#include "mg-collapse_edges.cpp"
+}
+namespace mg_share        {
+#include "mg-share.cpp"
+}
+namespace mg_job_status   {
+#include "mg-job_status.cpp"
+}
+// clang-format on
+
+namespace {
+const std::string DEFAULT_SOCKET_PATH = "metalldata.sock";
+
+/// the methods by the names of their executables
+experimental::service_table service_methods() {
+  return {{"mjl-init", mjl_init::ygm_main},
+          {"mjl-read_json", mjl_read_json::ygm_main},
+          {"mjl-getitem", mjl_getitem::ygm_main},
+          {"mjl-count", mjl_count::ygm_main},
+          {"mjl-hist", mjl_hist::ygm_main},
+          {"mjl-head", mjl_head::ygm_main},
+          {"mjl-info", mjl_info::ygm_main},
+          {"mjl-set", mjl_set::ygm_main},
+          {"mjl-clear", mjl_clear::ygm_main},
+          {"mjl-merge", mjl_merge::ygm_main},
+          {"mjl-groupby", mjl_groupby::ygm_main},
+          {"mjl-rebalance", mjl_rebalance::ygm_main},
+          {"mjl-to_parquet", mjl_to_parquet::ygm_main},
+          {"mjl-batch", mjl_batch::ygm_main},
+          {"mjl-snapshot", mjl_snapshot::ygm_main},
+          {"mjl-open_version", mjl_open_version::ygm_main},
+          {"mjl-create_index", mjl_create_index::ygm_main},
+          {"mjl-create_knn_index", mjl_create_knn_index::ygm_main},
+          {"mjl-knn", mjl_knn::ygm_main},
+          {"mjl-compact", mjl_compact::ygm_main},
+          {"mjl-share", mjl_share::ygm_main},
+          {"mjl-job_status", mjl_job_status::ygm_main},
+          {"mg-init", mg_init::ygm_main},
+          {"mg-read_vertices", mg_read_vertices::ygm_main},
+          {"mg-read_edges", mg_read_edges::ygm_main},
+          {"mg-read_json", mg_read_json::ygm_main},
+          {"mg-getitem", mg_getitem::ygm_main},
+          {"mg-count", mg_count::ygm_main},
+          {"mg-count_lines", mg_count_lines::ygm_main},
+          {"mg-count_degree", mg_count_degree::ygm_main},
+          {"mg-kcore", mg_kcore::ygm_main},
+          {"mg-cc", mg_cc::ygm_main},
+          {"mg-bfs", mg_bfs::ygm_main},
+          {"mg-pagerank", mg_pagerank::ygm_main},
+          {"mg-k_hop", mg_k_hop::ygm_main},
+          {"mg-triangles", mg_triangles::ygm_main},
+          {"mg-dump", mg_dump::ygm_main},
+          {"mg-hist", mg_hist::ygm_main},
+          {"mg-compact", mg_compact::ygm_main},
+          {"mg-create_subgraph", mg_create_subgraph::ygm_main},
+          {"mg-collapse_edges", mg_collapse_edges::ygm_main},
+          {"mg-share", mg_share::ygm_main},
+          {"mg-job_status", mg_job_status::ygm_main}};
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+  ygm::comm world(&argc, &argv);
+
+  const std::string path = argc > 1 ? argv[1] : DEFAULT_SOCKET_PATH;
+
+  try {
+    return experimental::serve(world, service_methods(), path);
+  } catch (const std::exception& err) {
+    std::cerr << "mg-serve: " << err.what() << std::endl;
+  }
+
+  return 1;
+}
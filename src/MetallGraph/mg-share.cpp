@@ -0,0 +1,56 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph share method (see mjl-share.cpp).
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "share";
+const std::string METHOD_DOCSTRING =
+    "Makes the datastore shared: concurrent jobs read its latest published "
+    "version, while a job that modifies the graph publishes a new version "
+    "when it ends. The selection is ignored.";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    xpr::datastore    mm{metall::open_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+    const bool        shared   = xpr::writer_lease::share(mm, dataLocation);
+    const std::size_t numNodes = g.nodes().count();
+    const std::size_t numEdges = g.edges().count();
+
+    if (world.rank() == 0) {
+      boost::json::object res;
+
+      res["shared"] = shared;
+      res["nodes"]  = numNodes;
+      res["edges"]  = numEdges;
+
+      clip.to_return(res);
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
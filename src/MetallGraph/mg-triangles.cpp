@@ -0,0 +1,56 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallGraph triangles method.
+
+#include "mg-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "triangles";
+const std::string METHOD_DOCSTRING =
+    "Counts the triangles of the undirected graph of the selected vertices; "
+    "sets 'triangles' and 'clustering' (local clustering coefficient)\n"
+    "returns {'triangles', 'average_clustering'}";
+}  // namespace
+
+int ygm_main(ygm::comm &world, int argc, char **argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MG_CLASS_NAME, "A " + MG_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  add_subgraph_argument(clip);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    xpr::datastore    mm{metall::open_only, dataLocation};
+    xpr::metall_graph g{mm, world};
+
+    use_subgraph(g, clip);
+
+    const auto res = g.triangles(node_filter(world.rank(), clip, g),
+                                 filter(world.rank(), clip, EDGES_SELECTOR));
+
+    if (world.rank() == 0) {
+      clip.to_return(res.asJson());
+    }
+  } catch (const std::exception &err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
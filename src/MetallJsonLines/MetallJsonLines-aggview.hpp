@@ -0,0 +1,402 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Materialized aggregate views: the partial aggregates of groupby,
+///        kept per rank in the Metall datastore.
+/// \details
+///   a view is declared once by its group keys and aggregates. Each rank
+///   stores the number of rows and the partial aggregates of each group of
+///   its local rows; appends (e.g., read_json) extend the views from the
+///   new rows only. hist and groupby over all rows are answered from a
+///   current view by combining the stored partial aggregates, instead of
+///   scanning the rows. As zone maps, a view becomes stale when the rows are
+///   modified otherwise, until it is created again.
+///   The minimum and maximum of a view are kept for numbers; a view whose
+///   column has strings does not answer min and max.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+#include "json_bento/box.hpp"
+
+#include "MetallJsonLines-index.hpp"
+
+namespace experimental {
+
+/// aggregation functions supported by groupby
+enum class aggregate_op : std::uint8_t {
+  count,
+  count_distinct,
+  sum,
+  min,
+  max,
+  mean
+};
+
+/// returns the aggregate_op named \ref name
+inline aggregate_op to_aggregate_op(std::string_view name) {
+  if (name == "count") return aggregate_op::count;
+  if (name == "count_distinct") return aggregate_op::count_distinct;
+  if (name == "sum") return aggregate_op::sum;
+  if (name == "min") return aggregate_op::min;
+  if (name == "max") return aggregate_op::max;
+  if (name == "mean") return aggregate_op::mean;
+
+  throw std::invalid_argument{"unknown aggregation function: " +
+                              std::string(name)};
+}
+
+/// returns the name of \ref op
+inline std::string_view aggregate_op_name(aggregate_op op) {
+  switch (op) {
+    case aggregate_op::count: return "count";
+    case aggregate_op::count_distinct: return "count_distinct";
+    case aggregate_op::sum: return "sum";
+    case aggregate_op::min: return "min";
+    case aggregate_op::max: return "max";
+    case aggregate_op::mean: return "mean";
+  }
+
+  return {};
+}
+
+/// a column to aggregate and how
+using aggregate_spec = std::pair<std::string, aggregate_op>;
+
+/// the group keys and aggregates of a view
+struct aggregate_view_definition {
+  std::vector<std::string>    keys;
+  std::vector<aggregate_spec> aggs;
+
+  /// returns the normalized JSON text of the definition, which names the
+  ///   view
+  std::string text() const {
+    boost::json::array keyList;
+    boost::json::array aggList;
+
+    for (const std::string& key : keys) keyList.emplace_back(key);
+
+    for (const auto& [col, op] : aggs) {
+      const std::string_view name = aggregate_op_name(op);
+
+      aggList.emplace_back(boost::json::array{boost::json::string(col),
+                                              boost::json::string(name)});
+    }
+
+    boost::json::object res;
+
+    res["keys"] = std::move(keyList);
+    res["agg"]  = std::move(aggList);
+    return boost::json::serialize(res);
+  }
+
+  /// returns the definition of the normalized JSON text \ref txt
+  static aggregate_view_definition parse(std::string_view txt) {
+    const boost::json::value   val = boost::json::parse(txt);
+    const boost::json::object& obj = val.as_object();
+    aggregate_view_definition  res;
+
+    for (const boost::json::value& key : obj.at("keys").as_array()) {
+      const boost::json::string& str = key.as_string();
+
+      res.keys.emplace_back(str.data(), str.size());
+    }
+
+    for (const boost::json::value& agg : obj.at("agg").as_array()) {
+      const boost::json::string& col = agg.as_array()[0].as_string();
+      const boost::json::string& op  = agg.as_array()[1].as_string();
+
+      res.aggs.emplace_back(std::string(col.data(), col.size()),
+                            to_aggregate_op({op.data(), op.size()}));
+    }
+
+    return res;
+  }
+};
+
+/// a number, as it is stored for the minimum and maximum of a view
+struct view_number {
+  enum : std::uint8_t { none, int64, uint64, real };
+
+  std::uint8_t  kind = none;
+  std::int64_t  i    = 0;
+  std::uint64_t u    = 0;
+  double        d    = 0;
+
+  double as_real() const {
+    return (kind == int64) ? double(i) : (kind == uint64) ? double(u) : d;
+  }
+
+  /// orders as groupby's min and max: integers exactly, others as doubles
+  bool operator<(const view_number& rhs) const {
+    if ((kind == int64) && (rhs.kind == int64)) return i < rhs.i;
+
+    return as_real() < rhs.as_real();
+  }
+
+  boost::json::value to_json() const {
+    switch (kind) {
+      case int64: return i;
+      case uint64: return u;
+      case real: return d;
+      default: return nullptr;
+    }
+  }
+};
+
+/// the partial aggregate of one column within one group of a view;
+///   as groupby's partial_aggregate, without count_distinct.
+struct view_partial {
+  std::uint64_t count    = 0;  ///< number of values
+  std::uint64_t numcount = 0;  ///< number of numeric values
+  std::int64_t  isum     = 0;  ///< sum of the integers
+  double        dsum     = 0;  ///< sum of all numbers
+  bool          real     = false;  ///< if a double was added
+  view_number   min;
+  view_number   max;
+  std::uint64_t strings = 0;  ///< strings, which min and max do not order
+
+  /// adds a row's value
+  template <class Accessor>
+  void add(aggregate_op op, const Accessor& val) {
+    if (val.is_null()) return;
+
+    ++count;
+
+    switch (op) {
+      case aggregate_op::sum:
+      case aggregate_op::mean:
+        if (val.is_int64()) {
+          isum += val.as_int64();
+          dsum += val.as_int64();
+        } else if (val.is_uint64()) {
+          isum += std::int64_t(val.as_uint64());
+          dsum += val.as_uint64();
+        } else if (val.is_double()) {
+          dsum += val.as_double();
+          real = true;
+        } else {
+          return;
+        }
+
+        ++numcount;
+        return;
+
+      case aggregate_op::min:
+      case aggregate_op::max: {
+        if (val.is_string()) {
+          ++strings;
+          return;
+        }
+
+        view_number num;
+
+        if (val.is_int64())
+          num = {view_number::int64, val.as_int64()};
+        else if (val.is_uint64())
+          num = {view_number::uint64, 0, val.as_uint64()};
+        else if (val.is_double())
+          num = {view_number::real, 0, 0, val.as_double()};
+        else
+          return;
+
+        view_number& cur = (op == aggregate_op::min) ? min : max;
+
+        if ((cur.kind == view_number::none) ||
+            ((op == aggregate_op::min) ? (num < cur) : (cur < num)))
+          cur = num;
+
+        return;
+      }
+
+      default:
+        return;
+    }
+  }
+};
+
+/// the persistent aggregate views of a rank, keyed by definition;
+///   stored next to the local container in the same Metall datastore.
+template <class Alloc>
+class aggregate_view_cache {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+  using offset_vector =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+  using partial_vector =
+      metall::container::vector<view_partial, other_allocator<view_partial>>;
+
+ public:
+  /// the groups of one view
+  class view {
+   public:
+    view(std::string_view def, const allocator_type& alloc)
+        : definition(def.data(), def.size(), alloc),
+          keytext(alloc),
+          keyOffsets(1, 0, alloc),
+          rowCounts(alloc),
+          partials(alloc) {}
+
+    /// the normalized JSON text of the definition
+    std::string_view name() const {
+      return {definition.data(), definition.size()};
+    }
+
+    /// returns true, if the view summarizes rows in state \ref st
+    bool current(const sorted_index_stamp& st) const { return stamp == st; }
+
+    /// marks the rows as summarized in state \ref st
+    void set_state(const sorted_index_stamp& st) { stamp = st; }
+
+    /// drops the groups
+    void clear() {
+      keytext.clear();
+      keyOffsets.assign(1, 0);
+      rowCounts.clear();
+      partials.clear();
+      stamp = {};
+    }
+
+    /// returns the number of groups
+    std::size_t size() const { return rowCounts.size(); }
+
+    /// returns the JSON text of the key of group \ref g
+    std::string_view key(std::size_t g) const {
+      return {keytext.data() + keyOffsets[g],
+              std::size_t(keyOffsets[g + 1] - keyOffsets[g])};
+    }
+
+    /// returns the number of rows of group \ref g
+    std::uint64_t rows(std::size_t g) const { return rowCounts[g]; }
+
+    /// returns the partial aggregate \ref a of group \ref g
+    const view_partial& partial(std::size_t g, std::size_t a,
+                                std::size_t numAggs) const {
+      return partials[g * numAggs + a];
+    }
+
+    /// adds the rows from \ref first of \ref vector
+    template <class Lines>
+    void extend(const Lines& vector, std::size_t first,
+                const aggregate_view_definition& def) {
+      const std::size_t numAggs = def.aggs.size();
+
+      // the group of each key text
+      std::unordered_map<std::string, std::size_t> groups;
+
+      for (std::size_t g = 0; g < size(); ++g) groups.emplace(key(g), g);
+
+      for (std::size_t i = first; i < vector.size(); ++i) {
+        const auto row = vector.at(i);
+
+        if (!row.is_object()) continue;
+
+        const auto         obj = row.as_object();
+        boost::json::array groupkey;
+        bool               complete = true;
+
+        for (const std::string& col : def.keys) {
+          const auto val = obj.if_contains(col);
+
+          if (!val) {
+            complete = false;
+            break;
+          }
+
+          groupkey.emplace_back(json_bento::value_to<boost::json::value>(*val));
+        }
+
+        if (!complete) continue;
+
+        auto [pos, fresh] =
+            groups.try_emplace(boost::json::serialize(groupkey), size());
+
+        if (fresh) {
+          keytext.append(pos->first.data(), pos->first.size());
+          keyOffsets.push_back(keytext.size());
+          rowCounts.push_back(0);
+          partials.resize(partials.size() + numAggs);
+        }
+
+        const std::size_t g = pos->second;
+
+        ++rowCounts[g];
+
+        for (std::size_t a = 0; a < numAggs; ++a)
+          if (const auto val = obj.if_contains(def.aggs[a].first))
+            partials[g * numAggs + a].add(def.aggs[a].second, *val);
+      }
+    }
+
+   private:
+    string_type        definition;
+    string_type        keytext;     ///< the concatenated key texts
+    offset_vector      keyOffsets;  ///< group -> begin of its key text
+    offset_vector      rowCounts;   ///< group -> rows
+    partial_vector     partials;    ///< group * aggregates + aggregate
+    sorted_index_stamp stamp;
+  };
+
+  explicit aggregate_view_cache(const allocator_type& alloc) : entries(alloc) {}
+
+  /// returns the view named \ref name, or nullptr
+  const view* find(std::string_view name) const {
+    for (const view& el : entries)
+      if (el.name() == name) return &el;
+
+    return nullptr;
+  }
+
+  /// returns the view named \ref name; adds an empty one if none exists
+  view& find_or_add(std::string_view name) {
+    for (view& el : entries)
+      if (el.name() == name) return el;
+
+    entries.emplace_back(name, entries.get_allocator());
+    return entries.back();
+  }
+
+  /// calls \ref fn with each view
+  template <class Fn>
+  void for_all_views(Fn fn) {
+    for (view& el : entries) fn(el);
+  }
+
+  /// returns the names of the views
+  std::vector<std::string> names() const {
+    std::vector<std::string> res;
+
+    for (const view& el : entries) res.emplace_back(el.name());
+
+    return res;
+  }
+
+ private:
+  metall::container::vector<view, other_allocator<view>> entries;
+};
+
+}  // namespace experimental
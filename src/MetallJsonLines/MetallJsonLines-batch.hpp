@@ -0,0 +1,373 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "json_bento/box.hpp"
+#include "json_bento/value_from.hpp"
+
+namespace experimental {
+
+/// a batch of flat rows stored column by column: the compact wire format
+///   of rows that are exchanged between ranks.
+/// \details
+///   each column has a type tag, a validity bitmap (value present and not
+///   null), a null bitmap (value is null), and either one 64-bit word per row
+///   (booleans, integers, doubles) or a string offsets array and the string
+///   characters. A column whose values have different types, and columns of
+///   arrays and objects, hold the values' JSON text. A value that is neither
+///   valid nor null is missing, i.e., the row does not have the column.
+///   Columns are either fixed at construction, or added when a row with
+///   a new key is appended.
+class column_batch {
+ public:
+  static constexpr std::size_t npos = std::numeric_limits<std::size_t>::max();
+
+  column_batch() = default;
+
+  /// \param columns the columns to store; if empty, all keys of the appended
+  ///        rows are stored.
+  explicit column_batch(const std::vector<std::string>& columns)
+      : projected(!columns.empty()) {
+    for (const std::string& col : columns) add_column(col);
+  }
+
+  /// appends a row, which is either a json_bento accessor or a
+  ///   boost::json::value. Non-object rows are appended as empty rows.
+  template <class JsonValue>
+  void append(const JsonValue& row) {
+    if (row.is_object()) {
+      const auto& obj = row.as_object();
+
+      if (projected) {
+        for (column& col : cols)
+          if (const auto val = obj.if_contains(col.name)) add_value(col, *val);
+      } else {
+        for (const auto& el : obj) {
+          const std::string_view key = el.key();
+          std::size_t            pos = find_column(key);
+
+          if (pos == npos) pos = add_column(key);
+
+          add_value(cols[pos], el.value());
+        }
+      }
+    }
+
+    for (column& col : cols) pad(col);
+
+    ++numrows;
+  }
+
+  /// returns the number of rows
+  std::size_t size() const { return numrows; }
+
+  /// returns true, if the batch has no rows
+  bool empty() const { return numrows == 0; }
+
+  /// removes all rows; keeps the columns of a projected batch
+  void clear() {
+    numrows = 0;
+
+    if (!projected) {
+      cols.clear();
+      return;
+    }
+
+    for (column& col : cols) col = column{std::move(col.name)};
+  }
+
+  /// returns the approximate number of bytes of the serialized batch
+  std::size_t byte_size() const {
+    std::size_t res = 0;
+
+    for (const column& col : cols)
+      res += col.name.size() +
+             (col.valid.size() + col.nulls.size() + col.fixed.size()) *
+                 sizeof(std::uint64_t) +
+             col.offsets.size() * sizeof(std::uint32_t) + col.chars.size();
+
+    return res;
+  }
+
+  /// returns the number of columns
+  std::size_t num_columns() const { return cols.size(); }
+
+  /// returns the name of column \ref col
+  const std::string& column_name(std::size_t col) const {
+    return cols[col].name;
+  }
+
+  /// returns the index of the column \ref name, or npos if there is none
+  std::size_t find_column(std::string_view name) const {
+    for (std::size_t i = 0; i < cols.size(); ++i)
+      if (cols[i].name == name) return i;
+
+    return npos;
+  }
+
+  /// returns true, if \ref row has a value (incl. null) in column \ref col
+  bool contains(std::size_t col, std::size_t row) const {
+    return test_bit(cols[col].valid, row) || test_bit(cols[col].nulls, row);
+  }
+
+  /// returns the value of column \ref col in \ref row (null if missing)
+  boost::json::value value_at(std::size_t col, std::size_t row) const {
+    const column& c = cols[col];
+
+    if (!test_bit(c.valid, row)) return nullptr;
+
+    switch (c.kind) {
+      case value_kind::boolean:
+        return c.fixed[row] != 0;
+      case value_kind::int64:
+        return std::int64_t(c.fixed[row]);
+      case value_kind::uint64:
+        return c.fixed[row];
+      case value_kind::real:
+        return to_double_bits(c.fixed[row]);
+      case value_kind::string:
+        return string_at(c, row);
+      case value_kind::json:
+        return boost::json::parse(string_at(c, row));
+      default:;
+    }
+
+    return nullptr;
+  }
+
+  /// writes the value of column \ref col in \ref row into a json_bento
+  ///   value, without constructing an intermediate boost::json::value for
+  ///   non-JSON columns.
+  template <class Accessor>
+  void emplace(Accessor store, std::size_t col, std::size_t row) const {
+    const column& c = cols[col];
+
+    if (!test_bit(c.valid, row)) return store.emplace_null();
+
+    switch (c.kind) {
+      case value_kind::boolean:
+        store.emplace_bool() = (c.fixed[row] != 0);
+        return;
+      case value_kind::int64:
+        store.emplace_int64() = std::int64_t(c.fixed[row]);
+        return;
+      case value_kind::uint64:
+        store.emplace_uint64() = c.fixed[row];
+        return;
+      case value_kind::real:
+        store.emplace_double() = to_double_bits(c.fixed[row]);
+        return;
+      case value_kind::string:
+        store.emplace_string() = string_at(c, row);
+        return;
+      default:;
+    }
+
+    json_bento::value_from(boost::json::parse(string_at(c, row)), store);
+  }
+
+  /// returns \ref row as object with all present columns
+  boost::json::value row_at(std::size_t row) const {
+    boost::json::object res;
+
+    for (std::size_t col = 0; col < cols.size(); ++col)
+      if (contains(col, row)) res[cols[col].name] = value_at(col, row);
+
+    return res;
+  }
+
+  /// returns \ref row as object with the present columns of \ref columns
+  boost::json::value row_at(std::size_t                     row,
+                            const std::vector<std::string>& columns) const {
+    boost::json::object res;
+
+    for (const std::string& name : columns) {
+      const std::size_t col = find_column(name);
+
+      if ((col != npos) && contains(col, row)) res[name] = value_at(col, row);
+    }
+
+    return res;
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(projected, numrows, cols);
+  }
+
+ private:
+  /// types of column values
+  enum class value_kind : std::uint8_t {
+    none,  // only null or missing values
+    boolean,
+    int64,
+    uint64,
+    real,
+    string,
+    json  // mixed types, arrays, or objects
+  };
+
+  struct column {
+    std::string                name;
+    value_kind                 kind = value_kind::none;
+    std::vector<std::uint64_t> valid;    ///< bitmap
+    std::vector<std::uint64_t> nulls;    ///< bitmap
+    std::vector<std::uint64_t> fixed;    ///< one word per row
+    std::vector<std::uint32_t> offsets;  ///< numrows + 1 string offsets
+    std::string                chars;
+
+    template <class Archive>
+    void serialize(Archive& ar) {
+      ar(name, kind, valid, nulls, fixed, offsets, chars);
+    }
+  };
+
+  static constexpr std::size_t bits = 64;
+
+  static void set_bit(std::vector<std::uint64_t>& bitmap, std::size_t i) {
+    if (bitmap.size() <= i / bits) bitmap.resize(i / bits + 1, 0);
+
+    bitmap[i / bits] |= std::uint64_t(1) << (i % bits);
+  }
+
+  static bool test_bit(const std::vector<std::uint64_t>& bitmap,
+                       std::size_t                       i) {
+    return (i / bits < bitmap.size()) &&
+           ((bitmap[i / bits] >> (i % bits)) & 1) != 0;
+  }
+
+  static bool fixed_width(value_kind kind) {
+    return (kind != value_kind::none) && (kind != value_kind::string) &&
+           (kind != value_kind::json);
+  }
+
+  static std::uint64_t double_bits(double d) {
+    std::uint64_t res;
+
+    std::memcpy(&res, &d, sizeof(res));
+    return res;
+  }
+
+  static double to_double_bits(std::uint64_t u) {
+    double res;
+
+    std::memcpy(&res, &u, sizeof(res));
+    return res;
+  }
+
+  static std::string_view string_at(const column& c, std::size_t row) {
+    return std::string_view(c.chars).substr(c.offsets[row],
+                                            c.offsets[row + 1] - c.offsets[row]);
+  }
+
+  template <class JsonValue>
+  static value_kind kind_of(const JsonValue& val) {
+    if (val.is_bool()) return value_kind::boolean;
+    if (val.is_int64()) return value_kind::int64;
+    if (val.is_uint64()) return value_kind::uint64;
+    if (val.is_double()) return value_kind::real;
+    if (val.is_string()) return value_kind::string;
+
+    return value_kind::json;
+  }
+
+  template <class JsonValue>
+  static std::string json_text(const JsonValue& val) {
+    if constexpr (std::is_same_v<JsonValue, boost::json::value>)
+      return boost::json::serialize(val);
+    else
+      return boost::json::serialize(
+          json_bento::value_to<boost::json::value>(val));
+  }
+
+  std::size_t add_column(std::string_view name) {
+    cols.push_back(column{std::string(name)});
+    return cols.size() - 1;
+  }
+
+  /// makes the storage of \ref col cover the current row
+  void pad(column& col) const {
+    if (fixed_width(col.kind))
+      col.fixed.resize(numrows + 1, 0);
+    else if (col.kind != value_kind::none)
+      col.offsets.resize(numrows + 2, col.chars.size());
+  }
+
+  /// stores the values of \ref col as JSON text
+  void convert_to_json(column& col) const {
+    const std::size_t idx = &col - cols.data();
+    column            res{col.name, value_kind::json, col.valid, col.nulls};
+
+    res.offsets.push_back(0);
+    for (std::size_t row = 0; row < numrows; ++row) {
+      if (test_bit(col.valid, row))
+        res.chars.append(boost::json::serialize(value_at(idx, row)));
+
+      res.offsets.push_back(res.chars.size());
+    }
+
+    col = std::move(res);
+  }
+
+  template <class JsonValue>
+  void add_value(column& col, const JsonValue& val) {
+    if (val.is_null()) return set_bit(col.nulls, numrows);
+
+    const value_kind kind = kind_of(val);
+
+    if (col.kind == value_kind::none) {
+      col.kind = kind;
+
+      if (fixed_width(kind))
+        col.fixed.assign(numrows, 0);
+      else
+        col.offsets.assign(numrows + 1, 0);
+    } else if ((col.kind != kind) && (col.kind != value_kind::json)) {
+      convert_to_json(col);
+    }
+
+    set_bit(col.valid, numrows);
+
+    switch (col.kind) {
+      case value_kind::boolean:
+        col.fixed.push_back(val.as_bool());
+        return;
+      case value_kind::int64:
+        col.fixed.push_back(std::uint64_t(val.as_int64()));
+        return;
+      case value_kind::uint64:
+        col.fixed.push_back(val.as_uint64());
+        return;
+      case value_kind::real:
+        col.fixed.push_back(double_bits(val.as_double()));
+        return;
+      case value_kind::string:
+        col.chars.append(std::string_view(val.as_string()));
+        break;
+      default:
+        col.chars.append(json_text(val));
+    }
+
+    assert(col.chars.size() <= std::numeric_limits<std::uint32_t>::max());
+    col.offsets.push_back(col.chars.size());
+  }
+
+  bool                projected = false;
+  std::size_t         numrows   = 0;
+  std::vector<column> cols;
+};
+
+}  // namespace experimental
@@ -0,0 +1,119 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string_view>
+#include <vector>
+
+#include <ygm/comm.hpp>
+
+#include "MetallJsonLines-hash.hpp"
+
+namespace experimental {
+
+/// a distributed filter is only built for key sets up to this size
+///   (about 20MB of bits, replicated on every rank).
+inline constexpr std::size_t DEFAULT_BLOOM_FILTER_LIMIT = 1 << 24;
+
+/// a Bloom filter over 64-bit key hashes, which ranks build from their
+///   local keys and then combine (see all_reduce_or). A rank can then drop
+///   rows whose keys are definitely not in the set before sending any
+///   message about them.
+/// \details
+///   the bit positions of a key are computed by double hashing from the
+///   key hash. A default-constructed filter has no bits and contains every
+///   key, so that callers can skip building a filter without special cases.
+class bloom_filter {
+ public:
+  /// creates a filter that contains every key
+  bloom_filter() = default;
+
+  /// creates an empty filter for \ref numItems keys (all ranks combined);
+  ///   all ranks must pass the same numbers.
+  explicit bloom_filter(std::size_t numItems, std::size_t bitsPerItem = 10)
+      : bits(std::max<std::size_t>(numItems * bitsPerItem, word_bits)),
+        numHashes(std::max(1, int(std::lround(bitsPerItem * std::log(2.0))))),
+        words((bits + word_bits - 1) / word_bits, 0) {
+    bits = words.size() * word_bits;
+  }
+
+  /// adds the key with hash \ref h
+  void insert(std::uint64_t h) {
+    if (words.empty()) return;
+
+    for_each_bit(h, [this](std::size_t pos) -> bool {
+      words[pos / word_bits] |= bit(pos);
+      return true;
+    });
+  }
+
+  void insert(std::string_view key) { insert(hash_of(key)); }
+
+  /// returns false, if the key with hash \ref h was not inserted on any rank
+  bool may_contain(std::uint64_t h) const {
+    if (words.empty()) return true;
+
+    return for_each_bit(h, [this](std::size_t pos) -> bool {
+      return (words[pos / word_bits] & bit(pos)) != 0;
+    });
+  }
+
+  bool may_contain(std::string_view key) const {
+    return may_contain(hash_of(key));
+  }
+
+  /// combines the keys inserted on all ranks; collective.
+  void all_reduce_or(ygm::comm& world) {
+    if (words.empty()) return;
+
+    words = world.all_reduce(words, elementwise_or{});
+  }
+
+  /// returns true, if the filter contains every key
+  bool accepts_all() const { return words.empty(); }
+
+  /// returns the hash that the string overloads use
+  static std::uint64_t hash_of(std::string_view key) {
+    return std::hash<std::string_view>{}(key);
+  }
+
+ private:
+  static constexpr std::size_t word_bits = 64;
+
+  struct elementwise_or {
+    std::vector<std::uint64_t> operator()(
+        const std::vector<std::uint64_t>& lhs,
+        const std::vector<std::uint64_t>& rhs) const {
+      std::vector<std::uint64_t> res{lhs.begin(), lhs.end()};
+
+      for (std::size_t i = 0; i < rhs.size(); ++i) res[i] |= rhs[i];
+
+      return res;
+    }
+  };
+
+  static std::uint64_t bit(std::size_t pos) {
+    return std::uint64_t(1) << (pos % word_bits);
+  }
+
+  /// calls fn with each bit position of h, until fn returns false
+  template <class Fn>
+  bool for_each_bit(std::uint64_t h, Fn fn) const {
+    // the key hashes are not well distributed (e.g., std::hash of integers)
+    const std::uint64_t h1 = stable_hash_distribute(h);
+    const std::uint64_t h2 = stable_hash_distribute(h1) | 1;
+
+    for (int i = 0; i < numHashes; ++i)
+      if (!fn((h1 + i * h2) % bits)) return false;
+
+    return true;
+  }
+
+  std::size_t                bits      = 0;
+  int                        numHashes = 0;
+  std::vector<std::uint64_t> words;
+};
+
+}  // namespace experimental
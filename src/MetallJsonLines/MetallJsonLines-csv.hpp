@@ -0,0 +1,289 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Typed parsing of CSV lines for read_csv_files.
+
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace experimental {
+
+/// the type of a CSV column, and of a parsed cell
+enum class csv_type : std::uint8_t {
+  skip,       ///< the column is not stored
+  null,       ///< an empty cell (cells only)
+  string,     ///< stored as is
+  int64,      ///< a signed integer
+  uint64,     ///< an unsigned integer
+  real,       ///< a floating point number
+  boolean,    ///< true|false|1|0 (also True, TRUE, False, FALSE)
+  automatic,  ///< the first of int, uint, real, and bool that fits, or string
+};
+
+/// returns the column type named \ref name; the names match those of the
+///   MetallFrame column types (string|int|uint|real), plus bool|auto|skip.
+inline csv_type to_csv_type(std::string_view name) {
+  if (name == "string") return csv_type::string;
+  if (name == "int") return csv_type::int64;
+  if (name == "uint") return csv_type::uint64;
+  if (name == "real") return csv_type::real;
+  if (name == "bool") return csv_type::boolean;
+  if (name == "auto") return csv_type::automatic;
+  if (name == "skip") return csv_type::skip;
+
+  throw std::invalid_argument{"unknown csv column type: " + std::string(name)};
+}
+
+/// a column of a CSV file
+struct csv_column {
+  std::string name;
+  csv_type    type = csv_type::automatic;
+};
+
+/// the layout of the lines of a CSV file
+struct csv_format {
+  /// the columns, in the order of the fields of a line
+  std::vector<csv_column> columns;
+
+  /// the field separator
+  char delimiter = ',';
+
+  /// if true, lines whose fields are the column names are skipped
+  bool header = false;
+
+  /// returns a format of (name, type name) pairs, as in the column
+  ///   descriptions of MetallFrame's __init__ (see to_csv_type)
+  static csv_format of(
+      const std::vector<std::pair<std::string, std::string>>& schema,
+      char delimiter = ',', bool header = false) {
+    csv_format res;
+
+    for (const auto& [name, type] : schema)
+      res.columns.push_back(csv_column{name, to_csv_type(type)});
+
+    res.delimiter = delimiter;
+    res.header    = header;
+    return res;
+  }
+
+  /// returns the position of column \ref name; columns.size() if there is none
+  std::size_t find(std::string_view name) const {
+    std::size_t pos = 0;
+
+    while ((pos < columns.size()) && (columns[pos].name != name)) ++pos;
+
+    return pos;
+  }
+};
+
+/// a typed cell of a parsed line; the string views refer to the line
+///   or to the parser, and are valid until the next line is parsed.
+struct csv_cell {
+  csv_type         type = csv_type::null;
+  std::int64_t     i    = 0;
+  std::uint64_t    u    = 0;
+  double           d    = 0;
+  bool             b    = false;
+  std::string_view s;  ///< the field's text (unquoted), for all types
+};
+
+/// splits CSV lines into fields and parses the fields into typed cells.
+/// \details
+///   fields follow RFC 4180: a field in double quotes may contain the
+///   delimiter, and a doubled quote stands for a quote. As the files are
+///   read line by line, a quoted field cannot span lines.
+///   An empty field is a null cell, except in string columns.
+///   A line is rejected if it has another number of fields than the format
+///   has columns, or if a field cannot be parsed as its column's type.
+class csv_line_parser {
+ public:
+  explicit csv_line_parser(csv_format fmt) : format(std::move(fmt)) {
+    cells.resize(format.columns.size());
+  }
+
+  /// parses \ref line into row()
+  /// \return false if the line is rejected or is a header line
+  ///         (see is_header)
+  bool parse(std::string_view line) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+
+    if (!split(line) || (fields.size() != format.columns.size())) return false;
+
+    if (is_header()) return false;
+
+    for (std::size_t c = 0; c < fields.size(); ++c)
+      if (!parse_cell(format.columns[c].type, fields[c], cells[c]))
+        return false;
+
+    return true;
+  }
+
+  /// returns true, if the last parsed line is a header line
+  bool is_header() const {
+    if (!format.header || (fields.size() != format.columns.size()))
+      return false;
+
+    for (std::size_t c = 0; c < fields.size(); ++c)
+      if (fields[c] != format.columns[c].name) return false;
+
+    return true;
+  }
+
+  const std::vector<csv_cell>& row() const { return cells; }
+  const csv_format&            layout() const { return format; }
+
+ private:
+  /// splits \ref line into fields
+  bool split(std::string_view line) {
+    const char delim = format.delimiter;
+
+    fields.clear();
+    unescaped.clear();
+    // unescaped fields are shorter than the line, so that the buffer is not
+    //   reallocated and the views into it remain valid.
+    unescaped.reserve(line.size());
+
+    for (std::size_t pos = 0;;) {
+      std::size_t end = 0;
+
+      if ((pos < line.size()) && (line[pos] == '"')) {
+        bool        escaped = false;
+        std::size_t quote   = pos;
+
+        for (;;) {
+          quote = line.find('"', quote + 1);
+
+          if (quote == std::string_view::npos) return false;
+          if ((quote + 1 == line.size()) || (line[quote + 1] != '"')) break;
+
+          escaped = true;
+          ++quote;
+        }
+
+        end = quote + 1;
+
+        if ((end < line.size()) && (line[end] != delim)) return false;
+
+        const std::string_view text = line.substr(pos + 1, quote - pos - 1);
+
+        fields.push_back(escaped ? unescape(text) : text);
+      } else {
+        end = std::min(line.find(delim, pos), line.size());
+        fields.push_back(line.substr(pos, end - pos));
+      }
+
+      if (end == line.size()) return true;
+
+      pos = end + 1;
+    }
+  }
+
+  /// appends \ref text with doubled quotes replaced to the buffer
+  std::string_view unescape(std::string_view text) {
+    const std::size_t first = unescaped.size();
+
+    for (std::size_t i = 0; i < text.size(); ++i) {
+      unescaped.push_back(text[i]);
+
+      if (text[i] == '"') ++i;
+    }
+
+    return std::string_view{unescaped}.substr(first);
+  }
+
+  template <class T>
+  static bool parse_number(std::string_view text, T& val) {
+    const char* const last = text.data() + text.size();
+    const auto [ptr, ec]   = std::from_chars(text.data(), last, val);
+
+    return (ec == std::errc{}) && (ptr == last);
+  }
+
+  static bool parse_bool(std::string_view text, bool& val) {
+    val = (text == "true" || text == "True" || text == "TRUE" || text == "1");
+
+    return val ||
+           (text == "false" || text == "False" || text == "FALSE" ||
+            text == "0");
+  }
+
+  static bool parse_cell(csv_type type, std::string_view text, csv_cell& cell) {
+    cell.s = text;
+
+    if (type == csv_type::string || type == csv_type::skip) {
+      cell.type = type;
+      return true;
+    }
+
+    if (text.empty()) {
+      cell.type = csv_type::null;
+      return true;
+    }
+
+    cell.type = type;
+
+    switch (type) {
+      case csv_type::int64:
+        return parse_number(text, cell.i);
+      case csv_type::uint64:
+        return parse_number(text, cell.u);
+      case csv_type::real:
+        return parse_number(text, cell.d);
+      case csv_type::boolean:
+        return parse_bool(text, cell.b);
+      default:;
+    }
+
+    // automatic: only text that starts like a number is parsed as a number
+    const char first = text.front();
+
+    const bool numeric =
+        (first == '-') || (first == '.') || ((first >= '0') && (first <= '9'));
+
+    if (numeric) {
+      if (parse_number(text, cell.i))
+        cell.type = csv_type::int64;
+      else if (parse_number(text, cell.u))
+        cell.type = csv_type::uint64;
+      else if (parse_number(text, cell.d))
+        cell.type = csv_type::real;
+
+      if (cell.type != csv_type::automatic) return true;
+    }
+
+    if (text == "true" || text == "false") {
+      cell.type = csv_type::boolean;
+      cell.b    = (text == "true");
+      return true;
+    }
+
+    cell.type = csv_type::string;
+    return true;
+  }
+
+  csv_format                    format;
+  std::vector<std::string_view> fields;
+  std::string                   unescaped;
+  std::vector<csv_cell>         cells;
+};
+
+/// a column that is computed from the cells of a line (e.g., a generated
+///   vertex key) and added to the imported row as a string
+struct csv_extra_column {
+  std::string                                              name;
+  std::function<std::string(const std::vector<csv_cell>&)> value;
+};
+
+}  // namespace experimental
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <mpi.h>
+
+#include <metall/metall.hpp>
+#include <metall/utility/metall_mpi_adaptor.hpp>
+
+#include "MetallJsonLines-lease.hpp"
+
+/// opening the Metall datastores of the methods: a standalone method opens
+///   and closes its datastore; in service mode (see
+///   MetallJsonLines-service.hpp), the datastores stay open across method
+///   calls, which saves the open cost of large datastores. A standalone
+///   method reads the latest published version of a shared datastore (see
+///   MetallJsonLines-lease.hpp).
+namespace experimental {
+
+/// the datastores that remain open across method calls.
+/// \details
+///   a cache is active while it is installed (see datastore_cache::install).
+///   All ranks must open and close the same datastores in the same order,
+///   as the Metall MPI adaptor is collective.
+class datastore_cache {
+ public:
+  using manager_type = metall::utility::metall_mpi_adaptor;
+
+  datastore_cache() = default;
+  ~datastore_cache() { clear(); }
+
+  datastore_cache(const datastore_cache&)            = delete;
+  datastore_cache& operator=(const datastore_cache&) = delete;
+
+  /// returns the installed cache, or null if none is installed
+  static datastore_cache*& active() {
+    static datastore_cache* cache = nullptr;
+
+    return cache;
+  }
+
+  /// installs \ref cache, or none if null
+  static void install(datastore_cache* cache) { active() = cache; }
+
+  /// returns the open datastore at \ref loc; a cached datastore is
+  ///   reopened if it is read-only and \ref mode requests write access, and
+  ///   recreated for metall::create_only. A replaced datastore stays open
+  ///   until the next flush, as the running method may still refer to it.
+  ///   Collective.
+  template <class Mode>
+  manager_type& open(Mode mode, std::string_view loc) {
+    constexpr bool creating = std::is_same_v<Mode, metall::create_only_t>;
+    constexpr bool writable = !std::is_same_v<Mode, metall::open_read_only_t>;
+
+    auto pos = stores.find(loc);
+
+    if ((pos != stores.end()) && !creating &&
+        (pos->second.writable || !writable))
+      return *pos->second.manager;
+
+    if (pos != stores.end()) {
+      retired.push_back(std::move(pos->second.manager));
+      stores.erase(pos);
+    }
+
+    const std::string             location{loc};
+    std::unique_ptr<manager_type> manager =
+        std::make_unique<manager_type>(mode, location.c_str(), MPI_COMM_WORLD);
+    manager_type& res = *manager;
+
+    stores.emplace(location, entry{std::move(manager), writable});
+    return res;
+  }
+
+  /// closes the datastore at \ref loc, if it is open. Collective.
+  void close(std::string_view loc) {
+    if (auto pos = stores.find(loc); pos != stores.end()) stores.erase(pos);
+  }
+
+  /// writes the writable datastores back to their files, and closes the
+  ///   replaced datastores; called between method calls. Collective.
+  void flush() {
+    retired.clear();
+
+    for (auto& [loc, el] : stores)
+      if (el.writable) el.manager->get_local_manager().flush();
+  }
+
+  /// closes all datastores. Collective.
+  void clear() {
+    retired.clear();
+    stores.clear();
+  }
+
+  /// returns the number of open datastores
+  std::size_t size() const { return stores.size(); }
+
+ private:
+  struct entry {
+    std::unique_ptr<manager_type> manager;
+    bool                          writable;
+  };
+
+  std::map<std::string, entry, std::less<>>  stores;
+  std::vector<std::unique_ptr<manager_type>> retired;
+};
+
+/// the datastore of a method: opened by the method, or borrowed from the
+///   active datastore_cache.
+/// \details
+///   converts to the Metall MPI adaptor, thus it can be passed to the
+///   containers (e.g., metall_json_lines, metall_graph).
+///   If the datastore is shared, a read-only datastore is the latest
+///   published version, and a writable datastore is published as the next
+///   version when it is closed. The service keeps its datastores open and
+///   does not take part in the sharing.
+class datastore {
+ public:
+  using manager_type = datastore_cache::manager_type;
+
+  /// opens the datastore at \ref loc in \ref mode (e.g., metall::open_only)
+  template <class Mode>
+  datastore(Mode mode, std::string_view loc) {
+    constexpr bool readonly = std::is_same_v<Mode, metall::open_read_only_t>;
+
+    if (datastore_cache* cache = datastore_cache::active()) {
+      manager = &cache->open(mode, loc);
+      return;
+    }
+
+    if constexpr (readonly) {
+      reader = std::make_unique<reader_lease>(loc);
+
+      if (reader->shared()) {
+        const std::string version = reader->location();
+
+        owned   = std::make_unique<manager_type>(metall::open_read_only,
+                                               version.c_str(), MPI_COMM_WORLD);
+        manager = owned.get();
+        return;
+      }
+    }
+
+    if constexpr (!readonly) writer = std::make_unique<writer_lease>(loc);
+
+    const std::string location{loc};
+
+    owned = std::make_unique<manager_type>(mode, location.c_str(),
+                                           MPI_COMM_WORLD);
+    manager = owned.get();
+  }
+
+  /// publishes a written shared datastore, before it is closed. Collective.
+  ~datastore() {
+    if (!writer || !writer->shared()) return;
+
+    try {
+      writer->publish(*owned);
+    } catch (const std::exception& err) {
+      std::cerr << err.what() << std::endl;
+    }
+  }
+
+  datastore(const datastore&)            = delete;
+  datastore& operator=(const datastore&) = delete;
+
+  manager_type& get() { return *manager; }
+
+  operator manager_type&() { return *manager; }
+
+ private:
+  // the leases are released after the datastore is closed
+  std::unique_ptr<reader_lease> reader;
+  std::unique_ptr<writer_lease> writer;
+  std::unique_ptr<manager_type> owned;  ///< null, if borrowed
+  manager_type*                 manager = nullptr;
+};
+
+}  // namespace experimental
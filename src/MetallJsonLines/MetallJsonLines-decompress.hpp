@@ -0,0 +1,435 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Streaming decompression of gzip and zstd compressed JSON lines
+///        files for read_json_files.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifdef METALLDATA_USE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef METALLDATA_USE_ZSTD
+#include <zstd.h>
+#endif
+
+namespace experimental {
+
+/// the compression of an input file
+enum class file_compression : std::uint8_t { none, gzip, zstd };
+
+/// returns the compression of \ref path, by its suffix (.gz or .zst)
+inline file_compression compression_of(std::string_view path) {
+  auto endsWith = [path](std::string_view suffix) -> bool {
+    return (path.size() >= suffix.size()) &&
+           (path.substr(path.size() - suffix.size()) == suffix);
+  };
+
+  if (endsWith(".gz")) return file_compression::gzip;
+  if (endsWith(".zst") || endsWith(".zstd")) return file_compression::zstd;
+
+  return file_compression::none;
+}
+
+/// a frame of a seekable zstd file
+struct zstd_frame {
+  std::uint64_t offset           = 0;  ///< offset of the frame in the file
+  std::uint32_t compressedSize   = 0;
+  std::uint32_t decompressedSize = 0;
+};
+
+/// returns the frames listed in the seek table of the zstd file \ref path;
+///   nullopt if the file has no seek table.
+/// \details
+///   the seek table of the zstd seekable format is a skippable frame at the
+///   end of the file: its entries (compressed size, decompressed size, and
+///   an optional checksum; 4 bytes each, little endian) are followed by a
+///   9-byte footer (number of frames, descriptor, and magic number).
+inline std::optional<std::vector<zstd_frame>> read_zstd_seek_table(
+    const std::string& path) {
+  static constexpr std::uint32_t skippableMagic = 0x184D2A5E;
+  static constexpr std::uint32_t seekableMagic  = 0x8F92EAB1;
+  static constexpr std::size_t   footerBytes    = 9;
+  static constexpr std::size_t   headerBytes    = 8;
+
+  auto u32 = [](const unsigned char* p) -> std::uint32_t {
+    return std::uint32_t(p[0]) | (std::uint32_t(p[1]) << 8) |
+           (std::uint32_t(p[2]) << 16) | (std::uint32_t(p[3]) << 24);
+  };
+
+  std::ifstream       ifs(path, std::ios::binary);
+  const std::uint64_t filesize = std::filesystem::file_size(path);
+
+  if (!ifs || filesize < headerBytes + footerBytes) return std::nullopt;
+
+  unsigned char footer[footerBytes];
+
+  ifs.seekg(filesize - footerBytes);
+  ifs.read(reinterpret_cast<char*>(footer), footerBytes);
+
+  if (!ifs || u32(footer + 5) != seekableMagic) return std::nullopt;
+
+  const std::uint32_t numFrames  = u32(footer);
+  const bool          checksums  = footer[4] & 0x80;
+  const std::size_t   entryBytes = checksums ? 12 : 8;
+  const std::uint64_t tableBytes =
+      headerBytes + std::uint64_t(numFrames) * entryBytes + footerBytes;
+
+  if (tableBytes > filesize) return std::nullopt;
+
+  std::vector<unsigned char> table(tableBytes);
+
+  ifs.seekg(filesize - tableBytes);
+  ifs.read(reinterpret_cast<char*>(table.data()), tableBytes);
+
+  if (!ifs || u32(table.data()) != skippableMagic ||
+      u32(table.data() + 4) != tableBytes - headerBytes)
+    return std::nullopt;
+
+  std::vector<zstd_frame> frames;
+  std::uint64_t           offset = 0;
+
+  for (std::uint32_t i = 0; i < numFrames; ++i) {
+    const unsigned char* entry = table.data() + headerBytes + i * entryBytes;
+    const zstd_frame     frame = {offset, u32(entry), u32(entry + 4)};
+
+    frames.push_back(frame);
+    offset += frame.compressedSize;
+  }
+
+  if (offset > filesize - tableBytes) return std::nullopt;
+
+  return frames;
+}
+
+/// reads the lines of a compressed JSON lines file that belong to a rank
+/// \details
+///   the frames of a seekable zstd file are split into one range per rank,
+///   of about the same compressed size; a line belongs to the rank whose
+///   range holds the line's first byte. Thus a rank reads one frame before
+///   its range (to find out whether its first line starts a line) and
+///   reads past its range until its last line ends.
+///   Other compressed files are streamed by a single rank, their owner
+///   (see assign_compressed_files). Empty lines are skipped.
+class compressed_line_reader {
+ public:
+  static constexpr std::size_t chunk_bytes = 1 << 20;
+
+  /// \param owner the rank that reads the file if it cannot be split
+  compressed_line_reader(std::string path, file_compression comp, int rank,
+                         int numranks, int owner)
+      : path(std::move(path)),
+        comp(comp),
+        rank(rank),
+        numranks(numranks),
+        owner(owner) {}
+
+  /// calls \ref fn with each line that belongs to this rank
+  template <class Fn>
+  void for_all(Fn fn) {
+    if (comp == file_compression::zstd) {
+      if (std::optional<std::vector<zstd_frame>> frames =
+              read_zstd_seek_table(path)) {
+        read_zstd_frames(*frames, fn);
+        return;
+      }
+    }
+
+    if (rank != owner) return;
+
+    std::ifstream ifs(path, std::ios::binary);
+
+    if (!ifs) throw std::runtime_error("cannot open " + path);
+
+    if (comp == file_compression::gzip)
+      stream_gzip(ifs, fn);
+    else
+      stream_zstd(ifs, fn);
+  }
+
+ private:
+  /// splits decompressed data into lines
+  template <class Fn>
+  struct line_splitter {
+    Fn&         fn;
+    std::string pending;
+
+    /// adds \ref n bytes; calls fn with the completed lines
+    void add(const char* data, std::size_t n) {
+      const char* const lim = data + n;
+
+      while (data != lim) {
+        const char* const eol = std::find(data, lim, '\n');
+
+        pending.append(data, eol);
+
+        if (eol == lim) return;
+
+        emit();
+        data = eol + 1;
+      }
+    }
+
+    /// calls fn with the current line, unless it is empty
+    void emit() {
+      if (!pending.empty()) fn(pending);
+
+      pending.clear();
+    }
+  };
+
+  template <class Fn>
+  void stream_gzip(std::ifstream& ifs, Fn& fn) {
+#ifdef METALLDATA_USE_ZLIB
+    std::vector<char> in(chunk_bytes);
+    std::vector<char> out(chunk_bytes);
+    line_splitter<Fn> lines{fn, {}};
+    z_stream          zs;
+
+    std::memset(&zs, 0, sizeof(zs));
+
+    // 15 + 32: maximum window size, detect the gzip or zlib header
+    if (inflateInit2(&zs, 15 + 32) != Z_OK)
+      throw std::runtime_error("zlib: cannot initialize " + path);
+
+    int ret = Z_OK;
+
+    while (ifs) {
+      ifs.read(in.data(), in.size());
+      zs.next_in  = reinterpret_cast<Bytef*>(in.data());
+      zs.avail_in = uInt(ifs.gcount());
+
+      while (zs.avail_in > 0) {
+        zs.next_out  = reinterpret_cast<Bytef*>(out.data());
+        zs.avail_out = uInt(out.size());
+        ret          = inflate(&zs, Z_NO_FLUSH);
+
+        if ((ret != Z_OK) && (ret != Z_STREAM_END)) {
+          inflateEnd(&zs);
+          throw std::runtime_error("zlib: corrupted input " + path);
+        }
+
+        lines.add(out.data(), out.size() - zs.avail_out);
+
+        // a file of concatenated gzip members (e.g., from pigz)
+        if (ret == Z_STREAM_END) inflateReset(&zs);
+      }
+    }
+
+    inflateEnd(&zs);
+
+    if (ret != Z_STREAM_END)
+      throw std::runtime_error("zlib: truncated input " + path);
+
+    lines.emit();
+#else
+    (void)ifs;
+    (void)fn;
+    throw std::runtime_error(
+        "reading " + path + " requires gzip support (METALLDATA_USE_ZLIB)");
+#endif
+  }
+
+  template <class Fn>
+  void stream_zstd(std::ifstream& ifs, Fn& fn) {
+#ifdef METALLDATA_USE_ZSTD
+    std::vector<char> in(ZSTD_DStreamInSize());
+    std::vector<char> out(ZSTD_DStreamOutSize());
+    line_splitter<Fn> lines{fn, {}};
+    ZSTD_DCtx* const  dctx = ZSTD_createDCtx();
+
+    while (ifs) {
+      ifs.read(in.data(), in.size());
+
+      ZSTD_inBuffer input = {in.data(), std::size_t(ifs.gcount()), 0};
+
+      while (input.pos < input.size) {
+        ZSTD_outBuffer    output = {out.data(), out.size(), 0};
+        const std::size_t ret    = ZSTD_decompressStream(dctx, &output, &input);
+
+        if (ZSTD_isError(ret)) {
+          ZSTD_freeDCtx(dctx);
+          throw std::runtime_error("zstd: corrupted input " + path);
+        }
+
+        lines.add(out.data(), output.pos);
+      }
+    }
+
+    ZSTD_freeDCtx(dctx);
+    lines.emit();
+#else
+    (void)ifs;
+    (void)fn;
+    throw std::runtime_error(
+        "reading " + path + " requires zstd support (METALLDATA_USE_ZSTD)");
+#endif
+  }
+
+  /// reads the lines that start in this rank's range of frames
+  template <class Fn>
+  void read_zstd_frames(const std::vector<zstd_frame>& frames, Fn& fn) {
+#ifdef METALLDATA_USE_ZSTD
+    const std::size_t n     = frames.size();
+    const std::size_t first = first_frame(frames, rank);
+    const std::size_t lim   = first_frame(frames, rank + 1);
+
+    if (first >= lim) return;
+
+    std::ifstream ifs(path, std::ios::binary);
+
+    if (!ifs) throw std::runtime_error("cannot open " + path);
+
+    ZSTD_DCtx* const  dctx = ZSTD_createDCtx();
+    std::vector<char> in;
+    std::vector<char> out;
+
+    auto decompress = [&](std::size_t i) -> void {
+      const zstd_frame& frame = frames[i];
+
+      in.resize(frame.compressedSize);
+      out.resize(frame.decompressedSize);
+      ifs.seekg(frame.offset);
+      ifs.read(in.data(), in.size());
+
+      const std::size_t ret = ZSTD_decompressDCtx(dctx, out.data(), out.size(),
+                                                  in.data(), in.size());
+
+      if (!ifs || ZSTD_isError(ret) || (ret != out.size())) {
+        ZSTD_freeDCtx(dctx);
+        throw std::runtime_error("zstd: corrupted frame in " + path);
+      }
+    };
+
+    // the first line is owned by the previous rank, unless a line starts
+    //   with the range.
+    bool skipping = false;
+
+    if (first > 0) {
+      decompress(first - 1);
+      skipping = out.empty() || (out.back() != '\n');
+    }
+
+    line_splitter<Fn> lines{fn, {}};
+
+    for (std::size_t i = first; i < n; ++i) {
+      // past the range: only complete the last line
+      if ((i >= lim) && (skipping || lines.pending.empty())) break;
+
+      decompress(i);
+
+      const char*       data = out.data();
+      const char* const end  = data + out.size();
+
+      if (skipping) {
+        data     = std::find(data, end, '\n');
+        skipping = (data == end);
+
+        if (skipping) continue;
+
+        ++data;
+      }
+
+      if (i < lim) {
+        lines.add(data, end - data);
+        continue;
+      }
+
+      const char* const eol = std::find(data, end, '\n');
+
+      lines.pending.append(data, eol);
+
+      if (eol != end) {
+        lines.emit();
+        break;
+      }
+    }
+
+    ZSTD_freeDCtx(dctx);
+
+    if (!skipping) lines.emit();
+#else
+    (void)frames;
+    (void)fn;
+    throw std::runtime_error(
+        "reading " + path + " requires zstd support (METALLDATA_USE_ZSTD)");
+#endif
+  }
+
+  /// returns the first frame of rank \ref r's range
+  std::size_t first_frame(const std::vector<zstd_frame>& frames, int r) const {
+    if (r >= numranks) return frames.size();
+
+    const std::uint64_t total =
+        frames.empty() ? 0
+                       : frames.back().offset + frames.back().compressedSize;
+    const std::uint64_t start = total * std::uint64_t(r) / numranks;
+
+    return std::lower_bound(frames.begin(), frames.end(), start,
+                            [](const zstd_frame& frame, std::uint64_t pos)
+                                -> bool { return frame.offset < pos; }) -
+           frames.begin();
+  }
+
+  std::string      path;
+  file_compression comp;
+  int              rank;
+  int              numranks;
+  int              owner;
+};
+
+/// assigns the compressed files in \ref files that cannot be split (i.e.,
+///   all but seekable zstd files) to ranks: the largest file first, each to
+///   the rank with the fewest compressed bytes so far.
+/// \param sizes the file sizes
+/// \return the owner of each file; -1 for uncompressed and seekable files
+inline std::vector<int> assign_compressed_files(
+    const std::vector<std::string>&   files,
+    const std::vector<std::uint64_t>& sizes, int numranks) {
+  std::vector<int>         owners(files.size(), -1);
+  std::vector<std::size_t> order;
+
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    const file_compression comp = compression_of(files[i]);
+
+    if (comp == file_compression::none) continue;
+
+    if ((comp == file_compression::zstd) && read_zstd_seek_table(files[i]))
+      continue;
+
+    order.push_back(i);
+  }
+
+  std::stable_sort(order.begin(), order.end(),
+                   [&sizes](std::size_t lhs, std::size_t rhs) -> bool {
+                     return sizes[lhs] > sizes[rhs];
+                   });
+
+  std::vector<std::uint64_t> load(numranks, 0);
+
+  for (std::size_t i : order) {
+    const int r =
+        int(std::min_element(load.begin(), load.end()) - load.begin());
+
+    owners[i] = r;
+    load[r] += sizes[i];
+  }
+
+  return owners;
+}
+
+}  // namespace experimental
@@ -0,0 +1,299 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines.hpp"
+
+namespace experimental {
+
+/// compiled form of common json_logic predicate shapes.
+///   a rule that consists of comparisons between a column and a constant
+///   (`{"<": [{"var": "keys.x"}, 5]}`), or a conjunction of these, is turned
+///   into typed closures that read the column values directly, without
+///   converting them into json_logic values.
+/// \details
+///   the column names are resolved into key locators when the predicate is
+///   evaluated for the first time. A row for which the compiled form cannot
+///   decide the outcome in the same way as json_logic (e.g., a missing
+///   column, or a string compared to a number) yields result::unknown and
+///   must be evaluated by the json_logic interpreter.
+class compiled_predicate {
+ public:
+  using accessor_type = metall_json_lines::accessor_type;
+
+  enum class result : std::uint8_t { no, yes, unknown };
+
+  /// compiles rule; returns an empty optional if the rule's shape
+  ///   is not supported.
+  /// \param rule          a json_logic rule
+  /// \param selectPrefix  the prefix of the variable names (e.g., "keys")
+  static std::optional<compiled_predicate> compile(
+      const boost::json::value& rule, std::string_view selectPrefix) {
+    compiled_predicate res;
+
+    if (!res.add_rule(rule, selectPrefix)) return std::nullopt;
+
+    res.locators = std::make_shared<key_locators>();
+    return res;
+  }
+
+  result operator()(const accessor_type& rowval) const {
+    if (!rowval.is_object()) {
+      CXX_UNLIKELY;
+      return result::unknown;
+    }
+
+    const auto objacc = rowval.as_object();
+
+    std::call_once(locators->resolved, [this, &objacc]() -> void {
+      for (const clause& cl : clauses)
+        locators->keys.push_back(objacc.locate_key(cl.column));
+    });
+
+    for (std::size_t i = 0; i < clauses.size(); ++i) {
+      const auto val = objacc.if_contains(locators->keys[i]);
+
+      if (!val) {
+        CXX_UNLIKELY;
+        return result::unknown;
+      }
+
+      if (const result res = clauses[i].test(*val); res != result::yes)
+        return res;
+    }
+
+    return result::yes;
+  }
+
+ private:
+  using test_type = std::function<result(const accessor_type&)>;
+
+  enum class comparison : std::uint8_t { eq, ne, lt, le, gt, ge, seq, sne };
+
+  /// a comparison of a column against a constant
+  struct clause {
+    std::string column;
+    test_type   test;
+  };
+
+  /// key locators of the clauses' columns, resolved on first use
+  struct key_locators {
+    std::once_flag                       resolved;
+    std::vector<json_bento::key_locator> keys;
+  };
+
+  static result to_result(bool b) { return b ? result::yes : result::no; }
+
+  static std::optional<comparison> to_comparison(std::string_view op) {
+    if (op == "==") return comparison::eq;
+    if (op == "!=") return comparison::ne;
+    if (op == "<") return comparison::lt;
+    if (op == "<=") return comparison::le;
+    if (op == ">") return comparison::gt;
+    if (op == ">=") return comparison::ge;
+    if (op == "===") return comparison::seq;
+    if (op == "!==") return comparison::sne;
+
+    return std::nullopt;
+  }
+
+  /// returns the comparison with swapped operands
+  static comparison flip(comparison cmp) {
+    switch (cmp) {
+      case comparison::lt:
+        return comparison::gt;
+      case comparison::le:
+        return comparison::ge;
+      case comparison::gt:
+        return comparison::lt;
+      case comparison::ge:
+        return comparison::le;
+      default:;
+    }
+
+    return cmp;
+  }
+
+  /// returns the column name if val is {"var": "<selectPrefix>.<column>"}
+  static std::optional<std::string> column_name(const boost::json::value& val,
+                                                std::string_view selectPrefix) {
+    const boost::json::object* obj = val.if_object();
+
+    if (!obj || obj->size() != 1) return std::nullopt;
+
+    const auto pos = obj->find("var");
+
+    if (pos == obj->end() || !pos->value().is_string()) return std::nullopt;
+
+    const boost::json::string& varstr = pos->value().as_string();
+    const std::string_view     var{varstr.data(), varstr.size()};
+
+    if (var.size() <= selectPrefix.size() ||
+        var.substr(0, selectPrefix.size()) != selectPrefix ||
+        var[selectPrefix.size()] != '.')
+      return std::nullopt;
+
+    return std::string(var.substr(selectPrefix.size() + 1));
+  }
+
+  /// \brief numeric comparison of a column value against a constant
+  ///   integer or floating point comparisons are used as json_logic would.
+  template <class Cmp>
+  static test_type make_numeric_test(const boost::json::value& cst) {
+    if (cst.is_int64()) {
+      return [c = cst.as_int64()](const accessor_type& val) -> result {
+        if (val.is_int64()) return to_result(Cmp{}(val.as_int64(), c));
+        if (val.is_uint64()) {
+          // a negative constant is less than any uint64 value
+          if (c < 0) return to_result(Cmp{}(1, 0));
+
+          return to_result(Cmp{}(val.as_uint64(), std::uint64_t(c)));
+        }
+        if (val.is_double())
+          return to_result(Cmp{}(val.as_double(), double(c)));
+
+        return result::unknown;
+      };
+    }
+
+    if (cst.is_uint64()) {
+      return [c = cst.as_uint64()](const accessor_type& val) -> result {
+        if (val.is_uint64()) return to_result(Cmp{}(val.as_uint64(), c));
+        if (val.is_int64()) {
+          const std::int64_t v = val.as_int64();
+
+          if (v < 0) return to_result(Cmp{}(0, 1));
+
+          return to_result(Cmp{}(std::uint64_t(v), c));
+        }
+        if (val.is_double())
+          return to_result(Cmp{}(val.as_double(), double(c)));
+
+        return result::unknown;
+      };
+    }
+
+    assert(cst.is_double());
+    return [c = cst.as_double()](const accessor_type& val) -> result {
+      if (val.is_double()) return to_result(Cmp{}(val.as_double(), c));
+      if (val.is_int64())
+        return to_result(Cmp{}(double(val.as_int64()), c));
+      if (val.is_uint64())
+        return to_result(Cmp{}(double(val.as_uint64()), c));
+
+      return result::unknown;
+    };
+  }
+
+  /// \brief (in)equality of a string column and a string constant
+  template <class Cmp>
+  static test_type make_string_test(const boost::json::value& cst) {
+    const boost::json::string& str = cst.as_string();
+
+    return [c = std::string(str.data(), str.size())](
+               const accessor_type& val) -> result {
+      if (!val.is_string()) return result::unknown;
+
+      return to_result(Cmp{}(val.as_string().str_view(), std::string_view(c)));
+    };
+  }
+
+  static test_type make_test(comparison cmp, const boost::json::value& cst) {
+    if (cst.is_number()) {
+      switch (cmp) {
+        case comparison::eq:
+          return make_numeric_test<std::equal_to<>>(cst);
+        case comparison::ne:
+          return make_numeric_test<std::not_equal_to<>>(cst);
+        case comparison::lt:
+          return make_numeric_test<std::less<>>(cst);
+        case comparison::le:
+          return make_numeric_test<std::less_equal<>>(cst);
+        case comparison::gt:
+          return make_numeric_test<std::greater<>>(cst);
+        case comparison::ge:
+          return make_numeric_test<std::greater_equal<>>(cst);
+        default:;  // strict comparisons are left to json_logic
+      }
+
+      return nullptr;
+    }
+
+    if (cst.is_string()) {
+      switch (cmp) {
+        case comparison::eq:
+        case comparison::seq:
+          return make_string_test<std::equal_to<>>(cst);
+        case comparison::ne:
+        case comparison::sne:
+          return make_string_test<std::not_equal_to<>>(cst);
+        default:;  // ordering of strings is left to json_logic
+      }
+    }
+
+    return nullptr;
+  }
+
+  /// adds the clauses of rule; returns false if the rule is not supported
+  bool add_rule(const boost::json::value& rule, std::string_view selectPrefix) {
+    const boost::json::object* obj = rule.if_object();
+
+    if (!obj || obj->size() != 1) return false;
+
+    const auto&               op   = *obj->begin();
+    const boost::json::array* args = op.value().if_array();
+
+    if (!args) return false;
+
+    const std::string_view opname{op.key().data(), op.key().size()};
+
+    if (opname == "and") {
+      if (args->empty()) return false;
+
+      for (const boost::json::value& sub : *args)
+        if (!add_rule(sub, selectPrefix)) return false;
+
+      return true;
+    }
+
+    const std::optional<comparison> cmp = to_comparison(opname);
+
+    if (!cmp || args->size() != 2) return false;
+
+    comparison                 actual = *cmp;
+    std::optional<std::string> column = column_name((*args)[0], selectPrefix);
+    const boost::json::value*  cst    = &(*args)[1];
+
+    if (!column) {
+      column = column_name((*args)[1], selectPrefix);
+      cst    = &(*args)[0];
+      actual = flip(actual);
+    }
+
+    if (!column) return false;
+
+    test_type test = make_test(actual, *cst);
+
+    if (!test) return false;
+
+    clauses.push_back(clause{std::move(*column), std::move(test)});
+    return true;
+  }
+
+  compiled_predicate() = default;
+
+  std::vector<clause>           clauses;
+  std::shared_ptr<key_locators> locators;
+};
+
+}  // namespace experimental
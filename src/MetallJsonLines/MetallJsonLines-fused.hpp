@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <cereal/types/vector.hpp>
+
+#include <ygm/comm.hpp>
+
+#include "MetallJsonLines.hpp"
+
+/// fused scans: several read-only methods on the same selection (e.g., the
+///   count, head, and hist of a notebook cell) are computed in one pass
+///   over the selected rows, instead of one pass per method.
+namespace experimental {
+
+namespace {
+/// the state of rank 0 while the head rows are gathered
+struct fused_scan_mjl {
+  /// head request -> (source rank, rows)
+  std::vector<std::vector<std::pair<int, std::vector<boost::json::value>>>>
+      remoteRows;
+
+  static fused_scan_mjl* ptr;
+};
+
+fused_scan_mjl* fused_scan_mjl::ptr = nullptr;
+}  // namespace
+
+/// the requests of one pass over the selected rows of a metall_json_lines
+/// \details
+///   the requests are added (add_count, add_head, add_hist), then run
+///   computes all results with one call of for_all_selected. The results
+///   are equal to the results of the individual methods (count, head,
+///   hist).
+class fused_scan {
+ public:
+  explicit fused_scan(const metall_json_lines& lines) : lines(&lines) {}
+
+  /// adds a count of the selected rows, or of all rows if \ref all is set
+  void add_count(bool all = false) {
+    requests.push_back({all ? request_kind::count_all : request_kind::count,
+                        counts.size()});
+    counts.push_back(all);
+  }
+
+  /// adds a head of \ref numrows rows, projected by \ref projector
+  void add_head(std::size_t                                numrows,
+                metall_json_lines::metall_projector_type projector) {
+    requests.push_back({request_kind::head, heads.size()});
+    heads.push_back({numrows, std::move(projector)});
+  }
+
+  /// adds a histogram of the values of column \ref column_name; see
+  ///   metall_json_lines::hist
+  void add_hist(std::string column_name, std::size_t max_bins = 0,
+                std::size_t min_count = 1) {
+    requests.push_back({request_kind::hist, hists.size()});
+    hists.push_back({std::move(column_name), max_bins, min_count});
+  }
+
+  /// returns the number of requests
+  std::size_t size() const { return requests.size(); }
+
+  /// computes the results of all requests. Collective.
+  /// \return the results in the order of the requests on rank 0; an empty
+  ///         array on the other ranks.
+  boost::json::array run() {
+    ygm::comm& world = lines->comm();
+
+    // phase 1: one pass over the selected rows
+    std::size_t                                     selected = 0;
+    std::vector<std::vector<boost::json::value>>    headRows(heads.size());
+    std::vector<metall_json_lines::hist_table_type> tables(hists.size());
+
+    const bool scanning =
+        !heads.empty() || !hists.empty() ||
+        std::find(counts.begin(), counts.end(), false) != counts.end();
+
+    if (scanning)
+      lines->for_all_selected(
+          [this, &selected, &headRows, &tables](
+              std::size_t,
+              const metall_json_lines::accessor_type& row) -> void {
+            ++selected;
+
+            for (std::size_t i = 0; i < heads.size(); ++i)
+              if (headRows[i].size() < heads[i].numrows)
+                headRows[i].emplace_back(heads[i].projector(row));
+
+            if (tables.empty() || !row.is_object()) return;
+
+            const auto obj = row.as_object();
+
+            for (std::size_t i = 0; i < hists.size(); ++i) {
+              if (const auto fld = obj.if_contains(hists[i].column)) {
+                boost::json::value value;
+
+                json_bento::value_to(*fld, value);
+                ++tables[i][std::move(value)];
+              }
+            }
+          });
+
+    // phase 2: reduce the results
+    const std::uint64_t totalSelected =
+        world.all_reduce_sum(std::uint64_t(selected));
+    const std::uint64_t totalRows =
+        world.all_reduce_sum(std::uint64_t(lines->local_size()));
+
+    std::vector<std::vector<std::pair<boost::json::value, std::size_t>>>
+        histograms;
+
+    for (std::size_t i = 0; i < hists.size(); ++i)
+      histograms.emplace_back(lines->reduce_hist(tables[i], hists[i].maxBins,
+                                                 hists[i].minCount));
+
+    std::vector<boost::json::array> headResults = gather_heads(headRows);
+
+    if (world.rank() != 0) return {};
+
+    boost::json::array res;
+
+    for (const request& req : requests) {
+      switch (req.kind) {
+        case request_kind::count:
+          res.emplace_back(totalSelected);
+          break;
+        case request_kind::count_all:
+          res.emplace_back(totalRows);
+          break;
+        case request_kind::head:
+          res.emplace_back(std::move(headResults[req.index]));
+          break;
+        case request_kind::hist:
+          res.emplace_back(boost::json::value_from(histograms[req.index]));
+          break;
+      }
+    }
+
+    return res;
+  }
+
+ private:
+  enum class request_kind : std::uint8_t { count, count_all, head, hist };
+
+  struct request {
+    request_kind kind;
+    std::size_t  index;  ///< index into counts, heads, or hists
+  };
+
+  struct head_request {
+    std::size_t                              numrows;
+    metall_json_lines::metall_projector_type projector;
+  };
+
+  struct hist_request {
+    std::string column;
+    std::size_t maxBins;
+    std::size_t minCount;
+  };
+
+  /// returns the first rows of each head request on rank 0, in rank order.
+  ///   Each rank sends only the rows that are needed after the rows of the
+  ///   lower ranks. Collective.
+  std::vector<boost::json::array> gather_heads(
+      std::vector<std::vector<boost::json::value>>& headRows) const {
+    ygm::comm&                      world    = lines->comm();
+    const int                       numranks = world.size();
+    const int                       rank     = world.rank();
+    std::vector<boost::json::array> res(heads.size());
+
+    if (heads.empty()) return res;
+
+    // the number of available rows per (request, rank)
+    std::vector<std::uint64_t> available(heads.size() * numranks, 0);
+
+    for (std::size_t i = 0; i < heads.size(); ++i)
+      available[i * numranks + rank] = headRows[i].size();
+
+    available = world.all_reduce(
+        available,
+        [](const std::vector<std::uint64_t>& lhs,
+           const std::vector<std::uint64_t>& rhs) -> std::vector<std::uint64_t> {
+          std::vector<std::uint64_t> res{lhs};
+
+          for (std::size_t i = 0; i < rhs.size(); ++i) res[i] += rhs[i];
+
+          return res;
+        });
+
+    fused_scan_mjl state{std::vector<std::vector<
+        std::pair<int, std::vector<boost::json::value>>>>(heads.size())};
+
+    assert(fused_scan_mjl::ptr == nullptr);
+    fused_scan_mjl::ptr = &state;
+
+    struct reset_ptr {
+      ~reset_ptr() { fused_scan_mjl::ptr = nullptr; }
+    } resetGuard;
+
+    world.barrier();
+
+    for (std::size_t i = 0; i < heads.size(); ++i) {
+      std::uint64_t before = 0;
+
+      for (int r = 0; r < rank; ++r) before += available[i * numranks + r];
+
+      const std::uint64_t needed =
+          heads[i].numrows > before ? heads[i].numrows - before : 0;
+      std::vector<boost::json::value>& rows = headRows[i];
+
+      rows.resize(std::min<std::uint64_t>(rows.size(), needed));
+
+      if (rows.empty()) continue;
+
+      if (rank == 0) {
+        state.remoteRows[i].emplace_back(rank, std::move(rows));
+        continue;
+      }
+
+      world.async(
+          0,
+          [](std::size_t i, int src,
+             const std::vector<boost::json::value>& rows) -> void {
+            fused_scan_mjl::ptr->remoteRows[i].emplace_back(src, rows);
+          },
+          i, rank, rows);
+    }
+
+    world.barrier();
+
+    if (rank != 0) return res;
+
+    for (std::size_t i = 0; i < heads.size(); ++i) {
+      auto& parts = state.remoteRows[i];
+
+      std::sort(parts.begin(), parts.end(),
+                [](const auto& lhs, const auto& rhs) -> bool {
+                  return lhs.first < rhs.first;
+                });
+
+      for (auto& [src, rows] : parts)
+        for (boost::json::value& row : rows)
+          res[i].emplace_back(std::move(row));
+    }
+
+    return res;
+  }
+
+  const metall_json_lines*  lines;
+  std::vector<request>      requests;
+  std::vector<bool>         counts;  ///< true, if all rows are counted
+  std::vector<head_request> heads;
+  std::vector<hist_request> hists;
+};
+
+}  // namespace experimental
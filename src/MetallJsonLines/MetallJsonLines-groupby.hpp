@@ -0,0 +1,526 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <cereal/types/utility.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "MetallJsonLines-hash.hpp"
+#include "MetallJsonLines.hpp"
+
+namespace experimental {
+
+/// partial aggregate of one column within one group.
+///   partial aggregates are computed locally and then combined on the
+///   group's owner rank, so the exchanged data is proportional to the
+///   number of groups.
+struct partial_aggregate {
+  std::uint64_t              count    = 0;  ///< number of values
+  std::uint64_t              numcount = 0;  ///< number of numeric values
+  std::int64_t               isum     = 0;  ///< sum of the integers
+  double                     dsum     = 0;  ///< sum of all numbers
+  bool                       real     = false;  ///< if a double was added
+  boost::json::value         min      = nullptr;
+  boost::json::value         max      = nullptr;
+  std::vector<std::uint64_t> distinct;  ///< sorted hashes of the values
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(count, numcount, isum, dsum, real, min, max, distinct);
+  }
+};
+
+namespace {
+
+/// orders numbers before strings; numbers numerically, strings
+///   lexicographically. Other values are not ordered.
+inline bool less_for_minmax(const boost::json::value& lhs,
+                            const boost::json::value& rhs) {
+  if (lhs.is_number() && rhs.is_number()) {
+    if (lhs.is_int64() && rhs.is_int64())
+      return lhs.as_int64() < rhs.as_int64();
+
+    return lhs.to_number<double>() < rhs.to_number<double>();
+  }
+
+  if (lhs.is_number()) return rhs.is_string();
+  if (!lhs.is_string() || !rhs.is_string()) return false;
+
+  return lhs.as_string() < rhs.as_string();
+}
+
+inline bool orderable(const boost::json::value& val) {
+  return val.is_number() || val.is_string();
+}
+
+/// adds a row's value to a partial aggregate
+template <class Accessor>
+void accumulate(partial_aggregate& agg, aggregate_op op, const Accessor& val) {
+  if (val.is_null()) return;
+
+  ++agg.count;
+
+  switch (op) {
+    case aggregate_op::count:
+      return;
+
+    case aggregate_op::count_distinct:
+      agg.distinct.push_back(json_hash_code(val));
+      return;
+
+    case aggregate_op::sum:
+    case aggregate_op::mean:
+      if (val.is_int64()) {
+        agg.isum += val.as_int64();
+        agg.dsum += val.as_int64();
+      } else if (val.is_uint64()) {
+        agg.isum += std::int64_t(val.as_uint64());
+        agg.dsum += val.as_uint64();
+      } else if (val.is_double()) {
+        agg.dsum += val.as_double();
+        agg.real = true;
+      } else {
+        return;
+      }
+
+      ++agg.numcount;
+      return;
+
+    case aggregate_op::min:
+    case aggregate_op::max: {
+      boost::json::value jv = json_bento::value_to<boost::json::value>(val);
+
+      if (!orderable(jv)) return;
+
+      boost::json::value& cur = (op == aggregate_op::min) ? agg.min : agg.max;
+
+      if (cur.is_null() || ((op == aggregate_op::min) ? less_for_minmax(jv, cur)
+                                                      : less_for_minmax(cur, jv)))
+        cur = std::move(jv);
+
+      return;
+    }
+  }
+}
+
+/// returns the partial aggregate of a view's partial aggregate
+inline partial_aggregate from_view_partial(const view_partial& vp) {
+  partial_aggregate res;
+
+  res.count    = vp.count;
+  res.numcount = vp.numcount;
+  res.isum     = vp.isum;
+  res.dsum     = vp.dsum;
+  res.real     = vp.real;
+  res.min      = vp.min.to_json();
+  res.max      = vp.max.to_json();
+  return res;
+}
+
+/// sorts and deduplicates the hashes of count_distinct
+inline void compact(partial_aggregate& agg) {
+  std::sort(agg.distinct.begin(), agg.distinct.end());
+  agg.distinct.erase(std::unique(agg.distinct.begin(), agg.distinct.end()),
+                     agg.distinct.end());
+}
+
+/// combines two partial aggregates of the same column and group
+inline void combine(partial_aggregate& lhs, const partial_aggregate& rhs) {
+  lhs.count += rhs.count;
+  lhs.numcount += rhs.numcount;
+  lhs.isum += rhs.isum;
+  lhs.dsum += rhs.dsum;
+  lhs.real = lhs.real || rhs.real;
+
+  if (!rhs.min.is_null() &&
+      (lhs.min.is_null() || less_for_minmax(rhs.min, lhs.min)))
+    lhs.min = rhs.min;
+
+  if (!rhs.max.is_null() &&
+      (lhs.max.is_null() || less_for_minmax(lhs.max, rhs.max)))
+    lhs.max = rhs.max;
+
+  if (!rhs.distinct.empty()) {
+    std::vector<std::uint64_t> merged;
+
+    merged.reserve(lhs.distinct.size() + rhs.distinct.size());
+    std::set_union(lhs.distinct.begin(), lhs.distinct.end(),
+                   rhs.distinct.begin(), rhs.distinct.end(),
+                   std::back_inserter(merged));
+    lhs.distinct.swap(merged);
+  }
+}
+
+/// returns the final value of an aggregate
+inline boost::json::value finalize(const partial_aggregate& agg,
+                                   aggregate_op             op) {
+  switch (op) {
+    case aggregate_op::count:
+      return agg.count;
+
+    case aggregate_op::count_distinct:
+      return agg.distinct.size();
+
+    case aggregate_op::sum:
+      if (agg.real) return agg.dsum;
+      return agg.isum;
+
+    case aggregate_op::mean:
+      if (agg.numcount == 0) return nullptr;
+      return agg.dsum / double(agg.numcount);
+
+    case aggregate_op::min:
+      return agg.min;
+
+    case aggregate_op::max:
+      return agg.max;
+  }
+
+  return nullptr;
+}
+
+using group_table_type =
+    std::unordered_map<boost::json::value, std::vector<partial_aggregate>,
+                       json_value_hash>;
+using partial_groups_type =
+    std::vector<std::pair<boost::json::value, std::vector<partial_aggregate>>>;
+
+/// state of a groupby on each rank, accessed by message handlers
+struct groupby_process_data {
+  group_table_type*                 groups = nullptr;
+  std::vector<boost::json::value>*  result = nullptr;
+};
+
+groupby_process_data groupbyState;
+
+void store_partial_groups(const partial_groups_type& groups) {
+  assert(groupbyState.groups != nullptr);
+
+  for (const auto& [key, partials] : groups) {
+    auto [pos, fresh] = groupbyState.groups->try_emplace(key, partials);
+
+    if (fresh) continue;
+
+    for (std::size_t i = 0; i < partials.size(); ++i)
+      combine(pos->second[i], partials[i]);
+  }
+}
+
+void store_result_rows(const std::vector<boost::json::value>& rows) {
+  assert(groupbyState.result != nullptr);
+
+  groupbyState.result->insert(groupbyState.result->end(), rows.begin(),
+                              rows.end());
+}
+
+/// returns the array of the values of \ref keys in row object \ref obj,
+///   or null if the row misses a key
+template <class ObjectAccessor>
+boost::json::value group_key(const ObjectAccessor&           obj,
+                             const std::vector<std::string>& keys) {
+  boost::json::array groupkey;
+
+  for (const std::string& key : keys) {
+    const auto val = obj.if_contains(key);
+
+    if (!val) return nullptr;
+
+    groupkey.emplace_back(json_bento::value_to<boost::json::value>(*val));
+  }
+
+  return groupkey;
+}
+
+/// aggregates the selected rows of \ref lines locally into \ref local
+inline void scan_groups(const metall_json_lines&           lines,
+                        const std::vector<std::string>&    keys,
+                        const std::vector<aggregate_spec>& aggs,
+                        group_table_type&                  local) {
+  lines.for_all_selected(
+      [&keys, &aggs, &local](std::size_t,
+                             const metall_json_lines::accessor_type& row) {
+        if (!row.is_object()) return;
+
+        const auto         obj      = row.as_object();
+        boost::json::value groupkey = group_key(obj, keys);
+
+        if (groupkey.is_null()) return;
+
+        auto [pos, fresh] = local.try_emplace(std::move(groupkey));
+
+        if (fresh) pos->second.resize(aggs.size());
+
+        for (std::size_t i = 0; i < aggs.size(); ++i) {
+          if (const auto val = obj.if_contains(aggs[i].first))
+            accumulate(pos->second[i], aggs[i].second, *val);
+        }
+      });
+}
+
+/// sends the partial aggregates of \ref local to the groups' owners (chosen
+///   by json_hash_code of the group key), which combine them into
+///   \ref owned; \ref local is cleared. Collective.
+inline void shuffle_groups(ygm::comm& world, group_table_type& local,
+                           group_table_type& owned) {
+  groupbyState.groups = &owned;
+  world.cf_barrier();
+
+  {
+    std::vector<partial_groups_type> outgoing(world.size());
+
+    for (auto& [key, partials] : local) {
+      const int owner = std::uint64_t(json_hash_code(key)) % world.size();
+
+      for (partial_aggregate& agg : partials) compact(agg);
+
+      outgoing[owner].emplace_back(key, std::move(partials));
+    }
+
+    local.clear();
+
+    for (int dest = 0; dest < world.size(); ++dest) {
+      if (outgoing[dest].empty()) continue;
+
+      world.async(
+          dest,
+          [](const partial_groups_type& groups) -> void {
+            store_partial_groups(groups);
+          },
+          outgoing[dest]);
+    }
+  }
+
+  world.barrier();
+}
+
+}  // namespace
+
+/// groups the selected rows by the values of \ref keys and aggregates
+///   columns within each group.
+/// \param  lines  the container (with its selection)
+/// \param  keys   the columns to group by; rows that miss a key are skipped
+/// \param  aggs   the columns to aggregate and their aggregate functions;
+///         null values are ignored; sum and mean only consider numbers;
+///         min and max consider numbers and strings.
+/// \return on rank 0, one object per group (ordered by the group keys' JSON
+///         text) with the key columns and one field per aggregated column;
+///         empty on the other ranks.
+/// \details
+///   each rank first aggregates its rows locally; the partial aggregates
+///   are then sent to the group's owner (chosen by json_hash_code of the
+///   group key), which combines them. count_distinct is computed on 64-bit
+///   value hashes. Without a selection, the local partial aggregates are
+///   taken from a current materialized view with the same keys and
+///   aggregates, if there is one (see create_aggregate_view).
+inline boost::json::array groupby(const metall_json_lines&           lines,
+                                  const std::vector<std::string>&    keys,
+                                  const std::vector<aggregate_spec>& aggs) {
+  if (keys.empty()) throw std::invalid_argument{"groupby needs a key column"};
+
+  ygm::comm& world = lines.comm();
+
+  // phase 1: local partial aggregation, or the partial aggregates of a
+  //   materialized view
+  group_table_type local;
+
+  if (auto match = lines.find_aggregate_view(keys, aggs)) {
+    const metall_json_lines::aggregate_view_type& av = *match->view;
+
+    for (std::size_t g = 0; g < av.size(); ++g) {
+      std::vector<partial_aggregate> partials;
+
+      for (std::size_t a : match->aggs)
+        partials.push_back(
+            from_view_partial(av.partial(g, a, match->numAggs)));
+
+      local.emplace(boost::json::parse(av.key(g)), std::move(partials));
+    }
+  } else {
+    scan_groups(lines, keys, aggs, local);
+  }
+
+  // phase 2: shuffle partial aggregates to the groups' owners
+  group_table_type                owned;
+  std::vector<boost::json::value> result;
+
+  groupbyState.result = &result;
+  shuffle_groups(world, local, owned);
+
+  // phase 3: finalize the owned groups and gather them on rank 0
+  {
+    // rows are sent as boost::json::value, which ygm can serialize
+    std::vector<boost::json::value> rows;
+
+    rows.reserve(owned.size());
+    for (const auto& [key, partials] : owned) {
+      boost::json::object      row;
+      const boost::json::array& keyvals = key.as_array();
+
+      for (std::size_t i = 0; i < keys.size(); ++i) row[keys[i]] = keyvals[i];
+
+      for (std::size_t i = 0; i < aggs.size(); ++i)
+        row[aggs[i].first] = finalize(partials[i], aggs[i].second);
+
+      rows.emplace_back(std::move(row));
+    }
+
+    owned.clear();
+
+    if (rows.size())
+      world.async(
+          0,
+          [](const std::vector<boost::json::value>& rows) -> void {
+            store_result_rows(rows);
+          },
+          rows);
+  }
+
+  world.barrier();
+  groupbyState = groupby_process_data{};
+
+  // order groups deterministically
+  std::vector<std::pair<std::string, boost::json::value>> sorted;
+
+  sorted.reserve(result.size());
+  for (boost::json::value& row : result) {
+    boost::json::array keyvals;
+
+    for (const std::string& key : keys)
+      keyvals.emplace_back(row.as_object()[key]);
+
+    sorted.emplace_back(boost::json::serialize(keyvals), std::move(row));
+  }
+
+  std::sort(sorted.begin(), sorted.end(),
+            [](const auto& lhs, const auto& rhs) -> bool {
+              return lhs.first < rhs.first;
+            });
+
+  boost::json::array res;
+
+  for (auto& [text, row] : sorted) res.emplace_back(std::move(row));
+
+  return res;
+}
+
+/// combines the rows of \ref lines with the same values of \ref keys into
+///   one row (e.g., multi-edges into one edge), which has the key columns,
+///   the aggregates of \ref aggs, and the number of combined rows.
+///   Collective.
+/// \param  aggs        the columns to aggregate with sum, min, or max; the
+///         aggregates are stored under the columns' names, thus the rows can
+///         be combined again (e.g., after more rows were appended).
+/// \param  countColumn if not empty, the column that receives the number of
+///         combined rows; a row with an integer in this column counts as
+///         that many rows.
+/// \return the number of rows after combining
+/// \details
+///   the rows are aggregated locally and shuffled to the groups' owners as
+///   in groupby; each owner then replaces its rows by the rows of its
+///   groups (see metall_json_lines::replace_local). The selection is
+///   ignored; rows that miss a key column, and the columns that are
+///   neither keys nor aggregated, are dropped.
+inline std::size_t collapse_rows(metall_json_lines&                 lines,
+                                 const std::vector<std::string>&    keys,
+                                 const std::vector<aggregate_spec>& aggs,
+                                 const std::string& countColumn = {}) {
+  auto isKey = [&keys](const std::string& col) -> bool {
+    return std::find(keys.begin(), keys.end(), col) != keys.end();
+  };
+
+  if (keys.empty()) throw std::invalid_argument{"collapse needs a key column"};
+
+  if (isKey(countColumn))
+    throw std::invalid_argument{"the count column is a key: " + countColumn};
+
+  for (const auto& [col, op] : aggs) {
+    if ((op != aggregate_op::sum) && (op != aggregate_op::min) &&
+        (op != aggregate_op::max))
+      throw std::invalid_argument{
+          "collapse aggregates with sum, min, or max: " + col};
+
+    if (isKey(col) || (col == countColumn))
+      throw std::invalid_argument{
+          "aggregated column is a key or the count column: " + col};
+  }
+
+  ygm::comm& world = lines.comm();
+
+  // phase 1: local partial aggregation; the last partial counts the rows
+  group_table_type local;
+
+  lines.clear_filter();
+  lines.for_all_selected([&keys, &aggs, &countColumn, &local](
+                             std::size_t,
+                             const metall_json_lines::accessor_type& row) {
+    if (!row.is_object()) return;
+
+    const auto         obj      = row.as_object();
+    boost::json::value groupkey = group_key(obj, keys);
+
+    if (groupkey.is_null()) return;
+
+    auto [pos, fresh] = local.try_emplace(std::move(groupkey));
+
+    if (fresh) pos->second.resize(aggs.size() + 1);
+
+    for (std::size_t i = 0; i < aggs.size(); ++i) {
+      if (const auto val = obj.if_contains(aggs[i].first))
+        accumulate(pos->second[i], aggs[i].second, *val);
+    }
+
+    std::int64_t weight = 1;
+
+    if (!countColumn.empty()) {
+      if (const auto cnt = obj.if_contains(countColumn)) {
+        if (cnt->is_int64())
+          weight = cnt->as_int64();
+        else if (cnt->is_uint64())
+          weight = std::int64_t(cnt->as_uint64());
+      }
+    }
+
+    pos->second.back().isum += weight;
+  });
+
+  // phase 2: shuffle partial aggregates to the groups' owners
+  group_table_type owned;
+
+  shuffle_groups(world, local, owned);
+  groupbyState = groupby_process_data{};
+
+  // phase 3: the owners store their groups
+  std::vector<boost::json::value> rows;
+
+  rows.reserve(owned.size());
+  for (const auto& [key, partials] : owned) {
+    boost::json::object       row;
+    const boost::json::array& keyvals = key.as_array();
+
+    for (std::size_t i = 0; i < keys.size(); ++i) row[keys[i]] = keyvals[i];
+
+    for (std::size_t i = 0; i < aggs.size(); ++i)
+      if (partials[i].count > 0)
+        row[aggs[i].first] = finalize(partials[i], aggs[i].second);
+
+    if (!countColumn.empty()) row[countColumn] = partials.back().isum;
+
+    rows.emplace_back(std::move(row));
+  }
+
+  owned.clear();
+  lines.replace_local(rows);
+
+  return world.all_reduce_sum(rows.size());
+}
+
+}  // namespace experimental
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <limits>
+#include <string_view>
+
+#include <boost/functional/hash.hpp>
+
+// use boost or alternative hash combine
+static constexpr bool USE_BOOST_HASH_COMBINE = true;
+
+//
+// alternative hash_combine: https://stackoverflow.com/a/50978188
+
+inline
+std::uint64_t xor_shift(std::uint64_t n, int i) { return n ^ (n >> i); }
+
+// a hash function with another name as to not confuse with std::hash
+inline
+std::uint64_t stable_hash_distribute(std::uint64_t n) {
+  std::uint64_t p = 0x5555555555555555ull;    // pattern of alternating 0 and 1
+  std::uint64_t c = 17316035218449499591ull;  // random uneven integer constant;
+  return c * xor_shift(p * xor_shift(n, 32), 32);
+}
+
+inline
+std::uint64_t stable_hash_combine(std::uint64_t seed, std::uint64_t comp) {
+  const std::uint64_t distr = stable_hash_distribute(comp);
+
+  return std::rotl(seed, std::numeric_limits<std::uint64_t>::digits/3) ^ distr;
+}
+
+/// a 64-bit finalizer (fmix64 of MurmurHash3). It only uses shifts, xors,
+///   and multiplications, so that a loop over an array of keys vectorizes.
+inline
+std::uint64_t mix_hash64(std::uint64_t k) {
+  k ^= k >> 33;
+  k *= 0xff51afd7ed558ccdull;
+  k ^= k >> 33;
+  k *= 0xc4ceb9fe1a85ec53ull;
+  k ^= k >> 33;
+  return k;
+}
+
+/// replaces each of the \ref n words at \ref keys by its mix_hash64
+inline
+void mix_hash64(std::uint64_t* keys, std::size_t n) {
+  for (std::size_t i = 0; i < n; ++i)
+    keys[i] = mix_hash64(keys[i]);
+}
+
+/// a string hash that, unlike std::hash, is the same in every run and
+///   library version (for a given byte order); reads 8 bytes at a time.
+/// \param seed hashes with different seeds can verify each other
+inline
+std::uint64_t stable_string_hash(
+    std::string_view str, std::uint64_t seed = 0x9e3779b97f4a7c15ull) {
+  std::uint64_t     res = mix_hash64(str.size() ^ seed);
+  std::size_t       pos = 0;
+  const std::size_t len = str.size();
+
+  for (; pos + sizeof(std::uint64_t) <= len; pos += sizeof(std::uint64_t)) {
+    std::uint64_t word;
+
+    std::memcpy(&word, str.data() + pos, sizeof(word));
+    res = mix_hash64(res ^ word);
+  }
+
+  if (pos < len) {
+    std::uint64_t word = 0;
+
+    std::memcpy(&word, str.data() + pos, len - pos);
+    res = mix_hash64(res ^ word);
+  }
+
+  return res;
+}
+
+inline
+std::uint64_t combine_hash(std::uint64_t lhs, std::uint64_t rhs) {
+  if (!USE_BOOST_HASH_COMBINE)
+    return stable_hash_combine(lhs, rhs);
+
+  boost::hash_combine(lhs, rhs);
+  return lhs;
+}
+
+
+template <typename MetallJsonAccessor>
+std::int64_t json_hash_code(const MetallJsonAccessor& val) {
+  if (val.is_null()) return std::hash<nullptr_t>{}(nullptr);
+  if (val.is_bool()) return std::hash<bool>{}(val.as_bool());
+  if (val.is_int64()) return std::hash<std::int64_t>{}(val.as_int64());
+  if (val.is_uint64()) return std::hash<std::uint64_t>{}(val.as_uint64());
+  if (val.is_double()) return std::hash<double>{}(val.as_double());
+
+  if (val.is_string()) {
+    const auto& str = val.as_string();
+
+    return std::hash<std::string_view>{}(std::string_view(str));
+  }
+
+  if (val.is_object()) {
+    const auto& obj = val.as_object();
+
+    std::int64_t res{0};
+
+    for (const auto& el : obj) {
+      res = combine_hash(res, std::hash<std::string_view>{}(el.key()));
+      res = combine_hash(res, json_hash_code(el.value()));
+    }
+
+    return res;
+  }
+
+  assert(val.is_array());
+  std::int64_t res{0};
+
+  // \todo should an element's position be taken into account for the computed
+  // hash value?
+  for (const auto& el : val.as_array())
+    res = combine_hash(res, json_hash_code(el));
+
+  return res;
+}
+
+/// the hash of a join key value: integers and strings are hashed by the
+///   stable functions above, so that the partitioning of a join is the same
+///   in every run; other values fall back to json_hash_code.
+/// \note int64 and uint64 values that compare equal have the same hash.
+template <typename MetallJsonAccessor>
+std::uint64_t key_hash_code(const MetallJsonAccessor& val) {
+  if (val.is_int64()) return mix_hash64(std::uint64_t(val.as_int64()));
+  if (val.is_uint64()) return mix_hash64(val.as_uint64());
+  if (val.is_string())
+    return stable_string_hash(std::string_view(val.as_string()));
+
+  return json_hash_code(val);
+}
+
+/// hash functor for boost::json::value (and JSON Bento accessors),
+///   to be used in unordered containers.
+struct json_value_hash {
+  template <typename JsonValue>
+  std::size_t operator()(const JsonValue& val) const {
+    return json_hash_code(val);
+  }
+};
@@ -0,0 +1,119 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief A HyperLogLog sketch for approximate distinct counts.
+
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace experimental {
+
+/// estimates the number of distinct 64-bit hashes that were added.
+/// \details
+///   the sketch has 2^precision one-byte registers; a hash selects a
+///   register by its top precision bits and records the position of the
+///   first set bit of the remaining bits. The relative standard error of
+///   the estimate is about 1.04 / sqrt(2^precision), e.g., 1.6% for the
+///   default precision of 12 (4 KiB). Sketches of the same precision are
+///   merged by the registers' maximum, so that the sketches of all ranks
+///   are combined with one all-reduce (see hyperloglog_merge).
+///   Small cardinalities are estimated by linear counting.
+class hyperloglog {
+ public:
+  static constexpr int MIN_PRECISION     = 4;
+  static constexpr int MAX_PRECISION     = 18;
+  static constexpr int DEFAULT_PRECISION = 12;
+
+  explicit hyperloglog(int precision = DEFAULT_PRECISION) : bits(precision) {
+    if ((precision < MIN_PRECISION) || (precision > MAX_PRECISION))
+      throw std::invalid_argument{"hyperloglog precision must be in [" +
+                                  std::to_string(MIN_PRECISION) + ", " +
+                                  std::to_string(MAX_PRECISION) + "]"};
+
+    regs.resize(std::size_t(1) << bits, 0);
+  }
+
+  /// adds a (well mixed) hash, e.g., of mix_hash64
+  void add(std::uint64_t hash) {
+    const std::size_t   idx  = hash >> (64 - bits);
+    const std::uint64_t rest = hash << bits;
+    const int           rank = rest ? std::countl_zero(rest) + 1 : 65 - bits;
+
+    regs[idx] = std::max(regs[idx], std::uint8_t(rank));
+  }
+
+  /// adds the hashes of \ref other, which must have the same precision
+  void merge(const hyperloglog& other) { merge(other.regs); }
+
+  /// merges registers, e.g., the result of an all-reduce
+  void merge(const std::vector<std::uint8_t>& other) {
+    if (other.size() != regs.size())
+      throw std::invalid_argument{"hyperloglog precisions differ"};
+
+    for (std::size_t i = 0; i < regs.size(); ++i)
+      regs[i] = std::max(regs[i], other[i]);
+  }
+
+  /// returns the estimated number of distinct hashes
+  double estimate() const {
+    const double m     = double(regs.size());
+    double       sum   = 0;
+    std::size_t  zeros = 0;
+
+    for (const std::uint8_t r : regs) {
+      sum += std::ldexp(1.0, -int(r));
+      zeros += (r == 0);
+    }
+
+    const double est = alpha() * m * m / sum;
+
+    if ((est <= 2.5 * m) && (zeros > 0)) return m * std::log(m / zeros);
+
+    return est;
+  }
+
+  int                              precision() const { return bits; }
+  const std::vector<std::uint8_t>& registers() const { return regs; }
+
+ private:
+  double alpha() const {
+    switch (bits) {
+      case 4:
+        return 0.673;
+      case 5:
+        return 0.697;
+      case 6:
+        return 0.709;
+      default:
+        return 0.7213 / (1.0 + 1.079 / double(regs.size()));
+    }
+  }
+
+  int                       bits;
+  std::vector<std::uint8_t> regs;
+};
+
+/// all-reduce operator that merges the registers of two sketches
+struct hyperloglog_merge {
+  std::vector<std::uint8_t> operator()(
+      const std::vector<std::uint8_t>& lhs,
+      const std::vector<std::uint8_t>& rhs) const {
+    std::vector<std::uint8_t> res{lhs.begin(), lhs.end()};
+
+    for (std::size_t i = 0; i < rhs.size(); ++i)
+      res[i] = std::max(res[i], rhs[i]);
+
+    return res;
+  }
+};
+
+}  // namespace experimental
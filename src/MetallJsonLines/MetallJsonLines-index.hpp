@@ -0,0 +1,327 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+/// sorted secondary indices: for a column, a rank stores its rows' numeric
+///   values in sorted order, together with the row numbers. A selection
+///   that bounds the column (e.g., `t0 <= keys.created_utc <= t1`) then
+///   only evaluates its rule for the rows whose values are in the bounds,
+///   instead of for all rows.
+/// \details
+///   json_logic compares non-numeric values (e.g., strings, null, or a
+///   missing field) with numbers after converting them. Rows whose column
+///   is not a number are therefore recorded separately and are candidates
+///   of every lookup. The candidates are a superset of the selected rows;
+///   the selection's rule still filters them.
+namespace experimental {
+
+/// the numeric values [lo, hi] of a column that a selection can select
+struct column_bounds {
+  std::string column;
+  double      lo = -std::numeric_limits<double>::infinity();
+  double      hi = std::numeric_limits<double>::infinity();
+
+  /// returns the bounds of the columns that \ref rule compares with
+  ///   numeric constants; only comparisons in the top-level conjunction
+  ///   are considered.
+  /// \param rule          a json_logic rule
+  /// \param selectPrefix  the prefix of the variable names (e.g., "keys")
+  static std::vector<column_bounds> of_rule(const boost::json::value& rule,
+                                            std::string_view selectPrefix) {
+    std::vector<column_bounds> res;
+
+    add_rule(res, rule, selectPrefix);
+    return res;
+  }
+
+ private:
+  /// returns v, if val is {"var": "<selectPrefix>.<v>"}
+  static std::optional<std::string_view> column_name(
+      const boost::json::value& val, std::string_view selectPrefix) {
+    const boost::json::object* obj = val.if_object();
+
+    if (!obj || (obj->size() != 1)) return std::nullopt;
+
+    const boost::json::value* var = obj->if_contains("var");
+
+    if (!var || !var->is_string()) return std::nullopt;
+
+    const std::string_view name{var->as_string().data(),
+                                var->as_string().size()};
+
+    if ((name.size() <= selectPrefix.size()) ||
+        (name.substr(0, selectPrefix.size()) != selectPrefix) ||
+        (name[selectPrefix.size()] != '.'))
+      return std::nullopt;
+
+    return name.substr(selectPrefix.size() + 1);
+  }
+
+  /// returns \ref val as double, if it is a number
+  ///   (the conversion is monotonic, thus strict comparisons are
+  ///   widened to inclusive bounds).
+  static std::optional<double> number(const boost::json::value& val) {
+    if (val.is_int64()) return double(val.as_int64());
+    if (val.is_uint64()) return double(val.as_uint64());
+    if (val.is_double()) return val.as_double();
+
+    return std::nullopt;
+  }
+
+  /// returns the comparison with swapped operands
+  static std::string_view flip(std::string_view op) {
+    if (op == "<") return ">";
+    if (op == "<=") return ">=";
+    if (op == ">") return "<";
+    if (op == ">=") return "<=";
+
+    return op;
+  }
+
+  /// narrows the bounds of \ref col in \ref res by `col op c`
+  static void add_comparison(std::vector<column_bounds>& res,
+                             std::string_view col, std::string_view op,
+                             double c) {
+    const bool upper = (op == "<") || (op == "<=");
+    const bool lower = (op == ">") || (op == ">=");
+    const bool equal = (op == "==") || (op == "===");
+
+    if (!upper && !lower && !equal) return;
+
+    auto pos = std::find_if(res.begin(), res.end(),
+                            [col](const column_bounds& b) -> bool {
+                              return b.column == col;
+                            });
+
+    if (pos == res.end()) {
+      res.push_back(column_bounds{std::string(col)});
+      pos = std::prev(res.end());
+    }
+
+    if (upper || equal) pos->hi = std::min(pos->hi, c);
+    if (lower || equal) pos->lo = std::max(pos->lo, c);
+  }
+
+  static void add_rule(std::vector<column_bounds>& res,
+                       const boost::json::value&   rule,
+                       std::string_view            selectPrefix) {
+    const boost::json::object* obj = rule.if_object();
+
+    if (!obj || (obj->size() != 1)) return;
+
+    const auto&               op   = *obj->begin();
+    const boost::json::array* args = op.value().if_array();
+
+    if (!args) return;
+
+    const std::string_view opname{op.key().data(), op.key().size()};
+
+    if (opname == "and") {
+      for (const boost::json::value& sub : *args)
+        add_rule(res, sub, selectPrefix);
+
+      return;
+    }
+
+    if (args->size() == 2) {
+      if (const auto col = column_name((*args)[0], selectPrefix)) {
+        if (const auto c = number((*args)[1]))
+          add_comparison(res, *col, opname, *c);
+      } else if (const auto col = column_name((*args)[1], selectPrefix)) {
+        if (const auto c = number((*args)[0]))
+          add_comparison(res, *col, flip(opname), *c);
+      }
+
+      return;
+    }
+
+    // between: {"<": [a, {"var": ...}, b]} (or "<=")
+    if ((args->size() == 3) && ((opname == "<") || (opname == "<="))) {
+      const auto col = column_name((*args)[1], selectPrefix);
+      const auto lo  = number((*args)[0]);
+      const auto hi  = number((*args)[2]);
+
+      if (!col || !lo || !hi) return;
+
+      add_comparison(res, *col, ">=", *lo);
+      add_comparison(res, *col, "<=", *hi);
+    }
+  }
+};
+
+/// a filter that passes the column bounds of a selection to the container:
+///   metall_json_lines::filter recognizes it and looks up the candidate
+///   rows in a sorted index of a bounded column. It selects all rows.
+struct column_bounds_hint {
+  std::vector<column_bounds> bounds;
+
+  template <class Accessor>
+  bool operator()(std::size_t, const Accessor&) const {
+    return true;
+  }
+};
+
+/// identifies the state of the rows that an index was built from;
+///   an index is stale when the rows were modified since.
+struct sorted_index_stamp {
+  std::uint64_t numrows = 0;
+  std::uint64_t mods    = 0;
+
+  bool operator==(const sorted_index_stamp&) const = default;
+};
+
+/// an index under construction, in DRAM
+struct sorted_index_buffer {
+  /// (value, row) of the rows with a numeric value
+  std::vector<std::pair<double, std::uint64_t>> entries;
+  /// the rows without a numeric value
+  std::vector<std::uint64_t>                    others;
+};
+
+/// the persistent sorted indices of a rank, keyed by column;
+///   stored next to the local container in the same Metall datastore.
+template <class Alloc>
+class sorted_index_cache {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+  using value_vector =
+      metall::container::vector<double, other_allocator<double>>;
+  using row_vector =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+
+ public:
+  /// the index of one column
+  class index {
+   public:
+    index(std::string_view col, const allocator_type& alloc)
+        : column(col.data(), col.size(), alloc),
+          values(alloc),
+          rows(alloc),
+          others(alloc) {}
+
+    std::string_view name() const { return {column.data(), column.size()}; }
+
+    /// returns true, if the index was built from rows in state \ref st
+    bool current(const sorted_index_stamp& st) const { return stamp == st; }
+
+    /// returns the number of candidate rows for the values [lo, hi]
+    std::size_t count(double lo, double hi) const {
+      const auto [beg, lim] = value_range(lo, hi);
+
+      return (lim - beg) + others.size();
+    }
+
+    /// returns the candidate rows for the values [lo, hi], in row order
+    std::vector<std::size_t> candidates(double lo, double hi) const {
+      const auto [beg, lim] = value_range(lo, hi);
+
+      std::vector<std::size_t> res(rows.begin() + beg, rows.begin() + lim);
+
+      res.insert(res.end(), others.begin(), others.end());
+      std::sort(res.begin(), res.end());
+      return res;
+    }
+
+    /// stores \ref buf, built from rows in state \ref st
+    void assign(sorted_index_buffer buf, const sorted_index_stamp& st) {
+      std::sort(buf.entries.begin(), buf.entries.end());
+
+      values.clear();
+      rows.clear();
+      values.reserve(buf.entries.size());
+      rows.reserve(buf.entries.size());
+
+      for (const auto& [val, row] : buf.entries) {
+        values.push_back(val);
+        rows.push_back(row);
+      }
+
+      others.assign(buf.others.begin(), buf.others.end());
+      stamp = st;
+    }
+
+   private:
+    /// returns the positions [beg, lim) of the values in [lo, hi]
+    std::pair<std::size_t, std::size_t> value_range(double lo,
+                                                    double hi) const {
+      if (hi < lo) return {0, 0};
+
+      const auto beg = std::lower_bound(values.begin(), values.end(), lo);
+      const auto lim = std::upper_bound(beg, values.end(), hi);
+
+      return {std::size_t(beg - values.begin()),
+              std::size_t(lim - values.begin())};
+    }
+
+    string_type        column;
+    value_vector       values;  ///< the numeric values, sorted
+    row_vector         rows;    ///< the rows of values
+    row_vector         others;  ///< rows without a numeric value, sorted
+    sorted_index_stamp stamp;
+  };
+
+  explicit sorted_index_cache(const allocator_type& alloc) : entries(alloc) {}
+
+  /// returns the index of \ref column, or nullptr
+  const index* find(std::string_view column) const {
+    for (const index& el : entries)
+      if (el.name() == column) return &el;
+
+    return nullptr;
+  }
+
+  /// stores the index of \ref column, built from rows in state \ref st
+  void store(std::string_view column, sorted_index_buffer buf,
+             const sorted_index_stamp& st) {
+    index* pos = nullptr;
+
+    for (index& el : entries)
+      if (el.name() == column) pos = &el;
+
+    if (!pos) {
+      entries.emplace_back(column, entries.get_allocator());
+      pos = &entries.back();
+    }
+
+    pos->assign(std::move(buf), st);
+  }
+
+  /// returns the indexed columns
+  std::vector<std::string> columns() const {
+    std::vector<std::string> res;
+
+    for (const index& el : entries) res.emplace_back(el.name());
+
+    return res;
+  }
+
+  /// returns the number of indices
+  std::size_t size() const { return entries.size(); }
+
+ private:
+  metall::container::vector<index, other_allocator<index>> entries;
+};
+
+}  // namespace experimental
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+
+#include <mpi.h>
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines-lease.hpp"
+
+/// background jobs: a long method (e.g., connected components, merge) that
+///   is called with a job name reports its progress to a status file next
+///   to its datastore (<loc>.jobs/<name>.json); the job_status method reads
+///   the file while the method runs, e.g., started in the background by a
+///   notebook. A job is cancelled by a file <loc>.jobs/<name>.cancel, which
+///   the method checks whenever it reports its progress.
+/// \details
+///   the status has the method, its state ("running", "done", "failed",
+///   or "cancelled"), the current phase, the progress within the phase
+///   (e.g., the round of an algorithm), the start and update times
+///   (seconds since the epoch), and the result of a finished job. Rank 0
+///   writes the status; all ranks report at the same points, after a
+///   barrier, as the cancellation is broadcast from rank 0.
+namespace experimental {
+
+/// thrown by the ranks of a cancelled job
+struct job_cancelled : std::runtime_error {
+  job_cancelled() : std::runtime_error{"job cancelled"} {}
+};
+
+namespace {
+/// returns the directory of the jobs of the datastore at \ref loc
+inline std::string jobs_location(std::string_view loc) {
+  return shared_base(loc) + ".jobs";
+}
+
+/// returns the status file of job \ref name
+inline std::string job_status_file(std::string_view loc,
+                                   std::string_view name) {
+  if (name.empty() || (name.find('/') != std::string_view::npos))
+    throw std::invalid_argument{"invalid job name: " + std::string(name)};
+
+  return jobs_location(loc) + "/" + std::string(name) + ".json";
+}
+
+/// returns the cancel file of job \ref name
+inline std::string job_cancel_file(std::string_view loc,
+                                   std::string_view name) {
+  std::string res = job_status_file(loc, name);
+
+  res.replace(res.size() - 5, 5, ".cancel");
+  return res;
+}
+
+inline double epoch_seconds() {
+  using clock = std::chrono::system_clock;
+
+  const std::chrono::duration<double> res = clock::now().time_since_epoch();
+
+  return res.count();
+}
+}  // namespace
+
+/// returns the status of job \ref name of the datastore at \ref loc, or
+///   nullopt if there is none
+inline std::optional<boost::json::object> read_job_status(
+    std::string_view loc, std::string_view name) {
+  std::ifstream status{job_status_file(loc, name)};
+
+  if (!status) return std::nullopt;
+
+  const std::string txt{std::istreambuf_iterator<char>(status),
+                        std::istreambuf_iterator<char>()};
+
+  return boost::json::parse(txt).as_object();
+}
+
+/// returns the status of job \ref name after it ended, or after \ref seconds
+///   (then, it may still be running); polls the status file
+inline std::optional<boost::json::object> wait_for_job(std::string_view loc,
+                                                       std::string_view name,
+                                                       double seconds) {
+  using clock = std::chrono::steady_clock;
+
+  constexpr std::chrono::milliseconds POLL_INTERVAL{250};
+
+  const clock::time_point limit =
+      clock::now() + std::chrono::duration_cast<clock::duration>(
+                         std::chrono::duration<double>(seconds));
+
+  while (true) {
+    std::optional<boost::json::object> res = read_job_status(loc, name);
+
+    if (!res || (res->at("state").as_string() != "running") ||
+        (clock::now() >= limit))
+      return res;
+
+    std::this_thread::sleep_for(POLL_INTERVAL);
+  }
+}
+
+/// requests the cancellation of job \ref name, which stops at its next
+///   progress report
+inline void cancel_job(std::string_view loc, std::string_view name) {
+  std::ofstream{job_cancel_file(loc, name)} << epoch_seconds() << std::endl;
+}
+
+/// returns the status of job \ref name (see the job_status methods): after
+///   requesting its cancellation if \ref cancel is set, and after it ended
+///   or \ref seconds passed; throws if there is no such job
+inline boost::json::object query_job(std::string_view loc,
+                                     std::string_view name, bool cancel,
+                                     double seconds) {
+  if (cancel) cancel_job(loc, name);
+
+  std::optional<boost::json::object> res = wait_for_job(loc, name, seconds);
+
+  if (!res) throw std::runtime_error{"unknown job: " + std::string(name)};
+
+  return std::move(*res);
+}
+
+/// the progress of a method that runs as a job; disabled without a name.
+/// \details
+///   while a job is enabled, it is the active job, to which the algorithms
+///   report (see report_progress).
+class job_progress {
+ public:
+  /// starts job \ref name of \ref method on the datastore at \ref loc, or
+  ///   a disabled job if \ref name is empty. Collective.
+  job_progress(std::string_view loc, std::string name, std::string method)
+      : jobName(std::move(name)) {
+    if (!enabled()) return;
+
+    statusFile = job_status_file(loc, jobName);
+    cancelFile = job_cancel_file(loc, jobName);
+
+    if (root()) {
+      std::error_code ec;
+
+      std::filesystem::create_directories(jobs_location(loc));
+      std::filesystem::remove(cancelFile, ec);
+
+      status["method"]   = std::move(method);
+      status["state"]    = "running";
+      status["phase"]    = "";
+      status["progress"] = boost::json::object{};
+      status["started"]  = epoch_seconds();
+      write();
+    }
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    active() = this;
+  }
+
+  /// records an unfinished job as failed, or as cancelled
+  ~job_progress() {
+    if (!enabled()) return;
+
+    active() = nullptr;
+
+    if (finished || !root()) return;
+
+    status["state"] = cancelled ? "cancelled" : "failed";
+    write();
+  }
+
+  job_progress(const job_progress&)            = delete;
+  job_progress& operator=(const job_progress&) = delete;
+
+  /// returns the active job, or null
+  static job_progress*& active() {
+    static job_progress* job = nullptr;
+
+    return job;
+  }
+
+  bool enabled() const { return !jobName.empty(); }
+
+  /// starts phase \ref name. Collective.
+  void phase(std::string name) {
+    if (!enabled()) return;
+
+    if (root()) {
+      status["phase"]    = std::move(name);
+      status["progress"] = boost::json::object{};
+      write();
+    }
+
+    check_cancelled();
+  }
+
+  /// sets the members of \ref progress within the phase; throws
+  ///   job_cancelled if the job was cancelled. Collective.
+  void report(const boost::json::object& progress) {
+    if (!enabled()) return;
+
+    if (root()) {
+      boost::json::object& cur = status["progress"].as_object();
+
+      for (const auto& [key, val] : progress) cur[key] = val;
+
+      if (epoch_seconds() >= lastWrite + UPDATE_INTERVAL) write();
+    }
+
+    check_cancelled();
+  }
+
+  /// records the job as done, with \ref result
+  void done(boost::json::value result) {
+    if (!enabled()) return;
+
+    finished = true;
+
+    if (!root()) return;
+
+    status["state"]  = "done";
+    status["result"] = std::move(result);
+    write();
+  }
+
+ private:
+  /// the minimal seconds between the status updates of report
+  static constexpr double UPDATE_INTERVAL = 1.0;
+
+  static bool root() { return lease_root(); }
+
+  /// replaces the status file, so that readers never see a partial status;
+  ///   a failed update does not stop the job
+  void write() {
+    lastWrite         = epoch_seconds();
+    status["updated"] = lastWrite;
+
+    const std::string staged = statusFile + ".tmp";
+    std::error_code   ec;
+
+    std::ofstream{staged} << boost::json::serialize(status) << std::endl;
+    std::filesystem::rename(staged, statusFile, ec);
+  }
+
+  void check_cancelled() {
+    std::uint64_t flag = 0;
+
+    if (root()) flag = std::filesystem::exists(cancelFile);
+
+    MPI_Bcast(&flag, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+
+    if (flag == 0) return;
+
+    cancelled = true;
+    throw job_cancelled{};
+  }
+
+  std::string         jobName;
+  std::string         statusFile;
+  std::string         cancelFile;
+  boost::json::object status;  ///< rank 0
+  double              lastWrite = 0;
+  bool                finished  = false;
+  bool                cancelled = false;
+};
+
+/// reports \ref progress to the active job, if any (see
+///   job_progress::report). Collective.
+inline void report_progress(const boost::json::object& progress) {
+  if (job_progress* job = job_progress::active()) job->report(progress);
+}
+
+}  // namespace experimental
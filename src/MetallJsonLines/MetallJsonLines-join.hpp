@@ -0,0 +1,318 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "MetallJsonLines-hash.hpp"
+#include "MetallJsonLines-profile.hpp"
+#include "MetallJsonLines-spill.hpp"
+
+/// the hash-owner join engine that is shared by the MetallJsonLines and the
+///   MetallFrame merge. The front ends provide the rows, their key hashes,
+///   and the wire format of the moved rows; the engine stores the key
+///   registries on the hash owners and computes the join candidates.
+/// \details
+///   the algorithm has four phases:
+///   (0) each rank sends (hash, rank, row) of its selected rows to the owner
+///       of the hash (register_row);
+///   (1) the hash owner matches the registries of both sides and sends the
+///       lhs candidates to the owners of the rhs rows (compute_candidates);
+///   (2) the owners of the rhs rows send the rhs rows to the owners of the
+///       lhs rows (for_each_candidates, for_each_lhs_owner);
+///   (3) the owners of the lhs rows compute the joined rows.
+///   The ygm handlers of phases 0 and 1 live in the front ends, because they
+///   must refer to the front end's global hash_join_state.
+namespace experimental {
+
+enum join_side { lhsData = 0, rhsData = 1 };
+
+/// the rows that a join returns
+enum class merge_how : std::uint8_t {
+  inner,  ///< the pairs of matching rows
+  left,   ///< as inner, and the lhs rows without a match
+  right,  ///< as inner, and the rhs rows without a match
+  outer,  ///< as inner, and the rows of both sides without a match
+  semi,   ///< the lhs rows with a match, as selection of the lhs
+  anti    ///< the lhs rows without a match, as selection of the lhs
+};
+
+/// returns the merge_how named \ref name
+inline merge_how to_merge_how(std::string_view name) {
+  if (name == "inner") return merge_how::inner;
+  if (name == "left") return merge_how::left;
+  if (name == "right") return merge_how::right;
+  if (name == "outer") return merge_how::outer;
+  if (name == "semi") return merge_how::semi;
+  if (name == "anti") return merge_how::anti;
+
+  throw std::invalid_argument{"unknown join type: " + std::string(name)};
+}
+
+/// returns true, if the rows of \ref which without a match are returned
+inline bool preserves(merge_how how, join_side which) {
+  return (how == merge_how::outer) ||
+         (how == (which == lhsData ? merge_how::left : merge_how::right));
+}
+
+/// returns true, if the join only selects lhs rows
+inline bool is_semi_join(merge_how how) {
+  return (how == merge_how::semi) || (how == merge_how::anti);
+}
+
+/// the counters of a join's profile (see make_join_profile); all counts are
+///   per rank.
+enum class join_counter : std::size_t {
+  rows_hashed,       ///< selected rows whose join key was hashed
+  rows_filtered,     ///< rows dropped by a semi-join filter
+  messages_sent,     ///< messages to other ranks
+  bytes_sent,        ///< payload bytes of the messages to other ranks
+  bytes_received,    ///< payload bytes of the messages from other ranks
+  index_lhs,         ///< lhs rows registered with this hash owner
+  index_rhs,         ///< rhs rows registered with this hash owner
+  candidate_groups,  ///< candidate groups of rhs rows on this rank
+  candidate_rows,    ///< rhs rows in the candidate groups
+  rows_moved,        ///< rows sent to the joining ranks
+  rows_received,     ///< rows received by the joining ranks
+  result_rows        ///< result rows stored on this rank
+};
+
+/// returns an enabled profile with the join_counter counters
+inline run_profile make_join_profile() {
+  return run_profile{{"rows_hashed", "rows_filtered", "messages_sent",
+                      "bytes_sent", "bytes_received", "index_lhs",
+                      "index_rhs", "candidate_groups", "candidate_rows",
+                      "rows_moved", "rows_received", "result_rows"}};
+}
+
+/// \note a plain struct, so that registries can be spilled as bytes
+struct join_registry {
+  join_registry() = default;
+  join_registry(std::uint64_t h, int rank, int idx)
+      : h(h), rank(rank), idx(idx) {}
+
+  std::uint64_t hash() const { return h; }
+  int           owner_rank() const { return rank; }
+  int           owner_index() const { return idx; }
+
+ private:
+  std::uint64_t h    = 0;
+  int           rank = 0;
+  int           idx  = 0;
+};
+
+struct by_hash_owner {
+  bool operator()(const join_registry& lhs, const join_registry& rhs) const {
+    {
+      const std::uint64_t lskey = lhs.hash();
+      const std::uint64_t rskey = rhs.hash();
+
+      if (lskey < rskey) return true;
+      if (lskey > rskey) return false;
+    }
+
+    {
+      const int lsown = lhs.owner_rank();
+      const int rsown = rhs.owner_rank();
+
+      if (lsown < rsown) return true;
+      if (lsown > rsown) return false;
+    }
+
+    return lhs.owner_index() < rhs.owner_index();
+  }
+};
+
+struct join_info_lhs : std::tuple<int, int> {
+  using base = std::tuple<int, int>;
+  using base::base;
+
+  int owner() const { return std::get<0>(*this); }
+  int index() const { return std::get<1>(*this); }
+};
+
+using join_info_rhs = int;
+
+struct merge_candidates
+    : std::tuple<std::vector<join_info_rhs>, std::vector<join_info_lhs> > {
+  using base =
+      std::tuple<std::vector<join_info_rhs>, std::vector<join_info_lhs> >;
+  using base::base;
+
+  std::vector<join_info_rhs>&       local_data() { return std::get<0>(*this); }
+  const std::vector<join_info_rhs>& local_data() const {
+    return std::get<0>(*this);
+  }
+  std::vector<join_info_lhs>&       remote_data() { return std::get<1>(*this); }
+  const std::vector<join_info_lhs>& remote_data() const {
+    return std::get<1>(*this);
+  }
+};
+
+/// the registries of a side, sorted by hash and owner
+using join_index = external_sorter<join_registry, by_hash_owner>;
+
+/// merge candidates are logged as a header {#rhs, #lhs} followed by the
+///   rhs entries {index, 0} and the lhs entries {owner, index}.
+struct candidate_entry {
+  int first;
+  int second;
+};
+
+using candidate_log = spill_log<candidate_entry>;
+
+/// returns the hash of a join key from the hashes of its columns
+template <class ColumnHashes>
+std::uint64_t join_key_hash(const ColumnHashes& colhashes) {
+  std::uint64_t res{0};
+
+  for (std::uint64_t h : colhashes) res = combine_hash(res, h);
+
+  return res;
+}
+
+/// the per-rank data of the hash-owner join
+struct hash_join_state {
+  join_index    index[2];
+  candidate_log candidates;
+
+  /// the two indices and the candidates share the budget
+  void configure(const spill_options& spill) {
+    index[lhsData].configure(spill.share(3));
+    index[rhsData].configure(spill.share(3));
+    candidates.configure(spill.share(3));
+  }
+
+  /// phase 0: registers row \ref idx on \ref rank with hash \ref h
+  void register_row(join_side which, std::uint64_t h, int rank, int idx) {
+    index[which].emplace_back(h, rank, idx);
+  }
+
+  /// phase 1: stores the candidates received from a hash owner
+  void store_candidates(const std::vector<join_info_rhs>& localInfo,
+                        const std::vector<join_info_lhs>& remoteInfo) {
+    candidates.push_back(
+        candidate_entry{int(localInfo.size()), int(remoteInfo.size())});
+
+    for (int idx : localInfo) candidates.push_back(candidate_entry{idx, 0});
+
+    for (const join_info_lhs& el : remoteInfo)
+      candidates.push_back(candidate_entry{el.owner(), el.index()});
+  }
+
+  void clear() {
+    index[lhsData].clear();
+    index[rhsData].clear();
+    candidates.clear();
+  }
+};
+
+/// returns the owner rank of a hash
+inline int hash_owner(std::uint64_t h, int numranks) { return h % numranks; }
+
+/// phase 1: matches the registries of both sides; calls
+///   send(dest, rhsInfo, lhsInfo) for each owner \ref dest of rhs rows
+///   with the hash of lhs rows. Clears the indices.
+template <class SendFn>
+void compute_candidates(hash_join_state& state, SendFn send) {
+  using registry_iterator = std::vector<join_registry>::const_iterator;
+
+  for_each_matching_group(
+      state.index[lhsData].sorted(), state.index[rhsData].sorted(),
+      [](const join_registry& el) -> std::uint64_t { return el.hash(); },
+      [&send](const std::vector<join_registry>& lhsGroup,
+              const std::vector<join_registry>& rhsGroup) -> void {
+        // pack candidates on left side
+        std::vector<join_info_lhs> lhsInfo;
+
+        std::transform(lhsGroup.begin(), lhsGroup.end(),
+                       std::back_inserter(lhsInfo),
+                       [](const join_registry& el) -> join_info_lhs {
+                         return join_info_lhs{el.owner_rank(),
+                                              el.owner_index()};
+                       });
+
+        // send lhs candidates to all owners of rhs candidates
+        registry_iterator       rsbeg = rhsGroup.begin();
+        const registry_iterator rslim = rhsGroup.end();
+
+        while (rsbeg < rslim) {
+          const int         dest  = rsbeg->owner_rank();
+          registry_iterator rsdst = std::find_if_not(
+              rsbeg + 1, rslim, [dest](const join_registry& rhs) -> bool {
+                return dest == rhs.owner_rank();
+              });
+          std::vector<join_info_rhs> rhsInfo;
+
+          std::transform(rsbeg, rsdst, std::back_inserter(rhsInfo),
+                         [](const join_registry& el) -> join_info_rhs {
+                           return el.owner_index();
+                         });
+
+          send(dest, rhsInfo, lhsInfo);
+          rsbeg = rsdst;
+        }
+      });
+
+  state.index[lhsData].clear();
+  state.index[rhsData].clear();
+}
+
+/// phase 2: calls fn(candidates) for each stored candidate group.
+///   Clears the candidates.
+template <class Fn>
+void for_each_candidates(hash_join_state& state, Fn fn) {
+  merge_candidates      m;
+  candidate_log::reader rd = state.candidates.read();
+
+  while (!rd.done()) {
+    const candidate_entry hdr = rd.front();
+
+    rd.pop();
+    m.local_data().clear();
+    m.remote_data().clear();
+
+    for (int i = 0; i < hdr.first; ++i, rd.pop())
+      m.local_data().push_back(rd.front().first);
+
+    for (int i = 0; i < hdr.second; ++i, rd.pop())
+      m.remote_data().emplace_back(rd.front().first, rd.front().second);
+
+    fn(std::as_const(m));
+  }
+
+  state.candidates.clear();
+}
+
+/// phase 2: calls fn(dest, indices) for each owner \ref dest of the lhs
+///   candidates with the owner's row indices.
+template <class Fn>
+void for_each_lhs_owner(const merge_candidates& m, Fn fn) {
+  using iterator = std::vector<join_info_lhs>::const_iterator;
+
+  iterator       beg = m.remote_data().begin();
+  const iterator lim = m.remote_data().end();
+
+  while (beg != lim) {
+    const int      dest = beg->owner();
+    const iterator nxt =
+        std::find_if(beg, lim, [dest](const join_info_lhs& el) -> bool {
+          return el.owner() != dest;
+        });
+    std::vector<int> indices;
+
+    std::transform(beg, nxt, std::back_inserter(indices),
+                   [](const join_info_lhs& el) -> int { return el.index(); });
+
+    fn(dest, indices);
+    beg = nxt;
+  }
+}
+
+}  // namespace experimental
@@ -0,0 +1,203 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Nearest neighbor search over a numeric array column.
+/// \details
+///   each rank computes the distances of its selected rows to the query
+///   with the kernels of MetallJsonLines-knnindex.hpp, and keeps its k
+///   nearest rows in a bounded heap; rank 0 merges the candidates of all
+///   ranks. With a current IVF index, a rank only visits the rows of the
+///   nprobe lists whose centroids are nearest to the query, which makes the
+///   search approximate. Rows without a numeric array of the query's size
+///   are skipped. Ties are broken by rank and row.
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <cereal/types/vector.hpp>
+
+#include "MetallJsonLines-knnindex.hpp"
+#include "MetallJsonLines.hpp"
+
+namespace experimental {
+
+/// a row and its distance to the query
+struct knn_entry {
+  double             dist = 0;
+  std::uint64_t      rank = 0;
+  std::uint64_t      row  = 0;
+  boost::json::value val;  ///< the (projected) row, once it is sent
+
+  /// returns true, if \ref lhs is nearer than \ref rhs
+  friend bool operator<(const knn_entry& lhs, const knn_entry& rhs) {
+    if (lhs.dist != rhs.dist) return lhs.dist < rhs.dist;
+    if (lhs.rank != rhs.rank) return lhs.rank < rhs.rank;
+
+    return lhs.row < rhs.row;
+  }
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(dist, rank, row, val);
+  }
+};
+
+namespace {
+
+/// the state of a search on each rank, accessed by message handlers
+struct knn_process_data {
+  std::vector<knn_entry>* received = nullptr;  ///< on rank 0
+};
+
+knn_process_data knnState;
+
+void store_knn_entries(const std::vector<knn_entry>& entries) {
+  assert(knnState.received != nullptr);
+
+  knnState.received->insert(knnState.received->end(), entries.begin(),
+                            entries.end());
+}
+
+/// returns the rows of the \ref nprobe lists of \ref idx whose centroids are
+///   nearest to \ref query, in ascending order
+inline std::vector<std::size_t> probed_rows(
+    const metall_json_lines::knn_index_type& idx, const knn_query& query,
+    std::size_t nprobe) {
+  std::vector<std::pair<double, std::size_t>> lists;
+
+  for (std::size_t l = 0; l < idx.size(); ++l)
+    if (std::optional<double> dist = query.distance(idx.centroid(l)))
+      lists.emplace_back(*dist, l);
+
+  nprobe = std::min(nprobe, lists.size());
+  std::partial_sort(lists.begin(), lists.begin() + nprobe, lists.end());
+
+  std::vector<std::size_t> res;
+
+  for (std::size_t i = 0; i < nprobe; ++i) {
+    const auto& rows = idx.rows(lists[i].second);
+
+    res.insert(res.end(), rows.begin(), rows.end());
+  }
+
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+}  // namespace
+
+/// returns the \ref k selected rows of \ref lines whose arrays \ref column
+///   are nearest to \ref query on rank 0 (empty on the other ranks), as
+///   objects with the distance and the projected row.
+/// \param nprobe the number of lists of an IVF index that are visited;
+///        0 scans all selected rows, also when the column has an index.
+/// \details
+///   the distance is Euclidean (l2), the negated inner product, or
+///   1 - the cosine similarity; smaller is nearer. Collective.
+inline boost::json::array nearest_rows(
+    const metall_json_lines& lines, std::string_view column,
+    const knn_query& query, std::size_t k, std::size_t nprobe,
+    metall_json_lines::metall_projector_type projector) {
+  ygm::comm&             world = lines.comm();
+  std::vector<knn_entry> received;
+
+  if (query.values.empty())
+    throw std::invalid_argument{"knn needs a query vector"};
+
+  const metall_json_lines::knn_index_type* idx =
+      (nprobe > 0) ? lines.find_knn_index(column) : nullptr;
+
+  if (idx && (idx->dimension() != query.values.size())) idx = nullptr;
+
+  knnState = knn_process_data{&received};
+  world.cf_barrier();
+
+  if (k > 0) {
+    // the top of the heap is the farthest of the candidates
+    std::priority_queue<knn_entry> heap;
+    std::vector<double>            vec;
+    const std::uint64_t            rank = world.rank();
+
+    auto visit = [&](std::size_t                             row,
+                     const metall_json_lines::accessor_type& val) -> void {
+      if (!numeric_array_of(val, column, vec) ||
+          (vec.size() != query.values.size()))
+        return;
+
+      const std::optional<double> dist = query.distance(vec.data());
+
+      if (!dist) return;
+
+      knn_entry entry{*dist, rank, row, nullptr};
+
+      if (heap.size() == k) {
+        if (!(entry < heap.top())) return;
+
+        heap.pop();
+      }
+
+      heap.push(std::move(entry));
+    };
+
+    if (idx)
+      lines.for_all_selected_candidates(visit,
+                                        probed_rows(*idx, query, nprobe));
+    else
+      lines.for_all_selected(visit);
+
+    // only the candidates are projected and sent
+    std::vector<knn_entry> candidates;
+
+    candidates.reserve(heap.size());
+    for (; !heap.empty(); heap.pop()) {
+      knn_entry entry = heap.top();
+
+      entry.val = projector(lines.at(entry.row));
+      candidates.push_back(std::move(entry));
+    }
+
+    if (world.rank() == 0)
+      store_knn_entries(candidates);
+    else if (candidates.size())
+      world.async(
+          0,
+          [](const std::vector<knn_entry>& entries) -> void {
+            store_knn_entries(entries);
+          },
+          candidates);
+  }
+
+  world.barrier();
+  knnState = knn_process_data{};
+
+  std::sort(received.begin(), received.end());
+
+  if (received.size() > k) received.resize(k);
+
+  boost::json::array res;
+
+  for (knn_entry& entry : received) {
+    boost::json::object obj;
+
+    obj["distance"] = query.reported_distance(entry.dist);
+    obj["row"]      = std::move(entry.val);
+    res.emplace_back(std::move(obj));
+  }
+
+  return res;
+}
+
+}  // namespace experimental
@@ -0,0 +1,333 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Distance kernels over numeric array columns, and the persistent
+///        coarse (IVF) indices of the nearest neighbor search.
+/// \details
+///   a vector is a row's array of numbers, which is copied as doubles
+///   (packed arrays are decoded at once). The kernels keep KNN_LANES
+///   independent partial sums, so that the compiler vectorizes them
+///   without intrinsics.
+///   An IVF index partitions the vectors of a column by their nearest
+///   centroid (k-means over all ranks); each rank stores the centroids and
+///   the inverted list of its rows per centroid. A search then only visits
+///   the rows of the lists whose centroids are nearest to the query.
+///   Appends (e.g., read_json) extend the lists; other modifications make
+///   the index stale until it is created again.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+#include "MetallJsonLines-index.hpp"
+
+namespace experimental {
+
+/// the distance of the nearest neighbor search
+enum class knn_metric : std::uint8_t {
+  l2,             ///< Euclidean distance
+  inner_product,  ///< the negated inner product
+  cosine          ///< 1 - the cosine similarity
+};
+
+/// returns the knn_metric named \ref name
+inline knn_metric to_knn_metric(std::string_view name) {
+  if (name == "l2") return knn_metric::l2;
+  if (name == "inner_product") return knn_metric::inner_product;
+  if (name == "cosine") return knn_metric::cosine;
+
+  throw std::invalid_argument{"unknown metric: " + std::string(name)};
+}
+
+/// the number of independent partial sums of the distance kernels
+static constexpr std::size_t KNN_LANES = 8;
+
+/// returns the inner product of the \ref n values at \ref x and \ref y
+inline double dot_product(const double* x, const double* y, std::size_t n) {
+  double      part[KNN_LANES] = {};
+  std::size_t i               = 0;
+
+  for (; i + KNN_LANES <= n; i += KNN_LANES)
+    for (std::size_t j = 0; j < KNN_LANES; ++j) part[j] += x[i + j] * y[i + j];
+
+  double res = 0;
+
+  for (; i < n; ++i) res += x[i] * y[i];
+  for (std::size_t j = 0; j < KNN_LANES; ++j) res += part[j];
+
+  return res;
+}
+
+/// returns the squared Euclidean distance of \ref x and \ref y
+inline double squared_l2(const double* x, const double* y, std::size_t n) {
+  double      part[KNN_LANES] = {};
+  std::size_t i               = 0;
+
+  for (; i + KNN_LANES <= n; i += KNN_LANES)
+    for (std::size_t j = 0; j < KNN_LANES; ++j) {
+      const double diff = x[i + j] - y[i + j];
+
+      part[j] += diff * diff;
+    }
+
+  double res = 0;
+
+  for (; i < n; ++i) res += (x[i] - y[i]) * (x[i] - y[i]);
+  for (std::size_t j = 0; j < KNN_LANES; ++j) res += part[j];
+
+  return res;
+}
+
+/// computes the inner product of \ref x and \ref y and the squared norm of
+///   \ref x in one pass
+inline void dot_and_norm(const double* x, const double* y, std::size_t n,
+                         double& dot, double& norm) {
+  double      dots[KNN_LANES]  = {};
+  double      norms[KNN_LANES] = {};
+  std::size_t i                = 0;
+
+  for (; i + KNN_LANES <= n; i += KNN_LANES)
+    for (std::size_t j = 0; j < KNN_LANES; ++j) {
+      dots[j] += x[i + j] * y[i + j];
+      norms[j] += x[i + j] * x[i + j];
+    }
+
+  dot  = 0;
+  norm = 0;
+
+  for (; i < n; ++i) {
+    dot += x[i] * y[i];
+    norm += x[i] * x[i];
+  }
+
+  for (std::size_t j = 0; j < KNN_LANES; ++j) {
+    dot += dots[j];
+    norm += norms[j];
+  }
+}
+
+/// returns the nearest of the \ref k centroids of \ref dims values at
+///   \ref centroids to \ref vec (Euclidean distance)
+inline std::size_t nearest_centroid(const double* vec, const double* centroids,
+                                    std::size_t k, std::size_t dims) {
+  std::size_t res  = 0;
+  double      best = std::numeric_limits<double>::infinity();
+
+  for (std::size_t l = 0; l < k; ++l) {
+    const double dist = squared_l2(vec, centroids + l * dims, dims);
+
+    if (dist < best) {
+      best = dist;
+      res  = l;
+    }
+  }
+
+  return res;
+}
+
+/// a query vector and its norm
+struct knn_query {
+  std::vector<double> values;
+  knn_metric          metric = knn_metric::l2;
+  double              norm   = 0;  ///< the Euclidean norm of values
+
+  knn_query(std::vector<double> vals, knn_metric m)
+      : values(std::move(vals)),
+        metric(m),
+        norm(std::sqrt(dot_product(values.data(), values.data(),
+                                   values.size()))) {}
+
+  /// returns the distance of the query to \ref x, which has as many values,
+  ///   or nullopt if the cosine is undefined. Smaller is nearer; for l2,
+  ///   the squared distance (see reported_distance).
+  std::optional<double> distance(const double* x) const {
+    const std::size_t n = values.size();
+
+    switch (metric) {
+      case knn_metric::l2: return squared_l2(x, values.data(), n);
+      case knn_metric::inner_product: return -dot_product(x, values.data(), n);
+      case knn_metric::cosine: {
+        double dot  = 0;
+        double sqnm = 0;
+
+        dot_and_norm(x, values.data(), n, dot, sqnm);
+
+        if ((sqnm == 0) || (norm == 0)) return std::nullopt;
+
+        return 1.0 - dot / (std::sqrt(sqnm) * norm);
+      }
+    }
+
+    return std::nullopt;
+  }
+
+  /// returns the distance that is reported for \ref dist
+  double reported_distance(double dist) const {
+    return (metric == knn_metric::l2) ? std::sqrt(dist) : dist;
+  }
+};
+
+/// copies the numeric array \ref column of \ref row into \ref out
+/// \return false, if the row has no such column, or if it is not an array
+///         of numbers
+template <class Accessor>
+bool numeric_array_of(const Accessor& row, std::string_view column,
+                      std::vector<double>& out) {
+  if (!row.is_object()) return false;
+
+  const auto obj = row.as_object();
+  const auto fld = obj.if_contains(column);
+
+  if (!fld || !fld->is_array()) return false;
+
+  return fld->as_array().copy_numbers(out);
+}
+
+/// the persistent IVF indices of a rank, keyed by column;
+///   stored next to the local container in the same Metall datastore.
+template <class Alloc>
+class knn_index_cache {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+  using real_vector =
+      metall::container::vector<double, other_allocator<double>>;
+
+ public:
+  using row_vector =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+
+ private:
+  using list_vector =
+      metall::container::vector<row_vector, other_allocator<row_vector>>;
+
+ public:
+  /// the centroids and inverted lists of one column
+  class index {
+   public:
+    index(std::string_view col, const allocator_type& alloc)
+        : column(col.data(), col.size(), alloc),
+          centroidValues(alloc),
+          lists(alloc) {}
+
+    /// the indexed column
+    std::string_view name() const { return {column.data(), column.size()}; }
+
+    /// returns true, if the lists have the rows in state \ref st
+    bool current(const sorted_index_stamp& st) const { return stamp == st; }
+
+    /// marks the lists as complete in state \ref st
+    void set_state(const sorted_index_stamp& st) { stamp = st; }
+
+    /// returns the number of values of the indexed vectors
+    std::size_t dimension() const { return dims; }
+
+    /// returns the number of inverted lists
+    std::size_t size() const { return lists.size(); }
+
+    /// returns the centroid of list \ref l
+    const double* centroid(std::size_t l) const {
+      return centroidValues.data() + l * dims;
+    }
+
+    /// returns the rows of list \ref l, in ascending order
+    const row_vector& rows(std::size_t l) const { return lists[l]; }
+
+    /// replaces the centroids by the \ref dimension values of each of
+    ///   \ref centroids, and empties the lists
+    void assign(const std::vector<double>& centroids, std::size_t dimension) {
+      dims = dimension;
+      centroidValues.assign(centroids.begin(), centroids.end());
+      lists.clear();
+
+      for (std::size_t l = 0; l < centroids.size() / dims; ++l)
+        lists.emplace_back(lists.get_allocator());
+
+      stamp = {};
+    }
+
+    /// returns the list whose centroid is nearest to \ref vec
+    std::size_t nearest_list(const double* vec) const {
+      return nearest_centroid(vec, centroidValues.data(), size(), dims);
+    }
+
+    /// adds the rows from \ref first of \ref vector that have a vector of
+    ///   the index's dimension
+    template <class Lines>
+    void extend(const Lines& vector, std::size_t first) {
+      std::vector<double> vec;
+
+      for (std::size_t i = first; i < vector.size(); ++i)
+        if (numeric_array_of(vector.at(i), name(), vec) && (vec.size() == dims))
+          lists[nearest_list(vec.data())].push_back(i);
+    }
+
+   private:
+    string_type        column;
+    std::uint64_t      dims = 0;
+    real_vector        centroidValues;  ///< list * dims + value
+    list_vector        lists;           ///< list -> rows
+    sorted_index_stamp stamp;
+  };
+
+  explicit knn_index_cache(const allocator_type& alloc) : entries(alloc) {}
+
+  /// returns the index of \ref column, or nullptr
+  const index* find(std::string_view column) const {
+    for (const index& el : entries)
+      if (el.name() == column) return &el;
+
+    return nullptr;
+  }
+
+  /// returns the index of \ref column; adds an empty one if none exists
+  index& find_or_add(std::string_view column) {
+    for (index& el : entries)
+      if (el.name() == column) return el;
+
+    entries.emplace_back(column, entries.get_allocator());
+    return entries.back();
+  }
+
+  /// calls \ref fn with each index
+  template <class Fn>
+  void for_all_indices(Fn fn) {
+    for (index& el : entries) fn(el);
+  }
+
+  /// returns the indexed columns
+  std::vector<std::string> columns() const {
+    std::vector<std::string> res;
+
+    for (const index& el : entries) res.emplace_back(el.name());
+
+    return res;
+  }
+
+ private:
+  metall::container::vector<index, other_allocator<index>> entries;
+};
+
+}  // namespace experimental
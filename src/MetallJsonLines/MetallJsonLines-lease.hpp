@@ -0,0 +1,283 @@
+#pragma once
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <mpi.h>
+
+#include <metall/utility/metall_mpi_adaptor.hpp>
+
+/// shared serving of a datastore: many jobs read the latest published
+///   version of the datastore, while one writer at a time modifies the
+///   datastore itself and publishes a new version when it closes it.
+/// \details
+///   the published versions are snapshots next to the datastore
+///   (<loc>.published-<n>), and <loc>.published has the number of the
+///   latest one. A reader holds a lease on the version that it maps, a file
+///   in <version>.leases; a version that is no longer the latest is removed
+///   by the next publish after its last reader has released its lease. A
+///   writer holds <loc>.writer. The lease files are created and removed by
+///   rank 0 of a job, with O_EXCL, which is atomic also on NFS and Lustre;
+///   unlike flock, they do not depend on the lock support of the file
+///   system.
+///   A job that ends abnormally leaves its lease behind: a stale reader
+///   lease keeps its version, and a stale writer lease needs to be removed
+///   before the datastore can be written again.
+namespace experimental {
+
+namespace {
+/// returns \ref loc without trailing slashes
+inline std::string shared_base(std::string_view loc) {
+  std::string res{loc};
+
+  while ((res.size() > 1) && (res.back() == '/')) res.pop_back();
+
+  return res;
+}
+
+/// returns the file that has the number of the latest published version
+inline std::string published_pointer(std::string_view loc) {
+  return shared_base(loc) + ".published";
+}
+
+/// returns the location of the published version \ref n
+inline std::string published_location(std::string_view loc, std::uint64_t n) {
+  return shared_base(loc) + ".published-" + std::to_string(n);
+}
+
+/// returns the directory of the reader leases of version \ref n
+inline std::string published_leases(std::string_view loc, std::uint64_t n) {
+  return published_location(loc, n) + ".leases";
+}
+
+/// returns the number of the latest published version, or 0 if the
+///   datastore is not shared
+inline std::uint64_t latest_published(std::string_view loc) {
+  std::ifstream pointer{published_pointer(loc)};
+  std::uint64_t n = 0;
+
+  if (!(pointer >> n)) return 0;
+
+  return n;
+}
+
+/// identifies the job that holds a lease; unique within a job, as a job may
+///   open a datastore more than once
+inline std::string lease_holder() {
+  static std::uint64_t counter = 0;
+  char                 host[256] = {};
+
+  ::gethostname(host, sizeof(host) - 1);
+  return std::string(host) + "." + std::to_string(::getpid()) + "." +
+         std::to_string(counter++);
+}
+
+/// creates the lease file \ref path exclusively; returns errno on failure
+inline int create_lease(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_CREAT | O_EXCL | O_WRONLY, 0644);
+
+  if (fd < 0) return errno;
+
+  const std::string holder = lease_holder();
+
+  ::write(fd, holder.data(), holder.size());
+  ::close(fd);
+  return 0;
+}
+
+/// broadcasts \ref val from rank 0. Collective.
+inline void broadcast_lease(std::uint64_t& val) {
+  MPI_Bcast(&val, 1, MPI_UINT64_T, 0, MPI_COMM_WORLD);
+}
+
+inline bool lease_root() {
+  int rank = 0;
+
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+  return rank == 0;
+}
+}  // namespace
+
+/// a reader's lease on the latest published version of a datastore
+class reader_lease {
+ public:
+  /// leases the latest published version of the datastore at \ref loc,
+  ///   unless it is not shared. Collective.
+  explicit reader_lease(std::string_view loc) : base(shared_base(loc)) {
+    if (lease_root()) {
+      // the version may be removed between reading the pointer and
+      //   creating the lease, then its lease directory is gone.
+      for (int attempt = 0; attempt < ATTEMPTS; ++attempt) {
+        version = latest_published(base);
+
+        if (version == 0) break;
+
+        path = published_leases(base, version) + "/" + lease_holder();
+
+        if (create_lease(path) == 0) break;
+
+        version = FAILED;
+      }
+    }
+
+    broadcast_lease(version);
+
+    if (version == FAILED)
+      throw std::runtime_error{"unable to lease a published version of " +
+                               base};
+  }
+
+  /// releases the lease
+  ~reader_lease() {
+    if (shared() && !path.empty()) ::unlink(path.c_str());
+  }
+
+  reader_lease(const reader_lease&)            = delete;
+  reader_lease& operator=(const reader_lease&) = delete;
+
+  /// returns true, if the datastore is shared
+  bool shared() const { return version != 0; }
+
+  /// returns the location of the leased version
+  std::string location() const { return published_location(base, version); }
+
+ private:
+  static constexpr int           ATTEMPTS = 16;
+  static constexpr std::uint64_t FAILED   = ~std::uint64_t(0);
+
+  std::string   base;
+  std::string   path;         ///< the lease file (rank 0)
+  std::uint64_t version = 0;  ///< 0, if the datastore is not shared
+};
+
+/// the writer's lease on a shared datastore: at most one job modifies a
+///   shared datastore; readers of the published versions are not affected.
+class writer_lease {
+ public:
+  /// leases the datastore at \ref loc for writing, if it is shared; throws
+  ///   if another job holds the lease. Collective.
+  explicit writer_lease(std::string_view loc) : base(shared_base(loc)) {
+    std::uint64_t state = UNSHARED;
+
+    if (lease_root() && (latest_published(base) != 0))
+      state = (create_lease(path()) == 0) ? LEASED : BUSY;
+
+    broadcast_lease(state);
+
+    if (state == BUSY)
+      throw std::runtime_error{"the datastore is being written by another "
+                               "job; remove " +
+                               path() + " if that job has ended"};
+
+    leased = (state == LEASED);
+  }
+
+  /// releases the lease
+  ~writer_lease() {
+    if (leased && lease_root()) ::unlink(path().c_str());
+  }
+
+  writer_lease(const writer_lease&)            = delete;
+  writer_lease& operator=(const writer_lease&) = delete;
+
+  /// returns true, if the datastore is shared
+  bool shared() const { return leased; }
+
+  /// publishes the datastore of \ref mgr as the next version, and removes
+  ///   the previous versions that have no readers. Collective.
+  void publish(metall::utility::metall_mpi_adaptor& mgr) {
+    std::uint64_t next = 0;
+
+    if (lease_root()) next = latest_published(base) + 1;
+
+    broadcast_lease(next);
+    publish_version(mgr, base, next);
+  }
+
+  /// publishes the first version of the datastore of \ref mgr at \ref loc,
+  ///   which makes the datastore shared; returns false if it is shared
+  ///   already. Collective.
+  static bool share(metall::utility::metall_mpi_adaptor& mgr,
+                    std::string_view                     loc) {
+    std::uint64_t shared = 0;
+
+    if (lease_root()) shared = latest_published(loc);
+
+    broadcast_lease(shared);
+
+    if (shared != 0) return false;
+
+    publish_version(mgr, shared_base(loc), 1);
+    return true;
+  }
+
+ private:
+  enum : std::uint64_t { UNSHARED, LEASED, BUSY };
+
+  std::string path() const { return base + ".writer"; }
+
+  /// snapshots the datastore as version \ref n, which replaces the latest.
+  static void publish_version(metall::utility::metall_mpi_adaptor& mgr,
+                              const std::string& base, std::uint64_t n) {
+    const std::string dest = published_location(base, n);
+
+    // the snapshot consists of the datastore's files after a flush
+    if (!mgr.snapshot(dest.c_str()))
+      throw std::runtime_error{"unable to publish " + dest};
+
+    MPI_Barrier(MPI_COMM_WORLD);
+
+    if (!lease_root()) return;
+
+    const std::string pointer = published_pointer(base);
+    const std::string staged  = pointer + ".tmp";
+
+    std::filesystem::create_directory(published_leases(base, n));
+    std::ofstream{staged} << n << std::endl;
+
+    // readers see the old or the new pointer, never a partial one
+    std::filesystem::rename(staged, pointer);
+
+    const std::filesystem::path store{base};
+    const std::filesystem::path dir =
+        store.has_parent_path() ? store.parent_path() : ".";
+    const std::string prefix = store.filename().string() + ".published-";
+
+    for (const auto& entry : std::filesystem::directory_iterator(dir)) {
+      const std::string name = entry.path().filename().string();
+
+      if ((name.size() <= prefix.size()) || (name.rfind(prefix, 0) != 0))
+        continue;
+
+      const std::string suffix = name.substr(prefix.size());
+
+      if (suffix.find_first_not_of("0123456789") != std::string::npos)
+        continue;
+
+      const std::uint64_t old = std::stoull(suffix);
+
+      // removing the empty lease directory is atomic: afterwards, no
+      //   reader can lease the version.
+      if ((old >= n) || (::rmdir(published_leases(base, old).c_str()) != 0))
+        continue;
+
+      std::error_code ec;
+
+      std::filesystem::remove_all(entry.path(), ec);
+    }
+  }
+
+  std::string base;
+  bool        leased = false;
+};
+
+}  // namespace experimental
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+#include "MetallJsonLines-hash.hpp"
+
+namespace experimental {
+
+/// identifies the contents of an input file
+struct file_fingerprint {
+  std::uint64_t size  = 0;
+  std::int64_t  mtime = 0;  ///< last write time (file clock ticks)
+  std::uint64_t hash  = 0;  ///< hash of the file's head and tail
+
+  /// number of bytes at the beginning and at the end of a file
+  ///   that are hashed.
+  static constexpr std::size_t sample_bytes = 1024 * 1024;
+
+  /// computes the fingerprint of the file at \ref path
+  /// \details
+  ///   hashing the full contents would read every file once more than
+  ///   the import; thus the hash combines the size with the first and last
+  ///   sample_bytes bytes, which distinguishes appended-to or rewritten
+  ///   dumps in practice.
+  static file_fingerprint of(const std::string& path) {
+    namespace fs = std::filesystem;
+
+    file_fingerprint res;
+
+    res.size  = fs::file_size(path);
+    res.mtime = fs::last_write_time(path).time_since_epoch().count();
+    res.hash  = stable_hash_distribute(res.size);
+
+    std::ifstream     ifs(path, std::ios::binary);
+    std::vector<char> buf(std::min<std::uint64_t>(sample_bytes, res.size));
+
+    auto hashChunk = [&ifs, &buf, &res](std::uint64_t pos) -> void {
+      ifs.seekg(pos);
+      ifs.read(buf.data(), buf.size());
+
+      const std::string_view chunk(buf.data(), ifs.gcount());
+
+      res.hash = stable_hash_combine(res.hash,
+                                     std::hash<std::string_view>{}(chunk));
+    };
+
+    hashChunk(0);
+    if (res.size > buf.size()) hashChunk(res.size - buf.size());
+
+    return res;
+  }
+};
+
+/// persistent record of the files that were imported into a local container.
+///   one manifest is stored next to each local container in the same Metall
+///   datastore; all ranks record the same files, each with the range of rows
+///   that the rank imported from the file.
+/// \details
+///   a file is considered ingested if a file with the same size and content
+///   hash was imported earlier, regardless of its path and mtime.
+///   Row ranges refer to the rows at import time; operations that remove
+///   or move rows (e.g., rebalance) do not update them.
+template <class Alloc>
+class ingest_manifest {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+
+ public:
+  explicit ingest_manifest(const allocator_type& alloc) : entries(alloc) {}
+
+  /// returns true, if a file with the same contents was recorded
+  bool contains(const file_fingerprint& fp) const {
+    for (const entry& el : entries)
+      if (el.size == fp.size && el.hash == fp.hash) return true;
+
+    return false;
+  }
+
+  /// records that rows [firstrow, firstrow + numrows) were imported from
+  ///   the file at \ref path.
+  void record(std::string_view path, const file_fingerprint& fp,
+              std::uint64_t firstrow, std::uint64_t numrows) {
+    entries.emplace_back(path, entries.get_allocator());
+
+    entry& el   = entries.back();
+    el.size     = fp.size;
+    el.mtime    = fp.mtime;
+    el.hash     = fp.hash;
+    el.firstrow = firstrow;
+    el.numrows  = numrows;
+  }
+
+  /// forgets all files
+  void clear() { entries.clear(); }
+
+  /// returns the number of recorded files
+  std::size_t size() const { return entries.size(); }
+
+  /// returns the recorded files as JSON array of objects
+  boost::json::array as_json() const {
+    boost::json::array res;
+
+    for (const entry& el : entries) {
+      boost::json::object obj;
+
+      obj["path"]     = std::string_view(el.path.data(), el.path.size());
+      obj["size"]     = el.size;
+      obj["mtime"]    = el.mtime;
+      obj["hash"]     = el.hash;
+      obj["firstrow"] = el.firstrow;
+      obj["numrows"]  = el.numrows;
+
+      res.emplace_back(std::move(obj));
+    }
+
+    return res;
+  }
+
+ private:
+  struct entry {
+    entry(std::string_view p, const allocator_type& alloc)
+        : path(p.data(), p.size(), alloc) {}
+
+    string_type   path;
+    std::uint64_t size     = 0;
+    std::int64_t  mtime    = 0;
+    std::uint64_t hash     = 0;
+    std::uint64_t firstrow = 0;
+    std::uint64_t numrows  = 0;
+  };
+
+  metall::container::vector<entry, other_allocator<entry>> entries;
+};
+
+}  // namespace experimental
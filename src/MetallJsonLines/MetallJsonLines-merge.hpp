@@ -1,12 +1,21 @@
 #pragma once
 
-#include <chrono>
+#include <cmath>
+#include <numeric>
 #include <ranges>
+#include <stdexcept>
+#include <string_view>
 
 #include <boost/functional/hash.hpp>
 #include <boost/json.hpp>
 // #include <metall/json/parse.hpp>
 
+#include "MetallJsonLines-batch.hpp"
+#include "MetallJsonLines-bloom.hpp"
+#include "MetallJsonLines-job.hpp"
+#include "MetallJsonLines-join.hpp"
+#include "MetallJsonLines-profile.hpp"
+#include "MetallJsonLines-spill.hpp"
 #include "MetallJsonLines.hpp"
 
 // sorry, for introducing this in a header file, which should really be a C
@@ -16,13 +25,9 @@ namespace mtljsn = metall::json;
 namespace xpr    = experimental;
 
 // switch debug output
-static constexpr bool DEBUG_TIME_MERGE       = false;
 static constexpr bool DEBUG_TRACE_MERGE      = false;
 static constexpr bool DEBUG_MERGE_DATA       = false;
 
-// use boost or alternative hash combine
-static constexpr bool USE_BOOST_HASH_COMBINE = true;
-
 template <bool On>
 struct merge_data_tracer_t
 {
@@ -138,215 +143,108 @@ T valueAt(bj::object& value, const argts&... keys) try {
   return T();
 }
 
-//
-// alternative hash_combine: https://stackoverflow.com/a/50978188
-
-inline
-std::uint64_t xor_shift(std::uint64_t n, int i) { return n ^ (n >> i); }
-
-// a hash function with another name as to not confuse with std::hash
-inline
-std::uint64_t stable_hash_distribute(std::uint64_t n) {
-  std::uint64_t p = 0x5555555555555555ull;    // pattern of alternating 0 and 1
-  std::uint64_t c = 17316035218449499591ull;  // random uneven integer constant;
-  return c * xor_shift(p * xor_shift(n, 32), 32);
-}
-
-inline
-std::uint64_t stable_hash_combine(std::uint64_t seed, std::uint64_t comp) {
-  const std::uint64_t distr = stable_hash_distribute(comp);
-
-  return std::rotl(seed, std::numeric_limits<std::uint64_t>::digits/3) ^ distr;
-}
-
-std::uint64_t combine_hash(std::uint64_t lhs, std::uint64_t rhs) {
-  if (!USE_BOOST_HASH_COMBINE)
-    return stable_hash_combine(lhs, rhs);
-
-  boost::hash_combine(lhs, rhs);
-  return lhs;
-}
-
-
-template <typename MetallJsonAccessor>
-std::int64_t json_hash_code(const MetallJsonAccessor& val) {
-  if (val.is_null()) return std::hash<nullptr_t>{}(nullptr);
-  if (val.is_bool()) return std::hash<bool>{}(val.as_bool());
-  if (val.is_int64()) return std::hash<std::int64_t>{}(val.as_int64());
-  if (val.is_uint64()) return std::hash<std::uint64_t>{}(val.as_uint64());
-  if (val.is_double()) return std::hash<double>{}(val.as_double());
-
-  if (val.is_string()) {
-    const auto& str = val.as_string();
-
-    return std::hash<std::string_view>{}(std::string_view(str));
-  }
-
-  if (val.is_object()) {
-    const auto& obj = val.as_object();
-
-    std::int64_t res{0};
-
-    for (const auto& el : obj) {
-      res = combine_hash(res, std::hash<std::string_view>{}(el.key()));
-      res = combine_hash(res, json_hash_code(el.value()));
-    }
-
-    return res;
-  }
-
-  assert(val.is_array());
-  std::int64_t res{0};
-
-  // \todo should an element's position be taken into account for the computed
-  // hash value?
-  for (const auto& el : val.as_array())
-    res = combine_hash(res, json_hash_code(el));
-
-  return res;
-}
-
 /// define data held locally
 
-enum join_side { lhsData = 0, rhsData = 1 };
-
-struct join_registry : std::tuple<std::uint64_t, int, int> {
-  using base = std::tuple<std::uint64_t, int, int>;
+using experimental::join_side;
+using experimental::lhsData;
+using experimental::rhsData;
+using experimental::join_info_lhs;
+using experimental::join_info_rhs;
+using experimental::merge_candidates;
+
+/// lhs rows and the rhs rows that may join them; if the rhs rows are
+///   preserved by an outer join, the owner and the indices of the rhs rows.
+struct join_data
+    : std::tuple<std::vector<int>, xpr::column_batch, int, std::vector<int> > {
+  using base =
+      std::tuple<std::vector<int>, xpr::column_batch, int, std::vector<int> >;
   using base::base;
 
-  std::uint64_t hash() const { return std::get<0>(*this); }
-  int           owner_rank() const { return std::get<1>(*this); }
-  int           owner_index() const { return std::get<2>(*this); }
+  std::vector<int>&        indices() { return std::get<0>(*this); }
+  const std::vector<int>&  indices() const { return std::get<0>(*this); }
+  xpr::column_batch&       data() { return std::get<1>(*this); }
+  const xpr::column_batch& data() const { return std::get<1>(*this); }
+  int                      source() const { return std::get<2>(*this); }
+  const std::vector<int>&  source_indices() const { return std::get<3>(*this); }
 };
 
-struct by_hash_owner {
-  bool operator()(const join_registry& lhs, const join_registry& rhs) const {
-    {
-      const std::uint64_t lskey = lhs.hash();
-      const std::uint64_t rskey = rhs.hash();
-
-      if (lskey < rskey) return true;
-      if (lskey > rskey) return false;
-    }
-
-    {
-      const int lsown = lhs.owner_rank();
-      const int rsown = rhs.owner_rank();
-
-      if (lsown < rsown) return true;
-      if (lsown > rsown) return false;
-    }
-
-    return lhs.owner_index() < rhs.owner_index();
-  }
-};
+struct global_process_data {
+  xpr::hash_join_state   join;
+  std::vector<join_data> joinData;
 
-struct same_hash_key {
-  bool operator()(const join_registry& rhs) const { return h == rhs.hash(); }
+  /// rhs rows that joined a lhs row (only for outer joins preserving rhs)
+  std::vector<bool> rhsMatched;
 
-  const std::uint64_t h;
+  /// the profile of the running merge; disabled outside of a merge
+  xpr::run_profile  noProfile;
+  xpr::run_profile* profile = &noProfile;
 };
 
-struct join_info_lhs : std::tuple<int, int> {
-  using base = std::tuple<int, int>;
-  using base::base;
+global_process_data local;  // global allocation!
 
-  int owner() const { return std::get<0>(*this); }
-  int index() const { return std::get<1>(*this); }
-};
+using xpr::join_counter;
 
-using join_info_rhs = int;
+/// counts a message to another rank in the profile of the running merge
+template <class... Args>
+void count_sent(const Args&... args) {
+  local.profile->count(join_counter::messages_sent);
+  local.profile->count(join_counter::bytes_sent, xpr::message_size(args...));
+}
 
-struct merge_candidates
-    : std::tuple<std::vector<join_info_rhs>, std::vector<join_info_lhs> > {
-  using base =
-      std::tuple<std::vector<join_info_rhs>, std::vector<join_info_lhs> >;
-  using base::base;
+/// counts a message from another rank in the profile of the running merge
+template <class... Args>
+void count_received(const Args&... args) {
+  local.profile->count(join_counter::bytes_received,
+                       xpr::message_size(args...));
+}
 
-  std::vector<join_info_rhs>&       local_data() { return std::get<0>(*this); }
-  const std::vector<join_info_rhs>& local_data() const {
-    return std::get<0>(*this);
-  }
-  std::vector<join_info_lhs>&       remote_data() { return std::get<1>(*this); }
-  const std::vector<join_info_lhs>& remote_data() const {
-    return std::get<1>(*this);
+/// makes \ref profile the profile of the running merge
+struct profile_scope {
+  explicit profile_scope(xpr::run_profile* profile) {
+    local.profile = profile ? profile : &local.noProfile;
   }
-};
-
-struct join_data : std::tuple<std::vector<int>, bj::array> {
-  using base = std::tuple<std::vector<int>, bj::array>;
-  using base::base;
-
-  std::vector<int>&       indices() { return std::get<0>(*this); }
-  const std::vector<int>& indices() const { return std::get<0>(*this); }
-  bj::array&              data() { return std::get<1>(*this); }
-  const bj::array&        data() const { return std::get<1>(*this); }
-};
 
-using join_index = std::vector<join_registry>;
+  ~profile_scope() { local.profile = &local.noProfile; }
 
-struct global_process_data {
-  std::vector<merge_candidates> mergeCandidates;
-  std::vector<join_data>        joinData;
-  join_index                    joinIndex[2];
+  profile_scope(const profile_scope&)            = delete;
+  profile_scope& operator=(const profile_scope&) = delete;
 };
 
-global_process_data local;  // global allocation!
-
 ///
 void store_elem(join_side which, std::uint64_t h, int rank, int idx) {
-  local.joinIndex[which].emplace_back(h, rank, idx);
+  local.join.register_row(which, h, rank, idx);
 
-  if (DEBUG_TRACE_MERGE && ((local.joinIndex[which].size() % (1 << 12)) == 0)) {
+  if (DEBUG_TRACE_MERGE && ((local.join.index[which].size() % (1 << 12)) == 0)) {
     simple_logger{}
             << "store_elem: @" << which << " - "
-            << local.joinIndex[which].size() << "  from: " << rank << '.'
+            << local.join.index[which].size() << "  from: " << rank << '.'
             << idx << '\n';
   }
 }
 
 void comm_join_hash(ygm::comm& w, join_side which, std::uint64_t h, int idx) {
   const int rank = w.rank();
-  const int dest = h % w.size();
+  const int dest = xpr::hash_owner(h, w.size());
 
   if (w.rank() == dest) {
     store_elem(which, h, rank, idx);
     return;
   }
 
+  count_sent(which, h, rank, idx);
   w.async(
       dest,
       [](join_side operand, std::uint64_t hash, int owner_rank, int owner_idx)
-          -> void { store_elem(operand, hash, owner_rank, owner_idx); },
+          -> void {
+        count_received(operand, hash, owner_rank, owner_idx);
+        store_elem(operand, hash, owner_rank, owner_idx);
+      },
       which, h, rank, idx);
 }
 
-template <class PackerFn>
-auto pack_join_info(join_index::const_iterator beg, join_index::const_iterator lim,
-                    PackerFn fn) -> std::vector<decltype(fn(*beg))> {
-  std::vector<decltype(fn(*beg))> res;
-
-  std::transform(beg, lim, std::back_inserter(res), fn);
-  return res;
-}
-
-std::vector<join_info_lhs> pack_join_info_lhs(join_index::const_iterator beg,
-                                              join_index::const_iterator lim) {
-  return pack_join_info(beg, lim, [](const join_registry& el) -> join_info_lhs {
-    return join_info_lhs{el.owner_rank(), el.owner_index()};
-  });
-}
-
-std::vector<join_info_rhs> pack_join_info_rhs(join_index::const_iterator beg,
-                                              join_index::const_iterator lim) {
-  return pack_join_info(beg, lim, [](const join_registry& el) -> join_info_rhs {
-    return join_info_rhs{el.owner_index()};
-  });
-}
-
 void store_candidates(const std::vector<int>&          localInfo,
                      const std::vector<join_info_lhs>& remoteInfo) {
-  local.mergeCandidates.emplace_back(localInfo, remoteInfo);
+  local.join.store_candidates(localInfo, remoteInfo);
 }
 
 void comm_join_candidates(ygm::comm& w, int dest, const std::vector<int>& rhsInfo,
@@ -363,37 +261,68 @@ void comm_join_candidates(ygm::comm& w, int dest, const std::vector<int>& rhsInf
     return;
   }
 
+  count_sent(rhsInfo, lhsInfo);
   w.async(
       dest,
       [](const std::vector<int>& ri, const std::vector<join_info_lhs>& li)
-          -> void { store_candidates(ri, li); },
+          -> void {
+        count_received(ri, li);
+        store_candidates(ri, li);
+      },
       rhsInfo, lhsInfo);
 }
 
-void store_join_data(const std::vector<int>& indices, const bj::array& data) {
-  local.joinData.emplace_back(indices, data);
+void store_join_data(const std::vector<int>&  indices,
+                     const xpr::column_batch& data, int source,
+                     const std::vector<int>& sourceIndices) {
+  local.profile->count(join_counter::rows_received, data.size());
+  local.joinData.emplace_back(indices, data, source, sourceIndices);
 }
 
+/// \param sourceIndices the rhs rows of \ref data; only needed if the
+///        rhs rows are preserved by an outer join.
 void comm_join_data(ygm::comm& w, int dest, const std::vector<int>& indices,
-                  bj::array& data) {
+                    const xpr::column_batch& data,
+                    const std::vector<int>& sourceIndices) {
+  local.profile->count(join_counter::rows_moved, data.size());
+
   if (w.rank() == dest) {
-    store_join_data(indices, data);
+    store_join_data(indices, data, w.rank(), sourceIndices);
     return;
   }
 
-  std::stringstream buf;
-
-  buf << data;
+  count_sent(indices, data, w.rank(), sourceIndices);
   w.async(
       dest,
-      [](const std::vector<int>& idx, const std::string& data) -> void {
-        bj::value jsdata = bj::parse(data);
+      [](const std::vector<int>& idx, const xpr::column_batch& data, int src,
+         const std::vector<int>& srcIdx) -> void {
+        count_received(idx, data, src, srcIdx);
+        store_join_data(idx, data, src, srcIdx);
+      },
+      indices, data, w.rank(), sourceIndices);
+}
 
-        assert(jsdata.is_array());
+void store_rhs_matches(const std::vector<int>& indices) {
+  for (int idx : indices) local.rhsMatched[idx] = true;
+}
+
+/// tells the owner of rhs rows which of its rows joined a lhs row
+void comm_rhs_matches(ygm::comm& w, int dest, const std::vector<int>& indices) {
+  if (indices.empty()) return;
+
+  if (w.rank() == dest) {
+    store_rhs_matches(indices);
+    return;
+  }
 
-        store_join_data(idx, jsdata.as_array());
+  count_sent(indices);
+  w.async(
+      dest,
+      [](const std::vector<int>& idx) -> void {
+        count_received(idx);
+        store_rhs_matches(idx);
       },
-      indices, buf.str());
+      indices);
 }
 
 // template <typename _allocator_type>
@@ -401,7 +330,15 @@ std::uint64_t compute_hash( const xpr::metall_json_lines::accessor_type& val,
                             const ColumnSelector& sel, ygm::comm& w) {
   assert(val.is_object());
 
-  const auto&   obj = val.as_object();
+  const auto& obj = val.as_object();
+
+  // single-column keys are the common case: hash the value directly
+  if (sel.size() == 1) {
+    auto pos = obj.find(sel.front());
+
+    return pos != obj.end() ? key_hash_code((*pos).value()) : 0;
+  }
+
   std::uint64_t res{0};
 
   for (const ColumnSelector::value_type& col : sel) {
@@ -410,20 +347,97 @@ std::uint64_t compute_hash( const xpr::metall_json_lines::accessor_type& val,
     if (pos != obj.end()) {
       const auto& sub = (*pos).value();
 
-      res = combine_hash(res, json_hash_code(sub));
+      res = combine_hash(res, key_hash_code(sub));
     }
   }
 
   return res;
 }
 
-void compute_merge_info( ygm::comm& world, const xpr::metall_json_lines& vec,
-                         const ColumnSelector& colsel, join_side which) {
+/// the number of integer keys that are hashed together
+static constexpr std::size_t KEY_HASH_BLOCK_SIZE = 1024;
+
+/// calls fn(rownum, hash) for each selected row of \ref vec with the
+///   hash of its join key (see compute_hash). For a single integer key
+///   column, the keys are collected in blocks and mixed in one pass; the
+///   lookup of the key uses the column index if the key is indexed.
+/// \note the rows are not visited in order
+template <class Fn>
+void for_each_key_hash(ygm::comm& world, const xpr::metall_json_lines& vec,
+                       const ColumnSelector& colsel, Fn fn) {
+  xpr::perf_scope perf{xpr::perf_region::hash};
+  std::size_t     hashed = 0;
+
+  if (colsel.size() != 1) {
+    vec.for_all_selected(
+        [&world, &colsel, &fn, &hashed](
+            std::size_t                                  rownum,
+            const xpr::metall_json_lines::accessor_type& row) -> void {
+          ++hashed;
+          fn(rownum, compute_hash(row, colsel, world));
+        });
+
+    perf.rows(hashed);
+    return;
+  }
+
+  std::vector<std::uint64_t> keys;
+  std::vector<std::size_t>   rows;
+
+  keys.reserve(KEY_HASH_BLOCK_SIZE);
+  rows.reserve(KEY_HASH_BLOCK_SIZE);
+
+  auto flush = [&keys, &rows, &fn]() -> void {
+    mix_hash64(keys.data(), keys.size());
+
+    for (std::size_t i = 0; i < keys.size(); ++i) fn(rows[i], keys[i]);
+
+    keys.clear();
+    rows.clear();
+  };
+
+  const std::string& col = colsel.front();
+
   vec.for_all_selected(
-      [&world, &colsel, which](
-          std::size_t                                  rownum,
+      [&](std::size_t                                  rownum,
           const xpr::metall_json_lines::accessor_type& row) -> void {
-        std::uint64_t hval = compute_hash(row, colsel, world);
+        assert(row.is_object());
+        ++hashed;
+
+        const auto& obj = row.as_object();
+        auto        pos = obj.find(col);
+
+        if (pos == obj.end()) return fn(rownum, std::uint64_t(0));
+
+        const auto& key = (*pos).value();
+
+        if (!key.is_int64() && !key.is_uint64())
+          return fn(rownum, key_hash_code(key));
+
+        // same value as key_hash_code after mixing
+        keys.push_back(key.is_int64() ? std::uint64_t(key.as_int64())
+                                      : key.as_uint64());
+        rows.push_back(rownum);
+
+        if (keys.size() == KEY_HASH_BLOCK_SIZE) flush();
+      });
+
+  flush();
+  perf.rows(hashed);
+}
+
+void compute_merge_info( ygm::comm& world, const xpr::metall_json_lines& vec,
+                         const ColumnSelector& colsel, join_side which,
+                         const xpr::bloom_filter& keys) {
+  for_each_key_hash(
+      world, vec, colsel,
+      [&world, which, &keys](std::size_t rownum, std::uint64_t hval) -> void {
+        local.profile->count(join_counter::rows_hashed);
+
+        if (!keys.may_contain(hval)) {
+          local.profile->count(join_counter::rows_filtered);
+          return;
+        }
 
         if (DEBUG_TRACE_MERGE && ((rownum % (1 << 12)) == 0)) {
           simple_logger{}
@@ -550,6 +564,57 @@ make_output_function(ColumnSelector projlst, std::string suffix)
          };
 }
 
+using batch_output_fn =
+    std::function<void(xpr::metall_json_lines::accessor_type::object_accessor,
+                       const xpr::column_batch&, std::size_t)>;
+
+void
+join_records_in_place( xpr::metall_json_lines::accessor_type res,
+                       const bj::value& lhs,
+                       const output_fn& lhs_append,
+                       const xpr::column_batch& rhs, std::size_t rhsRow,
+                       const batch_output_fn& rhs_append) {
+  auto obj = res.emplace_object();
+
+  lhs_append(obj, lhs);
+  rhs_append(obj, rhs, rhsRow);
+}
+
+/// as make_output_function, but copies the values from a column batch
+batch_output_fn
+make_batch_output_function(ColumnSelector projlst, std::string suffix)
+{
+  using object_accessor = xpr::metall_json_lines::accessor_type::object_accessor;
+
+  if (projlst.empty())
+  {
+    return [sf = std::move(suffix)]
+           (object_accessor res, const xpr::column_batch& batch, std::size_t row)->void
+           {
+             for (std::size_t col = 0; col < batch.num_columns(); ++col) {
+               if (!batch.contains(col, row)) continue;
+
+               batch.emplace(res[batch.column_name(col) + sf], col, row);
+             }
+           };
+  }
+
+  ColumnSelector outFieldList = append_suffix(projlst, suffix);
+
+  return [pl = std::move(projlst), of = std::move(outFieldList)]
+         (object_accessor res, const xpr::column_batch& batch, std::size_t row)->void
+         {
+           const int len = pl.size();
+
+           for (int i = 0; i < len; ++i) {
+             const std::size_t col = batch.find_column(pl[i]);
+
+             if ((col != xpr::column_batch::npos) && batch.contains(col, row))
+               batch.emplace(res[of[i]], col, row);
+           }
+         };
+}
+
 
 bool equal_to(const bj::value&                             lhs,
               const bj::value&                             rhs)
@@ -743,283 +808,1491 @@ void clear_vector(Vector& vec)
   Vector v;
   v.swap(vec);
 }
-}  // namespace
 
-namespace experimental {
+//
+// sort-merge join
 
-std::size_t merge(metall_json_lines& resVec, const metall_json_lines& lhsVec,
-                  const metall_json_lines& rhsVec, ColumnSelector lhsOn,
-                  ColumnSelector rhsOn, ColumnSelector lhsProj,
-                  ColumnSelector rhsProj,
-                  std::string lhsSuffix = "_l",
-                  std::string rhsSuffix = "_r"
-                  ) {
-  using time_point = std::chrono::time_point<std::chrono::system_clock>;
+/// number of hash samples that each rank contributes per join side
+static constexpr std::size_t SORT_MERGE_SAMPLES_PER_RANK = 1024;
 
-  ygm::comm&     world       = resVec.comm();
-  ColumnSelector sendListRhs = rhsProj;
+/// a key is heavy, if its estimated number of rows exceeds this fraction
+///   of the rows that a rank holds on average.
+static constexpr double SORT_MERGE_HEAVY_KEY_FACTOR = 0.5;
 
-  add_join_columns_to_output(rhsOn, sendListRhs);
+/// number of rows that are sent to a rank in one message
+static constexpr std::size_t SORT_MERGE_BATCH_SIZE = 1024;
 
-  //
-  // phase 0: build index on corresponding nodes for merge operations
-  if (DEBUG_TRACE_MERGE) {
-    simple_logger{}
-            << "phase 0: @" << world.rank()
-            << " *l: " << lhsVec.local_size()  // << " @" << lhsLoc
-            << " *r: " << rhsVec.local_size()  // << " @" << rhsLoc
-            << '\n';
+/// a heavy key is split across num_ranks() ranks starting at first_rank()
+///   (modulo comm-size); the rows of split_side() are distributed over
+///   these ranks, the rows of the other side are replicated to all of them.
+struct heavy_key : std::tuple<std::uint64_t, int, int, int> {
+  using base = std::tuple<std::uint64_t, int, int, int>;
+  using base::base;
+
+  std::uint64_t hash() const { return std::get<0>(*this); }
+  int           first_rank() const { return std::get<1>(*this); }
+  int           num_ranks() const { return std::get<2>(*this); }
+  join_side     split_side() const { return join_side(std::get<3>(*this)); }
+};
+
+struct by_heavy_hash {
+  bool operator()(const heavy_key& lhs, std::uint64_t rhs) const {
+    return lhs.hash() < rhs;
   }
+};
 
-  time_point starttime_P0 = std::chrono::system_clock::now();
+/// rows of one join side partitioned to this rank
+struct partitioned_rows {
+  std::vector<std::uint64_t> hashes;
+  std::vector<bj::value>     rows;
+};
 
-  //   left:
-  //     open left object
-  //     compute hash and send to designated node
-  compute_merge_info(world, lhsVec, lhsOn, lhsData);
+struct sort_merge_process_data {
+  /// hash samples and number of local rows by source rank (on rank 0)
+  std::vector<std::vector<std::uint64_t>> samples[2];
+  std::vector<std::uint64_t>              sampledRows[2];
 
-  if (DEBUG_TRACE_MERGE) {
-    simple_logger{} << "@done left now right\n";
-  }
+  /// partitioning plan
+  std::vector<std::uint64_t> splitters;
+  std::vector<heavy_key>     heavyKeys;
 
-  //   right:
-  //     open right object
-  //     compute hash and send to designated node
-  compute_merge_info(world, rhsVec, rhsOn, rhsData);
+  partitioned_rows partition[2];
+};
 
-  if (DEBUG_TIME_MERGE) {
-    time_point endtime_P0 = std::chrono::system_clock::now();
-    int elapsedtime = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          endtime_P0 - starttime_P0)
-                          .count();
+sort_merge_process_data sortMergeLocal;  // global allocation!
 
-    const double recPerS = ((lhsVec.local_size() + rhsVec.local_size()) /
-                             (elapsedtime / 1000.0));
+void store_samples(join_side which, int src, std::uint64_t numrows,
+                   const std::vector<std::uint64_t>& smpl) {
+  sort_merge_process_data& sm = sortMergeLocal;
 
-    simple_logger{}
-            << "@barrier 0: elapsedTime: " << elapsedtime << "ms : "
-            << recPerS << " rec/s\n";
+  if (sm.samples[which].size() <= std::size_t(src)) {
+    sm.samples[which].resize(src + 1);
+    sm.sampledRows[which].resize(src + 1);
   }
 
-  world.barrier();
+  sm.samples[which][src]     = smpl;
+  sm.sampledRows[which][src] = numrows;
+}
 
-  if (DEBUG_TRACE_MERGE) {
-    simple_logger{}
-            << "phase 1: @" << world.rank()
-            << "  L: " << local.joinIndex[lhsData].size()
-            << "  R: " << local.joinIndex[rhsData].size()
-            << '\n';
-  }
+void store_plan(const std::vector<std::uint64_t>& splitters,
+                const std::vector<heavy_key>&     heavyKeys) {
+  sortMergeLocal.splitters = splitters;
+  sortMergeLocal.heavyKeys = heavyKeys;
+}
 
-  time_point starttime_P1 = std::chrono::system_clock::now();
+void store_partitioned_rows(join_side which,
+                            const std::vector<std::uint64_t>& hashes,
+                            const xpr::column_batch& rows) {
+  partitioned_rows& part = sortMergeLocal.partition[which];
 
-  // phase 1: perform preliminary merge based on hash
-  //       a) sort the two indices
-  std::sort(local.joinIndex[lhsData].begin(), local.joinIndex[lhsData].end(),
-            by_hash_owner{});
-  std::sort(local.joinIndex[rhsData].begin(), local.joinIndex[rhsData].end(),
-            by_hash_owner{});
+  local.profile->count(join_counter::rows_received, rows.size());
+  part.hashes.insert(part.hashes.end(), hashes.begin(), hashes.end());
+  for (std::size_t i = 0; i < rows.size(); ++i)
+    part.rows.push_back(rows.row_at(i));
+}
 
-  //       b) send information of join candidates on left side to owners of
-  //       right side
-  join_index::const_iterator       lsbeg = local.joinIndex[lhsData].begin();
-  const join_index::const_iterator lslim = local.joinIndex[lhsData].end();
-  join_index::const_iterator       rsbeg = local.joinIndex[rhsData].begin();
-  const join_index::const_iterator rslim = local.joinIndex[rhsData].end();
-
-  while ((lsbeg != lslim) && (rsbeg != rslim)) {
-    const std::uint64_t       lskey = lsbeg->hash();
-    const std::uint64_t       rskey = rsbeg->hash();
-    join_index::const_iterator lseqr =
-        std::find_if_not(lsbeg + 1, lslim, same_hash_key{lsbeg->hash()});
-    join_index::const_iterator rseqr =
-        std::find_if_not(rsbeg + 1, rslim, same_hash_key{rsbeg->hash()});
-
-    if (lskey < rskey) {
-      lsbeg = lseqr;
-      continue;
-    }
+/// sends a set of evenly spaced samples of the sorted \ref hashes to rank 0
+void comm_samples(ygm::comm& w, join_side which,
+                  const std::vector<std::uint64_t>& hashes) {
+  const std::size_t          len = hashes.size();
+  const std::size_t          num = std::min(len, SORT_MERGE_SAMPLES_PER_RANK);
+  std::vector<std::uint64_t> smpl;
 
-    if (lskey > rskey) {
-      rsbeg = rseqr;
-      continue;
-    }
+  smpl.reserve(num);
+  for (std::size_t i = 0; i < num; ++i)
+    smpl.push_back(hashes[(i * len + len / 2) / num]);
+
+  if (w.rank() == 0) {
+    store_samples(which, 0, len, smpl);
+    return;
+  }
+
+  count_sent(which, w.rank(), std::uint64_t(len), smpl);
+  w.async(
+      0,
+      [](join_side operand, int src, std::uint64_t numrows,
+         const std::vector<std::uint64_t>& s) -> void {
+        count_received(operand, src, numrows, s);
+        store_samples(operand, src, numrows, s);
+      },
+      which, w.rank(), std::uint64_t(len), smpl);
+}
+
+/// computes splitters and heavy keys from the samples (on rank 0) and
+///   sends them to all ranks.
+/// \details
+///   each sample of a rank stands for numrows / numsamples rows of that
+///   rank. A key whose estimated number of rows exceeds
+///   SORT_MERGE_HEAVY_KEY_FACTOR times the average rows per rank is heavy;
+///   its larger side is split over as many ranks as it needs to fit into
+///   a rank's share. The splitters partition the remaining samples into
+///   ranges of equal estimated weight.
+void comm_plan(ygm::comm& w) {
+  if (w.rank() != 0) return;
 
-    //     b.1) keys are equal
-    //             pack candidates on left side
-    std::vector<join_info_lhs> lhsJoinData = pack_join_info_lhs(lsbeg, lseqr);
+  using weighted_sample = std::tuple<std::uint64_t, double, double>;
 
-    lsbeg = lseqr;
+  sort_merge_process_data&     sm = sortMergeLocal;
+  std::vector<weighted_sample> weighted;
+  double                       total = 0;
 
-    //     b.2) send lhs candidates to all owners of rhs candidates
-    //          processing groups by owner
-    while (rsbeg < rseqr) {
-      const int dest      = rsbeg->owner_rank();
-      auto      sameOwner = [dest](const join_registry& rhs) -> bool {
-        return dest == rhs.owner_rank();
-      };
-      join_index::const_iterator rsdst =
-          std::find_if_not(rsbeg + 1, rseqr, sameOwner);
+  for (join_side which : {lhsData, rhsData}) {
+    for (std::size_t src = 0; src < sm.samples[which].size(); ++src) {
+      const std::vector<std::uint64_t>& smpl = sm.samples[which][src];
 
-      //           pack all right hand side candidates with the same owner
-      std::vector<int> rhsJoinData = pack_join_info_rhs(rsbeg, rsdst);
+      total += sm.sampledRows[which][src];
+      if (smpl.empty()) continue;
 
-      //           send candidates
-      comm_join_candidates(world, dest, rhsJoinData, lhsJoinData);
+      const double weight = double(sm.sampledRows[which][src]) / smpl.size();
 
-      rsbeg = rsdst;
+      for (std::uint64_t h : smpl)
+        weighted.emplace_back(h, which == lhsData ? weight : 0.0,
+                              which == rhsData ? weight : 0.0);
     }
   }
 
-  clear_vector(local.joinIndex[lhsData]);
-  clear_vector(local.joinIndex[rhsData]);
+  clear_vector(sm.samples[lhsData]);
+  clear_vector(sm.samples[rhsData]);
+  clear_vector(sm.sampledRows[lhsData]);
+  clear_vector(sm.sampledRows[rhsData]);
+
+  std::sort(weighted.begin(), weighted.end());
+
+  // aggregate the estimates by key and extract heavy keys
+  const int                    numranks  = w.size();
+  const double                 share     = total / numranks;
+  std::vector<weighted_sample> light;
+  std::vector<heavy_key>       heavyKeys;
+  double                       lightTotal = 0;
+
+  for (auto beg = weighted.begin(); beg != weighted.end();) {
+    const std::uint64_t h   = std::get<0>(*beg);
+    auto                lim =
+        std::find_if(beg, weighted.end(), [h](const weighted_sample& el) {
+          return std::get<0>(el) != h;
+        });
+    double              lhsEst = 0;
+    double              rhsEst = 0;
+
+    for (; beg != lim; ++beg) {
+      lhsEst += std::get<1>(*beg);
+      rhsEst += std::get<2>(*beg);
+    }
 
-  if (DEBUG_TIME_MERGE) {
-    time_point endtime_P1 = std::chrono::system_clock::now();
-    int elapsedtime = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          endtime_P1 - starttime_P1)
-                          .count();
+    const double splitEst = std::max(lhsEst, rhsEst);
+    const int    parts =
+        std::min(numranks, int(std::ceil(splitEst / share)));
 
-    simple_logger{} << "@barrier 1: elapsedTime: " << elapsedtime
-                    << "ms\n";
-  }
+    const bool heavy =
+        (lhsEst + rhsEst > SORT_MERGE_HEAVY_KEY_FACTOR * share) && (parts > 1);
 
-  world.barrier();  // not needed
-  time_point starttime_P2 = std::chrono::system_clock::now();
+    if (heavy) {
+      heavyKeys.emplace_back(h, int(h % numranks), parts,
+                             int(lhsEst >= rhsEst ? lhsData : rhsData));
+      continue;
+    }
 
-  if (DEBUG_TRACE_MERGE) {
-    simple_logger{} << "phase 2: @" << world.rank()
-                    << "  M: " << local.mergeCandidates.size() << '\n';
+    light.emplace_back(h, lhsEst, rhsEst);
+    lightTotal += lhsEst + rhsEst;
   }
 
-  // phase 2: send data to node that computes the join
-  metall_json_lines::metall_projector_type projectRow = projector(sendListRhs);
+  // choose splitters, s.t. each rank receives the same estimated weight
+  std::vector<std::uint64_t> splitters;
+  double                     cumulative = 0;
 
-  for (const merge_candidates& m : local.mergeCandidates) {
-    using iterator = std::vector<join_info_lhs>::const_iterator;
+  for (const weighted_sample& el : light) {
+    if (int(splitters.size()) + 1 >= numranks) break;
 
-    bj::array jsdata;
+    cumulative += std::get<1>(el) + std::get<2>(el);
 
-    // project the entry according to the projection list and send it to the lhs
-    for (int idx : m.local_data())
-      jsdata.emplace_back(projectRow(rhsVec.at(idx)));
+    if (cumulative >= (splitters.size() + 1) * (lightTotal / numranks))
+      splitters.push_back(std::get<0>(el));
+  }
 
-    // send to all potential owners
-    iterator beg = m.remote_data().begin();
-    iterator lim = m.remote_data().end();
+  for (int dest = 0; dest < numranks; ++dest) {
+    if (dest == w.rank()) {
+      store_plan(splitters, heavyKeys);
+      continue;
+    }
 
-    assert(beg != lim);
-    do {
-      const int dest = beg->owner();
-      iterator  nxt =
-          std::find_if(beg, lim, [dest](const join_info_lhs& el) -> bool {
-            return el.owner() != dest;
-          });
+    count_sent(splitters, heavyKeys);
+    w.async(
+        dest,
+        [](const std::vector<std::uint64_t>& s,
+           const std::vector<heavy_key>&     hk) -> void {
+          count_received(s, hk);
+          store_plan(s, hk);
+        },
+        splitters, heavyKeys);
+  }
+}
 
-      std::vector<int> indices;
+/// buffers (projected) rows for a destination and sends them in batches
+struct partition_buffer {
+  explicit partition_buffer(const ColumnSelector& projlst) : rows(projlst) {}
 
-      std::transform(beg, nxt, std::back_inserter(indices),
-                     [](const join_info_lhs& el) -> int { return el.index(); });
+  void flush(ygm::comm& w, int dest, join_side which) {
+    if (hashes.empty()) return;
 
-      comm_join_data(world, dest, indices, jsdata);
+    if (w.rank() == dest)
+      store_partitioned_rows(which, hashes, rows);
+    else
+      send(w, dest, which);
 
-      beg = nxt;
-    } while (beg != lim);
+    hashes.clear();
+    rows.clear();
   }
 
-  clear_vector(local.mergeCandidates);
+  /// sends the buffered rows to all ranks
+  void broadcast(ygm::comm& w, join_side which) {
+    if (hashes.empty()) return;
 
-  if (DEBUG_TIME_MERGE) {
-    time_point endtime_P2 = std::chrono::system_clock::now();
-    int elapsedtime = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          endtime_P2 - starttime_P2)
-                          .count();
+    for (int dest = 0; dest < w.size(); ++dest)
+      if (dest != w.rank()) send(w, dest, which);
 
-    simple_logger{} << "@barrier 2: elapsedTime: " << elapsedtime
-                    << "ms\n";
+    store_partitioned_rows(which, hashes, rows);
+    hashes.clear();
+    rows.clear();
   }
 
-  world.barrier();
+  template <class JsonValue>
+  void append(std::uint64_t h, const JsonValue& row) {
+    hashes.push_back(h);
+    rows.append(row);
+  }
 
-  time_point starttime_P3 = std::chrono::system_clock::now();
-  resVec.clear();
+  std::size_t size() const { return hashes.size(); }
+
+ private:
+  void send(ygm::comm& w, int dest, join_side which) const {
+    local.profile->count(join_counter::rows_moved, rows.size());
+    count_sent(which, hashes, rows);
+    w.async(
+        dest,
+        [](join_side operand, const std::vector<std::uint64_t>& hs,
+           const xpr::column_batch& data) -> void {
+          count_received(operand, hs, data);
+          store_partitioned_rows(operand, hs, data);
+        },
+        which, hashes, rows);
+  }
 
-  if (DEBUG_TRACE_MERGE) {
-    simple_logger{} << "phase 3: @" << world.rank() << "  J: "
-                    << local.joinData.size()
-                    << '\n';
+  std::vector<std::uint64_t> hashes;
+  xpr::column_batch          rows;
+};
+
+/// sends the projected rows of one side to the ranks selected by the plan
+void comm_partitioned_rows(
+    ygm::comm& w, const xpr::metall_json_lines& vec,
+    const std::vector<std::pair<std::uint64_t, int> >& hashes,
+    const ColumnSelector& projlst, join_side which) {
+  const sort_merge_process_data& sm         = sortMergeLocal;
+  const int                      numranks   = w.size();
+  const int                      rank       = w.rank();
+  std::vector<partition_buffer>  outgoing(numranks,
+                                          partition_buffer{projlst});
+
+  auto send = [&](int dest, std::uint64_t h,
+                  const xpr::metall_json_lines::accessor_type& row) -> void {
+    partition_buffer& buf = outgoing[dest];
+
+    buf.append(h, row);
+
+    if (buf.size() == SORT_MERGE_BATCH_SIZE) buf.flush(w, dest, which);
+  };
+
+  for (const auto& [h, rownum] : hashes) {
+    const auto row = vec.at(rownum);
+    auto heavy = std::lower_bound(sm.heavyKeys.begin(), sm.heavyKeys.end(), h,
+                                  by_heavy_hash{});
+
+    if ((heavy == sm.heavyKeys.end()) || (heavy->hash() != h)) {
+      const int dest = std::distance(
+          sm.splitters.begin(),
+          std::lower_bound(sm.splitters.begin(), sm.splitters.end(), h));
+
+      send(dest, h, row);
+      continue;
+    }
+
+    if (heavy->split_side() == which) {
+      // spread the rows; the rank offset avoids that all ranks start
+      //   sending to the same rank.
+      const int part = (rownum + rank) % heavy->num_ranks();
+
+      send((heavy->first_rank() + part) % numranks, h, row);
+      continue;
+    }
+
+    for (int part = 0; part < heavy->num_ranks(); ++part)
+      send((heavy->first_rank() + part) % numranks, h, row);
   }
 
-  // phase 3:
-  //   process the join data and perform the actual joins
-  {
-    ColumnSelector  packListLhs  = lhsProj;
-    output_fn       lhsOutFn     = make_output_function(std::move(lhsProj), std::move(lhsSuffix));
-    output_fn       rhsOutFn     = make_output_function(std::move(rhsProj), std::move(rhsSuffix));
-    key_unifier     keyUnifier;
-    merge_data_tracer datatrace;
+  for (int dest = 0; dest < numranks; ++dest)
+    outgoing[dest].flush(w, dest, which);
+}
 
-    add_join_columns_to_output(lhsOn, packListLhs);
+/// returns the positions of a partition's rows ordered by hash
+std::vector<std::size_t> sorted_by_hash(const partitioned_rows& part) {
+  std::vector<std::size_t> res(part.hashes.size());
 
-    std::vector<key_unifier::key_type> unifiedRhsKeyIndices;
+  std::iota(res.begin(), res.end(), std::size_t(0));
+  std::stable_sort(res.begin(), res.end(),
+                   [&hs = part.hashes](std::size_t lhs, std::size_t rhs) {
+                     return hs[lhs] < hs[rhs];
+                   });
 
-    metall_json_lines::metall_projector_type projectRow = projector(packListLhs);
+  return res;
+}
 
-    for (const join_data& el : local.joinData) {
-      const std::size_t rhsDataLen = el.data().size();
+//
+// broadcast join
 
-      keyUnifier.clear();
-      unifiedRhsKeyIndices.clear();
-      unifiedRhsKeyIndices.reserve(rhsDataLen);
-
-      // preprocess join data
-      for (const bj::value& rhsObj : el.data())
-        unifiedRhsKeyIndices.push_back(keyUnifier(rhsObj, rhsOn));
-
-      // \todo this seems to be too sloppy and slowing down performance
-      //       -> produce a precise prototype object before retrying resreve
-      // resVec.reserve(el.data().front(), el.data().size() * el.indices().size());
-      for (int lhsIdx : el.indices()) {
-        bj::value             lhsObj = projectRow(lhsVec.at(lhsIdx));
-
-        if (key_unifier::key_type lhsKeyIndex = keyUnifier.find(lhsObj, lhsOn); lhsKeyIndex >= 0) {
-          for (std::size_t i = 0; i < rhsDataLen; ++i) {
-            if (lhsKeyIndex == unifiedRhsKeyIndices[i])
-              join_records_in_place(resVec.append_local(), lhsObj, lhsOutFn, el.data()[i], rhsOutFn);
-          }
-        }
-      }
+/// by default, merge replicates a side with fewer rows than this limit
+static constexpr std::size_t DEFAULT_BROADCAST_LIMIT = 1 << 17;
 
-      datatrace.trace(el.indices().size(), rhsDataLen, keyUnifier.len());
-    }
+/// replicates the projected rows of one side to all ranks
+void comm_broadcast_rows(ygm::comm& w, const xpr::metall_json_lines& vec,
+                         const ColumnSelector& colsel,
+                         const ColumnSelector& projlst, join_side which) {
+  partition_buffer outgoing{projlst};
 
-    if (DEBUG_MERGE_DATA)
-    {
-      datatrace.datalength(local.joinData.size());
+  vec.for_all_selected(
+      [&](std::size_t, const xpr::metall_json_lines::accessor_type& row)
+          -> void {
+        local.profile->count(join_counter::rows_hashed);
+        outgoing.append(compute_hash(row, colsel, w), row);
+
+        if (outgoing.size() == SORT_MERGE_BATCH_SIZE)
+          outgoing.broadcast(w, which);
+      });
+
+  outgoing.broadcast(w, which);
+}
 
-      simple_logger{} << datatrace << '\n';
+/// returns true, if lhs[lhsOn..] and rhs[rhsOn..] are the same key;
+///   as in key_unifier, a missing column only matches a missing column.
+bool same_key(const bj::value& lhs, const ColumnSelector& lhsOn,
+              const bj::value& rhs, const ColumnSelector& rhsOn) {
+  const bj::object& lhsObj = lhs.as_object();
+  const bj::object& rhsObj = rhs.as_object();
+
+  for (std::size_t i = 0; i < lhsOn.size(); ++i) {
+    const bj::value* lhsVal = lhsObj.if_contains(lhsOn[i]);
+    const bj::value* rhsVal = rhsObj.if_contains(rhsOn[i]);
+
+    if (!lhsVal || !rhsVal) {
+      if (lhsVal != rhsVal) return false;
+    } else if (*lhsVal != *rhsVal) {
+      return false;
     }
   }
 
-  clear_vector(local.joinData);
+  return true;
+}
 
-  if (DEBUG_TIME_MERGE) {
-    time_point endtime_P3 = std::chrono::system_clock::now();
-    int elapsedtime = std::chrono::duration_cast<std::chrono::milliseconds>(
-                          endtime_P3 - starttime_P3)
-                          .count();
-    simple_logger{} << "@barrier 3: elapsedTime: " << elapsedtime << "ms\n";
-  }
+//
+// selection and projection pushdown
 
-  world.barrier();
+CXX_MAYBE_UNUSED
+json_logic::ValueExpr to_value_expr(const bj::value& val) {
+  if (const std::int64_t* i = val.if_int64()) return json_logic::toValueExpr(*i);
+  if (const std::uint64_t* u = val.if_uint64())
+    return json_logic::toValueExpr(*u);
+  if (const double* d = val.if_double()) return json_logic::toValueExpr(*d);
+  if (const bj::string* s = val.if_string()) return json_logic::toValueExpr(*s);
 
-  if (DEBUG_TRACE_MERGE) {
-    simple_logger{} << "phase Z: @" << world.rank() << " *o: "
-                    << resVec.local_size() << '\n';
+  // as elsewhere, booleans are compared as integers
+  if (const bool* b = val.if_bool())
+    return json_logic::toValueExpr(std::int64_t(*b));
+
+  return json_logic::toValueExpr(nullptr);  // \todo array and object
+}
+
+/// columns, predicates, and output functions of a merge.
+/// \details
+///   the result columns are named "<column><suffix>"; a predicate or a
+///   result projection refers to them as "keys.<column><suffix>".
+struct merge_plan {
+  using predicate_ptr = std::shared_ptr<json_logic::Expr>;
+
+  /// columns that are moved between ranks (incl. join keys and predicate
+  ///   columns); empty if all columns are moved
+  ColumnSelector ship[2];
+
+  /// result columns of a side (without suffix)
+  ColumnSelector emit[2];
+
+  /// if true, all columns of a side are result columns
+  bool emitAll[2] = {true, true};
+
+  std::string suffix[2];
+
+  /// the rows that the merge returns
+  xpr::merge_how how = xpr::merge_how::inner;
+
+  /// predicates that only refer to one side, rewritten to the side's columns
+  JsonExpression pushed[2];
+
+  /// predicates that refer to both sides; evaluated on join candidates
+  std::vector<predicate_ptr> where;
+
+  /// a row of a side is only moved if its key hash may be in the filter,
+  ///   which holds the key hashes of the other side (see semi_join_filter)
+  xpr::bloom_filter keyFilter[2];
+
+  output_fn output(join_side which) const {
+    if (!emitAll[which] && emit[which].empty())
+      return [](xpr::metall_json_lines::accessor_type::object_accessor,
+                const bj::value&) -> void {};
+
+    return make_output_function(emit[which], suffix[which]);
+  }
+
+  batch_output_fn batch_output(join_side which) const {
+    if (!emitAll[which] && emit[which].empty())
+      return [](xpr::metall_json_lines::accessor_type::object_accessor,
+                const xpr::column_batch&, std::size_t) -> void {};
+
+    return make_batch_output_function(emit[which], suffix[which]);
+  }
+
+  /// evaluates the post-join predicates on a pair of join candidates
+  bool accept(const bj::value& lhs, const bj::value& rhs) const {
+    if (where.empty()) return true;
+
+    return accept_with(lhs, [&rhs](std::string_view col) -> json_logic::ValueExpr {
+      if (const bj::value* val = rhs.as_object().if_contains(col))
+        return to_value_expr(*val);
+
+      return json_logic::toValueExpr(nullptr);
+    });
+  }
+
+  bool accept(const bj::value& lhs, const xpr::column_batch& rhs,
+              std::size_t rhsRow) const {
+    if (where.empty()) return true;
+
+    return accept_with(lhs, [&rhs, rhsRow](std::string_view col)
+                                -> json_logic::ValueExpr {
+      const std::size_t pos = rhs.find_column(col);
+
+      if (pos == xpr::column_batch::npos)
+        return json_logic::toValueExpr(nullptr);
+
+      return to_value_expr(rhs.value_at(pos, rhsRow));
+    });
+  }
+
+  /// returns the side and the input column of a result column;
+  ///   throws if the name has neither suffix.
+  std::pair<join_side, std::string_view> input_column(
+      std::string_view name) const {
+    for (join_side which : {lhsData, rhsData}) {
+      const std::string& sf = suffix[which];
+
+      if ((name.size() >= sf.size()) &&
+          (name.substr(name.size() - sf.size()) == sf))
+        return {which, name.substr(0, name.size() - sf.size())};
+    }
+
+    throw std::invalid_argument{"not a merge result column: " +
+                                std::string(name)};
+  }
+
+ private:
+  template <class RhsLookup>
+  bool accept_with(const bj::value& lhs, RhsLookup rhsLookup) const {
+    const bj::object& lhsObj = lhs.as_object();
+
+    auto varLookup = [this, &lhsObj, &rhsLookup](const bj::value& colv,
+                                                 int) -> json_logic::ValueExpr {
+      const bj::string&      colname = colv.as_string();
+      const std::string_view name(colname.data() + KEYS_SELECTOR.size() + 1,
+                                  colname.size() - KEYS_SELECTOR.size() - 1);
+      const auto [which, col] = input_column(name);
+
+      if (which == rhsData) return rhsLookup(col);
+
+      if (const bj::value* val = lhsObj.if_contains(col))
+        return to_value_expr(*val);
+
+      return json_logic::toValueExpr(nullptr);
+    };
+
+    for (const predicate_ptr& pred : where)
+      if (!json_logic::unpackValue<bool>(json_logic::calculate(*pred, varLookup)))
+        return false;
+
+    return true;
+  }
+};
+
+/// appends the columns of \ref cols that are not yet in \ref res
+void append_missing(const ColumnSelector& cols, ColumnSelector& res) {
+  for (const std::string& col : cols)
+    if (std::find(res.begin(), res.end(), col) == res.end()) res.push_back(col);
+}
+
+/// replaces {"var": "keys.<column><suffix>"} by {"var": "keys.<column>"}
+void strip_result_suffix(bj::value& rule, const merge_plan& plan) {
+  if (bj::array* arr = rule.if_array()) {
+    for (bj::value& el : *arr) strip_result_suffix(el, plan);
+
+    return;
+  }
+
+  bj::object* obj = rule.if_object();
+
+  if (!obj) return;
+
+  for (bj::key_value_pair& kv : *obj) {
+    bj::value* var = &kv.value();
+
+    if (kv.key() != "var") {
+      strip_result_suffix(*var, plan);
+      continue;
+    }
+
+    if (bj::array* arr = var->if_array(); arr && !arr->empty())
+      var = &(*arr)[0];
+
+    if (!var->is_string()) continue;
+
+    const bj::string&      varstr = var->as_string();
+    const std::string_view name(varstr.data() + KEYS_SELECTOR.size() + 1,
+                                varstr.size() - KEYS_SELECTOR.size() - 1);
+    std::string            res = KEYS_SELECTOR + ".";
+
+    res.append(plan.input_column(name).second);
+    *var = res;
+  }
+}
+
+/// computes which columns a merge moves and emits, and splits the
+///   predicates into single-side predicates and post-join predicates.
+/// \param where    predicates over the result columns
+/// \param columns  the result columns; an empty list selects all projected
+///        columns
+/// \param how      the join type; semi and anti joins emit no columns
+merge_plan make_merge_plan(const ColumnSelector& lhsOn,
+                           const ColumnSelector& rhsOn,
+                           ColumnSelector lhsProj, ColumnSelector rhsProj,
+                           std::string lhsSuffix, std::string rhsSuffix,
+                           JsonExpression        where   = {},
+                           const ColumnSelector& columns = {},
+                           xpr::merge_how        how     = xpr::merge_how::inner) {
+  merge_plan     res;
+  ColumnSelector extra[2];  // columns needed by post-join predicates
+
+  res.suffix[lhsData] = std::move(lhsSuffix);
+  res.suffix[rhsData] = std::move(rhsSuffix);
+  res.how             = how;
+
+  if (xpr::is_semi_join(how) && !columns.empty())
+    throw std::invalid_argument{"semi and anti joins have no result columns"};
+
+  if ((!where.empty() || !columns.empty()) &&
+      (res.suffix[lhsData] == res.suffix[rhsData]))
+    throw std::invalid_argument{
+        "merge predicates and projections need distinct suffixes"};
+
+  // classify the predicates by the sides they refer to
+  for (bj::object& jexp : where) {
+    auto [ast, vars, hasComputedVarNames] =
+        json_logic::translateNode(jexp["rule"]);
+
+    if (hasComputedVarNames)
+      throw std::runtime_error("unable to work with computed variable names");
+
+    bool           uses[2] = {false, false};
+    ColumnSelector cols[2];
+
+    for (const bj::string& var : vars) {
+      const std::string_view varname(var.data(), var.size());
+
+      if ((varname.rfind(KEYS_SELECTOR, 0) != 0) ||
+          (varname.find('.') != KEYS_SELECTOR.size()))
+        throw std::invalid_argument{"not a merge result column: " +
+                                    std::string(varname)};
+
+      const auto [which, col] =
+          res.input_column(varname.substr(KEYS_SELECTOR.size() + 1));
+
+      uses[which] = true;
+      cols[which].emplace_back(col);
+    }
+
+    if (uses[lhsData] && uses[rhsData]) {
+      res.where.emplace_back(ast.release());
+
+      for (join_side which : {lhsData, rhsData})
+        append_missing(cols[which], extra[which]);
+
+      continue;
+    }
+
+    // a side's predicate is evaluated before any row is moved
+    const join_side which = uses[rhsData] ? rhsData : lhsData;
+
+    strip_result_suffix(jexp["rule"], res);
+    res.pushed[which].emplace_back(std::move(jexp));
+  }
+
+  // result columns of each side
+  ColumnSelector* proj[2] = {&lhsProj, &rhsProj};
+
+  for (join_side which : {lhsData, rhsData}) {
+    if (xpr::is_semi_join(how)) {
+      // only the join keys and the predicate columns are needed
+      res.emitAll[which] = false;
+      continue;
+    }
+
+    res.emitAll[which] = columns.empty() && proj[which]->empty();
+    res.emit[which]    = columns.empty() ? *proj[which] : ColumnSelector{};
+  }
+
+  for (const std::string& name : columns) {
+    const auto [which, col] = res.input_column(name);
+    const ColumnSelector& pl = *proj[which];
+
+    if (!pl.empty() && (std::find(pl.begin(), pl.end(), col) == pl.end()))
+      throw std::invalid_argument{"result column is not projected: " + name};
+
+    res.emit[which].emplace_back(col);
+  }
+
+  // moved columns: result columns, predicate columns, and join keys
+  const ColumnSelector* on[2] = {&lhsOn, &rhsOn};
+
+  for (join_side which : {lhsData, rhsData}) {
+    if (res.emitAll[which]) continue;
+
+    res.ship[which] = res.emit[which];
+    append_missing(extra[which], res.ship[which]);
+    append_missing(*on[which], res.ship[which]);
+  }
+
+  return res;
+}
+}  // namespace
+
+namespace experimental {
+
+/// join algorithms supported by merge
+enum class merge_algorithm : std::uint8_t {
+  hash,       ///< joins on the ranks that own the left-hand side rows
+  sort_merge  ///< sample-sorts both sides; splits heavy keys across ranks
+};
+
+/// returns the merge_algorithm named \ref name
+inline merge_algorithm to_merge_algorithm(std::string_view name) {
+  if (name == "hash") return merge_algorithm::hash;
+  if (name == "sort_merge") return merge_algorithm::sort_merge;
+
+  throw std::invalid_argument{"unknown merge algorithm: " + std::string(name)};
+}
+
+/// joins lhsVec and rhsVec using a distributed sample sort.
+/// \details
+///   both sides are partitioned by the hash of their join keys into
+///   ranges of about equal size, whose bounds are chosen from samples of
+///   the hashes. Keys that own a large fraction of the rows (heavy keys)
+///   are not assigned to a single rank; instead the rows of the larger side
+///   are spread over several ranks, and the rows of the other side are
+///   replicated to each of them. Each rank then sorts its partitions by hash
+///   and merges them. In contrast to the hash algorithm, the result rows
+///   are stored on the rank that computed the join.
+std::size_t sort_merge(metall_json_lines& resVec,
+                       const metall_json_lines& lhsVec,
+                       const metall_json_lines& rhsVec,
+                       const ColumnSelector& lhsOn, const ColumnSelector& rhsOn,
+                       const merge_plan& plan) {
+  using local_hashes = std::vector<std::pair<std::uint64_t, int> >;
+
+  ygm::comm&            world    = resVec.comm();
+  const ColumnSelector* sendList = plan.ship;
+  xpr::run_profile&     profile  = *local.profile;
+
+  // phase 0: compute and sort the local hashes
+  local_hashes hashes[2];
+
+  profile.phase("hash");
+
+  auto computeHashes = [&world](const metall_json_lines& vec,
+                                const ColumnSelector& colsel,
+                                const bloom_filter& keys,
+                                local_hashes& res) -> void {
+    for_each_key_hash(
+        world, vec, colsel,
+        [&keys, &res](std::size_t rownum, std::uint64_t h) -> void {
+          local.profile->count(join_counter::rows_hashed);
+
+          if (keys.may_contain(h))
+            res.emplace_back(h, rownum);
+          else
+            local.profile->count(join_counter::rows_filtered);
+        });
+
+    std::sort(res.begin(), res.end());
+  };
+
+  computeHashes(lhsVec, lhsOn, plan.keyFilter[lhsData], hashes[lhsData]);
+  computeHashes(rhsVec, rhsOn, plan.keyFilter[rhsData], hashes[rhsData]);
+
+  // phase 1: sample the hashes and compute the partitioning plan
+  profile.phase("sample");
+
+  for (join_side which : {lhsData, rhsData}) {
+    std::vector<std::uint64_t> hs;
+
+    hs.reserve(hashes[which].size());
+    for (const auto& el : hashes[which]) hs.push_back(el.first);
+
+    comm_samples(world, which, hs);
+  }
+
+  world.barrier();
+  comm_plan(world);
+  world.barrier();
+
+  // phase 2: partition the rows
+  profile.phase("partition");
+  comm_partitioned_rows(world, lhsVec, hashes[lhsData], sendList[lhsData],
+                        lhsData);
+  clear_vector(hashes[lhsData]);
+  comm_partitioned_rows(world, rhsVec, hashes[rhsData], sendList[rhsData],
+                        rhsData);
+  clear_vector(hashes[rhsData]);
+
+  world.barrier();
+
+  clear_vector(sortMergeLocal.splitters);
+  clear_vector(sortMergeLocal.heavyKeys);
+
+  // phase 3: sort the partitions and merge them
+  profile.phase("join");
+  resVec.clear();
+
+  {
+    const partitioned_rows&  lhsPart = sortMergeLocal.partition[lhsData];
+    const partitioned_rows&  rhsPart = sortMergeLocal.partition[rhsData];
+    std::vector<std::size_t> lhsOrd  = sorted_by_hash(lhsPart);
+    std::vector<std::size_t> rhsOrd  = sorted_by_hash(rhsPart);
+    output_fn   lhsOutFn = plan.output(lhsData);
+    output_fn   rhsOutFn = plan.output(rhsData);
+    key_unifier keyUnifier;
+
+    std::vector<key_unifier::key_type> unifiedRhsKeyIndices;
+
+    auto lsbeg = lhsOrd.begin();
+    auto rsbeg = rhsOrd.begin();
+
+    while ((lsbeg != lhsOrd.end()) && (rsbeg != rhsOrd.end())) {
+      const std::uint64_t lskey = lhsPart.hashes[*lsbeg];
+      const std::uint64_t rskey = rhsPart.hashes[*rsbeg];
+
+      if (lskey < rskey) {
+        ++lsbeg;
+        continue;
+      }
+
+      if (lskey > rskey) {
+        ++rsbeg;
+        continue;
+      }
+
+      auto lseqr = std::find_if(lsbeg, lhsOrd.end(),
+                                [&lhsPart, lskey](std::size_t i) -> bool {
+                                  return lhsPart.hashes[i] != lskey;
+                                });
+      auto rseqr = std::find_if(rsbeg, rhsOrd.end(),
+                                [&rhsPart, rskey](std::size_t i) -> bool {
+                                  return rhsPart.hashes[i] != rskey;
+                                });
+
+      // resolve hash collisions
+      keyUnifier.clear();
+      unifiedRhsKeyIndices.clear();
+
+      for (auto pos = rsbeg; pos != rseqr; ++pos)
+        unifiedRhsKeyIndices.push_back(keyUnifier(rhsPart.rows[*pos], rhsOn));
+
+      for (; lsbeg != lseqr; ++lsbeg) {
+        const bj::value& lhsObj = lhsPart.rows[*lsbeg];
+        const key_unifier::key_type lhsKeyIndex =
+            keyUnifier.find(lhsObj, lhsOn);
+
+        if (lhsKeyIndex < 0) continue;
+
+        for (std::size_t i = 0; i < unifiedRhsKeyIndices.size(); ++i) {
+          const bj::value& rhsObj = rhsPart.rows[*(rsbeg + i)];
+
+          if (lhsKeyIndex == unifiedRhsKeyIndices[i] &&
+              plan.accept(lhsObj, rhsObj))
+            join_records_in_place(resVec.append_local(), lhsObj, lhsOutFn,
+                                  rhsObj, rhsOutFn);
+        }
+      }
+
+      rsbeg = rseqr;
+    }
+  }
+
+  clear_vector(sortMergeLocal.partition[lhsData].hashes);
+  clear_vector(sortMergeLocal.partition[lhsData].rows);
+  clear_vector(sortMergeLocal.partition[rhsData].hashes);
+  clear_vector(sortMergeLocal.partition[rhsData].rows);
+
+  world.barrier();
+
+  return world.all_reduce_sum(resVec.local_size());
+}
+
+/// appends the selected rows of \ref vec that are not \ref matched to
+///   resVec; the rows only have the result columns of their side.
+void append_unmatched(metall_json_lines& resVec, const metall_json_lines& vec,
+                      const std::vector<bool>& matched, const merge_plan& plan,
+                      join_side which) {
+  output_fn                                outFn      = plan.output(which);
+  metall_json_lines::metall_projector_type projectRow =
+      projector(plan.ship[which]);
+
+  vec.for_all_selected(
+      [&](std::size_t rownum, const metall_json_lines::accessor_type& row)
+          -> void {
+        if (matched[rownum]) return;
+
+        outFn(resVec.append_local().emplace_object(), projectRow(row));
+      });
+}
+
+/// replicates the rows of the small side to all ranks, and probes the local
+///   rows of the large side against them; calls
+///   fn(largeRownum, lhsObj, rhsObj) for each pair of rows with the same key,
+///   for which the post-join predicates hold.
+template <class Fn>
+void for_each_broadcast_match(ygm::comm& world,
+                              const metall_json_lines& lhsVec,
+                              const metall_json_lines& rhsVec,
+                              const ColumnSelector& lhsOn,
+                              const ColumnSelector& rhsOn,
+                              const merge_plan& plan, join_side small, Fn fn) {
+  const join_side          large    = (small == lhsData) ? rhsData : lhsData;
+  const metall_json_lines& smallVec = (small == lhsData) ? lhsVec : rhsVec;
+  const metall_json_lines& largeVec = (small == lhsData) ? rhsVec : lhsVec;
+  const ColumnSelector*    on[2]    = {&lhsOn, &rhsOn};
+  const ColumnSelector*    packList = plan.ship;
+
+  // phase 1: replicate the small side
+  local.profile->phase("broadcast");
+  comm_broadcast_rows(world, smallVec, *on[small], packList[small], small);
+
+  world.barrier();
+
+  // phase 2: probe the local rows of the large side
+  local.profile->phase("probe");
+
+  {
+    const partitioned_rows&  smallPart = sortMergeLocal.partition[small];
+    std::vector<std::size_t> smallOrd  = sorted_by_hash(smallPart);
+
+    metall_json_lines::metall_projector_type projectRow =
+        projector(packList[large]);
+
+    auto byHash = [&hs = smallPart.hashes](std::size_t idx,
+                                           std::uint64_t h) -> bool {
+      return hs[idx] < h;
+    };
+
+    largeVec.for_all_selected(
+        [&](std::size_t rownum, const metall_json_lines::accessor_type& row)
+            -> void {
+          const std::uint64_t h   = compute_hash(row, *on[large], world);
+          auto                pos = std::lower_bound(smallOrd.begin(),
+                                                     smallOrd.end(), h, byHash);
+
+          local.profile->count(join_counter::rows_hashed);
+
+          if ((pos == smallOrd.end()) || (smallPart.hashes[*pos] != h))
+            return;
+
+          const bj::value largeObj = projectRow(row);
+
+          for (; (pos != smallOrd.end()) && (smallPart.hashes[*pos] == h);
+               ++pos) {
+            const bj::value& smallObj = smallPart.rows[*pos];
+            const bool       smallLhs = (small == lhsData);
+            const bj::value& lhsObj   = smallLhs ? smallObj : largeObj;
+            const bj::value& rhsObj   = smallLhs ? largeObj : smallObj;
+
+            if (same_key(lhsObj, lhsOn, rhsObj, rhsOn) &&
+                plan.accept(lhsObj, rhsObj))
+              fn(rownum, lhsObj, rhsObj);
+          }
+        });
+  }
+
+  clear_vector(sortMergeLocal.partition[small].hashes);
+  clear_vector(sortMergeLocal.partition[small].rows);
+}
+
+/// joins lhsVec and rhsVec by replicating the rows of the small side
+///   to all ranks.
+/// \details
+///   each rank probes its selected rows of the large side against the
+///   replicated rows; the large side is not shuffled, and the result rows are
+///   stored on the rank that owns the large side's row.
+/// \pre the join type does not preserve the small side
+std::size_t broadcast_merge(metall_json_lines& resVec,
+                            const metall_json_lines& lhsVec,
+                            const metall_json_lines& rhsVec,
+                            const ColumnSelector& lhsOn,
+                            const ColumnSelector& rhsOn,
+                            const merge_plan& plan, join_side small) {
+  const join_side   large    = (small == lhsData) ? rhsData : lhsData;
+  ygm::comm&        world    = resVec.comm();
+  const bool        keep     = preserves(plan.how, large);
+  output_fn         lhsOutFn = plan.output(lhsData);
+  output_fn         rhsOutFn = plan.output(rhsData);
+  std::vector<bool> matched(
+      keep ? (large == lhsData ? lhsVec : rhsVec).local_size() : 0, false);
+
+  assert(!preserves(plan.how, small));
+
+  resVec.clear();
+
+  for_each_broadcast_match(
+      world, lhsVec, rhsVec, lhsOn, rhsOn, plan, small,
+      [&](std::size_t rownum, const bj::value& lhsObj,
+          const bj::value& rhsObj) -> void {
+        join_records_in_place(resVec.append_local(), lhsObj, lhsOutFn, rhsObj,
+                              rhsOutFn);
+
+        if (keep) matched[rownum] = true;
+      });
+
+  if (keep) {
+    local.profile->phase("unmatched");
+    append_unmatched(resVec, (large == lhsData) ? lhsVec : rhsVec, matched,
+                     plan, large);
+  }
+
+  world.barrier();
+
+  return world.all_reduce_sum(resVec.local_size());
+}
+
+/// phases 0 to 2 of the hash algorithm: moves the rhs rows that may join
+///   a lhs row to the rank that owns the lhs row (local.joinData).
+/// \details
+///   the owner of a hash learns which rows on both sides have that hash, and
+///   tells the rhs rows' owners to send the projected rows to the owners of
+///   the lhs rows.
+///   The hash owners' registries and merge candidates are spilled to
+///   scratch files when they exceed the memory budget of \ref spill.
+void hash_exchange(ygm::comm& world, const metall_json_lines& lhsVec,
+                   const metall_json_lines& rhsVec,
+                   const ColumnSelector& lhsOn, const ColumnSelector& rhsOn,
+                   const merge_plan& plan, const spill_options& spill) {
+  const ColumnSelector& sendListRhs = plan.ship[rhsData];
+  const bool            keepRhs     = preserves(plan.how, rhsData);
+  xpr::run_profile&     profile     = *local.profile;
+
+  // the two indices and the candidates share the budget
+  local.join.configure(spill);
+
+  //
+  // phase 0: build index on corresponding nodes for merge operations
+  if (DEBUG_TRACE_MERGE) {
+    simple_logger{}
+            << "phase 0: @" << world.rank()
+            << " *l: " << lhsVec.local_size()  // << " @" << lhsLoc
+            << " *r: " << rhsVec.local_size()  // << " @" << rhsLoc
+            << '\n';
+  }
+
+  profile.phase("hash");
+
+  //   left:
+  //     open left object
+  //     compute hash and send to designated node
+  compute_merge_info(world, lhsVec, lhsOn, lhsData, plan.keyFilter[lhsData]);
+
+  if (DEBUG_TRACE_MERGE) {
+    simple_logger{} << "@done left now right\n";
+  }
+
+  //   right:
+  //     open right object
+  //     compute hash and send to designated node
+  compute_merge_info(world, rhsVec, rhsOn, rhsData, plan.keyFilter[rhsData]);
+
+  world.barrier();
+
+  if (DEBUG_TRACE_MERGE) {
+    simple_logger{}
+            << "phase 1: @" << world.rank()
+            << "  L: " << local.join.index[lhsData].size()
+            << "  R: " << local.join.index[rhsData].size()
+            << '\n';
+  }
+
+  profile.count(join_counter::index_lhs, local.join.index[lhsData].size());
+  profile.count(join_counter::index_rhs, local.join.index[rhsData].size());
+  profile.phase("candidates");
+
+  // phase 1: perform preliminary merge based on hash
+  //       a) sort the two indices (runs spilled to scratch files are merged)
+  //       b) send information of join candidates on left side to owners of
+  //       right side
+  xpr::compute_candidates(
+      local.join,
+      [&world](int dest, const std::vector<join_info_rhs>& rhsInfo,
+               const std::vector<join_info_lhs>& lhsInfo) -> void {
+        comm_join_candidates(world, dest, rhsInfo, lhsInfo);
+      });
+
+  world.barrier();  // not needed
+  profile.phase("exchange");
+
+  if (DEBUG_TRACE_MERGE) {
+    simple_logger{} << "phase 2: @" << world.rank()
+                    << "  M: " << local.join.candidates.size() << '\n';
+  }
+
+  // phase 2: send data to node that computes the join
+  const std::vector<int> noIndices;
+
+  xpr::for_each_candidates(
+      local.join, [&](const merge_candidates& m) -> void {
+        column_batch jsdata(sendListRhs);
+
+        profile.count(join_counter::candidate_groups);
+        profile.count(join_counter::candidate_rows, m.local_data().size());
+
+        // project the entry according to the projection list and send it
+        // to the lhs
+        for (int idx : m.local_data()) jsdata.append(rhsVec.at(idx));
+
+        // send to all potential owners
+        assert(!m.remote_data().empty());
+        xpr::for_each_lhs_owner(
+            m, [&](int dest, const std::vector<int>& indices) -> void {
+              comm_join_data(world, dest, indices, jsdata,
+                             keepRhs ? m.local_data() : noIndices);
+            });
+      });
+
+  world.barrier();
+
+  if (DEBUG_TRACE_MERGE) {
+    simple_logger{} << "phase 3: @" << world.rank() << "  J: "
+                    << local.joinData.size()
+                    << '\n';
+  }
+}
+
+/// phase 3 of the hash algorithm: calls fn(lhsIdx, lhsObj, joinData, rhsRow)
+///   for each pair of a local lhs row and a received rhs row with the same
+///   key, for which the post-join predicates hold. Clears local.joinData.
+template <class Fn>
+void for_each_hash_match(const metall_json_lines& lhsVec,
+                         const ColumnSelector& lhsOn,
+                         const ColumnSelector& rhsOn, const merge_plan& plan,
+                         Fn fn) {
+  const ColumnSelector& packListLhs = plan.ship[lhsData];
+  key_unifier           keyUnifier;
+  merge_data_tracer     datatrace;
+
+  std::vector<key_unifier::key_type> unifiedRhsKeyIndices;
+  std::vector<bj::value>             rhsKeys;
+
+  metall_json_lines::metall_projector_type projectRow = projector(packListLhs);
+
+  for (const join_data& el : local.joinData) {
+    const std::size_t rhsDataLen = el.data().size();
+
+    keyUnifier.clear();
+    unifiedRhsKeyIndices.clear();
+    unifiedRhsKeyIndices.reserve(rhsDataLen);
+    rhsKeys.clear();
+    rhsKeys.reserve(rhsDataLen);  // keyUnifier refers to the keys
+
+    // preprocess join data; only the key columns are decoded
+    for (std::size_t i = 0; i < rhsDataLen; ++i) {
+      rhsKeys.push_back(el.data().row_at(i, rhsOn));
+      unifiedRhsKeyIndices.push_back(keyUnifier(rhsKeys.back(), rhsOn));
+    }
+
+    // \todo this seems to be too sloppy and slowing down performance
+    //       -> produce a precise prototype object before retrying resreve
+    // resVec.reserve(el.data().front(), el.data().size() * el.indices().size());
+    for (int lhsIdx : el.indices()) {
+      bj::value             lhsObj = projectRow(lhsVec.at(lhsIdx));
+
+      if (key_unifier::key_type lhsKeyIndex = keyUnifier.find(lhsObj, lhsOn); lhsKeyIndex >= 0) {
+        for (std::size_t i = 0; i < rhsDataLen; ++i) {
+          if (lhsKeyIndex == unifiedRhsKeyIndices[i] && plan.accept(lhsObj, el.data(), i))
+            fn(lhsIdx, std::as_const(lhsObj), el, i);
+        }
+      }
+    }
+
+    datatrace.trace(el.indices().size(), rhsDataLen, keyUnifier.len());
+  }
+
+  if (DEBUG_MERGE_DATA)
+  {
+    datatrace.datalength(local.joinData.size());
+
+    simple_logger{} << datatrace << '\n';
+  }
+
+  clear_vector(local.joinData);
+}
+
+/// joins lhsVec and rhsVec on the ranks that own the hashes of the join keys.
+/// \details
+///   the rhs rows are moved to the owners of the lhs rows (see
+///   hash_exchange), which compute the join. The result rows are stored on
+///   the rank that owns the lhs row.
+///   Rows without a match that the join type preserves are appended by the
+///   rank that owns them; for rhs rows, the lhs rows' owners report the
+///   matched rows back.
+std::size_t hash_merge(metall_json_lines& resVec,
+                       const metall_json_lines& lhsVec,
+                       const metall_json_lines& rhsVec,
+                       const ColumnSelector& lhsOn, const ColumnSelector& rhsOn,
+                       const merge_plan& plan, const spill_options& spill) {
+  ygm::comm& world   = resVec.comm();
+  const bool keepLhs = preserves(plan.how, lhsData);
+  const bool keepRhs = preserves(plan.how, rhsData);
+
+  if (keepRhs) local.rhsMatched.assign(rhsVec.local_size(), false);
+
+  hash_exchange(world, lhsVec, rhsVec, lhsOn, rhsOn, plan, spill);
+
+  local.profile->phase("join");
+  resVec.clear();
+
+  // phase 3:
+  //   process the join data and perform the actual joins
+  {
+    output_fn         lhsOutFn = plan.output(lhsData);
+    batch_output_fn   rhsOutFn = plan.batch_output(rhsData);
+    std::vector<bool> lhsMatched(keepLhs ? lhsVec.local_size() : 0, false);
+
+    std::vector<std::vector<int> > rhsMatches(keepRhs ? world.size() : 0);
+
+    for_each_hash_match(
+        lhsVec, lhsOn, rhsOn, plan,
+        [&](int lhsIdx, const bj::value& lhsObj, const join_data& el,
+            std::size_t i) -> void {
+          join_records_in_place(resVec.append_local(), lhsObj, lhsOutFn,
+                                el.data(), i, rhsOutFn);
+
+          if (keepLhs) lhsMatched[lhsIdx] = true;
+          if (keepRhs)
+            rhsMatches[el.source()].push_back(el.source_indices()[i]);
+        });
+
+    for (int dest = 0; dest < int(rhsMatches.size()); ++dest) {
+      std::vector<int>& matches = rhsMatches[dest];
+
+      std::sort(matches.begin(), matches.end());
+      matches.erase(std::unique(matches.begin(), matches.end()),
+                    matches.end());
+      comm_rhs_matches(world, dest, matches);
+    }
+
+    if (keepLhs) append_unmatched(resVec, lhsVec, lhsMatched, plan, lhsData);
+  }
+
+  world.barrier();
+
+  if (keepRhs) {
+    local.profile->phase("unmatched");
+    append_unmatched(resVec, rhsVec, local.rhsMatched, plan, rhsData);
+    clear_vector(local.rhsMatched);
+    world.barrier();
+  }
+
+  if (DEBUG_TRACE_MERGE) {
+    simple_logger{} << "phase Z: @" << world.rank() << " *o: "
+                    << resVec.local_size() << '\n';
   }
 
   // done
   return world.all_reduce_sum(resVec.local_size());
 }
 
+/// returns a filter of the join key hashes of the selected rows in vec;
+///   \ref count is the number of selected rows on all ranks. Collective.
+bloom_filter semi_join_filter(ygm::comm& world, const metall_json_lines& vec,
+                              const ColumnSelector& on, std::size_t count) {
+  bloom_filter res{count};
+
+  local.profile->phase("semi_join_filter");
+  for_each_key_hash(world, vec, on,
+                    [&res](std::size_t, std::uint64_t h) -> void {
+                      res.insert(h);
+                    });
+
+  res.all_reduce_or(world);
+  return res;
+}
+
+/// runs the merge algorithm that fits the sizes of the sides
+std::size_t merge_with_plan(metall_json_lines& resVec,
+                            const metall_json_lines& lhsVec,
+                            const metall_json_lines& rhsVec,
+                            const ColumnSelector& lhsOn,
+                            const ColumnSelector& rhsOn, merge_plan plan,
+                            merge_algorithm algorithm,
+                            std::size_t broadcastLimit,
+                            std::size_t semiJoinLimit,
+                            const spill_options& spill,
+                            run_profile* profile) {
+  assert(!is_semi_join(plan.how));
+
+  if ((algorithm == merge_algorithm::sort_merge) &&
+      (plan.how != merge_how::inner))
+    throw std::invalid_argument{"sort_merge only supports inner joins"};
+
+  profile_scope scope(profile);
+  bool          broadcast = false;
+  join_side     small     = rhsData;
+
+  local.profile->phase("plan");
+
+  if ((broadcastLimit > 0) || (semiJoinLimit > 0)) {
+    const std::size_t lhsCount = lhsVec.count();
+    const std::size_t rhsCount = rhsVec.count();
+    const std::size_t smallCount = std::min(lhsCount, rhsCount);
+
+    report_progress({{"left_rows", lhsCount}, {"right_rows", rhsCount}});
+
+    small = (rhsCount <= lhsCount) ? rhsData : lhsData;
+
+    const join_side large = (small == lhsData) ? rhsData : lhsData;
+
+    // replicate a small side instead of shuffling both sides; the ranks
+    //   cannot tell which replicated rows found no match on any rank.
+    broadcast = (smallCount < broadcastLimit) && !preserves(plan.how, small);
+
+    // drop rows of the large side without a matching key before moving them
+    if (!broadcast && (smallCount <= semiJoinLimit))
+      plan.keyFilter[large] =
+          semi_join_filter(resVec.comm(), (small == lhsData) ? lhsVec : rhsVec,
+                           (small == lhsData) ? lhsOn : rhsOn, smallCount);
+  }
+
+  std::size_t res = 0;
+
+  if (broadcast)
+    res = broadcast_merge(resVec, lhsVec, rhsVec, lhsOn, rhsOn, plan, small);
+  else if (algorithm == merge_algorithm::sort_merge)
+    res = sort_merge(resVec, lhsVec, rhsVec, lhsOn, rhsOn, plan);
+  else
+    res = hash_merge(resVec, lhsVec, rhsVec, lhsOn, rhsOn, plan, spill);
+
+  report_progress({{"result_rows", res}});
+  local.profile->count(join_counter::result_rows, resVec.local_size());
+  local.profile->stop();
+  return res;
+}
+
+/// computes the selection of a semi or anti join
+std::vector<std::uint64_t> semi_join_with_plan(
+    const metall_json_lines& lhsVec, const metall_json_lines& rhsVec,
+    const ColumnSelector& lhsOn, const ColumnSelector& rhsOn, merge_plan plan,
+    std::size_t broadcastLimit, std::size_t semiJoinLimit,
+    const spill_options& spill, run_profile* profile) {
+  ygm::comm&        world = lhsVec.comm();
+  std::vector<bool> matched(lhsVec.local_size(), false);
+  bool              broadcast = false;
+  profile_scope     scope(profile);
+
+  assert(is_semi_join(plan.how));
+
+  local.profile->phase("plan");
+
+  if ((broadcastLimit > 0) || (semiJoinLimit > 0)) {
+    const std::size_t lhsCount = lhsVec.count();
+    const std::size_t rhsCount = rhsVec.count();
+    const join_side   small    = (rhsCount <= lhsCount) ? rhsData : lhsData;
+    const join_side   large    = (small == lhsData) ? rhsData : lhsData;
+    const std::size_t smallCount = std::min(lhsCount, rhsCount);
+
+    // the matches of the lhs rows are only known locally if rhs is
+    //   replicated.
+    broadcast = (rhsCount < broadcastLimit);
+
+    // a lhs row that is dropped has no match
+    if (!broadcast && (smallCount <= semiJoinLimit))
+      plan.keyFilter[large] =
+          semi_join_filter(world, (small == lhsData) ? lhsVec : rhsVec,
+                           (small == lhsData) ? lhsOn : rhsOn, smallCount);
+  }
+
+  if (broadcast) {
+    for_each_broadcast_match(
+        world, lhsVec, rhsVec, lhsOn, rhsOn, plan, rhsData,
+        [&matched](std::size_t rownum, const bj::value&,
+                   const bj::value&) -> void { matched[rownum] = true; });
+  } else {
+    hash_exchange(world, lhsVec, rhsVec, lhsOn, rhsOn, plan, spill);
+    for_each_hash_match(
+        lhsVec, lhsOn, rhsOn, plan,
+        [&matched](int lhsIdx, const bj::value&, const join_data&,
+                   std::size_t) -> void { matched[lhsIdx] = true; });
+  }
+
+  const bool                 anti = (plan.how == merge_how::anti);
+  std::vector<std::uint64_t> res((lhsVec.local_size() + 63) / 64, 0);
+
+  lhsVec.for_all_selected(
+      [&](std::size_t rownum, const metall_json_lines::accessor_type&)
+          -> void {
+        if (matched[rownum] == anti) return;
+
+        res[rownum / 64] |= std::uint64_t(1) << (rownum % 64);
+        local.profile->count(join_counter::result_rows);
+      });
+
+  world.barrier();
+  local.profile->stop();
+  return res;
+}
+
+/// join type, selection, and projection of a merge's result
+struct merge_output {
+  /// predicates over the result columns ("keys.<column><suffix>");
+  ///   rows are only joined if all predicates hold.
+  JsonExpression where;
+
+  /// the result columns ("<column><suffix>"); empty selects all
+  ///   projected columns.
+  ColumnSelector columns;
+
+  /// the rows that the merge returns; semi and anti joins do not return
+  ///   rows (see semi_join).
+  merge_how how = merge_how::inner;
+};
+
+/// joins the selected rows of lhsVec and rhsVec, where lhsOn equals rhsOn,
+///   and stores the result in resVec (any existing data is overwritten).
+/// \param algorithm      the join algorithm for two large sides
+/// \param broadcastLimit if one side has fewer selected rows, that side is
+///        replicated instead (see broadcast_merge); 0 turns replication off.
+/// \param semiJoinLimit  if the smaller side has at most this many selected
+///        rows, a Bloom filter of its keys is replicated, and rows of the
+///        other side that cannot match are not moved; 0 turns this off.
+/// \param spill          memory budget and scratch directory of the hash
+///        algorithm's per-rank index and candidates.
+/// \param profile        if not null, records the phase times and the
+///        join_counter counters of this rank (see make_join_profile).
+/// \return the total number of result rows
+std::size_t merge(metall_json_lines& resVec, const metall_json_lines& lhsVec,
+                  const metall_json_lines& rhsVec, ColumnSelector lhsOn,
+                  ColumnSelector rhsOn, ColumnSelector lhsProj,
+                  ColumnSelector rhsProj,
+                  std::string lhsSuffix = "_l",
+                  std::string rhsSuffix = "_r",
+                  merge_algorithm algorithm = merge_algorithm::hash,
+                  std::size_t broadcastLimit = DEFAULT_BROADCAST_LIMIT,
+                  std::size_t semiJoinLimit  = DEFAULT_BLOOM_FILTER_LIMIT,
+                  const spill_options& spill = {},
+                  run_profile* profile = nullptr
+                  ) {
+  merge_plan plan =
+      make_merge_plan(lhsOn, rhsOn, std::move(lhsProj), std::move(rhsProj),
+                      std::move(lhsSuffix), std::move(rhsSuffix));
+
+  return merge_with_plan(resVec, lhsVec, rhsVec, lhsOn, rhsOn, std::move(plan),
+                         algorithm, broadcastLimit, semiJoinLimit, spill,
+                         profile);
+}
+
+/// joins as above, and selects and projects the result.
+/// \details
+///   predicates that refer to the columns of a single side are appended to
+///   that side's filters, so they are evaluated before any row is moved;
+///   the other predicates are evaluated on join candidates. Only the result
+///   columns, the join keys, and the columns of the predicates are moved.
+///   A left, right, or outer join also returns the rows of the preserved
+///   sides that pass their side's predicates but have no matching row for
+///   which the other predicates hold; these rows only have the columns of
+///   their side, which are appended by the rank that owns the row.
+/// \post the filters of lhsVec and rhsVec include the single-side predicates
+std::size_t merge(metall_json_lines& resVec, metall_json_lines& lhsVec,
+                  metall_json_lines& rhsVec, ColumnSelector lhsOn,
+                  ColumnSelector rhsOn, ColumnSelector lhsProj,
+                  ColumnSelector rhsProj, merge_output output,
+                  std::string lhsSuffix = "_l",
+                  std::string rhsSuffix = "_r",
+                  merge_algorithm algorithm = merge_algorithm::hash,
+                  std::size_t broadcastLimit = DEFAULT_BROADCAST_LIMIT,
+                  std::size_t semiJoinLimit  = DEFAULT_BLOOM_FILTER_LIMIT,
+                  const spill_options& spill = {},
+                  run_profile* profile = nullptr
+                  ) {
+  const int  rank = resVec.comm().rank();
+  merge_plan plan =
+      make_merge_plan(lhsOn, rhsOn, std::move(lhsProj), std::move(rhsProj),
+                      std::move(lhsSuffix), std::move(rhsSuffix),
+                      std::move(output.where), output.columns, output.how);
+
+  if (is_semi_join(plan.how))
+    throw std::invalid_argument{"semi and anti joins return a selection"};
+
+  for (join_side which : {lhsData, rhsData})
+    (which == lhsData ? lhsVec : rhsVec)
+        .filter(filter(rank, plan.pushed[which], KEYS_SELECTOR),
+                selection_key(plan.pushed[which]));
+
+  return merge_with_plan(resVec, lhsVec, rhsVec, lhsOn, rhsOn, std::move(plan),
+                         algorithm, broadcastLimit, semiJoinLimit, spill,
+                         profile);
+}
+
+/// selects the rows of lhsVec that have (semi join) or do not have
+///   (anti join) a row in rhsVec, where lhsOn equals rhsOn. No rows are
+///   moved to a result; the rhs only sends the key and predicate columns of
+///   rows that may match.
+/// \param how   merge_how::semi or merge_how::anti
+/// \param where predicates over the columns of both sides
+///        ("keys.<column><suffix>"); single-side predicates are appended to
+///        that side's filters, and a lhs row only matches rhs rows for which
+///        the other predicates hold.
+/// \param profile as in merge; result_rows counts the selected rows.
+/// \return a bitmap of the local rows of lhsVec; bit i is set iff row i is
+///         selected.
+/// \post the filters of lhsVec and rhsVec include the single-side predicates
+std::vector<std::uint64_t> semi_join(
+    metall_json_lines& lhsVec, metall_json_lines& rhsVec, ColumnSelector lhsOn,
+    ColumnSelector rhsOn, merge_how how, JsonExpression where = {},
+    std::string lhsSuffix = "_l", std::string rhsSuffix = "_r",
+    std::size_t broadcastLimit = DEFAULT_BROADCAST_LIMIT,
+    std::size_t semiJoinLimit = DEFAULT_BLOOM_FILTER_LIMIT,
+    const spill_options& spill = {}, run_profile* profile = nullptr) {
+  if (!is_semi_join(how))
+    throw std::invalid_argument{"semi_join requires a semi or anti join"};
+
+  const int  rank = lhsVec.comm().rank();
+  merge_plan plan =
+      make_merge_plan(lhsOn, rhsOn, {}, {}, std::move(lhsSuffix),
+                      std::move(rhsSuffix), std::move(where), {}, how);
+
+  for (join_side which : {lhsData, rhsData})
+    (which == lhsData ? lhsVec : rhsVec)
+        .filter(filter(rank, plan.pushed[which], KEYS_SELECTOR),
+                selection_key(plan.pushed[which]));
+
+  return semi_join_with_plan(lhsVec, rhsVec, lhsOn, rhsOn, std::move(plan),
+                             broadcastLimit, semiJoinLimit, spill, profile);
+}
+
 }  // namespace experimental
@@ -0,0 +1,50 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Counts the point-to-point messages that a process sends.
+/// \details
+///   defines MPI_Send and MPI_Isend, which count the messages and bytes in
+///   mpi_send_counters and forward to the PMPI profiling interface. YGM
+///   sends its message buffers with MPI_Isend, thus the counters include
+///   all messages of the ygm containers and async calls; collectives (e.g.,
+///   all_reduce) are not counted.
+///   The functions must be defined once per executable: this header is only
+///   included by mjl-common.hpp, i.e., by the single translation unit of a
+///   method. Define METALLDATA_NO_MPI_COUNTERS to leave MPI unchanged.
+
+#pragma once
+
+#ifndef METALLDATA_NO_MPI_COUNTERS
+
+#include <mpi.h>
+
+#include "MetallJsonLines-profile.hpp"
+
+namespace experimental {
+inline void count_mpi_send(int count, MPI_Datatype type) {
+  int typeSize = 0;
+
+  PMPI_Type_size(type, &typeSize);
+
+  mpi_send_counters::messages.fetch_add(1, std::memory_order_relaxed);
+  mpi_send_counters::bytes.fetch_add(std::uint64_t(count) * typeSize,
+                                     std::memory_order_relaxed);
+}
+}  // namespace experimental
+
+extern "C" int MPI_Send(const void* buf, int count, MPI_Datatype type,
+                        int dest, int tag, MPI_Comm comm) {
+  experimental::count_mpi_send(count, type);
+  return PMPI_Send(buf, count, type, dest, tag, comm);
+}
+
+extern "C" int MPI_Isend(const void* buf, int count, MPI_Datatype type,
+                         int dest, int tag, MPI_Comm comm,
+                         MPI_Request* request) {
+  experimental::count_mpi_send(count, type);
+  return PMPI_Isend(buf, count, type, dest, tag, comm, request);
+}
+
+#endif /* METALLDATA_NO_MPI_COUNTERS */
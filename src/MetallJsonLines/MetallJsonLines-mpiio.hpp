@@ -0,0 +1,176 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Collective output of the lines of all ranks into a single file.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <stdexcept>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <mpi.h>
+
+namespace experimental {
+
+/// writes the lines of all ranks into a single file with collective MPI-IO.
+/// \details
+///   each rank formats its lines into a block of about blockbytes. Once the
+///   block of a rank is full, all ranks take part in a round: an allgather
+///   of the ranks' block sizes yields each rank's offset (the exclusive
+///   prefix sum) past the data of the previous rounds, and the blocks are
+///   written with a nonblocking collective write. A rank formats into the
+///   second buffer while the write of the first is in flight.
+///   Ranks whose block is not full (or that have no more lines) join the
+///   rounds of the others with what they have; thus, the file holds the
+///   lines of each rank in order, but interleaved with the other ranks'
+///   lines at block boundaries.
+///   The constructor and close are collective.
+class collective_line_writer {
+ public:
+  /// default size of a rank's block
+  static constexpr std::size_t DEFAULT_BLOCK_BYTES = 16 * 1024 * 1024;
+
+  explicit collective_line_writer(const std::string& path,
+                                  std::size_t blockbytes = DEFAULT_BLOCK_BYTES)
+      : limit(blockbytes), out(&sink) {
+    MPI_Info info;
+
+    MPI_Info_create(&info);
+    // aggregates the ranks' blocks into large writes of a few ranks
+    MPI_Info_set(info, "romio_cb_write", "enable");
+
+    const int err = MPI_File_open(MPI_COMM_WORLD, path.c_str(),
+                                  MPI_MODE_CREATE | MPI_MODE_WRONLY, info,
+                                  &file);
+
+    MPI_Info_free(&info);
+    check(err, "unable to open " + path);
+    check(MPI_File_set_size(file, 0), "unable to truncate " + path);
+
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &numranks);
+
+    for (std::string& buf : buffers) buf.reserve(limit + limit / 8);
+
+    sink.target = &buffers[active];
+  }
+
+  ~collective_line_writer() {
+    if (file != MPI_FILE_NULL) MPI_File_close(&file);
+  }
+
+  collective_line_writer(const collective_line_writer&)            = delete;
+  collective_line_writer& operator=(const collective_line_writer&) = delete;
+
+  /// appends \ref val and a newline; \ref val is formatted by operator<<.
+  ///   Collective whenever the block of this rank is full.
+  template <class T>
+  void write_line(const T& val) {
+    out << val << '\n';
+
+    if (buffers[active].size() >= limit) round(false);
+  }
+
+  /// writes the remaining lines and closes the file. Collective.
+  /// \return the size of the file
+  std::uint64_t close() {
+    while (!round(true)) {
+    }
+
+    for (MPI_Request& req : requests) wait(req);
+
+    check(MPI_File_close(&file), "unable to close the file");
+    return base;
+  }
+
+ private:
+  /// a stream buffer that appends to a string
+  struct string_sink : std::streambuf {
+    std::string* target = nullptr;
+
+    int_type overflow(int_type ch) override {
+      if (!traits_type::eq_int_type(ch, traits_type::eof()))
+        target->push_back(traits_type::to_char_type(ch));
+
+      return traits_type::not_eof(ch);
+    }
+
+    std::streamsize xsputn(const char* s, std::streamsize n) override {
+      target->append(s, n);
+      return n;
+    }
+  };
+
+  static void check(int err, const std::string& what) {
+    if (err == MPI_SUCCESS) return;
+
+    char msg[MPI_MAX_ERROR_STRING];
+    int  len = 0;
+
+    MPI_Error_string(err, msg, &len);
+    throw std::runtime_error{"MPI-IO: " + what + ": " + std::string(msg, len)};
+  }
+
+  void wait(MPI_Request& req) {
+    if (req == MPI_REQUEST_NULL) return;
+
+    check(MPI_Wait(&req, MPI_STATUS_IGNORE), "write failed");
+  }
+
+  /// writes the active block of each rank and switches the buffers
+  /// \param finished true, if this rank has no more lines
+  /// \return true, if all ranks have finished
+  bool round(bool finished) {
+    std::string&                       data = buffers[active];
+    const std::array<std::uint64_t, 2> mine{data.size(), finished ? 1u : 0u};
+    std::vector<std::uint64_t>         all(2 * std::size_t(numranks));
+
+    MPI_Allgather(mine.data(), 2, MPI_UINT64_T, all.data(), 2, MPI_UINT64_T,
+                  MPI_COMM_WORLD);
+
+    std::uint64_t offset  = base;
+    std::uint64_t total   = 0;
+    bool          allDone = true;
+
+    for (int r = 0; r < numranks; ++r) {
+      if (r < rank) offset += all[2 * r];
+
+      total += all[2 * r];
+      allDone = allDone && (all[2 * r + 1] != 0);
+    }
+
+    check(MPI_File_iwrite_at_all(file, MPI_Offset(offset), data.data(),
+                                 int(data.size()), MPI_CHAR,
+                                 &requests[active]),
+          "write failed");
+
+    base += total;
+    active = 1 - active;
+    wait(requests[active]);
+    buffers[active].clear();
+    sink.target = &buffers[active];
+
+    return allDone;
+  }
+
+  std::size_t                limit;
+  MPI_File                   file     = MPI_FILE_NULL;
+  int                        rank     = 0;
+  int                        numranks = 1;
+  std::size_t                active   = 0;
+  std::uint64_t              base     = 0;  ///< bytes of the previous rounds
+  std::array<std::string, 2> buffers;
+  std::array<MPI_Request, 2> requests{MPI_REQUEST_NULL, MPI_REQUEST_NULL};
+  string_sink                sink;
+  std::ostream               out;
+};
+
+}  // namespace experimental
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+/// how the pages of a datastore are brought into memory after it is
+///   opened. Metall maps the datastore files, thus without a hint the
+///   first scan takes a page fault per page, in the order the rows are
+///   visited.
+/// \details
+///   - lazy: no hint; pages are read on first access (the default).
+///   - prefault: the structures that every access reads first (the row
+///     locators and the cached selections) are read ahead
+///     (MADV_WILLNEED), so that the kernel fetches them asynchronously
+///     while the method starts up.
+///   - random: as prefault, and the rest of the datastore is marked
+///     MADV_RANDOM, which disables the readahead of the kernel. Suits
+///     point lookups and short heads on file systems with expensive
+///     readahead (e.g., Lustre).
+///   The modes are hints; failing madvise calls are ignored.
+namespace experimental {
+
+enum class page_in_mode : std::uint8_t { lazy, prefault, random };
+
+/// returns the page_in_mode named \ref name
+inline page_in_mode to_page_in_mode(std::string_view name) {
+  if (name == "lazy") return page_in_mode::lazy;
+  if (name == "prefault") return page_in_mode::prefault;
+  if (name == "random") return page_in_mode::random;
+
+  throw std::invalid_argument{"unknown page-in mode: " + std::string(name)};
+}
+
+/// gives \ref advice for the pages that overlap [\ref addr, \ref addr +
+///   \ref bytes)
+inline void advise_pages(const void* addr, std::size_t bytes, int advice) {
+  if ((addr == nullptr) || (bytes == 0)) return;
+
+  static const std::uintptr_t pagesize = ::sysconf(_SC_PAGESIZE);
+
+  const std::uintptr_t beg     = reinterpret_cast<std::uintptr_t>(addr);
+  const std::uintptr_t pagebeg = beg - (beg % pagesize);
+
+  ::madvise(reinterpret_cast<void*>(pagebeg), beg + bytes - pagebeg, advice);
+}
+
+}  // namespace experimental
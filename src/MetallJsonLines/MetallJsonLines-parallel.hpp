@@ -0,0 +1,76 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Thread-parallel scans of the local rows of a rank.
+/// \details
+///   the read-only scans (count, hist, and the filter evaluation) of a rank
+///   can use several threads, e.g., when few ranks run on a node with many
+///   cores. The work is split into chunks of CHUNK_ROWS items, which the
+///   threads claim from a shared counter; a thread that finishes its chunks
+///   early thus takes over the remaining ones. Each thread accumulates its
+///   own partial results, which the caller merges after the scan.
+///   The threads do not communicate: ygm is only called by the main thread.
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace experimental {
+
+/// the number of items that a thread claims at once
+static constexpr std::size_t CHUNK_ROWS = 4096;
+
+/// calls fn(thread, beg, lim) for the chunks [beg, lim) of [0, numItems)
+///   on up to \ref numThreads threads (including the calling thread).
+/// \details
+///   thread is in [0, numThreads), and fn is called by one thread at a time
+///   for the same value of thread. The first exception that fn throws is
+///   rethrown after all threads have finished.
+template <class Fn>
+void parallel_chunks(std::size_t numItems, std::size_t numThreads, Fn fn) {
+  const std::size_t numChunks = (numItems + CHUNK_ROWS - 1) / CHUNK_ROWS;
+
+  numThreads = std::max<std::size_t>(1, std::min(numThreads, numChunks));
+
+  std::atomic<std::size_t> next{0};
+  std::exception_ptr       error;
+  std::mutex               errorMutex;
+
+  auto work = [&](std::size_t thread) -> void {
+    try {
+      for (std::size_t chunk = next.fetch_add(1); chunk < numChunks;
+           chunk             = next.fetch_add(1)) {
+        const std::size_t beg = chunk * CHUNK_ROWS;
+
+        fn(thread, beg, std::min(numItems, beg + CHUNK_ROWS));
+      }
+    } catch (...) {
+      std::lock_guard<std::mutex> lock{errorMutex};
+
+      if (!error) error = std::current_exception();
+
+      // the other threads stop after their current chunk
+      next.store(numChunks);
+    }
+  };
+
+  std::vector<std::thread> threads;
+
+  for (std::size_t t = 1; t < numThreads; ++t) threads.emplace_back(work, t);
+
+  work(0);
+
+  for (std::thread& thread : threads) thread.join();
+
+  if (error) std::rethrow_exception(error);
+}
+
+}  // namespace experimental
@@ -0,0 +1,265 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/writer.h>
+#include <parquet/exception.h>
+
+#include "json_bento/box.hpp"
+
+namespace experimental {
+
+/// writes JSON rows as typed columns into a Parquet file.
+///   the column types are inferred from the rows (see add_sample), thus
+///   rows are visited twice: once to infer the schema, and once to write.
+/// \details
+///   a column holds booleans, int64, uint64, double, or strings. A column
+///   whose values have different types holds doubles if all values are
+///   numbers, and the values' JSON text otherwise; arrays and objects are
+///   also written as JSON text. Missing and null values are written as null.
+class parquet_row_writer {
+ public:
+  /// \param columns the columns to write; if empty, all keys of the rows
+  ///        passed to add_sample are written (in order of appearance).
+  explicit parquet_row_writer(std::vector<std::string> columns)
+      : projected(!columns.empty()) {
+    for (std::string& col : columns) add_column(std::move(col));
+  }
+
+  /// updates the column types with a row; must be called for every row
+  ///   before open.
+  template <class Accessor>
+  void add_sample(const Accessor& row) {
+    if (!row.is_object()) return;
+
+    const auto obj = row.as_object();
+
+    if (projected) {
+      for (column_info& col : cols)
+        if (const auto val = obj.if_contains(col.name))
+          col.kind = join(col.kind, kind_of(*val));
+
+      return;
+    }
+
+    for (const auto& el : obj) {
+      const std::string_view key = el.key();
+      auto                   pos = colidx.find(std::string(key));
+
+      if (pos == colidx.end()) pos = add_column(std::string(key));
+
+      column_info& col = cols[pos->second];
+
+      col.kind = join(col.kind, kind_of(el.value()));
+    }
+  }
+
+  /// creates the file at \ref path;
+  ///   rows are buffered and written in row groups of \ref rowgroupsize.
+  void open(const std::string& path, std::size_t rowgroupsize) {
+    arrow::FieldVector fields;
+
+    for (column_info& col : cols) {
+      col.builder = make_builder(col.kind);
+      fields.emplace_back(arrow::field(col.name, col.builder->type()));
+    }
+
+    schema    = arrow::schema(std::move(fields));
+    groupsize = std::max<std::size_t>(rowgroupsize, 1);
+
+    std::shared_ptr<arrow::io::FileOutputStream> outfile;
+
+    PARQUET_ASSIGN_OR_THROW(outfile, arrow::io::FileOutputStream::Open(path));
+    PARQUET_ASSIGN_OR_THROW(
+        writer, parquet::arrow::FileWriter::Open(
+                    *schema, arrow::default_memory_pool(), std::move(outfile),
+                    parquet::default_writer_properties()));
+  }
+
+  /// appends a row; non-object rows are written as all-null rows.
+  template <class Accessor>
+  void write(const Accessor& row) {
+    if (!row.is_object()) {
+      for (column_info& col : cols) check(col.builder->AppendNull());
+    } else {
+      const auto obj = row.as_object();
+
+      for (column_info& col : cols) {
+        if (const auto val = obj.if_contains(col.name))
+          append(col, *val);
+        else
+          check(col.builder->AppendNull());
+      }
+    }
+
+    if (++buffered == groupsize) flush();
+  }
+
+  /// writes the buffered rows and closes the file
+  void close() {
+    flush();
+    check(writer->Close());
+  }
+
+  /// returns the number of the written columns
+  std::size_t num_columns() const { return cols.size(); }
+
+ private:
+  /// types of column values
+  enum class value_kind : std::uint8_t {
+    none,  // only null values
+    boolean,
+    int64,
+    uint64,
+    real,
+    string,
+    json  // mixed types, arrays, or objects
+  };
+
+  struct column_info {
+    std::string                           name;
+    value_kind                            kind = value_kind::none;
+    std::unique_ptr<arrow::ArrayBuilder> builder;
+  };
+
+  static void check(const arrow::Status& status) {
+    PARQUET_THROW_NOT_OK(status);
+  }
+
+  template <class Accessor>
+  static value_kind kind_of(const Accessor& val) {
+    if (val.is_null()) return value_kind::none;
+    if (val.is_bool()) return value_kind::boolean;
+    if (val.is_int64()) return value_kind::int64;
+    if (val.is_uint64()) return value_kind::uint64;
+    if (val.is_double()) return value_kind::real;
+    if (val.is_string()) return value_kind::string;
+
+    return value_kind::json;
+  }
+
+  static bool is_numeric(value_kind kind) {
+    return kind == value_kind::int64 || kind == value_kind::uint64 ||
+           kind == value_kind::real;
+  }
+
+  static value_kind join(value_kind lhs, value_kind rhs) {
+    if (lhs == rhs || rhs == value_kind::none) return lhs;
+    if (lhs == value_kind::none) return rhs;
+    if (is_numeric(lhs) && is_numeric(rhs)) {
+      // int64 and uint64 values do not fit into one of the two
+      return value_kind::real;
+    }
+
+    return value_kind::json;
+  }
+
+  static std::unique_ptr<arrow::ArrayBuilder> make_builder(value_kind kind) {
+    switch (kind) {
+      case value_kind::boolean:
+        return std::make_unique<arrow::BooleanBuilder>();
+      case value_kind::int64:
+        return std::make_unique<arrow::Int64Builder>();
+      case value_kind::uint64:
+        return std::make_unique<arrow::UInt64Builder>();
+      case value_kind::real:
+        return std::make_unique<arrow::DoubleBuilder>();
+      default:;  // none, string, json
+    }
+
+    return std::make_unique<arrow::StringBuilder>();
+  }
+
+  template <class Accessor>
+  static double to_double(const Accessor& val) {
+    if (val.is_int64()) return double(val.as_int64());
+    if (val.is_uint64()) return double(val.as_uint64());
+
+    return val.as_double();
+  }
+
+  template <class Accessor>
+  void append(column_info& col, const Accessor& val) {
+    arrow::ArrayBuilder& builder = *col.builder;
+
+    if (val.is_null()) return check(builder.AppendNull());
+
+    switch (col.kind) {
+      case value_kind::boolean:
+        return check(
+            static_cast<arrow::BooleanBuilder&>(builder).Append(val.as_bool()));
+      case value_kind::int64:
+        return check(
+            static_cast<arrow::Int64Builder&>(builder).Append(val.as_int64()));
+      case value_kind::uint64:
+        return check(static_cast<arrow::UInt64Builder&>(builder).Append(
+            val.as_uint64()));
+      case value_kind::real:
+        return check(static_cast<arrow::DoubleBuilder&>(builder).Append(
+            to_double(val)));
+      case value_kind::string: {
+        const std::string_view str = val.as_string().str_view();
+
+        return check(static_cast<arrow::StringBuilder&>(builder).Append(
+            str.data(), str.size()));
+      }
+      default:;
+    }
+
+    const std::string txt =
+        boost::json::serialize(json_bento::value_to<boost::json::value>(val));
+
+    check(static_cast<arrow::StringBuilder&>(builder).Append(txt));
+  }
+
+  /// writes the buffered rows as a row group
+  void flush() {
+    if (buffered == 0) return;
+
+    arrow::ArrayVector arrays;
+
+    for (column_info& col : cols) {
+      std::shared_ptr<arrow::Array> arr;
+
+      check(col.builder->Finish(&arr));
+      arrays.emplace_back(std::move(arr));
+    }
+
+    const std::shared_ptr<arrow::Table> table =
+        arrow::Table::Make(schema, arrays, buffered);
+
+    check(writer->WriteTable(*table, buffered));
+    buffered = 0;
+  }
+
+  std::unordered_map<std::string, std::size_t>::iterator add_column(
+      std::string name) {
+    auto [pos, fresh] = colidx.try_emplace(name, cols.size());
+
+    if (fresh) cols.push_back(column_info{std::move(name)});
+
+    return pos;
+  }
+
+  bool                                         projected;
+  std::vector<column_info>                     cols;
+  std::unordered_map<std::string, std::size_t> colidx;
+  std::shared_ptr<arrow::Schema>               schema;
+  std::unique_ptr<parquet::arrow::FileWriter>  writer;
+  std::size_t                                  groupsize = 0;
+  std::size_t                                  buffered  = 0;
+};
+
+}  // namespace experimental
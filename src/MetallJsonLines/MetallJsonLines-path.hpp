@@ -0,0 +1,136 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines.hpp"
+
+namespace experimental {
+
+/// a variable name that may refer to a nested field (e.g.,
+///   `user.profile.country`), split into its segments once.
+/// \details
+///   a dotted name is first looked up as a key of the object; if it is not
+///   a key, its first segment selects a nested object, in which the
+///   remaining path is looked up in the same way. The keys of all levels
+///   are resolved into key locators when the path is evaluated for the
+///   first time, thus an evaluation is a fixed sequence of locator lookups.
+///   A missing or non-object intermediate value yields no value.
+class key_path {
+ public:
+  using accessor_type        = metall_json_lines::accessor_type;
+  using object_accessor_type = accessor_type::object_accessor;
+
+  explicit key_path(std::string_view path)
+      : fullpath(path), locators(std::make_shared<key_locators>()) {
+    for (std::size_t pos = 0;;) {
+      const std::size_t dot = path.find('.', pos);
+
+      if (dot == std::string_view::npos) {
+        levels.push_back(level{std::string(path.substr(pos)), std::string()});
+        break;
+      }
+
+      levels.push_back(level{std::string(path.substr(pos)),
+                             std::string(path.substr(pos, dot - pos))});
+      pos = dot + 1;
+    }
+  }
+
+  std::string_view name() const { return fullpath; }
+
+  /// returns the value at the path in \ref obj; nullopt if there is none
+  std::optional<accessor_type> operator()(
+      const object_accessor_type& obj) const {
+    std::call_once(locators->resolved, [this, &obj]() -> void {
+      for (const level& lvl : levels) {
+        locators->suffixes.push_back(obj.locate_key(lvl.suffix));
+        locators->selectors.push_back(obj.locate_key(lvl.selector));
+      }
+    });
+
+    return lookup(obj, 0);
+  }
+
+ private:
+  /// the keys at depth i: the remaining path and its first segment
+  struct level {
+    std::string suffix;
+    std::string selector;  ///< empty for the last segment
+  };
+
+  /// key locators of the levels, resolved on first use
+  struct key_locators {
+    std::once_flag                       resolved;
+    std::vector<json_bento::key_locator> suffixes;
+    std::vector<json_bento::key_locator> selectors;
+  };
+
+  std::optional<accessor_type> lookup(const object_accessor_type& obj,
+                                      std::size_t                 depth) const {
+    if (auto val = obj.if_contains(locators->suffixes[depth])) {
+      CXX_LIKELY;
+      return val;
+    }
+
+    if (depth + 1 == levels.size()) return std::nullopt;
+
+    const auto sub = obj.if_contains(locators->selectors[depth]);
+
+    if (!sub || !sub->is_object()) return std::nullopt;
+
+    return lookup(sub->as_object(), depth + 1);
+  }
+
+  std::string                   fullpath;
+  std::vector<level>            levels;
+  std::shared_ptr<key_locators> locators;
+};
+
+/// the compiled paths of a rule's variables
+class key_path_set {
+ public:
+  key_path_set() = default;
+
+  /// compiles the variables in \ref vars
+  /// \param selectPrefix the prefix of the variable names (e.g., "keys")
+  key_path_set(const std::vector<boost::json::string>& vars,
+               std::string_view                        selectPrefix) {
+    const std::size_t selLen = selectPrefix.size() + 1;
+
+    for (const boost::json::string& var : vars) {
+      if (var.size() <= selLen) continue;
+
+      const std::string_view col{var.data() + selLen, var.size() - selLen};
+
+      if (!find(col)) paths.emplace_back(col);
+    }
+  }
+
+  /// compiles the columns \ref cols
+  explicit key_path_set(const std::vector<std::string>& cols) {
+    for (const std::string& col : cols) paths.emplace_back(col);
+  }
+
+  /// returns the path of \ref col, or nullptr
+  const key_path* find(std::string_view col) const {
+    for (const key_path& path : paths)
+      if (path.name() == col) return &path;
+
+    return nullptr;
+  }
+
+  std::vector<key_path>::const_iterator begin() const { return paths.begin(); }
+  std::vector<key_path>::const_iterator end() const { return paths.end(); }
+
+ private:
+  std::vector<key_path> paths;
+};
+
+}  // namespace experimental
@@ -0,0 +1,203 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Hardware performance counters of the hot loops (scans, appends,
+///        and join-key hashing).
+/// \details
+///   the counters are only compiled in with METALLDATA_USE_PERF_COUNTERS
+///   (CMake option of the same name); otherwise, perf_scope is empty and
+///   its members do nothing. The counters are read with perf_event_open
+///   on Linux; if the kernel does not permit them (see
+///   /proc/sys/kernel/perf_event_paranoid), the regions count rows only.
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#if METALLDATA_USE_PERF_COUNTERS
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif /* METALLDATA_USE_PERF_COUNTERS */
+
+namespace experimental {
+
+/// the instrumented code regions
+enum class perf_region {
+  scan,    ///< _for_all_selected: the filter evaluation of the rows
+  append,  ///< parsing and appending rows (e.g., read_json)
+  hash,    ///< hashing the join keys of merge
+  NUM_REGIONS
+};
+
+static constexpr std::size_t NUM_PERF_REGIONS =
+    std::size_t(perf_region::NUM_REGIONS);
+
+inline const char* to_string(perf_region region) {
+  static constexpr std::array<const char*, NUM_PERF_REGIONS> names = {
+      "scan", "append", "hash"};
+
+  return names[std::size_t(region)];
+}
+
+/// the accumulated events and rows of a region
+struct perf_totals {
+  /// the hardware events
+  enum event { cycles, instructions, llc_misses, tlb_misses, NUM_EVENTS };
+
+  using event_counts = std::array<std::uint64_t, NUM_EVENTS>;
+
+  static const char* event_name(event ev) {
+    static constexpr std::array<const char*, NUM_EVENTS> names = {
+        "cycles", "instructions", "llc_misses", "tlb_misses"};
+
+    return names[ev];
+  }
+
+  event_counts  events = {};
+  std::uint64_t rows   = 0;
+};
+
+#if METALLDATA_USE_PERF_COUNTERS
+
+/// the counters of this process (the events of threads that the calling
+///   thread starts are included when the threads end).
+class perf_counters {
+ public:
+  static perf_counters& instance() {
+    static perf_counters counters;
+
+    return counters;
+  }
+
+  /// true, if the kernel permits the counters
+  bool available() const { return fds[0] >= 0; }
+
+  /// returns the current values of the events
+  perf_totals::event_counts read_events() const {
+    perf_totals::event_counts res = {};
+
+    for (int i = 0; i < perf_totals::NUM_EVENTS; ++i) {
+      std::uint64_t val = 0;
+
+      if ((fds[i] >= 0) && (::read(fds[i], &val, sizeof(val)) == sizeof(val)))
+        res[i] = val;
+    }
+
+    return res;
+  }
+
+  perf_totals& totals(perf_region region) {
+    return regions[std::size_t(region)];
+  }
+
+  perf_counters(const perf_counters&)            = delete;
+  perf_counters& operator=(const perf_counters&) = delete;
+
+ private:
+  perf_counters() {
+    fds.fill(-1);
+
+    // read misses of a cache (PERF_TYPE_HW_CACHE)
+    static constexpr std::uint64_t cacheMiss =
+        (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+
+    using event_type = std::pair<std::uint32_t, std::uint64_t>;
+
+    const std::array<event_type, perf_totals::NUM_EVENTS> events = {
+        {{PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+         {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+         {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | cacheMiss},
+         {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | cacheMiss}}};
+
+    for (int i = 0; i < perf_totals::NUM_EVENTS; ++i) {
+      perf_event_attr attr;
+
+      std::memset(&attr, 0, sizeof(attr));
+      attr.size           = sizeof(attr);
+      attr.type           = events[i].first;
+      attr.config         = events[i].second;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv     = 1;
+      attr.inherit        = 1;
+
+      fds[i] = int(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+
+      // without cycles, the other events are not reported either
+      if (fds[0] < 0) return;
+    }
+  }
+
+  ~perf_counters() {
+    for (int fd : fds)
+      if (fd >= 0) ::close(fd);
+  }
+
+  std::array<int, perf_totals::NUM_EVENTS>  fds;
+  std::array<perf_totals, NUM_PERF_REGIONS> regions;
+};
+
+/// adds the events of its lifetime and the rows that it was told about to
+///   a region. Nested scopes count their events in each region.
+class perf_scope {
+ public:
+  explicit perf_scope(perf_region region)
+      : counters(perf_counters::instance()),
+        region(region),
+        start(counters.read_events()) {}
+
+  ~perf_scope() {
+    const perf_totals::event_counts end = counters.read_events();
+    perf_totals&                    tot = counters.totals(region);
+
+    for (int i = 0; i < perf_totals::NUM_EVENTS; ++i)
+      tot.events[i] += end[i] - start[i];
+
+    tot.rows += numrows;
+  }
+
+  perf_scope(const perf_scope&)            = delete;
+  perf_scope& operator=(const perf_scope&) = delete;
+
+  /// adds \ref n to the rows of the scope
+  void rows(std::uint64_t n) { numrows += n; }
+
+ private:
+  perf_counters&            counters;
+  perf_region               region;
+  perf_totals::event_counts start;
+  std::uint64_t             numrows = 0;
+};
+
+/// returns the totals of \ref region
+inline perf_totals perf_region_totals(perf_region region) {
+  return perf_counters::instance().totals(region);
+}
+
+/// true, if the counters are compiled in and the kernel permits them
+inline bool perf_counters_available() {
+  return perf_counters::instance().available();
+}
+
+#else /* !METALLDATA_USE_PERF_COUNTERS */
+
+class perf_scope {
+ public:
+  explicit perf_scope(perf_region) {}
+
+  void rows(std::uint64_t) {}
+};
+
+inline perf_totals perf_region_totals(perf_region) { return {}; }
+
+inline bool perf_counters_available() { return false; }
+
+#endif /* METALLDATA_USE_PERF_COUNTERS */
+
+}  // namespace experimental
@@ -0,0 +1,594 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include <boost/json.hpp>
+
+#include <ygm/comm.hpp>
+
+#include "MetallJsonLines-perf.hpp"
+
+namespace experimental {
+
+namespace detail {
+template <class Op>
+struct elementwise {
+  std::vector<double> operator()(const std::vector<double>& lhs,
+                                 const std::vector<double>& rhs) const {
+    std::vector<double> res{lhs};
+
+    for (std::size_t i = 0; i < rhs.size(); ++i) res[i] = Op{}(res[i], rhs[i]);
+
+    return res;
+  }
+};
+
+struct min_op {
+  double operator()(double lhs, double rhs) const {
+    return std::min(lhs, rhs);
+  }
+};
+
+struct max_op {
+  double operator()(double lhs, double rhs) const {
+    return std::max(lhs, rhs);
+  }
+};
+}  // namespace detail
+
+/// reduces each of \ref values over all ranks to {"min", "max", "sum",
+///   "mean", "skew"}, where skew is max / mean. Collective.
+inline std::vector<boost::json::object> rank_statistics(
+    ygm::comm& world, const std::vector<double>& values) {
+  const std::vector<double> mins =
+      world.all_reduce(values, detail::elementwise<detail::min_op>{});
+  const std::vector<double> maxs =
+      world.all_reduce(values, detail::elementwise<detail::max_op>{});
+  const std::vector<double> sums =
+      world.all_reduce(values, detail::elementwise<std::plus<double> >{});
+  const int numranks = world.size();
+
+  std::vector<boost::json::object> res;
+
+  for (std::size_t i = 0; i < values.size(); ++i) {
+    const double        mean = sums[i] / numranks;
+    boost::json::object stats;
+
+    stats["min"]  = mins[i];
+    stats["max"]  = maxs[i];
+    stats["sum"]  = sums[i];
+    stats["mean"] = mean;
+    stats["skew"] = mean > 0 ? maxs[i] / mean : 1.0;
+    res.emplace_back(std::move(stats));
+  }
+
+  return res;
+}
+
+/// a runtime profile of a collective operation (e.g., merge): the wall time
+///   of each phase and per-rank counters (e.g., bytes sent). A
+///   default-constructed profile is disabled and records nothing, so that
+///   the operations can record unconditionally.
+/// \details
+///   all ranks must run the same phases in the same order. report() reduces
+///   each time and counter over all ranks to its minimum, maximum, sum,
+///   mean, and skew (max / mean), which shows the load imbalance.
+class run_profile {
+ public:
+  /// creates a disabled profile
+  run_profile() = default;
+
+  /// creates an enabled profile with the counters \ref counterNames
+  explicit run_profile(std::vector<std::string> counterNames)
+      : on(true),
+        counterNames(std::move(counterNames)),
+        counters(this->counterNames.size(), 0) {}
+
+  bool enabled() const { return on; }
+
+  /// ends the running phase and starts phase \ref name; the times of
+  ///   phases with the same name are added.
+  void phase(std::string name) {
+    if (!on) return;
+
+    stop();
+
+    auto pos = std::find_if(phases.begin(), phases.end(),
+                            [&name](const auto& el) -> bool {
+                              return el.first == name;
+                            });
+
+    if (pos == phases.end()) pos = phases.emplace(phases.end(), name, 0.0);
+
+    current = pos - phases.begin();
+    start   = clock::now();
+  }
+
+  /// ends the running phase
+  void stop() {
+    if (!on || (current < 0)) return;
+
+    const std::chrono::duration<double> elapsed = clock::now() - start;
+
+    phases[current].second += elapsed.count();
+    current = -1;
+  }
+
+  /// adds \ref n to counter \ref idx
+  template <class Counter>
+  void count(Counter idx, std::uint64_t n = 1) {
+    if (on) counters[std::size_t(idx)] += n;
+  }
+
+  /// returns the counter \ref idx of this rank
+  template <class Counter>
+  std::uint64_t counter(Counter idx) const {
+    return on ? counters[std::size_t(idx)] : 0;
+  }
+
+  /// returns {"ranks": n, "phases": {<name>: stats}, "counters":
+  ///   {<name>: stats}}, where stats is {"min", "max", "sum", "mean",
+  ///   "skew"} over all ranks; the phase times are in seconds.
+  ///   Ends the running phase. Collective.
+  boost::json::object report(ygm::comm& world) {
+    boost::json::object res;
+
+    if (!on) return res;
+
+    stop();
+
+    std::vector<double> values;
+
+    for (const auto& el : phases) values.push_back(el.second);
+    for (std::uint64_t el : counters) values.push_back(double(el));
+
+    std::vector<boost::json::object> stats = rank_statistics(world, values);
+    boost::json::object              phaseStats;
+    boost::json::object              counterStats;
+    std::size_t                      i = 0;
+
+    for (const auto& el : phases) phaseStats[el.first] = std::move(stats[i++]);
+    for (const std::string& name : counterNames)
+      counterStats[name] = std::move(stats[i++]);
+
+    res["ranks"]    = world.size();
+    res["phases"]   = std::move(phaseStats);
+    res["counters"] = std::move(counterStats);
+    return res;
+  }
+
+ private:
+  using clock = std::chrono::steady_clock;
+
+  bool                                        on = false;
+  std::vector<std::pair<std::string, double> > phases;
+  std::vector<std::string>                    counterNames;
+  std::vector<std::uint64_t>                  counters;
+  int                                         current = -1;
+  clock::time_point                           start;
+};
+
+/// the point-to-point messages that this process sent; counted by the
+///   MPI interposers of MetallJsonLines-mpicount.hpp, if the executable
+///   includes them.
+struct mpi_send_counters {
+  static inline std::atomic<std::uint64_t> messages{0};
+  static inline std::atomic<std::uint64_t> bytes{0};
+};
+
+/// the rows that the scans of this process visited and selected; counted
+///   once per scan.
+struct scan_counters {
+  static inline std::atomic<std::uint64_t> scanned{0};
+  static inline std::atomic<std::uint64_t> selected{0};
+
+  static void add(std::uint64_t numScanned, std::uint64_t numSelected) {
+    scanned.fetch_add(numScanned, std::memory_order_relaxed);
+    selected.fetch_add(numSelected, std::memory_order_relaxed);
+  }
+};
+
+/// the instrumentation of a method (e.g., a clippy executable): each phase
+///   records the wall time, the time waiting in barriers, the CPU time, the
+///   page faults, the rows scanned and selected, the MPI messages and bytes
+///   sent, and the growth of the tracked datastore.
+/// \details
+///   a default constructed profile is disabled and records nothing.
+///   All ranks must run the same phases in the same order, as report
+///   reduces the phases elementwise.
+class method_profile {
+ public:
+  /// the metrics of a phase
+  enum metric {
+    seconds,
+    wait_seconds,
+    cpu_seconds,
+    minor_faults,
+    major_faults,
+    rows_scanned,
+    rows_selected,
+    messages_sent,
+    bytes_sent,
+    segment_growth,
+    NUM_METRICS
+  };
+
+  /// ends the phase at the end of a scope
+  class scoped_phase {
+   public:
+    scoped_phase(method_profile& prof, std::string name) : prof(prof) {
+      prof.phase(std::move(name));
+    }
+
+    ~scoped_phase() { prof.stop(); }
+
+    scoped_phase(const scoped_phase&)            = delete;
+    scoped_phase& operator=(const scoped_phase&) = delete;
+
+   private:
+    method_profile& prof;
+  };
+
+  method_profile() = default;
+
+  /// the number of ranks that load_report lists as worst
+  static constexpr std::size_t NUM_WORST_RANKS = 3;
+
+  /// creates an enabled profile
+  explicit method_profile(ygm::comm& world) : comm(&world) {
+    for (std::size_t i = 0; i < NUM_PERF_REGIONS; ++i)
+      perfStart[i] = perf_region_totals(perf_region(i));
+  }
+
+  bool enabled() const { return comm != nullptr; }
+
+  /// the segment growth of later phases is the growth of the files of the
+  ///   datastore at \ref location; i.e., each rank sees the growth of all
+  ///   ranks' segments.
+  void track(std::string_view location) {
+    if (!enabled()) return;
+
+    tracked = location;
+    if (current >= 0) start.segment = datastore_size();
+  }
+
+  /// ends the running phase and starts (or continues) phase \ref name
+  void phase(std::string name) {
+    if (!enabled()) return;
+
+    stop();
+
+    auto pos = std::find_if(phases.begin(), phases.end(),
+                            [&name](const auto& el) -> bool {
+                              return el.first == name;
+                            });
+
+    if (pos == phases.end())
+      pos = phases.emplace(phases.end(), std::move(name), metrics{});
+
+    current = pos - phases.begin();
+    start   = sample();
+  }
+
+  /// returns a guard that runs phase \ref name until the end of the scope
+  scoped_phase scoped(std::string name) {
+    return scoped_phase{*this, std::move(name)};
+  }
+
+  /// ends the running phase
+  void stop() {
+    if (!enabled() || (current < 0)) return;
+
+    const snapshot end  = sample();
+    metrics&       vals = phases[current].second;
+
+    const std::chrono::duration<double> elapsed = end.time - start.time;
+
+    vals[seconds]        += elapsed.count();
+    vals[cpu_seconds]    += end.cpu - start.cpu;
+    vals[minor_faults]   += double(end.minorFaults - start.minorFaults);
+    vals[major_faults]   += double(end.majorFaults - start.majorFaults);
+    vals[rows_scanned]   += double(end.scanned - start.scanned);
+    vals[rows_selected]  += double(end.selected - start.selected);
+    vals[messages_sent]  += double(end.messages - start.messages);
+    vals[bytes_sent]     += double(end.bytes - start.bytes);
+    vals[segment_growth] += double(end.segment) - double(start.segment);
+    current = -1;
+  }
+
+  /// a barrier, whose time counts as wait time of the running phase. Only
+  ///   synchronizes, if the profile is disabled. Collective.
+  void barrier(ygm::comm& world) {
+    if (!enabled() || (current < 0)) return world.barrier();
+
+    const clock::time_point waitStart = clock::now();
+
+    world.barrier();
+    phases[current].second[wait_seconds] +=
+        std::chrono::duration<double>(clock::now() - waitStart).count();
+  }
+
+  /// returns {"ranks": n, "phases": {<name>: {<metric>: stats}}, "load":
+  ///   load_report()}, where stats is {"min", "max", "sum", "mean", "skew"}
+  ///   over all ranks; with METALLDATA_USE_PERF_COUNTERS, it also has
+  ///   "hardware": hardware_report(). Ends the running phase. Collective.
+  boost::json::object report() {
+    boost::json::object res;
+
+    if (!enabled()) return res;
+
+    stop();
+
+    std::vector<double> values;
+
+    for (const auto& el : phases)
+      values.insert(values.end(), el.second.begin(), el.second.end());
+
+    std::vector<boost::json::object> stats = rank_statistics(*comm, values);
+    boost::json::object              phaseStats;
+    std::size_t                      i = 0;
+
+    for (const auto& el : phases) {
+      boost::json::object metricStats;
+
+      for (int m = 0; m < NUM_METRICS; ++m)
+        metricStats[metric_name(metric(m))] = std::move(stats[i++]);
+
+      phaseStats[el.first] = std::move(metricStats);
+    }
+
+    res["ranks"]  = comm->size();
+    res["phases"] = std::move(phaseStats);
+    res["load"]   = load_report();
+
+#if METALLDATA_USE_PERF_COUNTERS
+    res["hardware"] = hardware_report();
+#endif /* METALLDATA_USE_PERF_COUNTERS */
+
+    return res;
+  }
+
+  /// returns {"available": bool, <region>: {"rows", <event>_per_row,
+  ///   "ipc"}} of the hardware events that the instrumented regions (see
+  ///   perf_region) counted since the profile was created, summed over
+  ///   all ranks. available is false, if a rank could not open the
+  ///   counters. Collective.
+  boost::json::object hardware_report() {
+    static constexpr std::size_t NUM_VALUES = perf_totals::NUM_EVENTS + 1;
+
+    boost::json::object res;
+
+    if (!enabled()) return res;
+
+    std::vector<double> values(NUM_PERF_REGIONS * NUM_VALUES + 1, 0.0);
+
+    for (std::size_t i = 0; i < NUM_PERF_REGIONS; ++i) {
+      const perf_totals tot = perf_region_totals(perf_region(i));
+      double*           out = values.data() + i * NUM_VALUES;
+
+      for (int ev = 0; ev < perf_totals::NUM_EVENTS; ++ev)
+        out[ev] = double(tot.events[ev] - perfStart[i].events[ev]);
+
+      out[perf_totals::NUM_EVENTS] = double(tot.rows - perfStart[i].rows);
+    }
+
+    // the number of ranks without counters
+    values.back() = perf_counters_available() ? 0.0 : 1.0;
+
+    values =
+        comm->all_reduce(values, detail::elementwise<std::plus<double> >{});
+
+    res["available"] = values.back() == 0.0;
+
+    for (std::size_t i = 0; i < NUM_PERF_REGIONS; ++i) {
+      const double*       in   = values.data() + i * NUM_VALUES;
+      const double        rows = in[perf_totals::NUM_EVENTS];
+      boost::json::object stats;
+
+      stats["rows"] = rows;
+
+      for (int ev = 0; ev < perf_totals::NUM_EVENTS; ++ev)
+        stats[std::string(perf_totals::event_name(perf_totals::event(ev))) +
+              "_per_row"] = rows > 0 ? in[ev] / rows : 0.0;
+
+      stats["ipc"] = in[perf_totals::cycles] > 0
+                         ? in[perf_totals::instructions] /
+                               in[perf_totals::cycles]
+                         : 0.0;
+
+      res[to_string(perf_region(i))] = std::move(stats);
+    }
+
+    return res;
+  }
+
+  /// returns {<metric>: {"min", "median", "max", "worst": [{"rank",
+  ///   "value"}]}} of the ranks' totals over all phases, where worst lists
+  ///   the NUM_WORST_RANKS ranks with the largest values (the stragglers).
+  ///   The metrics are busy_seconds (i.e., not waiting in barrier),
+  ///   wait_seconds, rows_scanned, rows_selected, messages_sent, and
+  ///   bytes_sent. Collective.
+  boost::json::object load_report() {
+    static constexpr std::array<metric, 5> counted = {
+        wait_seconds, rows_scanned, rows_selected, messages_sent, bytes_sent};
+    static constexpr std::size_t NUM_LOAD = counted.size() + 1;
+
+    boost::json::object res;
+
+    if (!enabled()) return res;
+
+    metrics totals{};
+
+    for (const auto& el : phases)
+      for (int m = 0; m < NUM_METRICS; ++m) totals[m] += el.second[m];
+
+    // each rank sets its own slots, thus the sum gathers all ranks' values
+    const std::size_t   numranks = comm->size();
+    const std::size_t   rank     = comm->rank();
+    std::vector<double> slots(numranks * NUM_LOAD, 0.0);
+
+    slots[rank * NUM_LOAD] = totals[seconds] - totals[wait_seconds];
+    for (std::size_t i = 0; i < counted.size(); ++i)
+      slots[rank * NUM_LOAD + i + 1] = totals[counted[i]];
+
+    slots = comm->all_reduce(slots,
+                             detail::elementwise<std::plus<double> >{});
+
+    for (std::size_t i = 0; i < NUM_LOAD; ++i) {
+      std::vector<std::pair<double, std::size_t> > byRank;
+
+      for (std::size_t r = 0; r < numranks; ++r)
+        byRank.emplace_back(slots[r * NUM_LOAD + i], r);
+
+      // the largest values first; ties are ordered by rank
+      std::sort(byRank.begin(), byRank.end(),
+                [](const auto& lhs, const auto& rhs) -> bool {
+                  return lhs.first != rhs.first ? lhs.first > rhs.first
+                                                : lhs.second < rhs.second;
+                });
+
+      boost::json::object stats;
+      boost::json::array  worst;
+
+      for (std::size_t r = 0; r < std::min(numranks, NUM_WORST_RANKS); ++r) {
+        boost::json::object straggler;
+
+        straggler["rank"]  = byRank[r].second;
+        straggler["value"] = byRank[r].first;
+        worst.emplace_back(std::move(straggler));
+      }
+
+      stats["min"]    = byRank.back().first;
+      stats["median"] = byRank[numranks / 2].first;
+      stats["max"]    = byRank.front().first;
+      stats["worst"]  = std::move(worst);
+
+      res[i == 0 ? "busy_seconds" : metric_name(counted[i - 1])] =
+          std::move(stats);
+    }
+
+    return res;
+  }
+
+  static const char* metric_name(metric m) {
+    static constexpr std::array<const char*, NUM_METRICS> names = {
+        "seconds",      "wait_seconds",  "cpu_seconds",   "minor_faults",
+        "major_faults", "rows_scanned",  "rows_selected", "messages_sent",
+        "bytes_sent",   "segment_growth"};
+
+    return names[m];
+  }
+
+ private:
+  using clock   = std::chrono::steady_clock;
+  using metrics = std::array<double, NUM_METRICS>;
+
+  struct snapshot {
+    clock::time_point time;
+    double            cpu         = 0;
+    std::uint64_t     minorFaults = 0;
+    std::uint64_t     majorFaults = 0;
+    std::uint64_t     scanned     = 0;
+    std::uint64_t     selected    = 0;
+    std::uint64_t     messages    = 0;
+    std::uint64_t     bytes       = 0;
+    std::uint64_t     segment     = 0;
+  };
+
+  snapshot sample() const {
+    snapshot res;
+    rusage   usage{};
+
+    getrusage(RUSAGE_SELF, &usage);
+
+    res.time        = clock::now();
+    res.cpu         = seconds_of(usage.ru_utime) + seconds_of(usage.ru_stime);
+    res.minorFaults = usage.ru_minflt;
+    res.majorFaults = usage.ru_majflt;
+    res.scanned     = scan_counters::scanned.load();
+    res.selected    = scan_counters::selected.load();
+    res.messages    = mpi_send_counters::messages.load();
+    res.bytes       = mpi_send_counters::bytes.load();
+    res.segment     = datastore_size();
+    return res;
+  }
+
+  /// returns the size of the files of the tracked datastore; Metall
+  ///   extends the files of a segment as the segment grows.
+  std::uint64_t datastore_size() const {
+    namespace fs = std::filesystem;
+
+    if (tracked.empty()) return 0;
+
+    std::error_code ec;
+    std::uint64_t   res = 0;
+
+    for (fs::recursive_directory_iterator it{tracked, ec}, lim; it != lim;
+         it.increment(ec)) {
+      if (ec) break;
+      if (!it->is_regular_file(ec)) continue;
+
+      const std::uintmax_t size = it->file_size(ec);
+
+      if (!ec) res += size;
+    }
+
+    return res;
+  }
+
+  static double seconds_of(const timeval& tv) {
+    return double(tv.tv_sec) + double(tv.tv_usec) / 1e6;
+  }
+
+  ygm::comm*                                   comm = nullptr;
+  std::vector<std::pair<std::string, metrics>> phases;
+  std::string                                  tracked;
+  int                                          current = -1;
+  snapshot                                     start;
+  std::array<perf_totals, NUM_PERF_REGIONS>    perfStart;
+};
+
+/// returns the approximate payload bytes of a message argument: types with
+///   byte_size(), ranges (e.g., vectors and strings), and fixed-size values.
+template <class T>
+std::size_t message_size_of(const T& arg) {
+  if constexpr (requires { arg.byte_size(); }) {
+    return arg.byte_size();
+  } else if constexpr (requires { arg.begin(); arg.size(); }) {
+    using value_type = std::decay_t<decltype(*arg.begin())>;
+
+    if constexpr (std::is_arithmetic_v<value_type>) {
+      return arg.size() * sizeof(value_type);
+    } else {
+      std::size_t res = 0;
+
+      for (const auto& el : arg) res += message_size_of(el);
+
+      return res;
+    }
+  } else {
+    return sizeof(T);
+  }
+}
+
+/// returns the approximate payload bytes of a message with \ref args
+template <class... Args>
+std::size_t message_size(const Args&... args) {
+  return (std::size_t(0) + ... + message_size_of(args));
+}
+
+}  // namespace experimental
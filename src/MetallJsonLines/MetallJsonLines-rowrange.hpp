@@ -0,0 +1,209 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string_view>
+
+#include <boost/json.hpp>
+
+/// row ranges of selections: a rule that compares the special columns
+///   rowid and mpiid with integer constants (e.g., `rowid == 7`, or
+///   `mpiid == 2 and 10 <= rowid < 20`) can only select the local rows in
+///   a range; a rank whose mpiid does not match selects none. The scans
+///   then visit only the rows in the range, instead of evaluating the
+///   rule for every row.
+/// \details
+///   the range is a bound: the rows in the range are still filtered by
+///   the rule. Only comparisons in the top-level conjunction are
+///   considered; other parts of the rule (e.g., a disjunction) do not
+///   narrow the range.
+namespace experimental {
+
+/// the local rows [beg, lim) that a selection can select
+struct row_range {
+  static constexpr std::size_t all = std::numeric_limits<std::size_t>::max();
+
+  std::size_t beg = 0;
+  std::size_t lim = all;
+
+  /// returns true, if no row is in the range
+  bool empty() const { return beg >= lim; }
+
+  /// returns true, if the range does not restrict the rows
+  bool unbounded() const { return (beg == 0) && (lim == all); }
+
+  /// restricts *this to the rows that are also in \ref other
+  void intersect(const row_range& other) {
+    beg = std::max(beg, other.beg);
+    lim = std::min(lim, other.lim);
+  }
+
+  /// returns the rows that \ref rule can select on rank \ref rank
+  /// \param rule          a json_logic rule
+  /// \param selectPrefix  the prefix of the variable names (e.g., "keys")
+  /// \param rank          the rank of the rows
+  static row_range of_rule(const boost::json::value& rule,
+                           std::string_view selectPrefix, std::size_t rank) {
+    row_range res;
+
+    res.add_rule(rule, selectPrefix, rank);
+    return res;
+  }
+
+ private:
+  /// returns v, if val is {"var": "<selectPrefix>.<v>"}
+  static std::optional<std::string_view> column_name(
+      const boost::json::value& val, std::string_view selectPrefix) {
+    const boost::json::object* obj = val.if_object();
+
+    if (!obj || (obj->size() != 1)) return std::nullopt;
+
+    const boost::json::value* var = obj->if_contains("var");
+
+    if (!var || !var->is_string()) return std::nullopt;
+
+    const std::string_view name{var->as_string().data(),
+                                var->as_string().size()};
+
+    if ((name.size() <= selectPrefix.size()) ||
+        (name.substr(0, selectPrefix.size()) != selectPrefix) ||
+        (name[selectPrefix.size()] != '.'))
+      return std::nullopt;
+
+    return name.substr(selectPrefix.size() + 1);
+  }
+
+  /// returns \ref val if it is an integer; saturates large unsigned
+  ///   integers.
+  static std::optional<std::int64_t> integer(const boost::json::value& val) {
+    if (val.is_int64()) return val.as_int64();
+
+    if (val.is_uint64())
+      return std::int64_t(std::min<std::uint64_t>(
+          val.as_uint64(), std::numeric_limits<std::int64_t>::max()));
+
+    return std::nullopt;
+  }
+
+  /// returns the comparison with swapped operands
+  static std::string_view flip(std::string_view op) {
+    if (op == "<") return ">";
+    if (op == "<=") return ">=";
+    if (op == ">") return "<";
+    if (op == ">=") return "<=";
+
+    return op;
+  }
+
+  /// returns the first row after \ref c; 0 if \ref c is negative
+  static std::size_t after(std::int64_t c) {
+    return c < 0 ? 0 : std::size_t(c) + 1;
+  }
+
+  /// returns \ref c, or 0
+  static std::size_t at_least_zero(std::int64_t c) {
+    return c < 0 ? 0 : std::size_t(c);
+  }
+
+  /// narrows *this by the comparison `col op c`
+  void add_comparison(std::string_view col, std::string_view op,
+                      std::int64_t c, std::size_t rank) {
+    if (col == "rowid") {
+      if ((op == "==") || (op == "===")) {
+        intersect({at_least_zero(c), after(c)});
+      } else if (op == "<") {
+        intersect({0, at_least_zero(c)});
+      } else if (op == "<=") {
+        intersect({0, after(c)});
+      } else if (op == ">") {
+        intersect({after(c), all});
+      } else if (op == ">=") {
+        intersect({at_least_zero(c), all});
+      }
+
+      return;
+    }
+
+    if (col != "mpiid") return;
+
+    const std::int64_t r        = std::int64_t(rank);
+    bool               selected = true;
+
+    if ((op == "==") || (op == "==="))
+      selected = (r == c);
+    else if ((op == "!=") || (op == "!=="))
+      selected = (r != c);
+    else if (op == "<")
+      selected = (r < c);
+    else if (op == "<=")
+      selected = (r <= c);
+    else if (op == ">")
+      selected = (r > c);
+    else if (op == ">=")
+      selected = (r >= c);
+
+    if (!selected) intersect({0, 0});
+  }
+
+  void add_rule(const boost::json::value& rule, std::string_view selectPrefix,
+                std::size_t rank) {
+    const boost::json::object* obj = rule.if_object();
+
+    if (!obj || (obj->size() != 1)) return;
+
+    const auto&               op   = *obj->begin();
+    const boost::json::array* args = op.value().if_array();
+
+    if (!args) return;
+
+    const std::string_view opname{op.key().data(), op.key().size()};
+
+    if (opname == "and") {
+      for (const boost::json::value& sub : *args)
+        add_rule(sub, selectPrefix, rank);
+
+      return;
+    }
+
+    if (args->size() == 2) {
+      if (const auto col = column_name((*args)[0], selectPrefix)) {
+        if (const auto c = integer((*args)[1]))
+          add_comparison(*col, opname, *c, rank);
+      } else if (const auto col = column_name((*args)[1], selectPrefix)) {
+        if (const auto c = integer((*args)[0]))
+          add_comparison(*col, flip(opname), *c, rank);
+      }
+
+      return;
+    }
+
+    // between: {"<": [a, {"var": ...}, b]} (or "<=")
+    if ((args->size() == 3) && ((opname == "<") || (opname == "<="))) {
+      const auto col = column_name((*args)[1], selectPrefix);
+      const auto lo  = integer((*args)[0]);
+      const auto hi  = integer((*args)[2]);
+
+      if (!col || !lo || !hi) return;
+
+      add_comparison(*col, flip(opname), *lo, rank);
+      add_comparison(*col, opname, *hi, rank);
+    }
+  }
+};
+
+/// a filter that passes the row range of a selection to the container:
+///   metall_json_lines::filter recognizes it and restricts its scans to
+///   the range. It selects all rows; the selection's rule still filters
+///   the rows in the range.
+struct row_range_hint {
+  row_range range;
+
+  template <class Accessor>
+  bool operator()(std::size_t, const Accessor&) const {
+    return true;
+  }
+};
+
+}  // namespace experimental
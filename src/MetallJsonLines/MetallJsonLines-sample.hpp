@@ -0,0 +1,162 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Row samples and the estimates computed from them.
+
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines-hash.hpp"
+
+namespace experimental {
+
+/// returns the sampling priority of \ref row on a rank; the priorities are
+///   uniform and only depend on the seed, the rank, and the row, so that a
+///   sample with the same seed has the same rows.
+inline std::uint64_t sample_priority(std::uint64_t seed, std::size_t rank,
+                                     std::size_t row) {
+  const std::uint64_t salt = mix_hash64(seed ^ mix_hash64(rank + 1));
+
+  return mix_hash64(salt ^ mix_hash64(row));
+}
+
+/// a filter that accepts each row with probability \ref fraction
+///   (Bernoulli sampling)
+struct bernoulli_sample {
+  bernoulli_sample(double fraction, std::uint64_t seed, std::size_t rank)
+      : seed(seed), rank(rank) {
+    if (!(fraction > 0.0) || (fraction > 1.0))
+      throw std::invalid_argument{"sample fraction must be in (0, 1]"};
+
+    // priorities are uniform in [0, 2^64)
+    threshold = (fraction == 1.0) ? UINT64_MAX
+                                  : std::uint64_t(std::ldexp(fraction, 64));
+  }
+
+  template <class Accessor>
+  bool operator()(std::size_t row, const Accessor&) const {
+    return sample_priority(seed, rank, row) <= threshold;
+  }
+
+  std::uint64_t seed;
+  std::size_t   rank;
+  std::uint64_t threshold = 0;
+};
+
+/// a filter that accepts a fixed set of rows, e.g., chosen by
+///   reservoir_sample_rows
+struct row_set_sample {
+  template <class Accessor>
+  bool operator()(std::size_t row, const Accessor&) const {
+    return std::binary_search(rows->begin(), rows->end(), row);
+  }
+
+  std::shared_ptr<const std::vector<std::size_t>> rows;
+};
+
+/// returns the (sorted) \ref k rows of [0, \ref n) with the smallest
+///   priorities; i.e., a uniform sample without replacement. The rows are
+///   chosen in one pass with a heap of \ref k entries, as by reservoir
+///   sampling with random priorities.
+inline std::vector<std::size_t> reservoir_sample_rows(std::size_t   n,
+                                                      std::size_t   k,
+                                                      std::uint64_t seed,
+                                                      std::size_t   rank) {
+  using entry = std::pair<std::uint64_t, std::size_t>;
+
+  std::priority_queue<entry> heap;  // the largest priority on top
+
+  for (std::size_t row = 0; (row < n) && (k > 0); ++row) {
+    const entry el{sample_priority(seed, rank, row), row};
+
+    if (heap.size() < k)
+      heap.push(el);
+    else if (el < heap.top()) {
+      heap.pop();
+      heap.push(el);
+    }
+  }
+
+  std::vector<std::size_t> res;
+
+  res.reserve(heap.size());
+  for (; !heap.empty(); heap.pop()) res.push_back(heap.top().second);
+
+  std::sort(res.begin(), res.end());
+  return res;
+}
+
+/// the sample that the rows of a metall_json_lines are restricted to
+struct row_sample {
+  enum method { bernoulli, reservoir };
+
+  method        kind     = bernoulli;
+  double        fraction = 1.0;  ///< probability, or sampled / total rows
+  std::size_t   sampled  = 0;    ///< rows in a reservoir sample
+  std::size_t   total    = 0;    ///< rows of all ranks
+  std::uint64_t seed     = 0;
+};
+
+/// an estimate with a 95% confidence interval
+struct sample_estimate {
+  double value = 0;
+  double low   = 0;
+  double high  = 0;
+
+  boost::json::object asJson() const {
+    boost::json::object res;
+
+    res["estimate"] = value;
+    res["low"]      = low;
+    res["high"]     = high;
+
+    return res;
+  }
+};
+
+/// returns the estimated number of rows in the population, for \ref k rows
+///   of \ref sample.
+/// \details
+///   for a Bernoulli sample, the estimate is k / p with the variance
+///   k (1 - p) / p^2; for a reservoir sample of n of N rows, it is
+///   N k / n with the (hypergeometric) variance
+///   N^2 p'(1 - p') / n * (N - n) / (N - 1), where p' = k / n.
+inline sample_estimate estimate_count(std::size_t k, const row_sample& sample) {
+  static constexpr double Z95 = 1.96;
+
+  const double hits = double(k);
+  double       est  = hits;
+  double       se   = 0;
+
+  if (sample.kind == row_sample::bernoulli) {
+    const double p = sample.fraction;
+
+    est = hits / p;
+    se  = std::sqrt(hits * (1.0 - p)) / p;
+  } else if (sample.sampled > 0) {
+    const double n    = double(sample.sampled);
+    const double N    = double(sample.total);
+    const double phat = hits / n;
+    const double fpc  = (N > 1) ? (N - n) / (N - 1) : 0.0;
+
+    est = N * phat;
+    se  = N * std::sqrt(phat * (1.0 - phat) / n * fpc);
+  }
+
+  // the population has at least the rows that were seen
+  return {est, std::max(hits, est - Z95 * se), est + Z95 * se};
+}
+
+}  // namespace experimental
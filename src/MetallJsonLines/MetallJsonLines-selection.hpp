@@ -0,0 +1,166 @@
+#pragma once
+
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+namespace experimental {
+
+/// calls fn(i) for each bit i that is set in \ref bits, in order,
+///   until fn returns false.
+template <class Bitmap, class Fn>
+void for_all_set_bits(const Bitmap& bits, Fn fn) {
+  for (std::size_t w = 0; w < bits.size(); ++w) {
+    for (std::uint64_t word = bits[w]; word != 0; word &= word - 1) {
+      if (!fn(w * 64 + std::countr_zero(word))) return;
+    }
+  }
+}
+
+/// thrown when a stored selection (see metall_json_lines::store_selection)
+///   is needed, but its bitmap is no longer cached; a stored selection
+///   cannot be recomputed from predicates.
+struct stale_selection : std::runtime_error {
+  explicit stale_selection(const std::string& name)
+      : std::runtime_error("stored selection is no longer available "
+                           "(recompute it): " + name) {}
+};
+
+/// persistent cache of selection results (i.e., which rows pass a filter).
+///   a selection is stored as a bitmap, keyed by the normalized JSON of the
+///   selection's predicates. One cache is stored next to each local
+///   container in the same Metall datastore, thus selections survive
+///   across clippy calls.
+/// \details
+///   a bitmap is only valid for the number of rows that it was computed for;
+///   any mutator of the container must call clear().
+///   the cache keeps at most max_entries bitmaps; the least recently used
+///   one is evicted first.
+template <class Alloc>
+class selection_cache {
+ public:
+  using allocator_type = Alloc;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+
+ public:
+  using bitmap_type =
+      metall::container::vector<std::uint64_t, other_allocator<std::uint64_t>>;
+
+  static constexpr std::size_t max_entries = 16;
+
+  explicit selection_cache(const allocator_type& alloc) : entries(alloc) {}
+
+  /// returns the bitmap of the selection \ref key if it was computed for a
+  ///   container with \ref numrows rows; nullptr otherwise.
+  const bitmap_type* find(std::string_view key, std::size_t numrows) {
+    for (entry& el : entries) {
+      if (std::string_view(el.key.data(), el.key.size()) != key) continue;
+
+      if (el.numrows != numrows) return nullptr;
+
+      el.lastuse = ++clock;
+      return &el.bits;
+    }
+
+    return nullptr;
+  }
+
+  /// as find, but does not record the use, thus it does not write to a
+  ///   read-only datastore.
+  const bitmap_type* lookup(std::string_view key, std::size_t numrows) const {
+    for (const entry& el : entries) {
+      if (std::string_view(el.key.data(), el.key.size()) != key) continue;
+
+      return (el.numrows == numrows) ? &el.bits : nullptr;
+    }
+
+    return nullptr;
+  }
+
+  /// stores the bitmap of the selection \ref key; bit i is set iff
+  ///   row i is selected.
+  void store(std::string_view key, std::size_t numrows,
+             const std::vector<std::uint64_t>& bits) {
+    entry* pos = nullptr;
+
+    for (entry& el : entries)
+      if (std::string_view(el.key.data(), el.key.size()) == key) pos = &el;
+
+    if (!pos && entries.size() >= max_entries) {
+      pos = &entries.front();
+
+      for (entry& el : entries)
+        if (el.lastuse < pos->lastuse) pos = &el;
+
+      pos->key.assign(key.data(), key.size());
+    }
+
+    if (!pos) {
+      entries.emplace_back(key, entries.get_allocator());
+      pos = &entries.back();
+    }
+
+    pos->numrows = numrows;
+    pos->lastuse = ++clock;
+    pos->bits.assign(bits.begin(), bits.end());
+  }
+
+  /// drops all cached selections
+  void clear() {
+    entries.clear();
+    ++clears;
+  }
+
+  /// returns the number of calls to clear(), i.e., of modifications of the
+  ///   container; lets other persistent indices detect that they are stale.
+  std::uint64_t modifications() const { return clears; }
+
+  /// returns the number of cached selections
+  std::size_t size() const { return entries.size(); }
+
+  /// calls \ref fn with the bitmap of each cached selection
+  template <class Fn>
+  void for_all_bitmaps(Fn fn) const {
+    for (const entry& el : entries) fn(el.bits);
+  }
+
+  /// sets row \ref i in a bitmap under construction
+  static void set(std::vector<std::uint64_t>& bits, std::size_t i) {
+    if (bits.size() <= i / 64) bits.resize(i / 64 + 1, 0);
+
+    bits[i / 64] |= std::uint64_t(1) << (i % 64);
+  }
+
+ private:
+  struct entry {
+    entry(std::string_view k, const allocator_type& alloc)
+        : key(k.data(), k.size(), alloc), bits(alloc) {}
+
+    string_type   key;
+    std::uint64_t numrows = 0;
+    std::uint64_t lastuse = 0;
+    bitmap_type   bits;
+  };
+
+  metall::container::vector<entry, other_allocator<entry>> entries;
+  std::uint64_t                                             clock  = 0;
+  std::uint64_t                                             clears = 0;
+};
+
+}  // namespace experimental
@@ -0,0 +1,293 @@
+#pragma once
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <mpi.h>
+
+#include <boost/json.hpp>
+
+#include <ygm/comm.hpp>
+
+#include "MetallJsonLines-datastore.hpp"
+
+/// a resident service that runs methods of a single MPI job: rank 0 reads
+///   method calls from a Unix domain socket and broadcasts them; all ranks
+///   run the method, whose datastores stay open across calls. This saves
+///   the job launch and the datastore open of a standalone method.
+/// \details
+///   the protocol has one JSON object per line. A request
+///   {"method": <executable name>, "input": <clippy input>} runs the method
+///   as if the executable was called with the input on stdin, and the
+///   response {"returncode": int, "stdout": <output>} carries what the
+///   executable would have returned and written. Requests on one
+///   connection run in order; connections are served one at a time.
+///   The control methods are
+///   - "__release__", which closes all datastores (e.g., before another job
+///     writes to one), and
+///   - "__shutdown__", which closes the datastores and ends the service.
+///   Other jobs must not open a datastore while the service holds it.
+namespace experimental {
+
+/// a method: the ygm_main of an executable
+using service_method = std::function<int(ygm::comm&, int, char**)>;
+
+/// the methods of a service by executable name
+using service_table = std::map<std::string, service_method, std::less<>>;
+
+static constexpr const char* const SERVICE_RELEASE  = "__release__";
+static constexpr const char* const SERVICE_SHUTDOWN = "__shutdown__";
+
+namespace {
+/// broadcasts \ref str from rank 0. Collective.
+inline void broadcast_string(std::string& str) {
+  unsigned long long len = str.size();
+
+  MPI_Bcast(&len, 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD);
+  str.resize(len);
+  MPI_Bcast(str.data(), int(len), MPI_CHAR, 0, MPI_COMM_WORLD);
+}
+
+/// returns the response of a failed request
+inline boost::json::object error_response(std::string_view msg) {
+  boost::json::object res;
+
+  res["returncode"] = 1;
+  res["stdout"]     = msg;
+  return res;
+}
+
+/// the connection of rank 0 to the clients
+class service_socket {
+ public:
+  explicit service_socket(const std::string& path) : path(path) {
+    sockaddr_un addr;
+
+    if (path.size() >= sizeof(addr.sun_path))
+      throw std::invalid_argument{"socket path is too long: " + path};
+
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+    ::unlink(path.c_str());
+    listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if ((listener < 0) ||
+        (::bind(listener, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) <
+         0) ||
+        (::listen(listener, 8) < 0))
+      throw std::runtime_error{"unable to listen on socket " + path + ": " +
+                               std::strerror(errno)};
+  }
+
+  ~service_socket() {
+    if (client >= 0) ::close(client);
+    if (listener >= 0) ::close(listener);
+
+    ::unlink(path.c_str());
+  }
+
+  service_socket(const service_socket&)            = delete;
+  service_socket& operator=(const service_socket&) = delete;
+
+  /// returns the next request line; waits for a client if none is
+  ///   connected.
+  std::string next_request() {
+    for (;;) {
+      if (client < 0) {
+        client = ::accept(listener, nullptr, nullptr);
+        pending.clear();
+
+        if (client < 0) continue;
+      }
+
+      if (const std::size_t eol = pending.find('\n');
+          eol != std::string::npos) {
+        std::string line = pending.substr(0, eol);
+
+        pending.erase(0, eol + 1);
+        return line;
+      }
+
+      char          buf[1 << 16];
+      const ssize_t len = ::recv(client, buf, sizeof(buf), 0);
+
+      if (len > 0) {
+        pending.append(buf, len);
+        continue;
+      }
+
+      // the client closed the connection
+      ::close(client);
+      client = -1;
+    }
+  }
+
+  /// sends \ref response as a line to the client
+  void respond(const boost::json::object& response) {
+    if (client < 0) return;
+
+    const std::string line = boost::json::serialize(response) + "\n";
+    std::size_t       sent = 0;
+
+    while (sent < line.size()) {
+      const ssize_t len =
+          ::send(client, line.data() + sent, line.size() - sent, MSG_NOSIGNAL);
+
+      if (len <= 0) return;
+
+      sent += len;
+    }
+  }
+
+ private:
+  std::string path;
+  std::string pending;  ///< the received data after the last request
+  int         listener = -1;
+  int         client   = -1;
+};
+
+/// redirects std::cin and std::cout of rank 0 while a method runs
+class stdio_redirect {
+ public:
+  stdio_redirect(std::string input, bool active)
+      : in(std::move(input)), on(active) {
+    if (!on) return;
+
+    cinbuf  = std::cin.rdbuf(in.rdbuf());
+    coutbuf = std::cout.rdbuf(out.rdbuf());
+  }
+
+  ~stdio_redirect() {
+    if (!on) return;
+
+    std::cout.flush();
+    std::cin.rdbuf(cinbuf);
+    std::cout.rdbuf(coutbuf);
+  }
+
+  std::string output() const { return out.str(); }
+
+ private:
+  std::istringstream in;
+  std::ostringstream out;
+  bool               on;
+  std::streambuf*    cinbuf  = nullptr;
+  std::streambuf*    coutbuf = nullptr;
+};
+}  // namespace
+
+/// runs the service loop on socket \ref path until a client sends
+///   "__shutdown__". Collective.
+/// \return 0 after a shutdown
+inline int serve(ygm::comm& world, const service_table& methods,
+                 const std::string& path) {
+  const bool                      isMainRank = world.rank() == 0;
+  std::unique_ptr<service_socket> sock;
+  datastore_cache                 cache;
+
+  if (isMainRank) sock = std::make_unique<service_socket>(path);
+
+  datastore_cache::install(&cache);
+
+  struct uninstall_cache {
+    ~uninstall_cache() { datastore_cache::install(nullptr); }
+  } uninstallGuard;
+
+  for (;;) {
+    std::string method;
+    std::string input;
+
+    if (isMainRank) {
+      const std::string line = sock->next_request();
+
+      try {
+        boost::json::object request = boost::json::parse(line).as_object();
+
+        method = request.at("method").as_string();
+
+        if (method.empty()) throw std::invalid_argument{"no method"};
+
+        if (const boost::json::value* val = request.if_contains("input"))
+          input = boost::json::serialize(*val);
+      } catch (const std::exception& err) {
+        sock->respond(error_response(std::string{"invalid request: "} +
+                                     err.what()));
+        method.clear();
+      }
+    }
+
+    broadcast_string(method);
+
+    if (method.empty()) continue;
+
+    boost::json::object response;
+
+    if ((method == SERVICE_RELEASE) || (method == SERVICE_SHUTDOWN)) {
+      cache.clear();
+      world.barrier();
+      response["returncode"] = 0;
+      response["stdout"]     = "";
+
+      if (isMainRank) sock->respond(response);
+      if (method == SERVICE_SHUTDOWN) return 0;
+
+      continue;
+    }
+
+    broadcast_string(input);
+
+    auto pos = methods.find(method);
+
+    if (pos == methods.end()) {
+      if (isMainRank)
+        sock->respond(error_response("unknown method: " + method));
+
+      continue;
+    }
+
+    int         returncode = 1;
+    std::string output;
+
+    {
+      stdio_redirect    stdio{std::move(input), isMainRank};
+      std::vector<char> name(method.begin(), method.end());
+
+      name.push_back('\0');
+
+      char* argv[] = {name.data(), nullptr};
+
+      try {
+        returncode = pos->second(world, 1, argv);
+      } catch (const std::exception& err) {
+        std::cout << err.what();
+      }
+
+      output = stdio.output();
+    }
+
+    // the datastores stay open, but their state is written back
+    cache.flush();
+    world.barrier();
+
+    if (isMainRank) {
+      response["returncode"] = returncode;
+      response["stdout"]     = std::move(output);
+      sock->respond(response);
+    }
+  }
+}
+
+}  // namespace experimental
@@ -0,0 +1,452 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Ordering of the selected rows: top n rows, and a distributed sort
+///        into another container.
+/// \details
+///   the rows are ordered by the values of the sort columns; within a
+///   column, booleans come before numbers (compared numerically), numbers
+///   before strings (compared lexicographically), and strings before
+///   arrays and objects (compared by their JSON text). Missing and null
+///   values come last, in either direction. Rows with equal sort keys keep
+///   the order of the container (rank, then row), thus the sort is stable
+///   and deterministic.
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+
+#include "MetallJsonLines.hpp"
+
+namespace experimental {
+
+/// a column of the sort order and its direction
+struct sort_column {
+  std::string name;
+  bool        ascending = true;
+};
+
+/// the number of sort keys that a rank contributes to the splitters
+static constexpr std::size_t SORT_VALUES_SAMPLES_PER_RANK = 256;
+
+/// the number of rows that are sent to a rank at once
+static constexpr std::size_t SORT_VALUES_BATCH_SIZE = 4096;
+
+/// a row and its sort key
+struct sort_entry {
+  boost::json::value key;  ///< the array of the sort column values
+  std::uint64_t      rank = 0;
+  std::uint64_t      row  = 0;
+  boost::json::value val;  ///< the (projected) row, once it is sent
+
+  template <class Archive>
+  void serialize(Archive& ar) {
+    ar(key, rank, row, val);
+  }
+};
+
+namespace {
+
+/// the position of a value's kind in the sort order
+inline int sort_class(const boost::json::value& val) {
+  if (val.is_bool()) return 0;
+  if (val.is_number()) return 1;
+  if (val.is_string()) return 2;
+  if (val.is_null()) return 4;
+
+  return 3;
+}
+
+/// compares two numbers of any representation
+inline int compare_numbers(const boost::json::value& lhs,
+                           const boost::json::value& rhs) {
+  if (lhs.is_int64() && rhs.is_int64())
+    return (lhs.as_int64() > rhs.as_int64()) -
+           (lhs.as_int64() < rhs.as_int64());
+
+  if (lhs.is_uint64() && rhs.is_uint64())
+    return (lhs.as_uint64() > rhs.as_uint64()) -
+           (lhs.as_uint64() < rhs.as_uint64());
+
+  // a negative int64 is smaller than any uint64
+  if (lhs.is_int64() && rhs.is_uint64() && (lhs.as_int64() < 0)) return -1;
+  if (lhs.is_uint64() && rhs.is_int64() && (rhs.as_int64() < 0)) return 1;
+
+  if (!lhs.is_double() && !rhs.is_double()) {
+    const std::uint64_t x = lhs.to_number<std::uint64_t>();
+    const std::uint64_t y = rhs.to_number<std::uint64_t>();
+
+    return (x > y) - (x < y);
+  }
+
+  const double x = lhs.to_number<double>();
+  const double y = rhs.to_number<double>();
+
+  return (x > y) - (x < y);
+}
+
+/// compares two values of the same sort class
+inline int compare_sort_values(const boost::json::value& lhs,
+                               const boost::json::value& rhs) {
+  switch (sort_class(lhs)) {
+    case 0: return int(lhs.as_bool()) - int(rhs.as_bool());
+    case 1: return compare_numbers(lhs, rhs);
+    case 2: {
+      const boost::json::string& x = lhs.as_string();
+      const boost::json::string& y = rhs.as_string();
+
+      return std::string_view{x.data(), x.size()}.compare({y.data(), y.size()});
+    }
+    case 3:
+      return boost::json::serialize(lhs).compare(boost::json::serialize(rhs));
+    default: return 0;
+  }
+}
+
+}  // namespace
+
+/// the order of the rows
+class sort_order {
+ public:
+  explicit sort_order(std::vector<sort_column> cols)
+      : columns(std::move(cols)) {
+    if (columns.empty())
+      throw std::invalid_argument{"sort_values needs a sort column"};
+  }
+
+  /// returns the sort key of \ref row, the values of the sort columns
+  template <class Accessor>
+  boost::json::value key_of(const Accessor& row) const {
+    boost::json::array key;
+
+    key.reserve(columns.size());
+
+    for (const sort_column& col : columns) {
+      if (row.is_object()) {
+        if (const auto val = row.as_object().if_contains(col.name)) {
+          key.emplace_back(json_bento::value_to<boost::json::value>(*val));
+          continue;
+        }
+      }
+
+      key.emplace_back(nullptr);
+    }
+
+    return key;
+  }
+
+  /// returns true, if the row of \ref lhs comes before the row of \ref rhs
+  bool operator()(const sort_entry& lhs, const sort_entry& rhs) const {
+    const boost::json::array& lhsKey = lhs.key.as_array();
+    const boost::json::array& rhsKey = rhs.key.as_array();
+
+    for (std::size_t i = 0; i < columns.size(); ++i) {
+      const int lhsClass = sort_class(lhsKey[i]);
+      const int rhsClass = sort_class(rhsKey[i]);
+      int       res      = 0;
+
+      if (lhsClass != rhsClass) {
+        res = (lhsClass < rhsClass) ? -1 : 1;
+
+        // null stays last
+        if (!columns[i].ascending && (lhsClass != 4) && (rhsClass != 4))
+          res = -res;
+      } else {
+        res = compare_sort_values(lhsKey[i], rhsKey[i]);
+
+        if (!columns[i].ascending) res = -res;
+      }
+
+      if (res != 0) return res < 0;
+    }
+
+    if (lhs.rank != rhs.rank) return lhs.rank < rhs.rank;
+
+    return lhs.row < rhs.row;
+  }
+
+ private:
+  std::vector<sort_column> columns;
+};
+
+namespace {
+
+/// the state of a sort on each rank, accessed by message handlers
+struct sort_process_data {
+  std::vector<sort_entry>*    received  = nullptr;
+  std::vector<sort_entry>*    samples   = nullptr;  ///< on rank 0
+  std::vector<std::uint64_t>* sampled   = nullptr;  ///< rows per sample
+  std::vector<sort_entry>*    splitters = nullptr;
+};
+
+sort_process_data sortState;
+
+void store_sorted_entries(const std::vector<sort_entry>& entries) {
+  assert(sortState.received != nullptr);
+
+  sortState.received->insert(sortState.received->end(), entries.begin(),
+                             entries.end());
+}
+
+void store_sort_samples(const std::vector<sort_entry>& entries,
+                        std::uint64_t                  weight) {
+  assert(sortState.samples != nullptr);
+
+  sortState.samples->insert(sortState.samples->end(), entries.begin(),
+                            entries.end());
+  sortState.sampled->insert(sortState.sampled->end(), entries.size(), weight);
+}
+
+void store_sort_splitters(const std::vector<sort_entry>& splitters) {
+  assert(sortState.splitters != nullptr);
+
+  *sortState.splitters = splitters;
+}
+
+/// returns the sort entries of the selected local rows
+inline std::vector<sort_entry> local_sort_entries(
+    const metall_json_lines& lines, const sort_order& order) {
+  std::vector<sort_entry> entries;
+  const std::uint64_t     rank = lines.comm().rank();
+
+  lines.for_all_selected(
+      [&](std::size_t row, const metall_json_lines::accessor_type& val)
+          -> void {
+        entries.push_back(sort_entry{order.key_of(val), rank, row, nullptr});
+      });
+
+  return entries;
+}
+
+}  // namespace
+
+/// returns the first \ref numrows selected rows in \ref order on rank 0
+///   (empty on the other ranks).
+/// \details
+///   each rank keeps its best \ref numrows rows in a bounded heap, and
+///   rank 0 merges the candidates of all ranks. Only the candidates are
+///   projected and sent.
+inline boost::json::array top_rows(
+    const metall_json_lines& lines, const sort_order& order,
+    std::size_t numrows, metall_json_lines::metall_projector_type projector) {
+  ygm::comm&              world = lines.comm();
+  std::vector<sort_entry> received;
+
+  sortState = sort_process_data{&received};
+  world.cf_barrier();
+
+  if (numrows > 0) {
+    // the top of the heap is the last of the candidates
+    std::priority_queue<sort_entry, std::vector<sort_entry>, sort_order>
+                        heap{order};
+    const std::uint64_t rank = world.rank();
+
+    lines.for_all_selected(
+        [&](std::size_t row, const metall_json_lines::accessor_type& val)
+            -> void {
+          sort_entry entry{order.key_of(val), rank, row, nullptr};
+
+          if (heap.size() == numrows) {
+            if (!order(entry, heap.top())) return;
+
+            heap.pop();
+          }
+
+          entry.val = projector(val);
+          heap.push(std::move(entry));
+        });
+
+    std::vector<sort_entry> candidates;
+
+    candidates.reserve(heap.size());
+    for (; !heap.empty(); heap.pop()) candidates.push_back(heap.top());
+
+    if (world.rank() == 0)
+      store_sorted_entries(candidates);
+    else if (candidates.size())
+      world.async(
+          0,
+          [](const std::vector<sort_entry>& entries) -> void {
+            store_sorted_entries(entries);
+          },
+          candidates);
+  }
+
+  world.barrier();
+  sortState = sort_process_data{};
+
+  std::sort(received.begin(), received.end(), order);
+
+  if (received.size() > numrows) received.resize(numrows);
+
+  boost::json::array res;
+
+  for (sort_entry& entry : received) res.emplace_back(std::move(entry.val));
+
+  return res;
+}
+
+/// writes the selected rows of \ref lines in \ref order into \ref out;
+///   existing rows of \ref out are removed.
+/// \return the number of sorted rows (on all ranks)
+/// \details
+///   sample sort: each rank sorts the keys of its rows, and sends evenly
+///   spaced samples to rank 0, which chooses splitters of equal estimated
+///   weight. The ranks send their (projected) rows to the rank of their
+///   splitter range, which sorts and appends them. Thus, the rows of
+///   \ref out are ordered by rank, and by row within a rank, as head
+///   returns them. Because the row position breaks ties, many rows with the
+///   same key are split over several ranks.
+inline std::size_t sort_values(
+    metall_json_lines& out, const metall_json_lines& lines,
+    const sort_order&                       order,
+    metall_json_lines::metall_projector_type projector) {
+  ygm::comm&                 world = lines.comm();
+  const int                  numranks = world.size();
+  std::vector<sort_entry>    received;
+  std::vector<sort_entry>    samples;
+  std::vector<std::uint64_t> sampled;
+  std::vector<sort_entry>    splitters;
+
+  sortState = sort_process_data{&received, &samples, &sampled, &splitters};
+  world.cf_barrier();
+
+  // phase 1: sort the local keys and sample them
+  std::vector<sort_entry> entries = local_sort_entries(lines, order);
+
+  std::sort(entries.begin(), entries.end(), order);
+
+  {
+    const std::size_t len = entries.size();
+    const std::size_t num = std::min(len, SORT_VALUES_SAMPLES_PER_RANK);
+    std::vector<sort_entry> smpl;
+
+    smpl.reserve(num);
+    for (std::size_t i = 0; i < num; ++i)
+      smpl.push_back(entries[(i * len + len / 2) / num]);
+
+    // each sample stands for (about) len / num rows
+    const std::uint64_t weight = num ? (len + num - 1) / num : 0;
+
+    if (world.rank() == 0)
+      store_sort_samples(smpl, weight);
+    else if (num)
+      world.async(
+          0,
+          [](const std::vector<sort_entry>& s, std::uint64_t w) -> void {
+            store_sort_samples(s, w);
+          },
+          smpl, weight);
+  }
+
+  world.barrier();
+
+  // phase 2: rank 0 chooses the splitters
+  if (world.rank() == 0) {
+    std::vector<std::size_t> idx(samples.size());
+    std::uint64_t            total = 0;
+
+    for (std::size_t i = 0; i < idx.size(); ++i) {
+      idx[i] = i;
+      total += sampled[i];
+    }
+
+    std::sort(idx.begin(), idx.end(),
+              [&samples, &order](std::size_t lhs, std::size_t rhs) -> bool {
+                return order(samples[lhs], samples[rhs]);
+              });
+
+    std::vector<sort_entry> chosen;
+    std::uint64_t           cumulative = 0;
+
+    for (std::size_t i : idx) {
+      if (int(chosen.size()) + 1 >= numranks) break;
+
+      cumulative += sampled[i];
+
+      if (cumulative >= (chosen.size() + 1) * (total / numranks))
+        chosen.push_back(samples[i]);
+    }
+
+    for (int dest = 1; dest < numranks; ++dest)
+      world.async(
+          dest,
+          [](const std::vector<sort_entry>& s) -> void {
+            store_sort_splitters(s);
+          },
+          chosen);
+
+    splitters = std::move(chosen);
+  }
+
+  world.barrier();
+
+  // phase 3: send the rows to the ranks of their splitter ranges; the
+  //   entries are sorted, thus the destinations are ascending.
+  {
+    std::vector<sort_entry> batch;
+    int                     batchDest = 0;
+
+    auto flush = [&]() -> void {
+      if (batch.empty()) return;
+
+      if (batchDest == world.rank())
+        store_sorted_entries(batch);
+      else
+        world.async(
+            batchDest,
+            [](const std::vector<sort_entry>& entries) -> void {
+              store_sorted_entries(entries);
+            },
+            batch);
+
+      batch.clear();
+    };
+
+    for (sort_entry& entry : entries) {
+      const int dest = std::distance(
+          splitters.begin(),
+          std::upper_bound(splitters.begin(), splitters.end(), entry, order));
+
+      if ((dest != batchDest) || (batch.size() == SORT_VALUES_BATCH_SIZE)) {
+        flush();
+        batchDest = dest;
+      }
+
+      entry.val = projector(lines.at(entry.row));
+      batch.push_back(std::move(entry));
+    }
+
+    flush();
+    entries.clear();
+  }
+
+  world.barrier();
+  sortState = sort_process_data{};
+
+  // phase 4: sort and append the received rows
+  std::sort(received.begin(), received.end(), order);
+
+  out.clear();
+
+  for (const sort_entry& entry : received) out.append_local(entry.val);
+
+  return world.all_reduce_sum(received.size());
+}
+
+}  // namespace experimental
@@ -0,0 +1,446 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+namespace experimental {
+
+/// where and when records are spilled to scratch files
+struct spill_options {
+  /// bytes of DRAM per rank for buffered records; 0 keeps all records
+  ///   in memory.
+  std::size_t budget = 0;
+
+  /// directory of the scratch files; empty selects the system's temporary
+  ///   directory. Node-local storage (e.g., NVMe) works best.
+  std::string directory;
+
+  /// returns an equal share of the budget for one of \ref n users
+  spill_options share(std::size_t n) const {
+    return spill_options{budget / std::max<std::size_t>(n, 1), directory};
+  }
+};
+
+/// a scratch file that is removed when the object is destroyed
+class scratch_file {
+ public:
+  explicit scratch_file(const spill_options& opts) : path(unique_path(opts)) {}
+
+  ~scratch_file() {
+    std::error_code ec;
+
+    std::filesystem::remove(path, ec);
+  }
+
+  scratch_file(const scratch_file&)            = delete;
+  scratch_file& operator=(const scratch_file&) = delete;
+
+  const std::filesystem::path& name() const { return path; }
+
+ private:
+  static std::filesystem::path unique_path(const spill_options& opts) {
+    static std::uint64_t counter = 0;
+
+    std::filesystem::path dir = opts.directory.empty()
+                                    ? std::filesystem::temp_directory_path()
+                                    : std::filesystem::path(opts.directory);
+
+    return dir / ("metalldata-spill-" + std::to_string(::getpid()) + "-" +
+                  std::to_string(counter++) + ".bin");
+  }
+
+  std::filesystem::path path;
+};
+
+/// collects records and returns them in sorted order; when the buffered
+///   records exceed the memory budget, they are sorted and written to
+///   a scratch file (a run). The sorted order is produced by a k-way merge
+///   of the runs and the buffer, which reads each run in blocks.
+/// \tparam T a trivially copyable record
+template <class T, class Compare = std::less<T>>
+class external_sorter {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "records are written to scratch files as bytes");
+
+ public:
+  class cursor;
+
+  explicit external_sorter(spill_options opts = {}, Compare cmp = Compare{})
+      : options(std::move(opts)), compare(std::move(cmp)) {}
+
+  /// replaces the spill options; only valid when empty
+  void configure(spill_options opts) {
+    assert(empty());
+    options = std::move(opts);
+  }
+
+  template <class... Args>
+  void emplace_back(Args&&... args) {
+    buffer.emplace_back(std::forward<Args>(args)...);
+    ++numrecs;
+
+    if ((options.budget > 0) && (buffer.size() * sizeof(T) >= options.budget))
+      spill();
+  }
+
+  void push_back(const T& rec) { emplace_back(rec); }
+
+  /// returns the number of records
+  std::size_t size() const { return numrecs; }
+
+  bool empty() const { return numrecs == 0; }
+
+  /// returns the number of runs in scratch files
+  std::size_t num_runs() const { return runs.size(); }
+
+  /// removes all records and scratch files
+  void clear() {
+    std::vector<T>().swap(buffer);
+    runs.clear();
+    numrecs = 0;
+  }
+
+  /// sorts the buffered records and returns a cursor over all records in
+  ///   order. The sorter must not be modified while a cursor is in use.
+  cursor sorted() {
+    std::sort(buffer.begin(), buffer.end(), compare);
+
+    return cursor(*this);
+  }
+
+  /// a forward pass over the records of a sorter in order
+  class cursor {
+   public:
+    /// returns true, if all records have been visited
+    bool done() const { return heap.empty(); }
+
+    /// returns the current record
+    const T& front() const {
+      assert(!done());
+      return sources[heap.front()].front();
+    }
+
+    /// moves to the next record
+    void pop() {
+      assert(!done());
+
+      std::pop_heap(heap.begin(), heap.end(), heap_order());
+
+      source& src = sources[heap.back()];
+
+      if (src.advance())
+        std::push_heap(heap.begin(), heap.end(), heap_order());
+      else
+        heap.pop_back();
+    }
+
+   private:
+    /// a sorted sequence of records, either in memory or in a run file
+    struct source {
+      const T* beg = nullptr;
+      const T* lim = nullptr;
+
+      std::unique_ptr<std::ifstream> in;
+      std::vector<T>                 block;
+      std::size_t                    unread = 0;  ///< records in *in
+
+      const T& front() const { return *beg; }
+
+      /// returns false, if the source is exhausted
+      bool advance() {
+        if (++beg != lim) return true;
+
+        return refill();
+      }
+
+      bool refill() {
+        if (unread == 0) return false;
+
+        const std::size_t n = std::min(unread, block.size());
+
+        in->read(reinterpret_cast<char*>(block.data()), n * sizeof(T));
+
+        if (!*in) throw std::runtime_error{"unable to read a spill file"};
+
+        unread -= n;
+        beg = block.data();
+        lim = beg + n;
+        return true;
+      }
+    };
+
+    explicit cursor(const external_sorter& sorter) : compare(&sorter.compare) {
+      // each run reads blocks of an equal share of the budget
+      const std::size_t blocksize =
+          std::max<std::size_t>(sorter.options.budget /
+                                    (sizeof(T) * (sorter.runs.size() + 1)),
+                                1024);
+
+      sources.reserve(sorter.runs.size() + 1);
+
+      for (const run& r : sorter.runs) {
+        source& src = sources.emplace_back();
+
+        src.in = std::make_unique<std::ifstream>(r.file->name(),
+                                                 std::ios::binary);
+        src.block.resize(std::min(blocksize, r.size));
+        src.unread = r.size;
+
+        if (!src.refill()) sources.pop_back();
+      }
+
+      if (!sorter.buffer.empty()) {
+        source& src = sources.emplace_back();
+
+        src.beg = sorter.buffer.data();
+        src.lim = src.beg + sorter.buffer.size();
+      }
+
+      for (std::size_t i = 0; i < sources.size(); ++i) heap.push_back(i);
+
+      std::make_heap(heap.begin(), heap.end(), heap_order());
+    }
+
+    /// orders the heap so that the smallest current record is on top
+    auto heap_order() const {
+      return [this](std::size_t lhs, std::size_t rhs) -> bool {
+        return (*compare)(sources[rhs].front(), sources[lhs].front());
+      };
+    }
+
+    const Compare*           compare;
+    std::vector<source>      sources;
+    std::vector<std::size_t> heap;
+
+    friend class external_sorter;
+  };
+
+ private:
+  struct run {
+    std::unique_ptr<scratch_file> file;
+    std::size_t                   size = 0;
+  };
+
+  /// writes the buffered records as a sorted run
+  void spill() {
+    std::sort(buffer.begin(), buffer.end(), compare);
+
+    run r{std::make_unique<scratch_file>(options), buffer.size()};
+
+    {
+      std::ofstream out(r.file->name(), std::ios::binary | std::ios::trunc);
+
+      out.write(reinterpret_cast<const char*>(buffer.data()),
+                buffer.size() * sizeof(T));
+
+      if (!out)
+        throw std::runtime_error{"unable to write spill file " +
+                                 r.file->name().string()};
+    }
+
+    runs.emplace_back(std::move(r));
+    buffer.clear();
+  }
+
+  spill_options    options;
+  Compare          compare;
+  std::vector<T>   buffer;
+  std::vector<run> runs;
+  std::size_t      numrecs = 0;
+};
+
+/// an append-only sequence of records; when the buffered records exceed
+///   the memory budget, they are appended to a scratch file. The records are
+///   read back in insertion order.
+/// \tparam T a trivially copyable record
+template <class T>
+class spill_log {
+  static_assert(std::is_trivially_copyable_v<T>,
+                "records are written to scratch files as bytes");
+
+ public:
+  class reader;
+
+  explicit spill_log(spill_options opts = {}) : options(std::move(opts)) {}
+
+  /// replaces the spill options; only valid when empty
+  void configure(spill_options opts) {
+    assert(empty());
+    options = std::move(opts);
+  }
+
+  void push_back(const T& rec) {
+    buffer.push_back(rec);
+    ++numrecs;
+
+    if ((options.budget > 0) && (buffer.size() * sizeof(T) >= options.budget))
+      spill();
+  }
+
+  /// returns the number of records
+  std::size_t size() const { return numrecs; }
+
+  bool empty() const { return numrecs == 0; }
+
+  /// removes all records and the scratch file
+  void clear() {
+    std::vector<T>().swap(buffer);
+    file.reset();
+    numspilled = 0;
+    numrecs    = 0;
+  }
+
+  /// returns a reader over all records. The log must not be modified while
+  ///   a reader is in use.
+  reader read() const { return reader(*this); }
+
+  /// a forward pass over the records of a log
+  class reader {
+   public:
+    /// returns true, if all records have been visited
+    bool done() const { return beg == lim; }
+
+    /// returns the current record
+    const T& front() const {
+      assert(!done());
+      return *beg;
+    }
+
+    /// moves to the next record
+    void pop() {
+      assert(!done());
+
+      if (++beg == lim) refill();
+    }
+
+   private:
+    explicit reader(const spill_log& log)
+        : buffer(&log.buffer), unread(log.numspilled) {
+      if (log.file) {
+        in = std::make_unique<std::ifstream>(log.file->name(),
+                                             std::ios::binary);
+        block.resize(std::min<std::size_t>(
+            std::max<std::size_t>(log.options.budget / sizeof(T), 1024),
+            unread));
+      }
+
+      refill();
+    }
+
+    void refill() {
+      if (unread == 0) {
+        // the buffered records follow the spilled records
+        if (buffer && !buffer->empty()) {
+          beg = buffer->data();
+          lim = beg + buffer->size();
+        }
+
+        buffer = nullptr;
+        return;
+      }
+
+      const std::size_t n = std::min(unread, block.size());
+
+      in->read(reinterpret_cast<char*>(block.data()), n * sizeof(T));
+
+      if (!*in) throw std::runtime_error{"unable to read a spill file"};
+
+      unread -= n;
+      beg = block.data();
+      lim = beg + n;
+    }
+
+    const std::vector<T>*          buffer;  ///< null after it was read
+    std::unique_ptr<std::ifstream> in;
+    std::vector<T>                 block;
+    std::size_t                    unread = 0;  ///< records in *in
+    const T*                       beg    = nullptr;
+    const T*                       lim    = nullptr;
+
+    friend class spill_log;
+  };
+
+ private:
+  /// appends the buffered records to the scratch file
+  void spill() {
+    if (!file) file = std::make_unique<scratch_file>(options);
+
+    {
+      std::ofstream out(file->name(), std::ios::binary | std::ios::app);
+
+      out.write(reinterpret_cast<const char*>(buffer.data()),
+                buffer.size() * sizeof(T));
+
+      if (!out)
+        throw std::runtime_error{"unable to write spill file " +
+                                 file->name().string()};
+    }
+
+    numspilled += buffer.size();
+    buffer.clear();
+  }
+
+  spill_options                 options;
+  std::vector<T>                buffer;
+  std::unique_ptr<scratch_file> file;
+  std::size_t                   numspilled = 0;
+  std::size_t                   numrecs    = 0;
+};
+
+/// joins two sorted streams of records by key: calls
+///   fn(lhsGroup, rhsGroup) for each key that occurs in both streams, where
+///   a group holds all records of a stream with that key.
+/// \param key returns the join key of a record
+template <class LhsCursor, class RhsCursor, class KeyFn, class Fn>
+void for_each_matching_group(LhsCursor&& lhs, RhsCursor&& rhs, KeyFn key,
+                             Fn fn) {
+  using lhs_record = std::decay_t<decltype(lhs.front())>;
+  using rhs_record = std::decay_t<decltype(rhs.front())>;
+
+  std::vector<lhs_record> lhsGroup;
+  std::vector<rhs_record> rhsGroup;
+
+  while (!lhs.done() && !rhs.done()) {
+    const auto lhskey = key(lhs.front());
+    const auto rhskey = key(rhs.front());
+
+    if (lhskey < rhskey) {
+      lhs.pop();
+      continue;
+    }
+
+    if (rhskey < lhskey) {
+      rhs.pop();
+      continue;
+    }
+
+    lhsGroup.clear();
+    rhsGroup.clear();
+
+    while (!lhs.done() && (key(lhs.front()) == lhskey)) {
+      lhsGroup.push_back(lhs.front());
+      lhs.pop();
+    }
+
+    while (!rhs.done() && (key(rhs.front()) == rhskey)) {
+      rhsGroup.push_back(rhs.front());
+      rhs.pop();
+    }
+
+    fn(std::as_const(lhsGroup), std::as_const(rhsGroup));
+  }
+}
+
+}  // namespace experimental
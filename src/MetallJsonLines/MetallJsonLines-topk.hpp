@@ -0,0 +1,116 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief A Space-Saving summary for finding the most frequent values.
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace experimental {
+
+/// tracks the approximate counts of the (at most) capacity most frequent
+///   keys of a stream (Space-Saving, Metwally et al. 2005).
+/// \details
+///   a key that is not tracked replaces the key with the smallest count,
+///   and inherits that count (+1) as its overestimate. Thus, the counts are
+///   upper bounds that exceed the true counts by at most error, and every
+///   key that occurs more than n / capacity times in n additions is tracked.
+template <class Key, class Hash = std::hash<Key>>
+class space_saving {
+ public:
+  /// a tracked key
+  struct entry {
+    Key         key;
+    std::size_t count = 0;  ///< upper bound of the key's count
+    std::size_t error = 0;  ///< count - error is a lower bound
+  };
+
+  explicit space_saving(std::size_t capacity)
+      : limit(std::max<std::size_t>(capacity, 1)) {
+    entries.reserve(limit);
+    index.reserve(limit);
+  }
+
+  /// counts one occurrence of \ref key
+  void add(Key key) {
+    if (auto pos = index.find(key); pos != index.end()) {
+      bump(pos->second, 0);
+      return;
+    }
+
+    if (entries.size() < limit) {
+      const std::size_t idx = entries.size();
+
+      index.emplace(key, idx);
+      entries.push_back(entry{std::move(key), 1, 0});
+      order.emplace(1, idx);
+      return;
+    }
+
+    // replace the key with the smallest count
+    const std::size_t idx   = order.begin()->second;
+    entry&            least = entries[idx];
+
+    index.erase(least.key);
+    index.emplace(key, idx);
+    least.key = std::move(key);
+    bump(idx, least.count);
+  }
+
+  /// returns the tracked entries, ordered by descending count
+  std::vector<entry> entries_by_count() const {
+    std::vector<entry> res;
+
+    res.reserve(entries.size());
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+      res.push_back(entries[it->second]);
+
+    return res;
+  }
+
+  std::size_t size() const { return entries.size(); }
+  std::size_t capacity() const { return limit; }
+
+ private:
+  /// increments the count of entry \ref idx and sets its error
+  void bump(std::size_t idx, std::size_t error) {
+    entry& el = entries[idx];
+
+    order.erase({el.count, idx});
+    if (error) el.error = error;
+    ++el.count;
+    order.emplace(el.count, idx);
+  }
+
+  std::size_t                                   limit;
+  std::vector<entry>                            entries;
+  std::unordered_map<Key, std::size_t, Hash>    index;
+  std::set<std::pair<std::size_t, std::size_t>> order;  ///< (count, entry)
+};
+
+/// all-reduce operator that merges two sorted candidate lists
+struct sorted_union {
+  std::vector<std::string> operator()(
+      const std::vector<std::string>& lhs,
+      const std::vector<std::string>& rhs) const {
+    std::vector<std::string> res;
+
+    res.reserve(lhs.size() + rhs.size());
+    std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                   std::back_inserter(res));
+    return res;
+  }
+};
+
+}  // namespace experimental
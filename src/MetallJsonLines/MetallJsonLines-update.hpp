@@ -0,0 +1,327 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Column updates that are applied without evaluating json_logic.
+/// \details
+///   set evaluates its json_logic expression for each row and parses the
+///   printed result into the column. column_update compiles the common bulk
+///   updates instead: a constant (e.g., flag = 1, or tag = "x"), or
+///   arithmetic (+, -, *, /, %) over numeric constants and top-level columns
+///   (e.g., score = score * 2). The keys are resolved once, and the result
+///   is written into the value locator of the column in place; a string
+///   column is reassigned in its string slot.
+///   A row that the compiled update cannot evaluate (a missing or
+///   non-numeric column, an integer overflow, or a division by zero) is left
+///   unchanged, so that the caller can apply the json_logic updater to it.
+
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <boost/json.hpp>
+
+#include "json_bento/box.hpp"
+
+namespace experimental {
+
+class column_update {
+ public:
+  /// returns the compiled update of \ref column by the json_logic expression
+  ///   \ref rule; nullopt, if \ref rule is neither a constant nor arithmetic
+  ///   over constants and columns.
+  /// \param selectPrefix the prefix of the variable names (e.g., "keys")
+  static std::optional<column_update> compile(std::string               column,
+                                              const boost::json::value& rule,
+                                              std::string_view selectPrefix) {
+    column_update res;
+
+    res.target = std::move(column);
+
+    if (rule.is_null() || rule.is_bool() || rule.is_string()) {
+      res.constant = rule;
+      return res;
+    }
+
+    if (!res.compile_node(rule, selectPrefix)) return std::nullopt;
+
+    return res;
+  }
+
+  /// the updated column
+  const std::string& column() const { return target; }
+
+  /// the columns that the expression reads
+  const std::vector<std::string>& sources() const { return columns; }
+
+  /// evaluates the update for \ref obj and writes the result into the value
+  ///   of \ref key.
+  /// \param sourceKeys the key locators of sources()
+  /// \return false, if the update cannot be evaluated for \ref obj; then
+  ///         \ref obj is unchanged.
+  template <class ObjectAccessor>
+  bool apply(ObjectAccessor obj, json_bento::key_locator key,
+             const std::vector<json_bento::key_locator>& sourceKeys) const {
+    if (nodes.empty()) {
+      assign_constant(obj.find_or_add(key));
+      return true;
+    }
+
+    const std::optional<number> res = eval(obj, sourceKeys, nodes.size() - 1);
+
+    if (!res) return false;
+
+    auto val = obj.find_or_add(key);
+
+    if (res->real)
+      val = res->d;
+    else
+      val = res->i;
+
+    return true;
+  }
+
+ private:
+  /// a numeric value of the evaluation, either an integer or a real
+  struct number {
+    bool         real = false;
+    std::int64_t i    = 0;
+    double       d    = 0;
+
+    double as_real() const { return real ? d : double(i); }
+  };
+
+  enum class opcode { constant, column, add, subtract, multiply, divide, mod };
+
+  /// a node of the expression; the operands of a node precede it in nodes
+  struct node {
+    opcode      op = opcode::constant;
+    number      value;    ///< the constant
+    std::size_t lhs = 0;  ///< the column (index of sources()), or the
+    std::size_t rhs = 0;  ///<   operand nodes
+  };
+
+  column_update() = default;
+
+  /// compiles \ref expr and appends its nodes
+  /// \return false, if \ref expr is not a numeric expression
+  bool compile_node(const boost::json::value& expr,
+                    std::string_view          selectPrefix) {
+    if (const std::optional<number> num = number_of(expr)) {
+      nodes.push_back(node{opcode::constant, *num});
+      return true;
+    }
+
+    const boost::json::object* obj = expr.if_object();
+
+    if (!obj || (obj->size() != 1)) return false;
+
+    const auto& [opname, args] = *obj->begin();
+
+    if (opname == "var") return compile_column(args, selectPrefix);
+
+    const std::optional<opcode> op = opcode_of(opname);
+    const boost::json::array*   arr = args.if_array();
+
+    if (!op || !arr || (arr->size() < 2)) return false;
+
+    // + and * take any number of operands, the others take two
+    if ((arr->size() > 2) && (*op != opcode::add) && (*op != opcode::multiply))
+      return false;
+
+    if (!compile_node((*arr)[0], selectPrefix)) return false;
+
+    for (std::size_t i = 1; i < arr->size(); ++i) {
+      const std::size_t lhs = nodes.size() - 1;
+
+      if (!compile_node((*arr)[i], selectPrefix)) return false;
+
+      nodes.push_back(node{*op, {}, lhs, nodes.size() - 1});
+    }
+
+    return true;
+  }
+
+  /// compiles the variable {"var": name}, where name refers to a top-level
+  ///   column; nested paths and the generated columns (rowid, mpiid) are
+  ///   left to json_logic.
+  bool compile_column(const boost::json::value& args,
+                      std::string_view          selectPrefix) {
+    const boost::json::value* name = &args;
+
+    if (const boost::json::array* arr = args.if_array()) {
+      if (arr->size() != 1) return false;
+
+      name = &(*arr)[0];
+    }
+
+    const boost::json::string* str = name->if_string();
+
+    if (!str || (str->size() <= selectPrefix.size() + 1)) return false;
+
+    const std::string_view var{str->data(), str->size()};
+
+    if ((var.substr(0, selectPrefix.size()) != selectPrefix) ||
+        (var[selectPrefix.size()] != '.'))
+      return false;
+
+    const std::string_view col = var.substr(selectPrefix.size() + 1);
+
+    if ((col.find('.') != std::string_view::npos) || (col == "rowid") ||
+        (col == "mpiid"))
+      return false;
+
+    std::size_t pos = 0;
+
+    while ((pos < columns.size()) && (columns[pos] != col)) ++pos;
+
+    if (pos == columns.size()) columns.emplace_back(col);
+
+    nodes.push_back(node{opcode::column, {}, pos});
+    return true;
+  }
+
+  static std::optional<opcode> opcode_of(std::string_view name) {
+    if (name == "+") return opcode::add;
+    if (name == "-") return opcode::subtract;
+    if (name == "*") return opcode::multiply;
+    if (name == "/") return opcode::divide;
+    if (name == "%") return opcode::mod;
+
+    return std::nullopt;
+  }
+
+  static std::optional<number> number_of(const boost::json::value& val) {
+    if (val.is_int64()) return number{false, val.as_int64()};
+    if (val.is_double()) return number{true, 0, val.as_double()};
+
+    if (val.is_uint64() &&
+        (val.as_uint64() <=
+         std::uint64_t(std::numeric_limits<std::int64_t>::max())))
+      return number{false, std::int64_t(val.as_uint64())};
+
+    return std::nullopt;
+  }
+
+  template <class ObjectAccessor>
+  std::optional<number> eval(
+      const ObjectAccessor& obj,
+      const std::vector<json_bento::key_locator>& sourceKeys,
+      std::size_t                                 idx) const {
+    const node& n = nodes[idx];
+
+    if (n.op == opcode::constant) return n.value;
+
+    if (n.op == opcode::column) {
+      const auto val = obj.if_contains(sourceKeys[n.lhs]);
+
+      if (!val) return std::nullopt;
+
+      if (val->is_int64()) return number{false, val->as_int64()};
+      if (val->is_double()) return number{true, 0, val->as_double()};
+
+      if (val->is_uint64() &&
+          (val->as_uint64() <=
+           std::uint64_t(std::numeric_limits<std::int64_t>::max())))
+        return number{false, std::int64_t(val->as_uint64())};
+
+      return std::nullopt;
+    }
+
+    const std::optional<number> lhs = eval(obj, sourceKeys, n.lhs);
+
+    if (!lhs) return std::nullopt;
+
+    const std::optional<number> rhs = eval(obj, sourceKeys, n.rhs);
+
+    if (!rhs) return std::nullopt;
+
+    return arithmetic(n.op, *lhs, *rhs);
+  }
+
+  /// integers yield integers, except for the division (as in json_logic);
+  ///   nullopt on overflow and on an integer division by zero.
+  static std::optional<number> arithmetic(opcode op, number lhs, number rhs) {
+    number res;
+
+    if (op == opcode::divide) {
+      if (rhs.as_real() == 0) return std::nullopt;
+
+      res.real = true;
+      res.d    = lhs.as_real() / rhs.as_real();
+      return res;
+    }
+
+    if (lhs.real || rhs.real) {
+      const double x = lhs.as_real();
+      const double y = rhs.as_real();
+
+      res.real = true;
+
+      switch (op) {
+        case opcode::add: res.d = x + y; break;
+        case opcode::subtract: res.d = x - y; break;
+        case opcode::multiply: res.d = x * y; break;
+        default: res.d = std::fmod(x, y);
+      }
+
+      if (std::isnan(res.d)) return std::nullopt;
+
+      return res;
+    }
+
+    bool overflow = false;
+
+    switch (op) {
+      case opcode::add:
+        overflow = __builtin_add_overflow(lhs.i, rhs.i, &res.i);
+        break;
+      case opcode::subtract:
+        overflow = __builtin_sub_overflow(lhs.i, rhs.i, &res.i);
+        break;
+      case opcode::multiply:
+        overflow = __builtin_mul_overflow(lhs.i, rhs.i, &res.i);
+        break;
+      default:
+        if (rhs.i == 0) return std::nullopt;
+
+        // INT64_MIN % -1 overflows
+        res.i = (rhs.i == -1) ? 0 : lhs.i % rhs.i;
+    }
+
+    if (overflow) return std::nullopt;
+
+    return res;
+  }
+
+  /// assigns the constant; a string replaces a string value in its slot
+  template <class ValueAccessor>
+  void assign_constant(ValueAccessor val) const {
+    if (const boost::json::string* str = constant.if_string()) {
+      const std::string_view s{str->data(), str->size()};
+
+      if (val.is_string())
+        val.as_string() = s;
+      else
+        val = s;
+    } else if (constant.is_bool()) {
+      val = constant.as_bool();
+    } else {
+      val = nullptr;
+    }
+  }
+
+  std::string              target;
+  boost::json::value       constant;  ///< the value, if nodes is empty
+  std::vector<node>        nodes;
+  std::vector<std::string> columns;
+};
+
+}  // namespace experimental
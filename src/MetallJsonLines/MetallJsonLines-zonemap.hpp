@@ -0,0 +1,183 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <metall/container/string.hpp>
+#include <metall/container/vector.hpp>
+
+#include "MetallJsonLines-index.hpp"
+#include "MetallJsonLines-rowrange.hpp"
+
+/// zone maps: for a column, a rank keeps the minimum and maximum numeric
+///   value of each block of rows. A scan skips the blocks whose values
+///   cannot be within the bounds of the selection (see column_bounds).
+///   Unlike a sorted index, a zone map is extended when rows are appended,
+///   thus it stays current for append-only ingests.
+/// \details
+///   as for sorted indices, rows whose column is not a number are
+///   counted; a block that has such rows is never skipped.
+namespace experimental {
+
+/// the summary of the column values in a block of rows
+struct zone {
+  double        min    = std::numeric_limits<double>::infinity();
+  double        max    = -std::numeric_limits<double>::infinity();
+  std::uint64_t others = 0;  ///< number of rows without a numeric value
+
+  /// returns true, if a row of the block can have a value in [lo, hi]
+  bool may_contain(double lo, double hi) const {
+    return (others != 0) || ((lo <= max) && (min <= hi));
+  }
+
+  void add(std::optional<double> val) {
+    if (!val) {
+      ++others;
+      return;
+    }
+
+    min = std::min(min, *val);
+    max = std::max(max, *val);
+  }
+};
+
+/// the persistent zone maps of a rank, keyed by column;
+///   stored next to the local container in the same Metall datastore.
+template <class Alloc>
+class zone_map_cache {
+ public:
+  using allocator_type = Alloc;
+
+  /// the number of rows that a zone summarizes
+  static constexpr std::size_t block_rows = 64 * 1024;
+
+ private:
+  template <class T>
+  using other_allocator =
+      typename std::allocator_traits<Alloc>::template rebind_alloc<T>;
+
+  using string_type =
+      metall::container::basic_string<char, std::char_traits<char>,
+                                      other_allocator<char>>;
+  using zone_vector = metall::container::vector<zone, other_allocator<zone>>;
+
+ public:
+  /// the zone map of one column
+  class zone_map {
+   public:
+    zone_map(std::string_view col, const allocator_type& alloc)
+        : column(col.data(), col.size(), alloc), zones(alloc) {}
+
+    std::string_view name() const { return {column.data(), column.size()}; }
+
+    /// returns true, if the zone map summarizes rows in state \ref st
+    bool current(const sorted_index_stamp& st) const { return stamp == st; }
+
+    /// returns the state of the rows that the zone map summarizes
+    const sorted_index_stamp& state() const { return stamp; }
+
+    /// drops the zones
+    void clear() {
+      zones.clear();
+      stamp = {};
+    }
+
+    /// adds the value of row \ref row, the next row after the summarized
+    ///   rows
+    void add(std::size_t row, std::optional<double> val) {
+      const std::size_t block = row / block_rows;
+
+      if (zones.size() <= block) zones.resize(block + 1);
+
+      zones[block].add(val);
+    }
+
+    /// marks the rows as summarized in state \ref st
+    void set_state(const sorted_index_stamp& st) { stamp = st; }
+
+    /// returns the ranges of the blocks in \ref rows that can have a value
+    ///   in [lo, hi]; consecutive blocks are merged.
+    std::vector<row_range> ranges(const row_range& rows, double lo,
+                                  double hi) const {
+      const std::size_t lim = std::min<std::size_t>(rows.lim, stamp.numrows);
+      std::vector<row_range> res;
+
+      for (std::size_t b = rows.beg / block_rows;
+           (b < zones.size()) && (b * block_rows < lim); ++b) {
+        if (!zones[b].may_contain(lo, hi)) continue;
+
+        row_range blk{std::max(rows.beg, b * block_rows),
+                      std::min(lim, (b + 1) * block_rows)};
+
+        if (!res.empty() && (res.back().lim == blk.beg))
+          res.back().lim = blk.lim;
+        else
+          res.push_back(blk);
+      }
+
+      return res;
+    }
+
+    /// returns the number of rows in \ref ranges
+    static std::size_t count(const std::vector<row_range>& ranges) {
+      std::size_t res = 0;
+
+      for (const row_range& rng : ranges) res += rng.lim - rng.beg;
+
+      return res;
+    }
+
+   private:
+    string_type        column;
+    zone_vector        zones;
+    sorted_index_stamp stamp;
+  };
+
+  explicit zone_map_cache(const allocator_type& alloc) : entries(alloc) {}
+
+  /// returns the zone map of \ref column, or nullptr
+  const zone_map* find(std::string_view column) const {
+    for (const zone_map& el : entries)
+      if (el.name() == column) return &el;
+
+    return nullptr;
+  }
+
+  /// returns the zone map of \ref column; adds an empty one if none exists
+  zone_map& find_or_add(std::string_view column) {
+    for (zone_map& el : entries)
+      if (el.name() == column) return el;
+
+    entries.emplace_back(column, entries.get_allocator());
+    return entries.back();
+  }
+
+  /// calls \ref fn with each zone map
+  template <class Fn>
+  void for_all_zone_maps(Fn fn) {
+    for (zone_map& el : entries) fn(el);
+  }
+
+  /// returns the columns that have a zone map
+  std::vector<std::string> columns() const {
+    std::vector<std::string> res;
+
+    for (const zone_map& el : entries) res.emplace_back(el.name());
+
+    return res;
+  }
+
+  /// returns the number of zone maps
+  std::size_t size() const { return entries.size(); }
+
+ private:
+  metall::container::vector<zone_map, other_allocator<zone_map>> entries;
+};
+
+}  // namespace experimental
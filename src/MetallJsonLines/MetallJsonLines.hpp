@@ -5,7 +5,13 @@
 #define METALL_DISABLE_CONCURRENCY 1
 #endif
 
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <optional>
+#include <string>
 #include <string_view>
+#include <unordered_map>
 #include <utility>
 
 #include <metall/container/vector.hpp>
@@ -14,9 +20,14 @@
 #include <metall/utility/metall_mpi_adaptor.hpp>
 
 #include <ygm/comm.hpp>
+#include <ygm/container/map.hpp>
 #include <ygm/io/csv_parser.hpp>
 #include <ygm/detail/cereal_boost_json.hpp>
 #ifdef METALLDATA_USE_PARQUET
+#include <arrow/api.h>
+#include <arrow/io/file.h>
+#include <parquet/arrow/reader.h>
+#include <parquet/exception.h>
 #include <ygm/io/arrow_parquet_parser.hpp>
 #include <ygm/io/detail/arrow_parquet_json_converter.hpp>
 #endif
@@ -25,21 +36,45 @@
 
 #include "json_bento/box.hpp"
 
+#include "MetallJsonLines-aggview.hpp"
+#include "MetallJsonLines-csv.hpp"
+#include "MetallJsonLines-decompress.hpp"
+#include "MetallJsonLines-hash.hpp"
+#include "MetallJsonLines-hll.hpp"
+#include "MetallJsonLines-index.hpp"
+#include "MetallJsonLines-knnindex.hpp"
+#include "MetallJsonLines-manifest.hpp"
+#include "MetallJsonLines-pagein.hpp"
+#include "MetallJsonLines-parallel.hpp"
+#include "MetallJsonLines-perf.hpp"
+#include "MetallJsonLines-profile.hpp"
+#include "MetallJsonLines-rowrange.hpp"
+#include "MetallJsonLines-sample.hpp"
+#include "MetallJsonLines-selection.hpp"
+#include "MetallJsonLines-topk.hpp"
+#include "MetallJsonLines-update.hpp"
+#include "MetallJsonLines-zonemap.hpp"
+#ifdef METALLDATA_USE_PARQUET
+#include "MetallJsonLines-parquet.hpp"
+#endif
+
 namespace msg {
 
 struct process_data_mjl {
-  // repeated from metall_json_lines class
-  using lines_type =
-      json_bento::box<metall::manager::allocator_type<std::byte>>;
-  using accessor_type = lines_type::value_accessor;
+  /// rows received by rank 0, tagged with the sender's rank
+  using remote_rows_type =
+      std::vector<std::pair<int, std::vector<boost::json::value>>>;
 
-  using projector_type =
-      std::function<boost::json::value(const accessor_type&)>;
+  /// returns up to n selected and projected local rows
+  using row_collector_type =
+      std::function<std::vector<boost::json::value>(std::size_t)>;
+
+  /// stores rows that were moved to this rank
+  using row_sink_type = std::function<void(std::vector<boost::json::value>&)>;
 
-  lines_type*               vector;
-  std::vector<std::string>* remoteRows;
-  std::vector<std::size_t>* selectedRows;
-  projector_type*           projector;
+  remote_rows_type*   remoteRows;
+  row_collector_type* collector;
+  row_sink_type*      sink = nullptr;
 };
 
 process_data_mjl mjlState;
@@ -48,40 +83,64 @@ process_data_mjl mjlState;
 // metall_json_lines::head messages
 
 struct row_response {
-  void operator()(std::vector<std::string> rows) {
+  void operator()(int src, std::vector<boost::json::value> rows) const {
     assert(mjlState.remoteRows != nullptr);
 
-    std::move(rows.begin(), rows.end(),
-              std::back_inserter(*mjlState.remoteRows));
+    mjlState.remoteRows->emplace_back(src, std::move(rows));
   }
 };
 
+/// asks a rank for up to numrows rows; a rank that cannot provide all
+/// asks the next rank for the remaining rows.
 struct row_request {
   void operator()(ygm::comm* w, std::size_t numrows) const {
     assert(w != nullptr);
-    assert(mjlState.vector != nullptr);
-    assert(mjlState.selectedRows != nullptr);
+    assert(mjlState.collector != nullptr);
 
-    ygm::comm& world     = *w;
-    const int  fromThis  = std::min(mjlState.selectedRows->size(), numrows);
-    const int  fromOther = numrows - fromThis;
+    ygm::comm&                      world = *w;
+    std::vector<boost::json::value> rows  = (*mjlState.collector)(numrows);
+    const std::size_t               fromOther = numrows - rows.size();
 
     if ((fromOther > 0) && (world.size() != (world.rank() + 1))) {
       world.async(world.rank() + 1, row_request{}, fromOther);
     }
 
-    mjlState.selectedRows->resize(fromThis);
+    if (rows.size()) world.async(0, row_response{}, world.rank(), rows);
+  }
+};
 
-    std::vector<std::string> response;
+//
+// metall_json_lines::rebalance/repartition messages
 
-    for (std::uint64_t i : *mjlState.selectedRows) {
-      std::stringstream serial;
+struct row_transfer {
+  void operator()(std::vector<boost::json::value> rows) const {
+    assert(mjlState.sink != nullptr);
 
-      serial << (*mjlState.projector)(mjlState.vector->at(i)) << std::flush;
-      response.emplace_back(serial.str());
-    }
+    (*mjlState.sink)(rows);
+  }
+};
+
+//
+// metall_json_lines::rebalance reduction operator
 
-    world.async(0, row_response{}, response);
+struct elementwise_sum {
+  std::vector<std::size_t> operator()(
+      const std::vector<std::size_t>& lhs,
+      const std::vector<std::size_t>& rhs) const {
+    std::vector<std::size_t> res{lhs.begin(), lhs.end()};
+
+    for (std::size_t i = 0; i < rhs.size(); ++i) res[i] += rhs[i];
+
+    return res;
+  }
+
+  std::vector<double> operator()(const std::vector<double>& lhs,
+                                 const std::vector<double>& rhs) const {
+    std::vector<double> res{lhs.begin(), lhs.end()};
+
+    for (std::size_t i = 0; i < rhs.size(); ++i) res[i] += rhs[i];
+
+    return res;
   }
 };
 
@@ -98,49 +157,144 @@ struct info_reduction {
   }
 };
 
+//
+// metall_json_lines::info (detailed) reduction operator
+
+struct info_detail_reduction {
+  std::vector<boost::json::value> operator()(
+      const std::vector<boost::json::value>& lhs,
+      const std::vector<boost::json::value>& rhs) const {
+    std::vector<boost::json::value> res{lhs.begin(), lhs.end()};
+
+    res.insert(res.end(), rhs.begin(), rhs.end());
+    return res;
+  }
+};
+
 }  // namespace msg
 
 namespace {
 
+/// calls fn for the rows in \ref rows, for up to maxrows rows
+/// \return the number of rows for which fn was called
 template <class Fn, class Vector>
-void _simple_for_all_selected(Fn fn, Vector& vector, std::size_t maxrows) {
-  std::size_t const lim = std::min(vector.size(), maxrows);
+std::size_t _simple_for_all_selected(Fn fn, Vector& vector,
+                                     const experimental::row_range& rows,
+                                     std::size_t                    maxrows) {
+  std::size_t const lim = std::min(vector.size(), rows.lim);
+  std::size_t       i   = rows.beg;
 
-  for (std::size_t i = 0; lim != i; ++i) fn(i, vector.at(i));
+  for (; (i < lim) && (i - rows.beg < maxrows); ++i) fn(i, vector.at(i));
+
+  const std::size_t res = i > rows.beg ? i - rows.beg : 0;
+
+  experimental::scan_counters::add(res, res);
+  return res;
+}
+
+/// calls fn for row i, if it passes the filters
+/// \return true, if fn was called
+template <class Fn, class Vector, class FilterFns>
+bool _select_row(Fn& fn, Vector& vector, FilterFns& filterfn, std::size_t i) {
+  try {
+    auto       filpos   = filterfn.begin();
+    auto const fillim   = filterfn.end();
+    auto       accElemI = vector.at(i);
+
+    filpos = std::find_if_not(
+        filpos, fillim,
+        [i, &accElemI](typename FilterFns::value_type const& filter) -> bool {
+          return filter(i, accElemI);
+        });
+
+    if (fillim == filpos) {
+      fn(i, accElemI);
+      return true;
+    }
+  } catch (const experimental::stale_selection&) {
+    throw;
+  } catch (...) { /* \todo filter functions must not throw */
+  }
+
+  return false;
 }
 
 // can be invoked with const and non-const arguments
+/// \return the number of rows for which fn was called
 template <class Fn, class Vector, class FilterFns>
-void _for_all_selected(
+std::size_t _for_all_selected(
     Fn fn, Vector& vector, FilterFns& filterfn,
-    std::size_t maxrows = std::numeric_limits<std::size_t>::max()) {
-  if (filterfn.empty())
-    return _simple_for_all_selected<Fn>(std::move(fn), vector, maxrows);
-
-  std::size_t const lim = vector.size();
-  std::size_t       i   = 0;
-
-  while (maxrows && (lim != i)) {
-    try {
-      auto       filpos   = filterfn.begin();
-      auto const fillim   = filterfn.end();
-      auto       accElemI = vector.at(i);
-
-      filpos = std::find_if_not(
-          filpos, fillim,
-          [i, &accElemI](typename FilterFns::value_type const& filter) -> bool {
-            return filter(i, accElemI);
-          });
+    const experimental::row_range& rows    = {},
+    std::size_t                    maxrows = experimental::row_range::all) {
+  experimental::perf_scope perf{experimental::perf_region::scan};
 
-      if (fillim == filpos) {
-        fn(i, accElemI);
-        --maxrows;
-      }
-    } catch (...) { /* \todo filter functions must not throw */
-    }
+  if (filterfn.empty()) {
+    const std::size_t res =
+        _simple_for_all_selected<Fn>(std::move(fn), vector, rows, maxrows);
+
+    perf.rows(res);
+    return res;
+  }
+
+  std::size_t const lim      = std::min(vector.size(), rows.lim);
+  std::size_t       i        = rows.beg;
+  std::size_t       selected = 0;
+
+  while ((selected < maxrows) && (i < lim)) {
+    if (_select_row(fn, vector, filterfn, i)) ++selected;
 
     ++i;
   }
+
+  perf.rows(i - std::min(i, rows.beg));
+  experimental::scan_counters::add(i - std::min(i, rows.beg), selected);
+  return selected;
+}
+
+/// calls fn for the rows in \ref candidates (in row order) that are in
+/// \ref rows and pass the filters, for up to maxrows rows
+template <class Fn, class Vector, class FilterFns>
+void _for_all_candidates(Fn fn, Vector& vector, FilterFns& filterfn,
+                         const std::vector<std::size_t>& candidates,
+                         const experimental::row_range&  rows,
+                         std::size_t                     maxrows) {
+  std::size_t const lim = std::min(vector.size(), rows.lim);
+  auto              pos =
+      std::lower_bound(candidates.begin(), candidates.end(), rows.beg);
+  const auto  first    = pos;
+  std::size_t selected = 0;
+
+  for (; (selected < maxrows) && (pos != candidates.end()) && (*pos < lim);
+       ++pos)
+    if (_select_row(fn, vector, filterfn, *pos)) ++selected;
+
+  experimental::scan_counters::add(pos - first, selected);
+}
+
+/// calls fn for the rows whose bits are set in \ref bits, for up to maxrows
+/// rows
+template <class Fn, class Vector, class Bitmap>
+void _for_all_cached(
+    Fn fn, Vector& vector, const Bitmap& bits,
+    std::size_t maxrows = std::numeric_limits<std::size_t>::max()) {
+  if (maxrows == 0) return;
+
+  std::size_t visited = 0;
+
+  experimental::for_all_set_bits(
+      bits, [&fn, &vector, &maxrows, &visited](std::size_t i) -> bool {
+        ++visited;
+
+        try {
+          fn(i, vector.at(i));
+        } catch (...) { /* \todo filter functions must not throw */
+        }
+
+        return --maxrows != 0;
+      });
+
+  // the cached selection visits only the selected rows
+  experimental::scan_counters::add(visited, visited);
 }
 
 }  // namespace
@@ -157,19 +311,45 @@ T& checked_deref(T* ptr, const char* errmsg = "Failed pointer dereference") {
   throw std::runtime_error(errmsg);
 }
 
-struct import_summary : std::tuple<std::size_t, std::size_t> {
-  using base = std::tuple<std::size_t, std::size_t>;
-  using base::base;
+/// returns an estimate of the memory used by \ref val
+inline std::size_t approx_json_bytes(const boost::json::value& val) {
+  std::size_t res = sizeof(boost::json::value);
+
+  if (const boost::json::string* str = val.if_string())
+    return res + str->size();
+
+  if (const boost::json::array* arr = val.if_array()) {
+    for (const boost::json::value& el : *arr) res += approx_json_bytes(el);
+  } else if (const boost::json::object* obj = val.if_object()) {
+    for (const auto& el : *obj)
+      res += el.key().size() + approx_json_bytes(el.value());
+  }
+
+  return res;
+}
+
+struct import_summary : std::tuple<std::size_t, std::size_t, std::size_t> {
+  using base = std::tuple<std::size_t, std::size_t, std::size_t>;
+
+  import_summary(std::size_t imported = 0, std::size_t rejected = 0,
+                 std::size_t skipped = 0)
+      : base(imported, rejected, skipped) {}
 
   std::size_t imported() const { return std::get<0>(*this); }
   std::size_t rejected() const { return std::get<1>(*this); }
 
+  /// number of files that were skipped because they had been imported
+  std::size_t skipped() const { return std::get<2>(*this); }
+
   boost::json::object asJson() const {
     boost::json::object res;
 
     res["imported"] = imported();
     res["rejected"] = rejected();
 
+    // omitted unless a file was re-imported, as before manifests existed
+    if (skipped()) res["skipped"] = skipped();
+
     return res;
   }
 };
@@ -189,6 +369,24 @@ struct metall_json_lines {
   using metall_projector_type =
       std::function<boost::json::value(const accessor_type&)>;
   using metall_manager_type = metall::utility::metall_mpi_adaptor;
+  /// called after each imported batch with the number of rows that
+  /// this rank has imported and rejected so far
+  using import_progress_type = std::function<void(std::size_t, std::size_t)>;
+  using selection_cache_type =
+      selection_cache<metall::manager::allocator_type<std::byte>>;
+  using ingest_manifest_type =
+      ingest_manifest<metall::manager::allocator_type<std::byte>>;
+  using sorted_index_cache_type =
+      sorted_index_cache<metall::manager::allocator_type<std::byte>>;
+  using zone_map_cache_type =
+      zone_map_cache<metall::manager::allocator_type<std::byte>>;
+  using zone_map_type = zone_map_cache_type::zone_map;
+  using aggregate_view_cache_type =
+      aggregate_view_cache<metall::manager::allocator_type<std::byte>>;
+  using aggregate_view_type = aggregate_view_cache_type::view;
+  using knn_index_cache_type =
+      knn_index_cache<metall::manager::allocator_type<std::byte>>;
+  using knn_index_type = knn_index_cache_type::index;
 
   //
   // ctors
@@ -199,96 +397,184 @@ struct metall_json_lines {
         vector(checked_deref(metallmgr.get_local_manager()
                                  .find<lines_type>(metall::unique_instance)
                                  .first,
-                             ERR_OPEN)) {}
+                             ERR_OPEN)),
+        selectionsname(SELECTIONS_NAME),
+        manifestname(MANIFEST_NAME),
+        indicesname(INDICES_NAME),
+        zonemapsname(ZONE_MAPS_NAME),
+        aggviewsname(AGGREGATE_VIEWS_NAME),
+        knnindicesname(KNN_INDICES_NAME) {
+    find_selections();
+    find_indices();
+    vector.attach_key_cache();
+  }
 
   metall_json_lines(metall_manager_type& mgr, ygm::comm& world, const char* key)
       : ygmcomm(world),
         metallmgr(mgr),
         vector(checked_deref(
             metallmgr.get_local_manager().find<lines_type>(key).first,
-            ERR_OPEN)) {}
+            ERR_OPEN)),
+        selectionsname(std::string(key) + "-" + SELECTIONS_NAME),
+        manifestname(std::string(key) + "-" + MANIFEST_NAME),
+        indicesname(std::string(key) + "-" + INDICES_NAME),
+        zonemapsname(std::string(key) + "-" + ZONE_MAPS_NAME),
+        aggviewsname(std::string(key) + "-" + AGGREGATE_VIEWS_NAME),
+        knnindicesname(std::string(key) + "-" + KNN_INDICES_NAME) {
+    find_selections();
+    find_indices();
+    vector.attach_key_cache();
+  }
 
   metall_json_lines(metall_manager_type& mgr, ygm::comm& world,
                     std::string_view key)
       : metall_json_lines(mgr, world, key.data()) {}
 
+  /// opens the container and gives the page-in hint \ref mode
+  metall_json_lines(metall_manager_type& mgr, ygm::comm& world,
+                    page_in_mode mode)
+      : metall_json_lines(mgr, world) {
+    page_in(mode);
+  }
+
+  /// the key lookups of filters are cached in DRAM while the container is
+  ///   open; the cache is dropped before the datastore is closed.
+  ~metall_json_lines() { vector.detach_key_cache(); }
+
   //
   // accessors
 
   /// returns \ref numrows elements from the container
+  /// \details
+  ///   rank 0 takes as many rows as it can from its local container, and
+  ///   asks rank 1 for the remaining ones, which asks rank 2, and so on.
+  ///   Thus, ranks are only visited as long as rows are missing.
+  ///   Rows are sent as binary boost::json::value (through cereal).
   boost::json::array head(std::size_t           numrows,
                           metall_projector_type projector) const {
     using ResultType = decltype(head(numrows, projector));
 
-    ResultType               res;
-    std::vector<std::string> remoteRows;
-    std::vector<std::size_t> selectedRows;
+    ResultType                             res;
+    msg::process_data_mjl::remote_rows_type remoteRows;
 
-    msg::mjlState =
-        msg::process_data_mjl{&vector, &remoteRows, &selectedRows, &projector};
+    msg::process_data_mjl::row_collector_type collector =
+        [this, &projector](std::size_t n) -> std::vector<boost::json::value> {
+      std::vector<boost::json::value> rows;
 
-    // phase 1: make all local selections
-    {
       for_all_selected(
-          [&selectedRows](std::size_t rownum, const accessor_type&) -> void {
-            selectedRows.emplace_back(rownum);
+          [&rows, &projector](std::size_t, const accessor_type& row) -> void {
+            rows.emplace_back(projector(row));
           },
-          numrows);
+          n);
 
-      ygmcomm.barrier();
-    }
+      return rows;
+    };
 
-    // phase 2: send data request to neighbor
-    //          (cascades until numrows are available, or last rank)
-    //          rank 0: start filling result vector
-    {
-      if (isMainRank() && (selectedRows.size() < numrows) && !isLastRank()) {
-        std::cerr << "send row request " << selectedRows.size() << ":"
-                  << numrows << std::endl;
-        ygmcomm.async(ygmcomm.rank() + 1, msg::row_request{},
-                      (numrows - selectedRows.size()));
-      }
+    msg::mjlState = msg::process_data_mjl{&remoteRows, &collector};
+
+    // all ranks need to have set up their state before any request arrives
+    ygmcomm.cf_barrier();
 
-      for (std::uint64_t i : selectedRows)
-        res.emplace_back(projector(vector.at(i)));
+    if (isMainRank() && numrows) {
+      for (boost::json::value& row : collector(numrows))
+        res.emplace_back(std::move(row));
 
-      ygmcomm.barrier();
+      if ((res.size() < numrows) && !isLastRank())
+        ygmcomm.async(ygmcomm.rank() + 1, msg::row_request{},
+                      numrows - res.size());
     }
 
-    // phase 3: append received data to res (only rank 0 receives data)
-    for (const std::string& row : remoteRows)
-      res.emplace_back(boost::json::parse(row));
+    // completes when all requests have been answered
+    ygmcomm.barrier();
+
+    // only rank 0 receives data
+    std::sort(remoteRows.begin(), remoteRows.end(),
+              [](const auto& lhs, const auto& rhs) -> bool {
+                return lhs.first < rhs.first;
+              });
 
+    for (auto& [src, rows] : remoteRows)
+      for (boost::json::value& row : rows) res.emplace_back(std::move(row));
+
+    msg::mjlState = msg::process_data_mjl{nullptr, nullptr};
     return res;
   }
 
   /// returns the number of elements in the local container
   std::size_t local_size() const { return vector.size(); }
 
+  /// gives the page-in hint \ref mode for this rank's datastore; called
+  ///   after the datastore is opened (see page_in_mode)
+  void page_in(page_in_mode mode) const {
+    if (mode == page_in_mode::lazy) return;
+
+    if (mode == page_in_mode::random) {
+      const auto& mgr = metallmgr.get_local_manager();
+
+      advise_pages(mgr.get_address(), mgr.get_size(), MADV_RANDOM);
+    }
+
+    const auto [addr, bytes] = vector.root_value_region();
+
+    advise_pages(addr, bytes, MADV_WILLNEED);
+
+    if (selections)
+      selections->for_all_bitmaps(
+          [](const selection_cache_type::bitmap_type& bits) -> void {
+            advise_pages(bits.data(), bits.size() * sizeof(std::uint64_t),
+                         MADV_WILLNEED);
+          });
+  }
+
   /// calls \ref accessor with each row, for up to \ref maxrows (per local
   /// container) times
   void for_all_selected(
       visitor_type accessor,
       std::size_t  maxrows = std::numeric_limits<std::size_t>::max()) const {
-    _for_all_selected(std::move(accessor), vector, filterfn, maxrows);
+    for_all_selected_rows(std::move(accessor), maxrows);
+  }
+
+  /// calls \ref accessor with each selected row of \ref candidates, which
+  ///   are in ascending order (e.g., the rows of an index)
+  void for_all_selected_candidates(
+      visitor_type accessor, const std::vector<std::size_t>& candidates) const {
+    _for_all_candidates(std::move(accessor), vector, filterfn, candidates, rows,
+                        std::numeric_limits<std::size_t>::max());
+  }
+
+  /// sets the number of threads of the local scans of count, hist, and the
+  ///   filter evaluation (see parallel_chunks); 1 scans sequentially.
+  void scan_threads(std::size_t n) {
+    scanthreads = std::max<std::size_t>(1, n);
   }
 
+  /// returns the number of threads of the local scans
+  std::size_t scan_threads() const { return scanthreads; }
+
   /// returns the number of selected elements in the local container
   std::size_t count_selected() const {
     std::size_t selected = local_size();
 
     if (filterfn.size()) {
-      selected = 0;
-      for_all_selected([&selected](std::size_t, const accessor_type&) -> void {
-        ++selected;
-      });
+      std::vector<std::size_t> counts(scanthreads, 0);
+
+      parallel_for_all_selected_rows(
+          [&counts](std::size_t thread, std::size_t, const auto&) -> void {
+            ++counts[thread];
+          });
+
+      selected = std::accumulate(counts.begin(), counts.end(), std::size_t(0));
     }
 
     return selected;
   }
 
   /// returns information about the data stored in each partition
-  boost::json::array info() const {
+  /// \param detailed if true, the entry of a rank also has the storage
+  ///        breakdown of its partition (see detailed_info).
+  boost::json::array info(bool detailed = false) const {
+    if (detailed) return detailed_info();
+
     boost::json::array res;
     std::size_t        total = vector.size();
 
@@ -318,6 +604,121 @@ struct metall_json_lines {
     return res;
   }
 
+  /// returns the storage breakdown of the local partition:
+  ///   {"rows": n, "bytes": {<storage>: n, ..., "total": n}, "strings": n,
+  ///   "free_string_slots": n, "keys": n, "distinct_keys": n,
+  ///   "objects": n, "avg_object_width": x,
+  ///   "key_types": {<key>: {<type>: n, ...}, ...}}.
+  /// \details
+  ///   the byte counts cover the whole partition; the key statistics are
+  ///   computed in a single scan over the selected rows ("rows") and count
+  ///   the top-level keys of the rows that are objects.
+  boost::json::object local_storage_info() const {
+    static constexpr std::size_t numtypes = 8;
+    static const char* const     typenames[numtypes] = {
+        "null", "bool", "int64", "uint64", "double", "string", "array",
+        "object"};
+
+    auto type_of = [](const accessor_type& val) -> std::size_t {
+      if (val.is_null()) return 0;
+      if (val.is_bool()) return 1;
+      if (val.is_int64()) return 2;
+      if (val.is_uint64()) return 3;
+      if (val.is_double()) return 4;
+      if (val.is_string()) return 5;
+      if (val.is_array()) return 6;
+      return 7;
+    };
+
+    std::unordered_map<std::string, std::array<std::size_t, numtypes>> types;
+    std::size_t rows    = 0;
+    std::size_t objects = 0;
+    std::size_t members = 0;
+
+    for_all_selected([&](std::size_t, const accessor_type& row) -> void {
+      ++rows;
+
+      if (!row.is_object()) return;
+
+      ++objects;
+
+      for (const auto& kv : row.as_object()) {
+        ++members;
+        ++types[std::string(kv.key())][type_of(kv.value())];
+      }
+    });
+
+    const json_bento::storage_usage usage = vector.usage();
+    boost::json::object             bytes;
+
+    bytes["root_value_storage"]       = usage.root_value_bytes;
+    bytes["string_storage"]           = usage.string_bytes;
+    bytes["array_storage"]            = usage.array_bytes;
+    bytes["object_storage"]           = usage.object_bytes;
+    bytes["key_storage"]              = usage.key_bytes;
+    bytes["object_key_order_storage"] = usage.key_order_bytes;
+    bytes["packed_array_storage"]     = usage.packed_array_bytes;
+    bytes["total"]                    = usage.total_bytes();
+
+    boost::json::object keyTypes;
+
+    for (const auto& [key, counts] : types) {
+      boost::json::object hist;
+
+      for (std::size_t i = 0; i < numtypes; ++i)
+        if (counts[i]) hist[typenames[i]] = counts[i];
+
+      keyTypes[key] = std::move(hist);
+    }
+
+    boost::json::object res;
+
+    res["rows"]              = rows;
+    res["bytes"]             = std::move(bytes);
+    res["strings"]           = usage.num_strings;
+    res["free_string_slots"] = usage.num_free_string_slots;
+    res["keys"]              = usage.num_keys;
+    res["distinct_keys"]     = types.size();
+    res["objects"]           = objects;
+    res["avg_object_width"]  = objects ? double(members) / objects : 0.0;
+    res["key_types"]         = std::move(keyTypes);
+    return res;
+  }
+
+  /// returns, for each partition, its row counts (see info) and
+  ///   its storage breakdown (see local_storage_info) in "storage".
+  /// \details
+  ///   a rank's key statistics are local; a key that occurs on several
+  ///   ranks is listed by each of them.
+  boost::json::array detailed_info() const {
+    boost::json::object storage = local_storage_info();
+    boost::json::object local;
+
+    local["rank"]     = ygmcomm.rank();
+    local["elements"] = vector.size();
+    local["selected"] = storage.at("rows");
+    local["storage"]  = std::move(storage);
+
+    std::vector<boost::json::value> inf = {std::move(local)};
+
+    inf = ygmcomm.all_reduce(inf, msg::info_detail_reduction{});
+
+    boost::json::array res;
+
+    if (isMainRank()) {
+      std::sort(inf.begin(), inf.end(),
+                [](const boost::json::value& lhs,
+                   const boost::json::value& rhs) -> bool {
+                  return lhs.as_object().at("rank").as_int64() <
+                         rhs.as_object().at("rank").as_int64();
+                });
+
+      for (boost::json::value& el : inf) res.emplace_back(std::move(el));
+    }
+
+    return res;
+  }
+
   /// returns the total number of elements
   std::size_t count() const {
     // phase 1: count locally
@@ -329,60 +730,330 @@ struct metall_json_lines {
     return totalSelected;
   }
 
+  /// returns the approximate number of distinct values of \ref column in
+  ///   the selected rows; rows without the column or with a null value are
+  ///   not counted. Collective.
+  /// \param precision the sketch has 2^precision registers (see hyperloglog)
+  /// \details
+  ///   each rank adds the hashes of its values to a HyperLogLog sketch; the
+  ///   sketches are merged with a single all-reduce of 2^precision bytes.
+  double count_distinct(std::string_view column,
+                        int precision = hyperloglog::DEFAULT_PRECISION) const {
+    hyperloglog sketch{precision};
+
+    add_distinct(sketch, column);
+    return merged_estimate(sketch);
+  }
+
+  /// adds the hashes of the values of \ref column in the selected rows
+  ///   to \ref sketch (see count_distinct)
+  void add_distinct(hyperloglog& sketch, std::string_view column) const {
+    for_all_selected(
+        [&sketch, column](std::size_t, const accessor_type& row) -> void {
+          if (!row.is_object()) return;
+
+          const auto val = row.as_object().if_contains(column);
+
+          if (val && !val->is_null())
+            sketch.add(mix_hash64(key_hash_code(*val)));
+        });
+  }
+
+  /// merges the sketches of all ranks and returns the estimate. Collective.
+  double merged_estimate(hyperloglog& sketch) const {
+    sketch.merge(ygmcomm.all_reduce(sketch.registers(), hyperloglog_merge{}));
+
+    return sketch.estimate();
+  }
+
+  /// the local counts of a histogram
+  using hist_table_type =
+      std::unordered_map<boost::json::value, std::size_t, json_value_hash>;
+
+  /// computes a histogram of the values of a column over the selected rows
+  /// \param  column_name name of the column
+  /// \param  max_bins    if > 0, only the max_bins most frequent values are
+  ///         returned
+  /// \param  min_count   values that occur less often are not returned
+  /// \return (value, count) pairs on rank 0, ordered by descending count;
+  ///         an empty vector on the other ranks.
+  /// \details
+  ///   the counts are first aggregated locally, then the local counts are
+  ///   shuffled to owner ranks (partitioned by hash) which compute the
+  ///   totals. The owner ranks apply max_bins and min_count before sending
+  ///   their bins to rank 0, thus rank 0 receives at most
+  ///   max_bins * comm-size bins.
+  ///   Without a selection, the local counts are taken from a current
+  ///   aggregate view that groups by the column, if there is one.
   std::vector<std::pair<boost::json::value, std::size_t>> hist(
-      const std::string& column_name) const {
-    std::vector<std::pair<boost::json::value, std::size_t>> table;
-    for_all_selected([&column_name, &table, this](
-                         std::size_t, const accessor_type acs) -> void {
-      assert(acs.is_object());
-      const auto obj = acs.as_object();
-      if (!obj.contains(column_name)) {
-        return;
-      }
-      boost::json::value value;
-      json_bento::value_to(obj.at(column_name), value);
-      // TODO: use hash function to increase performance
-      auto pos = std::find_if(
-          table.begin(), table.end(),
-          [&value](const auto& item) { return (item.first == value); });
-      if (pos == table.end()) {
-        table.push_back(std::make_pair(value, 1));
-      } else {
-        ++(pos->second);
-      }
-    });
-    ygmcomm.cf_barrier();
+      const std::string& column_name, std::size_t max_bins = 0,
+      std::size_t min_count = 1) const {
+    if (auto match = find_aggregate_view({column_name}, {})) {
+      const aggregate_view_type& av = *match->view;
+      hist_table_type            local_table;
+
+      for (std::size_t g = 0; g < av.size(); ++g)
+        local_table.emplace(boost::json::parse(av.key(g)).as_array().front(),
+                            av.rows(g));
+
+      return reduce_hist(local_table, max_bins, min_count);
+    }
+
+    return hist_by(
+        [&column_name](std::size_t, const accessor_type acs)
+            -> std::optional<boost::json::value> {
+          return column_value(acs, column_name);
+        },
+        max_bins, min_count);
+  }
+
+  /// computes a histogram as hist, of the values that \ref valueFn
+  ///   returns for the selected rows.
+  /// \param valueFn returns the value of a row (row, accessor), or an
+  ///        empty optional for rows without a value; called concurrently
+  ///        if scan_threads() > 1.
+  template <class ValueFn>
+  std::vector<std::pair<boost::json::value, std::size_t>> hist_by(
+      ValueFn valueFn, std::size_t max_bins = 0,
+      std::size_t min_count = 1) const {
+    // phase 1: count locally, one table per thread
+    std::vector<hist_table_type> tables(scanthreads);
+
+    parallel_for_all_selected_rows(
+        [&valueFn, &tables](std::size_t thread, std::size_t row,
+                            const accessor_type& acs) -> void {
+          std::optional<boost::json::value> value = valueFn(row, acs);
+
+          if (value) ++tables[thread][std::move(*value)];
+        });
 
-    std::vector<std::pair<boost::json::value, std::size_t>> gloval_table;
-    static auto& s_gloval_table = gloval_table;
+    hist_table_type& local_table = tables.front();
+
+    for (std::size_t t = 1; t < tables.size(); ++t) {
+      for (auto& [value, count] : tables[t]) local_table[value] += count;
+
+      tables[t].clear();
+    }
+
+    return reduce_hist(local_table, max_bins, min_count);
+  }
+
+  /// computes a histogram as hist, from the local counts \ref local_table
+  ///   of each rank; clears \ref local_table. Collective.
+  std::vector<std::pair<boost::json::value, std::size_t>> reduce_hist(
+      hist_table_type& local_table, std::size_t max_bins = 0,
+      std::size_t min_count = 1) const {
+    using bin_type = std::pair<std::string, std::size_t>;
+
+    // phase 2: shuffle the local counts to the owner ranks
+    ygm::container::map<std::string, std::size_t> global_table(ygmcomm);
+
+    for (const auto& [value, count] : local_table) {
+      global_table.async_visit(
+          boost::json::serialize(value),
+          [](const std::string&, std::size_t& total, std::size_t cnt) {
+            total += cnt;
+          },
+          count);
+    }
+    local_table.clear();
+    ygmcomm.barrier();
+
+    // phase 3: trim the owned bins
+    std::vector<bin_type> bins;
+
+    global_table.local_for_all(
+        [&bins, min_count](const std::string& key, std::size_t count) {
+          if (count >= min_count) bins.emplace_back(key, count);
+        });
+
+    trim_bins(bins, max_bins);
+
+    // phase 4: gather to rank 0
+    std::vector<bin_type> gathered;
+    static auto&          s_gathered = gathered;
     ygmcomm.cf_barrier();
 
-    // Gather results to rank 0
-    for (const auto& item : table) {
+    for (const auto& [key, count] : bins) {
       ygmcomm.async(
           0,
-          [](const boost::json::value& value, const std::size_t count) {
-            auto pos = std::find_if(
-                s_gloval_table.begin(), s_gloval_table.end(),
-                [&value](const auto& item) { return (item.first == value); });
-            if (pos == s_gloval_table.end()) {
-              s_gloval_table.push_back(std::make_pair(value, count));
-            } else {
-              (pos->second) += count;
-            }
+          [](const std::string& key, std::size_t count) {
+            s_gathered.emplace_back(key, count);
           },
-          item.first, item.second);
+          key, count);
     }
     ygmcomm.barrier();
 
-    return gloval_table;
+    trim_bins(gathered, max_bins);
+
+    std::vector<std::pair<boost::json::value, std::size_t>> res;
+
+    res.reserve(gathered.size());
+    for (const auto& [key, count] : gathered) {
+      res.emplace_back(boost::json::parse(key), count);
+    }
+
+    return res;
+  }
+
+  /// the default factor of candidates per rank of top_k
+  static constexpr std::size_t TOP_K_OVERSAMPLING = 4;
+
+  /// returns the \ref k most frequent values of a column over the selected
+  ///   rows, with their exact counts, as hist with max_bins = k.
+  /// \param  column_name name of the column
+  /// \param  k           number of values returned
+  /// \param  oversampling each rank proposes k * oversampling candidates
+  /// \return (value, count) pairs on all ranks, ordered by descending count
+  /// \details
+  ///   each rank summarizes its values with a Space-Saving summary of
+  ///   k * oversampling entries; the tracked values of all ranks are merged
+  ///   into a candidate set with one all-reduce, and the candidates are
+  ///   recounted exactly in a second pass over the rows. Thus, the
+  ///   communication is O(k * oversampling * comm-size), independent of the
+  ///   number of distinct values. A value that occurs in more than a
+  ///   1 / (k * oversampling) fraction of some rank's rows is a candidate;
+  ///   the result can differ from hist only if (near) the k most frequent
+  ///   values, none is that frequent on any rank.
+  std::vector<std::pair<boost::json::value, std::size_t>> top_k(
+      const std::string& column_name, std::size_t k,
+      std::size_t oversampling = TOP_K_OVERSAMPLING) const {
+    using bin_type = std::pair<std::string, std::size_t>;
+
+    if (k == 0) return {};
+
+    // phase 1: summarize locally
+    space_saving<std::string> summary{k *
+                                      std::max<std::size_t>(oversampling, 1)};
+
+    for_all_selected([&column_name, &summary](std::size_t,
+                                              const accessor_type acs) -> void {
+      if (auto value = column_value(acs, column_name))
+        summary.add(boost::json::serialize(*value));
+    });
+
+    // phase 2: merge the candidates of all ranks
+    std::vector<std::string> candidates;
+
+    for (auto& el : summary.entries_by_count())
+      candidates.push_back(std::move(el.key));
+
+    std::sort(candidates.begin(), candidates.end());
+    candidates = ygmcomm.all_reduce(candidates, sorted_union{});
+
+    // phase 3: recount the candidates exactly
+    hist_table_type          position;
+    std::vector<std::size_t> counts(candidates.size(), 0);
+
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+      position.emplace(boost::json::parse(candidates[i]), i);
+
+    for_all_selected([&column_name, &position, &counts](
+                         std::size_t, const accessor_type acs) -> void {
+      if (auto value = column_value(acs, column_name)) {
+        if (auto pos = position.find(*value); pos != position.end())
+          ++counts[pos->second];
+      }
+    });
+
+    counts = ygmcomm.all_reduce(counts, msg::elementwise_sum{});
+
+    // phase 4: keep the k most frequent
+    std::vector<bin_type> bins;
+
+    for (std::size_t i = 0; i < candidates.size(); ++i)
+      if (counts[i]) bins.emplace_back(std::move(candidates[i]), counts[i]);
+
+    trim_bins(bins, k);
+
+    std::vector<std::pair<boost::json::value, std::size_t>> res;
+
+    res.reserve(bins.size());
+    for (const auto& [key, count] : bins)
+      res.emplace_back(boost::json::parse(key), count);
+
+    return res;
+  }
+
+#if METALLDATA_USE_PARQUET
+  /// writes the selected rows into one Parquet file per rank
+  ///   (<prefix>-<rank>.parquet) and returns the total number of written rows
+  /// \param  prefix       the files' path prefix
+  /// \param  columns      the columns to write; all columns if empty
+  /// \param  rowgroupsize number of rows per row group
+  /// \details
+  ///   the column types are inferred from the selected rows of each rank
+  ///   (see parquet_row_writer), thus ranks may infer different types for
+  ///   a column that has mixed types.
+  std::size_t to_parquet(std::string_view                prefix,
+                         const std::vector<std::string>& columns = {},
+                         std::size_t rowgroupsize = 64 * 1024) const {
+    parquet_row_writer writer{columns};
+    std::size_t        written = 0;
+
+    for_all_selected([&writer](std::size_t, const accessor_type& row) -> void {
+      writer.add_sample(row);
+    });
+
+    writer.open(std::string(prefix) + "-" + std::to_string(ygmcomm.rank()) +
+                    ".parquet",
+                rowgroupsize);
+
+    for_all_selected(
+        [&writer, &written](std::size_t, const accessor_type& row) -> void {
+          writer.write(row);
+          ++written;
+        });
+
+    writer.close();
+    return ygmcomm.all_reduce_sum(written);
   }
+#endif
 
   //
   // mutators
 
-  /// clears the local container
-  void clear() { vector.clear(); }
+  /// clears the local container and its ingest manifest
+  void clear() {
+    vector.clear();
+    invalidate_selections();
+
+    if (ingest_manifest_type* manifest = find_manifest()) manifest->clear();
+  }
+
+  /// rewrites the local rows into freshly allocated, densely packed storage
+  ///   (see json_bento::box::compact); the selection is ignored.
+  /// \param sortkey if not empty, the local rows are sorted by the value of
+  ///        this field, which improves the locality of scans and lets zone
+  ///        maps skip more blocks. Sorting renumbers the rows, thus cached
+  ///        selections are dropped and indices and zone maps are rebuilt.
+  /// \return false, if the datastore is read-only
+  bool compact(std::string_view sortkey = {}) {
+    if (metallmgr.get_local_manager().read_only()) return false;
+
+    const sorted_index_stamp before = index_stamp();
+
+    vector.compact(sortkey);
+
+    if (sortkey.empty()) return true;
+
+    invalidate_selections();
+    refresh_indices();
+
+    if (zonemaps)
+      zonemaps->for_all_zone_maps([this](zone_map_type& zm) -> void {
+        zm.clear();
+        extend_zone_map(zm, 0);
+      });
+
+    // the groups do not depend on the order of the rows
+    if (aggviews)
+      aggviews->for_all_views([this, &before](aggregate_view_type& av) -> void {
+        if (av.current(before)) av.set_state(index_stamp());
+      });
+
+    return true;
+  }
 
   /// calls updater(row) for each selected row
   /// \param  updater a function that may modify an JSON line
@@ -393,13 +1064,13 @@ struct metall_json_lines {
 
     // phase 1: update records locally
     {
-      _for_all_selected(
+      for_all_selected_rows(
           [&updcount, fn = std::move(updater)](int           rownum,
                                                accessor_type obj) -> void {
             ++updcount;
             fn(rownum, obj);
-          },
-          vector, filterfn);
+          });
+      invalidate_selections();
     }
 
     // phase 2: compute total update count
@@ -408,53 +1079,397 @@ struct metall_json_lines {
     return res;
   }
 
-  /// imports json files and returns the number of imported rows
-  /// \param  files       a list of JSON data files that will be imported
-  /// \param  filter      a function that accepts or rejects a JSON line
-  /// \param  transformer a function that transforms a JSON entry before it is
-  /// stored \return a summary of how many lines were imported and rejected.
-  import_summary read_json_files(
-      const std::vector<std::string>&                       files,
-      std::function<bool(const boost::json::value&)>        filter = accept_all,
-      std::function<boost::json::value(boost::json::value)> transformer =
-          identity_transformer) {
-    // namespace mtljsn = metall::json::json;
+  /// applies a compiled column update to each selected row
+  /// \param  update   the compiled update
+  /// \param  fallback the updater of the rows that
+  ///         \ref update cannot
+  ///         evaluate (see column_update::apply)
+  /// \return the number of updated lines
+  /// \details
+  ///   the keys of the column and of the sources are resolved once; the
+  ///   updated values are written in place.
+  std::size_t set(const column_update& update, updater_type fallback) {
+    const json_bento::key_locator        key = vector.add_key(update.column());
+    std::vector<json_bento::key_locator> sourceKeys;
+    std::size_t                          updcount = 0;
+
+    for (const std::string& col : update.sources())
+      sourceKeys.push_back(vector.locate_key(col));
+
+    for_all_selected_rows([&](int rownum, accessor_type obj) -> void {
+      ++updcount;
+
+      if (!obj.is_object() ||
+          !update.apply(obj.as_object(), key, sourceKeys))
+        fallback(rownum, obj);
+    });
+    invalidate_selections();
 
-    // phase 1: distributed import of data in files
-    ygm::io::line_parser lineParser{ygmcomm, files};
-    std::size_t          imported    = 0;
-    std::size_t          rejected    = 0;
-    std::size_t const    initialSize = vector.size();
-    lines_type*          vec         = &vector;
-
-    lineParser.for_all(
-        [&imported, &rejected, vec, filterFn = std::move(filter),
-         transFn = std::move(transformer)](const std::string& line) -> void {
-          boost::json::value jsonLine = boost::json::parse(line);
-
-          if (filterFn(jsonLine)) {
-            vec->push_back(transFn(std::move(jsonLine)));
-            ++imported;
-          } else {
-            ++rejected;
-          }
-        });
+    return ygmcomm.all_reduce_sum(updcount);
+  }
 
-    assert(vec->size() == initialSize + imported);
+  /// moves rows between ranks, so that all ranks hold the same number of
+  /// rows (+/- 1).
+  /// \return the number of moved rows
+  /// \details
+  ///   ranks with surplus rows send their last rows to the ranks with a
+  ///   deficit, thus no more rows are moved than necessary. The filters
+  ///   are ignored (i.e., all rows are considered).
+  std::size_t rebalance() {
+    const int                rank = ygmcomm.rank();
+    const std::size_t        numranks = ygmcomm.size();
+    std::vector<std::size_t> rowcounts(numranks, 0);
+
+    rowcounts[rank] = vector.size();
+    rowcounts       = ygmcomm.all_reduce(rowcounts, msg::elementwise_sum{});
+
+    const std::size_t total =
+        std::accumulate(rowcounts.begin(), rowcounts.end(), std::size_t(0));
+    auto target = [total, numranks](std::size_t r) -> std::size_t {
+      return total / numranks + (r < total % numranks ? 1 : 0);
+    };
+
+    // pair surplus ranks with deficit ranks, in rank order
+    std::vector<std::size_t> dests(vector.size(), rank);
+    std::size_t              moved = 0;
+    std::size_t              recv  = 0;
+
+    for (std::size_t src = 0; src < numranks; ++src) {
+      std::size_t surplus =
+          rowcounts[src] > target(src) ? rowcounts[src] - target(src) : 0;
+
+      while (surplus) {
+        while (rowcounts[recv] >= target(recv)) ++recv;
+
+        const std::size_t n =
+            std::min(surplus, target(recv) - rowcounts[recv]);
+
+        if (src == std::size_t(rank)) {
+          const std::size_t keep = target(src) + surplus - n;
+
+          std::fill(dests.begin() + keep, dests.begin() + keep + n, recv);
+        }
 
-    // phase 2: compute total number of imported rows
-    int totalImported = ygmcomm.all_reduce_sum(imported);
-    int totalRejected = ygmcomm.all_reduce_sum(rejected);
+        rowcounts[recv] += n;
+        surplus -= n;
+        moved += n;
+      }
+    }
 
-    return {totalImported, totalRejected};
+    move_rows(dests);
+    return moved;
   }
 
-  /// imports a json files and returns the number of imported rows
-  import_summary read_json_file(std::string file) {
-    std::vector<std::string> files;
+  /// moves rows between ranks, so that all rows with the same value of
+  /// \ref key are stored on the same rank (rows without \ref key are treated
+  /// as if key were null).
+  /// \return the number of moved rows
+  /// \details
+  ///   the owner rank is json_hash_code(value) % comm-size. The filters
+  ///   are ignored (i.e., all rows are repartitioned).
+  std::size_t repartition(std::string_view key) {
+    const std::size_t        numranks = ygmcomm.size();
+    const std::size_t        nullhash = json_hash_code(boost::json::value{});
+    std::vector<std::size_t> dests;
+    std::size_t              moved = 0;
+
+    dests.reserve(vector.size());
+    for (std::size_t i = 0; i < vector.size(); ++i) {
+      const accessor_type row  = vector.at(i);
+      std::size_t         hash = nullhash;
+
+      if (row.is_object()) {
+        if (const auto val = row.as_object().if_contains(key))
+          hash = json_hash_code(*val);
+      }
 
-    files.emplace_back(std::move(file));
-    return read_json_files(files);
+      dests.push_back(hash % numranks);
+      moved += (dests.back() != std::size_t(ygmcomm.rank()));
+    }
+
+    move_rows(dests);
+    return ygmcomm.all_reduce_sum(moved);
+  }
+
+  /// replaces the local rows by \ref rows, e.g., after rows were combined
+  ///   (see collapse_rows). Unlike clear, the ingest manifest is kept, thus
+  ///   the imported files are not imported again.
+  void replace_local(const std::vector<boost::json::value>& rows) {
+    vector.clear();
+
+    for (const boost::json::value& row : rows) vector.push_back(row);
+
+    invalidate_selections();
+  }
+
+  /// imports json files and returns the number of imported rows
+  /// lines are parsed directly into the container in batches, without
+  /// constructing intermediate boost::json::value objects.
+  /// \param  files       a list of JSON data files that will be imported
+  /// \param  batchsize   max number of lines that are stored at once
+  /// \param  numthreads  number of threads per rank that parse a batch;
+  ///         the parsed lines are merged into the container by the
+  ///         calling thread, thus Metall is only accessed by one thread.
+  /// \param  batchbytes  max number of bytes of the lines in a batch;
+  ///         together with batchsize, this bounds the memory that is
+  ///         used for buffering lines, independent of the file sizes.
+  /// \param  progress    if set, called after each batch
+  /// \return a summary of how many lines were imported and rejected
+  ///         (i.e., were not valid JSON), and how many files were skipped.
+  /// \details
+  ///   imported files are recorded in a persistent manifest; files whose
+  ///   contents were imported before (see ingest_manifest) are skipped.
+  ///   The files are imported one after the other, so that the manifest
+  ///   can record each file's row range on each rank.
+  ///   Files ending in .gz or .zst are decompressed while they are read
+  ///   (see compressed_line_reader): a seekable zstd file is split over all
+  ///   ranks, any other compressed file is read by one rank.
+  import_summary read_json_files(
+      const std::vector<std::string>& files, std::size_t batchsize = 4096,
+      std::size_t numthreads = 1, std::size_t batchbytes = DEFAULT_BATCH_BYTES,
+      import_progress_type progress = {}) {
+    const sorted_index_stamp before   = index_stamp();
+    std::size_t              imported = 0;
+    std::size_t              rejected = 0;
+    std::size_t              bytes    = 0;
+    std::vector<std::string> batch;
+
+    batch.reserve(batchsize);
+
+    auto storeBatch = [this, &batch, &imported, &rejected, &bytes, &progress,
+                       numthreads]() -> void {
+      if (batch.empty()) return;
+
+      experimental::perf_scope perf{experimental::perf_region::append};
+      const std::size_t        stored =
+          vector.push_back_batch_parallel(batch, numthreads);
+
+      perf.rows(batch.size());
+
+      imported += stored;
+      rejected += batch.size() - stored;
+      bytes = 0;
+      batch.clear();
+
+      if (progress) progress(imported, rejected);
+    };
+
+    const std::vector<file_fingerprint> prints   = fingerprints(files);
+    const std::vector<int>              owners =
+        compressed_owners(files, prints);
+    ingest_manifest_type*               manifest = writable_manifest();
+    std::vector<file_fingerprint>       ingested;
+    std::size_t                         skipped = 0;
+
+    for (std::size_t i = 0; i < files.size(); ++i) {
+      const file_fingerprint& fp = prints[i];
+      const bool              seen =
+          (manifest && manifest->contains(fp)) ||
+          std::any_of(ingested.begin(), ingested.end(),
+                      [&fp](const file_fingerprint& other) -> bool {
+                        return fp.size == other.size && fp.hash == other.hash;
+                      });
+
+      if (seen) {
+        ++skipped;
+        continue;
+      }
+
+      const std::size_t firstrow = vector.size();
+
+      for_all_lines(
+          files[i], owners[i],
+          [&batch, &bytes, batchsize, batchbytes,
+           &storeBatch](const std::string& line) -> void {
+            bytes += line.size();
+            batch.emplace_back(line);
+
+            if ((batch.size() >= batchsize) || (bytes >= batchbytes))
+              storeBatch();
+          });
+
+      storeBatch();
+      ingested.push_back(fp);
+
+      if (manifest)
+        manifest->record(files[i], fp, firstrow, vector.size() - firstrow);
+    }
+
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
+    refresh_indices();
+
+    // phase 2: compute total number of imported rows
+    std::size_t totalImported = ygmcomm.all_reduce_sum(imported);
+    std::size_t totalRejected = ygmcomm.all_reduce_sum(rejected);
+
+    return {totalImported, totalRejected, skipped};
+  }
+
+  /// returns the files recorded in the ingest manifest of this rank
+  boost::json::array ingested_files() const {
+    const ingest_manifest_type* manifest =
+        metallmgr.get_local_manager()
+            .find<ingest_manifest_type>(manifestname.c_str())
+            .first;
+
+    return manifest ? manifest->as_json() : boost::json::array{};
+  }
+
+  /// imports json files and returns the number of imported rows
+  /// \param  files       a list of JSON data files that will be imported
+  /// \param  filter      a function that accepts or rejects a JSON line
+  /// \param  transformer a function that transforms a JSON entry before it is
+  /// stored \return a summary of how many lines were imported and rejected.
+  import_summary read_json_files(
+      const std::vector<std::string>&                       files,
+      std::function<bool(const boost::json::value&)>        filter,
+      std::function<boost::json::value(boost::json::value)> transformer =
+          identity_transformer) {
+    // namespace mtljsn = metall::json::json;
+    const sorted_index_stamp before = index_stamp();
+
+    // phase 1: distributed import of data in files
+    std::vector<std::string> plain;
+    std::vector<std::string> compressed;
+
+    for (const std::string& file : files)
+      (compression_of(file) == file_compression::none ? plain : compressed)
+          .push_back(file);
+
+    std::size_t       imported    = 0;
+    std::size_t       rejected    = 0;
+    std::size_t const initialSize = vector.size();
+    lines_type*       vec         = &vector;
+
+    auto importLine = [&imported, &rejected, vec, filterFn = std::move(filter),
+                       transFn = std::move(transformer)](
+                          const std::string& line) -> void {
+      boost::json::value jsonLine = boost::json::parse(line);
+
+      if (filterFn(jsonLine)) {
+        vec->push_back(transFn(std::move(jsonLine)));
+        ++imported;
+      } else {
+        ++rejected;
+      }
+    };
+
+    if (!plain.empty()) {
+      ygm::io::line_parser lineParser{ygmcomm, plain};
+
+      lineParser.for_all(importLine);
+    }
+
+    if (!compressed.empty()) {
+      const std::vector<int> owners =
+          compressed_owners(compressed, fingerprints(compressed));
+
+      for (std::size_t i = 0; i < compressed.size(); ++i)
+        for_all_lines(compressed[i], owners[i], importLine);
+    }
+
+    assert(vec->size() == initialSize + imported);
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
+    refresh_indices();
+
+    // phase 2: compute total number of imported rows
+    std::size_t totalImported = ygmcomm.all_reduce_sum(imported);
+    std::size_t totalRejected = ygmcomm.all_reduce_sum(rejected);
+
+    return {totalImported, totalRejected};
+  }
+
+  /// imports a json files and returns the number of imported rows
+  import_summary read_json_file(std::string file) {
+    std::vector<std::string> files;
+
+    files.emplace_back(std::move(file));
+    return read_json_files(files);
+  }
+
+  /// imports CSV files and returns the number of imported rows
+  /// \param  files    a list of CSV files that will be imported;
+  ///                  files ending in .gz or .zst are decompressed while
+  ///                  they are read (see read_json_files).
+  /// \param  format   the columns and their types, the delimiter, and
+  ///                  whether the files have a header line
+  /// \param  extras   columns that are computed from the cells of a line
+  ///                  and added to each row as strings
+  /// \param  progress if set, called after every CSV_PROGRESS_LINES lines
+  /// \return a summary of how many lines were imported and rejected
+  ///         (see csv_line_parser).
+  /// \details
+  ///   the lines are distributed over the ranks as by read_json_files.
+  ///   The columns are resolved into key locators once, and each line is
+  ///   parsed into typed cells that are written into the container
+  ///   directly, without constructing a JSON value per row.
+  ///   Columns of type skip are not stored; empty cells are stored as null.
+  import_summary read_csv_files(const std::vector<std::string>& files,
+                                const csv_format&               format,
+                                std::vector<csv_extra_column>   extras   = {},
+                                import_progress_type            progress = {}) {
+    using object_writer = lines_type::object_writer;
+
+    const sorted_index_stamp             before   = index_stamp();
+    std::size_t                          imported = 0;
+    std::size_t                          rejected = 0;
+    std::size_t                          lines    = 0;
+    csv_line_parser                      parser{format};
+    std::vector<json_bento::key_locator> keys;
+    std::vector<json_bento::key_locator> extraKeys;
+
+    for (const csv_column& col : format.columns)
+      keys.push_back(col.type == csv_type::skip ? json_bento::key_locator{}
+                                                : vector.add_key(col.name));
+
+    for (const csv_extra_column& extra : extras)
+      extraKeys.push_back(vector.add_key(extra.name));
+
+    auto importLine = [&](const std::string& line) -> void {
+      if (parser.parse(line)) {
+        const std::vector<csv_cell>& row    = parser.row();
+        object_writer                writer = vector.push_back_object();
+
+        for (std::size_t c = 0; c < row.size(); ++c)
+          store_csv_cell(writer, keys[c], row[c]);
+
+        for (std::size_t c = 0; c < extras.size(); ++c)
+          writer.add_string(extraKeys[c], extras[c].value(row));
+
+        writer.finish();
+        ++imported;
+      } else if (!parser.is_header()) {
+        ++rejected;
+      }
+
+      if (progress && (++lines % CSV_PROGRESS_LINES == 0))
+        progress(imported, rejected);
+    };
+
+    const std::vector<int> owners =
+        compressed_owners(files, fingerprints(files));
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+      for_all_lines(files[i], owners[i], importLine);
+
+    if (progress) progress(imported, rejected);
+
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
+    refresh_indices();
+
+    std::size_t totalImported = ygmcomm.all_reduce_sum(imported);
+    std::size_t totalRejected = ygmcomm.all_reduce_sum(rejected);
+
+    return {totalImported, totalRejected};
   }
 
 #if METALLDATA_USE_PARQUET
@@ -463,39 +1478,87 @@ struct metall_json_lines {
   /// \param  files       a list of Parquet data files that will be imported
   /// \param  filter      a function that accepts or rejects an JSON item
   /// \param  transformer a function that transforms a JSON entry before it is
-  /// stored \return a summary of how many lines were imported and rejected.
+  ///         stored
+  /// \param  batchsize   max number of rows that are sent at once
+  /// \param  batchbytes  max (approximate) number of bytes in a batch
+  /// \param  progress    if set, called after each batch
+  /// \return a summary of how many lines were imported and rejected.
+  /// \details
+  ///   rows are collected into a batch, which is sent to an owner rank
+  ///   (chosen round-robin) once it is full. Thus, a rank buffers at most
+  ///   one batch, and the number of messages is proportional to the number
+  ///   of batches instead of the number of rows.
   import_summary read_parquet_files(
       const std::vector<std::string>&                       files,
       std::function<bool(const boost::json::value&)>        filter = accept_all,
       std::function<boost::json::value(boost::json::value)> transformer =
-          identity_transformer) {
-    ygm::io::arrow_parquet_parser parquetParser{ygmcomm, files};
-    std::size_t                   imported    = 0;
-    std::size_t                   rejected    = 0;
-    std::size_t const             initialSize = vector.size();
-    metall_allocator_type         alloc       = get_allocator();
-    static metall_json_lines&     ref_self    = *this;
-    const auto&                   schema      = parquetParser.schema();
+          identity_transformer,
+      std::size_t          batchsize  = 4096,
+      std::size_t          batchbytes = DEFAULT_BATCH_BYTES,
+      import_progress_type progress   = {}) {
+    const sorted_index_stamp        before = index_stamp();
+    ygm::io::arrow_parquet_parser   parquetParser{ygmcomm, files};
+    std::size_t                     imported    = 0;
+    std::size_t                     rejected    = 0;
+    std::size_t                     bytes       = 0;
+    std::size_t                     numbatches  = 0;
+    std::size_t const               initialSize = vector.size();
+    static metall_json_lines&       ref_self    = *this;
+    const auto&                     schema      = parquetParser.schema();
+    std::vector<boost::json::value> batch;
+
+    batch.reserve(batchsize);
     ygmcomm.cf_barrier();
 
-    parquetParser.for_all([&imported, &rejected, alloc, &schema, this,
+    auto sendBatch = [this, &batch, &bytes, &numbatches, &imported, &rejected,
+                      &progress]() -> void {
+      if (batch.empty()) return;
+
+      const int owner = (ygmcomm.rank() + numbatches) % ygmcomm.size();
+
+      if (owner == ygmcomm.rank()) {
+        for (const boost::json::value& row : batch) vector.push_back(row);
+      } else {
+        ygmcomm.async(
+            owner,
+            [](auto, const std::vector<boost::json::value>& rows) {
+              for (const boost::json::value& row : rows)
+                ref_self.vector.push_back(row);
+            },
+            batch);
+      }
+
+      ++numbatches;
+      bytes = 0;
+      batch.clear();
+
+      if (progress) progress(imported, rejected);
+    };
+
+    parquetParser.for_all([&imported, &rejected, &schema, &batch, &bytes,
+                           batchsize, batchbytes, &sendBatch,
                            filterFn = std::move(filter),
                            transFn  = std::move(transformer)](
                               auto& stream_reader, const size_t&) -> void {
       boost::json::value jsonLine =
           ygm::io::detail::read_parquet_as_json(stream_reader, schema);
       if (filterFn(jsonLine)) {
-        const auto owner = imported % ygmcomm.size();
-        ygmcomm.async(
-            owner,
-            [](auto, const auto& data) { ref_self.vector.push_back(data); },
-            transFn(jsonLine));
+        batch.emplace_back(transFn(std::move(jsonLine)));
+        bytes += approx_json_bytes(batch.back());
         ++imported;
+
+        if ((batch.size() >= batchsize) || (bytes >= batchbytes)) sendBatch();
       } else {
         ++rejected;
       }
     });
+
+    sendBatch();
     ygmcomm.barrier();
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
 
     // phase 2: compute total number of imported rows
     std::size_t totalImported = ygmcomm.all_reduce_sum(imported);
@@ -506,6 +1569,85 @@ struct metall_json_lines {
     return {totalImported, totalRejected};
   }
 
+  /// imports Parquet files column by column and returns the number of
+  /// imported rows
+  /// \param  files     a list of Parquet data files that will be imported
+  /// \param  progress  if set, called after each record batch
+  /// \return a summary of how many rows were imported
+  /// \details
+  ///   the row groups of all files are distributed round-robin over the
+  ///   ranks; each rank reads its row groups as Arrow record batches.
+  ///   A file's columns are resolved into key locators once, and the values
+  ///   are written from the typed column buffers directly into the
+  ///   container without constructing a JSON value per row.
+  ///   Null entries are stored as null. Values of other than boolean,
+  ///   integer, floating point, and string columns are stored as strings
+  ///   (in Arrow's formatting).
+  import_summary read_parquet_files_columnar(
+      const std::vector<std::string>& files,
+      import_progress_type            progress = {}) {
+    const sorted_index_stamp before   = index_stamp();
+    const std::size_t        rank     = ygmcomm.rank();
+    const std::size_t        numranks = ygmcomm.size();
+    std::size_t              imported = 0;
+    std::size_t              rowgroup = 0;  // row group number across all files
+
+    for (const std::string& file : files) {
+      std::shared_ptr<arrow::io::ReadableFile> infile;
+      PARQUET_ASSIGN_OR_THROW(infile, arrow::io::ReadableFile::Open(file));
+
+      std::unique_ptr<parquet::arrow::FileReader> reader;
+      PARQUET_THROW_NOT_OK(parquet::arrow::OpenFile(
+          infile, arrow::default_memory_pool(), &reader));
+
+      const int numRowGroups = reader->num_row_groups();
+
+      bool readsRowGroup = false;
+
+      for (int g = 0; (g < numRowGroups) && !readsRowGroup; ++g)
+        readsRowGroup = ((rowgroup + g) % numranks == rank);
+
+      if (!readsRowGroup) {
+        rowgroup += numRowGroups;
+        continue;
+      }
+
+      std::shared_ptr<arrow::Schema> schema;
+      PARQUET_THROW_NOT_OK(reader->GetSchema(&schema));
+
+      std::vector<json_bento::key_locator> keys;
+
+      for (const std::shared_ptr<arrow::Field>& field : schema->fields())
+        keys.push_back(vector.add_key(field->name()));
+
+      for (int g = 0; g < numRowGroups; ++g, ++rowgroup) {
+        if (rowgroup % numranks != rank) continue;
+
+        std::shared_ptr<arrow::Table> table;
+        PARQUET_THROW_NOT_OK(reader->ReadRowGroup(g, &table));
+
+        arrow::TableBatchReader             batches(*table);
+        std::shared_ptr<arrow::RecordBatch> batch;
+
+        PARQUET_THROW_NOT_OK(batches.ReadNext(&batch));
+        while (batch) {
+          imported += store_record_batch(*batch, keys);
+
+          if (progress) progress(imported, 0);
+
+          PARQUET_THROW_NOT_OK(batches.ReadNext(&batch));
+        }
+      }
+    }
+
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
+
+    return {ygmcomm.all_reduce_sum(imported), std::size_t(0)};
+  }
+
   /// imports Parquet files and returns the number of imported rows
   import_summary read_parquet_file(std::string file) {
     std::vector<std::string> files;
@@ -524,18 +1666,446 @@ struct metall_json_lines {
   ///       e.g., mjl.filter(...).count();
   /// \{
   metall_json_lines& filter(filter_type fn) {
+    restrict_rows(fn);
     filterfn.emplace_back(std::move(fn));
+    cacheable = false;
     return *this;
   }
 
   metall_json_lines& filter(std::vector<filter_type> fns) {
+    return filter(std::move(fns), std::string_view{});
+  }
+
+  /// \param key identifies the selection made by \ref fns
+  ///        (e.g., the normalized JSON of the predicates). The selected
+  ///        rows are cached under the key in the Metall datastore, so that
+  ///        later calls with the same key do not evaluate the filters again.
+  ///        A read-only datastore uses the cached selections, but does not
+  ///        add any. An empty key disables caching.
+  metall_json_lines& filter(std::vector<filter_type> fns,
+                            std::string_view         key) {
+    if (fns.empty()) return *this;
+
+    if (key.empty())
+      cacheable = false;
+    else
+      selectionkey.append(key);
+
+    for (const filter_type& fn : fns) restrict_rows(fn);
+
     std::move(fns.begin(), fns.end(), std::back_inserter(filterfn));
     return *this;
   }
   /// \}
 
-  /// resets the filter
-  void clear_filter() { filterfn.clear(); }
+  /// stores \ref bits as the cached selection \ref key (see filter), e.g.,
+  ///   a selection computed by a semi join; bit i is set iff local row i is
+  ///   selected. As other cached selections, it is dropped when the rows
+  ///   are modified.
+  /// \return false, if the datastore is read-only
+  bool store_selection(std::string_view                  key,
+                       const std::vector<std::uint64_t>& bits) {
+    selection_cache_type* cache = writable_selections();
+
+    if (!cache) return false;
+
+    cache->store(key, vector.size(), bits);
+    return true;
+  }
+
+  /// \name sampling
+  /// restricts the selected rows to a sample of all rows, so that count and
+  ///   hist can be estimated from a fraction of the rows (see count_estimate
+  ///   and hist_estimate). The sample composes with the filters; it is
+  ///   evaluated before them, and it is neither cached nor reset by filter.
+  ///   A sample with the same seed (and number of ranks) has the same rows.
+  ///   The rows can be sampled once until clear_filter is called.
+  /// \{
+
+  /// samples each row with probability \ref fraction (Bernoulli sampling)
+  metall_json_lines& sample(double fraction, std::uint64_t seed = 0) {
+    add_sample_filter(bernoulli_sample{fraction, seed, ygmcomm.rank()});
+    samplestate = row_sample{row_sample::bernoulli, fraction, 0, 0, seed};
+    return *this;
+  }
+
+  /// samples \ref n rows of all ranks uniformly without replacement;
+  ///   each rank samples a share proportional to its number of rows, in one
+  ///   pass over the row indices (see reservoir_sample_rows). Collective.
+  metall_json_lines& sample_rows(std::size_t n, std::uint64_t seed = 0) {
+    const std::size_t        rank     = ygmcomm.rank();
+    std::vector<std::size_t> numrows(ygmcomm.size(), 0);
+
+    numrows[rank] = vector.size();
+    numrows       = ygmcomm.all_reduce(numrows, msg::elementwise_sum{});
+
+    const std::size_t total =
+        std::accumulate(numrows.begin(), numrows.end(), std::size_t(0));
+    const std::size_t before = std::accumulate(
+        numrows.begin(), numrows.begin() + rank, std::size_t(0));
+
+    n = std::min(n, total);
+
+    // the samples of the ranks [0, upto) have quota(upto) rows
+    auto quota = [n, total](std::size_t upto) -> std::size_t {
+      if (upto == total) return n;
+
+      return std::size_t(double(n) * double(upto) / double(total));
+    };
+
+    auto sampled = std::make_shared<const std::vector<std::size_t>>(
+        reservoir_sample_rows(vector.size(),
+                              quota(before + vector.size()) - quota(before),
+                              seed, rank));
+
+    add_sample_filter(row_set_sample{std::move(sampled)});
+    samplestate = row_sample{row_sample::reservoir,
+                             total ? double(n) / double(total) : 1.0, n, total,
+                             seed};
+    return *this;
+  }
+
+  /// returns the sample that the rows are restricted to, if any
+  const std::optional<row_sample>& current_sample() const {
+    return samplestate;
+  }
+
+  /// returns count of the selected rows, estimated from the sample;
+  ///   exact, without a sample. Collective.
+  sample_estimate count_estimate() const {
+    return estimate_count(count(), samplestate.value_or(row_sample{}));
+  }
+
+  /// returns hist of \ref column_name, with the counts estimated from the
+  ///   sample: an array of {value, estimate, low, high, sampled} on rank 0,
+  ///   where [low, high] is a 95% confidence interval and sampled is the
+  ///   count in the sample. Bins whose estimate is less than \ref min_count
+  ///   are dropped. Collective.
+  boost::json::array hist_estimate(const std::string& column_name,
+                                   std::size_t        max_bins  = 0,
+                                   std::size_t        min_count = 1) const {
+    const row_sample   smpl = samplestate.value_or(row_sample{});
+    boost::json::array res;
+
+    for (auto& [value, cnt] : hist(column_name, max_bins, 1)) {
+      const sample_estimate est = estimate_count(cnt, smpl);
+
+      if (est.value < double(min_count)) continue;
+
+      boost::json::object bin = est.asJson();
+
+      bin["value"]   = std::move(value);
+      bin["sampled"] = cnt;
+      res.emplace_back(std::move(bin));
+    }
+
+    return res;
+  }
+  /// \}
+
+  /// resets the filter and the sample
+  void clear_filter() {
+    filterfn.clear();
+    selectionkey.clear();
+    cacheable = true;
+    rows      = {};
+    bounds.clear();
+    samplestate.reset();
+  }
+
+  /// drops the cached selections;
+  ///   needs to be called after rows are modified without using
+  ///   a mutator of this class (e.g., through at()).
+  void invalidate_selections() {
+    if (selection_cache_type* cache = writable_selections()) cache->clear();
+  }
+
+  /// builds a sorted index over the numeric values of \ref column, which
+  ///   the selections that bound the column use; replaces an existing
+  ///   index. The index becomes stale when the rows are modified, except
+  ///   by read_json, which rebuilds the indices.
+  /// \return false, if the datastore is read-only
+  bool create_index(std::string_view column) {
+    auto& mgr = metallmgr.get_local_manager();
+
+    if (mgr.read_only()) return false;
+
+    if (!indices)
+      indices = mgr.construct<sorted_index_cache_type>(indicesname.c_str())(
+          mgr.get_allocator());
+
+    indices->store(column, build_index(column), index_stamp());
+    return true;
+  }
+
+  /// returns the columns that have a sorted index
+  std::vector<std::string> indexed_columns() const {
+    return indices ? indices->columns() : std::vector<std::string>{};
+  }
+
+  /// builds a zone map over the numeric values of \ref column, i.e., the
+  ///   minimum and maximum value of each block of rows; scans of the
+  ///   selections that bound the column skip the blocks outside the
+  ///   bounds. Appends (e.g., read_json) extend the zone map; other
+  ///   modifications make it stale.
+  /// \return false, if the datastore is read-only
+  bool create_zone_map(std::string_view column) {
+    auto& mgr = metallmgr.get_local_manager();
+
+    if (mgr.read_only()) return false;
+
+    if (!zonemaps)
+      zonemaps = mgr.construct<zone_map_cache_type>(zonemapsname.c_str())(
+          mgr.get_allocator());
+
+    zone_map_type& zm = zonemaps->find_or_add(column);
+
+    zm.clear();
+    extend_zone_map(zm, 0);
+    return true;
+  }
+
+  /// returns the columns that have a zone map
+  std::vector<std::string> zone_mapped_columns() const {
+    return zonemaps ? zonemaps->columns() : std::vector<std::string>{};
+  }
+
+  /// builds the materialized aggregate view \ref def over all local rows
+  ///   (see aggregate_view_cache); hist and groupby without a selection
+  ///   are then answered from the view. Appends (e.g., read_json) extend
+  ///   the view; other modifications make it stale.
+  /// \return false, if the datastore is read-only
+  bool create_aggregate_view(const aggregate_view_definition& def) {
+    auto& mgr = metallmgr.get_local_manager();
+
+    if (def.keys.empty())
+      throw std::invalid_argument{"an aggregate view needs a key column"};
+
+    for (const aggregate_spec& agg : def.aggs)
+      if (agg.second == aggregate_op::count_distinct)
+        throw std::invalid_argument{
+            "count_distinct is not supported by aggregate views"};
+
+    if (mgr.read_only()) return false;
+
+    if (!aggviews)
+      aggviews = mgr.construct<aggregate_view_cache_type>(
+          aggviewsname.c_str())(mgr.get_allocator());
+
+    aggregate_view_type& av = aggviews->find_or_add(def.text());
+
+    av.clear();
+    av.extend(vector, 0, def);
+    av.set_state(index_stamp());
+    return true;
+  }
+
+  /// returns the definitions of the aggregate views
+  std::vector<aggregate_view_definition> aggregate_views() const {
+    std::vector<aggregate_view_definition> res;
+
+    if (aggviews)
+      for (const std::string& name : aggviews->names())
+        res.push_back(aggregate_view_definition::parse(name));
+
+    return res;
+  }
+
+  /// a current aggregate view that answers a query
+  struct aggregate_view_match {
+    const aggregate_view_type* view = nullptr;
+    std::vector<std::size_t>   aggs;  ///< query aggregate -> view aggregate
+    std::size_t                numAggs = 0;  ///< the aggregates of the view
+  };
+
+  /// returns a current aggregate view that groups the rows by \ref keys
+  ///   and has the aggregates \ref aggs; nullopt on all ranks, if a rank
+  ///   has no such view, or if rows are selected. Collective.
+  std::optional<aggregate_view_match> find_aggregate_view(
+      const std::vector<std::string>&    keys,
+      const std::vector<aggregate_spec>& aggs) const {
+    std::optional<aggregate_view_match> res;
+
+    if (aggviews && filterfn.empty() && !samplestate) {
+      const sorted_index_stamp stamp = index_stamp();
+
+      for (const std::string& name : aggviews->names()) {
+        const aggregate_view_type*      av  = aggviews->find(name);
+        const aggregate_view_definition def =
+            aggregate_view_definition::parse(name);
+
+        if (!av->current(stamp) || (def.keys != keys)) continue;
+
+        if (auto match = match_aggregates(*av, def, aggs)) {
+          res = std::move(match);
+          break;
+        }
+      }
+    }
+
+    // the ranks must agree on the source of the aggregates
+    if (ygmcomm.all_reduce_sum(std::size_t(!res)) > 0) return std::nullopt;
+
+    return res;
+  }
+
+  /// the default number of Lloyd iterations of create_knn_index
+  static constexpr std::size_t KNN_INDEX_ITERATIONS = 10;
+
+  /// the maximal number of vectors of a rank that k-means clusters
+  static constexpr std::size_t KNN_INDEX_SAMPLES_PER_RANK = 65536;
+
+  /// builds an IVF index over the numeric arrays of \ref column (see
+  ///   knn_index_cache): k-means, with \ref iterations Lloyd iterations
+  ///   over a sample of the rows, chooses up to \ref lists centroids, and
+  ///   each rank stores its rows in the list of their nearest centroid;
+  ///   replaces an existing index. The vectors have the size of the longest
+  ///   first vector of a rank; rows with other vectors are not indexed.
+  ///   The selection is ignored. Collective.
+  /// \return false, if the datastore is read-only
+  bool create_knn_index(std::string_view column, std::size_t lists,
+                        std::size_t iterations = KNN_INDEX_ITERATIONS) {
+    auto& mgr = metallmgr.get_local_manager();
+
+    if (lists == 0)
+      throw std::invalid_argument{"a knn index needs at least one list"};
+
+    if (mgr.read_only()) return false;
+
+    std::vector<double> vec;
+    std::size_t         dims = 0;
+
+    for (std::size_t i = 0; (i < vector.size()) && (dims == 0); ++i)
+      if (numeric_array_of(vector.at(i), column, vec)) dims = vec.size();
+
+    dims = ygmcomm.all_reduce(
+        dims, [](std::size_t lhs, std::size_t rhs) -> std::size_t {
+          return std::max(lhs, rhs);
+        });
+
+    if (dims == 0)
+      throw std::runtime_error{"no numeric arrays in column " +
+                               std::string(column)};
+
+    // phase 1: sample evenly spaced rows
+    const std::size_t   stride = std::max<std::size_t>(
+        1, vector.size() / KNN_INDEX_SAMPLES_PER_RANK);
+    std::vector<double> samples;
+
+    for (std::size_t i = 0; i < vector.size(); i += stride)
+      if (numeric_array_of(vector.at(i), column, vec) && (vec.size() == dims))
+        samples.insert(samples.end(), vec.begin(), vec.end());
+
+    const std::size_t numSamples = samples.size() / dims;
+
+    // phase 2: the initial centroids, list l is a sample of rank l % ranks
+    const std::size_t        rank  = ygmcomm.rank();
+    const std::size_t        ranks = ygmcomm.size();
+    const std::size_t        mine  = (lists + ranks - 1 - rank) / ranks;
+    std::vector<double>      centroids(lists * dims, 0);
+    std::vector<std::size_t> members(lists, 0);
+
+    for (std::size_t j = 0; (j < mine) && (numSamples > 0); ++j) {
+      const std::size_t l    = rank + j * ranks;
+      const double*     smpl = samples.data() + (j * numSamples / mine) * dims;
+
+      std::copy(smpl, smpl + dims, centroids.begin() + l * dims);
+      members[l] = 1;
+    }
+
+    centroids = ygmcomm.all_reduce(centroids, msg::elementwise_sum{});
+    members   = ygmcomm.all_reduce(members, msg::elementwise_sum{});
+
+    // ranks with fewer samples than lists leave lists without a centroid
+    std::size_t numLists = 0;
+
+    for (std::size_t l = 0; l < lists; ++l) {
+      if (members[l] == 0) continue;
+
+      std::copy_n(centroids.begin() + l * dims, dims,
+                  centroids.begin() + numLists * dims);
+      ++numLists;
+    }
+
+    if (numLists == 0)
+      throw std::runtime_error{"no vectors of size " + std::to_string(dims) +
+                               " in column " + std::string(column)};
+
+    centroids.resize(numLists * dims);
+
+    // phase 3: Lloyd iterations; an empty list keeps its centroid
+    for (std::size_t it = 0; it < iterations; ++it) {
+      std::vector<double>      sums(centroids.size(), 0);
+      std::vector<std::size_t> counts(numLists, 0);
+
+      for (std::size_t s = 0; s < numSamples; ++s) {
+        const double*     smpl = samples.data() + s * dims;
+        const std::size_t l =
+            nearest_centroid(smpl, centroids.data(), numLists, dims);
+
+        for (std::size_t d = 0; d < dims; ++d) sums[l * dims + d] += smpl[d];
+
+        ++counts[l];
+      }
+
+      sums   = ygmcomm.all_reduce(sums, msg::elementwise_sum{});
+      counts = ygmcomm.all_reduce(counts, msg::elementwise_sum{});
+
+      for (std::size_t l = 0; l < numLists; ++l)
+        if (counts[l] > 0)
+          for (std::size_t d = 0; d < dims; ++d)
+            centroids[l * dims + d] = sums[l * dims + d] / double(counts[l]);
+    }
+
+    // phase 4: the inverted lists of all local rows
+    if (!knnindices)
+      knnindices = mgr.construct<knn_index_cache_type>(knnindicesname.c_str())(
+          mgr.get_allocator());
+
+    knn_index_type& idx = knnindices->find_or_add(column);
+
+    idx.assign(centroids, dims);
+    idx.extend(vector, 0);
+    idx.set_state(index_stamp());
+    return true;
+  }
+
+  /// returns the columns that have an IVF index
+  std::vector<std::string> knn_indexed_columns() const {
+    return knnindices ? knnindices->columns() : std::vector<std::string>{};
+  }
+
+  /// returns the current IVF index of \ref column; nullptr on all ranks, if
+  ///   a rank has no such index. Collective.
+  const knn_index_type* find_knn_index(std::string_view column) const {
+    const knn_index_type* res = knnindices ? knnindices->find(column) : nullptr;
+
+    if (res && !res->current(index_stamp())) res = nullptr;
+
+    // the ranks must agree on the rows that a search visits
+    if (ygmcomm.all_reduce_sum(std::size_t(!res)) > 0) return nullptr;
+
+    return res;
+  }
+
+  /// rebuilds the stale sorted indices
+  void refresh_indices() {
+    if (!indices || metallmgr.get_local_manager().read_only()) return;
+
+    const sorted_index_stamp stamp = index_stamp();
+
+    for (const std::string& column : indices->columns()) {
+      if (!indices->find(column)->current(stamp))
+        indices->store(column, build_index(column), stamp);
+    }
+  }
+
+  /// returns a number that changes whenever the local rows are modified
+  ///   through a mutator or invalidate_selections(); other indices (e.g.,
+  ///   of a graph) store it to detect that they are stale.
+  std::uint64_t modification_count() const {
+    return selections ? selections->modifications() : 0;
+  }
 
   //
   // local access/mutator functions
@@ -549,16 +2119,118 @@ struct metall_json_lines {
   /// appends a single element to the local container
   /// \{
   accessor_type append_local(const boost::json::value& val = {}) {
+    const sorted_index_stamp before = index_stamp();
+
     // No benefit of moving boost object to JSON Bento now.
     vector.push_back(val);
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
     return vector.back();
   }
 
+  /// the writer that append_objects passes to its row function
+  using object_writer_type = lines_type::object_writer;
+
+  /// appends \ref n objects to the local container, without constructing
+  ///   intermediate JSON values (e.g., for generated rows)
+  /// \param columns  the keys of the objects' fields
+  /// \param writeRow called as writeRow(i, writer, keys) to add the fields
+  ///        of the i-th object, where keys[j] is the locator of columns[j]
+  ///        (e.g., writer.add_uint64(keys[0], i))
+  /// \return n
+  template <class WriteRow>
+  std::size_t append_objects(const std::vector<std::string_view>& columns,
+                             std::size_t n, WriteRow writeRow) {
+    const sorted_index_stamp             before = index_stamp();
+    std::vector<json_bento::key_locator> keys;
+
+    for (std::string_view col : columns) keys.push_back(vector.add_key(col));
+
+    for (std::size_t i = 0; i < n; ++i) {
+      object_writer_type writer = vector.push_back_object();
+
+      writeRow(i, writer, std::as_const(keys));
+      writer.finish();
+    }
+
+    invalidate_selections();
+    extend_zone_maps(before);
+    extend_aggregate_views(before);
+    extend_knn_indices(before);
+    refresh_indices();
+    return n;
+  }
+
   template <class JsonValue>
   void reserve(const JsonValue& val, std::size_t n) {
     vector.reserve(val, n);
   }
 
+  /// declares top-level keys whose position in each row is kept in a
+  /// persistent column index, so filters and projections on these keys
+  /// do not scan the row's key list.
+  void index_keys(const std::vector<std::string>& keys) {
+    for (const std::string& key : keys) vector.index_key(key);
+  }
+
+  /// returns the keys declared through index_keys
+  std::vector<std::string> indexed_keys() const {
+    return vector.indexed_keys();
+  }
+
+  /// rows with \ref threshold or more top-level keys keep their keys sorted,
+  /// so that key lookups in wide rows (e.g., Parquet imports) take O(log n).
+  /// \param threshold minimum row width; 0 disables sorted keys.
+  void sort_keys_of_wide_rows(std::size_t threshold) {
+    vector.sort_keys_of_wide_objects(threshold);
+  }
+
+  /// arrays of at least \ref threshold numbers (e.g., ID lists, timestamps)
+  ///   are stored packed instead of one value locator per element.
+  /// \param threshold minimum array size; 0 stores all arrays unpacked.
+  void pack_numeric_arrays(std::size_t threshold) {
+    vector.pack_numeric_arrays(threshold);
+  }
+
+  /// turns on/off string interning, so repeated string values
+  /// (e.g., subreddit, author) are stored once per rank.
+  void intern_strings(bool enable) { vector.intern_strings(enable); }
+
+  /// stores the long string values of \ref keys (e.g., selftext, body) in
+  ///   compressed blocks; values are decompressed when they are read.
+  /// \param minlen strings shorter than minlen are stored uncompressed
+  /// \throws std::runtime_error if built without METALLDATA_USE_ZSTD
+  void compress_keys(const std::vector<std::string>& keys,
+                     std::size_t                     minlen = 256) {
+    for (const std::string& key : keys)
+      if (!vector.compress_key(key, minlen))
+        throw std::runtime_error{"string compression is not available "
+                                 "(built without METALLDATA_USE_ZSTD)"};
+  }
+
+  /// sets how rows' arrays and objects are allocated:
+  /// "individual" (default), "slab" (small ones come from large chunks),
+  /// or "bump" (slab without reuse, for immutable imports).
+  /// Only allowed while the container is empty.
+  void row_allocation(std::string_view mode) {
+    using json_bento::row_allocation_mode;
+
+    row_allocation_mode m = row_allocation_mode::individual;
+
+    if (mode == "slab")
+      m = row_allocation_mode::slab;
+    else if (mode == "bump")
+      m = row_allocation_mode::bump;
+    else if (mode != "individual")
+      throw std::invalid_argument{"unknown row allocation mode: " +
+                                  std::string(mode)};
+
+    if (!vector.set_row_allocation(m))
+      throw std::logic_error{"row allocation can only be set when empty"};
+  }
+
   //~ accessor_type append_local() { return append_local(boost::json::value{});
   //}
   /// \}
@@ -627,6 +2299,12 @@ struct metall_json_lines {
 
   static bool accept_all(const boost::json::value&) { return true; }
 
+  /// default max number of bytes in an import batch
+  static constexpr std::size_t DEFAULT_BATCH_BYTES = 64 * 1024 * 1024;
+
+  /// number of lines between two progress calls of read_csv_files
+  static constexpr std::size_t CSV_PROGRESS_LINES = 64 * 1024;
+
   static boost::json::value identity_transformer(boost::json::value val) {
     return val;
   }
@@ -636,10 +2314,746 @@ struct metall_json_lines {
   metall::utility::metall_mpi_adaptor& metallmgr;
   lines_type&                          vector;
   std::vector<filter_type>             filterfn = {};
+  std::string                          selectionsname;
+  mutable selection_cache_type*        selections = nullptr;
+  std::string                          selectionkey;
+  bool                                 cacheable = true;
+  row_range                            rows;  ///< bound of the selected rows
+  std::vector<column_bounds>           bounds;  ///< bounds of the selection
+  std::optional<row_sample>            samplestate;
+  std::string                          manifestname;
+  std::string                          indicesname;
+  sorted_index_cache_type*             indices = nullptr;
+  std::string                          zonemapsname;
+  zone_map_cache_type*                 zonemaps = nullptr;
+  std::string                          aggviewsname;
+  aggregate_view_cache_type*           aggviews = nullptr;
+  std::string                          knnindicesname;
+  knn_index_cache_type*                knnindices = nullptr;
+  std::size_t                          scanthreads = 1;
+
+  static constexpr char const* SELECTIONS_NAME = "mjl-selections";
+  static constexpr char const* MANIFEST_NAME   = "mjl-manifest";
+  static constexpr char const* INDICES_NAME    = "mjl-indices";
+  static constexpr char const* ZONE_MAPS_NAME  = "mjl-zonemaps";
+  static constexpr char const* AGGREGATE_VIEWS_NAME = "mjl-aggviews";
+  static constexpr char const* KNN_INDICES_NAME     = "mjl-knnindices";
+
+  ingest_manifest_type* find_manifest() {
+    return metallmgr.get_local_manager()
+        .find<ingest_manifest_type>(manifestname.c_str())
+        .first;
+  }
+
+  /// returns the ingest manifest; creates it if it does not exist and
+  ///   the datastore is writable.
+  ingest_manifest_type* writable_manifest() {
+    auto& mgr = metallmgr.get_local_manager();
+
+    if (ingest_manifest_type* manifest = find_manifest()) return manifest;
+    if (mgr.read_only()) return nullptr;
+
+    return mgr.construct<ingest_manifest_type>(manifestname.c_str())(
+        mgr.get_allocator());
+  }
+
+  /// computes the fingerprints of \ref files;
+  ///   each file is read by a single rank.
+  /// returns the owner ranks of the compressed files that a single rank
+  ///   reads (see assign_compressed_files); -1 for the other files.
+  std::vector<int> compressed_owners(
+      const std::vector<std::string>&      files,
+      const std::vector<file_fingerprint>& prints) const {
+    std::vector<std::uint64_t> sizes;
+
+    for (const file_fingerprint& fp : prints) sizes.push_back(fp.size);
+
+    return assign_compressed_files(files, sizes, ygmcomm.size());
+  }
+
+  /// adds a sample as the first filter, so that rows outside the sample
+  ///   are rejected before other filters are evaluated
+  void add_sample_filter(filter_type fn) {
+    if (samplestate) throw std::logic_error{"the rows are sampled already"};
+
+    filterfn.insert(filterfn.begin(), std::move(fn));
+    cacheable = false;
+  }
+
+  /// calls \ref fn with the lines of \ref file that this rank reads
+  /// \param owner the rank that reads a compressed file that cannot be split
+  template <class Fn>
+  void for_all_lines(const std::string& file, int owner, Fn&& fn) const {
+    const file_compression comp = compression_of(file);
+
+    if (comp == file_compression::none) {
+      ygm::io::line_parser lineParser{ygmcomm, {file}};
+
+      lineParser.for_all(fn);
+      return;
+    }
+
+    compressed_line_reader reader{file, comp, ygmcomm.rank(), ygmcomm.size(),
+                                  owner};
+
+    reader.for_all(std::ref(fn));
+  }
+
+  std::vector<file_fingerprint> fingerprints(
+      const std::vector<std::string>& files) const {
+    const std::size_t        rank     = ygmcomm.rank();
+    const std::size_t        numranks = ygmcomm.size();
+    std::vector<std::size_t> fields(files.size() * 3, 0);
+
+    for (std::size_t i = rank; i < files.size(); i += numranks) {
+      const file_fingerprint fp = file_fingerprint::of(files[i]);
+
+      fields[3 * i]     = fp.size;
+      fields[3 * i + 1] = fp.mtime;
+      fields[3 * i + 2] = fp.hash;
+    }
+
+    fields = ygmcomm.all_reduce(fields, msg::elementwise_sum{});
+
+    std::vector<file_fingerprint> res;
+
+    for (std::size_t i = 0; i < files.size(); ++i)
+      res.push_back(file_fingerprint{fields[3 * i],
+                                     std::int64_t(fields[3 * i + 1]),
+                                     fields[3 * i + 2]});
+
+    return res;
+  }
+
+  /// narrows the rows that the scans visit, if \ref fn is a
+  ///   row_range_hint or a column_bounds_hint. A row_range_hint is ignored
+  ///   when fields of the rows may be named rowid or mpiid, as the rules
+  ///   then refer to the fields.
+  void restrict_rows(const filter_type& fn) {
+    if (const column_bounds_hint* hint = fn.target<column_bounds_hint>()) {
+      bounds.insert(bounds.end(), hint->bounds.begin(), hint->bounds.end());
+      return;
+    }
+
+    const row_range_hint* hint = fn.target<row_range_hint>();
+
+    if (!hint || vector.contains_key("rowid") || vector.contains_key("mpiid"))
+      return;
+
+    rows.intersect(hint->range);
+  }
+
+  /// returns the state of the rows that the sorted indices are built from
+  sorted_index_stamp index_stamp() const {
+    return {vector.size(), modification_count()};
+  }
+
+  /// returns the value of \ref column in \ref row, if it is a number
+  static std::optional<double> numeric_value(const accessor_type& row,
+                                             std::string_view     column) {
+    if (!row.is_object()) return std::nullopt;
+
+    const auto obj = row.as_object();
+    const auto fld = obj.if_contains(column);
+
+    if (!fld) return std::nullopt;
+    if (fld->is_int64()) return double(fld->as_int64());
+    if (fld->is_uint64()) return double(fld->as_uint64());
+    if (fld->is_double()) return fld->as_double();
+
+    return std::nullopt;
+  }
+
+  /// returns the index of \ref column, built from the local rows
+  sorted_index_buffer build_index(std::string_view column) const {
+    sorted_index_buffer res;
+
+    for (std::size_t i = 0; i < vector.size(); ++i) {
+      if (const auto val = numeric_value(vector.at(i), column))
+        res.entries.emplace_back(*val, i);
+      else
+        res.others.push_back(i);
+    }
+
+    return res;
+  }
+
+  /// adds the rows from \ref first to the zone map \ref zm
+  void extend_zone_map(zone_map_type& zm, std::size_t first) const {
+    const std::string_view column = zm.name();
+
+    for (std::size_t i = first; i < vector.size(); ++i)
+      zm.add(i, numeric_value(vector.at(i), column));
+
+    zm.set_state(index_stamp());
+  }
+
+  /// extends the zone maps that are current for the rows in state
+  ///   \ref before by the rows appended since
+  void extend_zone_maps(const sorted_index_stamp& before) {
+    if (!zonemaps || metallmgr.get_local_manager().read_only()) return;
+
+    zonemaps->for_all_zone_maps([this, &before](zone_map_type& zm) -> void {
+      if (zm.current(before)) extend_zone_map(zm, before.numrows);
+    });
+  }
+
+  /// extends the aggregate views that are current for the rows in state
+  ///   \ref before by the rows appended since
+  void extend_aggregate_views(const sorted_index_stamp& before) {
+    if (!aggviews || metallmgr.get_local_manager().read_only()) return;
+
+    aggviews->for_all_views([this, &before](aggregate_view_type& av) -> void {
+      if (!av.current(before)) return;
+
+      av.extend(vector, before.numrows,
+                aggregate_view_definition::parse(av.name()));
+      av.set_state(index_stamp());
+    });
+  }
+
+  /// extends the IVF indices that are current for the rows in state
+  ///   \ref before by the rows appended since
+  void extend_knn_indices(const sorted_index_stamp& before) {
+    if (!knnindices || metallmgr.get_local_manager().read_only()) return;
+
+    knnindices->for_all_indices([this, &before](knn_index_type& idx) -> void {
+      if (!idx.current(before)) return;
+
+      idx.extend(vector, before.numrows);
+      idx.set_state(index_stamp());
+    });
+  }
+
+  /// maps the aggregates \ref aggs to the aggregates of view \ref av;
+  ///   nullopt, if the view lacks one of them, or if it cannot order the
+  ///   values of a min or max aggregate.
+  static std::optional<aggregate_view_match> match_aggregates(
+      const aggregate_view_type& av, const aggregate_view_definition& def,
+      const std::vector<aggregate_spec>& aggs) {
+    aggregate_view_match res{&av, {}, def.aggs.size()};
+
+    for (const aggregate_spec& agg : aggs) {
+      const auto pos = std::find(def.aggs.begin(), def.aggs.end(), agg);
+
+      if (pos == def.aggs.end()) return std::nullopt;
+
+      const std::size_t a = std::distance(def.aggs.begin(), pos);
+
+      if ((agg.second == aggregate_op::min) ||
+          (agg.second == aggregate_op::max)) {
+        for (std::size_t g = 0; g < av.size(); ++g)
+          if (av.partial(g, a, res.numAggs).strings) return std::nullopt;
+      }
+
+      res.aggs.push_back(a);
+    }
+
+    return res;
+  }
+
+  /// returns the row ranges that can contain selected rows, from the
+  ///   current zone map that skips the most rows; nullopt, if no zone map
+  ///   skips rows.
+  std::optional<std::vector<row_range>> zone_ranges() const {
+    if (!zonemaps || bounds.empty()) return std::nullopt;
+
+    std::optional<std::vector<row_range>> res;
+
+    const sorted_index_stamp stamp    = index_stamp();
+    const std::size_t        lim      = std::min(rows.lim, vector.size());
+    const row_range          visible  = {rows.beg, lim};
+    std::size_t              resCount = visible.empty() ? 0 : lim - rows.beg;
+
+    for (const column_bounds& bnd : bounds) {
+      const auto* zm = zonemaps->find(bnd.column);
+
+      if (!zm || !zm->current(stamp)) continue;
+
+      std::vector<row_range> ranges = zm->ranges(visible, bnd.lo, bnd.hi);
+      const std::size_t      cnt    = zone_map_type::count(ranges);
+
+      if (cnt >= resCount) continue;
+
+      res      = std::move(ranges);
+      resCount = cnt;
+    }
+
+    return res;
+  }
+
+  /// returns the candidate rows of the selection's bounds from the
+  ///   current index with the fewest candidates; nullopt, if no index
+  ///   narrows the rows.
+  std::optional<std::vector<std::size_t>> index_candidates() const {
+    if (!indices || bounds.empty()) return std::nullopt;
+
+    const sorted_index_stamp              stamp     = index_stamp();
+    const column_bounds*                  best      = nullptr;
+    const sorted_index_cache_type::index* bestIndex = nullptr;
+    std::size_t                           bestCount = vector.size();
+
+    for (const column_bounds& bnd : bounds) {
+      const auto* idx = indices->find(bnd.column);
+
+      if (!idx || !idx->current(stamp)) continue;
+
+      const std::size_t cnt = idx->count(bnd.lo, bnd.hi);
+
+      if (cnt >= bestCount) continue;
+
+      best      = &bnd;
+      bestIndex = idx;
+      bestCount = cnt;
+    }
+
+    if (!best) return std::nullopt;
+
+    return bestIndex->candidates(best->lo, best->hi);
+  }
+
+  /// evaluates the filters for the selected rows, using a sorted index
+  ///   when one narrows the rows
+  template <class Fn>
+  void scan_selected_rows(Fn fn, std::size_t maxrows) const {
+    if (auto candidates = index_candidates())
+      return _for_all_candidates(std::move(fn), vector, filterfn,
+                                 *candidates, rows, maxrows);
+
+    if (auto ranges = zone_ranges()) {
+      for (const row_range& rng : *ranges) {
+        if (maxrows == 0) return;
+
+        maxrows -= _for_all_selected(std::ref(fn), vector, filterfn, rng,
+                                     maxrows);
+      }
+
+      return;
+    }
+
+    _for_all_selected(std::move(fn), vector, filterfn, rows, maxrows);
+  }
+
+  void find_indices() {
+    indices = metallmgr.get_local_manager()
+                  .find<sorted_index_cache_type>(indicesname.c_str())
+                  .first;
+    zonemaps = metallmgr.get_local_manager()
+                   .find<zone_map_cache_type>(zonemapsname.c_str())
+                   .first;
+    aggviews = metallmgr.get_local_manager()
+                   .find<aggregate_view_cache_type>(aggviewsname.c_str())
+                   .first;
+    knnindices = metallmgr.get_local_manager()
+                     .find<knn_index_cache_type>(knnindicesname.c_str())
+                     .first;
+  }
+
+  void find_selections() {
+    selections = metallmgr.get_local_manager()
+                     .find<selection_cache_type>(selectionsname.c_str())
+                     .first;
+  }
+
+  /// returns the selection cache; creates it if it does not exist and
+  ///   the datastore is writable.
+  selection_cache_type* writable_selections() const {
+    auto& mgr = metallmgr.get_local_manager();
+
+    if (selections || mgr.read_only()) return selections;
+
+    selections = mgr.construct<selection_cache_type>(selectionsname.c_str())(
+        mgr.get_allocator());
+    return selections;
+  }
+
+  /// returns the cached bitmap of the selection, or nullptr; records the
+  ///   use only if the datastore is writable.
+  const selection_cache_type::bitmap_type* cached_selection() const {
+    if (!selections) return nullptr;
+
+    if (metallmgr.get_local_manager().read_only())
+      return selections->lookup(selectionkey, vector.size());
+
+    return selections->find(selectionkey, vector.size());
+  }
+
+  /// calls fn for each selected row (up to maxrows).
+  ///   uses the cached selection if one exists; otherwise, evaluates the
+  ///   filters and caches the selection (only if all rows are visited).
+  template <class Fn>
+  void for_all_selected_rows(
+      Fn          fn,
+      std::size_t maxrows = std::numeric_limits<std::size_t>::max()) const {
+    constexpr std::size_t all = std::numeric_limits<std::size_t>::max();
+
+    if (filterfn.empty() || !cacheable)
+      return scan_selected_rows(std::move(fn), maxrows);
+
+    if (const auto* bits = cached_selection())
+      return _for_all_cached(std::move(fn), vector, *bits, maxrows);
+
+    selection_cache_type* cache = (maxrows == all) ? writable_selections()
+                                                   : nullptr;
+
+    if (!cache) return scan_selected_rows(std::move(fn), maxrows);
+
+    std::vector<std::uint64_t> bits;
+    std::size_t const          numrows = vector.size();
+
+    scan_selected_rows(
+        [&bits, &fn](std::size_t rownum, auto&& row) -> void {
+          selection_cache_type::set(bits, rownum);
+          fn(rownum, row);
+        },
+        all);
+
+    cache->store(selectionkey, numrows, bits);
+  }
+
+  /// calls fn(thread, rownum, row) for each selected row on scan_threads()
+  ///   threads (see parallel_chunks); thread is in [0, scan_threads()).
+  ///   As for_all_selected_rows, uses the cached selection if one exists,
+  ///   and otherwise caches the selection.
+  /// \pre fn only modifies the partial results of its thread, and the
+  ///      filters can be evaluated concurrently.
+  template <class Fn>
+  void parallel_for_all_selected_rows(Fn fn) const {
+    if (scanthreads <= 1) {
+      return for_all_selected_rows(
+          [&fn](std::size_t rownum, auto&& row) -> void {
+            fn(0, rownum, row);
+          });
+    }
+
+    if (filterfn.empty() || !cacheable)
+      return parallel_scan_selected_rows(fn, nullptr);
+
+    if (const auto* bits = cached_selection())
+      return parallel_for_all_cached(fn, *bits);
+
+    selection_cache_type* cache = writable_selections();
+
+    if (!cache) return parallel_scan_selected_rows(fn, nullptr);
+
+    std::vector<std::vector<std::size_t>> selected(scanthreads);
+    std::vector<std::uint64_t>            bits;
+    std::size_t const                     numrows = vector.size();
+
+    parallel_scan_selected_rows(fn, &selected);
+
+    for (const std::vector<std::size_t>& rownums : selected)
+      for (std::size_t rownum : rownums)
+        selection_cache_type::set(bits, rownum);
+
+    cache->store(selectionkey, numrows, bits);
+  }
+
+  /// evaluates the filters as scan_selected_rows, on scan_threads() threads
+  /// \param selected if not null, the rows selected by thread t are added
+  ///        to (*selected)[t]
+  template <class Fn>
+  void parallel_scan_selected_rows(
+      Fn& fn, std::vector<std::vector<std::size_t>>* selected) const {
+    perf_scope perf{perf_region::scan};
+
+    std::optional<std::vector<std::size_t>> candidates = index_candidates();
+    std::vector<row_range>                  ranges;
+    std::vector<std::size_t>                offsets = {0};
+    std::size_t const lim = std::min(vector.size(), rows.lim);
+
+    // the rows are items [offsets[r], offsets[r+1]) of ranges[r], or the
+    //   candidates in [rows.beg, lim)
+    if (candidates) {
+      std::erase_if(*candidates, [this, lim](std::size_t i) -> bool {
+        return (i < rows.beg) || (i >= lim);
+      });
+    } else if (auto zones = zone_ranges()) {
+      ranges = std::move(*zones);
+    } else {
+      ranges.push_back(rows);
+    }
+
+    for (const row_range& rng : ranges) {
+      const std::size_t rnglim = std::min(vector.size(), rng.lim);
+
+      offsets.push_back(offsets.back() +
+                        (rnglim > rng.beg ? rnglim - rng.beg : 0));
+    }
+
+    const std::size_t numItems =
+        candidates ? candidates->size() : offsets.back();
+    std::vector<std::size_t> numSelected(scanthreads, 0);
+
+    parallel_chunks(
+        numItems, scanthreads,
+        [&](std::size_t thread, std::size_t beg, std::size_t end) -> void {
+          auto threadFn = [&fn, thread](std::size_t rownum,
+                                        auto&&      row) -> void {
+            fn(thread, rownum, row);
+          };
+          std::size_t numsel = 0;
+          std::size_t r =
+              std::upper_bound(offsets.begin(), offsets.end(), beg) -
+              offsets.begin() - 1;
+
+          for (std::size_t item = beg; item < end; ++item) {
+            std::size_t rownum = 0;
+
+            if (candidates) {
+              rownum = (*candidates)[item];
+            } else {
+              while (item >= offsets[r + 1]) ++r;
+
+              rownum = ranges[r].beg + (item - offsets[r]);
+            }
+
+            if (filterfn.empty()) {
+              threadFn(rownum, vector.at(rownum));
+            } else if (!_select_row(threadFn, vector, filterfn, rownum)) {
+              continue;
+            }
+
+            ++numsel;
+            if (selected) (*selected)[thread].push_back(rownum);
+          }
+
+          numSelected[thread] += numsel;
+        });
+
+    perf.rows(numItems);
+    scan_counters::add(numItems, std::accumulate(numSelected.begin(),
+                                                 numSelected.end(),
+                                                 std::size_t(0)));
+  }
+
+  /// calls fn for the rows of the cached selection \ref bits on
+  ///   scan_threads() threads (see _for_all_cached)
+  template <class Fn, class Bitmap>
+  void parallel_for_all_cached(Fn& fn, const Bitmap& bits) const {
+    std::vector<std::size_t> visited(scanthreads, 0);
+
+    parallel_chunks(
+        bits.size(), scanthreads,
+        [&](std::size_t thread, std::size_t beg, std::size_t end) -> void {
+          std::size_t numvisited = 0;
+
+          for (std::size_t w = beg; w < end; ++w) {
+            for (std::uint64_t word = bits[w]; word != 0; word &= word - 1) {
+              const std::size_t rownum = w * 64 + std::countr_zero(word);
+
+              ++numvisited;
+
+              try {
+                fn(thread, rownum, vector.at(rownum));
+              } catch (...) { /* \todo filter functions must not throw */
+              }
+            }
+          }
+
+          visited[thread] += numvisited;
+        });
+
+    const std::size_t total =
+        std::accumulate(visited.begin(), visited.end(), std::size_t(0));
+
+    // the cached selection visits only the selected rows
+    scan_counters::add(total, total);
+  }
 
   bool isMainRank() const { return 0 == ygmcomm.rank(); }
   bool isLastRank() const { return 1 == ygmcomm.size() - ygmcomm.rank(); }
 
+#if METALLDATA_USE_PARQUET
+  /// appends the rows of \ref batch as objects;
+  ///   keys[i] is the key locator of the batch's i-th column.
+  /// \return the number of appended rows
+  std::size_t store_record_batch(
+      const arrow::RecordBatch&                   batch,
+      const std::vector<json_bento::key_locator>& keys) {
+    using object_writer = lines_type::object_writer;
+
+    std::vector<std::shared_ptr<arrow::Array>> columns;
+
+    for (int c = 0; c < batch.num_columns(); ++c)
+      columns.emplace_back(batch.column(c));
+
+    for (std::int64_t row = 0; row < batch.num_rows(); ++row) {
+      object_writer writer = vector.push_back_object();
+
+      for (std::size_t c = 0; c < columns.size(); ++c)
+        store_cell(writer, keys[c], *columns[c], row);
+
+      writer.finish();
+    }
+
+    return batch.num_rows();
+  }
+
+  /// adds the value at \ref row of column \ref col to an object
+  template <class ObjectWriter>
+  static void store_cell(ObjectWriter& writer, json_bento::key_locator key,
+                         const arrow::Array& col, std::int64_t row) {
+    if (col.IsNull(row)) return writer.add_null(key);
+
+    switch (col.type_id()) {
+      case arrow::Type::BOOL:
+        return writer.add_bool(
+            key, static_cast<const arrow::BooleanArray&>(col).Value(row));
+      case arrow::Type::INT8:
+        return writer.add_int64(
+            key, static_cast<const arrow::Int8Array&>(col).Value(row));
+      case arrow::Type::INT16:
+        return writer.add_int64(
+            key, static_cast<const arrow::Int16Array&>(col).Value(row));
+      case arrow::Type::INT32:
+        return writer.add_int64(
+            key, static_cast<const arrow::Int32Array&>(col).Value(row));
+      case arrow::Type::INT64:
+        return writer.add_int64(
+            key, static_cast<const arrow::Int64Array&>(col).Value(row));
+      case arrow::Type::UINT8:
+        return writer.add_uint64(
+            key, static_cast<const arrow::UInt8Array&>(col).Value(row));
+      case arrow::Type::UINT16:
+        return writer.add_uint64(
+            key, static_cast<const arrow::UInt16Array&>(col).Value(row));
+      case arrow::Type::UINT32:
+        return writer.add_uint64(
+            key, static_cast<const arrow::UInt32Array&>(col).Value(row));
+      case arrow::Type::UINT64:
+        return writer.add_uint64(
+            key, static_cast<const arrow::UInt64Array&>(col).Value(row));
+      case arrow::Type::FLOAT:
+        return writer.add_double(
+            key, static_cast<const arrow::FloatArray&>(col).Value(row));
+      case arrow::Type::DOUBLE:
+        return writer.add_double(
+            key, static_cast<const arrow::DoubleArray&>(col).Value(row));
+      case arrow::Type::STRING: {
+        const auto str =
+            static_cast<const arrow::StringArray&>(col).GetView(row);
+
+        return writer.add_string(key, {str.data(), str.size()});
+      }
+      case arrow::Type::LARGE_STRING: {
+        const auto str =
+            static_cast<const arrow::LargeStringArray&>(col).GetView(row);
+
+        return writer.add_string(key, {str.data(), str.size()});
+      }
+      default:;
+    }
+
+    std::shared_ptr<arrow::Scalar> scalar;
+
+    PARQUET_ASSIGN_OR_THROW(scalar, col.GetScalar(row));
+    writer.add_string(key, scalar->ToString());
+  }
+#endif
+
+  /// adds a parsed CSV cell to an object
+  template <class ObjectWriter>
+  static void store_csv_cell(ObjectWriter& writer, json_bento::key_locator key,
+                             const csv_cell& cell) {
+    switch (cell.type) {
+      case csv_type::null:
+        return writer.add_null(key);
+      case csv_type::string:
+        return writer.add_string(key, cell.s);
+      case csv_type::int64:
+        return writer.add_int64(key, cell.i);
+      case csv_type::uint64:
+        return writer.add_uint64(key, cell.u);
+      case csv_type::real:
+        return writer.add_double(key, cell.d);
+      case csv_type::boolean:
+        return writer.add_bool(key, cell.b);
+      default:;  // skipped column
+    }
+  }
+
+  /// sends each local row i to rank dests[i], if that is not this rank.
+  ///   the moved rows are removed from the local container, and the
+  ///   received rows are appended to it.
+  void move_rows(const std::vector<std::size_t>& dests) {
+    static constexpr std::size_t batchsize = 1024;
+
+    const std::size_t                            rank = ygmcomm.rank();
+    std::vector<std::vector<boost::json::value>> outgoing(ygmcomm.size());
+
+    for (std::size_t i = 0; i < dests.size(); ++i) {
+      if (dests[i] != rank)
+        outgoing[dests[i]].emplace_back(
+            json_bento::value_to<boost::json::value>(vector.at(i)));
+    }
+
+    vector.remove_if([&dests, rank](std::size_t i, const accessor_type&) {
+      return dests[i] != rank;
+    });
+
+    msg::process_data_mjl::row_sink_type sink =
+        [this](std::vector<boost::json::value>& rows) -> void {
+      for (const boost::json::value& row : rows) vector.push_back(row);
+    };
+
+    msg::mjlState = msg::process_data_mjl{nullptr, nullptr, &sink};
+
+    // all ranks need to have removed their outgoing rows before rows arrive
+    ygmcomm.cf_barrier();
+
+    for (std::size_t dest = 0; dest < outgoing.size(); ++dest) {
+      std::vector<boost::json::value>& rows = outgoing[dest];
+
+      for (std::size_t i = 0; i < rows.size(); i += batchsize) {
+        const std::size_t lim = std::min(rows.size(), i + batchsize);
+
+        ygmcomm.async(dest, msg::row_transfer{},
+                      std::vector<boost::json::value>(rows.begin() + i,
+                                                      rows.begin() + lim));
+      }
+
+      rows.clear();
+    }
+
+    ygmcomm.barrier();
+    msg::mjlState = msg::process_data_mjl{nullptr, nullptr};
+    invalidate_selections();
+  }
+
+  /// returns the value of column \ref column_name of a row, or an empty
+  ///   optional if the row has no such column
+  static std::optional<boost::json::value> column_value(
+      const accessor_type& acs, const std::string& column_name) {
+    assert(acs.is_object());
+    const auto obj = acs.as_object();
+    if (!obj.contains(column_name)) {
+      return std::nullopt;
+    }
+    boost::json::value value;
+    json_bento::value_to(obj.at(column_name), value);
+    return value;
+  }
+
+  /// orders histogram bins by descending count (ties by value) and keeps
+  ///   the first max_bins bins (all if max_bins == 0).
+  static void trim_bins(std::vector<std::pair<std::string, std::size_t>>& bins,
+                        std::size_t max_bins) {
+    auto byCount = [](const auto& lhs, const auto& rhs) {
+      if (lhs.second != rhs.second) return lhs.second > rhs.second;
+      return lhs.first < rhs.first;
+    };
+
+    if (max_bins > 0 && max_bins < bins.size()) {
+      std::partial_sort(bins.begin(), bins.begin() + max_bins, bins.end(),
+                        byCount);
+      bins.resize(max_bins);
+      return;
+    }
+
+    std::sort(bins.begin(), bins.end(), byCount);
+  }
+
   static constexpr char const* ERR_OPEN =
       "unable to open metall_json_lines object";
   static constexpr char const* ERR_CONSTRUCT =
@@ -0,0 +1,125 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines batch method, which runs several
+///        count, head, and hist calls on the current selection in one pass.
+
+#include <algorithm>
+#include <cstdint>
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines-fused.hpp"
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "batch";
+const std::string METHOD_DOCSTRING =
+    "Runs a list of method calls on the current selection with one open "
+    "datastore and one pass over the selected rows; returns the list of "
+    "their results.";
+
+const std::string ARG_CALLS_NAME = "calls";
+const std::string ARG_CALLS_DESC =
+    "list of calls, e.g., [{\"method\": \"count\"}, {\"method\": \"head\", "
+    "\"num\": 5, \"columns\": []}, {\"method\": \"hist\", \"col\": \"author\", "
+    "\"max_bins\": 0, \"min_count\": 1}]";
+
+/// returns the integer argument \ref name of \ref call, or \ref dflt
+std::size_t call_arg(const boost::json::object& call, std::string_view name,
+                     std::size_t dflt) {
+  const boost::json::value* val = call.if_contains(name);
+
+  if (!val) return dflt;
+
+  return std::max<std::int64_t>(0, boost::json::value_to<std::int64_t>(*val));
+}
+
+/// adds \ref call to \ref scan
+void add_call(xpr::fused_scan& scan, const boost::json::object& call) {
+  const boost::json::value* method = call.if_contains("method");
+
+  if (!method || !method->is_string())
+    throw std::invalid_argument{"call without a method"};
+
+  const boost::json::string& name = method->as_string();
+
+  if (name == "count") {
+    const boost::json::value* all = call.if_contains("count_all");
+
+    scan.add_count(all && all->is_bool() && all->as_bool());
+    return;
+  }
+
+  if (name == "head") {
+    ColumnSelector columns;
+
+    if (const boost::json::value* cols = call.if_contains("columns"))
+      columns = boost::json::value_to<ColumnSelector>(*cols);
+
+    scan.add_head(call_arg(call, "num", 5), projector(std::move(columns)));
+    return;
+  }
+
+  if (name == "hist") {
+    const boost::json::value* col = call.if_contains("col");
+
+    if (!col || !col->is_string())
+      throw std::invalid_argument{"hist without a column"};
+
+    scan.add_hist(std::string(col->as_string().c_str()),
+                  call_arg(call, "max_bins", 0),
+                  call_arg(call, "min_count", 1));
+    return;
+  }
+
+  throw std::invalid_argument{"unsupported method in batch: " +
+                              std::string(name.c_str())};
+}
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<JsonExpression>(ARG_CALLS_NAME, ARG_CALLS_DESC);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const JsonExpression calls = clip.get<JsonExpression>(ARG_CALLS_NAME);
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+    xpr::fused_scan        scan{
+        lines.filter(filter(world.rank(), clip), selection_key(clip))};
+
+    for (const boost::json::object& call : calls) add_call(scan, call);
+
+    boost::json::array res = scan.run();
+
+    if (world.rank() == 0) {
+      clip.to_return(res);
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
@@ -11,8 +11,13 @@
 #define METALL_DISABLE_CONCURRENCY 1
 #endif
 
+#include <algorithm>
+#include <functional>
 #include <limits>
+#include <memory>
 #include <optional>
+#include <sstream>
+#include <stdexcept>
 #include <string>
 #include <system_error>
 
@@ -25,6 +30,12 @@
 #include <clippy/clippy-eval.hpp>
 #include <clippy/clippy.hpp>
 
+#include "MetallJsonLines-datastore.hpp"
+#include "MetallJsonLines-filter.hpp"
+#include "MetallJsonLines-job.hpp"
+#include "MetallJsonLines-mpicount.hpp"
+#include "MetallJsonLines-path.hpp"
+#include "MetallJsonLines-profile.hpp"
 #include "MetallJsonLines.hpp"
 
 using JsonExpression = std::vector<boost::json::object>;
@@ -37,6 +48,7 @@ const std::string MJL_CLASS_NAME     = "MetallJsonLines";
 const std::string ST_METALL_LOCATION = "metall_location";
 const std::string ST_SELECTED        = "selected";
 const std::string KEYS_SELECTOR      = "keys";
+const std::string ST_PAGE_IN         = "page_in";
 
 CXX_MAYBE_UNUSED
 json_logic::ValueExpr to_value_expr(
@@ -48,9 +60,10 @@ json_logic::ValueExpr to_value_expr(
 
   assert(el.is_string());  // \todo array
 
-  const auto& str = el.as_string();
+  // json_logic values own their strings; the view avoids any other copy.
+  const std::string_view str = el.as_string().str_view();
 
-  return json_logic::toValueExpr(boost::json::string(str.begin(), str.end()));
+  return json_logic::toValueExpr(boost::json::string(str.data(), str.size()));
 }
 
 template <class MetallJsonObjectT>
@@ -69,17 +82,46 @@ CXX_MAYBE_UNUSED json_logic::ValueExpr eval_path(std::string_view         path,
   return eval_path(suffix, obj.at(selector).as_object());
 }
 
+/// columns that are not fields of the rows' JSON objects (e.g., the vertex
+///   property columns of a MetallGraph); they take precedence over fields
+///   with the same name.
+struct external_columns {
+  /// returns true, if \ref col is an external column
+  std::function<bool(std::string_view col)> contains;
+
+  /// returns the value of external column \ref col in row \ref rownum
+  std::function<json_logic::ValueExpr(std::string_view col,
+                                      std::size_t      rownum)>
+      value;
+
+  explicit operator bool() const { return bool(contains); }
+};
+
+/// \param paths the compiled paths of the variables; variables without a
+///        compiled path are looked up by name (see eval_path).
 CXX_MAYBE_UNUSED
 auto variable_lookup(
     experimental::metall_json_lines::accessor_type::object_accessor objacc,
-    std::string_view selectPrefix, std::size_t rownum, std::size_t rank) {
-  return [objacc, rownum, rank, selLen = (selectPrefix.size() + 1)](
+    std::string_view selectPrefix, std::size_t rownum, std::size_t rank,
+    const external_columns*           extcols = nullptr,
+    const experimental::key_path_set* paths   = nullptr) {
+  return [objacc, rownum, rank, extcols, paths,
+          selLen = (selectPrefix.size() + 1)](
              const boost::json::value& colv, int) -> json_logic::ValueExpr {
     // \todo match selector instead of skipping it
     const auto&      colname = colv.as_string();
     std::string_view col{colname.begin() + selLen, colname.size() - selLen};
 
-    if (auto pos = objacc.find(col); pos != objacc.end()) {
+    if (extcols && extcols->contains(col)) return extcols->value(col, rownum);
+
+    const experimental::key_path* path = paths ? paths->find(col) : nullptr;
+
+    if (path) {
+      if (const auto val = (*path)(objacc)) {
+        CXX_LIKELY;
+        return to_value_expr(*val);
+      }
+    } else if (auto pos = objacc.find(col); pos != objacc.end()) {
       CXX_LIKELY;
       return to_value_expr(pos->value());
     }
@@ -87,34 +129,84 @@ auto variable_lookup(
     if (col == "rowid") return json_logic::toValueExpr(rownum);
     if (col == "mpiid") return json_logic::toValueExpr(std::int64_t(rank));
 
+    if (path) return json_logic::toValueExpr(nullptr);
+
     return eval_path(col, objacc);
   };
 }
 
 inline auto variable_lookup(
     experimental::metall_json_lines::accessor_type rowval,
-    std::string_view selectPrefix, std::size_t rownum, std::size_t rank)
+    std::string_view selectPrefix, std::size_t rownum, std::size_t rank,
+    const external_columns*           extcols = nullptr,
+    const experimental::key_path_set* paths   = nullptr)
     -> decltype(variable_lookup(rowval.as_object(), selectPrefix, rownum,
-                                rank)) {
+                                rank, extcols, paths)) {
   if (!rowval.is_object())
     throw std::logic_error("Entry is not a json::object");
 
-  return variable_lookup(rowval.as_object(), selectPrefix, rownum, rank);
+  return variable_lookup(rowval.as_object(), selectPrefix, rownum, rank,
+                         extcols, paths);
 }
 
+/// returns a rule that refers to the stored selection \ref name
+///   (see metall_json_lines::store_selection).
+CXX_MAYBE_UNUSED
+boost::json::object stored_selection_rule(std::string_view name) {
+  boost::json::object res;
+
+  res["rule"] = boost::json::object{{"selection", name}};
+  return res;
+}
+
+/// returns the name of a stored selection rule {"selection": name};
+///   nullptr for other rules.
+CXX_MAYBE_UNUSED
+const boost::json::string* stored_selection_name(
+    const boost::json::value& rule) {
+  const boost::json::object* obj = rule.if_object();
+
+  if (!obj || (obj->size() != 1)) return nullptr;
+
+  const boost::json::value* name = obj->if_contains("selection");
+
+  return name ? name->if_string() : nullptr;
+}
+
+/// \param extcols columns that the rules can refer to in addition to the
+///        fields of the rows
 CXX_MAYBE_UNUSED
 std::vector<experimental::metall_json_lines::filter_type> filter(
     std::size_t rank, JsonExpression jsonExpr,
-    std::string_view selectPrefix = KEYS_SELECTOR) {
-  using ResultType       = decltype(filter(rank, jsonExpr, selectPrefix));
+    std::string_view selectPrefix = KEYS_SELECTOR,
+    external_columns extcols      = {}) {
+  using ResultType =
+      std::vector<experimental::metall_json_lines::filter_type>;
   using BJVectorIterator = std::vector<boost::json::string>::iterator;
 
-  ResultType               res;
+  ResultType                              res;
+  std::shared_ptr<const external_columns> exts;
+
+  if (extcols)
+    exts = std::make_shared<const external_columns>(std::move(extcols));
+
   boost::json::string_view boostSelectPrefix(&*selectPrefix.begin(),
                                              selectPrefix.size());
 
   // prepare AST
   for (boost::json::object& jexp : jsonExpr) {
+    // a stored selection is only available from the selection cache, which
+    //   is consulted before any filter is evaluated.
+    if (const boost::json::string* name = stored_selection_name(jexp["rule"])) {
+      res.emplace_back(
+          [sel = std::string(*name)](
+              std::size_t,
+              const experimental::metall_json_lines::accessor_type&) -> bool {
+            throw experimental::stale_selection{sel};
+          });
+      continue;
+    }
+
     auto [ast, vars, hasComputedVarNames] =
         json_logic::translateNode(jexp["rule"]);
 
@@ -133,20 +225,90 @@ std::vector<experimental::metall_json_lines::filter_type> filter(
 
     if (!useRule) continue;
 
+    // comparisons of rowid and mpiid bound the rows that the scans visit,
+    //   unless external columns have these names.
+    if (!exts || (!exts->contains("rowid") && !exts->contains("mpiid"))) {
+      const experimental::row_range range =
+          experimental::row_range::of_rule(jexp["rule"], selectPrefix, rank);
+
+      if (!range.unbounded())
+        res.emplace_back(experimental::row_range_hint{range});
+    }
+
+    // numeric bounds of fields can be looked up in sorted indices
+    std::vector<experimental::column_bounds> bounds =
+        experimental::column_bounds::of_rule(jexp["rule"], selectPrefix);
+
+    if (exts)
+      std::erase_if(bounds,
+                    [&exts](const experimental::column_bounds& bnd) -> bool {
+                      return exts->contains(bnd.column);
+                    });
+
+    if (!bounds.empty())
+      res.emplace_back(experimental::column_bounds_hint{std::move(bounds)});
+
     // the repackaging requirement seems to be a deficiency in the C++
     //   standard, which does not allow lambda environments with unique_ptr
     //   be converted into a std::function - which requires copyability.
     json_logic::Expr*                 rawexpr = ast.release();
     std::shared_ptr<json_logic::Expr> pred{rawexpr};
 
-    res.emplace_back([rank, selectPrefix, pred = std::move(pred)](
-                         std::size_t rownum,
-                         const experimental::metall_json_lines::accessor_type&
-                             rowval) mutable -> bool {
-      auto varLookup = variable_lookup(rowval, selectPrefix, rownum, rank);
+    // the variables' key paths are split and resolved once per filter
+    auto paths = std::make_shared<const experimental::key_path_set>(
+        vars, selectPrefix);
+
+    auto interpreted =
+        [rank, selectPrefix, exts, paths = std::move(paths),
+         pred = std::move(pred)](
+            std::size_t                                           rownum,
+            const experimental::metall_json_lines::accessor_type& rowval)
+        -> bool {
+      auto varLookup = variable_lookup(rowval, selectPrefix, rownum, rank,
+                                       exts.get(), paths.get());
 
       return json_logic::unpackValue<bool>(
           json_logic::calculate(*pred, varLookup));
+    };
+
+    // the compiled predicates only read fields of the rows
+    const bool usesExternal =
+        exts && std::any_of(vars.begin(), vars.end(),
+                            [&exts, selLen = selectPrefix.size() + 1](
+                                const boost::json::string& varname) -> bool {
+                              return exts->contains(std::string_view(
+                                  varname.data() + selLen,
+                                  varname.size() - selLen));
+                            });
+
+    // common shapes are evaluated without the interpreter; rows for which
+    //   the compiled predicate cannot decide are still interpreted.
+    std::optional<experimental::compiled_predicate> compiled;
+
+    if (!usesExternal)
+      compiled =
+          experimental::compiled_predicate::compile(jexp["rule"], selectPrefix);
+
+    if (!compiled) {
+      res.emplace_back(std::move(interpreted));
+      continue;
+    }
+
+    res.emplace_back([comp = std::move(*compiled),
+                      interp = std::move(interpreted)](
+                         std::size_t rownum,
+                         const experimental::metall_json_lines::accessor_type&
+                             rowval) -> bool {
+      using compiled_result = experimental::compiled_predicate::result;
+
+      const compiled_result r = comp(rowval);
+
+      if (r != compiled_result::unknown) {
+        CXX_LIKELY;
+        return r == compiled_result::yes;
+      }
+
+      return interp(rownum, rowval);
     });
   }
 
@@ -155,14 +317,78 @@ std::vector<experimental::metall_json_lines::filter_type> filter(
 
 inline std::vector<experimental::metall_json_lines::filter_type> filter(
     std::size_t rank, const clippy::clippy& clip,
-    std::string_view selectPrefix = KEYS_SELECTOR) {
+    std::string_view selectPrefix = KEYS_SELECTOR,
+    external_columns extcols      = {}) {
   if (!clip.has_state(ST_SELECTED)) {
     CXX_UNLIKELY;
     return {};
   }
 
   return filter(rank, clip.get_state<JsonExpression>(ST_SELECTED),
-                selectPrefix);
+                selectPrefix, std::move(extcols));
+}
+
+/// writes \ref val as JSON with the keys of all objects sorted, so that
+///   equal values have the same text.
+CXX_MAYBE_UNUSED
+void write_normalized(std::ostream& os, const boost::json::value& val) {
+  if (const boost::json::object* obj = val.if_object()) {
+    std::vector<const boost::json::key_value_pair*> members;
+
+    for (const boost::json::key_value_pair& kv : *obj) members.push_back(&kv);
+
+    std::sort(members.begin(), members.end(),
+              [](const auto* lhs, const auto* rhs) -> bool {
+                return lhs->key() < rhs->key();
+              });
+
+    os << '{';
+    for (std::size_t i = 0; i < members.size(); ++i) {
+      if (i) os << ',';
+      os << boost::json::value(members[i]->key()) << ':';
+      write_normalized(os, members[i]->value());
+    }
+    os << '}';
+    return;
+  }
+
+  if (const boost::json::array* arr = val.if_array()) {
+    os << '[';
+    for (std::size_t i = 0; i < arr->size(); ++i) {
+      if (i) os << ',';
+      write_normalized(os, (*arr)[i]);
+    }
+    os << ']';
+    return;
+  }
+
+  os << val;
+}
+
+/// returns the key under which the selection's rows are cached;
+///   i.e., the normalized JSON of the selection's rules.
+CXX_MAYBE_UNUSED
+std::string selection_key(const JsonExpression& jsonExpr,
+                          std::string_view      selectPrefix = KEYS_SELECTOR) {
+  std::stringstream os;
+
+  os << selectPrefix << ':';
+  for (const boost::json::object& jexp : jsonExpr) {
+    if (const boost::json::value* rule = jexp.if_contains("rule"))
+      write_normalized(os, *rule);
+
+    os << ';';
+  }
+
+  return os.str();
+}
+
+inline std::string selection_key(
+    const clippy::clippy& clip, std::string_view selectPrefix = KEYS_SELECTOR) {
+  if (!clip.has_state(ST_SELECTED)) return {};
+
+  return selection_key(clip.get_state<JsonExpression>(ST_SELECTED),
+                       selectPrefix);
 }
 
 CXX_MAYBE_UNUSED
@@ -177,7 +403,8 @@ experimental::metall_json_lines::metall_projector_type projector(
       return json_bento::value_to<boost::json::value>(el);
     };
 
-  return [fields = std::move(projlist)](
+  // columns are key paths; a dotted column can select a nested field
+  return [fields = std::make_shared<const xpr::key_path_set>(projlist)](
              const xpr::metall_json_lines::accessor_type& el)
              -> boost::json::value {
     assert(el.is_object());
@@ -185,10 +412,9 @@ experimental::metall_json_lines::metall_projector_type projector(
 
     boost::json::object res;
 
-    for (const std::string& col : fields) {
-      if (const auto fld = frobj.if_contains(col))
-        res.emplace(col, json_bento::value_to<boost::json::value>(*fld));
-      //~ if (const auto fld = ifContains(frobj, col))
+    for (const xpr::key_path& col : *fields) {
+      if (const auto fld = col(frobj))
+        res.emplace(col.name(), json_bento::value_to<boost::json::value>(*fld));
     }
 
     return res;
@@ -219,12 +445,14 @@ CXX_MAYBE_UNUSED experimental::metall_json_lines::updater_type updater(
   //   be converted into a std::function - which requires copyability.
   json_logic::Expr*                 rawexpr = ast.release();
   std::shared_ptr<json_logic::Expr> oper{rawexpr};
+  auto paths = std::make_shared<const xpr::key_path_set>(vars, selectPrefix);
 
   return [rank, selectPrefix, colName = std::move(columnName),
-          op = std::move(oper), objalloc{alloc}](
+          op = std::move(oper), paths = std::move(paths), objalloc{alloc}](
              std::size_t                           rownum,
              xpr::metall_json_lines::accessor_type rowval) -> void {
-    auto varLookup = variable_lookup(rowval, selectPrefix, rownum, rank);
+    auto varLookup = variable_lookup(rowval, selectPrefix, rownum, rank,
+                                     nullptr, paths.get());
     json_logic::ValueExpr exp    = json_logic::calculate(*op, varLookup);
     auto                  rowobj = rowval.as_object();
     std::stringstream     jstr;
@@ -235,6 +463,38 @@ CXX_MAYBE_UNUSED experimental::metall_json_lines::updater_type updater(
   };
 }
 
+/// returns the compiled update of the column by the expression, if the
+///   expression is a constant or simple arithmetic (see column_update).
+CXX_MAYBE_UNUSED
+inline std::optional<experimental::column_update> column_update_of(
+    clippy::clippy& clip, const std::string& colkey, const std::string& exprkey,
+    std::string_view selectPrefix) {
+  boost::json::object columnExpr = clip.get<boost::json::object>(exprkey);
+
+  return experimental::column_update::compile(
+      clip.get<std::string>(colkey), columnExpr["rule"], selectPrefix);
+}
+
+/// returns the aggregates of an object that maps a column to the name of
+///   an aggregate function (e.g., the agg argument of groupby)
+CXX_MAYBE_UNUSED
+inline std::vector<experimental::aggregate_spec> aggregate_specs(
+    const boost::json::object& agg) {
+  std::vector<experimental::aggregate_spec> res;
+
+  for (const auto& el : agg) {
+    if (!el.value().is_string())
+      throw std::invalid_argument{"aggregate function is not a string"};
+
+    const boost::json::string& op = el.value().as_string();
+
+    res.emplace_back(std::string(el.key()),
+                     experimental::to_aggregate_op({op.data(), op.size()}));
+  }
+
+  return res;
+}
+
 CXX_MAYBE_UNUSED
 inline void append(std::vector<boost::json::object>& lhs,
                    std::vector<boost::json::object>  rhs) {
@@ -243,11 +503,159 @@ inline void append(std::vector<boost::json::object>& lhs,
   std::move(rhs.begin(), rhs.end(), std::back_inserter(lhs));
 }
 
+/// returns the location of the version \ref name of the datastore at
+///   \ref loc; versions are stored next to the datastore (<loc>@<name>).
+inline std::string version_location(std::string_view loc,
+                                    std::string_view name) {
+  if (name.empty() || (name.find('/') != std::string_view::npos))
+    throw std::invalid_argument{"invalid version name: " + std::string(name)};
+
+  std::string res{loc};
+
+  while ((res.size() > 1) && (res.back() == '/')) res.pop_back();
+
+  res += '@';
+  res += name;
+  return res;
+}
+
+const std::string ARG_SAMPLE_NAME = "sample";
+const std::string ARG_SAMPLE_DESC =
+    "if > 0, the rows are restricted to a Bernoulli sample of this fraction "
+    "of the rows, and counts are estimated for all rows";
+const std::string ARG_SAMPLE_ROWS_NAME = "sample_rows";
+const std::string ARG_SAMPLE_ROWS_DESC =
+    "if > 0, the rows are restricted to a uniform sample of this many rows, "
+    "and counts are estimated for all rows";
+const std::string ARG_SEED_NAME = "seed";
+const std::string ARG_SEED_DESC =
+    "the seed of the sample; the same seed selects the same rows";
+
+/// adds the sampling arguments (see apply_sample)
+inline void add_sample_arguments(clippy::clippy& clip) {
+  clip.add_optional<double>(ARG_SAMPLE_NAME, ARG_SAMPLE_DESC, 0.0);
+  clip.add_optional<int>(ARG_SAMPLE_ROWS_NAME, ARG_SAMPLE_ROWS_DESC, 0);
+  clip.add_optional<int>(ARG_SEED_NAME, ARG_SEED_DESC, 0);
+}
+
+/// restricts \ref lines to the sample of the sampling arguments, if any.
+/// \return true, if the rows are sampled
+inline bool apply_sample(experimental::metall_json_lines& lines,
+                         const clippy::clippy&            clip) {
+  const double        fraction = clip.get<double>(ARG_SAMPLE_NAME);
+  const int           numrows  = clip.get<int>(ARG_SAMPLE_ROWS_NAME);
+  const std::uint64_t seed     = clip.get<int>(ARG_SEED_NAME);
+
+  if ((fraction > 0) && (numrows > 0))
+    throw std::invalid_argument{ARG_SAMPLE_NAME + " and " +
+                                ARG_SAMPLE_ROWS_NAME + " are exclusive"};
+
+  if (fraction > 0) lines.sample(fraction, seed);
+  if (numrows > 0) lines.sample_rows(numrows, seed);
+
+  return (fraction > 0) || (numrows > 0);
+}
+
+const std::string ARG_THREADS_NAME = "threads";
+const std::string ARG_THREADS_DESC =
+    "the number of threads per rank that scan the local rows (count, hist, "
+    "and filter evaluation); 1 scans sequentially";
+
+/// adds the threads argument (see apply_threads)
+inline void add_threads_argument(clippy::clippy& clip) {
+  clip.add_optional<int>(ARG_THREADS_NAME, ARG_THREADS_DESC, 1);
+}
+
+/// sets the scan threads of \ref lines to the threads argument
+inline void apply_threads(experimental::metall_json_lines& lines,
+                          const clippy::clippy&            clip) {
+  lines.scan_threads(std::max(1, clip.get<int>(ARG_THREADS_NAME)));
+}
+
+const std::string ARG_PROFILE_NAME = "profile";
+const std::string ARG_PROFILE_DESC =
+    "if true, the result includes a profile of the method's phases: wall, "
+    "wait, and CPU time, page faults, messages and bytes sent, and datastore "
+    "growth per rank";
+
+/// adds the profile argument (see method_profile_of)
+inline void add_profile_argument(clippy::clippy& clip) {
+  clip.add_optional<bool>(ARG_PROFILE_NAME, ARG_PROFILE_DESC, false);
+}
+
+/// returns a profile that is enabled by the profile argument
+inline experimental::method_profile method_profile_of(
+    ygm::comm& world, const clippy::clippy& clip) {
+  if (!clip.get<bool>(ARG_PROFILE_NAME)) return {};
+
+  return experimental::method_profile{world};
+}
+
+const std::string ARG_JOB_NAME = "job";
+const std::string ARG_JOB_DESC =
+    "if not empty, the method reports its progress under this job name, "
+    "which job_status reads while the method runs";
+
+/// adds the job argument (see job_of)
+inline void add_job_argument(clippy::clippy& clip) {
+  clip.add_optional<std::string>(ARG_JOB_NAME, ARG_JOB_DESC, "");
+}
+
+/// returns the job of \ref method on the datastore at \ref loc, which is
+///   enabled by the job argument. Collective.
+inline experimental::job_progress job_of(const clippy::clippy& clip,
+                                         std::string_view      loc,
+                                         std::string           method) {
+  return experimental::job_progress{loc, clip.get<std::string>(ARG_JOB_NAME),
+                                    std::move(method)};
+}
+
+/// returns \ref res on rank 0; if \ref prof is enabled, an object result
+///   gets the report as member "profile", and other results are returned
+///   as {\ref resultKey: res, "profile": report}. Collective.
+template <class ResultT>
+inline void return_profiled(ygm::comm& world, clippy::clippy& clip,
+                            experimental::method_profile& prof, ResultT res,
+                            const std::string& resultKey = "result") {
+  if (!prof.enabled()) {
+    if (world.rank() == 0) clip.to_return(std::move(res));
+
+    return;
+  }
+
+  boost::json::object report = prof.report();
+
+  if (world.rank() != 0) return;
+
+  boost::json::value val = boost::json::value_from(std::move(res));
+
+  if (!val.is_object()) {
+    boost::json::object wrapped;
+
+    wrapped[resultKey] = std::move(val);
+    val                = std::move(wrapped);
+  }
+
+  val.as_object()[ARG_PROFILE_NAME] = std::move(report);
+  clip.to_return(std::move(val));
+}
+
+/// returns the page-in mode of the datastore (state page_in); lazy if the
+///   object does not have one.
+inline experimental::page_in_mode page_in_hint(const clippy::clippy& clip) {
+  if (!clip.has_state(ST_PAGE_IN)) return experimental::page_in_mode::lazy;
+
+  return experimental::to_page_in_mode(clip.get_state<std::string>(ST_PAGE_IN));
+}
+
 /// removes the entire directory \ref loc and its content and synchronizes
 /// processes on \ref world after the directory has been removed.
 CXX_MAYBE_UNUSED
 inline void remove_directory_and_content(ygm::comm&       world,
                                          std::string_view loc) {
+  // a datastore that the service keeps open must not outlive its files
+  if (auto* cache = experimental::datastore_cache::active()) cache->close(loc);
+
   try {
     std::error_code ec;
 
@@ -269,8 +677,11 @@ inline void remove_directory_and_content(ygm::comm&       world,
 
 int ygm_main(ygm::comm& world, int argc, char** argv);
 
+// the service (mg-serve) includes the methods and provides its own main
+#ifndef METALLDATA_SERVICE
 int main(int argc, char** argv) {
   ygm::comm world(&argc, &argv);
 
   return ygm_main(world, argc, argv);
 }
+#endif
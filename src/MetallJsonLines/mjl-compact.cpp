@@ -0,0 +1,69 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines compact method, which rewrites the
+///        rows of each rank into densely packed storage.
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "compact";
+const std::string METHOD_DOCSTRING =
+    "Rewrites the rows of each rank into freshly allocated, densely packed "
+    "storage and releases the memory left behind by clear and set. "
+    "The selection is ignored.";
+
+const std::string ARG_SORT_BY_NAME = "sort_by";
+const std::string ARG_SORT_BY_DESC =
+    "if not empty, the rows of each rank are sorted by this field "
+    "(numbers before strings before other values), which improves the "
+    "locality of scans; sorting renumbers the rows.";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_optional<std::string>(ARG_SORT_BY_NAME, ARG_SORT_BY_DESC, "");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string sortBy = clip.get<std::string>(ARG_SORT_BY_NAME);
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const bool             compacted = lines.compact(sortBy);
+
+    if (world.all_reduce_sum(std::size_t(!compacted)) != 0)
+      throw std::runtime_error{"unable to compact (read-only datastore)"};
+
+    const std::size_t numrows = lines.count();
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << "compacted " << numrows << " rows";
+      if (!sortBy.empty()) msg << " sorted by " << sortBy;
+      msg << "." << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
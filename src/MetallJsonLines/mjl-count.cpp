@@ -6,6 +6,8 @@
 /// \brief Demonstrates how to run Json expr::metall_json_linesession predicates
 /// on a MetallJsonLines
 
+#include <cmath>
+
 #include <boost/json.hpp>
 #include "mjl-common.hpp"
 
@@ -18,6 +20,16 @@ const std::string METHOD_DOCSTRING =
 
 const std::string COUNT_ALL_NAME = "count_all";
 const std::string COUNT_ALL_DESC = "if true, the selection criteria is ignored";
+
+const std::string DISTINCT_NAME = "distinct";
+const std::string DISTINCT_DESC =
+    "if set, the approximate number of distinct values of this column is "
+    "returned instead of the number of rows (HyperLogLog)";
+
+const std::string PRECISION_NAME = "precision";
+const std::string PRECISION_DESC =
+    "precision of the distinct count in [4, 18]; the relative error is about "
+    "1.04 / sqrt(2^precision)";
 }  // namespace
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
@@ -29,27 +41,61 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
                                        "Metall storage location");
 
   clip.add_optional<bool>(COUNT_ALL_NAME, COUNT_ALL_DESC, false);
+  clip.add_optional<std::string>(DISTINCT_NAME, DISTINCT_DESC, "");
+  clip.add_optional<int>(PRECISION_NAME, PRECISION_DESC,
+                         xpr::hyperloglog::DEFAULT_PRECISION);
+  add_sample_arguments(clip);
+  add_profile_argument(clip);
+  add_threads_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    const bool             countAll = clip.get<bool>(COUNT_ALL_NAME);
-    metall_manager         mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
-    xpr::metall_json_lines lines{mm, world};
-    const std::size_t      res =
-        countAll ? lines.count()
-                      : lines.filter(filter(world.rank(), clip)).count();
-
-    if (world.rank() == 0) {
-      clip.to_return(res);
+    const bool          countAll = clip.get<bool>(COUNT_ALL_NAME);
+    xpr::method_profile prof     = method_profile_of(world, clip);
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+    const std::string      distinct = clip.get<std::string>(DISTINCT_NAME);
+
+    apply_threads(lines, clip);
+
+    prof.track(dataLocation);
+    prof.phase("filter");
+
+    if (!countAll)
+      lines.filter(filter(world.rank(), clip), selection_key(clip));
+
+    prof.phase("count");
+
+    if (apply_sample(lines, clip) && distinct.empty()) {
+      const std::size_t   sampled = lines.count();
+      boost::json::object res =
+          xpr::estimate_count(sampled, *lines.current_sample()).asJson();
+
+      res["sampled"] = sampled;
+      return_profiled(world, clip, prof, std::move(res));
+      return error_code;
+    }
+
+    if (!distinct.empty()) {
+      const double res =
+          lines.count_distinct(distinct, clip.get<int>(PRECISION_NAME));
+
+      return_profiled(world, clip, prof, std::uint64_t(std::llround(res)),
+                      "count");
+      return error_code;
     }
+
+    const std::size_t res = lines.count();
+
+    return_profiled(world, clip, prof, res, "count");
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
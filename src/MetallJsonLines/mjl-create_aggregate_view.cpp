@@ -0,0 +1,100 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines create_aggregate_view method, which
+///        materializes the partial aggregates of a groupby in the datastore.
+
+#include <boost/json.hpp>
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "create_aggregate_view";
+const std::string METHOD_DOCSTRING =
+    "Stores the row counts and partial aggregates of the groups of all rows "
+    "in the datastore. hist on a single key column, and groupby with the "
+    "same keys and a subset of the aggregates, are then answered from the "
+    "view when no rows are selected. read_json keeps the view current; "
+    "other modifications make it stale until create_aggregate_view is "
+    "called again.";
+
+const std::string ARG_KEYS_NAME = "keys";
+const std::string ARG_KEYS_DESC = "columns to group by";
+
+const std::string ARG_AGG_NAME = "agg";
+const std::string ARG_AGG_DESC =
+    "object mapping a column to an aggregate function or a list of them: "
+    "count, sum, min, max, or mean";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<ColumnSelector>(ARG_KEYS_NAME, ARG_KEYS_DESC);
+  clip.add_optional<boost::json::object>(ARG_AGG_NAME, ARG_AGG_DESC,
+                                         boost::json::object{});
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const boost::json::object agg =
+        clip.get<boost::json::object>(ARG_AGG_NAME);
+
+    xpr::aggregate_view_definition def;
+
+    def.keys = clip.get<ColumnSelector>(ARG_KEYS_NAME);
+
+    auto addAggregate = [&def](std::string_view col,
+                               const boost::json::value& op) -> void {
+      if (!op.is_string())
+        throw std::invalid_argument{"aggregate function is not a string"};
+
+      const boost::json::string& name = op.as_string();
+
+      def.aggs.emplace_back(std::string(col),
+                            xpr::to_aggregate_op({name.data(), name.size()}));
+    };
+
+    for (const auto& el : agg) {
+      if (const boost::json::array* ops = el.value().if_array()) {
+        for (const boost::json::value& op : *ops) addAggregate(el.key(), op);
+      } else {
+        addAggregate(el.key(), el.value());
+      }
+    }
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const bool             created = lines.create_aggregate_view(def);
+
+    if (world.all_reduce_sum(std::size_t(!created)) != 0)
+      throw std::runtime_error{
+          "unable to create aggregate view (read-only datastore)"};
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << "created aggregate view " << def.text() << " of "
+          << lines.count() << " rows." << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
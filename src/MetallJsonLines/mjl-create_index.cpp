@@ -0,0 +1,89 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines create_index method, which builds
+///        a sorted index or a zone map over a column for range selections.
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "create_index";
+const std::string METHOD_DOCSTRING =
+    "Builds an index over the numeric values of a column; selections "
+    "that compare the column with constants (==, <, <=, >, >=, between) "
+    "then only evaluate the rows in the range. The selection is ignored. "
+    "read_json keeps the index current; other modifications make it stale "
+    "until create_index is called again.";
+
+const std::string ARG_COLUMN_NAME = "column";
+const std::string ARG_COLUMN_DESC = "name of the indexed column";
+
+const std::string ARG_KIND_NAME = "kind";
+const std::string ARG_KIND_DESC =
+    "sorted (default): the sorted values and their rows; "
+    "zone_map: the minimum and maximum value of each block of rows, which "
+    "is smaller and cheaper to maintain, and skips blocks of mostly "
+    "ordered data (e.g., timestamps of an ingest).";
+
+enum class index_kind { sorted, zone_map };
+
+index_kind to_index_kind(std::string_view kind) {
+  if (kind == "sorted") return index_kind::sorted;
+  if (kind == "zone_map") return index_kind::zone_map;
+
+  throw std::invalid_argument{"unknown index kind: " + std::string(kind)};
+}
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_COLUMN_NAME, ARG_COLUMN_DESC);
+  clip.add_optional<std::string>(ARG_KIND_NAME, ARG_KIND_DESC, "sorted");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string column   = clip.get<std::string>(ARG_COLUMN_NAME);
+    const std::string kindName = clip.get<std::string>(ARG_KIND_NAME);
+    const index_kind  kind     = to_index_kind(kindName);
+
+    if (column.empty()) throw std::invalid_argument{"empty column name"};
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const bool             created = (kind == index_kind::zone_map)
+                                         ? lines.create_zone_map(column)
+                                         : lines.create_index(column);
+
+    if (world.all_reduce_sum(std::size_t(!created)) != 0)
+      throw std::runtime_error{"unable to create index (read-only datastore)"};
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << "created " << (kind == index_kind::zone_map ? "zone map" : "index")
+          << " on " << column << " of " << lines.count() << " rows."
+          << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
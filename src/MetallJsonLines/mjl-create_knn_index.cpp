@@ -0,0 +1,86 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines create_knn_index method, which
+///        builds an IVF index over a numeric array column for knn.
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "create_knn_index";
+const std::string METHOD_DOCSTRING =
+    "Builds an IVF index over the numeric arrays of a column: k-means "
+    "chooses centroids, and each rank keeps its rows in the list of their "
+    "nearest centroid; knn then only searches the lists nearest to the "
+    "query. The selection is ignored. read_json extends the index; other "
+    "modifications make it stale until create_knn_index is called again.";
+
+const std::string ARG_COLUMN_NAME = "col";
+const std::string ARG_COLUMN_DESC = "the column with the numeric arrays";
+
+const std::string ARG_LISTS_NAME = "lists";
+const std::string ARG_LISTS_DESC =
+    "the number of centroids (e.g., the square root of the number of rows)";
+
+const std::string ARG_ITERATIONS_NAME = "iterations";
+const std::string ARG_ITERATIONS_DESC =
+    "the number of k-means iterations over a sample of the rows";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_COLUMN_NAME, ARG_COLUMN_DESC);
+  clip.add_optional<int>(ARG_LISTS_NAME, ARG_LISTS_DESC, 256);
+  clip.add_optional<int>(
+      ARG_ITERATIONS_NAME, ARG_ITERATIONS_DESC,
+      int(xpr::metall_json_lines::KNN_INDEX_ITERATIONS));
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string column     = clip.get<std::string>(ARG_COLUMN_NAME);
+    const int         lists      = clip.get<int>(ARG_LISTS_NAME);
+    const int         iterations = clip.get<int>(ARG_ITERATIONS_NAME);
+
+    if (column.empty()) throw std::invalid_argument{"empty column name"};
+
+    if ((lists <= 0) || (iterations < 0))
+      throw std::invalid_argument{ARG_LISTS_NAME + " must be positive, " +
+                                  ARG_ITERATIONS_NAME + " not negative"};
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const bool created = lines.create_knn_index(column, lists, iterations);
+
+    if (world.all_reduce_sum(std::size_t(!created)) != 0)
+      throw std::runtime_error{
+          "unable to create knn index (read-only datastore)"};
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << "created knn index on " << column << " of " << lines.count()
+          << " rows." << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
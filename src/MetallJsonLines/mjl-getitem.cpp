@@ -48,6 +48,10 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
       state.set_val(ST_METALL_LOCATION, std::move(location));
       state.set_val(ST_SELECTED, std::move(selectedExpression));
 
+      // the selection pages in the datastore as its base object
+      if (clip.has_state(ST_PAGE_IN))
+        state.set_val(ST_PAGE_IN, clip.get_state<std::string>(ST_PAGE_IN));
+
       clippy_type.set_val("__class__", MJL_CLASS_NAME);
       clippy_type.set_json("state", std::move(state));
 
@@ -0,0 +1,75 @@
+// Copyright 2022 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements groupby/agg on the selected rows of a MetallJsonLines
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines-groupby.hpp"
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "groupby";
+const std::string METHOD_DOCSTRING =
+    "Groups the selected rows by key columns and aggregates columns per group";
+
+const std::string ARG_KEYS_NAME = "keys";
+const std::string ARG_KEYS_DESC = "columns to group by";
+
+const std::string ARG_AGG_NAME = "agg";
+const std::string ARG_AGG_DESC =
+    "object mapping a column to an aggregate function: "
+    "count, count_distinct, sum, min, max, or mean";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<ColumnSelector>(ARG_KEYS_NAME, ARG_KEYS_DESC);
+  clip.add_required<boost::json::object>(ARG_AGG_NAME, ARG_AGG_DESC);
+  add_profile_argument(clip);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const ColumnSelector keys = clip.get<ColumnSelector>(ARG_KEYS_NAME);
+    xpr::method_profile  prof = method_profile_of(world, clip);
+
+    const std::vector<xpr::aggregate_spec> aggs =
+        aggregate_specs(clip.get<boost::json::object>(ARG_AGG_NAME));
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+
+    prof.phase("groupby");
+
+    boost::json::array groups = xpr::groupby(
+        lines.filter(filter(world.rank(), clip), selection_key(clip)), keys,
+        aggs);
+
+    return_profiled(world, clip, prof, std::move(groups), "groups");
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
@@ -38,6 +38,8 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   clip.add_optional<int>(ARG_MAX_ROWS, "Max number of rows returned", 5);
   clip.add_optional<ColumnSelector>(
       COLUMNS, "projection list (list of columns to put out)", DEFAULT_COLUMNS);
+  add_sample_arguments(clip);
+  add_profile_argument(clip);
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
 
@@ -46,19 +48,29 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    const std::size_t      numrows = clip.get<int>(ARG_MAX_ROWS);
-    metall_manager         mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
-    xpr::metall_json_lines lines{mm, world};
-    boost::json::value     res =
-        lines.filter(filter(world.rank(), clip, KEYS_SELECTOR))
-            .head(numrows, projector(COLUMNS, clip));
-
-    if (world.rank() == 0) clip.to_return(std::move(res));
+    const std::size_t   numrows = clip.get<int>(ARG_MAX_ROWS);
+    xpr::method_profile prof    = method_profile_of(world, clip);
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+
+    prof.track(dataLocation);
+    prof.phase("filter");
+    lines.filter(filter(world.rank(), clip, KEYS_SELECTOR),
+                 selection_key(clip, KEYS_SELECTOR));
+
+    // head of a sample returns random rows instead of the first ones
+    apply_sample(lines, clip);
+
+    prof.phase("head");
+
+    boost::json::value res = lines.head(numrows, projector(COLUMNS, clip));
+
+    return_profiled(world, clip, prof, std::move(res), "rows");
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
@@ -16,6 +16,18 @@ const std::string METHOD_NAME      = "hist";
 const std::string METHOD_DOCSTRING = "Make a histogram";
 
 const std::string COL = "col";
+
+const std::string ARG_MAX_BINS_NAME = "max_bins";
+const std::string ARG_MAX_BINS_DESC =
+    "Only return the most frequent values (0 returns all values)";
+
+const std::string ARG_MIN_COUNT_NAME = "min_count";
+const std::string ARG_MIN_COUNT_DESC =
+    "Only return values that occur at least this often";
+const std::string ARG_HEAVY_HITTERS_NAME = "heavy_hitters";
+const std::string ARG_HEAVY_HITTERS_DESC =
+    "if true and max_bins > 0, only the candidates of per-rank summaries are "
+    "counted (see top_k); faster for columns with many distinct values";
 }  // namespace
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
@@ -28,25 +40,63 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
 
   clip.add_required_state<bool>(COL, "Column name");
 
+  clip.add_optional<int>(ARG_MAX_BINS_NAME, ARG_MAX_BINS_DESC, 0);
+  clip.add_optional<int>(ARG_MIN_COUNT_NAME, ARG_MIN_COUNT_DESC, 1);
+  clip.add_optional<bool>(ARG_HEAVY_HITTERS_NAME, ARG_HEAVY_HITTERS_DESC,
+                          false);
+  add_sample_arguments(clip);
+  add_profile_argument(clip);
+  add_threads_argument(clip);
+
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
     const std::string col = clip.get_state<std::string>(COL);
+    const std::size_t maxBins =
+        std::max(0, clip.get<int>(ARG_MAX_BINS_NAME));
+    const std::size_t minCount =
+        std::max(0, clip.get<int>(ARG_MIN_COUNT_NAME));
+
+    xpr::method_profile prof = method_profile_of(world, clip);
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+
+    apply_threads(lines, clip);
 
-    metall_manager         mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
-    xpr::metall_json_lines lines{mm, world};
-    auto                   histogram = lines.hist(col);
+    prof.track(dataLocation);
+    prof.phase("filter");
+    lines.filter(filter(world.rank(), clip), selection_key(clip));
+    prof.phase("hist");
 
-    if (world.rank() == 0) {
-      clip.to_return(histogram);
+    if (apply_sample(lines, clip)) {
+      boost::json::array histogram =
+          lines.hist_estimate(col, maxBins, minCount);
+
+      return_profiled(world, clip, prof, std::move(histogram), "hist");
+      return error_code;
     }
+
+    if (clip.get<bool>(ARG_HEAVY_HITTERS_NAME) && (maxBins > 0)) {
+      auto histogram = lines.top_k(col, maxBins);
+
+      std::erase_if(histogram, [minCount](const auto& bin) {
+        return bin.second < minCount;
+      });
+
+      return_profiled(world, clip, prof, std::move(histogram), "hist");
+      return error_code;
+    }
+
+    auto histogram = lines.hist(col, maxBins, minCount);
+
+    return_profiled(world, clip, prof, std::move(histogram), "hist");
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
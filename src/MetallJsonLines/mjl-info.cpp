@@ -22,6 +22,13 @@ namespace xpr = experimental;
 
 namespace {
 const std::string methodName = "info";
+
+const std::string ARG_DETAILED_NAME = "detailed";
+const std::string ARG_DETAILED_DESC =
+    "if true, each rank also reports the bytes used by its storages, "
+    "the number of free string slots, and the key cardinality, "
+    "the value types of each key, and the average width of the selected "
+    "objects";
 }
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
@@ -34,20 +41,22 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
 
+  clip.add_optional<bool>(ARG_DETAILED_NAME, ARG_DETAILED_DESC, false);
+
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager         mm{metall::open_read_only, dataLocation.data(),
-                      MPI_COMM_WORLD};
-    xpr::metall_json_lines lines{mm, world};
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
     boost::json::value     res =
-        lines.filter(filter(world.rank(), clip, KEYS_SELECTOR)).info();
+        lines
+            .filter(filter(world.rank(), clip, KEYS_SELECTOR),
+                    selection_key(clip, KEYS_SELECTOR))
+            .info(clip.get<bool>(ARG_DETAILED_NAME));
 
     if (world.rank() == 0) clip.to_return(std::move(res));
   } catch (const std::exception& err) {
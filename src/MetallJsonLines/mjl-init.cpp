@@ -21,6 +21,47 @@ const std::string METHOD_DOCSTRING =
 const std::string ARG_ALWAYS_CREATE_NAME = "overwrite";
 const std::string ARG_ALWAYS_CREATE_DESC =
     "create new data store (deleting any existing data)";
+
+const std::string ARG_INDEXED_KEYS_NAME = "indexed_keys";
+const std::string ARG_INDEXED_KEYS_DESC =
+    "top-level keys that are indexed for faster filters and projections "
+    "(only used when a new data store is created)";
+
+const std::string ARG_WIDE_ROW_THRESHOLD_NAME = "wide_row_threshold";
+const std::string ARG_WIDE_ROW_THRESHOLD_DESC =
+    "rows with at least this many keys are stored with sorted keys "
+    "for faster lookups; 0 disables "
+    "(only used when a new data store is created)";
+
+const std::string ARG_PACKED_ARRAY_THRESHOLD_NAME = "packed_array_threshold";
+const std::string ARG_PACKED_ARRAY_THRESHOLD_DESC =
+    "arrays with at least this many elements that are all integers or all "
+    "floating point numbers are stored packed; 0 disables "
+    "(only used when a new data store is created)";
+
+const std::string ARG_INTERN_STRINGS_NAME = "intern_strings";
+const std::string ARG_INTERN_STRINGS_DESC =
+    "store repeated string values only once "
+    "(only used when a new data store is created)";
+
+const std::string ARG_COMPRESSED_KEYS_NAME = "compressed_keys";
+const std::string ARG_COMPRESSED_KEYS_DESC =
+    "top-level keys whose long string values (256 characters or more) are "
+    "stored in compressed blocks, for rarely read text "
+    "(only used when a new data store is created)";
+
+const std::string ARG_ROW_ALLOCATION_NAME = "row_allocation";
+const std::string ARG_ROW_ALLOCATION_DESC =
+    "individual, slab (pack small objects and arrays into large chunks), or "
+    "bump (slab without memory reuse, for read-only data) "
+    "(only used when a new data store is created)";
+
+const std::string ARG_PAGE_IN_DESC =
+    "how later methods page in the data store after opening it: "
+    "lazy (on first access), "
+    "prefault (read ahead the row locators and cached selections), or "
+    "random (as prefault, but disable the readahead of the rest; "
+    "for point lookups and heads)";
 }  // namespace
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
@@ -33,6 +74,19 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
                                  "Location of the Metall store");
   clip.add_optional<bool>(ARG_ALWAYS_CREATE_NAME, ARG_ALWAYS_CREATE_DESC,
                           false);
+  clip.add_optional<std::vector<std::string>>(ARG_INDEXED_KEYS_NAME,
+                                              ARG_INDEXED_KEYS_DESC, {});
+  clip.add_optional<int>(ARG_WIDE_ROW_THRESHOLD_NAME,
+                         ARG_WIDE_ROW_THRESHOLD_DESC, 0);
+  clip.add_optional<int>(ARG_PACKED_ARRAY_THRESHOLD_NAME,
+                         ARG_PACKED_ARRAY_THRESHOLD_DESC, 0);
+  clip.add_optional<bool>(ARG_INTERN_STRINGS_NAME, ARG_INTERN_STRINGS_DESC,
+                          false);
+  clip.add_optional<std::vector<std::string>>(ARG_COMPRESSED_KEYS_NAME,
+                                              ARG_COMPRESSED_KEYS_DESC, {});
+  clip.add_optional<std::string>(ARG_ROW_ALLOCATION_NAME,
+                                 ARG_ROW_ALLOCATION_DESC, "individual");
+  clip.add_optional<std::string>(ST_PAGE_IN, ARG_PAGE_IN_DESC, "lazy");
 
   // no object-state requirements in constructor
   if (clip.parse(argc, argv, world)) {
@@ -40,27 +94,39 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     // the real thing
     // try to create the object
     std::string dataLocation = clip.get<std::string>(ST_METALL_LOCATION);
     const bool  overwrite    = clip.get<bool>(ARG_ALWAYS_CREATE_NAME);
+    std::string pageIn       = clip.get<std::string>(ST_PAGE_IN);
+
+    xpr::to_page_in_mode(pageIn);  // throws on unknown modes
 
     if (overwrite) remove_directory_and_content(world, dataLocation);
 
     if (!std::filesystem::is_directory(dataLocation)) {
-      metall_manager mm{metall::create_only, dataLocation.data(),
-                        MPI_COMM_WORLD};
+      xpr::datastore mm{metall::create_only, dataLocation};
 
       xpr::metall_json_lines::create_new(mm, world);
+
+      xpr::metall_json_lines lines{mm, world};
+
+      lines.index_keys(
+          clip.get<std::vector<std::string>>(ARG_INDEXED_KEYS_NAME));
+      lines.sort_keys_of_wide_rows(
+          std::max(0, clip.get<int>(ARG_WIDE_ROW_THRESHOLD_NAME)));
+      lines.pack_numeric_arrays(
+          std::max(0, clip.get<int>(ARG_PACKED_ARRAY_THRESHOLD_NAME)));
+      lines.intern_strings(clip.get<bool>(ARG_INTERN_STRINGS_NAME));
+      lines.compress_keys(
+          clip.get<std::vector<std::string>>(ARG_COMPRESSED_KEYS_NAME));
+      lines.row_allocation(clip.get<std::string>(ARG_ROW_ALLOCATION_NAME));
     } else {
       if (!metall::utility::metall_mpi_adaptor::consistent(dataLocation.data(),
                                                            MPI_COMM_WORLD))
         throw std::runtime_error{"Metallstore is inconsistent"};
 
-      metall_manager mm{metall::open_read_only, dataLocation.data(),
-                        MPI_COMM_WORLD};
+      xpr::datastore mm{metall::open_read_only, dataLocation};
 
       // check that storage is in consistent state
       xpr::metall_json_lines::check_state(mm, world);
@@ -71,6 +137,9 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
     // create the return object
     if (world.rank() == 0) {
       clip.set_state(ST_METALL_LOCATION, std::move(dataLocation));
+
+      // lazy is the default of objects without page-in state
+      if (pageIn != "lazy") clip.set_state(ST_PAGE_IN, std::move(pageIn));
     }
   } catch (const std::exception& ex) {
     error_code = 1;
@@ -0,0 +1,105 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements knn: the selected rows of a MetallJsonLines whose
+///        numeric arrays are nearest to a query vector.
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines-knn.hpp"
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "knn";
+const std::string METHOD_DOCSTRING =
+    "Returns the k selected rows whose numeric arrays in a column are "
+    "nearest to a query vector, with their distances; uses the column's "
+    "IVF index (see create_knn_index), if it is current";
+
+const std::string ARG_COLUMN_NAME = "col";
+const std::string ARG_COLUMN_DESC = "the column with the numeric arrays";
+
+const std::string ARG_QUERY_NAME = "query_vector";
+const std::string ARG_QUERY_DESC =
+    "the query; rows with arrays of another size are skipped";
+
+const std::string ARG_NUM_NAME = "k";
+const std::string ARG_NUM_DESC = "the number of rows that are returned";
+
+const std::string ARG_METRIC_NAME = "metric";
+const std::string ARG_METRIC_DESC =
+    "l2 (Euclidean distance), inner_product (the negated inner product), "
+    "or cosine (1 - the cosine similarity)";
+
+const std::string ARG_NPROBE_NAME = "nprobe";
+const std::string ARG_NPROBE_DESC =
+    "the number of lists of the IVF index that are searched; more lists "
+    "find more of the exact neighbors. 0 scans all selected rows.";
+
+const std::string    COLUMNS         = "columns";
+const ColumnSelector DEFAULT_COLUMNS = {};
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_COLUMN_NAME, ARG_COLUMN_DESC);
+  clip.add_required<std::vector<double>>(ARG_QUERY_NAME, ARG_QUERY_DESC);
+  clip.add_optional<int>(ARG_NUM_NAME, ARG_NUM_DESC, 10);
+  clip.add_optional<std::string>(ARG_METRIC_NAME, ARG_METRIC_DESC, "l2");
+  clip.add_optional<int>(ARG_NPROBE_NAME, ARG_NPROBE_DESC, 8);
+  clip.add_optional<ColumnSelector>(
+      COLUMNS, "projection list (list of columns to put out)", DEFAULT_COLUMNS);
+  add_profile_argument(clip);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string   column  = clip.get<std::string>(ARG_COLUMN_NAME);
+    const int           numrows = clip.get<int>(ARG_NUM_NAME);
+    const int           nprobe  = clip.get<int>(ARG_NPROBE_NAME);
+    xpr::method_profile prof    = method_profile_of(world, clip);
+
+    const xpr::knn_query query{
+        clip.get<std::vector<double>>(ARG_QUERY_NAME),
+        xpr::to_knn_metric(clip.get<std::string>(ARG_METRIC_NAME))};
+
+    if ((numrows < 0) || (nprobe < 0))
+      throw std::invalid_argument{ARG_NUM_NAME + " and " + ARG_NPROBE_NAME +
+                                  " must not be negative"};
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+
+    prof.track(dataLocation);
+    prof.phase("filter");
+    lines.filter(filter(world.rank(), clip), selection_key(clip));
+
+    prof.phase("knn");
+
+    boost::json::value res = xpr::nearest_rows(
+        lines, column, query, numrows, nprobe, projector(COLUMNS, clip));
+
+    return_profiled(world, clip, prof, std::move(res), "rows");
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
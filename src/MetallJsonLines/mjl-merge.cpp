@@ -5,16 +5,16 @@
 
 /// \brief Implements joining two MetallJsonLines data sets.
 
+#include <bit>
 #include <fstream>
 #include <functional>
 #include <iostream>
 #include <limits>
+#include <memory>
 #include <numeric>
-#include <chrono>
-#include <tuple>
+#include <sstream>
 #include <vector>
 
-//~ #include <bit>
 //
 #include "mjl-common.hpp"
 #include "clippy/clippy.hpp"
@@ -27,8 +27,6 @@ namespace xpr = experimental;
 namespace {
 using StringVector = std::vector<std::string>;
 
-const bool LOG_TIMING = false;
-
 const std::string methodName = "merge";
 const std::string ARG_OUTPUT = "output";
 const std::string ARG_LEFT   = "left";
@@ -37,6 +35,17 @@ const std::string ARG_RIGHT  = "right";
 const std::string ARG_HOW     = "how";
 const std::string DEFAULT_HOW = "inner";
 
+const std::string ARG_ALGORITHM     = "algorithm";
+const std::string DEFAULT_ALGORITHM = "hash";
+
+const std::string ARG_BROADCAST_LIMIT = "broadcast_limit";
+const std::string ARG_SEMI_JOIN_LIMIT = "semi_join_limit";
+
+const std::string ARG_SPILL_BUDGET    = "spill_budget";
+const std::string ARG_SPILL_DIRECTORY = "spill_directory";
+
+const std::string ARG_PROFILE = "profile";
+
 const std::string ARG_ON       = "on";
 const std::string ARG_LEFT_ON  = "left_on";
 const std::string ARG_RIGHT_ON = "right_on";
@@ -44,6 +53,11 @@ const std::string ARG_RIGHT_ON = "right_on";
 const std::string COLUMNS_LEFT  = "left_columns";
 const std::string COLUMNS_RIGHT = "right_columns";
 
+const std::string ARG_WHERE   = "where";
+const std::string ARG_COLUMNS = "columns";
+
+const JsonExpression DEFAULT_WHERE = {};
+
 const ColumnSelector DEFAULT_COLUMNS = {};
 
 //~ const std::string    ARG_SUFFIXES     = "suffixes";
@@ -59,44 +73,30 @@ JsonExpression selectionCriteria(bj::object& obj) {
   return valueAt<JsonExpression>(obj, "__clippy_type__", "state", ST_SELECTED);
 }
 
-using time_point = std::chrono::time_point<std::chrono::system_clock>;
-
-struct Timer : std::vector<std::tuple<const char*, time_point> >
-{
-  using base = std::vector<std::tuple<const char*, time_point> >;
-
-  Timer()
-  : base()
-  {
-    segment("");
-  }
-
-  void segment(const char* desc)
-  {
-    if (LOG_TIMING)
-      base::emplace_back(desc, std::chrono::system_clock::now());
-  }
-};
-
-std::ostream& operator<<(std::ostream& os, Timer& timer)
-{
-  for (int i = 1; i < timer.size(); ++i)
-  {
-    os << std::get<0>(timer.at(i)) << ' '
-       << std::chrono::duration_cast<std::chrono::milliseconds>(std::get<1>(timer.at(i)) - std::get<1>(timer.at(i-1))).count()
-       << "   ";
-  }
-
-  os << "  = "
-     << std::chrono::duration_cast<std::chrono::milliseconds>(std::get<1>(timer.at(timer.size()-1)) - std::get<1>(timer.at(0))).count();
-
-  return os;
-};
+/// returns the name of the selection that a semi or anti join stores;
+///   the name is the normalized JSON of the join's arguments.
+std::string semiJoinName(const std::string& how, const bj::string& rhsLoc,
+                         const JsonExpression& rhsSelection,
+                         const ColumnSelector& lhsOn,
+                         const ColumnSelector& rhsOn,
+                         const JsonExpression& where) {
+  bj::object        desc;
+  std::stringstream os;
+
+  desc[ARG_HOW]      = how;
+  desc[ARG_RIGHT]    = rhsLoc;
+  desc[ST_SELECTED]  = bj::value_from(rhsSelection);
+  desc[ARG_LEFT_ON]  = bj::value_from(lhsOn);
+  desc[ARG_RIGHT_ON] = bj::value_from(rhsOn);
+  desc[ARG_WHERE]    = bj::value_from(where);
+
+  write_normalized(os, desc);
+  return os.str();
+}
 
 }  // namespace
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
-  Timer          timer;
   int            error_code = 0;
   clippy::clippy clip{
       methodName, "For all selected rows, set a field to a (computed) value."};
@@ -107,7 +107,8 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   // required arguments
   clip.add_required<bj::object>(
       ARG_OUTPUT,
-      "result MetallJsonLines object; any existing data will be overwritten");
+      "result MetallJsonLines object; any existing data will be overwritten "
+      "(not used by semi and anti joins)");
   clip.add_required<bj::object>(ARG_LEFT,
                                 "right hand side MetallJsonLines object");
   clip.add_required<bj::object>(ARG_RIGHT,
@@ -133,18 +134,69 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
                                     "projection list of the right input frame",
                                     DEFAULT_COLUMNS);
 
-  // currently unsupported optional arguments
-  // clip.add_optional(ARG_HOW, "join method:
-  // {'left'|'right'|'outer'|'inner'|'cross']} default: inner", DEFAULT_HOW);
+  // selection and projection of the result
+  clip.add_optional<JsonExpression>(
+      ARG_WHERE,
+      "predicates over the result columns (keys.<column><suffix>); predicates "
+      "on a single side are applied before rows are sent between ranks",
+      DEFAULT_WHERE);
+  clip.add_optional<ColumnSelector>(
+      ARG_COLUMNS,
+      "projection list of the result (<column><suffix>); only these, the "
+      "join and the predicate columns are sent between ranks",
+      DEFAULT_COLUMNS);
+
+  clip.add_optional<std::string>(
+      ARG_ALGORITHM,
+      "join algorithm: {'hash'|'sort_merge'}; sort_merge balances skewed keys "
+      "across ranks, but stores the result rows on the joining ranks",
+      DEFAULT_ALGORITHM);
+  clip.add_optional<int>(
+      ARG_BROADCAST_LIMIT,
+      "a side with fewer selected rows is replicated to all ranks, and the "
+      "result rows are stored with the other side's rows (0 turns this off)",
+      int(DEFAULT_BROADCAST_LIMIT));
+  clip.add_optional<int>(
+      ARG_SEMI_JOIN_LIMIT,
+      "if the smaller side has at most this many selected rows, rows of the "
+      "other side whose keys are not in a Bloom filter of the smaller side "
+      "are dropped before they are sent (0 turns this off)",
+      int(xpr::DEFAULT_BLOOM_FILTER_LIMIT));
+  clip.add_optional<int>(
+      ARG_SPILL_BUDGET,
+      "memory budget per rank in MiB for the join index and candidates of "
+      "the hash algorithm; the excess is spilled to scratch files (0 turns "
+      "spilling off)",
+      0);
+  clip.add_optional<std::string>(
+      ARG_SPILL_DIRECTORY,
+      "directory of the scratch files (default: the temporary directory)",
+      "");
+
+  clip.add_optional<std::string>(
+      ARG_HOW,
+      "join type: {'inner'|'left'|'right'|'outer'|'semi'|'anti'}; semi and "
+      "anti do not write the output, but return a selection of the left "
+      "MetallJsonLines",
+      DEFAULT_HOW);
+
+  clip.add_optional<bool>(
+      ARG_PROFILE,
+      "returns {'count', 'profile'}, where profile has the wall time of each "
+      "join phase and per-rank counters (e.g., bytes sent), reduced over the "
+      "ranks to min, max, sum, mean, and skew; profile.method has the "
+      "method's phases (see method_profile)",
+      false);
+  add_job_argument(clip);
 
   if (clip.parse(argc, argv, world)) {
     return 0;
   }
 
-  timer.segment("startup");
-
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
+    xpr::method_profile method = method_profile_of(world, clip);
+
+    method.phase("arguments");
 
     // argument processing
     bj::object lhsObj = clip.get<bj::object>(ARG_LEFT);
@@ -157,6 +209,37 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
     ColumnSelector projLhs = clip.get<ColumnSelector>(COLUMNS_LEFT);
     ColumnSelector projRhs = clip.get<ColumnSelector>(COLUMNS_RIGHT);
 
+    xpr::merge_output output{clip.get<JsonExpression>(ARG_WHERE),
+                             clip.get<ColumnSelector>(ARG_COLUMNS)};
+
+    const std::string    howName = clip.get<std::string>(ARG_HOW);
+    const xpr::merge_how how     = xpr::to_merge_how(howName);
+
+    output.how = how;
+
+    const xpr::merge_algorithm algorithm =
+        xpr::to_merge_algorithm(clip.get<std::string>(ARG_ALGORITHM));
+    const int broadcastLimit = clip.get<int>(ARG_BROADCAST_LIMIT);
+    const int semiJoinLimit  = clip.get<int>(ARG_SEMI_JOIN_LIMIT);
+
+    if (broadcastLimit < 0)
+      throw std::invalid_argument{"broadcast_limit must not be negative"};
+
+    if (semiJoinLimit < 0)
+      throw std::invalid_argument{"semi_join_limit must not be negative"};
+
+    const int spillBudget = clip.get<int>(ARG_SPILL_BUDGET);
+
+    if (spillBudget < 0)
+      throw std::invalid_argument{"spill_budget must not be negative"};
+
+    const xpr::spill_options spill{std::size_t(spillBudget) << 20,
+                                   clip.get<std::string>(ARG_SPILL_DIRECTORY)};
+
+    xpr::run_profile profile = clip.get<bool>(ARG_PROFILE)
+                                   ? xpr::make_join_profile()
+                                   : xpr::run_profile{};
+
     // argument error checking
     //   \todo move to validation
     if (argLhsOn.empty() && argsOn.empty())
@@ -172,73 +255,126 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
       throw std::runtime_error{
           "Number of columns of Left_On and Right_on differ"};
 
-    timer.segment("args");
+    method.phase("open_left");
 
+    // a semi join stores its selection in the left datastore
+    const JsonExpression lhsSelection = selectionCriteria(lhsObj);
+    const JsonExpression rhsSelection = selectionCriteria(rhsObj);
+    const bool           semiJoin     = xpr::is_semi_join(how);
     const bj::string& lhsLoc = valueAt<bj::string>(lhsObj, "__clippy_type__",
                                                    "state", ST_METALL_LOCATION);
-    metall_manager    lhsMgr{metall::open_read_only, lhsLoc.data(),
-                          MPI_COMM_WORLD};
-    xpr::metall_json_lines lhsVec{lhsMgr, world};
-    lhsVec.filter(
-        filter(world.rank(), selectionCriteria(lhsObj), KEYS_SELECTOR));
-
-    timer.segment("lhs");
-    const bj::string& rhsLoc = valueAt<bj::string>(rhsObj, "__clippy_type__",
-                                                   "state", ST_METALL_LOCATION);
-    timer.segment("rhs-loc");
-    metall_manager    rhsMgr{metall::open_read_only, rhsLoc.data(),
-                          MPI_COMM_WORLD};
-    timer.segment("rhs-mgr");
-    xpr::metall_json_lines rhsVec{rhsMgr, world};
-    timer.segment("rhs-open");
-    rhsVec.filter(
-        filter(world.rank(), selectionCriteria(rhsObj), KEYS_SELECTOR));
-    timer.segment("rhs-filter");
-
-    bj::object        outObj = clip.get<bj::object>(ARG_OUTPUT);
-    const bj::string& outLoc = valueAt<bj::string>(outObj, "__clippy_type__",
-                                                   "state", ST_METALL_LOCATION);
-    std::string_view  outLocVw(outLoc.data(), outLoc.size());
-
-    timer.segment("out");
-
-    // \todo instead of deleting the entire directory tree, just try
-    //       to open the output location and clear the content
-    //       then add argument whether existing data should be kept or
-    //       overwritten
-    //~ remove_directory_and_content(world, outLocVw);
-
-    timer.segment("out-rmdir");
-
-    metall_manager outMgr{metall::open_only, outLoc.data(), MPI_COMM_WORLD};
-
-    timer.segment("out-mgr");
 
-    xpr::metall_json_lines outVec{outMgr, world};
+    // the job's status is stored next to the left datastore
+    const std::string_view lhsLocVw(lhsLoc.data(), lhsLoc.size());
+    xpr::job_progress      job = job_of(clip, lhsLocVw, methodName);
 
-    timer.segment("out-open");
+    job.phase("open");
 
-    const std::size_t      totalMerged =
-        xpr::merge(outVec, lhsVec, rhsVec, lhsOn, rhsOn, std::move(projLhs),
-                   std::move(projRhs));
+    std::unique_ptr<xpr::datastore> lhsMgr =
+        semiJoin
+            ? std::make_unique<xpr::datastore>(metall::open_only, lhsLoc)
+            : std::make_unique<xpr::datastore>(metall::open_read_only, lhsLoc);
+    xpr::metall_json_lines lhsVec{*lhsMgr, world};
+    lhsVec.filter(filter(world.rank(), lhsSelection, KEYS_SELECTOR),
+                  selection_key(lhsSelection));
 
-    timer.segment("merge");
+    method.phase("open_right");
 
-    if (world.rank() == 0) {
-      clip.to_return(totalMerged);
+    const bj::string& rhsLoc = valueAt<bj::string>(rhsObj, "__clippy_type__",
+                                                   "state", ST_METALL_LOCATION);
+    xpr::datastore         rhsMgr{metall::open_read_only, rhsLoc};
+    xpr::metall_json_lines rhsVec{rhsMgr, world};
+    rhsVec.filter(filter(world.rank(), rhsSelection, KEYS_SELECTOR),
+                  selection_key(rhsSelection));
+
+    if (semiJoin) {
+      // the selection of the left side and the stored join selection
+      const std::string name =
+          semiJoinName(howName, rhsLoc, rhsSelection, lhsOn, rhsOn,
+                       output.where);
+      JsonExpression    selection = lhsSelection;
+
+      selection.push_back(stored_selection_rule(name));
+      method.track(std::string_view(lhsLoc.data(), lhsLoc.size()));
+      method.phase("semi_join");
+      job.phase("semi_join");
+
+      const std::vector<std::uint64_t> bits = xpr::semi_join(
+          lhsVec, rhsVec, lhsOn, rhsOn, how, std::move(output.where), "_l",
+          "_r", broadcastLimit, semiJoinLimit, spill, &profile);
+      std::size_t selected = 0;
+
+      for (std::uint64_t word : bits) selected += std::popcount(word);
+
+      lhsVec.store_selection(selection_key(selection), bits);
+      selected = world.all_reduce_sum(selected);
+      job.done(selected);
+
+      bj::object profileReport = profile.report(world);
+      bj::object methodReport  = method.report();
+
+      if (world.rank() == 0) {
+        bj::object res;
+
+        res["count"]    = selected;
+        res[ST_SELECTED] = bj::value_from(selection);
+
+        if (profile.enabled()) {
+          profileReport["method"] = std::move(methodReport);
+          res[ARG_PROFILE]        = std::move(profileReport);
+        }
+
+        clip.to_return(std::move(res));
+      }
+    } else {
+      bj::object        outObj = clip.get<bj::object>(ARG_OUTPUT);
+      const bj::string& outLoc = valueAt<bj::string>(outObj, "__clippy_type__",
+                                                     "state", ST_METALL_LOCATION);
+      std::string_view  outLocVw(outLoc.data(), outLoc.size());
+
+      method.phase("open_output");
+
+      // \todo instead of deleting the entire directory tree, just try
+      //       to open the output location and clear the content
+      //       then add argument whether existing data should be kept or
+      //       overwritten
+      //~ remove_directory_and_content(world, outLocVw);
+
+      xpr::datastore         outMgr{metall::open_only, outLoc};
+      xpr::metall_json_lines outVec{outMgr, world};
+
+      method.track(outLocVw);
+      method.phase("merge");
+      job.phase("merge");
+
+      const std::size_t      totalMerged =
+          xpr::merge(outVec, lhsVec, rhsVec, lhsOn, rhsOn, std::move(projLhs),
+                     std::move(projRhs), std::move(output), "_l", "_r",
+                     algorithm, broadcastLimit, semiJoinLimit, spill,
+                     &profile);
+
+      job.done(totalMerged);
+
+      bj::object profileReport = profile.report(world);
+      bj::object methodReport  = method.report();
+
+      if (world.rank() == 0) {
+        if (profile.enabled()) {
+          bj::object res;
+
+          profileReport["method"] = std::move(methodReport);
+          res["count"]            = totalMerged;
+          res[ARG_PROFILE]        = std::move(profileReport);
+          clip.to_return(std::move(res));
+        } else {
+          clip.to_return(totalMerged);
+        }
+      }
     }
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
   }
 
-  if (LOG_TIMING)
-  {
-    std::ofstream logfile{clippy::clippyLogFile, std::ofstream::app};
-    timer.segment("post");
-
-    logfile << timer << std::endl;
-  }
-
   return error_code;
 }
@@ -0,0 +1,85 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines open_version method, which returns
+///        an object for a version that snapshot created.
+
+#include <filesystem>
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "open_version";
+const std::string METHOD_DOCSTRING =
+    "Returns a MetallJsonLines object of the named version, with the same "
+    "selection. Changes to the version do not affect the datastore, and "
+    "vice versa.";
+
+const std::string ARG_NAME_NAME = "name";
+const std::string ARG_NAME_DESC = "name of the version";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_NAME_NAME, ARG_NAME_DESC);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string name            = clip.get<std::string>(ARG_NAME_NAME);
+    std::string       versionLocation = version_location(dataLocation, name);
+
+    if (!std::filesystem::is_directory(versionLocation))
+      throw std::runtime_error{"unknown version: " + name};
+
+    if (!metall::utility::metall_mpi_adaptor::consistent(
+            versionLocation.data(), MPI_COMM_WORLD))
+      throw std::runtime_error{"version is inconsistent: " + name};
+
+    {
+      xpr::datastore mm{metall::open_read_only, versionLocation};
+
+      xpr::metall_json_lines::check_state(mm, world);
+    }
+
+    if (world.rank() == 0) {
+      clippy::object res;
+      clippy::object clippy_type;
+      clippy::object state;
+
+      state.set_val(ST_METALL_LOCATION, std::move(versionLocation));
+
+      if (clip.has_state(ST_SELECTED))
+        state.set_val(ST_SELECTED,
+                      clip.get_state<JsonExpression>(ST_SELECTED));
+
+      if (clip.has_state(ST_PAGE_IN))
+        state.set_val(ST_PAGE_IN, clip.get_state<std::string>(ST_PAGE_IN));
+
+      clippy_type.set_val("__class__", MJL_CLASS_NAME);
+      clippy_type.set_json("state", std::move(state));
+
+      res.set_json("__clippy_type__", std::move(clippy_type));
+      clip.to_return(std::move(res));
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
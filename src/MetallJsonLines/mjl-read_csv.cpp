@@ -0,0 +1,105 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the typed import of csv files
+///        based on the distributed YGM line parser.
+
+#include <iostream>
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "read_csv";
+const std::string METHOD_DESC =
+    "Imports CSV Data from files into the MetallJsonLines object.";
+
+const std::string ARG_CSV_FILES_NAME = "csv_files";
+const std::string ARG_CSV_FILES_DESC =
+    "A list of CSV files that will be imported. Files ending in .gz or .zst "
+    "are decompressed while they are read.";
+
+using ARG_COLUMNS_TYPE = std::vector<std::pair<std::string, std::string> >;
+const std::string ARG_COLUMNS_NAME = "columns";
+const std::string ARG_COLUMNS_DESC =
+    "Column description (pair of string/string describing name and type of "
+    "the fields of a line)."
+    "\n  Valid types in (string | int | uint | real | bool | auto | skip); "
+    "auto stores the first of int, uint, real, and bool that fits, or a "
+    "string. Skip columns are not stored, empty fields are stored as null.";
+
+const std::string ARG_DELIMITER_NAME = "delimiter";
+const std::string ARG_DELIMITER_DESC =
+    "The field delimiter (default: \",\").";
+
+const std::string ARG_HEADER_NAME = "header";
+const std::string ARG_HEADER_DESC =
+    "Skip lines that list the column names (default: false).";
+
+const std::string ARG_PROGRESS_NAME = "progress";
+const std::string ARG_PROGRESS_DESC =
+    "Report the number of imported lines per rank periodically "
+    "(on stderr).";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DESC};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+
+  clip.add_required<std::vector<std::string> >(ARG_CSV_FILES_NAME,
+                                               ARG_CSV_FILES_DESC);
+  clip.add_required<ARG_COLUMNS_TYPE>(ARG_COLUMNS_NAME, ARG_COLUMNS_DESC);
+  clip.add_optional<std::string>(ARG_DELIMITER_NAME, ARG_DELIMITER_DESC, ",");
+  clip.add_optional<bool>(ARG_HEADER_NAME, ARG_HEADER_DESC, false);
+  clip.add_optional<bool>(ARG_PROGRESS_NAME, ARG_PROGRESS_DESC, false);
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::vector<std::string> files =
+        clip.get<std::vector<std::string> >(ARG_CSV_FILES_NAME);
+    const std::string delim = clip.get<std::string>(ARG_DELIMITER_NAME);
+
+    if (delim.size() != 1)
+      throw std::runtime_error("delimiter must be one character");
+
+    const xpr::csv_format format =
+        xpr::csv_format::of(clip.get<ARG_COLUMNS_TYPE>(ARG_COLUMNS_NAME),
+                            delim.front(), clip.get<bool>(ARG_HEADER_NAME));
+
+    xpr::metall_json_lines::import_progress_type progress;
+
+    if (clip.get<bool>(ARG_PROGRESS_NAME)) {
+      progress = [rank = world.rank()](std::size_t imported,
+                                       std::size_t rejected) -> void {
+        std::cerr << "rank " << rank << ": " << imported << " imported, "
+                  << rejected << " rejected" << std::endl;
+      };
+    }
+
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    xpr::datastore            mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines    lines{mm, world};
+    const xpr::import_summary imp =
+        lines.read_csv_files(files, format, {}, progress);
+
+    if (world.rank() == 0) {
+      clip.to_return(imp.asJson());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
@@ -6,6 +6,8 @@
 /// \brief Implements distributed processing of a json file
 ///        based on the distributed YGM line parser.
 
+#include <iostream>
+
 #include "mjl-common.hpp"
 
 namespace xpr = experimental;
@@ -17,7 +19,27 @@ const std::string METHOD_DESC =
 
 const std::string ARG_JSON_FILES_NAME = "json_files";
 const std::string ARG_JSON_FILES_DESC =
-    "A list of Json files that will be imported.";
+    "A list of Json files that will be imported. Files ending in .gz or .zst "
+    "are decompressed while they are read; a seekable .zst file is split "
+    "over all ranks.";
+
+const std::string ARG_THREADS_NAME = "threads";
+const std::string ARG_THREADS_DESC =
+    "Number of threads per rank that parse Json lines (default: 1).";
+
+const std::string ARG_BATCH_SIZE_NAME = "batch_size";
+const std::string ARG_BATCH_SIZE_DESC =
+    "Number of Json lines that are parsed at once (default: 4096).";
+
+const std::string ARG_BATCH_MB_NAME = "batch_mb";
+const std::string ARG_BATCH_MB_DESC =
+    "Max. size of the Json lines (in MiB) that are parsed at once "
+    "(default: 64).";
+
+const std::string ARG_PROGRESS_NAME = "progress";
+const std::string ARG_PROGRESS_DESC =
+    "Report the number of imported lines per rank after each batch "
+    "(on stderr).";
 }  // namespace
 
 int ygm_main(ygm::comm& world, int argc, char** argv) {
@@ -28,6 +50,11 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
 
   clip.add_required<std::vector<std::string> >(ARG_JSON_FILES_NAME,
                                                ARG_JSON_FILES_DESC);
+  clip.add_optional<int>(ARG_THREADS_NAME, ARG_THREADS_DESC, 1);
+  clip.add_optional<int>(ARG_BATCH_SIZE_NAME, ARG_BATCH_SIZE_DESC, 4096);
+  clip.add_optional<int>(ARG_BATCH_MB_NAME, ARG_BATCH_MB_DESC, 64);
+  clip.add_optional<bool>(ARG_PROGRESS_NAME, ARG_PROGRESS_DESC, false);
+  add_profile_argument(clip);
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
 
@@ -36,20 +63,44 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::vector<std::string> files =
         clip.get<std::vector<std::string> >(ARG_JSON_FILES_NAME);
+    const int numThreads = clip.get<int>(ARG_THREADS_NAME);
+    const int batchSize  = clip.get<int>(ARG_BATCH_SIZE_NAME);
+    const int batchMB    = clip.get<int>(ARG_BATCH_MB_NAME);
+
+    if (numThreads < 1) throw std::runtime_error("threads must be positive");
+    if (batchSize < 1) throw std::runtime_error("batch_size must be positive");
+    if (batchMB < 1) throw std::runtime_error("batch_mb must be positive");
+
+    xpr::metall_json_lines::import_progress_type progress;
+
+    if (clip.get<bool>(ARG_PROGRESS_NAME)) {
+      progress = [rank = world.rank()](std::size_t imported,
+                                       std::size_t rejected) -> void {
+        std::cerr << "rank " << rank << ": " << imported << " imported, "
+                  << rejected << " rejected" << std::endl;
+      };
+    }
+
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
-    xpr::metall_json_lines    lines{mm, world};
-    const xpr::import_summary imp = lines.read_json_files(files);
+    xpr::method_profile prof = method_profile_of(world, clip);
 
-    if (world.rank() == 0) {
-      assert(imp.rejected() == 0);
-      clip.to_return(imp.imported());
-    }
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+
+    prof.track(dataLocation);
+    prof.phase("import");
+
+    const xpr::import_summary imp =
+        lines.read_json_files(files, batchSize, numThreads,
+                              std::size_t(batchMB) * 1024 * 1024, progress);
+
+    assert((world.rank() != 0) || (imp.rejected() == 0));
+    return_profiled(world, clip, prof, imp.imported(), "imported");
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
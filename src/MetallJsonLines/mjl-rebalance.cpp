@@ -0,0 +1,60 @@
+// Copyright 2022 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements moving rows of a MetallJsonLines between ranks,
+///        either to balance the row counts or to partition by a key.
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "rebalance";
+const std::string METHOD_DOCSTRING =
+    "Moves rows between ranks, so that each rank holds the same number of "
+    "rows, or, if by is given, so that rows with the same value in column by "
+    "are stored on the same rank (selection is ignored).";
+
+const std::string ARG_BY_NAME = "by";
+const std::string ARG_BY_DESC =
+    "partition the rows by the hash of this column (empty for balancing)";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+  clip.add_optional<std::string>(ARG_BY_NAME, ARG_BY_DESC, "");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string by = clip.get<std::string>(ARG_BY_NAME);
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const std::size_t      moved =
+        by.empty() ? lines.rebalance() : lines.repartition(by);
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << moved << " rows moved." << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
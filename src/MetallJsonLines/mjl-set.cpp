@@ -32,6 +32,7 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   clip.add_required<std::string>(ARG_COLUMN, "output column");
   clip.add_required<boost::json::object>(ARG_EXPRESSION,
                                          "output value expression");
+  add_profile_argument(clip);
 
   clip.add_required_state<std::string>(ST_METALL_LOCATION,
                                        "Metall storage location");
@@ -41,21 +42,33 @@ int ygm_main(ygm::comm& world, int argc, char** argv) {
   }
 
   try {
-    using metall_manager = xpr::metall_json_lines::metall_manager_type;
-
     const std::string dataLocation =
         clip.get_state<std::string>(ST_METALL_LOCATION);
-    metall_manager mm{metall::open_only, dataLocation.data(), MPI_COMM_WORLD};
+    xpr::method_profile prof = method_profile_of(world, clip);
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
     xpr::metall_json_lines lines{mm, world};
     auto                   alloc = lines.get_allocator();
-    const std::size_t      updated =
-        lines.filter(filter(world.rank(), clip, KEYS_SELECTOR))
-            .set(updater(world.rank(), clip, ARG_COLUMN, ARG_EXPRESSION,
-                         KEYS_SELECTOR, alloc));
-
-    if (world.rank() == 0) {
-      clip.to_return(updated);
-    }
+
+    prof.track(dataLocation);
+    prof.phase("set");
+
+    const std::optional<xpr::column_update> compiled =
+        column_update_of(clip, ARG_COLUMN, ARG_EXPRESSION, KEYS_SELECTOR);
+    xpr::metall_json_lines::updater_type upd = updater(
+        world.rank(), clip, ARG_COLUMN, ARG_EXPRESSION, KEYS_SELECTOR, alloc);
+
+    lines.filter(filter(world.rank(), clip, KEYS_SELECTOR),
+                 selection_key(clip, KEYS_SELECTOR));
+
+    // constants and simple arithmetic are applied without json_logic
+    const std::size_t updated = compiled
+                                    ? lines.set(*compiled, std::move(upd))
+                                    : lines.set(std::move(upd));
+
+    return_profiled(world, clip, prof, updated, "updated");
   } catch (const std::exception& err) {
     error_code = 1;
     if (world.rank() == 0) clip.to_return(err.what());
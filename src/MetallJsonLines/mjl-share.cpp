@@ -0,0 +1,56 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines share method, which publishes the
+///        first version of a shared datastore (see MetallJsonLines-lease.hpp).
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "share";
+const std::string METHOD_DOCSTRING =
+    "Makes the datastore shared: concurrent jobs read its latest published "
+    "version, while a job that modifies the datastore publishes a new "
+    "version when it ends. The selection is ignored.";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const bool             shared = xpr::writer_lease::share(mm, dataLocation);
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      if (shared)
+        msg << "published " << lines.count() << " rows." << std::flush;
+      else
+        msg << "the datastore is shared already." << std::flush;
+
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
@@ -0,0 +1,73 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements the MetallJsonLines snapshot method, which stores the
+///        current rows as a named version (see open_version).
+
+#include <filesystem>
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "snapshot";
+const std::string METHOD_DOCSTRING =
+    "Stores the datastore as a named version, which can later be opened "
+    "with open_version; the selection is ignored. Metall clones the files "
+    "(reflink) where the file system supports it, thus a version "
+    "initially shares its data with the datastore.";
+
+const std::string ARG_NAME_NAME = "name";
+const std::string ARG_NAME_DESC = "name of the version";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_NAME_NAME, ARG_NAME_DESC);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string name            = clip.get<std::string>(ARG_NAME_NAME);
+    const std::string versionLocation = version_location(dataLocation, name);
+
+    if (std::filesystem::exists(versionLocation))
+      throw std::runtime_error{"version exists: " + name};
+
+    // all ranks have checked before the version is created
+    world.barrier();
+
+    xpr::datastore         mm{metall::open_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+
+    // the snapshot consists of the datastore's files after a flush
+    if (!mm.get().snapshot(versionLocation.c_str()))
+      throw std::runtime_error{"unable to create version " + name};
+
+    if (world.rank() == 0) {
+      std::stringstream msg;
+
+      msg << "created version " << name << " of " << lines.count()
+          << " rows." << std::flush;
+      clip.to_return(msg.str());
+    }
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
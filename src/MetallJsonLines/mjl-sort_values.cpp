@@ -0,0 +1,143 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements sort_values: the top n selected rows of a
+///        MetallJsonLines, or all selected rows sorted into another one.
+
+#include <boost/json.hpp>
+
+#include "MetallJsonLines-sort.hpp"
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME      = "sort_values";
+const std::string METHOD_DOCSTRING =
+    "Orders the selected rows by columns; returns the first n rows, or "
+    "writes all rows in order into the output MetallJsonLines";
+
+const std::string ARG_BY_NAME = "by";
+const std::string ARG_BY_DESC = "the columns to sort by";
+
+const std::string ARG_ASCENDING_NAME = "ascending";
+const std::string ARG_ASCENDING_DESC =
+    "sort in ascending order (missing and null values come last)";
+
+const std::string ARG_NUM_NAME = "n";
+const std::string ARG_NUM_DESC =
+    "if not negative, the number of rows that are returned";
+
+const std::string ARG_OUTPUT_NAME = "output";
+const std::string ARG_OUTPUT_DESC =
+    "without n, the MetallJsonLines object that receives the sorted rows; "
+    "any existing data will be overwritten";
+
+const std::string    COLUMNS         = "columns";
+const ColumnSelector DEFAULT_COLUMNS = {};
+
+/// returns the datastore location of the MetallJsonLines object \ref obj
+std::string metall_location(const boost::json::object& obj) {
+  const boost::json::value* loc = nullptr;
+
+  if (const boost::json::value* type = obj.if_contains("__clippy_type__"))
+    if (const boost::json::object* typeObj = type->if_object())
+      if (const boost::json::value* state = typeObj->if_contains("state"))
+        if (const boost::json::object* stateObj = state->if_object())
+          loc = stateObj->if_contains(ST_METALL_LOCATION);
+
+  if (!loc || !loc->is_string())
+    throw std::invalid_argument{"output is not a MetallJsonLines object"};
+
+  const boost::json::string& str = loc->as_string();
+
+  return std::string(str.data(), str.size());
+}
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<ColumnSelector>(ARG_BY_NAME, ARG_BY_DESC);
+  clip.add_optional<bool>(ARG_ASCENDING_NAME, ARG_ASCENDING_DESC, true);
+  clip.add_optional<int>(ARG_NUM_NAME, ARG_NUM_DESC, -1);
+  clip.add_optional<boost::json::object>(ARG_OUTPUT_NAME, ARG_OUTPUT_DESC,
+                                         boost::json::object{});
+  clip.add_optional<ColumnSelector>(
+      COLUMNS, "projection list (list of columns to put out)", DEFAULT_COLUMNS);
+  add_profile_argument(clip);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const bool          ascending = clip.get<bool>(ARG_ASCENDING_NAME);
+    const int           numrows   = clip.get<int>(ARG_NUM_NAME);
+    ColumnSelector      by        = clip.get<ColumnSelector>(ARG_BY_NAME);
+    xpr::method_profile prof      = method_profile_of(world, clip);
+
+    std::vector<xpr::sort_column> cols;
+
+    for (std::string& col : by) cols.push_back({std::move(col), ascending});
+
+    const xpr::sort_order order{std::move(cols)};
+
+    if (numrows >= 0) {
+      prof.phase("open");
+
+      xpr::datastore         mm{metall::open_read_only, dataLocation};
+      xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+
+      prof.track(dataLocation);
+      prof.phase("filter");
+      lines.filter(filter(world.rank(), clip), selection_key(clip));
+
+      prof.phase("top_n");
+
+      boost::json::value res =
+          xpr::top_rows(lines, order, numrows, projector(COLUMNS, clip));
+
+      return_profiled(world, clip, prof, std::move(res), "rows");
+      return error_code;
+    }
+
+    const std::string outLocation =
+        metall_location(clip.get<boost::json::object>(ARG_OUTPUT_NAME));
+
+    if (outLocation == dataLocation)
+      throw std::invalid_argument{"output must differ from the input"};
+
+    prof.phase("open");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world, page_in_hint(clip)};
+    xpr::datastore         outMgr{metall::open_only, outLocation};
+    xpr::metall_json_lines outLines{outMgr, world};
+
+    prof.track(outLocation);
+    prof.phase("filter");
+    lines.filter(filter(world.rank(), clip), selection_key(clip));
+
+    prof.phase("sort");
+
+    const std::size_t count =
+        xpr::sort_values(outLines, lines, order, projector(COLUMNS, clip));
+
+    return_profiled(world, clip, prof, count, "count");
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  }
+
+  return error_code;
+}
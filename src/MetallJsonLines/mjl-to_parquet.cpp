@@ -0,0 +1,81 @@
+// Copyright 2022 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief Implements writing the selected rows of a MetallJsonLines into
+///        Parquet files (one per rank).
+
+#include <boost/json.hpp>
+
+#include "mjl-common.hpp"
+
+namespace xpr = experimental;
+
+namespace {
+const std::string METHOD_NAME = "to_parquet";
+const std::string METHOD_DOCSTRING =
+    "Writes the selected rows into Parquet files <prefix>-<rank>.parquet.";
+
+const std::string ARG_PREFIX_NAME = "prefix";
+const std::string ARG_PREFIX_DESC = "path prefix of the output files";
+
+const std::string ARG_COLUMNS_NAME = "columns";
+const std::string ARG_COLUMNS_DESC =
+    "projection list (list of columns to write; empty writes all columns)";
+
+const std::string ARG_ROW_GROUP_SIZE_NAME = "row_group_size";
+const std::string ARG_ROW_GROUP_SIZE_DESC = "number of rows per row group";
+}  // namespace
+
+int ygm_main(ygm::comm& world, int argc, char** argv) {
+  int            error_code = 0;
+  clippy::clippy clip{METHOD_NAME, METHOD_DOCSTRING};
+
+  clip.member_of(MJL_CLASS_NAME, "A " + MJL_CLASS_NAME + " class");
+  clip.add_required_state<std::string>(ST_METALL_LOCATION,
+                                       "Metall storage location");
+
+  clip.add_required<std::string>(ARG_PREFIX_NAME, ARG_PREFIX_DESC);
+  clip.add_optional<ColumnSelector>(ARG_COLUMNS_NAME, ARG_COLUMNS_DESC,
+                                    ColumnSelector{});
+  clip.add_optional<int>(ARG_ROW_GROUP_SIZE_NAME, ARG_ROW_GROUP_SIZE_DESC,
+                         64 * 1024);
+
+  if (clip.parse(argc, argv, world)) {
+    return 0;
+  }
+
+  try {
+#if METALLDATA_USE_PARQUET
+    const std::string dataLocation =
+        clip.get_state<std::string>(ST_METALL_LOCATION);
+    const std::string    prefix  = clip.get<std::string>(ARG_PREFIX_NAME);
+    const ColumnSelector columns = clip.get<ColumnSelector>(ARG_COLUMNS_NAME);
+    const int rowGroupSize       = clip.get<int>(ARG_ROW_GROUP_SIZE_NAME);
+
+    if (rowGroupSize < 1)
+      throw std::runtime_error("row_group_size must be positive");
+
+    xpr::datastore         mm{metall::open_read_only, dataLocation};
+    xpr::metall_json_lines lines{mm, world};
+    const std::size_t      written =
+        lines.filter(filter(world.rank(), clip), selection_key(clip))
+            .to_parquet(prefix, columns, rowGroupSize);
+
+    if (world.rank() == 0) {
+      clip.to_return(written);
+    }
+#else
+    throw std::runtime_error{"built without Parquet support"};
+#endif
+  } catch (const std::exception& err) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return(err.what());
+  } catch (...) {
+    error_code = 1;
+    if (world.rank() == 0) clip.to_return("unhandled, unknown exception");
+  }
+
+  return error_code;
+}
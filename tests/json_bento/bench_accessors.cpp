@@ -0,0 +1,113 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include <boost/json/src.hpp>
+#include <json_bento/json_bento.hpp>
+
+#include "bench_allocation.hpp"
+
+template <typename Allocation>
+using box_type = json_bento::box<typename Allocation::allocator_type>;
+
+/// returns a row with each kind of value, as in the box test
+boost::json::value make_row(std::size_t i) {
+  boost::json::object row;
+
+  row["number"]  = double(i) / 3;
+  row["id"]      = i;
+  row["bool"]    = (i % 2 == 0);
+  row["string"]  = "Alice Smith " + std::to_string(i % 100);
+  row["nothing"] = nullptr;
+  row["array"]   = boost::json::array{1, 0, 2};
+
+  boost::json::object& obj = row["object"].emplace_object();
+
+  obj["currency"] = "USD";
+  obj["values"]   = boost::json::array{10.0, 20.1, 32.1};
+  return row;
+}
+
+/// appends state.range(0) rows (push_back_root_value)
+template <typename Allocation>
+void BM_BoxPushBack(benchmark::State& state) {
+  Allocation allocation;
+  const int  n = int(state.range(0));
+
+  for (auto _ : state) {
+    box_type<Allocation> box(allocation.get_allocator());
+
+    for (int i = 0; i < n; ++i) box.push_back(make_row(i));
+
+    benchmark::DoNotOptimize(box.size());
+  }
+
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// visits the fields of all rows through the accessors
+template <typename Allocation>
+void BM_AccessorTraversal(benchmark::State& state) {
+  Allocation           allocation;
+  box_type<Allocation> box(allocation.get_allocator());
+  const int            n = int(state.range(0));
+
+  for (int i = 0; i < n; ++i) box.push_back(make_row(i));
+
+  for (auto _ : state) {
+    double      sum = 0;
+    std::size_t len = 0;
+
+    for (std::size_t i = 0; i < box.size(); ++i) {
+      auto row = box[i].as_object();
+
+      sum += row["number"].as_double();
+      sum += double(row["id"].as_uint64());
+      sum += row["bool"].as_bool();
+      len += row["string"].as_string().size();
+
+      for (auto el : row["array"].as_array()) sum += double(el.as_int64());
+      for (auto el : row["object"].as_object()["values"].as_array())
+        sum += el.as_double();
+    }
+
+    benchmark::DoNotOptimize(sum);
+    benchmark::DoNotOptimize(len);
+  }
+
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// converts all rows back to boost::json values
+template <typename Allocation>
+void BM_AccessorValueTo(benchmark::State& state) {
+  Allocation           allocation;
+  box_type<Allocation> box(allocation.get_allocator());
+  const int            n = int(state.range(0));
+
+  for (int i = 0; i < n; ++i) box.push_back(make_row(i));
+
+  for (auto _ : state)
+    for (std::size_t i = 0; i < box.size(); ++i)
+      benchmark::DoNotOptimize(
+          json_bento::value_to<boost::json::value>(box[i]));
+
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK_TEMPLATE(BM_BoxPushBack, std_allocation)->Range(1 << 4, 1 << 12);
+BENCHMARK_TEMPLATE(BM_BoxPushBack, metall_allocation)->Range(1 << 4, 1 << 12);
+BENCHMARK_TEMPLATE(BM_AccessorTraversal, std_allocation)
+    ->Range(1 << 4, 1 << 12);
+BENCHMARK_TEMPLATE(BM_AccessorTraversal, metall_allocation)
+    ->Range(1 << 4, 1 << 12);
+BENCHMARK_TEMPLATE(BM_AccessorValueTo, std_allocation)->Range(1 << 4, 1 << 12);
+BENCHMARK_TEMPLATE(BM_AccessorValueTo, metall_allocation)
+    ->Range(1 << 4, 1 << 12);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,33 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+/// \brief The allocators of the json_bento benchmarks.
+/// \details
+///   each benchmark runs with std::allocator and with the Metall allocator,
+///   so that the allocator's overhead shows separately from the overhead
+///   of the data structure.
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+
+#include <metall/metall.hpp>
+
+/// allocates from the heap
+struct std_allocation {
+  using allocator_type = std::allocator<std::byte>;
+
+  allocator_type get_allocator() const { return {}; }
+};
+
+/// allocates from a Metall datastore that is created for each benchmark run
+struct metall_allocation {
+  using allocator_type = metall::manager::allocator_type<std::byte>;
+
+  allocator_type get_allocator() { return manager.get_allocator(); }
+
+  metall::manager manager{metall::create_only, "/tmp/metall-bench"};
+};
@@ -0,0 +1,100 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <json_bento/details/compact_string_storage.hpp>
+
+#include "bench_allocation.hpp"
+
+template <typename Allocation>
+using storage_type = json_bento::jbdtl::compact_string_storage<
+    typename Allocation::allocator_type>;
+
+/// returns n strings, short and long ones, with n / 4 distinct values
+std::vector<std::string> make_strings(std::size_t n) {
+  std::vector<std::string> strs;
+
+  for (std::size_t i = 0; i < n; ++i)
+    strs.push_back((i % 2 ? "s" : "long test string test test ") +
+                   std::to_string(i % (n / 4 + 1)));
+
+  return strs;
+}
+
+/// emplaces strings into an empty storage
+template <typename Allocation>
+void BM_StringStorageEmplace(benchmark::State& state) {
+  Allocation                     allocation;
+  const std::vector<std::string> strs = make_strings(state.range(0));
+
+  for (auto _ : state) {
+    storage_type<Allocation> storage(allocation.get_allocator());
+
+    for (const std::string& str : strs)
+      benchmark::DoNotOptimize(storage.emplace(str));
+  }
+
+  state.SetItemsProcessed(state.iterations() * strs.size());
+}
+
+/// assigns other strings to the stored ones, then erases and emplaces them
+///   again (churn)
+template <typename Allocation>
+void BM_StringStorageChurn(benchmark::State& state) {
+  Allocation                     allocation;
+  storage_type<Allocation>       storage(allocation.get_allocator());
+  const std::vector<std::string> strs = make_strings(state.range(0));
+  std::vector<std::size_t>       ids;
+
+  for (const std::string& str : strs) ids.push_back(storage.emplace(str));
+
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < ids.size(); ++i)
+      ids[i] = storage.assign(ids[i], strs[strs.size() - 1 - i]);
+
+    for (std::size_t i = 0; i < ids.size(); ++i) {
+      storage.erase(ids[i]);
+      ids[i] = storage.emplace(strs[i]);
+    }
+  }
+
+  state.SetItemsProcessed(state.iterations() * ids.size() * 3);
+}
+
+/// reads all strings by id
+template <typename Allocation>
+void BM_StringStorageRead(benchmark::State& state) {
+  Allocation                     allocation;
+  storage_type<Allocation>       storage(allocation.get_allocator());
+  const std::vector<std::string> strs = make_strings(state.range(0));
+  std::vector<std::size_t>       ids;
+
+  for (const std::string& str : strs) ids.push_back(storage.emplace(str));
+
+  for (auto _ : state)
+    for (std::size_t id : ids)
+      benchmark::DoNotOptimize(storage.str_view(id).size());
+
+  state.SetItemsProcessed(state.iterations() * ids.size());
+}
+
+BENCHMARK_TEMPLATE(BM_StringStorageEmplace, std_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_StringStorageEmplace, metall_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_StringStorageChurn, std_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_StringStorageChurn, metall_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_StringStorageRead, std_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_StringStorageRead, metall_allocation)
+    ->Range(1 << 4, 1 << 14);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,68 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <benchmark/benchmark.h>
+
+#include <json_bento/details/compact_vector.hpp>
+
+#include "bench_allocation.hpp"
+
+template <typename Allocation>
+using vec_type = json_bento::jbdtl::compact_vector<
+    int, typename std::allocator_traits<typename Allocation::allocator_type>::
+             template rebind_alloc<int>>;
+
+/// appends state.range(0) elements
+template <typename Allocation>
+void BM_CompactVectorPushBack(benchmark::State& state) {
+  Allocation allocation;
+  const auto alloc = allocation.get_allocator();
+  const int  n     = int(state.range(0));
+
+  for (auto _ : state) {
+    vec_type<Allocation> vec;
+
+    for (int i = 0; i < n; ++i) vec.push_back(int(i), alloc);
+
+    benchmark::DoNotOptimize(vec.size());
+    vec.destroy(alloc);
+  }
+
+  state.SetItemsProcessed(state.iterations() * n);
+}
+
+/// reads all elements, by index and by iterator
+template <typename Allocation>
+void BM_CompactVectorRead(benchmark::State& state) {
+  Allocation           allocation;
+  const auto           alloc = allocation.get_allocator();
+  const int            n     = int(state.range(0));
+  vec_type<Allocation> vec;
+
+  for (int i = 0; i < n; ++i) vec.push_back(int(i), alloc);
+
+  for (auto _ : state) {
+    long sum = 0;
+
+    for (std::size_t i = 0; i < vec.size(); ++i) sum += vec[i];
+    for (int el : vec) sum += el;
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * n * 2);
+  vec.destroy(alloc);
+}
+
+BENCHMARK_TEMPLATE(BM_CompactVectorPushBack, std_allocation)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_CompactVectorPushBack, metall_allocation)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_CompactVectorRead, std_allocation)
+    ->Range(1 << 4, 1 << 16);
+BENCHMARK_TEMPLATE(BM_CompactVectorRead, metall_allocation)
+    ->Range(1 << 4, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,92 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <json_bento/details/key_store.hpp>
+
+#include "bench_allocation.hpp"
+
+template <typename Allocation>
+using store_type =
+    json_bento::jbdtl::key_store<typename Allocation::allocator_type>;
+
+/// returns n keys; as in the tests, every other key is short enough to be
+///   stored inline
+std::vector<std::string> make_keys(std::size_t n, const std::string& prefix) {
+  std::vector<std::string> keys;
+
+  for (std::size_t i = 0; i < n; ++i)
+    keys.push_back((i % 2 ? prefix : "a-much-longer-key-" + prefix) +
+                   std::to_string(i));
+
+  return keys;
+}
+
+/// looks up keys that are in the store
+template <typename Allocation>
+void BM_KeyStoreFindOrAddHit(benchmark::State& state) {
+  Allocation                     allocation;
+  store_type<Allocation>         store(allocation.get_allocator());
+  const std::vector<std::string> keys = make_keys(state.range(0), "k");
+
+  for (const std::string& key : keys) store.find_or_add(key);
+
+  for (auto _ : state)
+    for (const std::string& key : keys)
+      benchmark::DoNotOptimize(store.find_or_add(key));
+
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/// adds new keys to an empty store
+template <typename Allocation>
+void BM_KeyStoreFindOrAddMiss(benchmark::State& state) {
+  Allocation                     allocation;
+  const std::vector<std::string> keys = make_keys(state.range(0), "k");
+
+  for (auto _ : state) {
+    store_type<Allocation> store(allocation.get_allocator());
+
+    for (const std::string& key : keys)
+      benchmark::DoNotOptimize(store.find_or_add(key));
+  }
+
+  state.SetItemsProcessed(state.iterations() * keys.size());
+}
+
+/// looks up keys by their locators
+template <typename Allocation>
+void BM_KeyStoreFindLocator(benchmark::State& state) {
+  Allocation                                  allocation;
+  store_type<Allocation>                      store(allocation.get_allocator());
+  std::vector<json_bento::jbdtl::key_locator> locs;
+
+  for (const std::string& key : make_keys(state.range(0), "k"))
+    locs.push_back(store.find_or_add(key));
+
+  for (auto _ : state)
+    for (const auto& loc : locs) benchmark::DoNotOptimize(store.find(loc));
+
+  state.SetItemsProcessed(state.iterations() * locs.size());
+}
+
+BENCHMARK_TEMPLATE(BM_KeyStoreFindOrAddHit, std_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_KeyStoreFindOrAddHit, metall_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_KeyStoreFindOrAddMiss, std_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_KeyStoreFindOrAddMiss, metall_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_KeyStoreFindLocator, std_allocation)
+    ->Range(1 << 4, 1 << 14);
+BENCHMARK_TEMPLATE(BM_KeyStoreFindLocator, metall_allocation)
+    ->Range(1 << 4, 1 << 14);
+
+BENCHMARK_MAIN();
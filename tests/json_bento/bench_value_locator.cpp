@@ -0,0 +1,73 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <json_bento/box/core_data/value_locator.hpp>
+
+using namespace json_bento::jbdtl;
+
+/// fills locators with each kind of value, as in the tests
+void fill(std::vector<value_locator>& locs) {
+  for (std::size_t i = 0; i < locs.size(); ++i) {
+    value_locator& loc = locs[i];
+
+    switch (i % 5) {
+      case 0: loc.emplace_bool() = (i % 2 == 0); break;
+      case 1: loc.emplace_int64() = -std::int64_t(i); break;
+      case 2: loc.emplace_uint64() = i; break;
+      case 3: loc.emplace_double() = double(i) / 2; break;
+      default: loc.emplace_string_index() = i; break;
+    }
+  }
+}
+
+/// emplaces a value into each locator
+void BM_ValueLocatorEmplace(benchmark::State& state) {
+  std::vector<value_locator> locs(state.range(0));
+
+  for (auto _ : state) {
+    fill(locs);
+    benchmark::ClobberMemory();
+  }
+
+  state.SetItemsProcessed(state.iterations() * locs.size());
+}
+
+/// dispatches on the kind of each locator and reads its value
+void BM_ValueLocatorRead(benchmark::State& state) {
+  std::vector<value_locator> locs(state.range(0));
+
+  fill(locs);
+
+  for (auto _ : state) {
+    double sum = 0;
+
+    for (const value_locator& loc : locs) {
+      if (loc.is_bool())
+        sum += loc.as_bool();
+      else if (loc.is_int64())
+        sum += double(loc.as_int64());
+      else if (loc.is_uint64())
+        sum += double(loc.as_uint64());
+      else if (loc.is_double())
+        sum += loc.as_double();
+      else if (loc.is_index())
+        sum += double(loc.as_index());
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  state.SetItemsProcessed(state.iterations() * locs.size());
+}
+
+BENCHMARK(BM_ValueLocatorEmplace)->Range(1 << 4, 1 << 16);
+BENCHMARK(BM_ValueLocatorRead)->Range(1 << 4, 1 << 16);
+
+BENCHMARK_MAIN();
@@ -131,4 +131,105 @@ TEST(ArrayAccessorTest, Resize) {
   value.emplace_array();
   value.as_array().resize(2);
   EXPECT_EQ(value.as_array().size(), 2);
-}
\ No newline at end of file
+}
+TEST(ArrayAccessorTest, Packed) {
+  bento_type bento;
+  bento.pack_numeric_arrays(4);
+  EXPECT_EQ(bento.packed_array_threshold(), 4);
+
+  // Sorted IDs (delta encoded), random-ish integers, doubles, and arrays
+  // that are not packed.
+  boost::json::array ids, ints, uints, reals;
+  for (int64_t i = 0; i < 100; ++i) {
+    ids.push_back(1000000 + i * 3);
+    ints.push_back((i % 2 ? -1 : 1) * i * i * 1234567);
+    uints.push_back(uint64_t(i) * 1000);
+    reals.push_back(0.5 * double(i));
+  }
+  boost::json::object obj;
+  obj["ids"]   = ids;
+  obj["ints"]  = ints;
+  obj["uints"] = uints;
+  obj["reals"] = reals;
+  obj["mixed"] = boost::json::array{1, 2.0, 3, 4};
+  obj["short"] = boost::json::array{1, 2};
+  const boost::json::value value(obj);
+
+  bento.push_back(value);
+  boost::json::error_code ec;
+  const auto              json = boost::json::serialize(value);
+  bento.push_back_json(json, ec);
+  ASSERT_FALSE(ec);
+  // Integral doubles can be serialized as integers
+  const boost::json::value expected[] = {value, boost::json::parse(json)};
+
+  for (std::size_t i = 0; i < bento.size(); ++i) {
+    EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[i]), expected[i]);
+
+    const auto arr = bento[i].as_object()["ids"].as_array();
+    ASSERT_EQ(arr.size(), ids.size());
+    EXPECT_EQ(arr[37].as_int64(), ids[37].as_int64());
+    std::size_t n = 0;
+    for (const auto elem : arr) {
+      EXPECT_EQ(elem.as_int64(), ids[n++].as_int64());
+    }
+    EXPECT_EQ(n, ids.size());
+  }
+
+  // Modifications unpack the array
+  auto arr = bento[0].as_object()["ints"].as_array();
+  arr[5] = 42;
+  arr.push_back(bento[1].as_object()["ints"].as_array()[7]);
+  ints[5] = 42;
+  ints.push_back(ints[7]);
+  EXPECT_EQ(
+      json_bento::value_to<boost::json::value>(bento[0].as_object()["ints"]),
+      boost::json::value(ints));
+
+  bento[1].as_object()["reals"] = "replaced";
+  EXPECT_EQ(bento[1].as_object()["reals"].as_string().str_view(), "replaced");
+
+  bento.compact();
+  EXPECT_EQ(bento.packed_array_threshold(), 4);
+  EXPECT_EQ(
+      json_bento::value_to<boost::json::value>(bento[0].as_object()["ints"]),
+      boost::json::value(ints));
+  EXPECT_EQ(
+      json_bento::value_to<boost::json::value>(bento[1].as_object()["uints"]),
+      expected[1].as_object().at("uints"));
+}
+
+TEST(ArrayAccessorTest, CopyNumbers) {
+  bento_type bento;
+  bento.pack_numeric_arrays(4);
+
+  boost::json::array ids, reals;
+  for (int64_t i = 0; i < 50; ++i) {
+    ids.push_back(1000000 + i * 3);
+    reals.push_back(0.25 * double(i));
+  }
+  boost::json::object obj;
+  obj["ids"]    = ids;
+  obj["reals"]  = reals;
+  obj["mixed"]  = boost::json::array{1, -2, 3.5};
+  obj["string"] = boost::json::array{1, "two", 3, 4};
+  bento.push_back(boost::json::value(obj));
+
+  auto                row = bento[0].as_object();
+  std::vector<double> out;
+
+  ASSERT_TRUE(row["ids"].as_array().copy_numbers(out));
+  ASSERT_EQ(out.size(), ids.size());
+  for (std::size_t i = 0; i < ids.size(); ++i) {
+    EXPECT_EQ(out[i], double(ids[i].as_int64()));
+  }
+
+  ASSERT_TRUE(row["reals"].as_array().copy_numbers(out));
+  ASSERT_EQ(out.size(), reals.size());
+  EXPECT_EQ(out[7], reals[7].as_double());
+
+  ASSERT_TRUE(row["mixed"].as_array().copy_numbers(out));
+  EXPECT_EQ(out, (std::vector<double>{1, -2, 3.5}));
+
+  EXPECT_FALSE(row["string"].as_array().copy_numbers(out));
+}
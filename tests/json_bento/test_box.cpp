@@ -5,6 +5,7 @@
 
 #include <gtest/gtest.h>
 
+#include <sstream>
 #include <string>
 
 #include <metall/metall.hpp>
@@ -60,4 +61,332 @@ TEST(BoxTest, All) {
 
   bento->clear();
   EXPECT_EQ(bento->size(), 0);
-}
\ No newline at end of file
+}
+TEST(BoxTest, PushBackJson) {
+  json_bento::box<> bento;
+
+  std::string json_string = R"(
+      {
+        "number": 3.141,
+        "bool": true,
+        "string": "Alice Smith",
+        "long string": "a string that does not fit in the short string buffer",
+        "nothing": null,
+        "int": -3,
+        "uint": 18446744073709551615,
+        "object": {
+          "everything": 42
+        },
+        "array": [1, 0, [2, {"x": "y"}]],
+        "objects mixed types": {
+          "currency": "USD",
+          "values": [10.0, 20.1, 32.1]
+        }
+      }
+    )";
+
+  boost::json::error_code ec;
+  const auto              index = bento.push_back_json(json_string, ec);
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(index, 0);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[index]),
+            boost::json::parse(json_string));
+
+  EXPECT_EQ(bento.push_back_json("[1, 2", ec), bento.size());
+  EXPECT_TRUE(ec);
+  ec.clear();
+  EXPECT_EQ(bento.push_back_json("1 2", ec), bento.size());
+  EXPECT_TRUE(ec);
+  EXPECT_EQ(bento.size(), 1);
+}
+
+TEST(BoxTest, PushBackBatch) {
+  json_bento::box<> bento;
+  bento.index_key("b");
+
+  const std::vector<std::string> lines = {
+      R"({"a": 1, "b": "x"})", R"({"a": 2, "b": "y"})", R"(invalid)",
+      R"({"b": [1, 2]})", R"("root string")"};
+
+  EXPECT_EQ(bento.push_back_batch(lines), 4);
+  EXPECT_EQ(bento.size(), 4);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[1]),
+            boost::json::parse(lines[1]));
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[2]),
+            boost::json::parse(lines[3]));
+  EXPECT_STREQ(bento[3].as_string().c_str(), "root string");
+  EXPECT_STREQ(bento[0].as_object().at("b").as_string().c_str(), "x");
+}
+
+TEST(BoxTest, PushBackBatchParallel) {
+  json_bento::box<> bento;
+  bento.index_key("id");
+
+  std::vector<std::string> lines;
+  for (int i = 0; i < 100; ++i) {
+    lines.push_back(R"({"id": )" + std::to_string(i) + R"(, "name": "n)" +
+                    std::to_string(i % 7) + R"(", "v": [1, {"k": true}]})");
+  }
+  lines[10] = "invalid";
+
+  EXPECT_EQ(bento.push_back_batch_parallel(lines, 4), 99);
+  ASSERT_EQ(bento.size(), 99);
+  for (std::size_t i = 0, row = 0; i < lines.size(); ++i) {
+    if (i == 10) continue;
+    EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[row]),
+              boost::json::parse(lines[i]));
+    EXPECT_EQ(bento[row].as_object().at("id").as_int64(), int64_t(i));
+    ++row;
+  }
+}
+
+TEST(BoxTest, Append) {
+  json_bento::box<> src;
+  src.push_back(boost::json::parse(R"({"a": 1, "b": ["x"]})"));
+  src.push_back(boost::json::parse(R"(2)"));
+
+  json_bento::box<> dst;
+  dst.push_back(boost::json::parse(R"({"b": null})"));
+  dst.append(src);
+  ASSERT_EQ(dst.size(), 3);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(dst[1]),
+            boost::json::parse(R"({"a": 1, "b": ["x"]})"));
+  EXPECT_EQ(dst[2].as_int64(), 2);
+}
+
+TEST(BoxTest, RootValueRegion) {
+  json_bento::box<> bento;
+  EXPECT_EQ(bento.root_value_region().second, 0);
+
+  bento.push_back(boost::json::parse(R"({"a": 1})"));
+  bento.push_back(boost::json::parse(R"("x")"));
+  const auto [addr, bytes] = bento.root_value_region();
+  EXPECT_NE(addr, nullptr);
+  EXPECT_GT(bytes, 0);
+
+  // the region grows with the number of items
+  bento.push_back(boost::json::parse(R"(3)"));
+  EXPECT_EQ(bento.root_value_region().second, bytes / 2 * 3);
+}
+
+TEST(BoxTest, ContainsKey) {
+  json_bento::box<> bento;
+  EXPECT_FALSE(bento.contains_key("a"));
+
+  bento.push_back(boost::json::parse(R"({"a": 1, "b": {"c": 2}})"));
+  EXPECT_TRUE(bento.contains_key("a"));
+  EXPECT_TRUE(bento.contains_key("c"));  // keys of nested objects
+  EXPECT_FALSE(bento.contains_key("d"));
+}
+
+TEST(BoxTest, KeyCache) {
+  json_bento::box<> bento;
+  bento.push_back(boost::json::parse(R"({"a": 1, "b": 2})"));
+  EXPECT_TRUE(bento.attach_key_cache(true));
+
+  EXPECT_TRUE(bento.contains_key("a"));
+  EXPECT_FALSE(bento.contains_key("c"));  // a cached miss
+  EXPECT_EQ(bento[0].as_object()["b"].as_int64(), 2);
+
+  // Adding a key updates the cached miss.
+  bento.push_back(boost::json::parse(R"({"c": 3})"));
+  EXPECT_TRUE(bento.contains_key("c"));
+  EXPECT_EQ(bento[1].as_object()["c"].as_int64(), 3);
+  EXPECT_FALSE(bento[0].as_object().contains("c"));
+
+  bento.detach_key_cache();
+  EXPECT_TRUE(bento.contains_key("c"));
+}
+
+TEST(BoxTest, Compact) {
+  json_bento::box<> bento;
+  bento.index_key("t");
+  bento.intern_strings(true, 4);
+  EXPECT_TRUE(bento.attach_key_cache());
+
+  const std::vector<std::string> lines = {
+      R"({"t": 3, "s": "three"})", R"({"t": "b"})", R"([1, 2])",
+      R"({"t": 1.5, "s": "one and a half"})", R"({"t": "a"})",
+      R"({"t": -2})"};
+  for (const auto& line : lines) bento.push_back(boost::json::parse(line));
+  bento[0].as_object()["s"] = "drei";
+
+  bento.compact();
+  ASSERT_EQ(bento.size(), lines.size());
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[0]),
+            boost::json::parse(R"({"t": 3, "s": "drei"})"));
+  for (std::size_t i = 1; i < lines.size(); ++i) {
+    EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[i]),
+              boost::json::parse(lines[i]));
+  }
+  EXPECT_TRUE(bento.is_indexed_key("t"));
+  EXPECT_TRUE(bento.interning_strings());
+  EXPECT_TRUE(bento.contains_key("s"));
+
+  bento.compact("t");
+  const std::vector<std::string> sorted = {
+      R"({"t": -2})", R"({"t": 1.5, "s": "one and a half"})",
+      R"({"t": 3, "s": "drei"})", R"({"t": "a"})", R"({"t": "b"})",
+      R"([1, 2])"};
+  ASSERT_EQ(bento.size(), sorted.size());
+  for (std::size_t i = 0; i < sorted.size(); ++i) {
+    EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[i]),
+              boost::json::parse(sorted[i]));
+  }
+  EXPECT_EQ(bento[3].as_object()["t"].as_string().str_view(), "a");
+
+  bento.detach_key_cache();
+}
+
+TEST(BoxTest, Usage) {
+  json_bento::box<> bento;
+  EXPECT_EQ(bento.usage().total_bytes(), 0);
+
+  bento.push_back(boost::json::parse(
+      R"({"name": "a string that is not stored inline", "ids": [1, 2, 3]})"));
+  bento.push_back(boost::json::parse(R"({"name": "b"})"));
+
+  auto usage = bento.usage();
+  EXPECT_GT(usage.root_value_bytes, 0);
+  EXPECT_GT(usage.string_bytes,
+            std::string("a string that is not stored inline").size());
+  EXPECT_GT(usage.array_bytes, 0);
+  EXPECT_GT(usage.object_bytes, 0);
+  EXPECT_GT(usage.key_bytes, 0);
+  EXPECT_EQ(usage.num_strings, 2);
+  EXPECT_EQ(usage.num_free_string_slots, 0);
+  EXPECT_EQ(usage.num_keys, 2);
+  EXPECT_EQ(usage.total_bytes(),
+            usage.root_value_bytes + usage.string_bytes + usage.array_bytes +
+                usage.object_bytes + usage.key_bytes);
+
+  bento[1].as_object()["name"] = 1;
+  usage = bento.usage();
+  EXPECT_EQ(usage.num_strings, 1);
+  EXPECT_EQ(usage.num_free_string_slots, 1);
+}
+
+TEST(BoxTest, CompressKey) {
+  json_bento::box<> bento;
+  if (!bento.compress_key("text", 16)) {
+    GTEST_SKIP() << "built without zstd";
+  }
+  EXPECT_EQ(bento.compressed_keys().size(), 1);
+
+  std::vector<std::string> texts;
+  for (std::size_t i = 0; i < 4000; ++i) {
+    texts.push_back("a rarely read description, number " + std::to_string(i));
+    boost::json::object obj;
+    obj["id"]   = "id-" + std::to_string(i);
+    obj["text"] = texts.back();
+    if (i % 2) {
+      bento.push_back(obj);
+    } else {
+      boost::json::error_code ec;
+      bento.push_back_json(boost::json::serialize(obj), ec);
+    }
+  }
+  bento.push_back(boost::json::parse(R"({"text": "short"})"));
+
+  std::stringstream profile;
+  bento.profile(profile);
+  EXPECT_NE(profile.str().find("#of compressed string data\t4000"),
+            std::string::npos);
+
+  for (std::size_t i = 0; i < texts.size(); ++i) {
+    auto obj = bento[i].as_object();
+    ASSERT_EQ(obj["text"].as_string().str_view(), texts[i]);
+    EXPECT_EQ(obj["id"].as_string().str_view(), "id-" + std::to_string(i));
+  }
+  EXPECT_EQ(bento[texts.size()].as_object()["text"].as_string().str_view(),
+            "short");
+
+  bento[0].as_object()["text"] = "replaced";
+  EXPECT_EQ(bento[0].as_object()["text"].as_string().str_view(), "replaced");
+
+  bento.compact("id");
+  EXPECT_EQ(bento.compressed_keys().size(), 1);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[1]),
+            boost::json::parse(R"({"id": "id-1", "text": ")" + texts[1] +
+                               "\"}"));
+
+  bento.clear();
+  EXPECT_EQ(bento.compressed_keys().front().first, "text");
+}
+
+TEST(BoxTest, RowAllocation) {
+  json_bento::box<> bento;
+  EXPECT_TRUE(bento.set_row_allocation(json_bento::row_allocation_mode::slab));
+  EXPECT_EQ(bento.row_allocation(), json_bento::row_allocation_mode::slab);
+
+  const std::vector<std::string> lines = {R"({"a": 1, "b": [1, 2]})",
+                                          R"({"a": 2, "b": []})",
+                                          R"([{"c": "x"}, {"d": null}])"};
+  EXPECT_EQ(bento.push_back_batch(lines), lines.size());
+  for (std::size_t i = 0; i < lines.size(); ++i) {
+    EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[i]),
+              boost::json::parse(lines[i]));
+  }
+  EXPECT_FALSE(bento.set_row_allocation(json_bento::row_allocation_mode::bump));
+
+  bento[0].as_object()["b"].as_array().emplace_back(3);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[0]),
+            boost::json::parse(R"({"a": 1, "b": [1, 2, 3]})"));
+
+  bento.clear();
+  EXPECT_TRUE(bento.set_row_allocation(json_bento::row_allocation_mode::bump));
+}
+
+TEST(BoxTest, RemoveIf) {
+  json_bento::box<> bento;
+  bento.index_key("a");
+  for (int i = 0; i < 5; ++i) {
+    bento.push_back(boost::json::parse(R"({"a": )" + std::to_string(i) +
+                                       R"(, "b": [null, "x"]})"));
+  }
+
+  EXPECT_EQ(bento.remove_if([](std::size_t, auto) { return false; }), 0);
+  ASSERT_EQ(bento.size(), 5);
+
+  EXPECT_EQ(bento.remove_if([](std::size_t i, auto row) {
+    return i == 0 || row.as_object()["a"].as_int64() == 3;
+  }),
+            2);
+  ASSERT_EQ(bento.size(), 3);
+  EXPECT_TRUE(bento.is_indexed_key("a"));
+  const std::vector<int> remaining = {1, 2, 4};
+  for (std::size_t i = 0; i < bento.size(); ++i) {
+    EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[i]),
+              boost::json::parse(R"({"a": )" + std::to_string(remaining[i]) +
+                                 R"(, "b": [null, "x"]})"));
+  }
+}
+
+TEST(BoxTest, PushBackObject) {
+  json_bento::box<> bento;
+  bento.index_key("b");
+
+  const auto a = bento.add_key("a");
+  const auto b = bento.add_key("b");
+  const auto c = bento.add_key("c");
+  EXPECT_EQ(bento.add_key("a"), a);
+
+  for (int i = 0; i < 2; ++i) {
+    auto w = bento.push_back_object();
+    w.add_int64(a, -i);
+    w.add_string(b, "x" + std::to_string(i));
+    if (i == 0) {
+      w.add_double(c, 0.5);
+    } else {
+      w.add_null(c);
+    }
+    EXPECT_EQ(w.finish(), std::size_t(i));
+  }
+
+  ASSERT_EQ(bento.size(), 2);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[0]),
+            boost::json::parse(R"({"a": 0, "b": "x0", "c": 0.5})"));
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(bento[1]),
+            boost::json::parse(R"({"a": -1, "b": "x1", "c": null})"));
+  EXPECT_EQ(bento[1].as_object()["b"].as_string().str_view(), "x1");
+}
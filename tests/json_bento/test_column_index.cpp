@@ -0,0 +1,80 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+#include <gtest/gtest.h>
+
+#include <json_bento/boost_json.hpp>
+#include <json_bento/json_bento.hpp>
+
+using box_type = json_bento::box<>;
+
+TEST(ColumnIndexTest, IndexExistingItems) {
+  box_type box;
+  box.push_back(boost::json::parse(R"({"a": 1, "score": 10})"));
+  box.push_back(boost::json::parse(R"({"b": 2})"));
+  box.push_back(boost::json::parse(R"([1, 2])"));
+
+  box.index_key("score");
+  EXPECT_TRUE(box.is_indexed_key("score"));
+  EXPECT_FALSE(box.is_indexed_key("a"));
+  ASSERT_EQ(box.indexed_keys().size(), 1);
+  EXPECT_EQ(box.indexed_keys()[0], "score");
+
+  EXPECT_TRUE(box[0].as_object().contains("score"));
+  EXPECT_EQ(box[0].as_object().at("score").as_int64(), 10);
+  EXPECT_FALSE(box[1].as_object().contains("score"));
+  EXPECT_EQ(box[1].as_object().find("score"), box[1].as_object().end());
+}
+
+TEST(ColumnIndexTest, IndexNewItems) {
+  box_type box;
+  box.index_key("score");
+  box.index_key("author");
+
+  box.push_back(boost::json::parse(R"({"author": "x", "a": 1, "score": 10})"));
+  box.push_back(boost::json::parse(R"({"score": 3.5})"));
+
+  EXPECT_EQ(box[0].as_object().at("score").as_int64(), 10);
+  EXPECT_STREQ(box[0].as_object().at("author").as_string().c_str(), "x");
+  EXPECT_EQ(box[0].as_object().at("a").as_int64(), 1);
+  EXPECT_EQ(box[1].as_object().at("score").as_double(), 3.5);
+  EXPECT_FALSE(box[1].as_object().contains("author"));
+}
+
+TEST(ColumnIndexTest, Modify) {
+  box_type box;
+  box.index_key("score");
+  box.push_back(boost::json::parse(R"({"a": 1})"));
+
+  // Add an indexed key to an existing item
+  auto obj     = box[0].as_object();
+  obj["score"] = 5;
+  EXPECT_TRUE(box[0].as_object().contains("score"));
+  EXPECT_EQ(box[0].as_object().at("score").as_int64(), 5);
+
+  // Replace the root value
+  box[0].emplace_object()["b"] = 2;
+  EXPECT_FALSE(box[0].as_object().contains("score"));
+  box[0].as_object()["score"] = 6;
+  EXPECT_EQ(box[0].as_object().at("score").as_int64(), 6);
+
+  box[0].parse(R"({"x": 0, "score": 7})");
+  EXPECT_EQ(box[0].as_object().at("score").as_int64(), 7);
+
+  box[0] = 1;
+  EXPECT_TRUE(box[0].is_int64());
+}
+
+TEST(ColumnIndexTest, Clear) {
+  box_type box;
+  box.index_key("score");
+  box.push_back(boost::json::parse(R"({"score": 1})"));
+  box.clear();
+  EXPECT_EQ(box.size(), 0);
+  EXPECT_TRUE(box.is_indexed_key("score"));
+
+  box.push_back(boost::json::parse(R"({"a": 0, "score": 2})"));
+  EXPECT_EQ(box[0].as_object().at("score").as_int64(), 2);
+}
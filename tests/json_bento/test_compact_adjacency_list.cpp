@@ -150,4 +150,51 @@ TEST(CompactAdjacencyListTest, Resize) {
   EXPECT_EQ(list.size(), 1);
   EXPECT_EQ(list.size(0), 1);
   EXPECT_EQ(list.at(0, 0), 10);
-}
\ No newline at end of file
+}
+
+TEST(CompactAdjacencyListTest, RowAllocation) {
+  using json_bento::jbdtl::row_allocation_mode;
+
+  for (const auto mode :
+       {row_allocation_mode::slab, row_allocation_mode::bump}) {
+    adj_type list;
+    EXPECT_EQ(list.row_allocation(), row_allocation_mode::individual);
+    EXPECT_TRUE(list.set_row_allocation(mode));
+    EXPECT_EQ(list.row_allocation(), mode);
+
+    // Small rows and a row that is too large to be pooled
+    for (int r = 0; r < 3000; ++r) {
+      for (int i = 0; i < r % 5; ++i) list.push_back(r, r * 10 + i);
+    }
+    for (int i = 0; i < 100; ++i) list.push_back(3000, int(i));
+
+    // Cannot change the mode while rows have memory
+    EXPECT_FALSE(list.set_row_allocation(row_allocation_mode::individual));
+
+    for (int r = 0; r < 3000; ++r) {
+      ASSERT_EQ(list.size(r), r % 5);
+      for (int i = 0; i < r % 5; ++i) EXPECT_EQ(list.at(r, i), r * 10 + i);
+    }
+    for (int i = 0; i < 100; ++i) EXPECT_EQ(list.at(3000, i), i);
+
+    // Free some rows and reuse the memory
+    for (int r = 0; r < 3000; r += 2) {
+      list.clear(r);
+      list.shrink_to_fit(r);
+    }
+    for (int r = 0; r < 3000; r += 2) list.push_back(r, -r);
+    for (int r = 0; r < 3000; ++r) {
+      if (r % 2 == 0) {
+        ASSERT_EQ(list.size(r), 1);
+        EXPECT_EQ(list.at(r, 0), -r);
+      } else {
+        ASSERT_EQ(list.size(r), r % 5);
+        for (int i = 0; i < r % 5; ++i) EXPECT_EQ(list.at(r, i), r * 10 + i);
+      }
+    }
+
+    list.clear();
+    EXPECT_EQ(list.size(), 0);
+    EXPECT_TRUE(list.set_row_allocation(row_allocation_mode::individual));
+  }
+}
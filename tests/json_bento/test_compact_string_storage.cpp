@@ -5,8 +5,10 @@
 
 #include <gtest/gtest.h>
 
+#include <numeric>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <json_bento/details/compact_string_storage.hpp>
 
@@ -88,4 +90,112 @@ TEST(CompactStringStorage, All) {
     SCOPED_TRACE("Const test");
     test_helper(storage);
   }
-}
\ No newline at end of file
+}
+TEST(CompactStringStorage, Intern) {
+  storage_t storage;
+  storage.intern(true);
+  EXPECT_TRUE(storage.interning());
+
+  const auto id0 = storage.emplace("long test string test test 0");
+  const auto id1 = storage.emplace("long test string test test 0");
+  EXPECT_EQ(id0, id1);
+  EXPECT_EQ(storage.use_count(id0), 2);
+  EXPECT_EQ(storage.size(), 1);
+
+  // Short strings are not interned
+  EXPECT_NE(storage.emplace("test"), storage.emplace("test"));
+  EXPECT_EQ(storage.size(), 3);
+
+  // Assigning to a shared string does not modify the other references
+  const auto id2 = storage.assign(id1, "long test string test test 1");
+  EXPECT_NE(id2, id0);
+  EXPECT_STREQ(storage.at(id0).c_str(), "long test string test test 0");
+  EXPECT_STREQ(storage.at(id2).c_str(), "long test string test test 1");
+  EXPECT_EQ(storage.use_count(id0), 1);
+
+  // Assigning an interned string shares it
+  EXPECT_EQ(storage.assign(id0, "long test string test test 1"), id2);
+  EXPECT_EQ(storage.use_count(id2), 2);
+  EXPECT_EQ(storage.size(), 3);
+
+  // Erase
+  storage.erase(id2);
+  EXPECT_EQ(storage.size(), 3);
+  storage.erase(id2);
+  EXPECT_EQ(storage.size(), 2);
+}
+
+TEST(CompactStringStorage, Detach) {
+  storage_t storage;
+  storage.intern(true);
+
+  const auto id0 = storage.emplace("long test string test test 0");
+  const auto id1 = storage.emplace("long test string test test 0");
+  ASSERT_EQ(id0, id1);
+
+  // A shared string is copied before it is modified in place
+  const auto id2 = storage.detach(id1);
+  EXPECT_NE(id2, id0);
+  EXPECT_EQ(storage.use_count(id0), 1);
+  EXPECT_EQ(storage.use_count(id2), 1);
+  *storage.begin_at(id2) = 'L';
+  EXPECT_STREQ(storage.at(id0).c_str(), "long test string test test 0");
+  EXPECT_STREQ(storage.at(id2).c_str(), "Long test string test test 0");
+
+  // An unshared string keeps its ID but is no longer interned
+  EXPECT_EQ(storage.detach(id0), id0);
+  *(storage.end_at(id0) - 1) = '1';
+  EXPECT_STREQ(storage.at(id0).c_str(), "long test string test test 1");
+  const auto id3 = storage.emplace("long test string test test 1");
+  EXPECT_NE(id3, id0);
+  EXPECT_EQ(storage.use_count(id3), 1);
+}
+
+TEST(CompactStringStorage, Compressed) {
+  storage_t storage;
+
+  // Enough strings to fill several blocks
+  std::vector<std::string> strings;
+  std::vector<std::size_t> ids;
+  for (std::size_t i = 0; i < 5000; ++i) {
+    strings.push_back("compressed test string " + std::to_string(i) +
+                      std::string(i % 50, 'x'));
+    ids.push_back(storage.emplace_compressed(strings.back().data(),
+                                             strings.back().size()));
+  }
+  const auto hot = storage.emplace("hot string");
+  EXPECT_FALSE(storage.compressed(hot));
+  EXPECT_EQ(storage.num_compressed(), strings.size());
+
+  for (std::size_t i = 0; i < strings.size(); ++i) {
+    ASSERT_TRUE(storage.compressed(ids[i]));
+    EXPECT_EQ(storage.str_view(ids[i]), strings[i]);
+    EXPECT_EQ(storage.length(ids[i]), strings[i].size());
+    EXPECT_STREQ(storage.c_str(ids[i]), strings[i].c_str());
+  }
+  EXPECT_EQ(storage.str_view(hot), "hot string");
+  EXPECT_EQ(storage.compressed_size().second,
+            std::accumulate(strings.begin(), strings.end(), std::size_t(0),
+                            [](std::size_t n, const std::string& s) {
+                              return n + s.size() + 1;
+                            }));
+
+  // Assigning replaces a compressed string with an uncompressed one
+  EXPECT_EQ(storage.assign(ids[0], "new"), ids[0]);
+  EXPECT_FALSE(storage.compressed(ids[0]));
+  EXPECT_EQ(storage.str_view(ids[0]), "new");
+
+  // Mutable iterators decompress the string
+  *storage.begin_at(ids[1]) = 'C';
+  EXPECT_FALSE(storage.compressed(ids[1]));
+  EXPECT_EQ(storage.str_view(ids[1]), "C" + strings[1].substr(1));
+
+  storage.erase(ids[2]);
+  EXPECT_FALSE(storage.compressed(ids[2]));
+  EXPECT_EQ(storage.num_compressed(), strings.size() - 3);
+  EXPECT_EQ(storage.str_view(ids[3]), strings[3]);
+
+  storage.clear();
+  EXPECT_EQ(storage.num_compressed(), 0);
+  EXPECT_EQ(storage.compressed_size().first, 0);
+}
@@ -0,0 +1,196 @@
+// Copyright 2023 Lawrence Livermore National Security, LLC and other MetallData
+// Project Developers. See the top-level COPYRIGHT file for details.
+//
+// SPDX-License-Identifier: MIT
+
+// Runs a box on top of the compact value locator.
+#ifndef JSON_BENTO_COMPACT_VALUE_LOCATOR
+#define JSON_BENTO_COMPACT_VALUE_LOCATOR
+#endif
+
+#include <gtest/gtest.h>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include <json_bento/boost_json.hpp>
+#include <json_bento/json_bento.hpp>
+
+using namespace json_bento::jbdtl;
+
+TEST(CompactValueLocatorTest, Size) {
+  EXPECT_EQ(sizeof(compact_value_locator), 8);
+  EXPECT_EQ(sizeof(value_locator), 8);
+}
+
+TEST(CompactValueLocatorTest, Values) {
+  compact_value_locator loc;
+  EXPECT_TRUE(loc.is_null());
+  EXPECT_FALSE(loc.is_double());
+
+  loc.emplace_bool() = true;
+  EXPECT_TRUE(loc.is_bool());
+  EXPECT_TRUE(loc.as_bool());
+
+  loc.emplace_int64() = -(int64_t(1) << 47);
+  EXPECT_TRUE(loc.is_int64());
+  EXPECT_EQ(loc.as_int64(), -(int64_t(1) << 47));
+  loc.as_int64() = (int64_t(1) << 47) - 1;
+  EXPECT_EQ(loc.as_int64(), (int64_t(1) << 47) - 1);
+
+  loc.emplace_uint64() = (uint64_t(1) << 48) - 1;
+  EXPECT_TRUE(loc.is_uint64());
+  EXPECT_EQ(loc.as_uint64(), (uint64_t(1) << 48) - 1);
+
+  for (const double d : {0.0, -0.0, 1.5, -1e300, HUGE_VAL, -HUGE_VAL}) {
+    loc.emplace_double() = d;
+    EXPECT_TRUE(loc.is_double());
+    EXPECT_FALSE(loc.is_null());
+    EXPECT_EQ(loc.as_double(), d);
+  }
+  loc.emplace_double() = -std::nan("");
+  EXPECT_TRUE(loc.is_double());
+  EXPECT_TRUE(std::isnan(double(loc.as_double())));
+
+  loc.emplace_string_index() = 10;
+  EXPECT_TRUE(loc.is_string_index());
+  EXPECT_EQ(loc.as_index(), 10);
+  loc.emplace_array_index() = 20;
+  EXPECT_TRUE(loc.is_array_index());
+  EXPECT_EQ(loc.as_index(), 20);
+  loc.emplace_object_index() = compact_value_locator::max_index();
+  EXPECT_TRUE(loc.is_object_index());
+  EXPECT_EQ(loc.as_index(), compact_value_locator::max_index());
+
+  loc.reset();
+  EXPECT_TRUE(loc.is_null());
+}
+
+TEST(CompactValueLocatorTest, OutOfRange) {
+  // Without slots for out-of-line integers
+  compact_value_locator loc;
+  EXPECT_THROW(loc.emplace_int64() = int64_t(1) << 47, std::overflow_error);
+  EXPECT_THROW(loc.emplace_uint64() = uint64_t(1) << 48,
+               std::overflow_error);
+  EXPECT_THROW(loc.emplace_array_index() = uint64_t(1) << 48,
+               std::overflow_error);
+}
+
+TEST(CompactValueLocatorTest, OutOfLine) {
+  data_storage<uint64_t> storage;
+  const wide_integer_slots slots(&storage);
+  compact_value_locator    loc;
+
+  loc.emplace_int64(slots) = std::numeric_limits<int64_t>::min();
+  EXPECT_TRUE(loc.is_int64());
+  EXPECT_FALSE(loc.is_uint64());
+  EXPECT_FALSE(loc.is_double());
+  EXPECT_TRUE(loc.is_out_of_line());
+  EXPECT_EQ(loc.as_int64(slots), std::numeric_limits<int64_t>::min());
+  EXPECT_EQ(storage.size(), 1);
+
+  // Reuses the slot
+  loc.as_int64(slots) = std::numeric_limits<int64_t>::max();
+  EXPECT_EQ(loc.as_int64(slots), std::numeric_limits<int64_t>::max());
+  EXPECT_EQ(storage.size(), 1);
+
+  // Releases the slot
+  loc.as_int64(slots) = 1;
+  EXPECT_FALSE(loc.is_out_of_line());
+  EXPECT_EQ(loc.as_int64(), 1);
+  EXPECT_EQ(storage.size(), 0);
+
+  loc.emplace_uint64(slots) = std::numeric_limits<uint64_t>::max();
+  EXPECT_TRUE(loc.is_uint64());
+  EXPECT_FALSE(loc.is_int64());
+  EXPECT_EQ(loc.as_uint64(slots), std::numeric_limits<uint64_t>::max());
+  EXPECT_EQ(storage.size(), 1);
+
+  loc.emplace_int64(slots) = int64_t(1) << 47;
+  EXPECT_TRUE(loc.is_int64());
+  EXPECT_EQ(loc.as_int64(slots), int64_t(1) << 47);
+  EXPECT_EQ(storage.size(), 1);
+
+  loc.reset(slots);
+  EXPECT_TRUE(loc.is_null());
+  EXPECT_EQ(storage.size(), 0);
+}
+
+TEST(CompactValueLocatorTest, Box) {
+  const std::string json_string = R"(
+      {
+        "pi": 3.141,
+        "happy": true,
+        "name": "Alice",
+        "nothing": null,
+        "list": [1, -2, 2.5, "x", [], {}],
+        "object": {"currency": "USD", "value": 42}
+      }
+    )";
+
+  json_bento::box<> box;
+  box.push_back(boost::json::parse(json_string));
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(box[0]),
+            boost::json::parse(json_string));
+
+  auto obj         = box[0].as_object();
+  obj["pi"]        = 3.0;
+  obj["name"]      = "Bob";
+  obj["list"]      = 5;
+  EXPECT_EQ(obj["pi"].as_double(), 3.0);
+  EXPECT_STREQ(obj["name"].as_string().c_str(), "Bob");
+  EXPECT_EQ(obj["list"].as_int64(), 5);
+
+  boost::json::error_code ec;
+  box.push_back_json(R"({"a": 1})", ec);
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(box.size(), 2);
+
+  // Integers that do not fit in the payload are stored out of line
+  const std::string wide_string =
+      R"({"u": 18446744073709551615, "i": -9223372036854775808,)"
+      R"( "list": [140737488355328, 1]})";
+  box.push_back_json(wide_string, ec);
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(box.size(), 3);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(box[2]),
+            boost::json::parse(wide_string));
+
+  auto wide = box[2].as_object();
+  EXPECT_EQ(wide["u"].as_uint64(), std::numeric_limits<uint64_t>::max());
+  wide["u"] = 7u;
+  EXPECT_EQ(wide["u"].as_uint64(), 7u);
+  wide["i"].as_int64() = std::numeric_limits<int64_t>::max();
+  EXPECT_EQ(wide["i"].as_int64(), std::numeric_limits<int64_t>::max());
+  std::vector<double> numbers;
+  EXPECT_TRUE(wide["list"].as_array().copy_numbers(numbers));
+  EXPECT_EQ(numbers, std::vector<double>({140737488355328.0, 1.0}));
+
+  box.push_back(boost::json::parse(wide_string));
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(box[3]),
+            boost::json::parse(wide_string));
+}
+
+TEST(CompactValueLocatorTest, ClearReleasesWideIntegers) {
+  const std::string wide_string =
+      R"({"u": 18446744073709551615, "list": [140737488355328, 1]})";
+
+  json_bento::box<> box;
+  box.push_back(boost::json::parse(wide_string));
+  box.push_back(boost::json::parse(R"({"u": 1})"));
+  box.push_back(boost::json::parse(wide_string));
+  EXPECT_EQ(box.usage().num_wide_integers, 4);
+
+  // remove_if() rebuilds the box, so only the kept rows own slots
+  box.remove_if([](std::size_t i, const auto&) { return i == 0; });
+  EXPECT_EQ(box.size(), 2);
+  EXPECT_EQ(box.usage().num_wide_integers, 2);
+  EXPECT_EQ(json_bento::value_to<boost::json::value>(box[1]),
+            boost::json::parse(wide_string));
+
+  box.clear();
+  EXPECT_EQ(box.size(), 0);
+  EXPECT_EQ(box.usage().num_wide_integers, 0);
+}
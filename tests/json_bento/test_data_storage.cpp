@@ -5,6 +5,8 @@
 
 #include <gtest/gtest.h>
 
+#include <vector>
+
 #include <metall/metall.hpp>
 
 #include <json_bento/details/data_storage.hpp>
@@ -32,4 +34,57 @@ TEST(DataStorageTest, Everything) {
     storage.erase(idx0);
     EXPECT_EQ(storage.size(), 0);
   }
-}
\ No newline at end of file
+}
+template <typename storage_type>
+void free_slot_test_helper(storage_type &storage) {
+  EXPECT_EQ(storage.size(), 0);
+
+  std::vector<std::size_t> ids;
+  for (int i = 0; i < 200; ++i) {
+    ids.push_back(storage.emplace(i));
+  }
+  EXPECT_EQ(storage.size(), 200);
+
+  // Erase even items
+  for (int i = 0; i < 200; i += 2) {
+    storage.erase(ids[i]);
+  }
+  EXPECT_EQ(storage.size(), 100);
+  EXPECT_EQ(storage.capacity(), 200);
+  EXPECT_EQ(storage.num_free_slots(), 100);
+
+  // Iterator skips free slots
+  std::size_t count = 0;
+  for (const auto &item : storage) {
+    EXPECT_EQ(item % 2, 1);
+    ++count;
+  }
+  EXPECT_EQ(count, 100);
+
+  // Free slots are reused
+  for (int i = 0; i < 100; ++i) {
+    const auto id = storage.emplace(-1);
+    EXPECT_LT(id, 200);
+    EXPECT_EQ(storage.at(id), -1);
+  }
+  EXPECT_EQ(storage.size(), 200);
+  EXPECT_EQ(storage.capacity(), 200);
+  EXPECT_EQ(storage.num_free_slots(), 0);
+
+  storage.emplace(-2);
+  EXPECT_EQ(storage.capacity(), 201);
+}
+
+TEST(DataStorageTest, OrderedFreeSlots) {
+  json_bento::jbdtl::data_storage<int, std::allocator<int>,
+                                  json_bento::jbdtl::ordered_free_slots>
+      storage;
+  free_slot_test_helper(storage);
+}
+
+TEST(DataStorageTest, StackFreeSlots) {
+  json_bento::jbdtl::data_storage<int, std::allocator<int>,
+                                  json_bento::jbdtl::stack_free_slots>
+      storage;
+  free_slot_test_helper(storage);
+}
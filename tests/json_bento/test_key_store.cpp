@@ -3,6 +3,9 @@
 //
 // SPDX-License-Identifier: MIT
 
+#include <string>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <metall/metall.hpp>
@@ -28,5 +31,33 @@ TEST(CompactVectorTest, Everything) {
 
     EXPECT_STREQ(store.find(loc0).data(), "key0");
     EXPECT_STREQ(store.find(loc1).data(), "key1");
+
+    EXPECT_TRUE(store.contains("key0"));
+    EXPECT_FALSE(store.contains("key2"));
+  }
+}
+
+TEST(KeyStoreTest, ManyKeys) {
+  metall::manager manager(metall::create_only, "/tmp/metall-test");
+
+  {
+    store_type store(manager.get_allocator());
+
+    // Short keys are stored inline, long ones are allocated.
+    std::vector<std::string>                    keys;
+    std::vector<json_bento::jbdtl::key_locator> locs;
+    for (int i = 0; i < 10000; ++i) {
+      keys.push_back((i % 2 ? "k" : "a-much-longer-key-") + std::to_string(i));
+      locs.push_back(store.find_or_add(keys.back()));
+    }
+    EXPECT_EQ(store.size(), keys.size());
+
+    for (std::size_t i = 0; i < keys.size(); ++i) {
+      EXPECT_EQ(store.find(keys[i]), locs[i]);
+      EXPECT_EQ(store.find_or_add(keys[i]), locs[i]);
+      EXPECT_EQ(store.find(locs[i]), keys[i]);
+    }
+    EXPECT_EQ(store.size(), keys.size());
+    EXPECT_FALSE(store.contains("k10000"));
   }
-}
\ No newline at end of file
+}
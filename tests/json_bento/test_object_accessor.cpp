@@ -244,4 +244,86 @@ TEST(ObjectAccessorTest, IfContains) {
   EXPECT_EQ(const_accessor.if_contains("key0")->as_bool(), true);
   EXPECT_DOUBLE_EQ(const_accessor.if_contains("key1")->as_double(), 0.5);
   EXPECT_FALSE(const_accessor.if_contains("key2"));
-}
\ No newline at end of file
+}
+
+TEST(ObjectAccessorTest, IfContainsLocator) {
+  box_type           box;
+  boost::json::value value;
+  value.emplace_object();
+  value.as_object()["key0"] = true;
+  value.as_object()["key1"] = 0.5;
+  box.push_back(value);
+  value.as_object().erase("key0");
+  box.push_back(value);
+
+  const auto accessor0 = box[0].as_object();
+  const auto accessor1 = box[1].as_object();
+  const auto key0      = accessor0.locate_key("key0");
+  const auto key1      = accessor0.locate_key("key1");
+  EXPECT_EQ(accessor0.if_contains(key0)->as_bool(), true);
+  EXPECT_DOUBLE_EQ(accessor0.if_contains(key1)->as_double(), 0.5);
+  EXPECT_FALSE(accessor1.if_contains(key0));
+  EXPECT_DOUBLE_EQ(accessor1.if_contains(key1)->as_double(), 0.5);
+  EXPECT_FALSE(accessor0.if_contains(accessor0.locate_key("key2")));
+}
+
+TEST(ObjectAccessorTest, FindOrAddLocator) {
+  box_type           box;
+  boost::json::value value;
+  value.emplace_object();
+  value.as_object()["key0"] = 1;
+  box.push_back(value);
+  box.push_back(value);
+
+  const auto key0 = box.add_key("key0");
+  const auto key1 = box.add_key("key1");
+  EXPECT_EQ(box.locate_key("key1"), key1);
+
+  auto accessor0 = box[0].as_object();
+  auto accessor1 = box[1].as_object();
+  accessor0.find_or_add(key0) = 2;
+  accessor1.find_or_add(key1) = "value";
+  EXPECT_EQ(accessor0.size(), 1);
+  EXPECT_EQ(accessor0.at("key0").as_int64(), 2);
+  EXPECT_EQ(accessor1.size(), 2);
+  EXPECT_EQ(accessor1.at("key0").as_int64(), 1);
+  EXPECT_STREQ(accessor1.at("key1").as_string().c_str(), "value");
+}
+
+TEST(ObjectAccessorTest, WideObject) {
+  box_type box;
+  box.sort_keys_of_wide_objects(4);
+  EXPECT_EQ(box.wide_object_threshold(), 4);
+
+  boost::json::object value;
+  for (int i = 0; i < 100; ++i) {
+    value["key" + std::to_string(i)] = i;
+  }
+
+  auto accessor = box[box.push_back(value)].as_object();
+  for (int i = 0; i < 100; ++i) {
+    const auto key = "key" + std::to_string(i);
+    EXPECT_TRUE(accessor.contains(key));
+    EXPECT_EQ(accessor.at(key).as_int64(), i);
+  }
+  EXPECT_FALSE(accessor.contains("key100"));
+
+  // Keys added later are found too
+  accessor["new"] = 1.5;
+  EXPECT_DOUBLE_EQ(accessor.at("new").as_double(), 1.5);
+  EXPECT_EQ(accessor.at("key10").as_int64(), 10);
+
+  // Iteration order is not changed
+  int i = 0;
+  for (auto kv : accessor) {
+    if (i < 100) {
+      EXPECT_EQ(kv.key(), "key" + std::to_string(i));
+    }
+    ++i;
+  }
+  EXPECT_EQ(i, 101);
+
+  // Narrow objects are searched linearly
+  auto narrow = box[box.push_back(boost::json::parse(R"({"a": 0})"))];
+  EXPECT_TRUE(narrow.as_object().contains("a"));
+}
@@ -133,6 +133,21 @@ TEST(StringAccessorTest, Assign) {
   EXPECT_STREQ(box[id].as_string().c_str(), "Goodbye, world!");
 }
 
+TEST(StringAccessorTest, AssignStringView) {
+  box_type   box;
+  const auto id = box.push_back(boost::json::value("Hello, world!"));
+  auto       sa = box[id].as_string();
+
+  // The view is not null-terminated
+  const std::string_view sv = std::string_view("Goodbye, world!").substr(0, 7);
+  sa                        = sv;
+  EXPECT_EQ(sa.size(), 7);
+  EXPECT_STREQ(sa.c_str(), "Goodbye");
+
+  box[id] = std::string_view("Hello, world!").substr(7, 5);
+  EXPECT_STREQ(box[id].as_string().c_str(), "world");
+}
+
 TEST(StringAccessorTest, Iterator) {
   boost::json::value bj_string;
   bj_string.emplace_string() = "Hello, world!";
@@ -171,6 +186,20 @@ TEST(StringAccessorTest, Iterator) {
   EXPECT_EQ(it, sa.end());
 }
 
+TEST(StringAccessorTest, IteratorOfSharedString) {
+  box_type box;
+  box.intern_strings(true);
+  box.push_back(boost::json::value("shared string value"));
+  box.push_back(boost::json::value("shared string value"));
+
+  // Writing through the iterator does not modify the other value
+  auto sa = box[1].as_string();
+  *sa.begin() = 'S';
+  EXPECT_STREQ(box[0].as_string().c_str(), "shared string value");
+  EXPECT_STREQ(box[1].as_string().c_str(), "Shared string value");
+  EXPECT_STREQ(sa.c_str(), "Shared string value");
+}
+
 TEST(StringAccessorTest, Conversion) {
   boost::json::value bj_string;
   bj_string.emplace_string() = "Hello, world!";
@@ -184,4 +213,16 @@ TEST(StringAccessorTest, Conversion) {
 
   std::string_view sv = static_cast<std::string_view>(sa);
   EXPECT_EQ(sv, "Hello, world!");
-}
\ No newline at end of file
+}
+
+TEST(StringAccessorTest, StrView) {
+  boost::json::value bj_string;
+  bj_string.emplace_string() = "Hello, world!";
+
+  box_type   box;
+  const auto id = box.push_back(bj_string);
+  auto       sa = box[id].as_string();
+
+  EXPECT_EQ(sa.str_view(), "Hello, world!");
+  EXPECT_EQ(sa.str_view().data(), sa.c_str());
+}
@@ -42,4 +42,15 @@ TEST(ValueToTest, MetallJSON) {
   metall::json::value mj_value;
   json_bento::value_to(box.back(), mj_value);
   EXPECT_EQ(mj_value, metall::json::parse(json_string));
-}
\ No newline at end of file
+}
+
+TEST(ValueToTest, StringView) {
+  box_type box;
+  box.push_back(boost::json::parse(json_string));
+  const auto obj = box.back().as_object();
+
+  const auto view = json_bento::value_to<std::string_view>(obj.at("name"));
+  EXPECT_EQ(view, "Alice");
+  // No copy is made
+  EXPECT_EQ(view.data(), obj.at("name").as_string().c_str());
+}
@@ -132,11 +132,21 @@ exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-init" "mjl-init-resul
 
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-count" "mjl-count-names" 1
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-head" "mjl-head-names" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-groupby" "mjl-groupby-names" 0
 
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-head" "mjl-head-selected_places" 0
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-info" "mjl-info-selected_places" 0
 
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-merge" "mjl-merge" 1
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-merge" "mjl-merge-left" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-merge" "mjl-merge-right" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-merge" "mjl-merge-outer" 0
+
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-init" "mjl-init-vectors" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-read_json" "mjl-read_json-vectors" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-create_knn_index" "mjl-create_knn_index-vectors" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-knn" "mjl-knn-vectors" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallJsonLines/mjl-knn" "mjl-knn-scan" 0
 
 
 #
@@ -151,6 +161,12 @@ exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-count_lines" "mg-count_lin
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-count" "mg-count-1" 1
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-count" "mg-count-selected" 1
 
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-cc" "mg-cc" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-count_degree" "mg-count_degree" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-kcore" "mg-kcore" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-bfs" "mg-bfs" 0
+exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-pagerank" "mg-pagerank" 0
+
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-init" "mg-softcom-init" 1
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-read_edges" "mg-softcom-read_edges" 1
 exec_test "$EXEPREFIX" "$BUILDROOT/src/MetallGraph/mg-count_lines" "mg-softcom-count_lines" 1